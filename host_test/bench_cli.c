@@ -0,0 +1,358 @@
+// File: host_test/bench_cli.c
+// ==========================================================================================
+// The CLI's dispatch on the host (user-011): cli_handler.c and state_machine.c themselves,
+// the LED calls counted and the other modules' statistics stubbed out.
+//   1. Checks: every table entry is found by the binary search, the in-place tokenizer
+//      (quotes, tabs, the argv limit), text commands reach the LED calls and the FSM,
+//      and binary frames fed a byte at a time get the right replies.
+//   2. Lookup alone: ns per name over the whole table.
+//   3. A scripted rig mix as text lines and as the equivalent binary frames: commands/s
+//      (stdout discarded), bytes per command, and the wire limit at 115200 baud.
+// ==========================================================================================
+
+#include <fcntl.h>
+#include <unistd.h>
+#include "check.h"
+#define TAG FSM_TAG             // Both modules have a file-local TAG
+#include "state_machine.c"
+#undef TAG
+#include "cli_handler.c"
+
+#define CLI_BAUD    115200u
+
+// === LED calls (counted) ===
+
+static unsigned led_applied, led_blinks, led_stops;
+static float last_hz, last_duty;
+
+uint32_t led_apply_pattern(led_channel_t ch, led_pattern_t pattern) {
+    (void)ch; (void)pattern;
+    return ++led_applied & 0xFFFFFFu;
+}
+
+bool led_cmd_applied(led_channel_t ch, uint32_t seq, uint32_t *applied_us) {
+    (void)ch; (void)seq;
+    *applied_us = (uint32_t)esp_timer_get_time();
+    return true;
+}
+
+void led_blink(led_channel_t ch, float frequency_hz, float duty_cycle_percent) {
+    (void)ch;
+    led_blinks++;
+    last_hz = frequency_hz;
+    last_duty = duty_cycle_percent;
+}
+
+void led_stop(led_channel_t ch) { (void)ch; led_stops++; }
+void led_pulse(led_channel_t ch, float frequency_hz) { (void)ch; (void)frequency_hz; }
+void led_fade(led_channel_t ch, uint32_t duration_ms) { (void)ch; (void)duration_ms; }
+void led_debug_status(void) {}
+void led_trace_dump(void) {}
+void led_trace_set_echo(bool enable) { (void)enable; }
+
+// === Sessions the FSM hooks start, and the other modules' statistics (not benchmarked) ===
+
+void tether_start(uint32_t from_seg) { (void)from_seg; }
+void tether_stop(void) {}
+void untether_start(void) {}
+void untether_stop(void) {}
+upload_cursor_t untether_cursor(void) { return (upload_cursor_t){0}; }
+void rtv_start(void) {}
+void rtv_stop(void) {}
+void rtv_snap_start(void) {}
+void rtv_snap_stop(void) {}
+
+void boot_profile_print(void) {}
+void log_query_init(log_query_t *q) { memset(q, 0, sizeof(*q)); }
+int log_query_run(const char *root, const log_query_t *q, log_query_cb_t cb, void *ctx,
+                  log_query_stats_t *stats) {
+    (void)root; (void)q; (void)cb; (void)ctx;
+    memset(stats, 0, sizeof(*stats));
+    return 0;
+}
+void rtv_get_stats(rtv_stats_t *out, bool reset) { (void)reset; memset(out, 0, sizeof(*out)); }
+const char *rtv_rate_action_str(rtv_rate_action_t a) { (void)a; return "-"; }
+void rtv_snap_get_stats(rtv_snap_stats_t *out) { memset(out, 0, sizeof(*out)); }
+esp_err_t rtv_snapshot(uint8_t scale, uint8_t **out, uint16_t *width, uint16_t *height) {
+    (void)scale; (void)out; (void)width; (void)height;
+    return ESP_ERR_INVALID_STATE;
+}
+void rtv_stream_get_stats(rtv_stream_stats_t *out, bool reset) {
+    (void)reset;
+    memset(out, 0, sizeof(*out));
+}
+void sd_log_get_stats(sd_log_stats_t *out) { memset(out, 0, sizeof(*out)); }
+void tether_get_stats(tether_stats_t *out) { memset(out, 0, sizeof(*out)); }
+void untether_get_stats(untether_stats_t *out) { memset(out, 0, sizeof(*out)); }
+esp_err_t untether_rewind(void) { return ESP_OK; }
+const char *upload_result_str(upload_result_t r) { (void)r; return "-"; }
+const char *xfer_result_str(xfer_result_t r) { (void)r; return "-"; }
+const char *wifi_path_str(wifi_path_t p) { (void)p; return "-"; }
+esp_err_t wifi_sta_connect(uint32_t timeout_ms) { (void)timeout_ms; return ESP_OK; }
+void wifi_sta_disconnect(void) {}
+esp_err_t wifi_sta_forget(void) { return ESP_OK; }
+void wifi_sta_get_stats(wifi_sta_stats_t *out, bool reset) {
+    (void)reset;
+    memset(out, 0, sizeof(*out));
+}
+esp_err_t wifi_sta_scan(wifi_sta_seen_t *out, uint8_t max, uint8_t *count) {
+    (void)out; (void)max;
+    *count = 0;
+    return ESP_OK;
+}
+esp_err_t uart_input_init(void) { return ESP_FAIL; }
+bool uart_input_get(uart_input_msg_t *out, TickType_t timeout) { (void)out; (void)timeout; return false; }
+void uart_input_take_stats(uart_input_stats_t *out) { memset(out, 0, sizeof(*out)); }
+
+// === Helpers ===
+
+/** The FSM task's loop body: dispatch what the commands posted. */
+static void drain(void) {
+    fsm_msg_t batch[FSM_BATCH_MAX];
+    size_t n;
+
+    while ((n = fsm_queue_pop_batch(&event_queue, batch, FSM_BATCH_MAX)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            fsm_dispatch(&batch[i]);
+        }
+    }
+}
+
+/** A line as uart_input hands it over: copied into the CLI's buffer, then run. */
+static int run_line(const char *text) {
+    char line[128];
+
+    snprintf(line, sizeof(line), "%s", text);
+    return cli_execute_line(line);
+}
+
+/** Feed an encoded frame a byte at a time, like uart_input, and run it when complete. */
+static bool run_frame(cli_frame_decoder_t *dec, const uint8_t *bytes, size_t n) {
+    bool done = false;
+
+    for (size_t i = 0; i < n; i++) {
+        if (cli_frame_decode_byte(dec, bytes[i]) == CLI_FRAME_COMPLETE) {
+            cli_handle_frame(&dec->frame);
+            done = true;
+        }
+    }
+    return done;
+}
+
+static int stdout_saved = -1;
+
+static void stdout_mute(bool mute) {
+    fflush(stdout);
+    if (mute) {
+        int null = open("/dev/null", O_WRONLY);
+        stdout_saved = dup(STDOUT_FILENO);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    } else if (stdout_saved >= 0) {
+        dup2(stdout_saved, STDOUT_FILENO);
+        close(stdout_saved);
+        stdout_saved = -1;
+    }
+}
+
+// === 1. Checks ===
+
+static void test_lookup(void) {
+    for (size_t i = 0; i < CLI_CMD_COUNT; i++) {
+        CHECK(cli_find(commands[i].name) == &commands[i]);
+        if (i) {
+            CHECK(strcmp(commands[i - 1].name, commands[i].name) < 0);
+        }
+    }
+    CHECK(cli_find("") == NULL);
+    CHECK(cli_find("le") == NULL);
+    CHECK(cli_find("led_") == NULL);
+    CHECK(cli_find("zzz") == NULL);
+}
+
+static void test_tokenize(void) {
+    char line[96], *argv[CLI_MAX_ARGS];
+
+    strcpy(line, "  led\t0   blink 2 50 ");
+    CHECK_EQ(cli_tokenize(line, argv, CLI_MAX_ARGS), 5);
+    CHECK(strcmp(argv[0], "led") == 0 && strcmp(argv[1], "0") == 0);
+    CHECK(strcmp(argv[4], "50") == 0);
+
+    strcpy(line, "log_query -s \"sd write\" -n 3");
+    CHECK_EQ(cli_tokenize(line, argv, CLI_MAX_ARGS), 5);
+    CHECK(strcmp(argv[2], "sd write") == 0 && strcmp(argv[4], "3") == 0);
+
+    strcpy(line, "a b c d e f g h");
+    CHECK_EQ(cli_tokenize(line, argv, CLI_MAX_ARGS), 8);
+    strcpy(line, "a b c d e f g h i");
+    CHECK_EQ(cli_tokenize(line, argv, CLI_MAX_ARGS), -1);
+    strcpy(line, " \t ");
+    CHECK_EQ(cli_tokenize(line, argv, CLI_MAX_ARGS), 0);
+}
+
+static void test_text(void) {
+    unsigned blinks = led_blinks, applied = led_applied, stops = led_stops;
+
+    stdout_mute(true);
+    int rc_blink = run_line("led 0 blink 2 50");
+    int rc_pattern = run_line("led state OPERATIONAL");
+    int rc_off = run_line("led network off");
+    int rc_event = run_line("event CLI_SET_OP");
+    int rc_bad_event = run_line("event NO_SUCH_EVENT");
+    int rc_unknown = run_line("no_such_command");
+    stdout_mute(false);
+
+    CHECK_EQ(rc_blink, 0);
+    CHECK_EQ(led_blinks, blinks + 1);
+    CHECK(last_hz == 2.0f && last_duty == 50.0f);
+    CHECK_EQ(rc_pattern, 0);
+    CHECK_EQ(rc_off, 0);
+    CHECK_EQ(led_stops, stops + 1);
+    CHECK_EQ(rc_event, 0);
+    CHECK_EQ(rc_bad_event, 1);                  // Usage error
+    CHECK_EQ(rc_unknown, -1);
+    drain();
+    CHECK_EQ(get_current_state(), STATE_OPERATIONAL);
+    CHECK(led_applied > applied);
+}
+
+static void test_frames(void) {
+    cli_frame_decoder_t dec;
+    uint8_t buf[CLI_FRAME_MAX_PAYLOAD + CLI_FRAME_OVERHEAD];
+    const uint8_t ping[] = { 1, 2, 3 };
+    size_t n;
+
+    cli_frame_decoder_reset(&dec);
+    n = cli_frame_encode(CLI_OP_PING, ping, sizeof(ping), buf);
+    CHECK(run_frame(&dec, buf, n));
+    CHECK_EQ(host_uart_last[2], CLI_OP_PING | CLI_FRAME_RESPONSE);
+    CHECK_EQ(host_uart_last[1], 1 + sizeof(ping));
+    CHECK(host_uart_last[3] == CLI_STATUS_OK && memcmp(&host_uart_last[4], ping, 3) == 0);
+
+    n = cli_frame_encode(CLI_OP_GET_STATE, NULL, 0, buf);
+    CHECK(run_frame(&dec, buf, n));
+    CHECK_EQ(host_uart_last[3], CLI_STATUS_OK);
+    CHECK_EQ(host_uart_last[4], get_current_state());
+
+    const uint8_t blink[] = { 1, 250, 0, 25 };     // 2.5 Hz, 25 %
+    n = cli_frame_encode(CLI_OP_LED_BLINK, blink, sizeof(blink), buf);
+    CHECK(run_frame(&dec, buf, n));
+    CHECK(last_hz == 2.5f && last_duty == 25.0f);
+
+    const uint8_t bad[] = { LED_CHANNEL_COUNT };
+    n = cli_frame_encode(CLI_OP_LED_OFF, bad, sizeof(bad), buf);
+    CHECK(run_frame(&dec, buf, n));
+    CHECK_EQ(host_uart_last[3], CLI_STATUS_BAD_ARG);
+
+    n = cli_frame_encode(0x7F, NULL, 0, buf);
+    CHECK(run_frame(&dec, buf, n));
+    CHECK_EQ(host_uart_last[3], CLI_STATUS_BAD_OPCODE);
+
+    buf[n - 1] ^= 0xFF;                         // Corrupt CRC: dropped, no reply
+    size_t before = host_uart_tx_bytes;
+    CHECK(!run_frame(&dec, buf, n));
+    CHECK_EQ(host_uart_tx_bytes, before);
+}
+
+// === 2. Lookup ===
+
+static void bench_lookup(unsigned rounds) {
+    volatile size_t found = 0;
+    uint64_t t0 = bench_now_us();
+
+    for (unsigned r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < CLI_CMD_COUNT; i++) {
+            found += cli_find(commands[i].name) != NULL;
+        }
+    }
+    uint64_t us = bench_now_us() - t0;
+    uint64_t n = (uint64_t)rounds * CLI_CMD_COUNT;
+
+    CHECK_EQ(found, n);
+    printf("lookup: %u commands, %.1f ns per binary search\n", (unsigned)CLI_CMD_COUNT,
+           us * 1000.0 / (double)n);
+}
+
+// === 3. Rig mix, text vs binary ===
+
+static const char *const mix_text[] = {
+    "led 0 blink 2 50", "led state OPERATIONAL", "event CLI_SET_OP", "state",
+    "event CLI_MAGIC_KEY", "led network off",
+};
+#define MIX_LEN     (sizeof(mix_text) / sizeof(mix_text[0]))
+
+static size_t mix_frames(uint8_t frames[MIX_LEN][16], size_t len[MIX_LEN]) {
+    const uint8_t blink[] = { 0, 200, 0, 50 }, pattern[] = { 0, LED_PATTERN_OPERATIONAL };
+    const uint8_t set_op[] = { EVENT_CLI_SET_OP }, magic[] = { EVENT_CLI_MAGIC_KEY };
+    const uint8_t off[] = { LED_CHANNEL_NETWORK };
+    size_t total = 0;
+
+    len[0] = cli_frame_encode(CLI_OP_LED_BLINK, blink, sizeof(blink), frames[0]);
+    len[1] = cli_frame_encode(CLI_OP_LED_PATTERN, pattern, sizeof(pattern), frames[1]);
+    len[2] = cli_frame_encode(CLI_OP_POST_EVENT, set_op, 1, frames[2]);
+    len[3] = cli_frame_encode(CLI_OP_GET_STATE, NULL, 0, frames[3]);
+    len[4] = cli_frame_encode(CLI_OP_POST_EVENT, magic, 1, frames[4]);
+    len[5] = cli_frame_encode(CLI_OP_LED_OFF, off, sizeof(off), frames[5]);
+    for (size_t i = 0; i < MIX_LEN; i++) {
+        total += len[i];
+    }
+    return total;
+}
+
+static void report(const char *name, uint64_t us, uint64_t cmds, double bytes_per_cmd) {
+    double wire = CLI_BAUD / 10.0 / bytes_per_cmd;      // 8N1: 10 bits a byte
+    printf("  %-7s %10.0f cmds/s  %6.0f ns/cmd  %5.1f bytes/cmd  wire limit %6.0f cmds/s\n",
+           name, cmds * 1e6 / (double)us, us * 1000.0 / (double)cmds, bytes_per_cmd, wire);
+}
+
+static void bench_mix(unsigned rounds) {
+    uint8_t frames[MIX_LEN][16];
+    size_t len[MIX_LEN], text_bytes = 0;
+    size_t frame_bytes = mix_frames(frames, len);
+    cli_frame_decoder_t dec;
+    unsigned text_fail = 0, bin_done = 0;
+
+    for (size_t i = 0; i < MIX_LEN; i++) {
+        text_bytes += strlen(mix_text[i]) + 1;  // + newline
+    }
+
+    stdout_mute(true);
+    uint64_t t0 = bench_now_us();
+    for (unsigned r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < MIX_LEN; i++) {
+            text_fail += run_line(mix_text[i]) != 0;
+        }
+        drain();
+    }
+    uint64_t t1 = bench_now_us();
+    cli_frame_decoder_reset(&dec);
+    for (unsigned r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < MIX_LEN; i++) {
+            bin_done += run_frame(&dec, frames[i], len[i]);
+        }
+        drain();
+    }
+    uint64_t t2 = bench_now_us();
+    stdout_mute(false);
+
+    uint64_t cmds = (uint64_t)rounds * MIX_LEN;
+    CHECK_EQ(text_fail, 0);
+    CHECK_EQ(bin_done, cmds);
+    printf("rig mix (%u commands: LED blink/pattern/off, 2 events, state), FSM drained per round:\n",
+           (unsigned)MIX_LEN);
+    report("text", t1 - t0, cmds, (double)text_bytes / MIX_LEN);
+    report("binary", t2 - t1, cmds, (double)frame_bytes / MIX_LEN);
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+
+    state_machine_init();
+    test_lookup();
+    test_tokenize();
+    test_text();
+    test_frames();
+    bench_lookup(quick ? 20000 : 2000000);
+    bench_mix(quick ? 2000 : 200000);
+    return check_done("bench_cli");
+}
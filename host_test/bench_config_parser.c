@@ -0,0 +1,64 @@
+// File: host_test/bench_config_parser.c
+// ==========================================================================================
+// Cold-boot config cost on the host: parsing the shipped config.yaml in one buffer and fed
+// a byte at a time (the streaming worst case), next to the keys of the NVS cache: the
+// YAML source hash (now computed at build time) and the schema fingerprint (every boot).
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "config_parser.h"
+
+#ifndef CONFIG_YAML_PATH
+#define CONFIG_YAML_PATH    "../main/config.yaml"
+#endif
+
+static volatile uint32_t sink;
+
+int main(int argc, char **argv) {
+    static char text[16384];
+    unsigned runs = bench_quick(argc, argv) ? 2000 : 100000;
+    app_config_t cfg;
+    config_error_t err;
+    size_t len = 0;
+
+    FILE *f = fopen(CONFIG_YAML_PATH, "rb");
+    if (f) {
+        len = fread(text, 1, sizeof(text), f);
+        fclose(f);
+    }
+    CHECK(len > 0);
+    CHECK_EQ(config_parse_buffer(text, len, &cfg, &err), CONFIG_OK);
+
+    uint64_t t0 = bench_now_us();
+    for (unsigned i = 0; i < runs; i++) {
+        sink += config_parse_buffer(text, len, &cfg, &err);
+    }
+    uint64_t t1 = bench_now_us();
+    for (unsigned i = 0; i < runs; i++) {
+        config_parser_t p;
+        config_parser_init(&p, &cfg);
+        for (size_t b = 0; b < len; b++) {
+            config_parser_feed(&p, text + b, 1);
+        }
+        sink += config_parser_finish(&p);
+    }
+    uint64_t t2 = bench_now_us();
+    for (unsigned i = 0; i < runs; i++) {
+        sink += config_hash(text, len, CONFIG_HASH_SEED);
+    }
+    uint64_t t3 = bench_now_us();
+    for (unsigned i = 0; i < runs; i++) {
+        sink += config_schema_hash();
+    }
+    uint64_t t4 = bench_now_us();
+
+    printf("config.yaml: %zu bytes, %u runs each\n", len, runs);
+    printf("  parse, one buffer      %8.2f us  (%.1f MB/s)\n", (double)(t1 - t0) / runs,
+           (double)len * runs / (double)(t1 - t0));
+    printf("  parse, 1-byte feeds    %8.2f us\n", (double)(t2 - t1) / runs);
+    printf("  hash of the source     %8.2f us  (build time since CONFIG_YAML_HASH)\n",
+           (double)(t3 - t2) / runs);
+    printf("  schema fingerprint     %8.2f us  (warm boot, per boot)\n", (double)(t4 - t3) / runs);
+    return check_done("bench_config_parser");
+}
@@ -0,0 +1,245 @@
+// File: host_test/bench_fsm.c
+// ==========================================================================================
+// The state machine's dispatcher on the host (user-007): state_machine.c itself, with the
+// FSM task's loop body (pop a batch, dispatch each event) run by hand and the hooks'
+// sessions (LED, tether, untether, RTV, snapshots) replaced by counters.
+//   1. One thread: a scripted event cycle through every session, events/s and ns per
+//      event for transitions and for ignored events; the resulting states are checked.
+//   2. PRODUCERS threads post random events against a consumer thread: events/s and
+//      post-to-handled latency (esp_timer microseconds, as the FSM measures it).
+// ==========================================================================================
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "check.h"
+#include "state_machine.c"
+
+#define PRODUCERS   3
+
+// === Sessions the hooks start (counters only) ===
+
+static unsigned led_applied, sessions_started, sessions_stopped;
+
+uint32_t led_apply_pattern(led_channel_t ch, led_pattern_t pattern) {
+    (void)ch; (void)pattern;
+    return ++led_applied & 0xFFFFFFu;
+}
+
+bool led_cmd_applied(led_channel_t ch, uint32_t seq, uint32_t *applied_us) {
+    (void)ch; (void)seq;
+    *applied_us = (uint32_t)esp_timer_get_time();
+    return true;
+}
+
+void tether_start(uint32_t from_seg) { (void)from_seg; sessions_started++; }
+void tether_stop(void) { sessions_stopped++; }
+void untether_start(void) { sessions_started++; }
+void untether_stop(void) { sessions_stopped++; }
+upload_cursor_t untether_cursor(void) { return (upload_cursor_t){0}; }
+void rtv_start(void) { sessions_started++; }
+void rtv_stop(void) { sessions_stopped++; }
+void rtv_snap_start(void) { sessions_started++; }
+void rtv_snap_stop(void) { sessions_stopped++; }
+
+// === The FSM task's loop body ===
+
+static size_t drain(uint32_t *lat_us, size_t *n_lat, size_t lat_cap) {
+    fsm_msg_t batch[FSM_BATCH_MAX];
+    size_t n, total = 0;
+
+    while ((n = fsm_queue_pop_batch(&event_queue, batch, FSM_BATCH_MAX)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            fsm_dispatch(&batch[i]);
+            if (lat_us && *n_lat < lat_cap) {
+                lat_us[(*n_lat)++] = (uint32_t)esp_timer_get_time() - batch[i].posted_us;
+            }
+        }
+        total += n;
+    }
+    fsm_led_probe_check();
+    return total;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+// === 1. Scripted cycle, one thread ===
+
+/** DEV -> OPERATIONAL -> RTV -> OPERATIONAL -> TETHERED -> OPERATIONAL -> UNTETHERED
+ *  -> TETHERED -> OPERATIONAL -> DEV, then an event DEV ignores. */
+static const event_t cycle[] = {
+    EVENT_CLI_SET_OP, EVENT_RTV_ON, EVENT_RTV_OFF, EVENT_TETHER_REQUEST,
+    EVENT_TRANSFER_COMPLETE, EVENT_UNTETHER_REQUEST, EVENT_TRANSFER_FAILED,
+    EVENT_TRANSFER_COMPLETE, EVENT_CLI_MAGIC_KEY, EVENT_TIMEOUT,
+};
+static const SystemState after[] = {
+    STATE_OPERATIONAL, STATE_RTV, STATE_OPERATIONAL, STATE_TETHERED, STATE_OPERATIONAL,
+    STATE_UNTETHERED, STATE_TETHERED, STATE_OPERATIONAL, STATE_DEV, STATE_DEV,
+};
+#define CYCLE_LEN   (sizeof(cycle) / sizeof(cycle[0]))
+
+static uint32_t hist_total(const fsm_lat_t *l) {
+    uint32_t n = 0;
+    for (int b = 0; b < FSM_STATS_BUCKETS; b++) {
+        n += l->hist[b];
+    }
+    return n;
+}
+
+static void test_cycle(void) {
+    for (size_t i = 0; i < CYCLE_LEN; i++) {
+        CHECK(state_machine_post_event(cycle[i]));
+        drain(NULL, NULL, 0);
+        CHECK_EQ(get_current_state(), after[i]);
+    }
+    CHECK(!state_machine_post_event(EVENT_COUNT));
+    const fsm_pair_stats_t *ps = fsm_stats_get(STATE_UNTETHERED, STATE_TETHERED);
+    CHECK(ps && ps->count == 1 && ps->led_count == 1);
+    ps = fsm_stats_get(STATE_TETHERED, STATE_OPERATIONAL);      // Taken twice
+    CHECK(ps && ps->count == 2);
+    if (ps) {                                   // Every phase has its own histogram
+        CHECK_EQ(hist_total(&ps->queue), 2);
+        CHECK_EQ(hist_total(&ps->exit), 2);
+        CHECK_EQ(hist_total(&ps->entry), 2);
+        CHECK_EQ(hist_total(&ps->led), ps->led_count);
+    }
+
+    // A reset from another task is only a request: readers see it at once, the table
+    // itself is cleared by the FSM task before its next record
+    fsm_stats_reset();
+    ps = fsm_stats_get(STATE_TETHERED, STATE_OPERATIONAL);
+    CHECK(ps && ps->count == 0 && hist_total(&ps->queue) == 0);
+    CHECK(state_machine_post_event(EVENT_CLI_SET_OP));          // DEV -> OPERATIONAL
+    drain(NULL, NULL, 0);
+    ps = fsm_stats_get(STATE_TETHERED, STATE_OPERATIONAL);     // Cleared, not hidden
+    CHECK(ps && ps->count == 0);
+    ps = fsm_stats_get(STATE_DEV, STATE_OPERATIONAL);
+    CHECK(ps && ps->count == 1 && hist_total(&ps->queue) == 1);
+    CHECK(state_machine_post_event(EVENT_CLI_MAGIC_KEY));       // Back to DEV
+    drain(NULL, NULL, 0);
+    CHECK_EQ(get_current_state(), STATE_DEV);
+}
+
+static void bench_cycle(unsigned rounds) {
+    uint64_t t0 = now_ns();
+    for (unsigned r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < CYCLE_LEN; i++) {
+            state_machine_post_event(cycle[i]);
+            if ((i & 7) == 7 || i + 1 == CYCLE_LEN) {
+                drain(NULL, NULL, 0);           // A batch at a time, like the task
+            }
+        }
+    }
+    uint64_t t1 = now_ns();
+    for (unsigned r = 0; r < rounds * CYCLE_LEN; r++) {
+        state_machine_post_event(EVENT_TIMEOUT);   // Ignored in DEV: lookup only
+        if ((r & 7) == 7) {
+            drain(NULL, NULL, 0);
+        }
+    }
+    drain(NULL, NULL, 0);
+    uint64_t t2 = now_ns();
+
+    double n = (double)rounds * CYCLE_LEN;
+    CHECK_EQ(get_current_state(), STATE_DEV);
+    CHECK_EQ(event_queue.dropped, 0);
+    CHECK_EQ(sessions_started, sessions_stopped);       // Every session closed again
+    printf("One thread, %.0f events per run:\n", n);
+    printf("  transition cycle  %8.0f events/s  %7.1f ns/event (9 of 10 change state)\n",
+           n * 1e9 / (double)(t1 - t0), (double)(t1 - t0) / n);
+    printf("  ignored events    %8.0f events/s  %7.1f ns/event\n",
+           n * 1e9 / (double)(t2 - t1), (double)(t2 - t1) / n);
+}
+
+// === 2. Producers against a consumer thread ===
+
+static unsigned posts_per_producer;
+static atomic_int producers_left;
+static atomic_uint posted_ok, post_full;
+
+static void *producer(void *arg) {
+    unsigned seed = (unsigned)(uintptr_t)arg * 7919u + 1;
+
+    for (unsigned i = 0; i < posts_per_producer; i++) {
+        event_t ev = (event_t)(1 + rand_r(&seed) % (EVENT_COUNT - 1));
+        while (!state_machine_post_event(ev)) {
+            atomic_fetch_add(&post_full, 1);
+            sched_yield();                      // Queue full: let the consumer run
+        }
+        atomic_fetch_add(&posted_ok, 1);
+        if ((i & 15) == 0) {
+            sched_yield();
+        }
+    }
+    atomic_fetch_sub(&producers_left, 1);
+    return NULL;
+}
+
+typedef struct {
+    uint32_t *lat;
+    size_t    n_lat;
+    size_t    cap;
+    size_t    handled;
+} consumer_t;
+
+static void *consumer(void *arg) {
+    consumer_t *c = arg;
+
+    while (atomic_load(&producers_left) > 0) {
+        c->handled += drain(c->lat, &c->n_lat, c->cap);
+        sched_yield();                          // Stands in for the notification wait
+    }
+    c->handled += drain(c->lat, &c->n_lat, c->cap);
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_threads(unsigned posts) {
+    pthread_t prod[PRODUCERS], cons;
+    consumer_t c = { .cap = (size_t)posts * PRODUCERS };
+
+    posts_per_producer = posts;
+    c.lat = malloc(c.cap * sizeof(uint32_t));
+    atomic_store(&producers_left, PRODUCERS);
+
+    uint64_t t0 = now_ns();
+    pthread_create(&cons, NULL, consumer, &c);
+    for (unsigned i = 0; i < PRODUCERS; i++) {
+        pthread_create(&prod[i], NULL, producer, (void *)(uintptr_t)i);
+    }
+    for (unsigned i = 0; i < PRODUCERS; i++) {
+        pthread_join(prod[i], NULL);
+    }
+    pthread_join(cons, NULL);
+    uint64_t t1 = now_ns();
+
+    CHECK_EQ(c.handled, atomic_load(&posted_ok));
+    CHECK_EQ(c.handled, (size_t)posts * PRODUCERS);
+    qsort(c.lat, c.n_lat, sizeof(uint32_t), cmp_u32);
+    if (c.n_lat) {
+        printf("%d producers + consumer thread, %zu events (%u posts found the queue full):\n",
+               PRODUCERS, c.handled, atomic_load(&post_full));
+        printf("  %8.0f events/s | post-to-handled us: p50 %u  p99 %u  max %u\n",
+               (double)c.handled * 1e9 / (double)(t1 - t0), (unsigned)c.lat[c.n_lat / 2],
+               (unsigned)c.lat[c.n_lat * 99 / 100], (unsigned)c.lat[c.n_lat - 1]);
+    }
+    free(c.lat);
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+
+    state_machine_init();
+    test_cycle();
+    bench_cycle(quick ? 2000 : 200000);
+    bench_threads(quick ? 5000 : 200000);
+    return check_done("bench_fsm");
+}
@@ -0,0 +1,111 @@
+// File: host_test/bench_led_sched.c
+// ==========================================================================================
+// The shared LED timer from 1 to 16 channels (user-004). Every channel plays a looping
+// pattern against a virtual clock through led_sched, the way led_timer_callback does:
+// one wakeup pops every channel due at that instant, steps it and queues its next edge.
+// Reports edges/s, wakeups/s with the shared timer against one timer per channel (one
+// wakeup per edge), and the callback CPU time per second of LED time on this host.
+// Channels either all start together ("aligned") or 137 us apart ("staggered"), and each
+// channel's edges are checked against the same pattern played alone. The CPU figures
+// include reading the clock twice per wakeup.
+// ==========================================================================================
+
+#include "check.h"
+#include "led_pattern.h"
+#include "led_sched.h"
+
+#define STAGGER_US      137
+
+static const led_pattern_t looping[] = {
+    LED_PATTERN_OPERATIONAL, LED_PATTERN_RTV_ACTIVE, LED_PATTERN_TETHERED,
+    LED_PATTERN_UNTETHERED, LED_PATTERN_TRANSFER_COMPLETE,
+};
+#define LOOPING_COUNT   (sizeof(looping) / sizeof(looping[0]))
+
+typedef struct {
+    uint64_t edges;
+    uint64_t wakeups;
+    uint64_t cpu_ns;
+    uint64_t edge_sum;          ///< Sum of edge times, per channel, for the check
+} run_t;
+
+static uint64_t now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static led_pattern_t pattern_of(int ch) {
+    return looping[ch % LOOPING_COUNT];
+}
+
+/** @brief Sum of one pattern's edge times before `until_us`, played alone from `start_us`. */
+static uint64_t alone(led_pattern_t p, int64_t start_us, int64_t until_us, uint64_t *edges) {
+    led_pattern_state_t st;
+    int64_t t = start_us + led_pattern_start(&st, led_pattern_get(p));
+    uint64_t sum = 0;
+
+    for (*edges = 0; t <= until_us; (*edges)++) {
+        sum += (uint64_t)t;
+        t += led_pattern_step(&st);
+    }
+    return sum;
+}
+
+static run_t run(int n, int64_t stagger_us, int64_t until_us, uint64_t *per_channel) {
+    led_pattern_state_t st[LED_SCHED_MAX_CHANNELS];
+    led_sched_t s;
+    run_t r = {0};
+    int64_t now, deadline;
+
+    led_sched_init(&s);
+    for (int ch = 0; ch < n; ch++) {
+        per_channel[ch] = 0;
+        led_sched_set(&s, (uint8_t)ch,
+                      ch * stagger_us + led_pattern_start(&st[ch], led_pattern_get(pattern_of(ch))));
+    }
+    while (led_sched_peek(&s, &now) && now <= until_us) {
+        uint64_t t0 = now_ns();
+        int ch;
+        r.wakeups++;
+        while ((ch = led_sched_pop_due(&s, now, &deadline)) >= 0) {     // The callback body
+            led_sched_set(&s, (uint8_t)ch, deadline + led_pattern_step(&st[ch]));
+            per_channel[ch] += (uint64_t)deadline;
+            r.edges++;
+        }
+        r.cpu_ns += now_ns() - t0;
+    }
+    return r;
+}
+
+int main(int argc, char **argv) {
+    int64_t until_us = (bench_quick(argc, argv) ? 60 : 3600) * 1000000LL;
+    double secs = (double)until_us / 1e6;
+
+    printf("LED channels on one timer, %.0f s of LED time per row:\n", secs);
+    printf("  %-9s %3s | %8s | %10s %12s | %9s %7s\n", "start", "ch", "edges/s", "wakeups/s",
+           "(1 timer/ch)", "cpu us/s", "ns/edge");
+    for (int staggered = 0; staggered <= 1; staggered++) {
+        for (int n = 1; n <= LED_SCHED_MAX_CHANNELS; n++) {
+            uint64_t per_channel[LED_SCHED_MAX_CHANNELS];
+            int64_t stagger = staggered ? STAGGER_US : 0;
+            run_t r = run(n, stagger, until_us, per_channel);
+
+            uint64_t want_edges = 0;
+            for (int ch = 0; ch < n; ch++) {
+                uint64_t e;
+                CHECK_EQ(per_channel[ch], alone(pattern_of(ch), ch * stagger, until_us, &e));
+                want_edges += e;
+            }
+            CHECK_EQ(r.edges, want_edges);
+            CHECK(r.wakeups <= r.edges);
+            if (n == 1 || n == 2 || n == 4 || n == 8 || n == 16) {
+                printf("  %-9s %3d | %8.1f | %10.1f %12.1f | %9.3f %7.1f\n",
+                       staggered ? "staggered" : "aligned", n, r.edges / secs, r.wakeups / secs,
+                       r.edges / secs, r.cpu_ns / secs / 1000.0,
+                       r.edges ? (double)r.cpu_ns / r.edges : 0);
+            }
+        }
+    }
+    return check_done("bench_led_sched");
+}
@@ -0,0 +1,219 @@
+// File: host_test/bench_led_trace.c
+// ==========================================================================================
+// The LED timer callback before and after the trace ring (user-002): the old path formatted
+// one ESP_LOGI line per edge in the callback, the new one stores an 8-byte record and the
+// drain task formats it later. Times both per edge in batches of one drain period, then
+// the drain itself, and checks the ring keeps and overwrites records as documented. A
+// producer thread and a consumer thread then race on the ring and the callback
+// statistics: every record popped must be whole and newer than the last, and every
+// statistics snapshot consistent (no torn reads).
+//
+// On the device the old path also waits for the UART (about 87 us for a 100-byte line at
+// 115200 baud), which this does not count: the "before" figures are a lower bound.
+// ==========================================================================================
+
+#include <pthread.h>
+#include "check.h"
+#include "led_trace.c"                          // For led_trace_drain() and the ring
+
+#define BATCH       32                          // Edges between two drains (< ring size)
+
+static const char *EDGE_FMT = "[%10u us] ch=%u pattern=%u LED %s cycle=%u";
+
+/** @brief The callback body with LED_LOG_EDGES: one formatted line per edge. */
+static void edge_logged(uint32_t t_us, uint8_t ch, uint8_t level, uint8_t cycle) {
+    ESP_LOGI(TAG, "[%10u us] ch=%u pattern=%u LED %s cycle=%u", (unsigned)t_us, ch, 3u,
+             level ? "ON " : "OFF", cycle);
+}
+
+/** @brief The callback body now: one record in the ring. */
+static void edge_traced(uint32_t t_us, uint8_t ch, uint8_t level, uint8_t cycle) {
+    led_trace_record(t_us, ch, 3, level, cycle);
+}
+
+typedef struct {
+    double   mean_ns;           ///< Per edge
+    double   worst_ns;          ///< Per edge, in the slowest batch
+    double   drain_ns;          ///< Per record, drain task side (traced only)
+} result_t;
+
+static uint64_t now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static result_t run(void (*edge)(uint32_t, uint8_t, uint8_t, uint8_t), unsigned batches) {
+    result_t r = {0};
+    uint64_t total = 0, worst = 0, drain = 0;
+    uint32_t t_us = 0;
+
+    for (unsigned b = 0; b < batches; b++) {
+        uint64_t t0 = now_ns();
+        for (unsigned i = 0; i < BATCH; i++, t_us += 250000) {
+            edge(t_us, (uint8_t)(i & 1), (uint8_t)(i & 1), (uint8_t)(i / 2));
+        }
+        uint64_t t1 = now_ns();
+        led_trace_drain();                      // The drain task, outside the callback
+        uint64_t t2 = now_ns();
+
+        total += t1 - t0;
+        worst = t1 - t0 > worst ? t1 - t0 : worst;
+        drain += t2 - t1;
+    }
+    r.mean_ns = (double)total / ((double)batches * BATCH);
+    r.worst_ns = (double)worst / BATCH;
+    r.drain_ns = (double)drain / ((double)batches * BATCH);
+    return r;
+}
+
+static void test_ring(void) {
+    led_trace_rec_t r;
+
+    atomic_store(&dropped, 0);
+    led_trace_drain();
+
+    for (unsigned i = 0; i < LED_TRACE_RING_SIZE; i++) {
+        led_trace_record(i, 0, 1, i & 1, 0);
+    }
+    CHECK_EQ(atomic_load(&dropped), 0);
+    led_trace_record(999, 0, 1, 1, 0);          // Full: the oldest goes, counted
+    CHECK_EQ(atomic_load(&dropped), 1);
+    CHECK(led_trace_pop(&r));
+    CHECK_EQ(r.t_us, 1);                        // Oldest kept, in order
+    for (unsigned i = 2; i < LED_TRACE_RING_SIZE; i++) {
+        CHECK(led_trace_pop(&r) && r.t_us == i);
+    }
+    CHECK(led_trace_pop(&r));
+    CHECK_EQ(r.t_us, 999);                      // The newest edge is never the one lost
+    CHECK(!led_trace_pop(&r));
+
+    for (unsigned i = 0; i < 3 * LED_TRACE_RING_SIZE; i++) {
+        led_trace_record(i, 0, 1, i & 1, 0);    // Echo off for a while: keeps the latest
+    }
+    CHECK_EQ(atomic_load(&dropped), 1 + 2 * LED_TRACE_RING_SIZE);
+    CHECK(led_trace_pop(&r));
+    CHECK_EQ(r.t_us, 2 * LED_TRACE_RING_SIZE);
+    CHECK_EQ(led_trace_drain(), LED_TRACE_RING_SIZE - 1);
+    CHECK_EQ(led_trace_drain(), 0);
+    led_trace_record(5, 1, 2, 1, 3);            // Room again
+    CHECK_EQ(led_trace_drain(), 1);
+    atomic_store(&dropped, 0);
+}
+
+// === Producer and consumer on two threads ===
+
+static atomic_bool race_stop;
+
+/** The timer callback: edges numbered from 1, fields derived from the number. */
+static void *race_producer(void *arg) {
+    uint32_t n = 0;
+    (void)arg;
+
+    while (!atomic_load(&race_stop)) {
+        n++;
+        led_trace_record(n, (uint8_t)n, (uint8_t)(n >> 8), (uint8_t)(n >> 16), (uint8_t)~n);
+        led_trace_note_callback(3, 2);          // Every callback: 3 us, two edges
+    }
+    return NULL;
+}
+
+static atomic_bool taken;
+
+static void sleep_ms(unsigned ms) {
+    nanosleep(&(struct timespec){ .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000 }, NULL);
+}
+
+static void *take_stats(void *arg) {
+    led_trace_take_cb_stats(arg);
+    atomic_store(&taken, true);
+    return NULL;
+}
+
+/** A snapshot started while the producer is mid-update waits for the update to finish. */
+static void test_seqlock(void) {
+    led_trace_cb_stats_t s;
+    pthread_t th;
+
+    led_trace_note_callback(3, 2);
+    unsigned seq = atomic_load(&cb_seq);
+    CHECK_EQ(seq & 1, 0);
+    atomic_store(&cb_seq, seq + 1);             // The producer, interrupted mid-update
+    cb_stats.count = 1000;                      // ...with half its fields written
+    atomic_store(&taken, false);
+    pthread_create(&th, NULL, take_stats, &s);
+    sleep_ms(20);
+    CHECK(!atomic_load(&taken));                // No torn snapshot while odd
+    cb_stats.edges = 2000;
+    atomic_store(&cb_seq, seq + 2);
+    pthread_join(th, NULL);
+    CHECK_EQ(s.count, 1000);
+    CHECK_EQ(s.edges, 2000);
+    led_trace_note_callback(3, 2);              // Consumes the reset
+    led_trace_take_cb_stats(&s);
+    CHECK_EQ(s.count, 1);
+}
+
+static void test_race(unsigned ms) {
+    pthread_t th;
+    uint64_t t0 = bench_now_us();
+    uint32_t popped = 0, torn = 0, out_of_order = 0, snapshots = 0, torn_stats = 0, last = 0;
+    led_trace_rec_t r;
+
+    led_trace_drain();
+    atomic_store(&dropped, 0);
+    atomic_store(&race_stop, false);
+    pthread_create(&th, NULL, race_producer, NULL);
+    while (bench_now_us() - t0 < ms * 1000ull) {
+        for (int i = 0; i < 16 && led_trace_pop(&r); i++) {
+            popped++;
+            torn += r.channel != (uint8_t)r.t_us || r.pattern != (uint8_t)(r.t_us >> 8) ||
+                    r.level != (uint8_t)(r.t_us >> 16) || r.cycle != (uint8_t)~r.t_us;
+            out_of_order += r.t_us <= last;
+            last = r.t_us;
+        }
+        led_trace_cb_stats_t s;
+        led_trace_take_cb_stats(&s);
+        snapshots++;
+        torn_stats += s.edges != 2 * s.count || s.total_us != 3ull * s.count ||
+                      (s.count && s.max_us != 3);
+    }
+    atomic_store(&race_stop, true);
+    pthread_join(th, NULL);
+
+    printf("  race, %u ms: %u records popped, %u overwritten, %u torn, %u out of order | "
+           "%u stats snapshots, %u torn\n", ms, (unsigned)popped, atomic_load(&dropped),
+           (unsigned)torn, (unsigned)out_of_order, (unsigned)snapshots, (unsigned)torn_stats);
+    CHECK(popped > 0);
+    CHECK(atomic_load(&dropped) > 0);           // The producer is faster: it overwrote
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(out_of_order, 0);
+    CHECK_EQ(torn_stats, 0);
+    led_trace_drain();
+    atomic_store(&dropped, 0);
+}
+
+int main(int argc, char **argv) {
+    unsigned batches = bench_quick(argc, argv) ? 2000 : 200000;
+    char line[128];
+
+    test_ring();
+    test_seqlock();
+    test_race(bench_quick(argc, argv) ? 300 : 3000);
+
+    result_t before = run(edge_logged, batches);
+    result_t after = run(edge_traced, batches);
+    CHECK_EQ(atomic_load(&dropped), 0);         // Drained every BATCH: nothing lost
+    CHECK(after.mean_ns < before.mean_ns);
+
+    int len = snprintf(line, sizeof(line), EDGE_FMT, 4294967u, 1u, 3u, "OFF", 2u);
+    printf("LED callback per edge, %u edges (%d-char lines, output discarded):\n",
+           batches * BATCH, len);
+    printf("  before  ESP_LOGI in callback   mean %7.1f ns  worst batch %7.1f ns\n",
+           before.mean_ns, before.worst_ns);
+    printf("  after   led_trace_record       mean %7.1f ns  worst batch %7.1f ns  (%.0fx)\n",
+           after.mean_ns, after.worst_ns, after.mean_ns > 0 ? before.mean_ns / after.mean_ns : 0);
+    printf("          drain task, per record      %7.1f ns  (formatting moved here)\n",
+           after.drain_ns);
+    return check_done("bench_led_trace");
+}
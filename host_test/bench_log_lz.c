@@ -0,0 +1,257 @@
+// File: host_test/bench_log_lz.c
+// ==========================================================================================
+// Log block compression (user-017): log_lz through the segment frame encoder, on 4 KB
+// blocks packed by log_sink exactly as the SD writer packs them.
+//   1. Round trips on generated inputs (random, small alphabet, repeats, runs, every length
+//      up to a block): the output fits its bound, decodes to the input, needs exactly its
+//      size, and damaged input is rejected without writing past the buffer.
+//   2. A device log: ratio (frame headers included), compress and decompress MB/s, and the
+//      RAM the codec takes, checked against LZ_RAM_CAP.
+//
+// Usage: bench_log_lz [--quick] [log file]. Without a file the log is generated from
+// device-like lines (tags and messages of the firmware, mostly I/D); pass a capture from
+// the serial monitor to measure recorded logs.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "log_lz.h"
+#include "log_sink.h"
+#include "log_segment.h"
+
+#define LZ_RAM_CAP      (4 * 1024)  // Match table limit (the frame buffer is the store's)
+#define BLOCK           LOG_SINK_BLOCK_SIZE
+
+static log_lz_t lz;
+static log_sink_t sink;
+static uint32_t rs = 1;
+
+static uint32_t rnd(void) {
+    rs = rs * 1103515245u + 12345u;
+    return rs >> 8;
+}
+
+// === 1. Round trips ===
+
+static void fill(uint8_t *src, size_t len, int kind) {
+    for (size_t i = 0; i < len; i++) {
+        switch (kind) {
+            case 0:  src[i] = (uint8_t)rnd(); break;                    // Incompressible
+            case 1:  src[i] = (uint8_t)"abcab"[rnd() % 5]; break;       // Small alphabet
+            case 2:  src[i] = i > 20 && rnd() % 8 ? src[i - 1 - rnd() % 20] : (uint8_t)rnd();
+                     break;                                             // Short repeats
+            default: src[i] = 'x'; break;                               // One long run
+        }
+    }
+}
+
+static void test_round_trips(unsigned iterations) {
+    static uint8_t src[BLOCK], dst[LOG_LZ_BOUND(BLOCK)], out[BLOCK + 16];
+    unsigned bad_bound = 0, bad_trip = 0, bad_exact = 0, bad_overrun = 0;
+
+    for (unsigned it = 0; it < iterations; it++) {
+        size_t len = it < 5000 ? it % 80 : rnd() % (BLOCK + 1);
+        fill(src, len, (int)(rnd() % 4));
+        size_t cap = (it & 1) ? LOG_LZ_BOUND(len) : (len ? len - 1 : 0);
+        size_t n = log_lz_compress(&lz, src, len, dst, cap);
+
+        if (n == 0) {
+            bad_bound += cap >= LOG_LZ_BOUND(len) && len > 0;   // The bound must always fit
+            continue;
+        }
+        bad_bound += n > cap;
+        int m = log_lz_decompress(dst, n, out, sizeof(out));
+        bad_trip += m != (int)len || memcmp(out, src, len) != 0;
+        if (len) {
+            bad_exact += log_lz_decompress(dst, n, out, len) != (int)len ||
+                         log_lz_decompress(dst, n, out, len - 1) != -1;
+        }
+        if (n > 2) {                            // Damaged: any result, but inside the buffer
+            dst[rnd() % n] ^= (uint8_t)(1u << rnd() % 8);
+            memset(out + BLOCK, 0xA5, 16);
+            log_lz_decompress(dst, n, out, BLOCK);
+            for (int i = 0; i < 16; i++) {
+                bad_overrun += out[BLOCK + i] != 0xA5;
+            }
+        }
+    }
+    for (unsigned it = 0; it < iterations / 2; it++) {             // Pure noise as input
+        size_t n = rnd() % 200;
+        fill(dst, n, 0);
+        log_lz_decompress(dst, n, out, BLOCK);
+    }
+    CHECK_EQ(bad_bound, 0);
+    CHECK_EQ(bad_trip, 0);
+    CHECK_EQ(bad_exact, 0);
+    CHECK_EQ(bad_overrun, 0);
+}
+
+// === 2. Device log ===
+
+/** One device-like message (the shapes the firmware logs most). */
+static int device_msg(char *msg, size_t cap, uint32_t kind) {
+    static const char *const states[] = {
+        "OPERATIONAL", "DEV", "RTV", "TETHERED", "UNTETHERED", "HALTED", "blink", "steady",
+    };
+    const char *a = states[rnd() % 8], *b = states[rnd() % 8];
+
+    switch (kind) {
+        case 0:  return snprintf(msg, cap, "Transition %s -> %s in %u us", a, b, rnd() % 900);
+        case 1:  return snprintf(msg, cap, "Event %s ignored in %s", a, b);
+        case 2:  return snprintf(msg, cap, "LED ch %u pattern %s applied (seq %u)", rnd() % 4, a,
+                                 rnd() % 5000);
+        case 3:  return snprintf(msg, cap, "Block written in %u us (%u bytes)", rnd() % 5000,
+                                 rnd() % 4096);
+        case 4:  return snprintf(msg, cap, "Connected to %s on channel %u in %u ms", "OptiPulse-Lab",
+                                 1 + rnd() % 13, rnd() % 3000);
+        case 5:  return snprintf(msg, cap, "Frame %u: %u bytes, %u fps, queue %u", rnd() % 50000,
+                                 rnd() % 60000, rnd() % 30, rnd() % 4);
+        case 6:  return snprintf(msg, cap, "Segment %u closed: %u blocks, %u lines", rnd() % 4096,
+                                 rnd() % 256, rnd() % 20000);
+        case 7:  return snprintf(msg, cap, "Upload chunk %u acked in %u ms", rnd() % 9000,
+                                 rnd() % 400);
+        default: return snprintf(msg, cap, "Heap free %u, largest block %u", rnd() % 300000,
+                                 rnd() % 100000);
+    }
+}
+
+static char *generate_log(size_t target, size_t *len) {
+    static const char *const tags[] = {
+        "CLI_HANDLER", "LED_HANDLER", "STATE_MACHINE", "SD_LOG", "WIFI_STA", "RTV", "TETHER",
+        "UNTETHER", "SNAP",
+    };
+    char *text = malloc(target + 256);
+    size_t n = 0;
+    uint32_t ts = 300;
+
+    while (n < target) {
+        uint32_t r = rnd(), pick = r % 100;
+        char level = pick < 1 ? 'E' : pick < 4 ? 'W' : pick < 45 ? 'I' : 'D';
+        char msg[112];
+
+        ts += rnd() % 40;
+        device_msg(msg, sizeof(msg), (r >> 8) % 9);
+        n += (size_t)snprintf(text + n, 256, "%c (%u) %s: %s\n", level, (unsigned)ts,
+                              tags[(r >> 16) % 9], msg);
+    }
+    *len = n;
+    return text;
+}
+
+static char *read_log(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    char *text = NULL;
+
+    if (f && fseek(f, 0, SEEK_END) == 0) {
+        long n = ftell(f);
+        rewind(f);
+        text = malloc((size_t)n + 1);
+        *len = fread(text, 1, (size_t)n, f);
+    }
+    if (f) {
+        fclose(f);
+    }
+    return text;
+}
+
+/** Pack the log into blocks as the SD writer does (lines never straddle a block). */
+static size_t pack_blocks(const char *text, size_t len, uint8_t *blocks, uint16_t *sizes) {
+    log_sink_req_t req;
+    size_t nb = 0;
+
+    log_sink_init(&sink, 0);
+    for (const char *p = text; p < text + len;) {
+        const char *nl = memchr(p, '\n', (size_t)(text + len - p));
+        size_t n = nl ? (size_t)(nl - p) + 1 : (size_t)(text + len - p);
+        log_sink_write(&sink, p, n);
+        p += n;
+        while (log_sink_pack(&sink, &req)) {
+            memcpy(blocks + nb * BLOCK, req.data, BLOCK);
+            sizes[nb++] = BLOCK;
+            log_sink_block_done(&sink, req.buf);
+        }
+    }
+    if (log_sink_flush_partial(&sink, &req)) {
+        memcpy(blocks + nb * BLOCK, req.data, req.len);
+        sizes[nb++] = req.len;
+    }
+    return nb;
+}
+
+static void bench_log(const char *name, const char *text, size_t len, unsigned reps) {
+    size_t cap = len / (BLOCK / 2) + 16;        // Short lines: blocks are over half full
+    uint8_t *blocks = malloc(cap * BLOCK);
+    uint16_t *sizes = malloc(cap * sizeof(uint16_t));
+    uint8_t *frames = malloc(cap * LOG_SEG_FRAME_MAX);
+    size_t *offsets = malloc(cap * sizeof(size_t));
+    static uint8_t back[BLOCK];
+    size_t nb = pack_blocks(text, len, blocks, sizes);
+    size_t raw = 0, stored = 0, lz_blocks = 0;
+    uint64_t best_c = UINT64_MAX, best_d = UINT64_MAX;
+    unsigned mismatches = 0;
+
+    for (size_t i = 0; i < nb; i++) {
+        raw += sizes[i];
+    }
+    for (unsigned r = 0; r < reps; r++) {
+        uint64_t t0 = bench_now_us();
+        stored = lz_blocks = 0;
+        for (size_t i = 0; i < nb; i++) {
+            offsets[i] = stored;
+            stored += log_seg_frame_encode(&lz, frames + stored, blocks + i * BLOCK, sizes[i]);
+        }
+        uint64_t t1 = bench_now_us();
+        for (size_t i = 0; i < nb; i++) {
+            log_seg_frame_t hdr;
+            memcpy(&hdr, frames + offsets[i], sizeof(hdr));
+            const uint8_t *payload = frames + offsets[i] + sizeof(hdr);
+            if (hdr.stored == hdr.raw) {
+                memcpy(back, payload, hdr.raw);
+            } else {
+                lz_blocks++;
+                mismatches += log_lz_decompress(payload, hdr.stored, back, BLOCK) != hdr.raw;
+            }
+            mismatches += memcmp(back, blocks + i * BLOCK, sizes[i]) != 0;
+        }
+        uint64_t t2 = bench_now_us();
+        best_c = t1 - t0 < best_c ? t1 - t0 : best_c;
+        best_d = t2 - t1 < best_d ? t2 - t1 : best_d;
+    }
+
+    CHECK_EQ(mismatches, 0);
+    CHECK(stored < raw);
+    printf("  %-9s %6zu blocks %7.1f MB -> %6.1f MB  ratio %5.2f  (%zu%% LZ)  "
+           "compress %6.0f MB/s  decompress %6.0f MB/s\n", name, nb, raw / 1e6, stored / 1e6,
+           (double)raw / (double)stored, nb ? lz_blocks * 100 / nb : 0,
+           raw / (double)(best_c ? best_c : 1), raw / (double)(best_d ? best_d : 1));
+    free(blocks);
+    free(sizes);
+    free(frames);
+    free(offsets);
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+    const char *path = argc > 1 && !quick ? argv[1] : argc > 2 ? argv[2] : NULL;
+    size_t len = 0;
+
+    test_round_trips(quick ? 20000 : 200000);
+
+    CHECK_EQ(sizeof(log_lz_t), 2u << LOG_LZ_HASH_BITS);
+    CHECK(sizeof(log_lz_t) <= LZ_RAM_CAP);
+    printf("log_lz: %u-entry match table, %zu B RAM (cap %u B) + %zu B frame buffer\n",
+           1u << LOG_LZ_HASH_BITS, sizeof(log_lz_t), LZ_RAM_CAP, (size_t)LOG_SEG_FRAME_MAX);
+
+    char *text = generate_log(quick ? 2000000 : 64000000, &len);
+    bench_log("generated", text, len, quick ? 1 : 3);
+    free(text);
+    if (path) {
+        text = read_log(path, &len);
+        CHECK(text != NULL);
+        if (text) {
+            bench_log("file", text, len, 3);
+            free(text);
+        }
+    }
+    return check_done("bench_log_lz");
+}
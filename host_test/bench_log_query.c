@@ -0,0 +1,238 @@
+// File: host_test/bench_log_query.c
+// ==========================================================================================
+// Indexed log queries against a full scan (user-016). A synthetic store is generated through
+// the real log_sink -> log_store path: BOOTS boots of device-like lines (six tags, mostly
+// I/D, 0.4 % errors, colored and continuation lines), 1 MB segments, and one boot cut off
+// without closing its segment, so the next open has to recover it. Each query then runs
+// twice, with the index and scanning every block, with the page cache dropped before each:
+// time, bytes read, segments skipped. Both modes must return the same lines (count and hash).
+//
+// Usage: bench_log_query [--quick] [lines] [dir]. The full run writes 50 M lines (about
+// 3.3 GB) to ./log_query_host; --quick writes 200 k lines (13 MB).
+// ==========================================================================================
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "check.h"
+#include "log_sink.h"
+#include "log_store.h"
+#include "log_query.h"
+
+#define BOOTS           6
+#define CRASHED_BOOT    4           // Boot left open (power loss), recovered by the next one
+#define SEGMENT_KB      1024
+#define FLUSH_EVERY     50000       // Lines between flush-on-idle partial writes
+
+static log_sink_t sink;
+static log_store_t store;
+static const char *root = "log_query_host";
+static uint32_t ts_end[BOOTS];      ///< Last timestamp of each boot (ms)
+static uint32_t write_errors;
+
+static uint64_t rng = 88172645463325252ull;
+
+static uint32_t rnd(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)rng;
+}
+
+// === Store generation (packer and writer task bodies run by hand) ===
+
+static void pump(void) {
+    log_sink_req_t req;
+
+    while (log_sink_pack(&sink, &req)) {
+        write_errors += !log_store_write(&store, &req);
+        log_sink_block_done(&sink, req.buf);
+    }
+}
+
+static void flush(void) {
+    log_sink_req_t req;
+
+    pump();
+    if (log_sink_flush_partial(&sink, &req)) {
+        log_store_write(&store, &req);
+    }
+}
+
+static int device_line(char *line, size_t cap, uint64_t i, uint32_t *ts) {
+    static const char *const tags[] = {
+        "CLI_HANDLER", "LED_HANDLER", "STATE_MACHINE", "SD_LOG", "WIFI", "RTV",
+    };
+    uint32_t r = rnd();
+    unsigned pick = r >> 24;
+    char level = pick < 1 ? 'E' : pick < 6 ? 'W' : pick < 108 ? 'I' : pick < 250 ? 'D' : 'V';
+
+    *ts += r % 7;
+    if ((r & 0xFF) < 8) {
+        return snprintf(line, cap, "    continuation of previous record %u\n", (unsigned)r);
+    }
+    if ((r & 0xFF) < 24) {
+        return snprintf(line, cap, "\033[0;33m%c (%u) %s: colored message %08x\033[0m\n", level,
+                        (unsigned)*ts, tags[r % 6], (unsigned)r);
+    }
+    return snprintf(line, cap, "%c (%u) %s: event %u value=%d state=%s %08x\n", level,
+                    (unsigned)*ts, tags[r % 6], (unsigned)i, (int)(r % 1000) - 500,
+                    (r & 1) ? "OPERATIONAL" : "INIT", (unsigned)rnd());
+}
+
+static void generate_boot(uint64_t lines, bool crash, uint32_t *end) {
+    char line[160];
+    uint32_t ts = 300;
+
+    CHECK(log_store_open(&store, root, SEGMENT_KB, false));
+    log_sink_init(&sink, 0);
+    for (uint64_t i = 0; i < lines; i++) {
+        int n = device_line(line, sizeof(line), i, &ts);
+        if (!log_sink_write(&sink, line, (size_t)n)) {
+            pump();
+            log_sink_write(&sink, line, (size_t)n);
+        }
+        if ((i & 31) == 31) {
+            pump();
+        }
+        if (i % FLUSH_EVERY == FLUSH_EVERY - 1) {
+            flush();
+        }
+    }
+    flush();
+    if (crash) {                                // Power loss: nothing is closed or sealed
+        fclose(store.seg);
+        fclose(store.catalog);
+    } else {
+        log_store_close(&store);
+    }
+    *end = ts;
+}
+
+// === Queries ===
+
+/** Drop the store from the page cache, so each query reads from the disk like from a card. */
+static void evict(void) {
+    char path[LOG_PATH_MAX];
+
+    for (uint32_t id = 0; id < store.cat.next_seg; id++) {
+        log_seg_path(path, sizeof(path), root, id);
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+typedef struct {
+    uint64_t hash;              ///< Order-independent sum of the matched lines' hashes
+} result_t;
+
+static bool collect(const char *line, size_t len, const log_line_meta_t *meta, uint32_t boot,
+                    void *ctx) {
+    result_t *r = ctx;
+    uint64_t h = 1469598103934665603ull ^ boot;
+
+    (void)meta;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)line[i]) * 1099511628211ull;
+    }
+    r->hash += h;
+    return true;
+}
+
+static void run(const char *name, log_query_t q) {
+    log_query_stats_t st[2];
+    result_t res[2] = { { 0 }, { 0 } };
+    uint64_t us[2];
+
+    for (int mode = 0; mode < 2; mode++) {
+        q.use_index = mode == 0;
+        evict();
+        uint64_t t0 = bench_now_us();
+        CHECK_EQ(log_query_run(root, &q, collect, &res[mode], &st[mode]), 0);
+        us[mode] = bench_now_us() - t0;
+    }
+    bool same = st[0].matched == st[1].matched && res[0].hash == res[1].hash;
+    CHECK(same);
+    CHECK(st[0].bytes_read <= st[1].bytes_read);
+
+    printf("  %-32s %8u  %9.1f ms %10.1f MB %4u/%-4u | %9.1f ms %10.1f MB | x%.0f%s\n", name,
+           (unsigned)st[0].matched, us[0] / 1e3, st[0].bytes_read / 1e6, (unsigned)st[0].skipped,
+           (unsigned)(st[0].segments + st[0].skipped), us[1] / 1e3, st[1].bytes_read / 1e6,
+           (double)us[1] / (double)(us[0] ? us[0] : 1), same ? "" : "  MISMATCH");
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    (void)sb; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+int main(int argc, char **argv) {
+    uint64_t total = bench_quick(argc, argv) ? 200000 : 50000000;
+    log_query_t q;
+
+    for (int i = 1, pos = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            continue;
+        }
+        if (pos++ == 0) {
+            total = strtoull(argv[i], NULL, 0);
+        } else {
+            root = argv[i];
+        }
+    }
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+    uint64_t t0 = bench_now_us();
+    uint32_t recovered = 0;
+    for (int b = 0; b < BOOTS; b++) {
+        generate_boot(total / BOOTS, b + 1 == CRASHED_BOOT, &ts_end[b]);
+        recovered += store.stats.recovered;
+    }
+    uint64_t us = bench_now_us() - t0;
+    CHECK_EQ(recovered, 1);                     // Found by the boot after the crash
+    CHECK_EQ(write_errors, 0);
+    printf("store: %llu lines, %u segments of %u KB, %u boots (boot %u recovered), "
+           "written in %.1f s\n", (unsigned long long)total, (unsigned)store.cat.next_seg,
+           SEGMENT_KB, BOOTS, CRASHED_BOOT, us / 1e6);
+    printf("  %-32s %8s  %12s %13s %9s | %12s %13s\n", "query", "matches", "index", "read",
+           "skipped", "scan", "read");
+
+    log_query_init(&q);
+    q.boot = 3;
+    q.from_ms = ts_end[2] / 2;
+    q.to_ms = q.from_ms + 10000;
+    run("boot 3, 10 s window", q);
+
+    log_query_init(&q);
+    q.boot = CRASHED_BOOT;
+    q.from_ms = ts_end[CRASHED_BOOT - 1] / 3;
+    q.to_ms = q.from_ms + 60000;
+    run("recovered boot, 60 s window", q);
+
+    log_query_init(&q);
+    q.boot = 5;
+    q.from_ms = ts_end[4] / 2;
+    q.to_ms = q.from_ms + 600000;
+    q.level = 2;
+    run("boot 5, 10 min window, W and E", q);
+
+    log_query_init(&q);
+    q.from_ms = ts_end[0] / 2;
+    q.to_ms = q.from_ms + 1000;
+    run("all boots, 1 s window", q);
+
+    log_query_init(&q);
+    q.level = 1;
+    run("all boots, errors only", q);
+
+    log_query_init(&q);
+    q.boot = 2;
+    run("boot 2, everything", q);
+
+    return check_done("bench_log_query");
+}
@@ -0,0 +1,262 @@
+// File: host_test/bench_rtv_motion.c
+// ==========================================================================================
+// Motion gate kernels (user-024): rtv_motion_sad_scalar against rtv_motion_sad_vector (GCC
+// vector extensions here, the PIE kernel's portable twin).
+//   1. Kernel equality on random columns: noise, small differences, 0/255 extremes (the
+//      per-pixel cap), every stride and row count.
+//   2. Decisions on recorded frames: still and moving stretches with sensor noise, in
+//      GRAY8, YUV422 and RGB565 at four sizes (one not a multiple of the block). Two gates,
+//      one per kernel, must pass and skip exactly the same frames.
+//   3. Time per frame check (thumbnail + blocks) and the SAD of a whole thumbnail.
+//
+// Usage: bench_rtv_motion [--quick] [file width height]. The file is a raw GRAY8 recording
+// (width x height bytes per frame, e.g. ffmpeg -pix_fmt gray -f rawvideo); its decisions
+// are compared the same way.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "rtv_motion.h"
+#include "rtv_pipe.h"
+
+#define FRAME_US        100000      // 10 fps
+#define BLOCK_W         RTV_MOTION_BLOCK_W
+#define BLOCK_H         RTV_MOTION_BLOCK_H
+
+static const rtv_motion_config_t config = { .threshold = 4, .blocks = 1, .keepalive_ms = 2000 };
+static uint64_t clock_us;
+static uint32_t rs = 12345;
+
+static uint32_t rnd(void) {
+    rs = rs * 1103515245u + 12345u;
+    return rs >> 8;
+}
+
+static uint64_t gate_now(void *ctx) {
+    (void)ctx;
+    return clock_us;
+}
+
+// === 1. Kernel equality ===
+
+static void test_kernels(unsigned cases) {
+    enum { BYTES = 4096 };
+    uint8_t *a = aligned_alloc(16, BYTES), *b = aligned_alloc(16, BYTES);
+    unsigned mismatches = 0;
+
+    for (unsigned t = 0; t < cases; t++) {
+        for (int i = 0; i < BYTES; i++) {
+            a[i] = (uint8_t)rnd();
+            switch (t % 3) {
+                case 0:  b[i] = (uint8_t)rnd(); break;
+                case 1:  b[i] = (uint8_t)(a[i] + (int)(rnd() % 9) - 4); break;
+                default: b[i] = (rnd() & 1) ? 0 : 255; break;
+            }
+        }
+        size_t stride = BLOCK_W * (1 + rnd() % 8);
+        unsigned rows = 1 + rnd() % (BYTES / stride);
+        mismatches += rtv_motion_sad_scalar(a, b, stride, rows) !=
+                      rtv_motion_sad_vector(a, b, stride, rows);
+    }
+    memset(a, 0, BYTES);
+    memset(b, 255, BYTES);
+    CHECK_EQ(rtv_motion_sad_vector(a, b, BLOCK_W, BLOCK_H),
+             BLOCK_W * BLOCK_H * RTV_MOTION_DIFF_MAX);
+    CHECK_EQ(mismatches, 0);
+    free(a);
+    free(b);
+}
+
+// === 2. Decisions on recorded frames ===
+
+/** Still, slow and fast stretches of 40 frames, like a bench camera watching a lab. */
+static uint8_t motion_at(unsigned i) {
+    switch ((i / 40) % 4) {
+        case 1:  return 2;
+        case 3:  return 6;
+        default: return 0;
+    }
+}
+
+/** Sensor noise of +-2 on luma (RGB565 stays bit-exact: its fields would wrap). */
+static void add_noise(uint8_t *px, size_t len, rtv_format_t fmt) {
+    size_t step = fmt == RTV_FMT_GRAY8 ? 1 : 2;
+
+    if (fmt == RTV_FMT_RGB565) {
+        return;
+    }
+    for (size_t i = 0; i < len; i += step) {
+        int v = px[i] + (int)(rnd() % 5) - 2;
+        px[i] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+}
+
+static uint8_t *record(rtv_format_t fmt, uint16_t w, uint16_t h, unsigned n) {
+    size_t fb = rtv_frame_size(fmt, w, h);
+    uint8_t *frames = malloc(fb * n);
+    rtv_synth_t synth;
+    rtv_source_t src;
+
+    rtv_synth_init(&synth, &src, w, h, fmt, 0);
+    for (unsigned i = 0; i < n; i++) {
+        rtv_frame_t f = { .data = frames + fb * i, .cap = fb };
+        synth.motion = motion_at(i);
+        src.capture(src.ctx, &f);
+        memset(f.data, 0, fb * 8 / h);          // No counter strip: a camera has none
+        add_noise(f.data, fb, fmt);
+    }
+    return frames;
+}
+
+typedef struct {
+    rtv_motion_t gate;
+    uint8_t *bufs[2];
+} gate_t;
+
+static void gate_open(gate_t *g, uint16_t w, uint16_t h, rtv_motion_sad_fn sad) {
+    size_t tb = rtv_motion_thumb_bytes(w, h);
+
+    g->bufs[0] = aligned_alloc(16, tb);
+    g->bufs[1] = aligned_alloc(16, tb);
+    rtv_motion_init(&g->gate, &config, g->bufs[0], g->bufs[1], tb, sad, gate_now, NULL);
+}
+
+static void gate_close(gate_t *g) {
+    free(g->bufs[0]);
+    free(g->bufs[1]);
+}
+
+/**
+ * @brief Check every frame with both kernels; time rtv_motion_changed() over `reps` passes.
+ *
+ * @return Frames the gate skipped.
+ */
+static uint32_t compare(const char *name, const uint8_t *frames, unsigned n, rtv_format_t fmt,
+                        uint16_t w, uint16_t h, unsigned reps) {
+    size_t fb = rtv_frame_size(fmt, w, h);
+    gate_t scalar, vector;
+    unsigned differ = 0;
+    uint64_t us[2] = { 0, 0 };
+
+    gate_open(&scalar, w, h, rtv_motion_sad_scalar);
+    gate_open(&vector, w, h, rtv_motion_sad_vector);
+    for (unsigned i = 0; i < n; i++) {
+        rtv_frame_t f = { .data = (uint8_t *)frames + fb * i, .cap = fb, .len = fb, .width = w,
+                          .height = h, .format = fmt };
+        clock_us = (uint64_t)i * FRAME_US;
+        differ += rtv_motion_check(&scalar.gate, &f) != rtv_motion_check(&vector.gate, &f);
+    }
+    CHECK_EQ(differ, 0);
+    CHECK_EQ(scalar.gate.stats.passed, vector.gate.stats.passed);
+
+    for (int k = 0; k < 2; k++) {
+        rtv_motion_t *m = k ? &vector.gate : &scalar.gate;
+        uint64_t t0 = bench_now_us();
+        for (unsigned r = 0; r < reps; r++) {
+            for (unsigned i = 0; i < n; i++) {
+                rtv_frame_t f = { .data = (uint8_t *)frames + fb * i, .cap = fb, .len = fb,
+                                  .width = w, .height = h, .format = fmt };
+                rtv_motion_changed(m, &f);
+            }
+        }
+        us[k] = bench_now_us() - t0;
+    }
+    const rtv_motion_stats_t *st = &vector.gate.stats;
+    printf("  %-7s %4ux%-4u %3ux%-3u thumb %4u blocks | %4u frames %4u passed %4u skipped "
+           "%3u keepalive | equal %-3s | check %7.1f us scalar %7.1f us vector\n", name,
+           (unsigned)w, (unsigned)h, (unsigned)vector.gate.tw, (unsigned)vector.gate.th,
+           (unsigned)st->blocks, (unsigned)st->frames, (unsigned)st->passed,
+           (unsigned)st->skipped, (unsigned)st->keepalive, differ ? "NO" : "yes",
+           (double)us[0] / (reps * n), (double)us[1] / (reps * n));
+    uint32_t skipped = st->skipped;
+    gate_close(&scalar);
+    gate_close(&vector);
+    return skipped;
+}
+
+static void test_recorded(unsigned n, unsigned reps) {
+    static const rtv_format_t formats[] = { RTV_FMT_GRAY8, RTV_FMT_YUV422, RTV_FMT_RGB565 };
+    static const uint16_t sizes[][2] = { { 160, 120 }, { 320, 240 }, { 640, 480 }, { 162, 117 } };
+
+    for (size_t fi = 0; fi < sizeof(formats) / sizeof(formats[0]); fi++) {
+        for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+            uint16_t w = sizes[si][0], h = sizes[si][1];
+            uint8_t *frames = record(formats[fi], w, h, n);
+            uint32_t skipped = compare(rtv_format_str(formats[fi]), frames, n, formats[fi], w, h,
+                                       reps);
+            CHECK(skipped > 0);                 // The still stretches are gated
+            free(frames);
+        }
+    }
+}
+
+static void test_file(const char *path, uint16_t w, uint16_t h) {
+    size_t fb = (size_t)w * h;
+    FILE *f = fopen(path, "rb");
+    uint8_t *frames = NULL;
+    unsigned n = 0;
+
+    CHECK(f != NULL && fb > 0);
+    if (!f || fb == 0) {
+        return;
+    }
+    fseek(f, 0, SEEK_END);
+    n = (unsigned)(ftell(f) / (long)fb);
+    rewind(f);
+    frames = malloc(fb * (n ? n : 1));
+    n = (unsigned)fread(frames, fb, n, f);
+    fclose(f);
+    CHECK(n > 0);
+    if (n) {
+        compare("file", frames, n, RTV_FMT_GRAY8, w, h, 3);
+    }
+    free(frames);
+}
+
+// === 3. SAD of a whole thumbnail ===
+
+static void bench_sad(unsigned reps) {
+    enum { TW = RTV_MOTION_THUMB_W, TH = 96 };
+    uint8_t *a = aligned_alloc(16, TW * TH), *b = aligned_alloc(16, TW * TH);
+    static const rtv_motion_sad_fn kernels[2] = { rtv_motion_sad_scalar, rtv_motion_sad_vector };
+    uint32_t sums[2] = { 0, 0 };
+
+    for (size_t i = 0; i < TW * TH; i++) {
+        a[i] = (uint8_t)rnd();
+        b[i] = (uint8_t)rnd();
+    }
+    for (int k = 0; k < 2; k++) {
+        uint64_t t0 = bench_now_us();
+        for (unsigned r = 0; r < reps; r++) {
+            for (unsigned by = 0; by < TH; by += BLOCK_H) {
+                for (unsigned bx = 0; bx < TW; bx += BLOCK_W) {
+                    sums[k] += kernels[k](a + by * TW + bx, b + by * TW + bx, TW, BLOCK_H);
+                }
+            }
+        }
+        uint64_t us = bench_now_us() - t0;
+        printf("  SAD of a %ux%u thumbnail (%u blocks): %s %6.2f us (%5.0f MB/s per input)\n",
+               TW, TH, (TW / BLOCK_W) * (TH / BLOCK_H), k ? "vector" : "scalar",
+               (double)us / reps, (double)TW * TH * reps / (double)(us ? us : 1));
+    }
+    CHECK_EQ(sums[0], sums[1]);
+    free(a);
+    free(b);
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+    unsigned frames = quick ? 160 : 320;
+    int arg = quick ? 2 : 1;
+
+    test_kernels(quick ? 20000 : 200000);
+    printf("motion gate, threshold %u, %u block, keepalive %u ms, %u frames at 10 fps:\n",
+           (unsigned)config.threshold, (unsigned)config.blocks, (unsigned)config.keepalive_ms,
+           frames);
+    test_recorded(frames, quick ? 1 : 20);
+    if (argc >= arg + 3) {
+        test_file(argv[arg], (uint16_t)atoi(argv[arg + 1]), (uint16_t)atoi(argv[arg + 2]));
+    }
+    bench_sad(quick ? 2000 : 20000);
+    return check_done("bench_rtv_motion");
+}
@@ -0,0 +1,374 @@
+// File: host_test/bench_rtv_pool.c
+// ==========================================================================================
+// RTV frame pool and pipeline (user-021).
+//   1. Pool rules on a virtual clock: latest-frame-wins, shared references, the third
+//      buffer, starvation when two viewers hold different frames, recycling, frame age.
+//   2. Pipeline: a DROP stage and a NEW stage, with and without a spare buffer.
+//   3. The synthetic source in every raw format.
+//   4. Threads: the synthetic source paced to a frame rate into a pool, viewers taking
+//      the latest frame and holding it for their send time. Published and delivered fps,
+//      frame age (capture to release), stale and starved counts. A slow viewer must only
+//      cost stale frames: the age stays bounded and the pool never grows. Each viewer
+//      checks that its frame is not overwritten while it holds it.
+//
+// Usage: bench_rtv_pool [--quick]. --quick runs each scenario for 0.5 s instead of 5 s.
+// ==========================================================================================
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "check.h"
+#include "rtv_pool.h"
+#include "rtv_pipe.h"
+
+#define WIDTH           320
+#define HEIGHT          240
+#define VIEWERS_MAX     4
+
+// === 1. Pool rules (virtual clock, no locking) ===
+
+static uint64_t virtual_us;
+
+static void no_lock(void *ctx) {
+    (void)ctx;
+}
+
+static uint64_t virtual_now(void *ctx) {
+    (void)ctx;
+    return virtual_us;
+}
+
+static const rtv_pool_ops_t virtual_ops = {
+    .lock = no_lock, .unlock = no_lock, .now_us = virtual_now,
+};
+
+static uint8_t small[4][64];
+static uint8_t *const small_bufs[4] = { small[0], small[1], small[2], small[3] };
+
+static void test_pool(void) {
+    rtv_pool_t p;
+    rtv_pool_stats_t st;
+
+    CHECK(!rtv_pool_init(&p, &virtual_ops, small_bufs, 0, sizeof(small[0])));
+    CHECK(rtv_pool_init(&p, &virtual_ops, small_bufs, 3, sizeof(small[0])));
+    CHECK(rtv_pool_acquire(&p, 0) == NULL);
+
+    rtv_frame_t *f = rtv_pool_get_free(&p);
+    virtual_us = 100;
+    rtv_pool_publish(&p, f, 100);
+    rtv_frame_t *a = rtv_pool_acquire(&p, 0);
+    CHECK(a != NULL && a->seq == 1);
+    CHECK(rtv_pool_acquire(&p, 1) == NULL);     // Nothing newer
+
+    f = rtv_pool_get_free(&p);
+    rtv_pool_publish(&p, f, 200);               // Latest 2, frame 1 still held
+    rtv_frame_t *b = rtv_pool_acquire(&p, 1);
+    CHECK(b != NULL && b != a && b->seq == 2);
+
+    f = rtv_pool_get_free(&p);                  // The third buffer
+    CHECK(f != NULL && f != a && f != b);
+    rtv_pool_publish(&p, f, 300);               // Latest 3; 1 and 2 held
+    CHECK(rtv_pool_get_free(&p) == NULL);       // Two viewers on different frames: starved
+    CHECK_EQ(rtv_pool_held(&p), 2);
+
+    rtv_pool_release(&p, a);
+    CHECK_EQ(rtv_pool_held(&p), 1);
+    f = rtv_pool_get_free(&p);
+    CHECK(f == a);                              // Recycled at once
+    rtv_pool_publish(&p, f, 400);               // Frame 3 retired unread: stale
+    virtual_us = 1000;
+    rtv_pool_release(&p, b);
+
+    f = rtv_pool_get_free(&p);
+    rtv_pool_discard(&p, f);
+    rtv_pool_get_stats(&p, &st, true);
+    CHECK_EQ(st.published, 4);
+    CHECK_EQ(st.delivered, 2);
+    CHECK_EQ(st.stale, 1);
+    CHECK_EQ(st.starved, 1);
+    CHECK_EQ(st.discarded, 1);
+    CHECK_EQ(st.age_count, 2);
+    CHECK_EQ(st.age_max_us, 800);               // Frame 2: captured at 200, released at 1000
+    CHECK_EQ(st.busy_max, 3);
+    rtv_pool_get_stats(&p, &st, false);
+    CHECK_EQ(st.published, 0);
+}
+
+// === 2. Pipeline stages ===
+
+static rtv_stage_result_t drop_odd(void *ctx, rtv_frame_t *in, rtv_frame_t *out) {
+    (void)ctx; (void)out;
+    return (in->data[0] & 1) ? RTV_STAGE_DROP : RTV_STAGE_KEEP;
+}
+
+static rtv_stage_result_t halve(void *ctx, rtv_frame_t *in, rtv_frame_t *out) {
+    (void)ctx;
+    if (!out) {
+        return RTV_STAGE_KEEP;                  // No spare buffer: pass the input on
+    }
+    out->len = in->len;
+    out->width = in->width / 2;
+    out->height = in->height;
+    out->format = in->format;
+    out->data[0] = in->data[0];
+    return RTV_STAGE_NEW;
+}
+
+static bool count_source(void *ctx, rtv_frame_t *f) {
+    uint8_t *n = ctx;
+
+    f->data[0] = (*n)++;
+    f->len = 1;
+    f->width = 2;
+    f->height = 1;
+    f->format = RTV_FMT_GRAY8;
+    return true;
+}
+
+static void test_pipe(void) {
+    rtv_pool_t p;
+    rtv_pool_stats_t st;
+    rtv_pipe_t pp;
+    uint8_t n = 0;
+    rtv_source_t src = { .name = "count", .ctx = &n, .capture = count_source };
+    rtv_stage_t gate = { .name = "gate", .run = drop_odd };
+    rtv_stage_t half = { .name = "half", .needs_out = true, .run = halve };
+
+    CHECK(rtv_pool_init(&p, &virtual_ops, small_bufs, 4, sizeof(small[0])));
+    rtv_pipe_init(&pp, &p, &src);
+    CHECK(rtv_pipe_add_stage(&pp, &gate));
+    CHECK(rtv_pipe_add_stage(&pp, &half));
+    for (int i = 0; i < 10; i++) {
+        rtv_pipe_step(&pp);
+    }
+    CHECK_EQ(pp.stats.captured, 10);
+    CHECK_EQ(pp.stats.dropped, 5);
+    CHECK_EQ(pp.stats.published, 5);
+    rtv_pool_get_stats(&p, &st, false);
+    CHECK(st.busy_max <= 3);                    // Filling + output + latest
+
+    rtv_frame_t *h1 = rtv_pool_acquire(&p, 0);
+    CHECK(h1 != NULL && h1->width == 1);
+    rtv_pipe_step(&pp);
+    rtv_pipe_step(&pp);
+    rtv_frame_t *h2 = rtv_pool_acquire(&p, h1->seq);
+    CHECK(h2 != NULL && h2 != h1);
+    rtv_pipe_step(&pp);                         // Two held + latest + filling: no `out`,
+    rtv_pipe_step(&pp);                         // the stage keeps its input
+    CHECK_EQ(pp.stats.no_frame, 0);
+    CHECK_EQ(pp.stats.published, 7);
+    rtv_pool_release(&p, h1);
+    rtv_pool_release(&p, h2);
+    CHECK_EQ(rtv_pool_held(&p), 0);
+}
+
+// === 3. Synthetic source ===
+
+static void test_synth(void) {
+    static uint8_t big[WIDTH * HEIGHT * 2];
+    rtv_synth_t s;
+    rtv_source_t src;
+
+    for (int fmt = RTV_FMT_GRAY8; fmt <= RTV_FMT_YUV422; fmt++) {
+        rtv_frame_t f = { .data = big, .cap = sizeof(big) };
+        rtv_synth_init(&s, &src, WIDTH, HEIGHT, (rtv_format_t)fmt, 4);
+        CHECK(src.capture(src.ctx, &f));
+        CHECK_EQ(f.len, rtv_frame_size((rtv_format_t)fmt, WIDTH, HEIGHT));
+        CHECK_EQ(f.width, WIDTH);
+        CHECK_EQ(f.height, HEIGHT);
+        CHECK_EQ(f.format, fmt);
+    }
+    rtv_frame_t f = { .data = big, .cap = 100 };
+    rtv_synth_init(&s, &src, WIDTH, HEIGHT, RTV_FMT_GRAY8, 0);
+    CHECK(!src.capture(src.ctx, &f));           // Buffer too small: no frame
+}
+
+// === 4. Threads: producer at a frame rate, viewers at their send time ===
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static rtv_pool_t pool;
+static atomic_bool stop;
+
+static void pool_lock(void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&mutex);
+}
+
+static void pool_unlock(void *ctx) {
+    (void)ctx;
+    pthread_mutex_unlock(&mutex);
+}
+
+static uint64_t pool_now(void *ctx) {
+    (void)ctx;
+    return bench_now_us();
+}
+
+static void pool_published(void *ctx, const rtv_frame_t *f) {
+    (void)ctx; (void)f;
+    pthread_mutex_lock(&mutex);
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&mutex);
+}
+
+static const rtv_pool_ops_t thread_ops = {
+    .lock = pool_lock, .unlock = pool_unlock, .now_us = pool_now, .published = pool_published,
+};
+
+typedef struct {
+    unsigned send_ms;
+    uint32_t frames;
+    uint32_t overwritten;       ///< Frames that changed while held
+} viewer_t;
+
+static void sleep_us(uint64_t us) {
+    nanosleep(&(struct timespec){ .tv_sec = (time_t)(us / 1000000),
+                                  .tv_nsec = (long)(us % 1000000) * 1000 }, NULL);
+}
+
+static uint32_t frame_hash(const rtv_frame_t *f) {
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < f->len; i += 7) {
+        h = (h ^ f->data[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void *viewer(void *arg) {
+    viewer_t *v = arg;
+    uint32_t seq = 0;
+
+    while (!atomic_load(&stop)) {
+        rtv_frame_t *f = rtv_pool_acquire(&pool, seq);
+        if (!f) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += 20000000;
+            if (until.tv_nsec >= 1000000000) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000;
+            }
+            pthread_mutex_lock(&mutex);
+            pthread_cond_timedwait(&wake, &mutex, &until);
+            pthread_mutex_unlock(&mutex);
+            continue;
+        }
+        uint32_t h = frame_hash(f);
+        seq = f->seq;
+        sleep_us(v->send_ms * 1000u);           // The send
+        v->overwritten += frame_hash(f) != h || f->seq != seq;
+        rtv_pool_release(&pool, f);
+        v->frames++;
+    }
+    return NULL;
+}
+
+typedef struct {
+    unsigned fps;               ///< 0: as fast as the source goes
+    uint8_t  buffers;
+    unsigned send_ms[VIEWERS_MAX];  ///< 0 ends the list
+} scenario_t;
+
+static void run(const scenario_t *sc, unsigned ms) {
+    size_t cap = rtv_frame_size(RTV_FMT_YUV422, WIDTH, HEIGHT);
+    uint8_t *bufs[RTV_POOL_MAX];
+    viewer_t views[VIEWERS_MAX] = { { 0 } };
+    pthread_t th[VIEWERS_MAX];
+    rtv_pool_stats_t st;
+    rtv_synth_t synth;
+    rtv_source_t src;
+    rtv_pipe_t pp;
+    unsigned nv = 0;
+
+    for (uint8_t i = 0; i < sc->buffers; i++) {
+        bufs[i] = malloc(cap);
+    }
+    CHECK(rtv_pool_init(&pool, &thread_ops, bufs, sc->buffers, cap));
+    rtv_synth_init(&synth, &src, WIDTH, HEIGHT, RTV_FMT_YUV422, 2);
+    rtv_pipe_init(&pp, &pool, &src);
+    atomic_store(&stop, false);
+    for (; nv < VIEWERS_MAX && sc->send_ms[nv]; nv++) {
+        views[nv].send_ms = sc->send_ms[nv];
+        pthread_create(&th[nv], NULL, viewer, &views[nv]);
+    }
+
+    uint64_t period = sc->fps ? 1000000u / sc->fps : 0;
+    uint64_t t0 = bench_now_us(), next = t0;
+    while (bench_now_us() - t0 < ms * 1000ull) {
+        rtv_pipe_step(&pp);
+        if (period) {
+            uint64_t now = bench_now_us();
+            next += period;
+            if (next > now) {
+                sleep_us(next - now);
+            } else {
+                next = now;
+            }
+        } else {
+            sched_yield();                      // Let the viewers in on one core
+        }
+    }
+    double secs = (double)(bench_now_us() - t0) / 1e6;
+    atomic_store(&stop, true);
+    for (unsigned i = 0; i < nv; i++) {
+        pthread_join(th[i], NULL);
+    }
+    rtv_pool_get_stats(&pool, &st, false);
+
+    unsigned slowest = 0;
+    if (sc->fps) {
+        printf("  %3u fps target, ", sc->fps);
+    } else {
+        printf("  unpaced source, ");
+    }
+    printf("%u buffers (%4zu KB) |", (unsigned)sc->buffers, sc->buffers * cap / 1024);
+    for (unsigned i = 0; i < nv; i++) {
+        CHECK_EQ(views[i].overwritten, 0);
+        CHECK(views[i].frames > 0);
+        slowest = views[i].send_ms > slowest ? views[i].send_ms : slowest;
+        printf(" %3u ms viewer %5.1f fps |", views[i].send_ms, views[i].frames / secs);
+    }
+    printf(" published %6.1f fps, age avg %5.1f ms max %5.1f ms, %u stale, %u starved, "
+           "busy max %u\n", pp.stats.published / secs,
+           st.age_count ? (double)st.age_total_us / 1e3 / st.age_count : 0.0,
+           st.age_max_us / 1e3, (unsigned)st.stale, (unsigned)st.starved, (unsigned)st.busy_max);
+
+    CHECK(st.busy_max <= sc->buffers);
+    CHECK_EQ(rtv_pool_held(&pool), 0);
+    if (sc->fps) {
+        // Latest-frame-wins: a frame is at most a period old when taken, then sent. Generous
+        // slack for a loaded host; a queue would grow with the run length instead.
+        CHECK(st.age_max_us < (period + slowest * 1000u) * 2 + 200000u);
+        CHECK(pp.stats.published > sc->fps * secs * 0.8);   // A slow viewer never slows capture
+    }
+    if (sc->buffers >= nv + 2) {
+        CHECK_EQ(st.starved, 0);                // Filling + latest + one per viewer
+    }
+    for (uint8_t i = 0; i < sc->buffers; i++) {
+        free(bufs[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned ms = bench_quick(argc, argv) ? 500 : 5000;
+    static const scenario_t scenarios[] = {
+        { .fps = 30, .buffers = 3, .send_ms = { 5 } },          // Viewer keeps up
+        { .fps = 30, .buffers = 3, .send_ms = { 100 } },        // Slow client: stale frames
+        { .fps = 30, .buffers = 3, .send_ms = { 10, 100 } },    // Two viewers: starved when on different frames
+        { .fps = 30, .buffers = 4, .send_ms = { 10, 100 } },
+        { .fps = 0,  .buffers = 3, .send_ms = { 5 } },          // Source as fast as it goes
+    };
+
+    test_pool();
+    test_pipe();
+    test_synth();
+
+    printf("rtv pool, %ux%u YUV422 synthetic source:\n", WIDTH, HEIGHT);
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        run(&scenarios[i], ms);
+    }
+    return check_done("bench_rtv_pool");
+}
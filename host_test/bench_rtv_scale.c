@@ -0,0 +1,205 @@
+// File: host_test/bench_rtv_scale.c
+// ==========================================================================================
+// RTV downscaler (user-025).
+//   1. Correctness: random frames of every raw format, random sizes (odd ones included) and
+//      factors 1..RTV_SCALE_MAX, in the frame's format and to gray, with the scalar and the
+//      vector kernels; each output must equal a box average computed straight from the
+//      definition. Frames smaller than one box are left alone; factor 1 is a no-op.
+//   2. Throughput on 640x480 frames per format, output kind and factor (2, 4, 8), both
+//      kernels: best time per frame and source MB/s.
+//
+// Usage: bench_rtv_scale [--quick].
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "rtv_scale.h"
+
+#define BENCH_W     640
+#define BENCH_H     480
+
+static const rtv_format_t formats[] = { RTV_FMT_GRAY8, RTV_FMT_RGB565, RTV_FMT_YUV422 };
+static uint32_t rs = 777;
+
+static uint32_t rnd(void) {
+    rs = rs * 1103515245u + 12345u;
+    return rs >> 8;
+}
+
+// === 1. Correctness against the definition ===
+
+static uint8_t mean(uint32_t sum, uint32_t n) {
+    return (uint8_t)((sum + n / 2) / n);
+}
+
+/** One output pixel of a box average, the slow way. */
+static void box_pixel(const uint8_t *src, rtv_format_t fmt, int w, int f, bool gray, int ox,
+                      int oy, uint8_t *out, int ow) {
+    uint32_t s[3] = { 0, 0, 0 }, area = (uint32_t)(f * f);
+
+    for (int dy = 0; dy < f; dy++) {
+        for (int dx = 0; dx < f; dx++) {
+            int x = ox * f + dx, y = oy * f + dy;
+            const uint8_t *p = src + ((size_t)y * w + x) * (fmt == RTV_FMT_GRAY8 ? 1 : 2);
+            if (fmt == RTV_FMT_RGB565) {
+                uint16_t px = (uint16_t)(p[0] | p[1] << 8);
+                s[0] += px >> 11;
+                s[1] += (px >> 5) & 63;
+                s[2] += px & 31;
+            } else {
+                s[0] += p[0];                   // Gray, or Y of YUV422
+            }
+        }
+    }
+    size_t i = (size_t)oy * ow + ox;
+    if (fmt == RTV_FMT_GRAY8 || (fmt == RTV_FMT_YUV422 && gray)) {
+        out[i] = mean(s[0], area);
+    } else if (fmt == RTV_FMT_YUV422) {
+        // Chroma: U (even output x) or V (odd) of the source pairs under the output pair
+        uint32_t c = 0;
+        int base = (ox & ~1) * f, off = (ox & 1) ? 3 : 1;
+        for (int dy = 0; dy < f; dy++) {
+            for (int q = 0; q < f; q++) {
+                c += src[((size_t)(oy * f + dy) * w + base + q * 2) * 2 + off];
+            }
+        }
+        out[i * 2] = mean(s[0], area);
+        out[i * 2 + 1] = mean(c, area);
+    } else if (gray) {
+        uint32_t r8 = mean(s[0] << 3, area), g8 = mean(s[1] << 2, area), b8 = mean(s[2] << 3, area);
+        out[i] = (uint8_t)((77 * r8 + 150 * g8 + 29 * b8) >> 8);
+    } else {
+        uint16_t px = (uint16_t)(mean(s[0], area) << 11 | mean(s[1], area) << 5 | mean(s[2], area));
+        out[i * 2] = (uint8_t)px;
+        out[i * 2 + 1] = (uint8_t)(px >> 8);
+    }
+}
+
+static void test_box(unsigned cases) {
+    unsigned bad_size = 0, bad_pixels = 0, bad_passthrough = 0;
+
+    for (unsigned t = 0; t < cases; t++) {
+        rtv_format_t fmt = formats[t % 3];
+        int w = 2 + (int)(rnd() % 330), h = 1 + (int)(rnd() % 200), f = 1 + (int)(rnd() % RTV_SCALE_MAX);
+        bool gray = rnd() & 1;
+        if (fmt == RTV_FMT_YUV422) {
+            w &= ~1;
+        }
+        size_t fb = rtv_frame_size(fmt, (uint16_t)w, (uint16_t)h);
+        size_t work_bytes = rtv_scale_work_bytes(fmt, (uint16_t)w);
+        uint8_t *src = malloc(fb), *ref = malloc(fb), *buf = malloc(fb);
+        uint16_t *work = malloc(work_bytes);
+        uint16_t ow, oh;
+
+        for (size_t i = 0; i < fb; i++) {
+            src[i] = (t & 4) ? (uint8_t)rnd() : (uint8_t)((rnd() & 1) * 255);   // Noise or 0/255
+        }
+        rtv_scale_size(fmt, (uint16_t)w, (uint16_t)h, (uint8_t)f, &ow, &oh);
+        for (int oy = 0; oy < oh; oy++) {
+            for (int ox = 0; ox < ow; ox++) {
+                box_pixel(src, fmt, w, f, gray, ox, oy, ref, ow);
+            }
+        }
+        rtv_format_t out_fmt = gray ? RTV_FMT_GRAY8 : fmt;
+
+        for (int k = 0; k < 2; k++) {
+            rtv_scale_t sc;
+            rtv_frame_t fr = { .data = buf, .cap = fb, .len = fb, .width = (uint16_t)w,
+                               .height = (uint16_t)h, .format = fmt };
+            rtv_scale_init(&sc, (uint8_t)f, gray, work, work_bytes,
+                           k ? &rtv_scale_vector : &rtv_scale_scalar);
+            memcpy(buf, src, fb);
+            bool scaled = rtv_scale_frame(&sc, &fr);
+
+            if (ow == 0) {                      // Smaller than one box
+                bad_passthrough += scaled || memcmp(buf, src, fb) != 0;
+            } else if (f == 1 && out_fmt == fmt) {
+                bad_passthrough += memcmp(buf, src, fb) != 0;
+            } else if (!scaled || fr.width != ow || fr.height != oh || fr.format != out_fmt ||
+                       fr.len != rtv_frame_size(out_fmt, ow, oh)) {
+                bad_size++;
+            } else {
+                bad_pixels += memcmp(buf, ref, fr.len) != 0;
+            }
+        }
+        free(src);
+        free(ref);
+        free(buf);
+        free(work);
+    }
+    CHECK_EQ(bad_size, 0);
+    CHECK_EQ(bad_pixels, 0);
+    CHECK_EQ(bad_passthrough, 0);
+}
+
+static void test_unscaled(void) {
+    static uint8_t jpeg[64];
+    uint16_t work[64];
+    rtv_scale_t sc;
+    rtv_frame_t f = { .data = jpeg, .cap = sizeof(jpeg), .len = 40, .width = 320, .height = 240,
+                      .format = RTV_FMT_JPEG };
+
+    rtv_scale_init(&sc, 2, false, work, sizeof(work), &rtv_scale_vector);
+    CHECK(!rtv_scale_frame(&sc, &f));           // Compressed: passed on
+    CHECK_EQ(f.len, 40);
+    f = (rtv_frame_t){ .data = jpeg, .cap = sizeof(jpeg), .len = 64, .width = 64, .height = 1,
+                       .format = RTV_FMT_GRAY8 };
+    CHECK(rtv_scale_frame(&sc, &f) == false);   // One row: smaller than a box
+    CHECK_EQ(sc.stats.unscaled, 2);
+}
+
+// === 2. Throughput ===
+
+static void bench_format(rtv_format_t fmt, bool gray, uint8_t factor, unsigned reps) {
+    size_t fb = rtv_frame_size(fmt, BENCH_W, BENCH_H);
+    size_t work_bytes = rtv_scale_work_bytes(fmt, BENCH_W);
+    uint8_t *src = malloc(fb), *buf = malloc(fb);
+    uint16_t *work = malloc(work_bytes);
+    uint64_t best[2] = { UINT64_MAX, UINT64_MAX };
+    uint16_t ow, oh;
+
+    for (size_t i = 0; i < fb; i++) {
+        src[i] = (uint8_t)rnd();
+    }
+    for (int k = 0; k < 2; k++) {
+        rtv_scale_t sc;
+        rtv_scale_init(&sc, factor, gray, work, work_bytes, k ? &rtv_scale_vector : &rtv_scale_scalar);
+        for (unsigned r = 0; r < reps; r++) {
+            rtv_frame_t f = { .data = buf, .cap = fb, .len = fb, .width = BENCH_W,
+                              .height = BENCH_H, .format = fmt };
+            memcpy(buf, src, fb);               // In place: every pass starts from the source
+            uint64_t t0 = bench_now_us();
+            rtv_scale_frame(&sc, &f);
+            uint64_t us = bench_now_us() - t0;
+            best[k] = us < best[k] ? us : best[k];
+        }
+    }
+    rtv_scale_size(fmt, BENCH_W, BENCH_H, factor, &ow, &oh);
+    printf("  %-7s -> %-6s %2ux %3ux%-3u | scalar %7.1f us %6.0f MB/s | vector %7.1f us %6.0f MB/s\n",
+           rtv_format_str(fmt), gray ? "gray" : "same", factor, ow, oh, (double)best[0],
+           fb / (double)(best[0] ? best[0] : 1), (double)best[1], fb / (double)(best[1] ? best[1] : 1));
+    free(src);
+    free(buf);
+    free(work);
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+    static const uint8_t factors[] = { 2, 4, 8 };
+
+    test_box(quick ? 600 : 3000);
+    test_unscaled();
+
+    printf("rtv_scale on %ux%u frames (best of %u):\n", BENCH_W, BENCH_H, quick ? 5 : 300);
+    for (size_t fi = 0; fi < sizeof(formats) / sizeof(formats[0]); fi++) {
+        for (int gray = 0; gray < 2; gray++) {
+            if (gray && formats[fi] == RTV_FMT_GRAY8) {
+                continue;
+            }
+            for (size_t si = 0; si < sizeof(factors); si++) {
+                bench_format(formats[fi], gray, factors[si], quick ? 5 : 300);
+            }
+        }
+    }
+    return check_done("bench_rtv_scale");
+}
@@ -0,0 +1,587 @@
+// File: host_test/bench_rtv_viewer.c
+// ==========================================================================================
+// RTV viewer loop (user-022) over local sockets: a load test of the MJPEG stream. A
+// producer publishes JPEG-sized frames into a pool at the rate controller's frame rate,
+// with a size that follows its quality, and closes a controller window every WINDOW_MS
+// with rtv_viewer_take_load() and rtv_rate_update(), as the RTV task does. Each viewer
+// runs rtv_viewer_run() on its own thread and sends HTTP chunks into a TCP loopback
+// connection with a small send buffer and a send timeout (the server's
+// send_wait_timeout); a client thread on the other end reads as fast as it can, at a
+// link rate, or not at all. Per scenario:
+//   - every stream parses (chunked, multipart, Content-Length); frames arrive in order
+//     and intact (never overwritten while sent); a finished stream ends with the trailer
+//     and holds exactly the frames its viewer counted;
+//   - a slow client costs only its own frames: the others take (nearly) every published
+//     frame, the capture keeps the controller's rate and the pool never starves;
+//   - the slowest client is the one the controller is fed, and the rate comes down;
+//   - a client that stops reading is dropped at the send timeout and its frame released.
+//
+// Usage: bench_rtv_viewer [--quick]. --quick runs each scenario for 2 s instead of 8 s.
+// ==========================================================================================
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "check.h"
+#include "rtv_viewer.h"
+
+#define VIEWERS_MAX     4
+#define BUFFERS         (VIEWERS_MAX + 2)   // Filling + latest + one per viewer
+#define WINDOW_MS       250
+#define SEND_TIMEOUT_MS 300
+#define SOCK_BUF        (16 * 1024)
+#define STALL           UINT32_MAX          // Client rate: never reads
+
+static const rtv_rate_limits_t limits = { .fps_min = 2, .fps_max = 30, .q_min = 20, .q_max = 80 };
+
+/** JPEG size at quality q (as in test_rtv_rate). */
+static size_t jpeg_bytes(uint8_t q) {
+    return 4000u + 250u * q;
+}
+
+// === Pool over pthreads ===
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static uint32_t wake_gen;               ///< Under mutex: publishes and the session end
+static rtv_pool_t pool;
+static atomic_bool session;
+
+static void pool_lock(void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&mutex);
+}
+
+static void pool_unlock(void *ctx) {
+    (void)ctx;
+    pthread_mutex_unlock(&mutex);
+}
+
+static uint64_t pool_now(void *ctx) {
+    (void)ctx;
+    return bench_now_us();
+}
+
+static void wake_all(void) {
+    pthread_mutex_lock(&mutex);
+    wake_gen++;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&mutex);
+}
+
+static void pool_published(void *ctx, const rtv_frame_t *f) {
+    (void)ctx; (void)f;
+    wake_all();
+}
+
+static const rtv_pool_ops_t pool_ops = {
+    .lock = pool_lock, .unlock = pool_unlock, .now_us = pool_now, .published = pool_published,
+};
+
+static void sleep_us(uint64_t us) {
+    nanosleep(&(struct timespec){ .tv_sec = (time_t)(us / 1000000),
+                                  .tv_nsec = (long)(us % 1000000) * 1000 }, NULL);
+}
+
+// === Viewers ===
+
+typedef struct {
+    uint32_t rate;              ///< Client reads at this many bytes/s (0: at once, STALL: never)
+    int      slot;
+    int      fd;                ///< Server end
+    int      cfd;               ///< Client end
+    pthread_t server_th;
+    pthread_t client_th;
+    atomic_bool done;           ///< rtv_viewer_run() returned
+    bool     ok;                ///< ...and what it returned
+    uint32_t done_ms;           ///< When, from the scenario start
+    uint32_t frames;            ///< Sent in full
+    uint32_t skipped;
+    uint64_t send_us;
+    uint32_t worst;             ///< Windows the controller was fed this viewer
+    uint8_t *rx;                ///< Everything the client read
+    size_t   rx_len;
+    size_t   rx_cap;
+} viewer_t;
+
+static pthread_mutex_t load_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rtv_viewer_load_t loads[VIEWERS_MAX];    // Under load_mutex
+static uint64_t start_us;
+
+static bool viewer_session_open(void *ctx) {
+    (void)ctx;
+    return atomic_load(&session);
+}
+
+static rtv_frame_t *viewer_acquire(void *ctx, uint32_t after_seq, uint32_t wait_ms) {
+    struct timespec until;
+    (void)ctx;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += wait_ms / 1000;
+    until.tv_nsec += (long)(wait_ms % 1000) * 1000000;
+    if (until.tv_nsec >= 1000000000) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000;
+    }
+    for (;;) {
+        pthread_mutex_lock(&mutex);
+        uint32_t gen = wake_gen;
+        pthread_mutex_unlock(&mutex);
+        rtv_frame_t *f = rtv_pool_acquire(&pool, after_seq);
+        if (f || !atomic_load(&session)) {
+            return f;
+        }
+        int r = 0;
+        pthread_mutex_lock(&mutex);
+        while (wake_gen == gen && r != ETIMEDOUT) {
+            r = pthread_cond_timedwait(&wake, &mutex, &until);
+        }
+        pthread_mutex_unlock(&mutex);
+        if (r == ETIMEDOUT) {
+            return NULL;
+        }
+    }
+}
+
+static void viewer_release(void *ctx, rtv_frame_t *f) {
+    (void)ctx;
+    rtv_pool_release(&pool, f);
+}
+
+static bool send_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+
+    while (len) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;                       // EAGAIN: SO_SNDTIMEO without progress
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/** One HTTP chunk, as httpd_resp_send_chunk() frames it. */
+static bool viewer_send(void *ctx, const void *data, size_t len) {
+    viewer_t *v = ctx;
+    char head[16];
+
+    if (!data) {
+        return send_all(v->fd, "0\r\n\r\n", 5);
+    }
+    int n = snprintf(head, sizeof(head), "%zx\r\n", len);
+    return send_all(v->fd, head, (size_t)n) && send_all(v->fd, data, len) &&
+           send_all(v->fd, "\r\n", 2);
+}
+
+static uint64_t viewer_now(void *ctx) {
+    (void)ctx;
+    return bench_now_us();
+}
+
+static void viewer_sent(void *ctx, bool ok, size_t bytes, uint32_t skipped, uint64_t send_us) {
+    viewer_t *v = ctx;
+    (void)bytes;
+
+    pthread_mutex_lock(&load_mutex);
+    rtv_viewer_load_add(&loads[v->slot], skipped, send_us);
+    pthread_mutex_unlock(&load_mutex);
+    v->frames += ok;
+    v->skipped += skipped;
+    v->send_us += send_us;
+}
+
+static void *server(void *arg) {
+    viewer_t *v = arg;
+    const rtv_viewer_io_t io = {
+        .ctx = v, .session_open = viewer_session_open, .acquire = viewer_acquire,
+        .release = viewer_release, .send = viewer_send, .now_us = viewer_now, .sent = viewer_sent,
+    };
+
+    v->ok = rtv_viewer_run(&io);
+    v->done_ms = (uint32_t)((bench_now_us() - start_us) / 1000);
+    pthread_mutex_lock(&load_mutex);
+    loads[v->slot].used = false;
+    pthread_mutex_unlock(&load_mutex);
+    shutdown(v->fd, SHUT_WR);
+    close(v->fd);
+    atomic_store(&v->done, true);
+    return NULL;
+}
+
+static void *client(void *arg) {
+    viewer_t *v = arg;
+    uint64_t t0 = bench_now_us(), got = 0;
+
+    while (v->rate == STALL && !atomic_load(&v->done)) {
+        sleep_us(10000);                        // Not reading; drain once the server gave up
+    }
+    for (;;) {
+        if (v->rx_cap - v->rx_len < 4096) {
+            v->rx_cap = v->rx_cap ? v->rx_cap * 2 : 1 << 20;
+            v->rx = realloc(v->rx, v->rx_cap);
+        }
+        ssize_t n = recv(v->cfd, v->rx + v->rx_len, 4096, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        v->rx_len += (size_t)n;
+        got += (uint64_t)n;
+        if (v->rate && v->rate != STALL) {
+            uint64_t due = t0 + got * 1000000u / v->rate, now = bench_now_us();
+            if (due > now) {
+                sleep_us(due - now);
+            }
+        }
+    }
+    close(v->cfd);
+    return NULL;
+}
+
+/** A connected loopback pair with small buffers and the server's send timeout. */
+static void connect_pair(int listener, viewer_t *v) {
+    struct sockaddr_in a;
+    socklen_t alen = sizeof(a);
+    int sz = SOCK_BUF;
+    struct timeval tv = { .tv_sec = 0, .tv_usec = SEND_TIMEOUT_MS * 1000 };
+
+    getsockname(listener, (struct sockaddr *)&a, &alen);
+    v->cfd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(v->cfd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+    CHECK(connect(v->cfd, (struct sockaddr *)&a, alen) == 0);
+    v->fd = accept(listener, NULL, NULL);
+    CHECK(v->fd >= 0);
+    setsockopt(v->fd, SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+    setsockopt(v->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+// === What the clients got ===
+
+typedef struct {
+    uint32_t frames;
+    uint32_t bad;               ///< Framing errors, torn or out-of-order frames
+    bool     chunks_ended;      ///< Terminating chunk seen
+    bool     trailer;           ///< Closing boundary seen, nothing after it
+} parsed_t;
+
+/** Frames carry their number and a pattern derived from it between SOI and EOI. */
+static void fill_frame(rtv_frame_t *f, uint32_t id, size_t len) {
+    f->len = len;
+    f->format = RTV_FMT_JPEG;
+    f->data[0] = 0xFF;
+    f->data[1] = 0xD8;
+    memcpy(f->data + 2, &id, 4);
+    for (size_t i = 6; i < len - 2; i++) {
+        f->data[i] = (uint8_t)(id * 131u + i);
+    }
+    f->data[len - 2] = 0xFF;
+    f->data[len - 1] = 0xD9;
+}
+
+static bool frame_intact(const uint8_t *p, size_t len, uint32_t *last_id) {
+    uint32_t id;
+
+    if (len < 8 || p[0] != 0xFF || p[1] != 0xD8 || p[len - 2] != 0xFF || p[len - 1] != 0xD9) {
+        return false;
+    }
+    memcpy(&id, p + 2, 4);
+    for (size_t i = 6; i < len - 2; i++) {
+        if (p[i] != (uint8_t)(id * 131u + i)) {
+            return false;
+        }
+    }
+    if (id <= *last_id) {
+        return false;
+    }
+    *last_id = id;
+    return true;
+}
+
+/** Undo the chunked encoding in place; returns the body length. A cut-off tail is dropped. */
+static size_t dechunk(uint8_t *rx, size_t len, parsed_t *r) {
+    size_t i = 0, o = 0;
+
+    while (i < len) {
+        size_t n = 0, h = i;
+        while (h < len && rx[h] && strchr("0123456789abcdef", rx[h])) {
+            n = n * 16 + (size_t)(rx[h] <= '9' ? rx[h] - '0' : rx[h] - 'a' + 10);
+            h++;
+        }
+        if (h + 2 > len) {
+            break;                              // Cut off in the size line
+        }
+        if (h == i || rx[h] != '\r' || rx[h + 1] != '\n') {
+            r->bad++;
+            break;
+        }
+        h += 2;
+        if (n == 0) {
+            r->chunks_ended = h + 2 == len && rx[h] == '\r' && rx[h + 1] == '\n';
+            r->bad += !r->chunks_ended;
+            break;
+        }
+        if (h + n + 2 > len) {
+            break;                              // Cut off in the data
+        }
+        if (rx[h + n] != '\r' || rx[h + n + 1] != '\n') {
+            r->bad++;
+            break;
+        }
+        memmove(rx + o, rx + h, n);
+        o += n;
+        i = h + n + 2;
+    }
+    return o;
+}
+
+static parsed_t parse(viewer_t *v) {
+    static const char head[] = "\r\n--" RTV_VIEWER_BOUNDARY "\r\nContent-Type: image/jpeg\r\n"
+                               "Content-Length: ";
+    static const char trailer[] = "\r\n--" RTV_VIEWER_BOUNDARY "--\r\n";
+    parsed_t r = { 0 };
+    size_t len = dechunk(v->rx, v->rx_len, &r), i = 0;
+    uint32_t last_id = 0;
+    const uint8_t *p = v->rx;
+
+    while (i < len) {
+        size_t left = len - i;
+        if (left == sizeof(trailer) - 1 && memcmp(p + i, trailer, left) == 0) {
+            r.trailer = true;
+            break;
+        }
+        if (left < sizeof(head) - 1) {
+            r.bad += memcmp(p + i, head, left) != 0;
+            break;                              // Cut off in a part header
+        }
+        if (memcmp(p + i, head, sizeof(head) - 1) != 0) {
+            r.bad++;
+            break;
+        }
+        size_t h = i + sizeof(head) - 1, n = 0;
+        while (h < len && p[h] >= '0' && p[h] <= '9') {
+            n = n * 10 + (size_t)(p[h++] - '0');
+        }
+        if (h + 4 > len) {
+            break;
+        }
+        if (memcmp(p + h, "\r\n\r\n", 4) != 0) {
+            r.bad++;
+            break;
+        }
+        h += 4;
+        if (h + n > len) {
+            break;                              // Cut off in the JPEG
+        }
+        if (frame_intact(p + h, n, &last_id)) {
+            r.frames++;
+        } else {
+            r.bad++;
+        }
+        i = h + n;
+    }
+    return r;
+}
+
+// === Scenarios ===
+
+typedef struct {
+    const char *name;
+    uint32_t rate[VIEWERS_MAX];     ///< Client read rates
+    uint8_t  viewers;
+    int      slow;                  ///< Viewer the controller should be fed, -1: none
+    bool     hold;                  ///< The rate must stay at the maximum
+} scenario_t;
+
+static const char *rate_str(uint32_t rate, char *buf, size_t size) {
+    if (rate == 0) {
+        return "fast";
+    }
+    if (rate == STALL) {
+        return "stalled";
+    }
+    snprintf(buf, size, "%u KB/s", (unsigned)(rate / 1000));
+    return buf;
+}
+
+static void run(const scenario_t *sc, unsigned ms) {
+    size_t cap = jpeg_bytes(100);
+    uint8_t *bufs[BUFFERS];
+    viewer_t views[VIEWERS_MAX];
+    rtv_pool_stats_t st;
+    rtv_rate_t rate;
+    uint32_t published = 0, starved = 0, windows = 0;
+    double target = 0;
+
+    memset(views, 0, sizeof(views));
+    memset(loads, 0, sizeof(loads));
+    for (int i = 0; i < BUFFERS; i++) {
+        bufs[i] = malloc(cap);
+    }
+    CHECK(rtv_pool_init(&pool, &pool_ops, bufs, BUFFERS, cap));
+    rtv_rate_init(&rate, &limits);
+    atomic_store(&session, true);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    CHECK(bind(listener, (struct sockaddr *)&a, sizeof(a)) == 0 && listen(listener, VIEWERS_MAX) == 0);
+    start_us = bench_now_us();
+    for (uint8_t i = 0; i < sc->viewers; i++) {
+        viewer_t *v = &views[i];
+        v->rate = sc->rate[i];
+        v->slot = i;
+        loads[i].used = true;
+        connect_pair(listener, v);
+        pthread_create(&v->server_th, NULL, server, v);
+        pthread_create(&v->client_th, NULL, client, v);
+    }
+    close(listener);
+
+    // The capture side: paced to the controller's rate, one window every WINDOW_MS
+    uint64_t now = bench_now_us(), next = now, window_start = now;
+    uint32_t mark_published = 0, mark_starved = 0, id = 0;
+    while ((now = bench_now_us()) - start_us < ms * 1000ull) {
+        rtv_frame_t *f = rtv_pool_get_free(&pool);
+        if (f) {
+            fill_frame(f, ++id, jpeg_bytes(rate.quality));
+            rtv_pool_publish(&pool, f, now);
+            published++;
+        } else {
+            starved++;
+        }
+        if (now - window_start >= WINDOW_MS * 1000u) {
+            rtv_rate_sample_t s = {
+                .window_us = (uint32_t)(now - window_start),
+                .published = published - mark_published,
+                .dropped = starved - mark_starved,
+            };
+            target += s.window_us / 1e6 * rate.fps;
+            pthread_mutex_lock(&load_mutex);
+            int worst = rtv_viewer_take_load(loads, VIEWERS_MAX, &s);
+            pthread_mutex_unlock(&load_mutex);
+            if (worst >= 0) {
+                views[worst].worst++;
+            }
+            rtv_rate_update(&rate, &s);
+            windows++;
+            window_start = now;
+            mark_published = published;
+            mark_starved = starved;
+        }
+        next += 1000000u / rate.fps;
+        now = bench_now_us();
+        if (next > now) {
+            sleep_us(next - now);
+        } else {
+            next = now;
+        }
+    }
+    double secs = (double)(bench_now_us() - start_us) / 1e6;
+    atomic_store(&session, false);
+    wake_all();
+    for (uint8_t i = 0; i < sc->viewers; i++) {
+        pthread_join(views[i].server_th, NULL);
+        pthread_join(views[i].client_th, NULL);
+    }
+    rtv_pool_get_stats(&pool, &st, false);
+
+    printf("  %-22s | published %5.1f fps, ends at %2u fps q%2u after %2u downs %2u ups | "
+           "age avg %5.1f ms max %5.1f ms, busy max %u\n", sc->name, published / secs,
+           (unsigned)rate.fps, (unsigned)rate.quality, (unsigned)rate.downs, (unsigned)rate.ups,
+           st.age_count ? (double)st.age_total_us / 1e3 / st.age_count : 0.0,
+           st.age_max_us / 1e3, (unsigned)st.busy_max);
+    for (uint8_t i = 0; i < sc->viewers; i++) {
+        viewer_t *v = &views[i];
+        parsed_t r = parse(v);
+        char buf[16];
+        uint32_t seen = v->frames + v->skipped;
+        printf("    viewer %u %-8s %5.1f fps, skipped %3u%%, sending %3u%% | %s at %5u ms, "
+               "%4u frames parsed, fed to the controller %2u/%u windows\n", (unsigned)i,
+               rate_str(v->rate, buf, sizeof(buf)), v->frames / secs,
+               seen ? (unsigned)(v->skipped * 100u / seen) : 0u,
+               (unsigned)(v->send_us * 100 / (uint64_t)(secs * 1e6)), v->ok ? "ended" : "dropped",
+               (unsigned)v->done_ms, (unsigned)r.frames, (unsigned)v->worst, (unsigned)windows);
+
+        CHECK_EQ(r.bad, 0);
+        if (v->rate == STALL) {
+            CHECK(!v->ok);                      // Dropped at the send timeout...
+            CHECK(v->done_ms < 2000);           // ...once the buffers fill and stop trickling
+            CHECK(r.frames <= v->frames + 1);
+        } else {
+            CHECK(v->ok);
+            CHECK(r.chunks_ended && r.trailer);
+            CHECK_EQ(r.frames, v->frames);
+        }
+        if (v->rate == 0) {
+            CHECK(v->frames >= published * 0.8);    // Not held up by the slow ones
+        }
+        free(v->rx);
+    }
+    if (sc->slow >= 0) {
+        CHECK(views[sc->slow].worst * 10 >= windows * 6);
+        CHECK(rate.downs > 0);
+        CHECK(rate.fps < limits.fps_max || rate.quality < limits.q_max);
+    }
+    if (sc->hold) {
+        CHECK_EQ(rate.downs, 0);
+    }
+    CHECK_EQ(starved, 0);
+    CHECK(published >= target * 0.8);           // The capture kept the controller's rate
+    CHECK(st.busy_max <= BUFFERS);
+    CHECK_EQ(rtv_pool_held(&pool), 0);
+    CHECK(st.age_max_us < 2000000u);            // Held no longer than a stalled send
+    for (int i = 0; i < BUFFERS; i++) {
+        free(bufs[i]);
+    }
+}
+
+static void test_take_load(void) {
+    rtv_viewer_load_t l[3] = { { .used = true }, { .used = false }, { .used = true } };
+    rtv_rate_sample_t s;
+
+    rtv_viewer_load_add(&l[0], 0, 1000);
+    rtv_viewer_load_add(&l[0], 2, 1000);
+    rtv_viewer_load_add(&l[1], 9, 90000);       // Slot free: not counted
+    rtv_viewer_load_add(&l[2], 1, 5000);
+    CHECK_EQ(rtv_viewer_take_load(l, 3, &s), 2);
+    CHECK_EQ(s.viewers, 2);
+    CHECK_EQ(s.sent, 1);
+    CHECK_EQ(s.skipped, 1);
+    CHECK_EQ(s.send_us, 5000);
+    CHECK_EQ(l[0].sent + l[0].skipped + l[2].sent, 0);     // New window
+    CHECK_EQ(rtv_viewer_take_load(l, 3, &s), 0);            // Equal: the first
+    CHECK_EQ(s.sent, 0);
+    l[0].used = l[2].used = false;
+    CHECK_EQ(rtv_viewer_take_load(l, 3, &s), -1);
+    CHECK_EQ(s.viewers, 0);
+}
+
+int main(int argc, char **argv) {
+    unsigned ms = bench_quick(argc, argv) ? 2000 : 8000;
+    static const scenario_t scenarios[] = {
+        { "two fast",              { 0, 0 },                        2, -1, true },
+        { "fast + 200 KB/s link",  { 0, 200000 },                   2, 1,  false },
+        { "fast + stalled",        { 0, STALL },                    2, -1, false },
+        { "four, two links",       { 0, 600000, 150000, 0 },        4, 2,  false },
+    };
+
+    test_take_load();
+    printf("rtv viewers over loopback TCP, %u KB socket buffers, %u ms send timeout, "
+           "%u ms windows:\n", SOCK_BUF / 1024, SEND_TIMEOUT_MS, WINDOW_MS);
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        run(&scenarios[i], ms);
+    }
+    return check_done("bench_rtv_viewer");
+}
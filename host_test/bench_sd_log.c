@@ -0,0 +1,289 @@
+// File: host_test/bench_sd_log.c
+// ==========================================================================================
+// The SD log writer's data path on the host (user-014): log_sink (ring + packer) and
+// log_store (segments, catalog) writing to a directory, the packer and writer task bodies
+// run by hand as in sd_log.c. The card mount and the FreeRTOS glue are all that is left out.
+//   1. One thread, raw and LZ: lines/s and bytes/s through ring, packer and store, block
+//      write time; everything is read back with log_query in order.
+//   2. Loss policy: PRODUCERS threads log without waiting against a writer slowed to
+//      SLOW_CARD_US per block. Lines kept + lines dropped = lines logged, the "[log] N
+//      lines dropped" markers add up to the drop count and each producer's lines stay in
+//      order.
+//   3. Every file and directory name is 8.3 (FATFS runs without LFN).
+//
+// Usage: bench_sd_log [--quick] [dir]. dir defaults to ./sd_log_host and is emptied first;
+// point it at a mounted FAT image (mkfs.fat -C fat.img 65536; mount -o loop fat.img dir)
+// to run the same checks on FAT.
+// ==========================================================================================
+
+#define _XOPEN_SOURCE 700
+#include <ctype.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "check.h"
+#include "log_sink.h"
+#include "log_store.h"
+#include "log_query.h"
+
+#define PRODUCERS       3
+#define PUMP_EVERY      32          // Lines per packer wakeup (half the ring)
+#define SLOW_CARD_US    400         // Block write time of the slow-card run
+#define SEGMENT_KB      256
+
+static log_sink_t sink;
+static log_store_t store;
+static const char *root = "sd_log_host";
+
+static struct {
+    uint32_t blocks;
+    uint32_t errors;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t delay_us;              ///< Simulated card time per full block
+} io;
+
+// === Packer and writer task bodies ===
+
+static void write_req(const log_sink_req_t *req) {
+    uint64_t t0 = bench_now_us();
+    if (!log_store_write(&store, req)) {
+        io.errors++;
+    }
+    if (io.delay_us && !req->partial) {
+        nanosleep(&(struct timespec){ .tv_nsec = io.delay_us * 1000L }, NULL);
+    }
+    uint32_t us = (uint32_t)(bench_now_us() - t0);
+    io.blocks += !req->partial;
+    io.total_us += us;
+    if (us > io.max_us) {
+        io.max_us = us;
+    }
+}
+
+/** Pack until the ring is empty, writing each full block as it is handed over. */
+static void pump(void) {
+    log_sink_req_t req;
+
+    while (log_sink_pack(&sink, &req)) {
+        write_req(&req);
+        log_sink_block_done(&sink, req.buf);
+    }
+}
+
+/** Flush-on-idle at the end of a run. */
+static void flush(void) {
+    log_sink_req_t req;
+
+    pump();
+    if (log_sink_flush_partial(&sink, &req)) {
+        write_req(&req);
+    }
+}
+
+static bool store_start(bool compress) {
+    memset(&io, 0, sizeof(io));
+    log_sink_init(&sink, 0);
+    return log_store_open(&store, root, SEGMENT_KB, compress);
+}
+
+static int format_line(char *buf, size_t cap, unsigned producer, unsigned n) {
+    return snprintf(buf, cap, "I (%u) BENCH: p%u #%07u sd log writer host benchmark line\n",
+                    n / 8, producer, n);
+}
+
+// === Read-back ===
+
+typedef struct {
+    uint32_t lines;             ///< Benchmark lines found
+    uint32_t markers;           ///< Drop count announced by the markers
+    uint32_t next[PRODUCERS];   ///< Next sequence number expected per producer
+    uint32_t out_of_order;
+    bool     gaps_ok;           ///< Dropped lines leave gaps
+} readback_t;
+
+static bool readback_line(const char *line, size_t len, const log_line_meta_t *meta,
+                          uint32_t boot, void *ctx) {
+    readback_t *r = ctx;
+    unsigned p, n, dropped;
+    char text[LOG_SINK_LINE_MAX + 1];
+
+    (void)meta; (void)boot;
+    if (len == 0) {
+        return true;                            // Padding at the end of a block
+    }
+    snprintf(text, sizeof(text), "%.*s", (int)len, line);
+    if (sscanf(text, "[log] %u lines dropped", &dropped) == 1) {
+        r->markers += dropped;
+    } else if (sscanf(text, "I (%*u) BENCH: p%u #%u", &p, &n) == 2 && p < PRODUCERS) {
+        if (r->gaps_ok ? n < r->next[p] : n != r->next[p]) {
+            r->out_of_order++;
+        }
+        r->next[p] = n + 1;
+        r->lines++;
+    }
+    return true;
+}
+
+static readback_t read_back(bool gaps_ok) {
+    log_query_t q;
+    log_query_stats_t qs;
+    readback_t r = { .gaps_ok = gaps_ok };
+
+    log_query_init(&q);
+    q.boot = log_store_boot(&store);
+    q.use_index = false;                        // Every block, the reference path
+    CHECK_EQ(log_query_run(root, &q, readback_line, &r, &qs), 0);
+    return r;
+}
+
+// === 1. Throughput, one thread ===
+
+static void bench_pipeline(bool compress, unsigned lines) {
+    char line[LOG_SINK_LINE_MAX + 1];
+    uint64_t text = 0;
+    unsigned refused = 0;
+
+    CHECK(store_start(compress));
+    uint64_t t0 = bench_now_us();
+    for (unsigned i = 0; i < lines; i++) {
+        int n = format_line(line, sizeof(line), 0, i);
+        text += (unsigned)n;
+        refused += !log_sink_write(&sink, line, (size_t)n);     // Never: pumped in time
+        if (i % PUMP_EVERY == PUMP_EVERY - 1) {
+            pump();
+        }
+    }
+    flush();
+    uint64_t us = bench_now_us() - t0;
+    log_store_close(&store);
+
+    readback_t r = read_back(false);
+    CHECK_EQ(refused, 0);
+    CHECK_EQ(r.lines, lines);
+    CHECK_EQ(r.out_of_order, 0);
+    CHECK_EQ(log_sink_dropped(&sink), 0);
+    CHECK_EQ(io.errors, 0);
+    CHECK_EQ(store.stats.errors, 0);
+
+    printf("  %-4s %9.0f lines/s %7.1f MB/s text  %5.1f MB stored  %4u segments  "
+           "block write avg %5.1f us, max %6u us\n",
+           compress ? "LZ" : "raw", lines * 1e6 / (double)us, text / (double)us,
+           (double)store.stats.stored_bytes / 1e6, (unsigned)store.stats.segments,
+           io.blocks ? (double)io.total_us / io.blocks : 0.0, (unsigned)io.max_us);
+}
+
+// === 2. Loss policy: producers never wait for a slow card ===
+
+static atomic_bool go;
+static atomic_uint producers_done;
+static unsigned lines_each;
+
+static void *producer(void *arg) {
+    unsigned p = (unsigned)(uintptr_t)arg;
+    char line[LOG_SINK_LINE_MAX + 1];
+
+    while (!atomic_load(&go)) {
+        sched_yield();
+    }
+    for (unsigned i = 0; i < lines_each; i++) {
+        int n = format_line(line, sizeof(line), p, i);
+        log_sink_write(&sink, line, (size_t)n);  // Dropped and counted if the ring is full
+        if (i % 8 == 7) {
+            sched_yield();
+        }
+    }
+    atomic_fetch_add(&producers_done, 1);
+    return NULL;
+}
+
+static void test_loss(unsigned lines) {
+    pthread_t th[PRODUCERS];
+
+    CHECK(store_start(false));
+    io.delay_us = SLOW_CARD_US;
+    lines_each = lines;
+    atomic_store(&go, false);
+    atomic_store(&producers_done, 0);
+    for (unsigned p = 0; p < PRODUCERS; p++) {
+        pthread_create(&th[p], NULL, producer, (void *)(uintptr_t)p);
+    }
+    atomic_store(&go, true);
+    while (atomic_load(&producers_done) < PRODUCERS) {
+        pump();
+        sched_yield();
+    }
+    for (unsigned p = 0; p < PRODUCERS; p++) {
+        pthread_join(th[p], NULL);
+    }
+    flush();
+    log_store_close(&store);
+
+    uint32_t sent = PRODUCERS * lines, dropped = log_sink_dropped(&sink);
+    readback_t r = read_back(true);
+
+    CHECK(dropped > 0);                         // The slow card did cost lines...
+    CHECK_EQ(r.lines + dropped, sent);          // ...every one of them counted
+    CHECK_EQ(r.markers, dropped);               // and announced in the log itself
+    CHECK_EQ(r.out_of_order, 0);
+    printf("  slow card (%u us/block): %u lines logged by %u producers, %u kept, %u dropped "
+           "(%.1f %%), all announced\n", SLOW_CARD_US, (unsigned)sent, PRODUCERS,
+           (unsigned)r.lines, (unsigned)dropped, 100.0 * dropped / sent);
+}
+
+// === 3. 8.3 names ===
+
+static unsigned long_names;
+
+static bool is_83(const char *name) {
+    const char *dot = strchr(name, '.');
+    size_t base = dot ? (size_t)(dot - name) : strlen(name);
+    size_t ext = dot ? strlen(dot + 1) : 0;
+
+    if (base == 0 || base > 8 || ext > 3 || (dot && strchr(dot + 1, '.'))) {
+        return false;
+    }
+    for (const char *c = name; *c; c++) {
+        if (*c != '.' && !isupper((unsigned char)*c) && !isdigit((unsigned char)*c) && *c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int check_name(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    (void)sb; (void)flag;
+    if (ftw->level > 0 && !is_83(path + ftw->base)) {
+        printf("  not an 8.3 name: %s\n", path);
+        long_names++;
+    }
+    return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    (void)sb; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") != 0) {
+            root = argv[i];
+        }
+    }
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+    printf("sd_log data path into %s (%u KB segments, %u-line ring, pack every %u lines):\n",
+           root, SEGMENT_KB, LOG_SINK_RING_CELLS, PUMP_EVERY);
+    bench_pipeline(false, quick ? 20000 : 2000000);
+    bench_pipeline(true, quick ? 20000 : 2000000);
+    test_loss(quick ? 4000 : 40000);
+
+    nftw(root, check_name, 16, FTW_PHYS);
+    CHECK_EQ(long_names, 0);
+    return check_done("bench_sd_log");
+}
@@ -0,0 +1,478 @@
+// File: host_test/bench_uart_input.c
+// ==========================================================================================
+// The UART input demultiplexer (user-012): uart_input.c itself, fed through the driver stub.
+//   1. Checks: lines and frames interleaved, a SYNC byte inside a line (text, not a frame
+//      start), bad CRC, overlong lines, a full ring, and random streams of lines and frames
+//      split at random points that must come out whole and in order.
+//   2. Wakeups and latency on a virtual clock: one recorded session (typing, a pasted
+//      script, binary frames from a host tool, idle stretches) delivered the way the
+//      event-driven task gets it (newline pattern, FIFO threshold, RX timeout) and the way
+//      the old CLI reader did (uart_read_bytes of 64 bytes with a 20 ms timeout, in a
+//      loop). Both must produce the same messages; wakeups and end-of-message to handler
+//      latency are compared.
+//   3. Throughput of the demultiplexer itself: MB/s for text and for frames.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "uart_input.c"
+
+#define BYTE_US         87          // 10 bits at 115200 baud
+#define FIFO_FULL       120         // Driver default rxfifo_full_thresh
+#define RX_TOUT_US      (10 * BYTE_US)      // Driver default RX timeout: 10 symbols idle
+#define POLL_BYTES      64          // The old reader's uart_read_bytes() length...
+#define POLL_US         20000       // ...and timeout
+#define MSG_MAX         1024
+#define TRACE_MAX       65536
+
+static uint32_t rs = 4242;
+
+static uint32_t rnd(void) {
+    rs = rs * 1103515245u + 12345u;
+    return rs >> 8;
+}
+
+// === Helpers ===
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  len;
+    uint8_t  op;
+    uint8_t  data[UART_INPUT_LINE_MAX];
+    uint32_t done_us;               ///< When its last byte arrived (latency runs)
+} expect_t;
+
+static void input_reset(void) {
+    atomic_store(&head, 0);
+    atomic_store(&tail, 0);
+    line_len = 0;
+    line_overflow = false;
+    line_dropped = false;
+    cli_frame_decoder_reset(&frame_dec);
+    uart_input_stats_t st;
+    uart_input_take_stats(&st);
+}
+
+static void feed_str(const char *s) {
+    uart_input_feed((const uint8_t *)s, strlen(s), 0);
+}
+
+static void feed_frame(uint8_t op, const uint8_t *payload, size_t len) {
+    uint8_t wire[CLI_FRAME_MAX_PAYLOAD + CLI_FRAME_OVERHEAD];
+    uart_input_feed(wire, cli_frame_encode(op, payload, len, wire), 0);
+}
+
+/** Does `m` carry exactly the message `e` describes? */
+static bool same(const uart_input_msg_t *m, const expect_t *e) {
+    if (m->type != e->type) {
+        return false;
+    }
+    if (m->type == UART_INPUT_LINE) {
+        return strlen(m->line) == e->len && memcmp(m->line, e->data, e->len) == 0;
+    }
+    return m->frame.op == e->op && m->frame.len == e->len &&
+           memcmp(m->frame.payload, e->data, e->len) == 0;
+}
+
+// === 1. Checks ===
+
+static void test_basic(void) {
+    uart_input_msg_t m;
+    uart_input_stats_t st;
+    static const uint8_t ping[] = { 1, 2, 3 };
+
+    input_reset();
+    feed_str("led on\r\n");
+    feed_frame(CLI_OP_PING, ping, sizeof(ping));
+    feed_str("status\n\n\r\n");             // Empty lines are not messages
+    CHECK(uart_input_get(&m, 0) && m.type == UART_INPUT_LINE && strcmp(m.line, "led on") == 0);
+    CHECK(uart_input_get(&m, 0) && m.type == UART_INPUT_FRAME && m.frame.op == CLI_OP_PING &&
+          m.frame.len == 3 && memcmp(m.frame.payload, ping, 3) == 0);
+    CHECK(uart_input_get(&m, 0) && m.type == UART_INPUT_LINE && strcmp(m.line, "status") == 0);
+    CHECK(!uart_input_get(&m, 0));
+
+    // Bad CRC: counted, nothing published, the next line is fine
+    uint8_t wire[16];
+    size_t n = cli_frame_encode(CLI_OP_PING, ping, sizeof(ping), wire);
+    wire[n - 1] ^= 0xFF;
+    uart_input_feed(wire, n, 0);
+    feed_str("help\n");
+    CHECK(uart_input_get(&m, 0) && strcmp(m.line, "help") == 0);
+    uart_input_take_stats(&st);
+    CHECK_EQ(st.frame_errors, 1);
+    CHECK_EQ(st.lines, 3);
+    CHECK_EQ(st.frames, 1);
+}
+
+static void test_sync_in_line(void) {
+    uart_input_msg_t m;
+    uart_input_stats_t st;
+    uint8_t wire[16];
+    static const uint8_t payload[] = { 0x01, 0x07 };
+    size_t n = cli_frame_encode(CLI_OP_LED_PATTERN, payload, sizeof(payload), wire);
+
+    // A whole valid frame inside a line: all of it is text of that line
+    CHECK(!memchr(wire, '\0', n) && !memchr(wire, '\n', n) && !memchr(wire, '\r', n));
+    input_reset();
+    feed_str("led x");
+    uart_input_feed(wire, n, 0);
+    feed_str(" tail\n");
+    CHECK(uart_input_get(&m, 0));
+    CHECK_EQ(m.type, UART_INPUT_LINE);
+    CHECK_EQ(strlen(m.line), 5 + n + 5);
+    CHECK(memcmp(m.line, "led x", 5) == 0 && memcmp(m.line + 5, wire, n) == 0 &&
+          strcmp(m.line + 5 + n, " tail") == 0);
+    CHECK(!uart_input_get(&m, 0));
+
+    // A SYNC byte at the end of a line, then a real frame right after the newline
+    feed_str("ab\xA5\n");
+    uart_input_feed(wire, n, 0);
+    CHECK(uart_input_get(&m, 0) && m.type == UART_INPUT_LINE && strcmp(m.line, "ab\xA5") == 0);
+    CHECK(uart_input_get(&m, 0) && m.type == UART_INPUT_FRAME &&
+          m.frame.op == CLI_OP_LED_PATTERN && m.frame.payload[1] == 0x07);
+    uart_input_take_stats(&st);
+    CHECK_EQ(st.frames, 1);
+    CHECK_EQ(st.frame_errors, 0);
+
+    // After an overlong line, the next frame still starts at the newline
+    char big[UART_INPUT_LINE_MAX + 40];
+    memset(big, 'x', sizeof(big) - 2);
+    big[sizeof(big) - 2] = '\xA5';
+    big[sizeof(big) - 1] = '\0';
+    feed_str(big);
+    feed_str("\n");
+    uart_input_feed(wire, n, 0);
+    CHECK(uart_input_get(&m, 0) && m.type == UART_INPUT_FRAME);
+    CHECK(!uart_input_get(&m, 0));
+    uart_input_take_stats(&st);
+    CHECK_EQ(st.overflows, 1);
+}
+
+static void test_ring_full(void) {
+    uart_input_msg_t m;
+    uart_input_stats_t st;
+    char line[16];
+
+    input_reset();
+    for (int i = 0; i < UART_INPUT_RING_SIZE + 2; i++) {
+        snprintf(line, sizeof(line), "cmd %d\n", i);
+        feed_str(line);
+    }
+    static const uint8_t one = 1;
+    feed_frame(CLI_OP_LED_OFF, &one, 1);    // Dropped as well
+    for (int i = 0; i < UART_INPUT_RING_SIZE; i++) {
+        snprintf(line, sizeof(line), "cmd %d", i);
+        CHECK(uart_input_get(&m, 0) && strcmp(m.line, line) == 0);
+    }
+    CHECK(!uart_input_get(&m, 0));
+    uart_input_take_stats(&st);
+    CHECK_EQ(st.lines, UART_INPUT_RING_SIZE);
+    CHECK_EQ(st.dropped, 3);
+
+    // A line that started while the ring was full is dropped whole, not published half
+    for (int i = 0; i < UART_INPUT_RING_SIZE; i++) {
+        feed_str("fill\n");
+    }
+    feed_str("half");
+    CHECK(uart_input_get(&m, 0));           // Room again, mid-line
+    feed_str("-line\nnext\n");
+    for (int i = 1; i < UART_INPUT_RING_SIZE; i++) {
+        CHECK(uart_input_get(&m, 0) && strcmp(m.line, "fill") == 0);
+    }
+    CHECK(uart_input_get(&m, 0) && strcmp(m.line, "next") == 0);
+    CHECK(!uart_input_get(&m, 0));
+}
+
+/** Append one random message to `wire`; describe it in `e`. */
+static size_t random_message(uint8_t *wire, expect_t *e) {
+    if (rnd() % 3 == 0) {
+        e->type = UART_INPUT_FRAME;
+        e->op = (uint8_t)(1 + rnd() % 0x20);
+        e->len = (uint8_t)(rnd() % (CLI_FRAME_MAX_PAYLOAD + 1));
+        for (int i = 0; i < e->len; i++) {
+            e->data[i] = (uint8_t)rnd();    // Newlines and SYNC bytes included
+        }
+        return cli_frame_encode(e->op, e->data, e->len, wire);
+    }
+    e->type = UART_INPUT_LINE;
+    e->len = (uint8_t)(8 + rnd() % (UART_INPUT_LINE_MAX - 8 + 1));
+    for (int i = 0; i < e->len; i++) {
+        e->data[i] = (uint8_t)(i > 0 && rnd() % 16 == 0 ? CLI_FRAME_SYNC : ' ' + rnd() % 95);
+    }
+    memcpy(wire, e->data, e->len);
+    size_t n = e->len;
+    if (rnd() & 1) {
+        wire[n++] = '\r';
+    }
+    wire[n++] = '\n';
+    return n;
+}
+
+static void test_random(unsigned streams) {
+    static uint8_t wire[8 * (UART_INPUT_LINE_MAX + 2)];
+    expect_t exp[8];
+    unsigned bad = 0, lost = 0;
+
+    input_reset();
+    for (unsigned s = 0; s < streams; s++) {
+        size_t len = 0;
+        int count = 1 + (int)(rnd() % UART_INPUT_RING_SIZE);
+        for (int i = 0; i < count; i++) {
+            len += random_message(wire + len, &exp[i]);
+        }
+        for (size_t pos = 0; pos < len;) {            // Random read sizes, like the driver's
+            size_t n = 1 + rnd() % UART_INPUT_CHUNK;
+            n = n < len - pos ? n : len - pos;
+            uart_input_feed(wire + pos, n, 0);
+            pos += n;
+        }
+        uart_input_msg_t m;
+        for (int i = 0; i < count; i++) {
+            if (!uart_input_get(&m, 0)) {
+                lost++;
+                break;
+            }
+            bad += !same(&m, &exp[i]);
+        }
+        lost += uart_input_get(&m, 0);      // Anything extra
+    }
+    uart_input_stats_t st;
+    uart_input_take_stats(&st);
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(lost, 0);
+    CHECK_EQ(st.frame_errors + st.overflows + st.dropped, 0);
+}
+
+// === 2. Wakeups and latency on a virtual clock ===
+
+typedef struct {
+    uint8_t  b[TRACE_MAX];
+    uint32_t t[TRACE_MAX];          ///< Arrival time of each byte
+    size_t   n;
+    uint32_t end_us;
+    expect_t msgs[MSG_MAX];
+    unsigned count;
+} trace_t;
+
+static trace_t trace;
+
+static void trace_bytes(uint32_t *now, const uint8_t *b, size_t n, uint32_t gap_us) {
+    for (size_t i = 0; i < n && trace.n < TRACE_MAX; i++) {
+        trace.b[trace.n] = b[i];
+        trace.t[trace.n++] = *now;
+        *now += i + 1 < n ? BYTE_US : 0;
+    }
+    *now += gap_us;
+}
+
+static void trace_message(uint32_t *now, const uint8_t *wire, size_t n, uint32_t gap_us,
+                          const expect_t *e) {
+    trace_bytes(now, wire, n, 0);
+    if (trace.count < MSG_MAX) {
+        trace.msgs[trace.count] = *e;
+        trace.msgs[trace.count++].done_us = *now;
+    }
+    *now += gap_us;
+}
+
+/**
+ * @brief A bench session: a person typing commands, a pasted script, a host tool's
+ *        frames, and long idle stretches in between.
+ */
+static void record_session(unsigned rounds) {
+    uint32_t now = 1000;
+    uint8_t wire[UART_INPUT_LINE_MAX + CLI_FRAME_OVERHEAD + 2];
+    static const char *const typed[] = { "status", "led blink 0 2 50", "cli_stats", "fsm" };
+
+    trace.n = 0;
+    trace.count = 0;
+    for (unsigned r = 0; r < rounds; r++) {
+        // Typing: a key every 120-250 ms, Enter sends CR LF
+        for (size_t i = 0; i < sizeof(typed) / sizeof(typed[0]); i++) {
+            expect_t e = { .type = UART_INPUT_LINE, .len = (uint8_t)strlen(typed[i]) };
+            memcpy(e.data, typed[i], e.len);
+            for (size_t k = 0; k < e.len; k++) {
+                trace_bytes(&now, e.data + k, 1, 120000 + rnd() % 130000);
+            }
+            memcpy(wire, "\r\n", 2);
+            trace_message(&now, wire, 2, 1500000, &e);
+        }
+        // A pasted script: lines back to back at line rate
+        for (int i = 0; i < 12; i++) {
+            expect_t e = { .type = UART_INPUT_LINE };
+            e.len = (uint8_t)snprintf((char *)e.data, sizeof(e.data), "led pattern %d %d",
+                                      i % 2, i % 8);
+            memcpy(wire, e.data, e.len);
+            wire[e.len] = '\n';
+            trace_message(&now, wire, e.len + 1u, 0, &e);
+        }
+        now += 3000000;
+        // A host tool: binary frames 50 ms apart, each answered before the next
+        for (int i = 0; i < 40; i++) {
+            expect_t e = { .type = UART_INPUT_FRAME, .op = CLI_OP_GET_STATE, .len = 0 };
+            if (i % 4 == 0) {
+                e.op = CLI_OP_LED_BLINK;
+                e.len = 4;
+                memcpy(e.data, (uint8_t[]){ 0, 200, 0, 50 }, 4);
+            }
+            trace_message(&now, wire, cli_frame_encode(e.op, e.data, e.len, wire), 50000, &e);
+        }
+        now += 10000000;                    // Idle console
+    }
+    trace.end_us = now;
+}
+
+typedef struct {
+    const char *name;
+    unsigned wakeups;
+    unsigned messages, mismatches;
+    uint64_t lat_total;
+    uint32_t lat_max;
+    uint32_t line_max, frame_max;
+} run_t;
+
+/** A wakeup at `now`: the bytes that arrived up to it reach the demultiplexer. */
+static void wake(run_t *r, size_t *pos, size_t upto, uint32_t now) {
+    uart_input_msg_t m;
+
+    r->wakeups++;
+    host_uart_rx_len = 0;
+    while (*pos < upto) {
+        size_t n = upto - *pos < sizeof(host_uart_rx) ? upto - *pos : sizeof(host_uart_rx);
+        memcpy(host_uart_rx, trace.b + *pos, n);
+        host_uart_rx_len = n;
+        uart_input_drain(now);
+        *pos += n;
+    }
+    while (uart_input_get(&m, 0)) {
+        if (r->messages >= trace.count) {
+            r->mismatches++;
+            continue;
+        }
+        const expect_t *e = &trace.msgs[r->messages++];
+        uint32_t lat = m.rx_us - e->done_us;
+        r->mismatches += !same(&m, e);
+        r->lat_total += lat;
+        r->lat_max = lat > r->lat_max ? lat : r->lat_max;
+        if (e->type == UART_INPUT_LINE) {
+            r->line_max = lat > r->line_max ? lat : r->line_max;
+        } else {
+            r->frame_max = lat > r->frame_max ? lat : r->frame_max;
+        }
+    }
+}
+
+/**
+ * @brief The event-driven task: the driver queues an event for a newline (pattern
+ *        detection), for FIFO_FULL bytes, or after RX_TOUT_US without a new byte.
+ */
+static void run_events(run_t *r) {
+    size_t pos = 0, i = 0;
+
+    input_reset();
+    while (i < trace.n) {
+        size_t start = i;
+        // Gather until an event fires: newline, FIFO threshold, or an idle gap
+        for (;;) {
+            uint8_t b = trace.b[i++];
+            if (b == '\n' || i - start >= FIFO_FULL || i == trace.n ||
+                trace.t[i] - trace.t[i - 1] > RX_TOUT_US) {
+                break;
+            }
+        }
+        bool pattern = trace.b[i - 1] == '\n';
+        bool full = i - start >= FIFO_FULL;
+        uint32_t at = trace.t[i - 1] + (pattern || full ? 0 : RX_TOUT_US);
+        wake(r, &pos, i, at);
+    }
+}
+
+/** The old CLI reader: uart_read_bytes(64 bytes, 20 ms) back to back. */
+static void run_polling(run_t *r) {
+    size_t pos = 0, i = 0;
+    uint32_t now = 0;
+
+    input_reset();
+    while (now < trace.end_us) {
+        uint32_t deadline = now + POLL_US;
+        size_t got = 0;
+        while (i < trace.n && trace.t[i] <= deadline && got < POLL_BYTES) {
+            i++;
+            got++;
+        }
+        now = got == POLL_BYTES ? (trace.t[i - 1] > now ? trace.t[i - 1] : now) : deadline;
+        wake(r, &pos, i, now);
+    }
+}
+
+static void print_run(const run_t *r, uint32_t span_us) {
+    printf("  %-8s %6u wakeups (%5.1f/s) | latency mean %6.2f ms, max line %6.2f ms, "
+           "max frame %6.2f ms\n", r->name, r->wakeups, r->wakeups * 1e6 / span_us,
+           r->messages ? r->lat_total / 1000.0 / r->messages : 0.0, r->line_max / 1000.0,
+           r->frame_max / 1000.0);
+}
+
+static void test_wakeups(unsigned rounds) {
+    run_t ev = { .name = "events" }, poll = { .name = "polling" };
+
+    record_session(rounds);
+    run_events(&ev);
+    run_polling(&poll);
+    CHECK_EQ(ev.messages, trace.count);
+    CHECK_EQ(poll.messages, trace.count);
+    CHECK_EQ(ev.mismatches + poll.mismatches, 0);
+    CHECK(ev.line_max == 0);                // Pattern detection: at the newline
+    CHECK(ev.frame_max <= RX_TOUT_US);      // Frames end without one: the RX timeout
+    CHECK(poll.lat_max > ev.lat_max);
+    CHECK(ev.wakeups * 4 < poll.wakeups);
+    printf("session of %.1f s, %u messages (%zu bytes):\n", trace.end_us / 1e6, trace.count,
+           trace.n);
+    print_run(&ev, trace.end_us);
+    print_run(&poll, trace.end_us);
+}
+
+// === 3. Throughput ===
+
+static void bench_feed(unsigned reps) {
+    static uint8_t text[64 * 1024], frames[64 * 1024];
+    size_t tn = 0, fn = 0;
+    uart_input_msg_t m;
+
+    while (tn + 40 < sizeof(text)) {
+        tn += (size_t)snprintf((char *)text + tn, sizeof(text) - tn, "led blink %u 2.5 50\r\n",
+                               (unsigned)(rnd() % 2));
+    }
+    while (fn + CLI_FRAME_MAX_PAYLOAD + CLI_FRAME_OVERHEAD < sizeof(frames)) {
+        uint8_t p[8] = { 0, 200, 0, 50 };
+        fn += cli_frame_encode(CLI_OP_LED_BLINK, p, 4, frames + fn);
+    }
+    for (int k = 0; k < 2; k++) {
+        const uint8_t *buf = k ? frames : text;
+        size_t len = k ? fn : tn;
+        uint64_t best = UINT64_MAX;
+        input_reset();
+        for (unsigned r = 0; r < reps; r++) {
+            uint64_t t0 = bench_now_us();
+            for (size_t pos = 0; pos < len; pos += UART_INPUT_CHUNK) {
+                uart_input_feed(buf + pos, len - pos < UART_INPUT_CHUNK ? len - pos : UART_INPUT_CHUNK, 0);
+                while (uart_input_get(&m, 0)) {
+                }
+            }
+            uint64_t us = bench_now_us() - t0;
+            best = us < best ? us : best;
+        }
+        printf("  feed %-6s %6.0f MB/s\n", k ? "frames" : "text", len / (double)(best ? best : 1));
+    }
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+
+    test_basic();
+    test_sync_in_line();
+    test_ring_full();
+    test_random(quick ? 2000 : 50000);
+    test_wakeups(quick ? 2 : 10);
+    bench_feed(quick ? 3 : 50);
+    return check_done("bench_uart_input");
+}
@@ -0,0 +1,331 @@
+// File: host_test/bench_xfer.c
+// ==========================================================================================
+// The tethered transfer end to end on Linux (user-018): xfer_send on a pty master, fed by
+// seg_source from a store generated through log_sink -> log_store, and tools/tether_recv.py
+// on the slave side as the USB host. Every run gets a fresh receiver process:
+//   1. clean       no faults: throughput
+//   2. lossy       DATA frames dropped and corrupted, host reads lost: selective retransmit
+//   3. cable pull  pty closed and its name removed partway, back after CABLE_OUT_MS: the
+//                  session resumes from the host's offsets; recovery time
+//   4. again       same output as 3: every file is already there and skipped
+// The rebuilt LOGS tree must match the store byte for byte.
+//
+// Usage: bench_xfer [--quick] [dir]. The store goes to dir (default ./xfer_host), the
+// receiver writes dir_rx and the pty is linked as dir.tty. pyserial is required.
+// ==========================================================================================
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#include "check.h"
+#include "log_sink.h"
+#include "log_store.h"
+#include "seg_source.h"
+#include "xfer_proto.h"
+
+#define SEGMENT_KB      256
+#define CHUNK           8192        // config.yaml: chunk_bytes, capped at XFER_CHUNK_MAX
+#define WINDOW          16          // config.yaml: window
+#define RESUME_MS       10000
+#define CABLE_OUT_MS    500
+#define RECV_WAIT_S     "5"         // Receiver gives up after this long without the device
+
+static log_sink_t sink;
+static log_store_t store;
+static const char *root = "xfer_host";
+static char rx_root[LOG_PATH_MAX], tty_link[LOG_PATH_MAX];
+static xfer_tx_t tx;
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+
+static uint32_t rnd(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)rng;
+}
+
+// === Store generation (packer and writer task bodies run by hand) ===
+
+static void pump(void) {
+    log_sink_req_t req;
+
+    while (log_sink_pack(&sink, &req)) {
+        log_store_write(&store, &req);
+        log_sink_block_done(&sink, req.buf);
+    }
+}
+
+static void generate_store(unsigned lines) {
+    log_sink_req_t req;
+    char line[LOG_SINK_LINE_MAX + 1];
+    uint32_t ts = 300;
+
+    CHECK(log_store_open(&store, root, SEGMENT_KB, true));
+    log_sink_init(&sink, 0);
+    for (unsigned i = 0; i < lines; i++) {
+        uint32_t r = rnd();
+        ts += r % 7;
+        int n = snprintf(line, sizeof(line), "%c (%u) %s: event %u value=%d %08x\n",
+                         (r & 0xF) ? 'I' : 'W', (unsigned)ts,
+                         (r & 0x10) ? "SD_LOG" : "STATE_MACHINE", i, (int)(r % 1000) - 500,
+                         (unsigned)rnd());
+        log_sink_write(&sink, line, (size_t)n);
+        if ((i & 31) == 31) {
+            pump();
+        }
+    }
+    pump();
+    if (log_sink_flush_partial(&sink, &req)) {
+        log_store_write(&store, &req);
+    }
+    log_store_close(&store);
+    CHECK_EQ(store.stats.errors, 0);
+}
+
+// === Link: pty master, with fault injection and a cable to pull ===
+
+typedef struct {
+    int      master, slave;
+    unsigned drop_pct;          ///< DATA frames lost on the way out
+    unsigned corrupt_pct;       ///< DATA frames damaged on the way out
+    unsigned read_loss_pct;     ///< Reads from the host lost (ACKs and all)
+    uint64_t cut_after;         ///< Pull the cable after this many bytes (0: never)
+    uint64_t written;
+    uint32_t back_at_ms;        ///< Cable out until then
+    bool     cut_done;
+} pty_link_t;
+
+static uint32_t now_ms(void *ctx) {
+    struct timespec t;
+
+    (void)ctx;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+static bool pty_open(pty_link_t *l) {
+    struct termios tio;
+
+    l->master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (l->master < 0 || grantpt(l->master) != 0 || unlockpt(l->master) != 0) {
+        return false;
+    }
+    const char *name = ptsname(l->master);
+    l->slave = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);  // Held: host reopens do not hang up
+    if (l->slave < 0 || tcgetattr(l->slave, &tio) != 0) {
+        return false;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(l->slave, TCSANOW, &tio);
+    unlink(tty_link);
+    return symlink(name, tty_link) == 0;
+}
+
+static void pty_close(pty_link_t *l) {
+    if (l->master >= 0) {
+        close(l->master);
+        close(l->slave);
+    }
+    l->master = l->slave = -1;
+    unlink(tty_link);
+}
+
+/** Pull the cable once cut_after bytes are out; plug it back in CABLE_OUT_MS later. */
+static void cable(pty_link_t *l) {
+    if (l->cut_after && !l->cut_done && l->written >= l->cut_after) {
+        l->cut_done = true;
+        l->back_at_ms = now_ms(NULL) + CABLE_OUT_MS;
+        pty_close(l);
+    }
+    if (l->master < 0 && now_ms(NULL) >= l->back_at_ms) {
+        pty_open(l);
+    }
+}
+
+static int link_read(void *ctx, uint8_t *buf, size_t cap, uint32_t timeout_ms) {
+    pty_link_t *l = ctx;
+
+    cable(l);
+    if (l->master < 0) {
+        nanosleep(&(struct timespec){ .tv_nsec = 1000000L }, NULL);
+        return -1;
+    }
+    struct pollfd p = { .fd = l->master, .events = POLLIN };
+    if (poll(&p, 1, (int)timeout_ms) <= 0) {
+        return 0;
+    }
+    ssize_t n = read(l->master, buf, cap);
+    if (n < 0) {                                // EIO: no host has the port open
+        nanosleep(&(struct timespec){ .tv_nsec = 1000000L }, NULL);
+        return errno == EIO ? 0 : -1;
+    }
+    if (rnd() % 100 < l->read_loss_pct) {
+        return 0;
+    }
+    return (int)n;
+}
+
+static bool link_write(void *ctx, const uint8_t *data, size_t len) {
+    static uint8_t damaged[XFER_COBS_MAX(XFER_MSG_MAX)];
+    pty_link_t *l = ctx;
+
+    cable(l);
+    if (l->master < 0) {
+        return false;
+    }
+    l->written += len;
+    if (len > XFER_DATA_HDR + 16) {             // DATA only: the handshake gets through
+        if (rnd() % 100 < l->drop_pct) {
+            return true;
+        }
+        if (rnd() % 100 < l->corrupt_pct && len <= sizeof(damaged)) {
+            memcpy(damaged, data, len);
+            damaged[len / 2] ^= 0x5A;
+            data = damaged;
+        }
+    }
+    while (len) {
+        struct pollfd p = { .fd = l->master, .events = POLLOUT };
+        if (poll(&p, 1, 200) <= 0) {
+            return false;
+        }
+        ssize_t n = write(l->master, data, len);
+        if (n < 0) {
+            if (errno == EAGAIN) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// === Sessions ===
+
+static pid_t start_receiver(void) {
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        execl(PYTHON, PYTHON, TETHER_RECV, tty_link, "--out", rx_root, "--wait", RECV_WAIT_S,
+              (char *)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+/** Every closed segment arrived intact under rx_root. */
+static unsigned compare_trees(unsigned *files) {
+    static uint8_t a[CHUNK], b[CHUNK];
+    seg_source_t ss;
+    xfer_source_t src;
+    xfer_file_t f;
+    unsigned bad = 0;
+
+    *files = 0;
+    CHECK(seg_source_open(&ss, &src, root, 0));
+    while (src.next(src.ctx, &f)) {
+        char path[LOG_PATH_MAX];
+        log_seg_path(path, sizeof(path), rx_root, f.id);
+        FILE *rx = fopen(path, "rb");
+        bool same = rx != NULL;
+        for (uint32_t off = 0; same && off < f.size; off += CHUNK) {
+            size_t n = f.size - off < CHUNK ? f.size - off : CHUNK;
+            same = src.read(src.ctx, &f, off, a, n) && fread(b, 1, n, rx) == n &&
+                   memcmp(a, b, n) == 0;
+        }
+        same = same && fgetc(rx) == EOF;
+        if (rx) {
+            fclose(rx);
+        }
+        bad += !same;
+        (*files)++;
+    }
+    seg_source_close(&ss);
+    return bad;
+}
+
+static const xfer_stats_t *session(const char *name, pty_link_t l) {
+    seg_source_t ss;
+    xfer_source_t src;
+    xfer_params_t p = { .chunk = CHUNK, .window = WINDOW, .resume_ms = RESUME_MS, .boot = 1,
+                        .session = rnd() };
+    xfer_link_t link = { .ctx = &l, .read = link_read, .write = link_write, .now_ms = now_ms };
+    int status = -1;
+    unsigned files;
+
+    CHECK(pty_open(&l));
+    CHECK(seg_source_open(&ss, &src, root, 0));
+    pid_t pid = start_receiver();
+    xfer_result_t r = xfer_send(&tx, &p, &link, &src);
+    waitpid(pid, &status, 0);
+    seg_source_close(&ss);
+    pty_close(&l);
+
+    const xfer_stats_t *x = &tx.stats;
+    unsigned bad = compare_trees(&files);
+    CHECK_EQ(r, XFER_OK);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(x->files, files);
+    printf("  %-10s %3u files %3u skipped %7.1f MB %6.1f MB/s  %4u retx  %3u bad frames  "
+           "%u reconnects, recovery %u ms  rtt %u ms\n", name, (unsigned)x->files,
+           (unsigned)x->skipped, x->bytes / 1e6, x->bytes / 1e3 / (x->elapsed_ms ? x->elapsed_ms : 1),
+           (unsigned)x->retransmits, (unsigned)x->bad_frames, (unsigned)x->reconnects,
+           (unsigned)x->recover_max_ms, (unsigned)x->rtt_ms);
+    return x;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    (void)sb; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+int main(int argc, char **argv) {
+    bool quick = bench_quick(argc, argv);
+    const xfer_stats_t *x;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") != 0) {
+            root = argv[i];
+        }
+    }
+    snprintf(rx_root, sizeof(rx_root), "%s_rx", root);
+    snprintf(tty_link, sizeof(tty_link), "%s.tty", root);
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    generate_store(quick ? 40000 : 600000);
+    printf("xfer over a pty to tether_recv.py: %u segments of %u KB (LZ), chunk %u, window %u\n",
+           (unsigned)store.cat.next_seg, SEGMENT_KB, CHUNK, WINDOW);
+
+    nftw(rx_root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    x = session("clean", (pty_link_t){ .master = -1 });
+    CHECK_EQ(x->retransmits, 0);
+    uint64_t total = x->bytes;
+
+    nftw(rx_root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    x = session("lossy", (pty_link_t){ .master = -1, .drop_pct = 3, .corrupt_pct = 2,
+                                       .read_loss_pct = 2 });
+    CHECK(x->retransmits > 0);
+    CHECK_EQ(x->bytes, total);
+
+    nftw(rx_root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    x = session("cable pull", (pty_link_t){ .master = -1, .cut_after = total * 2 / 5 });
+    CHECK_EQ(x->reconnects, 1);
+    CHECK(x->bytes < total);                    // Acked before the pull is not sent again
+    CHECK(x->recover_max_ms >= CABLE_OUT_MS && x->recover_max_ms < CABLE_OUT_MS + 2000);
+
+    x = session("again", (pty_link_t){ .master = -1 });
+    CHECK_EQ(x->skipped, x->files);
+    CHECK_EQ(x->bytes, 0);
+
+    pty_close(&(pty_link_t){ .master = -1 });
+    return check_done("bench_xfer");
+}
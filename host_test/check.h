@@ -0,0 +1,53 @@
+// File: host_test/check.h
+// ==========================================================================================
+// Minimal checks for the host tests: CHECK() records a failure with its line and goes on,
+// so one run reports every broken case; check_done() prints the total and gives the exit
+// code. Benchmarks use bench_now_us() and bench_quick() (the --quick flag under ctest).
+// ==========================================================================================
+
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+static int check_failed;
+static int check_total;
+
+#define CHECK(cond) do {                                                                    \
+        check_total++;                                                                      \
+        if (!(cond)) {                                                                      \
+            check_failed++;                                                                 \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                 \
+        }                                                                                   \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                                 \
+        long long a_ = (long long)(a), b_ = (long long)(b);                                 \
+        check_total++;                                                                      \
+        if (a_ != b_) {                                                                     \
+            check_failed++;                                                                 \
+            printf("%s:%d: %s == %lld, expected %s == %lld\n", __FILE__, __LINE__, #a, a_,  \
+                   #b, b_);                                                                 \
+        }                                                                                   \
+    } while (0)
+
+static inline int check_done(const char *name) {
+    printf("%s: %d checks, %d failed\n", name, check_total, check_failed);
+    return check_failed ? 1 : 0;
+}
+
+static inline uint64_t bench_now_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000u + (uint64_t)t.tv_nsec / 1000u;
+}
+
+static inline bool bench_quick(int argc, char **argv) {
+    return argc > 1 && strcmp(argv[1], "--quick") == 0;
+}
+
+#endif // HOST_CHECK_H
@@ -0,0 +1,178 @@
+// File: host_test/fuzz_config_parser.c
+// ==========================================================================================
+// Fuzz target for config_parser. Each input is parsed as one buffer and again fed in two
+// pieces split at an input-derived point; both must agree, and the result must be sane:
+// error positions inside the text, strings terminated, list counts within the schema.
+// Any violation aborts, as does anything the sanitizers catch.
+//
+//   Built by default as a self-contained mutation fuzzer seeded with config.yaml:
+//     fuzz_config_parser [iterations] [seed]      (ctest runs it with --quick)
+//   With -DHOST_SANITIZE=ON the host build adds ASan + UBSan; under clang a libFuzzer
+//   build (fuzz_config_parser_libfuzzer) uses LLVMFuzzerTestOneInput() directly.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "config_parser.h"
+
+#ifndef CONFIG_YAML_PATH
+#define CONFIG_YAML_PATH    "../main/config.yaml"
+#endif
+
+#define FUZZ_INPUT_MAX  4096
+
+#define REQUIRE(cond) do {                                                                  \
+        if (!(cond)) {                                                                      \
+            fprintf(stderr, "%s:%d: REQUIRE(%s) failed\n", __FILE__, __LINE__, #cond);      \
+            abort();                                                                        \
+        }                                                                                   \
+    } while (0)
+
+static void check_config(const app_config_t *cfg) {
+#define FUZZ_CHECK_STR(m, size)         REQUIRE(memchr(cfg->m, '\0', sizeof(cfg->m)) != NULL);
+#define FUZZ_CHECK_U8(m, size)
+#define FUZZ_CHECK_U16(m, size)
+#define FUZZ_CHECK_U32(m, size)
+#define FUZZ_CHECK_BOOL(m, size)
+#define FUZZ_CHECK_U8_LIST(m, size)     REQUIRE(cfg->m##_count <= (size));
+#define X(sec, key, type, size, min, max, def) FUZZ_CHECK_##type(sec##_##key, size)
+    CONFIG_SCHEMA(X)
+#undef X
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    const char *text = (const char *)data;
+    app_config_t whole, split;
+    config_error_t err;
+    config_parser_t p;
+    size_t lines = 1;
+
+    config_status_t rc = config_parse_buffer(text, size, &whole, &err);
+    REQUIRE(rc == err.code);
+    for (size_t i = 0; i < size; i++) {
+        lines += text[i] == '\n';
+    }
+    if (rc != CONFIG_OK) {
+        REQUIRE(strcmp(config_status_str(rc), "?") != 0);
+        REQUIRE(err.line >= 1 && err.line <= lines);
+        REQUIRE(err.column >= 1 && err.column <= CONFIG_LINE_MAX + 1);
+    }
+    check_config(&whole);
+
+    size_t cut = size ? data[0] % (size + 1) : 0;
+    config_parser_init(&p, &split);
+    config_parser_feed(&p, text, cut);
+    config_parser_feed(&p, text + cut, size - cut);
+    config_parser_finish(&p);
+    REQUIRE(memcmp(&p.err, &err, sizeof(err)) == 0);
+    REQUIRE(memcmp(&split, &whole, sizeof(whole)) == 0);
+    return 0;
+}
+
+#ifndef HOST_LIBFUZZER
+
+// === Self-contained mutation loop ===
+
+static const char *const tokens[] = {
+    ":", ": ", " ", "  ", "\n", "\r\n", "\t", "\"", "'", "''", "\\", "\\\"", "[", "]", ", ",
+    "#", " # c", "- ", "0x", "0xFF", "4294967296", "yes", "off", "[1, 6, 11]", "device:",
+    "wifi:", "  channels:", "  ssid: ", "rtv:", "  fps: ",
+};
+#define TOKEN_COUNT     (sizeof(tokens) / sizeof(tokens[0]))
+
+static uint32_t rng;
+
+static uint32_t next_rand(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/** @brief Apply 1-4 random edits: byte flip, token insert, range delete or line copy. */
+static size_t mutate(char *buf, size_t len) {
+    for (int edits = 1 + next_rand() % 4; edits > 0; edits--) {
+        size_t at = len ? next_rand() % len : 0;
+        switch (next_rand() % 4) {
+            case 0:
+                if (len) {
+                    buf[at] = (char)next_rand();
+                }
+                break;
+            case 1: {
+                const char *t = tokens[next_rand() % TOKEN_COUNT];
+                size_t n = strlen(t);
+                if (len + n <= FUZZ_INPUT_MAX) {
+                    memmove(buf + at + n, buf + at, len - at);
+                    memcpy(buf + at, t, n);
+                    len += n;
+                }
+                break;
+            }
+            case 2: {
+                size_t n = len - at < 16 ? len - at : next_rand() % 16;
+                memmove(buf + at, buf + at + n, len - at - n);
+                len -= n;
+                break;
+            }
+            default: {
+                size_t from = len ? next_rand() % len : 0, n = 0;
+                while (from + n < len && buf[from + n] != '\n' && n < 200) {
+                    n++;
+                }
+                if (len + n <= FUZZ_INPUT_MAX) {
+                    char line[200];
+                    memcpy(line, buf + from, n);
+                    memmove(buf + at + n, buf + at, len - at);
+                    memcpy(buf + at, line, n);
+                    len += n;
+                }
+                break;
+            }
+        }
+    }
+    return len;
+}
+
+int main(int argc, char **argv) {
+    static char seed_text[FUZZ_INPUT_MAX], buf[FUZZ_INPUT_MAX];
+    unsigned long iterations = bench_quick(argc, argv) ? 20000
+                             : argc > 1 ? strtoul(argv[1], NULL, 0) : 2000000;
+    unsigned errors[32] = {0};
+    size_t seed_len = 0;
+
+    rng = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x9E3779B9u;
+    FILE *f = fopen(CONFIG_YAML_PATH, "rb");
+    if (f) {
+        seed_len = fread(seed_text, 1, sizeof(seed_text), f);
+        fclose(f);
+    }
+    CHECK(seed_len > 0);
+
+    uint64_t t0 = bench_now_us();
+    for (unsigned long i = 0; i < iterations; i++) {
+        memcpy(buf, seed_text, seed_len);
+        size_t len = seed_len;
+        for (int rounds = 1 + next_rand() % 8; rounds > 0; rounds--) {
+            len = mutate(buf, len);
+        }
+        LLVMFuzzerTestOneInput((const uint8_t *)buf, len);
+
+        config_error_t err;
+        app_config_t cfg;
+        errors[config_parse_buffer(buf, len, &cfg, &err) & 31]++;
+    }
+    uint64_t us = bench_now_us() - t0;
+
+    printf("%lu inputs in %.1f s (%.0f/s); results:\n", iterations, us / 1e6,
+           us ? iterations * 1e6 / us : 0.0);
+    for (int c = 0; c < 32; c++) {
+        if (errors[c]) {
+            printf("  %-28s %u\n", config_status_str((config_status_t)c), errors[c]);
+        }
+    }
+    CHECK(errors[CONFIG_OK] > 0);               // The mutations do not only break the file
+    return check_done("fuzz_config_parser");
+}
+
+#endif // HOST_LIBFUZZER
@@ -0,0 +1,126 @@
+// File: host_test/stubs/driver/uart.h
+// ==========================================================================================
+// Host stand-in for the UART driver. Transmit: uart_write_bytes() counts the bytes and
+// keeps the last write in host_uart_last (up to its size), so a test can read a reply.
+// Receive: a test appends bytes to host_uart_rx and the reads take them from there; the
+// setup calls succeed and no events are ever queued.
+// ==========================================================================================
+
+#ifndef HOST_STUB_DRIVER_UART_H
+#define HOST_STUB_DRIVER_UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_err.h"
+#include "freertos/queue.h"
+
+typedef int uart_port_t;
+
+#define UART_NUM_0  0
+#define UART_NUM_1  1
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX,
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_DEFAULT = 0 } uart_sclk_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    uart_sclk_t source_clk;
+} uart_config_t;
+
+__attribute__((weak)) uint64_t host_uart_tx_bytes;
+__attribute__((weak)) uint8_t host_uart_last[128];
+__attribute__((weak)) size_t host_uart_last_len;
+
+static inline int uart_write_bytes(uart_port_t port, const void *src, size_t size) {
+    (void)port;
+    host_uart_tx_bytes += size;
+    host_uart_last_len = size < sizeof(host_uart_last) ? size : sizeof(host_uart_last);
+    memcpy(host_uart_last, src, host_uart_last_len);
+    return (int)size;
+}
+
+__attribute__((weak)) uint8_t host_uart_rx[4096];
+__attribute__((weak)) size_t host_uart_rx_len;
+
+static inline esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size) {
+    (void)port;
+    *size = host_uart_rx_len;
+    return ESP_OK;
+}
+
+static inline int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t wait) {
+    size_t n = length < host_uart_rx_len ? length : host_uart_rx_len;
+
+    (void)port; (void)wait;
+    memcpy(buf, host_uart_rx, n);
+    memmove(host_uart_rx, host_uart_rx + n, host_uart_rx_len - n);
+    host_uart_rx_len -= n;
+    return (int)n;
+}
+
+static inline esp_err_t uart_flush_input(uart_port_t port) {
+    (void)port;
+    host_uart_rx_len = 0;
+    return ESP_OK;
+}
+
+static inline int uart_pattern_pop_pos(uart_port_t port) {
+    (void)port;
+    return -1;
+}
+
+static inline esp_err_t uart_driver_install(uart_port_t port, int rx_size, int tx_size,
+                                            int queue_size, QueueHandle_t *queue, int flags) {
+    (void)port; (void)rx_size; (void)tx_size; (void)queue_size; (void)flags;
+    if (queue) {
+        *queue = NULL;
+    }
+    return ESP_OK;
+}
+
+static inline esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config) {
+    (void)port; (void)config;
+    return ESP_OK;
+}
+
+static inline esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t port, char chr,
+                                                          uint8_t num, int chr_tout,
+                                                          int post_idle, int pre_idle) {
+    (void)port; (void)chr; (void)num; (void)chr_tout; (void)post_idle; (void)pre_idle;
+    return ESP_OK;
+}
+
+static inline esp_err_t uart_pattern_queue_reset(uart_port_t port, int queue_length) {
+    (void)port; (void)queue_length;
+    return ESP_OK;
+}
+
+#endif // HOST_STUB_DRIVER_UART_H
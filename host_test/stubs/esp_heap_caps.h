@@ -0,0 +1,26 @@
+// File: host_test/stubs/esp_heap_caps.h
+// ==========================================================================================
+// Host stand-in for esp_heap_caps.h: every capability is plain malloc().
+// ==========================================================================================
+
+#ifndef HOST_STUB_ESP_HEAP_CAPS_H
+#define HOST_STUB_ESP_HEAP_CAPS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1u << 2)
+#define MALLOC_CAP_DMA      (1u << 3)
+#define MALLOC_CAP_INTERNAL (1u << 11)
+#define MALLOC_CAP_SPIRAM   (1u << 10)
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void heap_caps_free(void *ptr) {
+    free(ptr);
+}
+
+#endif // HOST_STUB_ESP_HEAP_CAPS_H
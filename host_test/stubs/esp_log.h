@@ -0,0 +1,78 @@
+// File: host_test/stubs/esp_log.h
+// ==========================================================================================
+// Host stand-in for esp_log: ESP_LOGx formats the line like the IDF does ("I (ms) TAG: ...")
+// and hands it to host_log_sink (NULL: formatted, then discarded), so a benchmark still
+// pays for the formatting a log call costs on the device, without the UART. esp_log_write
+// (the tokenized log's output) writes its text there unchanged.
+// ==========================================================================================
+
+#ifndef HOST_STUB_ESP_LOG_H
+#define HOST_STUB_ESP_LOG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL     ESP_LOG_INFO
+#endif
+
+__attribute__((weak)) FILE *host_log_sink;
+
+static inline uint32_t esp_log_timestamp(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)(t.tv_sec * 1000u + t.tv_nsec / 1000000u);
+}
+
+__attribute__((format(printf, 3, 4)))
+static inline void host_log_write(char letter, const char *tag, const char *fmt, ...) {
+    char line[256];
+    va_list args;
+    int n = snprintf(line, sizeof(line), "%c (%u) %s: ", letter, (unsigned)esp_log_timestamp(), tag);
+
+    va_start(args, fmt);
+    vsnprintf(line + n, sizeof(line) - (size_t)n, fmt, args);
+    va_end(args);
+    if (host_log_sink) {
+        fprintf(host_log_sink, "%s\n", line);
+    }
+}
+
+/** Raw write as tlog_emit() uses it: the text as given, no prefix (tag and level unused). */
+__attribute__((format(printf, 3, 4)))
+static inline void esp_log_write(esp_log_level_t level, const char *tag, const char *fmt, ...) {
+    va_list args;
+
+    (void)level;
+    (void)tag;
+    if (host_log_sink) {
+        va_start(args, fmt);
+        vfprintf(host_log_sink, fmt, args);
+        va_end(args);
+    }
+}
+
+#define ESP_LOG_AT_(level, letter, tag, fmt, ...) do {                                      \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                                   \
+            host_log_write(letter, tag, fmt, ##__VA_ARGS__);                                \
+        }                                                                                   \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...)     ESP_LOG_AT_(ESP_LOG_ERROR,   'E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)     ESP_LOG_AT_(ESP_LOG_WARN,    'W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)     ESP_LOG_AT_(ESP_LOG_INFO,    'I', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)     ESP_LOG_AT_(ESP_LOG_DEBUG,   'D', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...)     ESP_LOG_AT_(ESP_LOG_VERBOSE, 'V', tag, fmt, ##__VA_ARGS__)
+
+#endif // HOST_STUB_ESP_LOG_H
@@ -0,0 +1,18 @@
+// File: host_test/stubs/esp_timer.h
+// ==========================================================================================
+// Host stand-in for esp_timer: only the clock (CLOCK_MONOTONIC, in microseconds).
+// ==========================================================================================
+
+#ifndef HOST_STUB_ESP_TIMER_H
+#define HOST_STUB_ESP_TIMER_H
+
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+#endif // HOST_STUB_ESP_TIMER_H
@@ -0,0 +1,28 @@
+// File: host_test/stubs/freertos/FreeRTOS.h
+// ==========================================================================================
+// Host stand-in for the FreeRTOS types and macros the modules under test use. Critical
+// sections are no-ops: the host programs call a module from one thread unless they say
+// otherwise, and then they bring their own locking.
+// ==========================================================================================
+
+#ifndef HOST_STUB_FREERTOS_H
+#define HOST_STUB_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef int      portMUX_TYPE;
+
+#define pdFALSE                         0
+#define pdTRUE                          1
+#define pdFAIL                          0
+#define pdPASS                          1
+#define portMAX_DELAY                   ((TickType_t)0xFFFFFFFFu)
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms))
+#define portMUX_INITIALIZER_UNLOCKED    0
+#define taskENTER_CRITICAL(mux)         ((void)(mux))
+#define taskEXIT_CRITICAL(mux)          ((void)(mux))
+
+#endif // HOST_STUB_FREERTOS_H
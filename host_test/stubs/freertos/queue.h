@@ -0,0 +1,24 @@
+// File: host_test/stubs/freertos/queue.h
+// ==========================================================================================
+// Host stand-in for freertos/queue.h: only the handle type and the calls the UART input
+// path makes. No queue ever holds anything; a test calls the task bodies' helpers instead.
+// ==========================================================================================
+
+#ifndef HOST_STUB_FREERTOS_QUEUE_H
+#define HOST_STUB_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+static inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait) {
+    (void)queue; (void)item; (void)wait;
+    return pdFALSE;
+}
+
+static inline BaseType_t xQueueReset(QueueHandle_t queue) {
+    (void)queue;
+    return pdPASS;
+}
+
+#endif // HOST_STUB_FREERTOS_QUEUE_H
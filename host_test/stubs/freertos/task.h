@@ -0,0 +1,51 @@
+// File: host_test/stubs/freertos/task.h
+// ==========================================================================================
+// Host stand-in for freertos/task.h: no tasks are started on the host (xTaskCreate fails),
+// a test calls the task bodies' helpers directly instead.
+// ==========================================================================================
+
+#ifndef HOST_STUB_FREERTOS_TASK_H
+#define HOST_STUB_FREERTOS_TASK_H
+
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define tskIDLE_PRIORITY                0
+
+static inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack,
+                                     void *arg, UBaseType_t prio, TaskHandle_t *handle) {
+    (void)fn; (void)name; (void)stack; (void)arg; (void)prio;
+    if (handle) {
+        *handle = NULL;
+    }
+    return pdFAIL;
+}
+
+static inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+    (void)clear; (void)wait;
+    return 0;
+}
+
+static inline void xTaskNotifyGive(TaskHandle_t task) {
+    (void)task;
+}
+
+static inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    (void)task;
+    if (woken) {
+        *woken = pdFALSE;
+    }
+}
+
+static inline TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return NULL;
+}
+
+static inline void vTaskDelay(TickType_t ticks) {
+    (void)ticks;
+}
+
+#endif // HOST_STUB_FREERTOS_TASK_H
@@ -0,0 +1,219 @@
+// File: host_test/test_config_parser.c
+// ==========================================================================================
+// config_parser: the shipped config.yaml, every supported syntax, each error code with the
+// line:column it is reported at, and chunked feeding (any split gives the same result).
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "config_parser.h"
+#ifdef HAVE_CONFIG_YAML_HASH
+#include "config_yaml_hash.h"
+#endif
+
+#ifndef CONFIG_YAML_PATH
+#define CONFIG_YAML_PATH    "../main/config.yaml"
+#endif
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    char *buf = NULL;
+
+    if (f && fseek(f, 0, SEEK_END) == 0) {
+        long n = ftell(f);
+        rewind(f);
+        buf = malloc((size_t)n + 1);
+        *len = fread(buf, 1, (size_t)n, f);
+        buf[*len] = '\0';
+    }
+    if (f) {
+        fclose(f);
+    }
+    return buf;
+}
+
+static config_status_t parse(const char *text, app_config_t *cfg, config_error_t *err) {
+    return config_parse_buffer(text, strlen(text), cfg, err);
+}
+
+static void test_shipped_config(void) {
+    app_config_t cfg;
+    config_error_t err;
+    size_t len = 0;
+    char *text = read_file(CONFIG_YAML_PATH, &len);
+
+    CHECK(text != NULL);
+    if (!text) {
+        return;
+    }
+    CHECK_EQ(config_parse_buffer(text, len, &cfg, &err), CONFIG_OK);
+    CHECK(strcmp(cfg.device_name, "optipulse-01") == 0);
+    CHECK(strcmp(cfg.wifi_ssid, "OptiPulse-Lab") == 0);
+    CHECK_EQ(cfg.wifi_channels_count, 3);
+    CHECK_EQ(cfg.wifi_channels[2], 11);
+    CHECK(cfg.rtv_adaptive);
+    CHECK(cfg.transfer_tether_fallback);
+    CHECK(strcmp(cfg.keys_magic, "unlocked_dev_123") == 0);
+    free(text);
+}
+
+static void test_syntax(void) {
+    app_config_t cfg, def;
+    config_error_t err;
+    const char *text =
+        "# comment\n"
+        "device:\n"
+        "    name: \"a \\\"q\\\" #x\"   # quoted, escaped, '#' kept inside\n"
+        "    security_level: 0x3\n"
+        "\r\n"
+        "wifi:\n"
+        "    password: 'it''s'\n"
+        "    channels:\n"
+        "      - 1\n"
+        "      - 0x0E\n"
+        "rtv:\n"
+        "    adaptive: OFF\n"
+        "    port: 65534\n"
+        "log:\n"
+        "    to_sd: 0";                         // No final newline
+
+    config_set_defaults(&def);
+    CHECK_EQ(parse(text, &cfg, &err), CONFIG_OK);
+    CHECK(strcmp(cfg.device_name, "a \"q\" #x") == 0);
+    CHECK_EQ(cfg.device_security_level, 3);
+    CHECK(strcmp(cfg.wifi_password, "it's") == 0);
+    CHECK_EQ(cfg.wifi_channels_count, 2);
+    CHECK_EQ(cfg.wifi_channels[1], 14);
+    CHECK(!cfg.rtv_adaptive);
+    CHECK_EQ(cfg.rtv_port, 65534);
+    CHECK(!cfg.log_to_sd);
+    CHECK_EQ(cfg.rtv_fps, def.rtv_fps);         // Absent keys keep their defaults
+    CHECK(strcmp(cfg.keys_magic, def.keys_magic) == 0);
+
+    CHECK_EQ(parse("wifi:\n  channels: []\n", &cfg, &err), CONFIG_OK);
+    CHECK_EQ(cfg.wifi_channels_count, 0);
+    CHECK_EQ(parse("wifi:\n  channels: [ 1 , 2, ]\n", &cfg, &err), CONFIG_OK);
+    CHECK_EQ(cfg.wifi_channels_count, 2);
+    CHECK_EQ(parse("", &cfg, &err), CONFIG_OK);
+}
+
+typedef struct {
+    const char     *text;
+    config_status_t code;
+    uint16_t        line;
+    uint16_t        column;
+} error_case_t;
+
+static void test_errors(void) {
+    static char long_line[CONFIG_LINE_MAX + 16];
+    static const error_case_t cases[] = {
+        { "device:\n  name\n",                          CONFIG_ERR_SYNTAX,          2, 3 },
+        { "device:\n\tname: x\n",                       CONFIG_ERR_TAB,             2, 1 },
+        { "device:\n  name: x\n   security_level: 1\n", CONFIG_ERR_INDENT,          3, 4 },
+        { "  name: x\n",                                CONFIG_ERR_INDENT,          1, 3 },
+        { "camera:\n",                                  CONFIG_ERR_UNKNOWN_SECTION, 1, 1 },
+        { "device:\n  nam: x\n",                        CONFIG_ERR_UNKNOWN_KEY,     2, 3 },
+        { "name: x\n",                                  CONFIG_ERR_UNKNOWN_KEY,     1, 1 },
+        { "wifi:\n  ssid: a\n  ssid: b\n",              CONFIG_ERR_DUPLICATE,       3, 3 },
+        { "wifi:\n  ssid:\n",                           CONFIG_ERR_MISSING_VALUE,   2, 7 },
+        { "rtv:\n  fps: ten\n",                         CONFIG_ERR_TYPE,            2, 8 },
+        { "rtv:\n  adaptive: maybe\n",                  CONFIG_ERR_TYPE,            2, 13 },
+        { "rtv:\n  fps: [1]\n",                         CONFIG_ERR_TYPE,            2, 8 },
+        { "rtv:\n  fps: 31\n",                          CONFIG_ERR_RANGE,           2, 8 },
+        { "rtv:\n  fps: 99999999999\n",                 CONFIG_ERR_TYPE,            2, 8 },
+        { "rtv:\n  format: abcdefgh\n",                 CONFIG_ERR_TOO_LONG,        2, 18 },
+        { "wifi:\n  channels: [1, 2, 3, 4, 5]\n",       CONFIG_ERR_LIST_FULL,       2, 26 },
+        { "wifi:\n  channels: [1, 15]\n",               CONFIG_ERR_RANGE,           2, 17 },
+        { "wifi:\n  channels: [1, 2\n",                 CONFIG_ERR_UNTERMINATED,    2, 13 },
+        { "wifi:\n  ssid: \"open\n",                    CONFIG_ERR_UNTERMINATED,    2, 9 },
+        { "wifi:\n  channels: [1 2]\n",                 CONFIG_ERR_TYPE,            2, 14 },
+        { "wifi:\n  channels: [1] x\n",                 CONFIG_ERR_SYNTAX,          2, 17 },
+        { "wifi:\n  channels:\n    - 1 \"x\"\n",        CONFIG_ERR_TYPE,            3, 7 },
+        { "wifi:\n  channels:\n    - \"1\" x\n",        CONFIG_ERR_SYNTAX,          3, 11 },
+        { "wifi:\n  ssid: \"a\" b\n",                   CONFIG_ERR_SYNTAX,          2, 13 },
+        { "- 1\n",                                      CONFIG_ERR_SYNTAX,          1, 1 },
+        { "wifi:\n  channels:\n    -\n",                CONFIG_ERR_MISSING_VALUE,   3, 5 },
+        { NULL,                                         CONFIG_ERR_LINE_TOO_LONG,   2, CONFIG_LINE_MAX + 1 },
+    };
+
+    memcpy(long_line, "wifi:\n", 6);
+    memset(long_line + 6, 'x', CONFIG_LINE_MAX + 4);
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const error_case_t *c = &cases[i];
+        const char *text = c->text ? c->text : long_line;
+        app_config_t cfg;
+        config_error_t err;
+        config_status_t rc = parse(text, &cfg, &err);
+
+        if (rc != c->code || err.line != c->line || err.column != c->column) {
+            printf("case %zu: %u:%u %s, expected %u:%u %s\n", i, err.line, err.column,
+                   config_status_str(rc), c->line, c->column, config_status_str(c->code));
+        }
+        CHECK_EQ(rc, c->code);
+        CHECK_EQ(err.code, c->code);
+        CHECK_EQ(err.line, c->line);
+        CHECK_EQ(err.column, c->column);
+        CHECK(strcmp(config_status_str(rc), "?") != 0);
+    }
+}
+
+/** @brief Feeding in chunks of every size gives the same config and error as one buffer. */
+static void test_chunks(void) {
+    size_t len = 0;
+    char *text = read_file(CONFIG_YAML_PATH, &len);
+    const char *bad = "wifi:\n  ssid: x\n  channels: [1, 6\n";
+
+    for (int doc = 0; doc < 2 && text; doc++) {
+        const char *t = doc ? bad : text;
+        size_t n = doc ? strlen(bad) : len;
+        app_config_t whole, part;
+        config_error_t err;
+        config_parse_buffer(t, n, &whole, &err);
+
+        for (size_t chunk = 1; chunk <= 64; chunk++) {
+            config_parser_t p;
+            config_parser_init(&p, &part);
+            for (size_t i = 0; i < n; i += chunk) {
+                config_parser_feed(&p, t + i, n - i < chunk ? n - i : chunk);
+            }
+            config_parser_finish(&p);
+            CHECK(memcmp(&p.err, &err, sizeof(err)) == 0);
+            CHECK(memcmp(&part, &whole, sizeof(whole)) == 0);
+        }
+    }
+    free(text);
+}
+
+static void test_hashes(void) {
+    CHECK_EQ(config_hash("", 0, CONFIG_HASH_SEED), CONFIG_HASH_SEED);
+    CHECK_EQ(config_hash("a", 1, CONFIG_HASH_SEED), 0xE40C292Cu);      // FNV-1a test vector
+    CHECK_EQ(config_hash("b", 1, config_hash("a", 1, CONFIG_HASH_SEED)),
+             config_hash("ab", 2, CONFIG_HASH_SEED));
+    CHECK_EQ(config_schema_hash(), config_schema_hash());
+}
+
+/** @brief tools/config_hash.py gives what config_hash() gives at run time. */
+static void test_build_time_hash(void) {
+#ifdef HAVE_CONFIG_YAML_HASH
+    size_t len = 0;
+    char *text = read_file(CONFIG_YAML_PATH, &len);
+
+    CHECK(text != NULL);
+    if (text) {
+        CHECK_EQ(len, CONFIG_YAML_BYTES);
+        CHECK_EQ(config_hash(text, len, CONFIG_HASH_SEED), CONFIG_YAML_HASH);
+        free(text);
+    }
+#endif
+}
+
+int main(void) {
+    test_shipped_config();
+    test_syntax();
+    test_errors();
+    test_chunks();
+    test_hashes();
+    test_build_time_hash();
+    return check_done("test_config_parser");
+}
@@ -0,0 +1,180 @@
+// File: host_test/test_led_mailbox.c
+// ==========================================================================================
+// led_mailbox under load: PRODUCERS threads post to random channels while one consumer
+// thread takes, like tasks calling led_apply_pattern() against the LED timer callback.
+// Checks that no command is torn or lost (posted = taken + superseded, every slot free
+// at the end), that each channel's sequence numbers only go up, that one producer's
+// commands reach a channel in the order it posted them, and that the sequence skips 0
+// when it wraps. With the slot pool exhausted a post gives up after its bounded scans
+// and counts a drop. Includes led_mailbox.c to look at the pool and poke the version.
+// Build with -fsanitize=thread to have the races checked as well.
+// ==========================================================================================
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "check.h"
+#include "led_mailbox.c"
+
+#define PRODUCERS       4                       // + 16 mailboxes + consumer <= slots
+#define CHANNELS        LED_SCHED_MAX_CHANNELS
+
+_Static_assert(PRODUCERS + CHANNELS + 1 <= LED_MAILBOX_SLOTS, "slot pool would run dry");
+
+static unsigned posts_per_producer;
+static atomic_int producers_left;
+static atomic_bool go;                          // Everyone starts together
+
+static uint32_t last_seq[CHANNELS];             // Consumer side only
+static uint32_t last_count[CHANNELS][PRODUCERS];
+static unsigned torn, out_of_order, seq_backwards, seq_zero;
+
+/** @brief Command payload: producer and a per-producer counter, b checks a. */
+static led_cmd_t make_cmd(unsigned producer, uint32_t count) {
+    return (led_cmd_t){ .op = LED_CMD_BLINK, .pattern = (uint8_t)producer,
+                        .a = count, .b = ~count ^ (producer * 0x01010101u) };
+}
+
+static void *producer(void *arg) {
+    unsigned id = (unsigned)(uintptr_t)arg;
+    unsigned seed = id * 7919u + 1;
+
+    while (!atomic_load(&go)) {
+    }
+    for (uint32_t i = 1; i <= posts_per_producer; i++) {
+        uint8_t ch = (uint8_t)(rand_r(&seed) % CHANNELS);
+        led_cmd_t cmd = make_cmd(id, i);
+        led_mailbox_post(ch, &cmd);
+        if ((i & 63) == 0) {
+            sched_yield();                      // Interleave even on a single core
+        }
+    }
+    atomic_fetch_sub(&producers_left, 1);
+    return NULL;
+}
+
+static void consume(uint8_t ch, const led_cmd_t *cmd) {
+    unsigned p = cmd->pattern;
+
+    if (p >= PRODUCERS || cmd->b != (~cmd->a ^ (p * 0x01010101u))) {
+        torn++;
+        return;
+    }
+    if (cmd->seq == 0) {
+        seq_zero++;
+    }
+    if (last_seq[ch] && ((cmd->seq - last_seq[ch]) & BOX_VER_MAX) >= 0x800000u) {
+        seq_backwards++;
+    }
+    last_seq[ch] = cmd->seq;
+    if (cmd->a <= last_count[ch][p]) {
+        out_of_order++;
+    }
+    last_count[ch][p] = cmd->a;
+}
+
+static void *consumer(void *arg) {
+    led_cmd_t cmd;
+    (void)arg;
+
+    while (!atomic_load(&go)) {
+    }
+    while (atomic_load(&producers_left) > 0) {
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            if (led_mailbox_take(ch, &cmd)) {
+                consume(ch, &cmd);
+            }
+        }
+        sched_yield();
+    }
+    for (uint8_t ch = 0; ch < CHANNELS; ch++) {                 // Whatever is left
+        if (led_mailbox_take(ch, &cmd)) {
+            consume(ch, &cmd);
+        }
+    }
+    return NULL;
+}
+
+static void test_stress(void) {
+    pthread_t prod[PRODUCERS], cons;
+    led_mailbox_stats_t st;
+
+    atomic_store(&producers_left, PRODUCERS);
+    pthread_create(&cons, NULL, consumer, NULL);
+    for (unsigned i = 0; i < PRODUCERS; i++) {
+        pthread_create(&prod[i], NULL, producer, (void *)(uintptr_t)i);
+    }
+    atomic_store(&go, true);
+    for (unsigned i = 0; i < PRODUCERS; i++) {
+        pthread_join(prod[i], NULL);
+    }
+    pthread_join(cons, NULL);
+
+    led_mailbox_get_stats(&st);
+    CHECK_EQ(st.posted, (uint64_t)PRODUCERS * posts_per_producer);
+    CHECK_EQ(st.posted, st.taken + st.superseded);
+    CHECK_EQ(st.dropped, 0);                                    // Pool sized for the load
+    CHECK(st.taken > 0);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(out_of_order, 0);
+    CHECK_EQ(seq_backwards, 0);
+    CHECK_EQ(seq_zero, 0);
+    for (unsigned i = 0; i < LED_MAILBOX_SLOTS; i++) {
+        CHECK(!atomic_load(&slots[i].busy));                    // No slot leaked
+    }
+    for (unsigned ch = 0; ch < CHANNELS; ch++) {
+        CHECK_EQ(BOX_SLOT(atomic_load(&mailbox[ch])), 0);
+    }
+    printf("%u producers: %u posted, %u taken, %u superseded\n", PRODUCERS,
+           (unsigned)st.posted, (unsigned)st.taken, (unsigned)st.superseded);
+}
+
+static void test_seq_wrap(void) {
+    led_cmd_t cmd = make_cmd(0, 1), got;
+    uint8_t ch = 3;
+
+    atomic_store(&mailbox[ch], BOX_PACK(0, BOX_VER_MAX - 1));
+    CHECK_EQ(led_mailbox_post(ch, &cmd), BOX_VER_MAX);
+    CHECK(led_mailbox_take(ch, &got));
+    CHECK_EQ(got.seq, BOX_VER_MAX);
+    CHECK_EQ(led_mailbox_post(ch, &cmd), 1);                    // Skips 0
+    CHECK_EQ(led_mailbox_post(ch, &cmd), 2);                    // Supersedes 1
+    CHECK(led_mailbox_take(ch, &got));
+    CHECK_EQ(got.seq, 2);
+    CHECK(!led_mailbox_take(ch, &got));
+    CHECK_EQ(led_mailbox_post(LED_SCHED_MAX_CHANNELS, &cmd), 0); // Out of range
+}
+
+static void test_pool_exhausted(void) {
+    led_cmd_t cmd = make_cmd(0, 7), got;
+    led_mailbox_stats_t before, after;
+    uint8_t ch = 5;
+
+    led_mailbox_get_stats(&before);
+    for (unsigned i = 0; i < LED_MAILBOX_SLOTS; i++) {
+        atomic_store(&slots[i].busy, true);                     // Stuck holders
+    }
+    uint32_t box = atomic_load(&mailbox[ch]);
+    CHECK_EQ(led_mailbox_post(ch, &cmd), 0);                    // Gives up, does not spin
+    CHECK_EQ(atomic_load(&mailbox[ch]), box);
+    led_mailbox_get_stats(&after);
+    CHECK_EQ(after.dropped - before.dropped, 1);
+    CHECK_EQ(after.posted, before.posted);
+
+    atomic_store(&slots[LED_MAILBOX_SLOTS - 1].busy, false);   // One comes free
+    CHECK(led_mailbox_post(ch, &cmd) != 0);
+    CHECK(led_mailbox_take(ch, &got));
+    CHECK_EQ(got.a, 7);
+    for (unsigned i = 0; i < LED_MAILBOX_SLOTS; i++) {
+        atomic_store(&slots[i].busy, false);
+    }
+}
+
+int main(int argc, char **argv) {
+    posts_per_producer = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+
+    test_stress();
+    test_seq_wrap();
+    test_pool_exhausted();
+    return check_done("test_led_mailbox");
+}
@@ -0,0 +1,148 @@
+// File: host_test/test_led_pattern.c
+// ==========================================================================================
+// Plays every row of the pattern table against a virtual clock and checks each edge time
+// and level, and how the pattern ends (LOOP, HOLD_OFF, STATIC_ON), against the timing
+// #defines in led_pattern.h.
+// ==========================================================================================
+
+#include "check.h"
+#include "led_pattern.h"
+
+#define EDGES_MAX   256
+
+typedef struct {
+    uint64_t t_us;
+    bool     level;
+} edge_t;
+
+/**
+ * @brief Run the interpreter like the LED task does: the clock jumps to each deadline.
+ *
+ * @return Edges seen before `until_us` (or the end); *ended tells whether step() gave 0.
+ */
+static int play(led_pattern_t p, uint64_t until_us, edge_t *edges, bool *ended) {
+    led_pattern_state_t st;
+    uint64_t t = 0;
+    int n = 0;
+    uint32_t delay = led_pattern_start(&st, led_pattern_get(p));
+
+    *ended = delay == 0;
+    while (delay && n < EDGES_MAX) {
+        t += delay;
+        if (t >= until_us) {
+            break;
+        }
+        delay = led_pattern_step(&st);
+        edges[n++] = (edge_t){ t, st.level };
+        *ended = delay == 0;
+    }
+    return n;
+}
+
+/**
+ * @brief Expected edges of a burst pattern: `cycles` ON/OFF pairs, the last OFF lasting
+ *        `pause` instead of `off` (cycles 0: plain blinking).
+ */
+static int expect(uint32_t on, uint32_t off, uint16_t cycles, uint32_t pause, uint64_t until_us,
+                  edge_t *edges) {
+    uint64_t t = on;                            // Starts ON at 0 (not an edge)
+    int n = 0;
+
+    for (unsigned c = 0; t < until_us && n < EDGES_MAX; c++) {
+        edges[n++] = (edge_t){ t, false };
+        bool last = cycles && (c + 1) % cycles == 0;
+        t += last ? pause : off;
+        if (t >= until_us) {
+            break;
+        }
+        edges[n++] = (edge_t){ t, true };
+        t += on;
+    }
+    return n;
+}
+
+static void check_edges(const char *name, const edge_t *got, int n_got, const edge_t *want,
+                        int n_want) {
+    CHECK_EQ(n_got, n_want);
+    for (int i = 0; i < n_got && i < n_want; i++) {
+        if (got[i].t_us != want[i].t_us || got[i].level != want[i].level) {
+            printf("%s: edge %d at %llu us %s, expected %llu us %s\n", name, i,
+                   (unsigned long long)got[i].t_us, got[i].level ? "ON" : "OFF",
+                   (unsigned long long)want[i].t_us, want[i].level ? "ON" : "OFF");
+            CHECK(false);
+            return;
+        }
+    }
+}
+
+static void test_looping(led_pattern_t p, uint32_t on, uint32_t off, uint16_t cycles,
+                         uint32_t pause) {
+    edge_t got[EDGES_MAX], want[EDGES_MAX];
+    bool ended;
+    uint64_t until = 20000000;                  // 20 s: several bursts of every pattern
+
+    int n_got = play(p, until, got, &ended);
+    int n_want = expect(on, off, cycles, pause, until, want);
+    const char *name = led_pattern_get(p)->name;
+
+    CHECK(!ended);                              // LOOP never ends
+    CHECK(n_got > 4);
+    check_edges(name, got, n_got, want, n_want);
+}
+
+static void test_dev_mode(void) {
+    led_pattern_state_t st;
+    const led_pattern_desc_t *d = led_pattern_get(LED_PATTERN_DEV_MODE);
+
+    CHECK_EQ(d->end, LED_END_STATIC_ON);
+    CHECK_EQ(led_pattern_start(&st, d), 0);     // No timer
+    CHECK(st.level);                            // Held ON
+}
+
+static void test_halted(void) {
+    edge_t got[EDGES_MAX], want[EDGES_MAX];
+    bool ended;
+
+    int n_got = play(LED_PATTERN_HALTED_ENTRY, UINT64_MAX, got, &ended);
+    int n_want = HALTED_MAX_CYCLES * 2 - 1;     // Stops after the last OFF edge
+
+    expect(HALTED_BLINK_ON_US, HALTED_BLINK_OFF_US, HALTED_MAX_CYCLES, 0, UINT64_MAX, want);
+
+    CHECK(ended);
+    CHECK_EQ(n_got, HALTED_MAX_CYCLES * 2 - 1);
+    check_edges("HALTED", got, n_got, want, n_want);
+    CHECK(!got[n_got - 1].level);               // HOLD_OFF: left OFF
+    // "Total 2s": the pairs from the start, the last one ending on its OFF edge and
+    // its OFF phase held from there
+    CHECK_EQ(got[n_got - 1].t_us + HALTED_BLINK_OFF_US,
+             (uint64_t)HALTED_MAX_CYCLES * (HALTED_BLINK_ON_US + HALTED_BLINK_OFF_US));
+}
+
+static void test_table(void) {
+    for (int p = 0; p < LED_PATTERN_COUNT; p++) {
+        const led_pattern_desc_t *d = led_pattern_get((led_pattern_t)p);
+        CHECK(d != NULL && d->name != NULL);
+        if (d && d->end != LED_END_STATIC_ON) {
+            CHECK(d->timing.on_us > 0 && d->timing.off_us > 0);
+        }
+        if (d && d->end == LED_END_LOOP && d->cycles) {
+            CHECK(d->pause_us > 0);             // A burst needs its gap
+        }
+    }
+    CHECK(led_pattern_get(LED_PATTERN_COUNT) == NULL);
+    CHECK(led_pattern_get((led_pattern_t)-1) == NULL);
+}
+
+int main(void) {
+    test_table();
+    test_dev_mode();
+    test_looping(LED_PATTERN_OPERATIONAL, OPERATIONAL_BLINK_ON_US, OPERATIONAL_BLINK_OFF_US, 0, 0);
+    test_looping(LED_PATTERN_RTV_ACTIVE, RTV_BLINK_ON_US, RTV_BLINK_OFF_US, RTV_BURST_CYCLES,
+                 RTV_PAUSE_US);
+    test_looping(LED_PATTERN_TETHERED, TETHERED_BLINK_ON_US, TETHERED_BLINK_OFF_US, 0, 0);
+    test_looping(LED_PATTERN_UNTETHERED, UNTETHERED_BURST_ON_US, UNTETHERED_BURST_OFF_US,
+                 UNTETHERED_BURST_CYCLES, UNTETHERED_PAUSE_US);
+    test_looping(LED_PATTERN_TRANSFER_COMPLETE, TRANSFER_BLINK_ON_US, TRANSFER_BLINK_OFF_US, 0, 0);
+    test_halted();
+    return check_done("test_led_pattern");
+}
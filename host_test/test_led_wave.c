@@ -0,0 +1,192 @@
+// File: host_test/test_led_wave.c
+// ==========================================================================================
+// led_wave_encode(): long phases split at LED_WAVE_MAX_HALF_TICKS, the odd last half split
+// in two, the -1 / -2 returns, one-shot against looping bursts, and every blinking row of
+// the pattern table replayed from its symbols against the timer interpreter. Ticks are
+// 1 MHz like led_hw.c, so a tick is a microsecond; rows that do not fit its 48-symbol
+// RMT block (47 data symbols and the end marker) stay on the timer there, and are checked
+// here with a larger buffer.
+// ==========================================================================================
+
+#include "check.h"
+#include "led_wave.h"
+
+#define SYMS_MAX    512
+#define HW_SYMBOLS  47                          // LED_RMT_DATA_SYMBOLS in led_hw.c
+#define HALVES_MAX  (SYMS_MAX * 2)
+#define MHZ         1000000u
+
+typedef struct {
+    bool     level;
+    uint32_t ticks;
+} half_t;
+
+/** @brief Flatten symbols into halves, checking none is zero (that would end the TX). */
+static int halves_of(const led_wave_symbol_t *s, const led_wave_t *w, half_t *h) {
+    int n = 0;
+    for (size_t i = 0; i < w->count; i++) {
+        CHECK(s[i].duration0 > 0 && s[i].duration1 > 0);
+        h[n++] = (half_t){ s[i].level0, s[i].duration0 };
+        h[n++] = (half_t){ s[i].level1, s[i].duration1 };
+    }
+    return n;
+}
+
+/** @brief Merge runs of the same level back into phases. */
+static int phases_of(const half_t *h, int n, half_t *ph) {
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        if (m && ph[m - 1].level == h[i].level) {
+            ph[m - 1].ticks += h[i].ticks;
+        } else {
+            ph[m++] = h[i];
+        }
+    }
+    return m;
+}
+
+static led_pattern_desc_t blink(uint32_t on_us, uint32_t off_us) {
+    return (led_pattern_desc_t){ .name = "TEST", .timing = { on_us, off_us }, .end = LED_END_LOOP };
+}
+
+static void test_long_phase_split(void) {
+    led_wave_symbol_t s[SYMS_MAX];
+    half_t h[HALVES_MAX], ph[HALVES_MAX];
+    led_wave_t w;
+    led_pattern_desc_t d = blink(100000, 3 * LED_WAVE_MAX_HALF_TICKS + 1);  // Both > 1 half
+
+    CHECK_EQ(led_wave_encode(&d, MHZ, s, SYMS_MAX, &w), 0);
+    int n = halves_of(s, &w, h);
+    CHECK_EQ(n, 8);                             // ON: 3 full + 1699, OFF: 3 full + 1
+    for (int i = 0; i < 3; i++) {
+        CHECK(h[i].level && h[i].ticks == LED_WAVE_MAX_HALF_TICKS);
+        CHECK(!h[4 + i].level && h[4 + i].ticks == LED_WAVE_MAX_HALF_TICKS);
+    }
+    CHECK(h[3].level && h[3].ticks == 100000 - 3 * LED_WAVE_MAX_HALF_TICKS);
+    CHECK(!h[7].level && h[7].ticks == 1);
+
+    CHECK_EQ(phases_of(h, n, ph), 2);
+    CHECK_EQ(ph[0].ticks, 100000);
+    CHECK_EQ(ph[1].ticks, 3 * LED_WAVE_MAX_HALF_TICKS + 1);
+    CHECK(w.loop);
+}
+
+static void test_odd_half_split(void) {
+    led_wave_symbol_t s[SYMS_MAX];
+    half_t h[HALVES_MAX], ph[HALVES_MAX];
+    led_wave_t w;
+    led_pattern_desc_t d = blink(2 * LED_WAVE_MAX_HALF_TICKS, 1001);       // 2 + 1 halves
+
+    CHECK_EQ(led_wave_encode(&d, MHZ, s, SYMS_MAX, &w), 0);
+    CHECK_EQ(w.count, 2);
+    int n = halves_of(s, &w, h);
+    CHECK(!h[2].level && !h[3].level);          // The OFF half cut in two, level kept
+    CHECK_EQ(h[2].ticks, 501);
+    CHECK_EQ(h[3].ticks, 500);
+    CHECK_EQ(phases_of(h, n, ph), 2);
+    CHECK_EQ(ph[1].ticks, 1001);
+
+    // An odd last half of one tick cannot be split
+    led_pattern_desc_t tiny = blink(2 * LED_WAVE_MAX_HALF_TICKS, 1);
+    CHECK_EQ(led_wave_encode(&tiny, MHZ, s, SYMS_MAX, &w), -2);
+}
+
+static void test_errors(void) {
+    led_wave_symbol_t s[SYMS_MAX];
+    led_wave_t w = {0};
+    led_pattern_desc_t d = blink(1000, 1000);
+
+    CHECK_EQ(led_wave_encode(led_pattern_get(LED_PATTERN_DEV_MODE), MHZ, s, SYMS_MAX, &w), -1);
+    CHECK_EQ(led_wave_encode(&d, MHZ, s, 0, &w), -2);
+    CHECK_EQ(led_wave_encode(&d, MHZ, s, 1, &w), 0);        // Exactly one symbol
+    CHECK_EQ(w.count, 1);
+
+    led_pattern_desc_t burst = { .name = "B", .timing = { 1000, 1000 }, .pause_us = 5000,
+                                 .cycles = 10, .end = LED_END_LOOP };
+    CHECK_EQ(led_wave_encode(&burst, MHZ, s, 9, &w), -2);   // Needs 10
+    CHECK_EQ(led_wave_encode(&burst, MHZ, s, 10, &w), 0);
+    CHECK_EQ(w.count, 10);
+
+    led_pattern_desc_t zero = blink(0, 0);                  // Nothing to play
+    CHECK_EQ(led_wave_encode(&zero, MHZ, s, SYMS_MAX, &w), -2);
+}
+
+static void test_one_shot_vs_loop(void) {
+    led_wave_symbol_t s[SYMS_MAX];
+    half_t h[HALVES_MAX], ph[HALVES_MAX];
+    led_wave_t w;
+    led_pattern_desc_t d = { .name = "B", .timing = { 1000, 2000 }, .pause_us = 9000,
+                             .cycles = 3, .end = LED_END_LOOP };
+
+    CHECK_EQ(led_wave_encode(&d, MHZ, s, SYMS_MAX, &w), 0);
+    CHECK(w.loop);
+    int m = phases_of(h, halves_of(s, &w, h), ph);
+    CHECK_EQ(m, 6);
+    CHECK_EQ(ph[3].ticks, 2000);                // Inner OFF
+    CHECK_EQ(ph[5].ticks, 9000);                // The burst ends with its pause
+
+    d.end = LED_END_HOLD_OFF;                   // Same burst, played once
+    CHECK_EQ(led_wave_encode(&d, MHZ, s, SYMS_MAX, &w), 0);
+    CHECK(!w.loop);
+    m = phases_of(h, halves_of(s, &w, h), ph);
+    CHECK_EQ(m, 6);
+    CHECK_EQ(ph[5].ticks, 2000);                // Last OFF is a normal OFF, then held
+    CHECK(!ph[5].level);
+}
+
+/**
+ * @brief The symbols of every blinking table row give the interpreter's phases.
+ *
+ * Both start with the first ON phase: the delay of start() is the first phase, then one
+ * step() per phase.
+ */
+static void test_table_rows(void) {
+    for (int p = 0; p < LED_PATTERN_COUNT; p++) {
+        const led_pattern_desc_t *d = led_pattern_get((led_pattern_t)p);
+        led_wave_symbol_t s[SYMS_MAX];
+        half_t h[HALVES_MAX], ph[HALVES_MAX];
+        led_pattern_state_t st;
+        led_wave_t w;
+
+        int rc = led_wave_encode(d, MHZ, s, HW_SYMBOLS, &w);
+        if (d->end == LED_END_STATIC_ON) {
+            CHECK_EQ(rc, -1);
+            continue;
+        }
+        if (rc != 0) {
+            CHECK_EQ(rc, -2);                   // Too long for RMT: the timer plays it
+            CHECK_EQ(led_wave_encode(d, MHZ, s, SYMS_MAX, &w), 0);
+            CHECK(w.count > HW_SYMBOLS);
+            printf("%s: %u symbols, played by the timer\n", d->name, (unsigned)w.count);
+        }
+        CHECK_EQ(w.loop, d->end == LED_END_LOOP);
+        int m = phases_of(h, halves_of(s, &w, h), ph);
+
+        uint32_t delay = led_pattern_start(&st, d);
+        for (int i = 0; i < m; i++) {
+            if (i) {
+                delay = led_pattern_step(&st);
+            }
+            if (ph[i].level != st.level || (delay && ph[i].ticks != delay)) {
+                printf("%s: phase %d %s %u ticks, interpreter %s %u us\n", d->name, i,
+                       ph[i].level ? "ON" : "OFF", (unsigned)ph[i].ticks,
+                       st.level ? "ON" : "OFF", (unsigned)delay);
+                CHECK(false);
+                break;
+            }
+            if (!delay) {                       // HOLD_OFF: the last OFF edge ends it
+                CHECK_EQ(i, m - 1);
+                CHECK_EQ(ph[i].ticks, d->timing.off_us);
+            }
+        }
+    }
+}
+
+int main(void) {
+    test_long_phase_split();
+    test_odd_half_split();
+    test_errors();
+    test_one_shot_vs_loop();
+    test_table_rows();
+    return check_done("test_led_wave");
+}
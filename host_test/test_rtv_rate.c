@@ -0,0 +1,211 @@
+// File: host_test/test_rtv_rate.c
+// ==========================================================================================
+// The RTV rate controller (user-023) against synthetic windows: a viewer behind a link of
+// a given capacity, JPEG frames whose size follows the quality, and the send time and
+// backlog (frames replaced before the viewer took them) that follow from both. Checks
+// that congestion walks quality and then the frame rate down to rtv.jpeg_quality_min and
+// rtv.fps_min and holds there, that a recovered link brings both back to the maximum,
+// that a link in between settles without oscillating, and the idle / drop / bounds rules.
+// ==========================================================================================
+
+#include "check.h"
+#include "rtv_rate.h"
+
+#define WINDOW_US   (RTV_RATE_WINDOW_MS * 1000u)
+
+static const rtv_rate_limits_t limits = { .fps_min = 2, .fps_max = 15, .q_min = 20, .q_max = 80 };
+
+/** JPEG size of a 320x240 frame at quality q (roughly linear over the useful range). */
+static uint32_t frame_bytes(uint8_t q) {
+    return 4000u + 250u * q;
+}
+
+/**
+ * @brief One window at the controller's settings over a link of `bps` bytes/s: the viewer
+ *        sends what fits, the rest of the frames are replaced before it gets to them.
+ */
+static rtv_rate_sample_t window(const rtv_rate_t *r, uint32_t bps, uint8_t viewers) {
+    rtv_rate_sample_t s = { .window_us = WINDOW_US, .published = r->fps, .viewers = viewers };
+    uint64_t per_frame_us = (uint64_t)frame_bytes(r->quality) * 1000000u / (bps ? bps : 1);
+
+    if (viewers) {
+        s.sent = (uint32_t)(WINDOW_US / per_frame_us);
+        s.sent = s.sent < r->fps ? s.sent : r->fps;
+        s.skipped = r->fps - s.sent;
+        s.send_us = s.sent * per_frame_us;
+        if (s.skipped) {
+            s.send_us = WINDOW_US;              // Busy the whole window
+        }
+    }
+    return s;
+}
+
+/** Run `n` windows; returns the number of direction changes (DOWN after UP or back). */
+static unsigned run(rtv_rate_t *r, uint32_t bps, unsigned n) {
+    rtv_rate_action_t prev = RTV_RATE_HOLD;
+    unsigned flips = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        rtv_rate_sample_t s = window(r, bps, 1);
+        rtv_rate_action_t a = rtv_rate_update(r, &s);
+        if ((a == RTV_RATE_UP && prev == RTV_RATE_DOWN) || (a == RTV_RATE_DOWN && prev == RTV_RATE_UP)) {
+            flips++;
+        }
+        if (a == RTV_RATE_UP || a == RTV_RATE_DOWN) {
+            prev = a;
+        }
+    }
+    return flips;
+}
+
+static void test_congestion_and_recovery(void) {
+    rtv_rate_t r;
+
+    rtv_rate_init(&r, &limits);
+    CHECK_EQ(r.fps, limits.fps_max);
+    CHECK_EQ(r.quality, limits.q_max);
+
+    // A link that carries well under one frame per second at any quality: all the way down
+    run(&r, 5000, 30);
+    CHECK_EQ(r.fps, limits.fps_min);
+    CHECK_EQ(r.quality, limits.q_min);
+    uint32_t downs = r.downs;
+    CHECK(downs >= 2);
+    printf("  congested: fps %u q %u after %u steps down\n", (unsigned)r.fps,
+           (unsigned)r.quality, (unsigned)downs);
+
+    // ...and it stays there without trying to go lower or higher
+    run(&r, 5000, 20);
+    CHECK_EQ(r.fps, limits.fps_min);
+    CHECK_EQ(r.quality, limits.q_min);
+    CHECK_EQ(r.ups, 0);
+
+    // Link back: the frame rate first, then quality, to the maximum
+    uint8_t q_when_fps_max = 0;
+    for (int i = 0; i < 60; i++) {
+        rtv_rate_sample_t s = window(&r, 10000000, 1);
+        rtv_rate_update(&r, &s);
+        if (r.fps == limits.fps_max && !q_when_fps_max) {
+            q_when_fps_max = r.quality;
+        }
+    }
+    CHECK_EQ(r.fps, limits.fps_max);
+    CHECK_EQ(r.quality, limits.q_max);
+    CHECK_EQ(q_when_fps_max, limits.q_min);     // Rate recovered before quality moved
+    CHECK_EQ(r.downs, downs);
+    printf("  recovered: fps %u q %u after %u steps up\n", (unsigned)r.fps,
+           (unsigned)r.quality, (unsigned)r.ups);
+}
+
+static void test_settles(void) {
+    static const uint32_t links[] = { 60000, 100000, 150000, 250000 };
+
+    for (size_t i = 0; i < sizeof(links) / sizeof(links[0]); i++) {
+        rtv_rate_t r;
+        rtv_rate_init(&r, &limits);
+        run(&r, links[i], 30);                  // Converge
+        uint32_t ups = r.ups, downs = r.downs;
+        unsigned flips = run(&r, links[i], 100);
+        rtv_rate_sample_t s = window(&r, links[i], 1);
+
+        // Settled: what it sends fits the link, and it rarely probes upward again
+        CHECK(s.send_us <= WINDOW_US);
+        CHECK(r.ups - ups <= 10 && r.downs - downs <= 10);
+        CHECK(flips <= 5);
+        CHECK(r.fps >= limits.fps_min && r.fps <= limits.fps_max);
+        CHECK(r.quality >= limits.q_min && r.quality <= limits.q_max);
+        printf("  %4u KB/s: fps %2u q %2u | %u ups %u downs %u flips in 100 windows\n",
+               (unsigned)(links[i] / 1000), (unsigned)r.fps, (unsigned)r.quality,
+               (unsigned)(r.ups - ups), (unsigned)(r.downs - downs), flips);
+    }
+}
+
+static void test_backlog_and_drops(void) {
+    rtv_rate_t r;
+
+    // The viewer falls behind (frames replaced) although the send time looks fine
+    rtv_rate_init(&r, &limits);
+    rtv_rate_sample_t s = { .window_us = WINDOW_US, .published = 15, .viewers = 1, .sent = 10,
+                            .skipped = 5, .send_us = WINDOW_US / 4 };
+    CHECK_EQ(rtv_rate_update(&r, &s), RTV_RATE_DOWN);
+    CHECK_EQ(r.quality, limits.q_max - RTV_RATE_Q_STEP);
+    CHECK_EQ(r.fps, limits.fps_max);            // Quality goes first
+    CHECK_EQ(r.skip_pct, 33);
+
+    // Far behind (severe): quality and the rate at once, to what it took
+    s = (rtv_rate_sample_t){ .window_us = WINDOW_US, .published = 15, .viewers = 1, .sent = 3,
+                             .skipped = 12, .send_us = WINDOW_US };
+    CHECK_EQ(rtv_rate_update(&r, &s), RTV_RATE_DOWN);
+    CHECK_EQ(r.fps, 4);
+    CHECK_EQ(r.quality, limits.q_max - 2 * RTV_RATE_Q_STEP);
+
+    // Frames lost before publishing step down even with an idle link
+    rtv_rate_init(&r, &limits);
+    s = (rtv_rate_sample_t){ .window_us = WINDOW_US, .published = 14, .dropped = 1, .viewers = 1,
+                             .sent = 14 };
+    CHECK_EQ(rtv_rate_update(&r, &s), RTV_RATE_DOWN);
+    CHECK_EQ(r.dropped, 1);
+
+    // In the band (between the low and high load marks): hold
+    rtv_rate_init(&r, &limits);
+    r.fps = 8;
+    for (int i = 0; i < 10; i++) {
+        s = (rtv_rate_sample_t){ .window_us = WINDOW_US, .published = 8, .viewers = 1, .sent = 8,
+                                 .send_us = WINDOW_US * 7 / 10 };
+        CHECK_EQ(rtv_rate_update(&r, &s), RTV_RATE_HOLD);
+    }
+    CHECK_EQ(r.fps, 8);
+}
+
+static void test_idle(void) {
+    rtv_rate_t r;
+    rtv_rate_sample_t s;
+
+    rtv_rate_init(&r, &limits);
+    run(&r, 120000, 20);
+    uint8_t fps = r.fps, q = r.quality;
+    CHECK(fps < limits.fps_max);
+
+    // Nobody watching: minimum rate, for as long as that lasts
+    for (int i = 0; i < 5; i++) {
+        s = window(&r, 120000, 0);
+        CHECK_EQ(rtv_rate_update(&r, &s), RTV_RATE_IDLE);
+        CHECK_EQ(r.fps, limits.fps_min);
+    }
+    // A viewer: back to where it was, without judging the idle-rate window
+    s = window(&r, 120000, 1);
+    CHECK_EQ(rtv_rate_update(&r, &s), RTV_RATE_UP);
+    CHECK_EQ(r.fps, fps);
+    CHECK_EQ(r.quality, q);
+
+    // An empty window changes nothing
+    s = (rtv_rate_sample_t){ .viewers = 1 };
+    CHECK_EQ(rtv_rate_update(&r, &s), RTV_RATE_HOLD);
+    CHECK_EQ(r.fps, fps);
+}
+
+static void test_bounds(void) {
+    rtv_rate_t r;
+    rtv_rate_limits_t lim = { .fps_min = 0, .fps_max = 0, .q_min = 90, .q_max = 10 };
+
+    rtv_rate_init(&r, &lim);
+    CHECK_EQ(r.lim.fps_min, 1);
+    CHECK_EQ(r.lim.fps_max, 1);
+    CHECK_EQ(r.lim.q_max, 90);
+    CHECK_EQ(r.fps, 1);
+    CHECK_EQ(r.quality, 90);
+    run(&r, 1000, 10);                          // Nothing to give up
+    CHECK_EQ(r.fps, 1);
+    CHECK_EQ(r.quality, 90);
+    CHECK_EQ(r.downs, 0);
+    CHECK(rtv_rate_action_str(RTV_RATE_COUNT)[0] == '?');
+}
+
+int main(void) {
+    test_congestion_and_recovery();
+    test_settles();
+    test_backlog_and_drops();
+    test_idle();
+    test_bounds();
+    return check_done("test_rtv_rate");
+}
@@ -0,0 +1,171 @@
+// File: host_test/test_tlog.c
+// ==========================================================================================
+// Tokenized logging round trip: the TLOGx calls below go through tlog_emit() and
+// tlog_vencode() into a log file, tools/tlog_dict.py builds the dictionary from this source
+// (a CMake step, as in the firmware build), and tools/tlog_decode.py must give back the
+// text printf would have produced, under the tag of each call. Covers every argument type
+// (pointers with all their bits), a tag the dictionary cannot know, and the cuts.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "check.h"
+#include "tlog.h"
+
+#ifndef TLOG_DICT
+#define TLOG_DICT       "test_tlog_dict.json"
+#endif
+
+#define CASES_MAX       16
+
+static const char *TAG = "TLOG_TEST";
+static const char *OTHER = "OTHER_MODULE";                  // Not in the dictionary
+static const char *LONG_TAG = "A_VERY_LONG_MODULE_NAME";    // Cut to TLOG_TAG_MAX
+
+static char expect[CASES_MAX][160];
+static int n_cases;
+
+/** Expected decoder output of the next record, without its timestamp. */
+__attribute__((format(printf, 3, 4)))
+static void expect_line(char level, const char *tag, const char *fmt, ...) {
+    va_list args;
+    int n = snprintf(expect[n_cases], sizeof(expect[0]), "%c %s: ", level, tag);
+
+    va_start(args, fmt);
+    vsnprintf(expect[n_cases] + n, sizeof(expect[0]) - (size_t)n, fmt, args);
+    va_end(args);
+    n_cases++;
+}
+
+static size_t encode(uint8_t *out, size_t cap, uint32_t types, ...) {
+    va_list args;
+
+    va_start(args, types);
+    size_t n = tlog_vencode(out, cap, ESP_LOG_INFO, TAG, 0x12345678u, 1000, types, args);
+    va_end(args);
+    return n;
+}
+
+static void test_types(void) {
+    CHECK_EQ(TLOG_TYPES(), 0);
+    CHECK_EQ(TLOG_TYPES(1, 2LL, 1.0, "s", (void *)0), 5u | (TLOG_ARG_INT << 4) |
+             (TLOG_ARG_INT64 << 7) | (TLOG_ARG_DOUBLE << 10) | (TLOG_ARG_STRING << 13) |
+             (TLOG_ARG_PTR << 16));
+    uint8_t *p = NULL;
+    CHECK_EQ(TLOG_ARG_TYPE(p), sizeof(p) > sizeof(int) ? TLOG_ARG_PTR : TLOG_ARG_INT);
+
+    // Header and tag first; no room for them: nothing
+    uint8_t rec[TLOG_RECORD_MAX];
+    CHECK_EQ(encode(rec, 5 + 5 + TLOG_TAG_MAX, TLOG_TYPES()), 0);
+    size_t n = encode(rec, sizeof(rec), TLOG_TYPES(-1, (void *)p), -1, (void *)p);
+    CHECK_EQ(n, 1 + 4 + 2 + 1 + strlen(TAG) + 1 + 1);
+    CHECK_EQ(rec[7], strlen(TAG));
+    CHECK(memcmp(&rec[8], TAG, strlen(TAG)) == 0);
+    CHECK_EQ(rec[n - 2], 1);                    // zigzag(-1)
+    CHECK_EQ(rec[n - 1], 0);                    // NULL
+}
+
+/** Log every case to `path`, noting what the decoder must print for it. */
+static void emit_cases(const char *path) {
+    static const char long_str[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    static int object;
+    void *heap_like = (void *)(uintptr_t)(sizeof(void *) > 4 ? 0x7ffd12345678ull : 0x3fc88000u);
+
+    host_log_sink = fopen(path, "w");
+    if (!host_log_sink) {
+        CHECK(host_log_sink != NULL);
+        return;
+    }
+    fprintf(host_log_sink, "plain line, passed through\n");
+
+    TLOGI(TAG, "plain text");
+    expect_line('I', TAG, "plain text");
+    TLOGI(TAG, "int %d unsigned %u hex %x", -5, 4000000000u, 0xBEEFu);
+    expect_line('I', TAG, "int %d unsigned %u hex %x", -5, 4000000000u, 0xBEEFu);
+    TLOGW(TAG, "long long %lld %llu", -1234567890123LL, 18446744073709551615ULL);
+    expect_line('W', TAG, "long long %lld %llu", -1234567890123LL, 18446744073709551615ULL);
+    TLOGI(TAG, "float %.2f %g", 1.5, -0.25f);
+    expect_line('I', TAG, "float %.2f %g", 1.5, -0.25f);
+    TLOGE(TAG, "str '%s' char %c", "hello", 'x');
+    expect_line('E', TAG, "str '%s' char %c", "hello", 'x');
+
+    // Pointers keep every bit of the address: void *, another pointer type, an object
+    TLOGI(TAG, "ptr %p", heap_like);
+    expect_line('I', TAG, "ptr 0x%08llx", (unsigned long long)(uintptr_t)heap_like);
+    TLOGI(TAG, "object %p", &object);
+    expect_line('I', TAG, "object 0x%08llx", (unsigned long long)(uintptr_t)&object);
+    // A 32-bit target's address goes out as an int: sign-extended, read back as 32 bits
+    TLOGI(TAG, "target %p", (int32_t)0xBFC00000u);
+    expect_line('I', TAG, "target 0x%08x", 0xBFC00000u);
+
+    // The tag comes from the record, not from the dictionary (which has TAG for this file)
+    TLOGI(OTHER, "plain text");
+    expect_line('I', OTHER, "plain text");
+    char cut_tag[TLOG_TAG_MAX + 1];
+    snprintf(cut_tag, sizeof(cut_tag), "%.*s", TLOG_TAG_MAX, LONG_TAG);
+    TLOGW(LONG_TAG, "tag cut");
+    expect_line('W', cut_tag, "tag cut");
+
+    // A %s keeps TLOG_STRING_MAX bytes; arguments past the record size are dropped
+    TLOGI(TAG, "cut %s", long_str);
+    expect_line('I', TAG, "cut %.*s", TLOG_STRING_MAX, long_str);
+    TLOGI(TAG, "full %s %s %s", long_str, long_str, long_str);
+    expect_line('I', TAG, "full %.*s <?> <?> <truncated>", TLOG_STRING_MAX, long_str);
+
+    fclose(host_log_sink);
+    host_log_sink = NULL;
+}
+
+/** Decoded line without its "(timestamp) ". */
+static void strip_timestamp(char *line) {
+    char *open = strchr(line, '(');
+    char *close = open ? strstr(open, ") ") : NULL;
+    if (open && close) {
+        memmove(open, close + 2, strlen(close + 2) + 1);
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+}
+
+static void test_round_trip(void) {
+    char path[] = "/tmp/test_tlog_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    close(fd);
+    emit_cases(path);
+
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "\"%s\" \"%s\" -d \"%s\" \"%s\"", PYTHON, TLOG_DECODE, TLOG_DICT,
+             path);
+    FILE *p = popen(cmd, "r");
+    CHECK(p != NULL);
+    if (!p) {
+        unlink(path);
+        return;
+    }
+
+    char line[256];
+    int i = 0, mismatched = 0;
+    CHECK(fgets(line, sizeof(line), p) && strcmp(line, "plain line, passed through\n") == 0);
+    while (fgets(line, sizeof(line), p)) {
+        printf("  %s", line);
+        strip_timestamp(line);
+        if (i >= n_cases || strcmp(line, expect[i]) != 0) {
+            printf("    expected: %s\n", i < n_cases ? expect[i] : "(no more lines)");
+            mismatched++;
+        }
+        i++;
+    }
+    CHECK_EQ(pclose(p), 0);
+    CHECK_EQ(i, n_cases);
+    CHECK_EQ(mismatched, 0);
+    unlink(path);
+}
+
+int main(void) {
+    test_types();
+    test_round_trip();
+    return check_done("test_tlog");
+}
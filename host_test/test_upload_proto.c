@@ -0,0 +1,363 @@
+// File: host_test/test_upload_proto.c
+// ==========================================================================================
+// upload_run() against a fake HTTP link: an in-memory server that decodes the chunked body,
+// keeps each file at the offset it has (appending a record only there, like
+// tools/upload_server.py) and answers "<file> <have> <part|ok>" lines, on a virtual clock.
+// Faults are switched per test:
+//   - clean session, several batches, every byte checked and the cursor checkpointed;
+//   - rewind: the server loses a file's tail mid-session, the uploader follows it back;
+//   - link drops below and beyond p.retries (UPLOAD_ERR_LINK, the cursor kept);
+//   - no progress: 200 answers that keep nothing, or leave every record out. Counted as
+//     failures with backoff, so the session ends after p.retries instead of looping;
+//   - a single stalled answer in the middle does not end the session.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include "check.h"
+#include "upload_proto.h"
+
+#define FILES           5
+#define CHUNK           1024
+#define BATCH           (16 * 1024)
+#define BODY_MAX        (2 * BATCH + 4096)
+#define POST_LIMIT      1000        // Far more than any session below needs
+
+static const uint32_t sizes[FILES] = { 3000, 70000, 10, 41000, 5000 };
+
+// === Source ===
+
+typedef struct {
+    uint8_t *data[FILES];
+    uint8_t  next;
+} src_t;
+
+static src_t files;
+
+static bool src_next(void *ctx, xfer_file_t *out) {
+    src_t *s = ctx;
+
+    if (s->next >= FILES) {
+        return false;
+    }
+    *out = (xfer_file_t){ .id = 100u + s->next, .size = sizes[s->next], .tag = 0x5eed0000u + s->next };
+    s->next++;
+    return true;
+}
+
+static bool src_read(void *ctx, const xfer_file_t *f, uint32_t offset, uint8_t *buf, size_t len) {
+    src_t *s = ctx;
+    uint32_t i = f->id - 100u;
+
+    if (i >= FILES || offset + len > sizes[i]) {
+        return false;
+    }
+    memcpy(buf, s->data[i] + offset, len);
+    return true;
+}
+
+static const xfer_source_t source = { .ctx = &files, .next = src_next, .read = src_read };
+
+// === Fake server ===
+
+typedef enum {
+    FAULT_NONE,
+    FAULT_DROP,                     ///< No answer (connection lost)
+    FAULT_KEEP_NOTHING,             ///< 200, every record answered at its old offset
+    FAULT_OMIT,                     ///< 200 with an empty body
+} fault_t;
+
+typedef struct {
+    uint8_t  copy[FILES][70000];
+    uint32_t have[FILES];
+    uint8_t  body[BODY_MAX];
+    size_t   body_len;
+    bool     overflow;
+    fault_t  fault;
+    unsigned fault_posts;           ///< POSTs left to answer with `fault`
+    int      lose_file;             ///< >= 0: after this POST, cut that file back...
+    uint32_t lose_to;               ///< ...to this many bytes
+    unsigned posts, begins, resets, checkpoints;
+    uint32_t now;
+    upload_cursor_t last_cp;
+    bool     cp_backwards;
+} server_t;
+
+static server_t srv;
+
+static bool link_begin(void *ctx) {
+    server_t *s = ctx;
+
+    s->begins++;
+    s->body_len = 0;
+    s->overflow = false;
+    return s->posts < POST_LIMIT;
+}
+
+static bool link_write(void *ctx, const uint8_t *data, size_t len) {
+    server_t *s = ctx;
+
+    if (s->body_len + len > sizeof(s->body)) {
+        s->overflow = true;
+        return false;
+    }
+    memcpy(s->body + s->body_len, data, len);
+    s->body_len += len;
+    s->now += 1;
+    return true;
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/** Undo the chunk framing in place; returns the payload length, or -1 if malformed. */
+static long dechunk(uint8_t *b, size_t n) {
+    size_t in = 0, out = 0;
+
+    for (;;) {
+        char *end;
+        unsigned long len = strtoul((const char *)b + in, &end, 16);
+        in = (size_t)((uint8_t *)end - b);
+        if (in + 2 > n || memcmp(b + in, "\r\n", 2) != 0) {
+            return -1;
+        }
+        in += 2;
+        if (len == 0) {
+            return in + 2 == n && memcmp(b + in, "\r\n", 2) == 0 ? (long)out : -1;
+        }
+        if (in + len + 2 > n || memcmp(b + in + len, "\r\n", 2) != 0) {
+            return -1;
+        }
+        memmove(b + out, b + in, len);
+        out += len;
+        in += len + 2;
+    }
+}
+
+static int link_finish(void *ctx, char *body, size_t cap) {
+    server_t *s = ctx;
+    fault_t fault = s->fault_posts ? s->fault : FAULT_NONE;
+    long n = s->overflow ? -1 : dechunk(s->body, s->body_len);
+    size_t pos = 0, out = 0;
+
+    s->now += 20;
+    s->fault_posts -= s->fault_posts > 0;
+    body[0] = '\0';
+    if (fault == FAULT_DROP) {
+        return -1;
+    }
+    s->posts++;
+    if (n < 0) {
+        return 400;
+    }
+    while (pos + UPLOAD_REC_HDR <= (size_t)n && fault != FAULT_OMIT) {
+        const uint8_t *h = s->body + pos;
+        uint32_t id = get32(h + 4) - 100u, off = get32(h + 16), len = get32(h + 20);
+        if (get32(h) != UPLOAD_MAGIC || id >= FILES || get32(h + 8) != sizes[id] ||
+            pos + UPLOAD_REC_HDR + len > (size_t)n) {
+            return 400;
+        }
+        if (off == s->have[id] && fault != FAULT_KEEP_NOTHING) {
+            memcpy(s->copy[id] + off, h + UPLOAD_REC_HDR, len);
+            s->have[id] += len;
+        }
+        out += (size_t)snprintf(body + out, cap - out, "%u %u %s\n", (unsigned)(id + 100u),
+                                (unsigned)s->have[id], s->have[id] == sizes[id] ? "ok" : "part");
+        pos += UPLOAD_REC_HDR + len;
+    }
+    if (s->lose_file >= 0 && s->have[s->lose_file] > s->lose_to) {
+        s->have[s->lose_file] = s->lose_to;     // Restarted without its last appends
+        s->lose_file = -1;
+    }
+    return 200;
+}
+
+static void link_reset(void *ctx) {
+    ((server_t *)ctx)->resets++;
+}
+
+static uint32_t link_now(void *ctx) {
+    return ((server_t *)ctx)->now;
+}
+
+static void link_sleep(void *ctx, uint32_t ms) {
+    ((server_t *)ctx)->now += ms;
+}
+
+static void link_checkpoint(void *ctx, const upload_cursor_t *c) {
+    server_t *s = ctx;
+
+    s->checkpoints++;
+    s->cp_backwards |= c->seg_id < s->last_cp.seg_id;
+    s->last_cp = *c;
+}
+
+static const upload_link_t link = {
+    .ctx = &srv, .begin = link_begin, .write = link_write, .finish = link_finish,
+    .reset = link_reset, .now_ms = link_now, .sleep_ms = link_sleep,
+    .checkpoint = link_checkpoint,
+};
+
+// === Harness ===
+
+static upload_t up;
+static uint8_t buf[UPLOAD_BUF_SIZE(CHUNK)];
+static const upload_params_t params = { .chunk = CHUNK, .batch = BATCH, .retries = 3 };
+
+static void server_fresh(void) {
+    memset(srv.have, 0, sizeof(srv.have));
+    srv.fault = FAULT_NONE;
+    srv.fault_posts = 0;
+    srv.lose_file = -1;
+    srv.posts = srv.begins = srv.resets = srv.checkpoints = 0;
+    srv.last_cp = (upload_cursor_t){ 0 };
+    srv.cp_backwards = false;
+}
+
+static upload_result_t run(upload_cursor_t *cursor) {
+    files.next = (uint8_t)(cursor->seg_id > 100u ? cursor->seg_id - 100u : 0);
+    return upload_run(&up, &params, &link, &source, cursor, buf);
+}
+
+static bool server_has_everything(void) {
+    for (int i = 0; i < FILES; i++) {
+        if (srv.have[i] != sizes[i] || memcmp(srv.copy[i], files.data[i], sizes[i]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// === Tests ===
+
+static void test_clean(void) {
+    upload_cursor_t c = { .seg_id = 100 };
+    uint32_t total = 0;
+
+    server_fresh();
+    for (int i = 0; i < FILES; i++) {
+        total += sizes[i];
+    }
+    CHECK_EQ(run(&c), UPLOAD_OK);
+    CHECK(server_has_everything());
+    CHECK_EQ(c.seg_id, 100 + FILES);
+    CHECK_EQ(up.stats.files, FILES);
+    CHECK_EQ(up.stats.bytes, total);
+    CHECK_EQ(up.stats.requests, (total + BATCH - 1) / BATCH);
+    CHECK_EQ(up.stats.failures, 0);
+    CHECK_EQ(up.stats.rewinds, 0);
+    CHECK_EQ(srv.checkpoints, up.stats.requests);
+    CHECK(!srv.cp_backwards);
+    CHECK_EQ(srv.last_cp.seg_id, c.seg_id);
+
+    // Nothing new: no POST at all
+    unsigned posts = srv.posts;
+    CHECK_EQ(run(&c), UPLOAD_OK);
+    CHECK_EQ(srv.posts, posts);
+}
+
+static void test_rewind(void) {
+    upload_cursor_t c = { .seg_id = 100 };
+
+    server_fresh();
+    srv.lose_file = 1;              // After the first POST that leaves file 1 past 20000
+    srv.lose_to = 20000;
+    CHECK_EQ(run(&c), UPLOAD_OK);
+    CHECK(server_has_everything());
+    CHECK(up.stats.rewinds >= 1);
+    CHECK_EQ(up.stats.failures, 0);
+    CHECK_EQ(up.stats.stalls, 0);
+    printf("  rewind: %u requests, %u rewinds\n", (unsigned)up.stats.requests,
+           (unsigned)up.stats.rewinds);
+
+    // A restarted session from a cursor past what the server has follows it back, too
+    memset(srv.have, 0, sizeof(srv.have));
+    srv.have[0] = sizes[0];
+    srv.have[1] = 12000;
+    c = (upload_cursor_t){ .seg_id = 101, .offset = 50000, .tag = 0x5eed0001u };
+    CHECK_EQ(run(&c), UPLOAD_OK);
+    CHECK(server_has_everything());
+    CHECK_EQ(up.stats.bytes, 70000 - 12000 + sizes[2] + sizes[3] + sizes[4]);
+}
+
+static void test_link_retries(void) {
+    upload_cursor_t c = { .seg_id = 100 };
+
+    // Fewer drops in a row than retries: completes, each drop backed off and reconnected
+    server_fresh();
+    srv.fault = FAULT_DROP;
+    srv.fault_posts = params.retries;
+    CHECK_EQ(run(&c), UPLOAD_OK);
+    CHECK(server_has_everything());
+    CHECK_EQ(up.stats.failures, params.retries);
+    CHECK_EQ(srv.resets, params.retries);
+    CHECK(up.stats.backoff_ms >= params.retries * UPLOAD_BACKOFF_MIN_MS / 2);
+
+    // One more than the retries: gives up with the cursor where the server is
+    server_fresh();
+    c = (upload_cursor_t){ .seg_id = 100 };
+    srv.fault = FAULT_DROP;
+    srv.fault_posts = 1000;
+    CHECK_EQ(run(&c), UPLOAD_ERR_LINK);
+    CHECK_EQ(up.stats.failures, params.retries + 1u);
+    CHECK_EQ(up.stats.requests, 0);
+    CHECK_EQ(c.seg_id, 100);
+    CHECK_EQ(c.offset, 0);
+}
+
+static void test_no_progress(void) {
+    static const fault_t faults[] = { FAULT_KEEP_NOTHING, FAULT_OMIT };
+
+    for (int k = 0; k < 2; k++) {
+        // The server answers 200 forever without taking anything
+        upload_cursor_t c = { .seg_id = 100 };
+        server_fresh();
+        srv.fault = faults[k];
+        srv.fault_posts = 1000;
+        srv.have[0] = 1000;             // Ahead of the cursor: the first answer moves it
+        upload_result_t r = run(&c);
+        unsigned moved = faults[k] == FAULT_KEEP_NOTHING;
+        CHECK_EQ(r, UPLOAD_ERR_SERVER);
+        CHECK(srv.posts < POST_LIMIT);
+        CHECK_EQ(up.stats.requests, params.retries + 1u + moved);
+        CHECK_EQ(up.stats.stalls, params.retries + 1u);
+        CHECK_EQ(up.stats.failures, params.retries + 1u);
+        CHECK(up.stats.backoff_ms >= params.retries * UPLOAD_BACKOFF_MIN_MS / 2);
+        CHECK_EQ(srv.resets, 0);        // The connection itself was fine
+        CHECK_EQ(c.offset, moved ? 1000 : 0);
+        CHECK(up.stats.rewinds >= up.stats.requests);
+        printf("  no progress (%s): gave up after %u POSTs, %u ms backing off\n",
+               faults[k] == FAULT_OMIT ? "empty answer" : "kept nothing",
+               (unsigned)up.stats.requests, (unsigned)up.stats.backoff_ms);
+    }
+
+    // One stalled answer mid-session is retried and the session completes
+    upload_cursor_t c = { .seg_id = 100 };
+    server_fresh();
+    srv.fault = FAULT_KEEP_NOTHING;
+    srv.fault_posts = 1;
+    CHECK_EQ(run(&c), UPLOAD_OK);
+    CHECK(server_has_everything());
+    CHECK_EQ(up.stats.stalls, 1);
+    CHECK_EQ(up.stats.failures, 1);
+}
+
+int main(void) {
+    uint32_t rs = 99;
+
+    for (int i = 0; i < FILES; i++) {
+        files.data[i] = malloc(sizes[i]);
+        for (uint32_t j = 0; j < sizes[i]; j++) {
+            rs = rs * 1103515245u + 12345u;
+            files.data[i][j] = (uint8_t)(rs >> 16);
+        }
+    }
+    test_clean();
+    test_rewind();
+    test_link_retries();
+    test_no_progress();
+    for (int i = 0; i < FILES; i++) {
+        free(files.data[i]);
+    }
+    return check_done("test_upload_proto");
+}
@@ -0,0 +1,259 @@
+// File: host_test/test_wifi_cache.c
+// ==========================================================================================
+// The reconnect policy of wifi_cache.c against a simulated radio: APs with a BSSID, channel,
+// RSSI and SSID that can move, disappear or refuse the password, and a virtual clock that
+// scans and joins advance (SCAN_MS per channel, then association and DHCP). Covers the
+// DIRECTED -> CHANNELS -> FULL fallback, invalidation (SSID change, WIFI_CACHE_MAX_FAILS
+// misses), the CLI scan feeding the cache, the time budget, and that the persisted blob
+// only changes when the AP, its channel or the fail count do.
+// ==========================================================================================
+
+#include "check.h"
+#include "wifi_cache.h"
+
+#define ALL_CHANNELS    13
+#define SCAN_MS         120         // Per channel scanned
+#define ASSOC_MS        500         // Authentication, association and 4-way handshake
+#define DHCP_MS         300
+#define TIMEOUT_MS      15000       // wifi_sta_connect() from the CLI and the upload
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    bool    ours;                   ///< Broadcasts our SSID
+    bool    up;
+    int8_t  rssi;
+} sim_ap_t;
+
+typedef struct {
+    sim_ap_t ap[4];
+    int      n;
+    bool     auth_ok;               ///< false: wrong password, every join times out
+    uint32_t now;
+    unsigned scans, joins;
+    uint32_t first_join_ms;         ///< Budget of the first join since it was cleared
+} sim_t;
+
+static sim_t sim;
+
+// === Simulated backend ===
+
+static bool sim_scan(void *ctx, const uint8_t *channels, uint8_t n, wifi_ap_t *best) {
+    sim_t *s = ctx;
+    bool found = false;
+
+    s->scans++;
+    s->now += SCAN_MS * (n ? n : ALL_CHANNELS);
+    for (int i = 0; i < s->n; i++) {
+        const sim_ap_t *a = &s->ap[i];
+        bool listed = n == 0;
+        for (uint8_t c = 0; c < n; c++) {
+            listed |= channels[c] == a->channel;
+        }
+        if (a->up && a->ours && listed && (!found || a->rssi > best->rssi)) {
+            memcpy(best->bssid, a->bssid, sizeof(best->bssid));
+            best->channel = a->channel;
+            best->rssi = a->rssi;
+            found = true;
+        }
+    }
+    return found;
+}
+
+/** Probe on the given channel first, then all of them; associate, handshake, DHCP. */
+static bool sim_join(void *ctx, wifi_ap_t *ap, uint32_t timeout_ms) {
+    sim_t *s = ctx;
+
+    s->joins++;
+    if (!s->first_join_ms) {
+        s->first_join_ms = timeout_ms;
+    }
+    for (int i = 0; i < s->n; i++) {
+        const sim_ap_t *a = &s->ap[i];
+        if (!a->up || memcmp(a->bssid, ap->bssid, sizeof(a->bssid)) != 0) {
+            continue;
+        }
+        uint32_t cost = (a->channel == ap->channel ? SCAN_MS : SCAN_MS * ALL_CHANNELS) +
+                        ASSOC_MS + DHCP_MS;
+        if (!s->auth_ok || cost > timeout_ms) {
+            s->now += timeout_ms;
+            return false;
+        }
+        s->now += cost;
+        ap->channel = a->channel;
+        ap->rssi = a->rssi;
+        return true;
+    }
+    uint32_t miss = SCAN_MS * ALL_CHANNELS;     // Probed everywhere, then NO_AP_FOUND
+    s->now += miss < timeout_ms ? miss : timeout_ms;
+    return false;
+}
+
+static uint32_t sim_now(void *ctx) {
+    return ((sim_t *)ctx)->now;
+}
+
+static const wifi_backend_t backend = { .ctx = &sim, .scan = sim_scan, .join = sim_join,
+                                        .now_ms = sim_now };
+static const uint8_t channels[] = { 1, 6, 11 };     // wifi.channels
+
+static wifi_cache_t cache;
+static wifi_connect_stats_t stats;
+static uint32_t ssid;
+static unsigned writes;             ///< Blob changes: NVS writes the caller would make
+
+static wifi_path_t connect(uint32_t timeout_ms) {
+    wifi_cache_t before = cache;
+    wifi_path_t p = wifi_cache_connect(&cache, &stats, &backend, ssid, channels,
+                                       sizeof(channels), timeout_ms, NULL);
+
+    writes += memcmp(&before, &cache, sizeof(cache)) != 0;
+    return p;
+}
+
+// === Tests ===
+
+static void test_cold_and_warm(void) {
+    CHECK(!wifi_cache_valid(&cache, ssid));
+
+    // Cold: the channel list finds ours (the stronger AP on channel 1 is another network)
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_CHANNELS);
+    CHECK(wifi_cache_valid(&cache, ssid));
+    CHECK_EQ(cache.channel, 6);
+    CHECK_EQ(cache.bssid[0], 0x10);
+    CHECK_EQ(writes, 1);
+    uint32_t cold_ms = stats.last_ms;
+
+    // Warm: directed, no scan and no rewrite of the blob
+    for (int i = 0; i < 5; i++) {
+        CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_DIRECTED);
+    }
+    CHECK_EQ(sim.scans, 1);
+    CHECK_EQ(writes, 1);
+    CHECK(stats.last_ms < cold_ms);
+    CHECK_EQ(stats.path[WIFI_PATH_DIRECTED].ok, 5);
+    CHECK_EQ(stats.path[WIFI_PATH_DIRECTED].max_ms, SCAN_MS + ASSOC_MS + DHCP_MS);
+    printf("  cold %u ms (channels), warm %u ms (directed)\n", (unsigned)cold_ms,
+           (unsigned)stats.last_ms);
+}
+
+static void test_fallback(void) {
+    // Same AP on another channel: the directed join still finds it, the channel is updated
+    sim.ap[0].channel = 11;
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_DIRECTED);
+    CHECK_EQ(cache.channel, 11);
+    CHECK_EQ(writes, 2);
+
+    // AP replaced by another one on a channel outside the list: CHANNELS finds none, FULL
+    sim.ap[0].up = false;
+    sim.ap[2] = (sim_ap_t){ { 0x30, 2, 3, 4, 5, 6 }, 3, true, true, -60 };
+    sim.n = 3;
+    unsigned tries = stats.path[WIFI_PATH_CHANNELS].tries;
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_FULL);
+    CHECK_EQ(stats.path[WIFI_PATH_CHANNELS].tries, tries + 1);
+    CHECK_EQ(cache.bssid[0], 0x30);
+    CHECK_EQ(cache.channel, 3);
+    CHECK_EQ(cache.fails, 0);
+    printf("  replaced AP %u ms (full)\n", (unsigned)stats.last_ms);
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_DIRECTED);
+
+    // Wrong password: the channel scan sees the AP, so no full scan after its join fails
+    sim.auth_ok = false;
+    sim.ap[2].channel = 6;
+    tries = stats.path[WIFI_PATH_FULL].tries;
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_NONE);
+    CHECK_EQ(stats.path[WIFI_PATH_FULL].tries, tries);
+    CHECK_EQ(cache.fails, 1);
+    sim.auth_ok = true;
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_DIRECTED);
+    CHECK_EQ(cache.fails, 0);
+}
+
+static void test_invalidation(void) {
+    // Another SSID in the config: the entry is not used
+    CHECK(!wifi_cache_valid(&cache, wifi_cache_ssid_hash("Other")));
+
+    // Network gone: WIFI_CACHE_MAX_FAILS directed misses drop the entry
+    sim.ap[2].up = false;
+    unsigned failures = stats.failures;
+    for (int i = 0; i < WIFI_CACHE_MAX_FAILS; i++) {
+        CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_NONE);
+    }
+    CHECK(!wifi_cache_valid(&cache, ssid));
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(stats.failures, failures + WIFI_CACHE_MAX_FAILS);
+    unsigned tries = stats.path[WIFI_PATH_DIRECTED].tries;
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_NONE);
+    CHECK_EQ(stats.path[WIFI_PATH_DIRECTED].tries, tries);     // No directed try left
+
+    // Back: a scan learns it again; so does a CLI scan after a forget
+    sim.ap[2].up = true;
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_CHANNELS);
+    CHECK(wifi_cache_valid(&cache, ssid));
+    wifi_cache_forget(&cache);
+    wifi_ap_t seen;
+    CHECK(wifi_cache_scan(&cache, &stats, &backend, ssid, NULL, 0, &seen));
+    CHECK(wifi_cache_valid(&cache, ssid));
+    CHECK_EQ(seen.channel, 6);
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_DIRECTED);
+}
+
+static void test_budget(void) {
+    // A short budget ends after the directed miss: no scan is started
+    sim.ap[2].up = false;
+    unsigned scans = stats.scans;
+    CHECK_EQ(connect(1500), WIFI_PATH_NONE);
+    CHECK_EQ(stats.scans, scans);
+    CHECK(stats.last_ms <= 1500);
+
+    // The directed join gets WIFI_CACHE_DIRECTED_MS of a long budget, the scan the rest
+    sim.ap[2].up = true;
+    sim.auth_ok = false;
+    sim.first_join_ms = 0;
+    CHECK_EQ(connect(TIMEOUT_MS), WIFI_PATH_NONE);
+    CHECK_EQ(sim.first_join_ms, WIFI_CACHE_DIRECTED_MS);
+    CHECK_EQ(stats.last_ms, TIMEOUT_MS);
+    sim.auth_ok = true;
+}
+
+static void test_stats(void) {
+    unsigned ok = 0, tries = 0;
+
+    for (int p = 0; p < WIFI_PATH_COUNT; p++) {
+        const wifi_path_stats_t *s = &stats.path[p];
+        CHECK(s->ok <= s->tries);
+        CHECK(s->ok == 0 || (s->min_ms <= s->max_ms && s->total_ms >= s->ok * s->min_ms));
+        ok += s->ok;
+        tries += s->tries;
+        printf("  %-8s %3u tries %3u ok  avg %5u ms  min %5u  max %5u\n",
+               wifi_path_str((wifi_path_t)p), (unsigned)s->tries, (unsigned)s->ok,
+               s->ok ? (unsigned)(s->total_ms / s->ok) : 0, (unsigned)s->min_ms,
+               (unsigned)s->max_ms);
+    }
+    CHECK_EQ(ok + stats.failures, stats.connects);
+    CHECK(tries >= stats.connects - stats.failures);
+    printf("  %u connects, %u failed, %u scans, %u dropped, %u cache writes\n",
+           (unsigned)stats.connects, (unsigned)stats.failures, (unsigned)stats.scans,
+           (unsigned)stats.dropped, writes);
+}
+
+int main(void) {
+    sim = (sim_t){
+        .ap = {
+            { { 0x10, 2, 3, 4, 5, 6 }, 6, true, true, -50 },
+            { { 0x20, 2, 3, 4, 5, 6 }, 1, false, true, -30 },
+        },
+        .n = 2,
+        .auth_ok = true,
+    };
+    ssid = wifi_cache_ssid_hash("OptiPulse-Lab");
+    wifi_cache_forget(&cache);
+    wifi_connect_stats_reset(&stats);
+
+    test_cold_and_warm();
+    test_fallback();
+    test_invalidation();
+    test_budget();
+    test_stats();
+    return check_done("test_wifi_cache");
+}
@@ -0,0 +1,189 @@
+// File: main/boot_profile.c
+// ==========================================================================================
+// Boot-phase timestamps (esp_timer) with the previous boot's record retained in RTC memory.
+// RTC_NOINIT memory is not cleared by software resets, panics or deep sleep; after a power
+// cycle it holds garbage, which the magic + check word reject.
+// ==========================================================================================
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "boot_profile.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define BOOT_RECORD_MAGIC   0x544F4F42u     // "BOOT"
+#define BOOT_PHASE_SKIPPED  UINT32_MAX
+
+static const char *TAG = "BOOT";
+
+/**
+ * @brief One boot's timing. Times are esp_timer microseconds (fit in 32 bits during boot).
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t boot_count;                    ///< Boots since RTC memory was last valid
+    uint32_t app_start_us;                  ///< esp_timer time when app_main() started
+    uint32_t ready_us;                      ///< esp_timer time when boot_profile_finish() ran
+    uint32_t budget_ms;
+    uint32_t phase_us[BOOT_PHASE_COUNT];    ///< Duration, or BOOT_PHASE_SKIPPED
+    uint32_t check;                         ///< Over all fields above
+} boot_record_t;
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_BANNER]   = "banner",
+    [BOOT_PHASE_NVS]      = "nvs",
+    [BOOT_PHASE_CONFIG]   = "config",
+    [BOOT_PHASE_STORAGE]  = "storage",
+    [BOOT_PHASE_UART]     = "uart",
+    [BOOT_PHASE_HOLD]     = "hold*",
+    [BOOT_PHASE_LED]      = "led",
+    [BOOT_PHASE_LED_DEMO] = "led_demo*",
+    [BOOT_PHASE_FSM]      = "fsm",
+    [BOOT_PHASE_CLI]      = "cli",
+};
+
+RTC_NOINIT_ATTR static boot_record_t rtc_record;
+
+static boot_record_t current;
+static boot_record_t previous;
+static bool have_previous;
+static uint32_t last_mark_us;
+
+// === Helpers ===
+
+static uint32_t boot_record_check(const boot_record_t *r) {
+    const uint32_t *w = (const uint32_t *)r;
+    uint32_t h = 0x9E3779B9u;
+
+    for (size_t i = 0; i < offsetof(boot_record_t, check) / sizeof(uint32_t); i++) {
+        h = (h ^ w[i]) * 0x01000193u;
+    }
+    return h;
+}
+
+static bool boot_phase_waits(int phase) {
+    return phase == BOOT_PHASE_HOLD || phase == BOOT_PHASE_LED_DEMO;
+}
+
+/**
+ * @brief Time waiting for a human or a demo, excluded from the budget.
+ */
+static uint32_t boot_wait_us(const boot_record_t *r) {
+    uint32_t us = 0;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (boot_phase_waits(i) && r->phase_us[i] != BOOT_PHASE_SKIPPED) {
+            us += r->phase_us[i];
+        }
+    }
+    return us;
+}
+
+/**
+ * @brief Reset-to-ready time minus waiting.
+ */
+static uint32_t boot_active_us(const boot_record_t *r) {
+    return r->ready_us - boot_wait_us(r);
+}
+
+// === Recording ===
+
+void boot_profile_begin(void) {
+    have_previous = rtc_record.magic == BOOT_RECORD_MAGIC &&
+                    rtc_record.check == boot_record_check(&rtc_record);
+    if (have_previous) {
+        previous = rtc_record;
+    }
+
+    memset(&current, 0, sizeof(current));
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        current.phase_us[i] = BOOT_PHASE_SKIPPED;
+    }
+    current.magic = BOOT_RECORD_MAGIC;
+    current.boot_count = have_previous ? previous.boot_count + 1 : 1;
+    current.app_start_us = (uint32_t)esp_timer_get_time();
+    last_mark_us = current.app_start_us;
+}
+
+void boot_profile_end(boot_phase_t phase) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    if ((unsigned)phase < BOOT_PHASE_COUNT) {
+        current.phase_us[phase] = now - last_mark_us;
+    }
+    last_mark_us = now;
+}
+
+bool boot_profile_finish(uint32_t budget_ms) {
+    current.ready_us = (uint32_t)esp_timer_get_time();
+    current.budget_ms = budget_ms;
+    current.check = boot_record_check(&current);
+    rtc_record = current;
+
+    boot_profile_print();
+
+    uint32_t active_ms = boot_active_us(&current) / 1000;
+    if (budget_ms && active_ms > budget_ms) {
+        ESP_LOGW(TAG, "Boot over budget: %u ms > %u ms", (unsigned)active_ms, (unsigned)budget_ms);
+        return false;
+    }
+    return true;
+}
+
+// === Reporting ===
+
+const char *boot_profile_phase_name(boot_phase_t phase) {
+    return (unsigned)phase < BOOT_PHASE_COUNT ? phase_names[phase] : "?";
+}
+
+static void print_us(uint32_t us) {
+    if (us == BOOT_PHASE_SKIPPED) {
+        printf(" %10s", "-");
+    } else {
+        printf(" %10u", (unsigned)us);
+    }
+}
+
+void boot_profile_print(void) {
+    const boot_record_t *prev = have_previous ? &previous : NULL;
+
+    if (current.ready_us == 0) {
+        printf("Boot still in progress\n");
+        return;
+    }
+
+    printf("=== Boot #%u profile (us) ===\n", (unsigned)current.boot_count);
+    printf("%-10s %10s %10s %10s\n", "Phase", "This", "Previous", "Delta");
+
+    printf("%-10s", "pre-app");
+    print_us(current.app_start_us);
+    print_us(prev ? prev->app_start_us : BOOT_PHASE_SKIPPED);
+    if (prev) {
+        printf(" %+10d", (int)(current.app_start_us - prev->app_start_us));
+    }
+    printf("\n");
+
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        uint32_t now_us = current.phase_us[i];
+        uint32_t prev_us = prev ? prev->phase_us[i] : BOOT_PHASE_SKIPPED;
+
+        printf("%-10s", phase_names[i]);
+        print_us(now_us);
+        print_us(prev_us);
+        if (now_us != BOOT_PHASE_SKIPPED && prev_us != BOOT_PHASE_SKIPPED) {
+            printf(" %+10d", (int)(now_us - prev_us));
+        }
+        printf("\n");
+    }
+
+    printf("Ready at %u ms, %u ms excluding waits (*)",
+           (unsigned)(current.ready_us / 1000), (unsigned)(boot_active_us(&current) / 1000));
+    if (prev) {
+        printf(" | previous %u ms", (unsigned)(boot_active_us(prev) / 1000));
+    }
+    if (current.budget_ms) {
+        printf(" | budget %u ms", (unsigned)current.budget_ms);
+    }
+    printf("\n");
+}
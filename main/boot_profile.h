@@ -0,0 +1,72 @@
+// File: main/boot_profile.h
+// ==========================================================================================
+// Boot-phase profiler.
+// app_main() calls boot_profile_end() as each init phase completes; the table of phase
+// durations is printed once boot is done, next to the same table from the previous boot
+// (kept in RTC memory across software resets, panics and deep sleep).
+// ==========================================================================================
+
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Init phases, in boot order.
+ */
+typedef enum {
+    BOOT_PHASE_BANNER,      /**< Banner printed */
+    BOOT_PHASE_NVS,         /**< NVS flash initialized */
+    BOOT_PHASE_CONFIG,      /**< Config loaded (NVS cache or YAML parse) */
+    BOOT_PHASE_STORAGE,     /**< SD log writer started (card mounts in the background) */
+    BOOT_PHASE_UART,        /**< UART input driver and RX task */
+    BOOT_PHASE_HOLD,        /**< Optional boot hold (waiting, not counted in the budget) */
+    BOOT_PHASE_LED,         /**< LED handler, timers and mailboxes */
+    BOOT_PHASE_LED_DEMO,    /**< Optional LED pattern demo (waiting, not counted) */
+    BOOT_PHASE_FSM,         /**< State machine task started */
+    BOOT_PHASE_CLI,         /**< CLI task started */
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+/**
+ * @brief Start the profile. Call first thing in app_main().
+ *
+ * Keeps the previous boot's table if RTC memory still holds a valid one.
+ */
+void boot_profile_begin(void);
+
+/**
+ * @brief Mark the end of a phase: its duration is the time since the previous mark.
+ *
+ * A phase that is skipped is simply never marked (shown as "-").
+ */
+void boot_profile_end(boot_phase_t phase);
+
+/**
+ * @brief Close the profile, save it to RTC memory and print it.
+ *
+ * @param budget_ms Startup budget for the counted phases (0 = no budget).
+ * @return true if boot stayed within the budget.
+ */
+bool boot_profile_finish(uint32_t budget_ms);
+
+/**
+ * @brief Print the current and previous boot tables.
+ */
+void boot_profile_print(void);
+
+/**
+ * @brief Short name of a phase.
+ */
+const char *boot_profile_phase_name(boot_phase_t phase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_PROFILE_H
@@ -0,0 +1,115 @@
+// File: main/cli_frame.c
+// ==========================================================================================
+// Frame encoder/decoder for the binary CLI. The decoder is a small state machine fed
+// one byte at a time from the UART reader; it never allocates and never blocks.
+// ==========================================================================================
+
+#include <string.h>
+#include "cli_frame.h"
+
+enum {
+    DEC_SYNC = 0,
+    DEC_LEN,
+    DEC_OP,
+    DEC_PAYLOAD,
+    DEC_CRC_LO,
+    DEC_CRC_HI,
+};
+
+// CRC-16/CCITT nibble table: 32 bytes instead of 512, two lookups per byte
+static const uint16_t crc_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t cli_crc16(uint16_t crc, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ crc_nibble[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ crc_nibble[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+// === Decoder ===
+
+void cli_frame_decoder_reset(cli_frame_decoder_t *dec) {
+    dec->state = DEC_SYNC;
+    dec->pos = 0;
+    dec->crc = 0;
+}
+
+/**
+ * @brief CRC of the frame currently held by the decoder (LEN, OP, PAYLOAD).
+ */
+static uint16_t frame_crc(const cli_frame_t *f) {
+    uint8_t hdr[2] = { f->len, f->op };
+    return cli_crc16(cli_crc16(0xFFFF, hdr, 2), f->payload, f->len);
+}
+
+cli_frame_result_t cli_frame_decode_byte(cli_frame_decoder_t *dec, uint8_t byte) {
+    cli_frame_t *f = &dec->frame;
+
+    switch (dec->state) {
+        case DEC_SYNC:
+            if (byte == CLI_FRAME_SYNC) {
+                dec->state = DEC_LEN;
+            }
+            return CLI_FRAME_NEED_MORE;
+
+        case DEC_LEN:
+            if (byte > CLI_FRAME_MAX_PAYLOAD) {
+                cli_frame_decoder_reset(dec);
+                return CLI_FRAME_TOO_LONG;
+            }
+            f->len = byte;
+            dec->state = DEC_OP;
+            return CLI_FRAME_NEED_MORE;
+
+        case DEC_OP:
+            f->op = byte;
+            dec->pos = 0;
+            dec->state = f->len ? DEC_PAYLOAD : DEC_CRC_LO;
+            return CLI_FRAME_NEED_MORE;
+
+        case DEC_PAYLOAD:
+            f->payload[dec->pos++] = byte;
+            if (dec->pos == f->len) {
+                dec->state = DEC_CRC_LO;
+            }
+            return CLI_FRAME_NEED_MORE;
+
+        case DEC_CRC_LO:
+            dec->crc = byte;
+            dec->state = DEC_CRC_HI;
+            return CLI_FRAME_NEED_MORE;
+
+        case DEC_CRC_HI:
+        default: {
+            uint16_t crc = (uint16_t)(dec->crc | (byte << 8));
+            cli_frame_decoder_reset(dec);
+            if (crc != frame_crc(f)) {
+                return CLI_FRAME_CRC_ERROR;
+            }
+            f->payload[f->len] = '\0';
+            return CLI_FRAME_COMPLETE;
+        }
+    }
+}
+
+// === Encoder ===
+
+size_t cli_frame_encode(uint8_t op, const uint8_t *payload, size_t len, uint8_t *out) {
+    if (len > CLI_FRAME_MAX_PAYLOAD) {
+        return 0;
+    }
+    out[0] = CLI_FRAME_SYNC;
+    out[1] = (uint8_t)len;
+    out[2] = op;
+    if (len) {
+        memcpy(&out[3], payload, len);
+    }
+    uint16_t crc = cli_crc16(0xFFFF, &out[1], len + 2);
+    out[3 + len] = (uint8_t)(crc & 0xFF);
+    out[4 + len] = (uint8_t)(crc >> 8);
+    return len + CLI_FRAME_OVERHEAD;
+}
@@ -0,0 +1,115 @@
+// File: main/cli_frame.h
+// ==========================================================================================
+// Binary framed CLI protocol, sharing UART0 with the text CLI.
+//
+//   +------+-----+----+-------------+-------------+
+//   | 0xA5 | LEN | OP | PAYLOAD[LEN] | CRC16 (LE) |
+//   +------+-----+----+-------------+-------------+
+//
+// CRC-16/CCITT-FALSE over LEN, OP and PAYLOAD. Responses use OP | 0x80 and start
+// their payload with a status byte. Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef CLI_FRAME_H
+#define CLI_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLI_FRAME_SYNC          0xA5    // Never appears in text commands (not ASCII)
+#define CLI_FRAME_MAX_PAYLOAD   64
+#define CLI_FRAME_OVERHEAD      5       // SYNC + LEN + OP + CRC16
+#define CLI_FRAME_RESPONSE      0x80    // OR-ed into the opcode of replies
+
+/**
+ * @brief Request opcodes.
+ */
+typedef enum {
+    CLI_OP_PING         = 0x01,     /**< Echo the payload back */
+    CLI_OP_GET_STATE    = 0x02,     /**< Reply: [status, SystemState] */
+    CLI_OP_POST_EVENT   = 0x03,     /**< [event_t] */
+    CLI_OP_LED_PATTERN  = 0x10,     /**< [channel, led_pattern_t] */
+    CLI_OP_LED_BLINK    = 0x11,     /**< [channel, freq_centihz lo, hi, duty %] */
+    CLI_OP_LED_OFF      = 0x12,     /**< [channel] */
+    CLI_OP_TEXT         = 0x20,     /**< ASCII text command, run through the text table */
+} cli_opcode_t;
+
+/**
+ * @brief Status byte at the start of every response payload.
+ */
+typedef enum {
+    CLI_STATUS_OK = 0,
+    CLI_STATUS_BAD_OPCODE,
+    CLI_STATUS_BAD_LENGTH,
+    CLI_STATUS_BAD_ARG,
+    CLI_STATUS_FAILED,
+} cli_status_t;
+
+/**
+ * @brief One decoded frame.
+ */
+typedef struct {
+    uint8_t op;
+    uint8_t len;
+    uint8_t payload[CLI_FRAME_MAX_PAYLOAD + 1];     ///< +1 so text payloads can be NUL-terminated
+} cli_frame_t;
+
+/**
+ * @brief Byte-at-a-time frame decoder.
+ */
+typedef struct {
+    uint8_t     state;      ///< Internal decoder state (0 = waiting for SYNC)
+    uint8_t     pos;        ///< Payload bytes received
+    uint16_t    crc;        ///< CRC received so far (LE)
+    cli_frame_t frame;      ///< Frame being assembled / last complete frame
+} cli_frame_decoder_t;
+
+/**
+ * @brief Result of feeding one byte.
+ */
+typedef enum {
+    CLI_FRAME_NEED_MORE,    /**< Byte consumed, frame not complete */
+    CLI_FRAME_COMPLETE,     /**< dec->frame holds a valid frame */
+    CLI_FRAME_CRC_ERROR,    /**< Frame dropped: CRC mismatch */
+    CLI_FRAME_TOO_LONG,     /**< Frame dropped: LEN > CLI_FRAME_MAX_PAYLOAD */
+} cli_frame_result_t;
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021), chainable through `crc` (start with 0xFFFF).
+ */
+uint16_t cli_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Reset the decoder to "waiting for SYNC".
+ */
+void cli_frame_decoder_reset(cli_frame_decoder_t *dec);
+
+/**
+ * @brief True while the decoder is inside a frame (the next byte belongs to it).
+ */
+static inline bool cli_frame_decoder_busy(const cli_frame_decoder_t *dec) {
+    return dec->state != 0;
+}
+
+/**
+ * @brief Feed one byte. The first byte must be CLI_FRAME_SYNC (others are ignored).
+ */
+cli_frame_result_t cli_frame_decode_byte(cli_frame_decoder_t *dec, uint8_t byte);
+
+/**
+ * @brief Encode a frame into `out` (at least len + CLI_FRAME_OVERHEAD bytes).
+ *
+ * @return Encoded size, or 0 if `len` exceeds CLI_FRAME_MAX_PAYLOAD.
+ */
+size_t cli_frame_encode(uint8_t op, const uint8_t *payload, size_t len, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CLI_FRAME_H
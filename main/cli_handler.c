@@ -1,57 +1,930 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include "cli_handler.h"
-#include "esp_console.h"      // ESP-IDF console system (CLI core)
+#include "cli_frame.h"        // Binary framed protocol
+#include "uart_input.h"       // Event-driven line/frame input
 #include "esp_log.h"          // For logging
-#include "argtable3/argtable3.h"  // For argument parsing in commands
+#include "esp_timer.h"        // Dispatch timing
+#include "esp_heap_caps.h"    // rtv preview buffer
+#include "driver/uart.h"      // UART0 shared by text and binary modes
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #include "state_machine.h"    // Access to get/transition state
+#include "led_handler.h"      // LED commands
+#include "led_trace.h"        // LED edge trace dump
+#include "fsm_stats.h"        // Transition latency table
+#include "boot_profile.h"     // Boot phase timing
+#include "sd_log.h"           // SD log writer statistics
+#include "log_query.h"        // Indexed SD log search
+#include "tether.h"           // USB log transfer statistics
+#include "untether.h"         // Wi-Fi log upload statistics
+#include "wifi_sta.h"         // Station, AP cache and connect timing
+#include "rtv_handler.h"      // RTV pipeline statistics
+#include "rtv_stream.h"       // RTV viewers
+#include "rtv_snap.h"         // OPERATIONAL snapshots
+
+#define CLI_UART            UART_NUM_0
+#define CLI_MAX_ARGS        8       // argv[] entries per command
+#define CLI_TASK_STACK      4096
+#define CLI_TASK_PRIO       (tskIDLE_PRIORITY + 2)
+#define CLI_QUERY_MAX       50      // Default log_query result limit
 
 static const char *TAG = "CLI_HANDLER";
 
 // ====================================================
-// Register all CLI commands on startup
-// This gets called once from app_main()
+// Command table entry
 // ====================================================
-void cli_register_commands(void)
+typedef struct {
+    const char *name;
+    int (*func)(int argc, char **argv);
+    const char *hint;
+    const char *help;
+} cli_cmd_t;
+
+// ====================================================
+// CLI statistics (written by the CLI task only)
+// ====================================================
+static struct {
+    uint32_t text_cmds;         ///< Text commands dispatched
+    uint32_t bin_frames;        ///< Binary frames dispatched
+    uint32_t unknown;           ///< Unknown commands / opcodes
+    uint32_t max_us;            ///< Slowest dispatch
+    uint64_t total_us;          ///< Sum of dispatch times
+    uint32_t rx_count;          ///< Messages received from uart_input
+    uint32_t rx_max_us;         ///< Slowest UART event -> handler start
+    uint64_t rx_total_us;       ///< Sum of UART event -> handler start
+} cli_stats;
+
+static TaskHandle_t cli_task = NULL;
+
+// ====================================================
+// Argument helpers
+// ====================================================
+
+/**
+ * @brief Channel by index ("0") or name ("state", "network", ...).
+ */
+static int parse_channel(const char *s)
 {
-    ESP_LOGI(TAG, "Registering CLI commands...");
-
-    // You’ll later register each command here using:
-    // esp_console_cmd_register(&cmd);
-    //
-    // Example:
-    // esp_console_cmd_register(&set_state_cmd);
-    // esp_console_cmd_register(&get_state_cmd);
-    // esp_console_cmd_register(&rtv_on_cmd);
-    //
-    // Each will be declared below this function.
-}
-
-// ====================
-// EXAMPLE STRUCTURE:
-// You’ll later define CLI commands using:
-// 1. A struct of arguments (optional)
-// 2. A handler function
-// 3. A command descriptor
-// ====================
-
-/*
- * Future Example Command:
- * Command: set_state OPERATIONAL
- *
- * Step 1: Define handler function
-int cmd_set_state(int argc, char **argv)
+    static const char *const names[LED_CHANNEL_COUNT] = { "state", "network", "storage", "security" };
+
+    for (int ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+        if (strcasecmp(s, names[ch]) == 0) {
+            return ch;
+        }
+    }
+    char *end;
+    long v = strtol(s, &end, 0);
+    return (*s && !*end && v >= 0 && v < LED_CHANNEL_COUNT) ? (int)v : -1;
+}
+
+static int parse_pattern(const char *s)
+{
+    for (int p = 0; p < LED_PATTERN_COUNT; p++) {
+        if (strcasecmp(s, led_pattern_get((led_pattern_t)p)->name) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+static int parse_event(const char *s)
+{
+    for (int e = 0; e < EVENT_COUNT; e++) {
+        if (strcasecmp(s, state_machine_event_name((event_t)e)) == 0) {
+            return e;
+        }
+    }
+    return -1;
+}
+
+// ====================================================
+// Command: led <ch> <PATTERN|off|blink <hz> <duty>|pulse <hz>|fade <ms>>
+// ====================================================
+static int cmd_led(int argc, char **argv)
+{
+    int ch = (argc > 2) ? parse_channel(argv[1]) : -1;
+    if (ch < 0) {
+        printf("Usage: led <ch> <PATTERN|off|blink <hz> <duty>|pulse <hz>|fade <ms>>\n");
+        return 1;
+    }
+
+    const char *what = argv[2];
+    if (strcasecmp(what, "off") == 0) {
+        led_stop((led_channel_t)ch);
+    } else if (strcasecmp(what, "blink") == 0 && argc == 5) {
+        led_blink((led_channel_t)ch, strtof(argv[3], NULL), strtof(argv[4], NULL));
+    } else if (strcasecmp(what, "pulse") == 0 && argc == 4) {
+        led_pulse((led_channel_t)ch, strtof(argv[3], NULL));
+    } else if (strcasecmp(what, "fade") == 0 && argc == 4) {
+        led_fade((led_channel_t)ch, (uint32_t)strtoul(argv[3], NULL, 0));
+    } else {
+        int p = parse_pattern(what);
+        if (p < 0) {
+            printf("Unknown pattern '%s'\n", what);
+            return 1;
+        }
+        led_apply_pattern((led_channel_t)ch, (led_pattern_t)p);
+    }
+    return 0;
+}
+
+// ====================================================
+// Command: led_status
+// ====================================================
+static int cmd_led_status(int argc, char **argv)
+{
+    led_debug_status();
+    return 0;
+}
+
+// ====================================================
+// Command: led_trace [on|off]
+// Without argument: print pending LED edge records and
+// timer-callback statistics, then reset them.
+// With on/off: enable/disable live echo of every edge.
+// ====================================================
+static int cmd_led_trace(int argc, char **argv)
+{
+    if (argc > 1) {
+        if (strcmp(argv[1], "on") == 0) {
+            led_trace_set_echo(true);
+        } else if (strcmp(argv[1], "off") == 0) {
+            led_trace_set_echo(false);
+        } else {
+            printf("Usage: led_trace [on|off]\n");
+            return 1;
+        }
+        return 0;
+    }
+    led_trace_dump();
+    return 0;
+}
+
+// ====================================================
+// Command: event <NAME>
+// Post an FSM event (e.g. CLI_SET_OP, RTV_ON).
+// ====================================================
+static int cmd_event(int argc, char **argv)
+{
+    int e = (argc == 2) ? parse_event(argv[1]) : -1;
+    if (e < 0) {
+        printf("Usage: event <NAME>  (e.g. CLI_SET_OP, RTV_ON, TETHER_REQUEST)\n");
+        return 1;
+    }
+    return state_machine_post_event((event_t)e) ? 0 : 1;
+}
+
+// ====================================================
+// Command: state
+// ====================================================
+static int cmd_state(int argc, char **argv)
+{
+    printf("State: %s\n", state_machine_state_name(get_current_state()));
+    return 0;
+}
+
+// ====================================================
+// Command: fsm_stats
+// Print per-transition counters and latency (avg/max)
+// for every (from -> to) pair seen, then reset them.
+// ====================================================
+static unsigned avg_us(const fsm_lat_t *l, uint32_t n)
+{
+    return n ? (unsigned)(l->sum_us / n) : 0;
+}
+
+static void print_lat_hist(const char *label, const fsm_lat_t *l)
+{
+    printf("  %-22s", label);
+    for (int b = 0; b < FSM_STATS_BUCKETS; b++) {
+        uint32_t limit = fsm_stats_bucket_limit_us(b);
+        if (limit == UINT32_MAX) {
+            printf(" >=%u:%u", (unsigned)fsm_stats_bucket_limit_us(b - 1), (unsigned)l->hist[b]);
+        } else {
+            printf(" <%u:%u", (unsigned)limit, (unsigned)l->hist[b]);
+        }
+    }
+    printf("\n");
+}
+
+static int cmd_fsm_stats(int argc, char **argv)
+{
+    int pairs = 0;
+
+    printf("=== FSM TRANSITIONS (us, avg/max) ===\n");
+    printf("%-24s %6s %13s %13s %13s %15s %6s\n",
+           "from -> to", "count", "queue", "exit", "entry", "post->LED", "missed");
+
+    for (int from = 0; from < STATE_COUNT; from++) {
+        for (int to = 0; to < STATE_COUNT; to++) {
+            const fsm_pair_stats_t *s = fsm_stats_get((uint8_t)from, (uint8_t)to);
+            if (!s || s->count == 0) {
+                continue;
+            }
+            char label[32];
+            snprintf(label, sizeof(label), "%s -> %s",
+                     state_machine_state_name((SystemState)from),
+                     state_machine_state_name((SystemState)to));
+
+            printf("%-24s %6u %6u/%-6u %6u/%-6u %6u/%-6u %7u/%-7u %6u\n",
+                   label, (unsigned)s->count,
+                   avg_us(&s->queue, s->count), (unsigned)s->queue.max_us,
+                   avg_us(&s->exit, s->count), (unsigned)s->exit.max_us,
+                   avg_us(&s->entry, s->count), (unsigned)s->entry.max_us,
+                   avg_us(&s->led, s->led_count), (unsigned)s->led.max_us,
+                   (unsigned)s->led_missed);
+
+            print_lat_hist("queue hist", &s->queue);
+            print_lat_hist("exit hist", &s->exit);
+            print_lat_hist("entry hist", &s->entry);
+            print_lat_hist("post->LED hist", &s->led);
+            pairs++;
+        }
+    }
+
+    if (pairs == 0) {
+        printf("(no transitions since last reset)\n");
+    }
+    fsm_stats_reset();
+    return 0;
+}
+
+// ====================================================
+// Command: boot
+// This boot's phase timings next to the previous boot's.
+// ====================================================
+static int cmd_boot(int argc, char **argv)
+{
+    boot_profile_print();
+    return 0;
+}
+
+// ====================================================
+// Command: cli_stats
+// Receive and dispatch counters and timing, then reset them.
+// ====================================================
+static int cmd_cli_stats(int argc, char **argv)
+{
+    uint32_t n = cli_stats.text_cmds + cli_stats.bin_frames;
+    uart_input_stats_t rx;
+
+    uart_input_take_stats(&rx);
+    printf("=== CLI: %u text | %u binary | %u unknown ===\n",
+           (unsigned)cli_stats.text_cmds, (unsigned)cli_stats.bin_frames,
+           (unsigned)cli_stats.unknown);
+    printf("UART: %u wakeups | %u lines | %u frames | %u dropped | %u overflows | %u frame errors\n",
+           (unsigned)rx.events, (unsigned)rx.lines, (unsigned)rx.frames,
+           (unsigned)rx.dropped, (unsigned)rx.overflows, (unsigned)rx.frame_errors);
+    printf("RX->handler: mean %u us | max %u us\n",
+           cli_stats.rx_count ? (unsigned)(cli_stats.rx_total_us / cli_stats.rx_count) : 0,
+           (unsigned)cli_stats.rx_max_us);
+    printf("Dispatch: mean %u us | max %u us\n",
+           n ? (unsigned)(cli_stats.total_us / n) : 0, (unsigned)cli_stats.max_us);
+    memset(&cli_stats, 0, sizeof(cli_stats));
+    return 0;
+}
+
+// ====================================================
+// Command: rtv
+// Capture pipeline, frame pool and MJPEG viewers: the running session, or the last one.
+// "preview" prints a downscaled frame from the source as text.
+// ====================================================
+static int rtv_preview(uint8_t scale)
+{
+    static const char ramp[] = " .:-=+*#%@";
+    uint8_t *px;
+    uint16_t w, h;
+
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = rtv_snapshot(scale, &px, &w, &h);
+    int64_t us = esp_timer_get_time() - t0;
+    if (err != ESP_OK) {
+        printf("Preview failed: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    for (uint16_t y = 0; y + 1 < h; y += 2) {          // Two rows per line: characters are tall
+        for (uint16_t x = 0; x < w; x++) {
+            unsigned l = (px[y * w + x] + px[(y + 1) * w + x]) / 2;
+            putchar(ramp[l * (sizeof(ramp) - 1) / 256]);
+        }
+        putchar('\n');
+    }
+    printf("%ux%u gray, captured and scaled in %u us\n", (unsigned)w, (unsigned)h, (unsigned)us);
+    heap_caps_free(px);
+    return 0;
+}
+
+static int cmd_rtv(int argc, char **argv)
+{
+    bool reset = argc > 1 && strcmp(argv[1], "reset") == 0;
+
+    if (argc > 1 && strcmp(argv[1], "preview") == 0) {
+        int scale = argc > 2 ? atoi(argv[2]) : 0;
+        if (scale < 0 || scale > RTV_SCALE_MAX) {
+            printf("Scale: 1-%d (none: fit %d columns)\n", RTV_SCALE_MAX, RTV_PREVIEW_W);
+            return 1;
+        }
+        return rtv_preview((uint8_t)scale);
+    }
+    if (argc > 1 && !reset) {
+        printf("Usage: rtv [reset | preview [scale]]\n");
+        return 1;
+    }
+
+    rtv_stats_t st;
+    rtv_stream_stats_t vs;
+    rtv_get_stats(&st, reset);
+    rtv_stream_get_stats(&vs, reset);
+    const rtv_pipe_stats_t *pp = &st.pipe;
+    const rtv_pool_stats_t *pl = &st.pool;
+    uint32_t fps_x10 = st.elapsed_ms ? (uint32_t)((uint64_t)pp->published * 10000 / st.elapsed_ms) : 0;
+
+    printf("=== RTV: %s | %u sessions | source %s ===\n", st.running ? "RUNNING" : "idle",
+           (unsigned)st.sessions, st.source ? st.source : "-");
+    if (st.scale.frames || st.scale.unscaled) {
+        printf("Scale: %ux%u out | %u frames scaled, %u left as they were\n", (unsigned)st.width,
+               (unsigned)st.height, (unsigned)st.scale.frames, (unsigned)st.scale.unscaled);
+    }
+    printf("Pool: %u x %u KB in %s | busy max %u\n", (unsigned)st.buffers,
+           (unsigned)(st.frame_bytes >> 10), st.psram ? "PSRAM" : "internal RAM",
+           (unsigned)pl->busy_max);
+    printf("Frames: %u published in %u ms (%u.%u fps) | %u dropped by stages | %u not captured\n",
+           (unsigned)pp->published, (unsigned)st.elapsed_ms, (unsigned)(fps_x10 / 10),
+           (unsigned)(fps_x10 % 10), (unsigned)pp->dropped, (unsigned)pp->no_frame);
+    printf("Senders: %u delivered | %u stale (replaced unread) | %u starved | age avg %u us, max %u us\n",
+           (unsigned)pl->delivered, (unsigned)pl->stale, (unsigned)pl->starved,
+           pl->age_count ? (unsigned)(pl->age_total_us / pl->age_count) : 0,
+           (unsigned)pl->age_max_us);
+    if (pp->captured) {
+        printf("Capture: avg %u us per frame", (unsigned)(pp->capture_us / pp->captured));
+        for (int i = 0; i < RTV_STAGES_MAX && st.stage_names[i]; i++) {
+            printf(" | %s: avg %u us", st.stage_names[i], (unsigned)(pp->stage_us[i] / pp->captured));
+        }
+        printf(" | %u too large for JPEG\n", (unsigned)st.jpeg_overflows);
+    }
+    const rtv_motion_stats_t *mo = &st.motion;
+    if (st.motion_gate) {
+        printf("Motion: %u looked at | %u sent, %u skipped (no change), %u kept alive | "
+               "%u blocks, at most %u changed\n", (unsigned)mo->frames, (unsigned)mo->passed,
+               (unsigned)mo->skipped, (unsigned)mo->keepalive, (unsigned)mo->blocks,
+               (unsigned)mo->changed_max);
+    } else {
+        printf("Motion: gate off (every frame is sent)\n");
+    }
+    const rtv_rate_t *rt = &st.rate;
+    printf("Rate: %s | %u fps (%u..%u), q%u (%u..%u) | last %s: send %u%%, missed %u%%, %u lost | "
+           "%u down, %u up\n", st.adaptive ? "adaptive" : "fixed", (unsigned)rt->fps,
+           (unsigned)rt->lim.fps_min, (unsigned)rt->lim.fps_max, (unsigned)rt->quality,
+           (unsigned)rt->lim.q_min, (unsigned)rt->lim.q_max,
+           rtv_rate_action_str((rtv_rate_action_t)rt->last), (unsigned)(rt->load_pm / 10),
+           (unsigned)rt->skip_pct, (unsigned)rt->dropped, (unsigned)rt->downs, (unsigned)rt->ups);
+    printf("Viewers: %s | %u now, %u max, %u total, %u turned away | %u frames, %u KB | %u lost\n",
+           vs.serving ? "serving" : "off", (unsigned)vs.viewers, (unsigned)vs.viewers_max,
+           (unsigned)vs.viewers_total, (unsigned)vs.rejected, (unsigned)vs.frames,
+           (unsigned)(vs.bytes >> 10), (unsigned)vs.errors);
+    rtv_snap_stats_t sn;
+    rtv_snap_get_stats(&sn);
+    if (sn.period_s) {
+        printf("Snapshots: %s | every %u s at 1/%u | %u written (%u KB), %u deleted, %u failed, "
+               "%u without card | last %ux%u in %u us\n",
+               sn.running ? "on" : "off until OPERATIONAL", (unsigned)sn.period_s,
+               (unsigned)sn.scale, (unsigned)sn.taken, (unsigned)(sn.bytes >> 10),
+               (unsigned)sn.deleted, (unsigned)sn.failed, (unsigned)sn.no_card,
+               (unsigned)sn.width, (unsigned)sn.height, (unsigned)sn.last_us);
+    } else {
+        printf("Snapshots: off\n");
+    }
+    return 0;
+}
+
+// ====================================================
+// Command: sd_log
+// SD log writer throughput, losses and block write timing.
+// ====================================================
+static int cmd_sd_log(int argc, char **argv)
+{
+    sd_log_stats_t st;
+    sd_log_get_stats(&st);
+    uint32_t writes = st.blocks + st.partials;
+
+    printf("=== SD log: %s ===\n", st.mounted ? "card mounted" : "NO CARD");
+    printf("Lines: %u packed | %u dropped | %u truncated | %u bytes\n",
+           (unsigned)st.lines, (unsigned)st.dropped, (unsigned)st.truncated, (unsigned)st.bytes);
+    printf("Writes: %u blocks | %u partial | %u stalls | %u errors\n",
+           (unsigned)st.blocks, (unsigned)st.partials, (unsigned)st.stalls, (unsigned)st.write_errors);
+    printf("Write time: mean %u us | max %u us\n",
+           writes ? (unsigned)(st.write_total_us / writes) : 0, (unsigned)st.write_max_us);
+    printf("Store: boot %u | segment %u | %u opened | %u deleted | %u recovered\n",
+           (unsigned)st.boot, (unsigned)st.segment, (unsigned)st.segments,
+           (unsigned)st.deleted, (unsigned)st.recovered);
+    if (st.stored_bytes) {
+        printf("Stored: %u KB of text in %u KB (ratio %u.%02u)\n",
+               (unsigned)(st.raw_bytes >> 10), (unsigned)(st.stored_bytes >> 10),
+               (unsigned)(st.raw_bytes / st.stored_bytes),
+               (unsigned)(st.raw_bytes * 100 / st.stored_bytes % 100));
+    }
+    return 0;
+}
+
+// ====================================================
+// Command: log_query [-b boot] [-f ms] [-t ms] [-l E|W|I|D|V] [-n max] [-s]
+// Print stored SD log lines of one boot / time window /
+// level and up, using the segment index. -s forces a
+// full scan of every block (for comparison).
+// ====================================================
+static bool print_log_line(const char *line, size_t len, const log_line_meta_t *meta,
+                           uint32_t boot, void *ctx)
+{
+    printf("[%u] %.*s\n", (unsigned)boot, (int)len, line);
+    return true;
+}
+
+static int cmd_log_query(int argc, char **argv)
+{
+    log_query_t q;
+    log_query_stats_t st;
+
+    log_query_init(&q);
+    q.max = CLI_QUERY_MAX;
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(opt, "-s") == 0) {
+            q.use_index = false;
+            continue;
+        }
+        if (!val || opt[0] != '-' || opt[1] == '\0' || opt[2] != '\0') {
+            printf("Usage: log_query [-b boot] [-f ms] [-t ms] [-l E|W|I|D|V] [-n max] [-s]\n");
+            return 1;
+        }
+        i++;
+        switch (opt[1]) {
+            case 'b': q.boot = (uint32_t)strtoul(val, NULL, 0); break;
+            case 'f': q.from_ms = (uint32_t)strtoul(val, NULL, 0); break;
+            case 't': q.to_ms = (uint32_t)strtoul(val, NULL, 0); break;
+            case 'n': q.max = (uint32_t)strtoul(val, NULL, 0); break;
+            case 'l': {
+                static const char levels[] = "EWIDV";
+                const char *lv = val[0] ? strchr(levels, val[0] & ~0x20) : NULL;
+                if (!lv) {
+                    printf("Level must be one of E W I D V\n");
+                    return 1;
+                }
+                q.level = (uint8_t)(lv - levels + 1);
+                break;
+            }
+            default:
+                printf("Unknown option %s\n", opt);
+                return 1;
+        }
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    if (log_query_run(SD_LOG_ROOT, &q, print_log_line, NULL, &st) != 0) {
+        printf("No log store on the SD card\n");
+        return 1;
+    }
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+
+    printf("=== %u matches | %u lines examined | %u segments (%u skipped) | "
+           "%u blocks, %u KB read | %u ms (%s) ===\n",
+           (unsigned)st.matched, (unsigned)st.lines, (unsigned)st.segments, (unsigned)st.skipped,
+           (unsigned)st.blocks_read, (unsigned)(st.bytes_read >> 10), (unsigned)ms,
+           q.use_index ? "index" : "scan");
+    return 0;
+}
+
+// ====================================================
+// Command: tether
+// USB log transfer: the running session, or the last one.
+// ====================================================
+static int cmd_tether(int argc, char **argv)
 {
-    // Parse argument from argv[1], validate and call transition_to_state()
+    tether_stats_t st;
+    tether_get_stats(&st);
+    const xfer_stats_t *x = &st.xfer;
+
+    printf("=== Tether: %s | %u sessions | %u completed ===\n",
+           st.running ? "RUNNING" : st.sessions ? xfer_result_str(st.result) : "idle",
+           (unsigned)st.sessions, (unsigned)st.completed);
+    printf("Files: %u (%u already on host, %u bad) | %u KB sent | %u KB resumed\n",
+           (unsigned)x->files, (unsigned)x->skipped, (unsigned)x->bad,
+           (unsigned)(x->bytes >> 10), (unsigned)(x->resumed >> 10));
+    printf("Link: %u KB written | %u retransmits (%u on timeout) | %u bad frames | RTT %u ms\n",
+           (unsigned)(x->sent >> 10), (unsigned)x->retransmits, (unsigned)x->timeouts,
+           (unsigned)x->bad_frames, (unsigned)x->rtt_ms);
+    printf("Recovery: %u reconnects | longest %u ms\n",
+           (unsigned)x->reconnects, (unsigned)x->recover_max_ms);
+    if (!st.running && x->elapsed_ms) {
+        printf("Time: %u ms (%u KB/s)\n", (unsigned)x->elapsed_ms,
+               (unsigned)(x->bytes * 1000 / x->elapsed_ms >> 10));
+    }
     return 0;
 }
 
- * Step 2: Register the command
-static const esp_console_cmd_t set_state_cmd = {
-    .command = "set_state",
-    .help = "Change the current system state",
-    .hint = NULL,
-    .func = &cmd_set_state,
-    .argtable = NULL  // For now, we skip advanced argument parsing
+// ====================================================
+// Command: untether
+// Wi-Fi log upload: the running session, or the last one; 'rewind' resets the cursor.
+// ====================================================
+static int cmd_untether(int argc, char **argv)
+{
+    if (argc > 1) {
+        if (strcmp(argv[1], "rewind") != 0) {
+            printf("Usage: untether [rewind]\n");
+            return 1;
+        }
+        if (untether_rewind() != ESP_OK) {
+            printf("Upload in progress: cannot rewind\n");
+            return 1;
+        }
+        printf("Next upload starts from the oldest segment on the card\n");
+        return 0;
+    }
+
+    untether_stats_t st;
+    untether_get_stats(&st);
+    const upload_stats_t *x = &st.upload;
+    uint32_t per_mb = x->bytes ? (uint32_t)((uint64_t)x->requests * 100 * 1048576 / x->bytes) : 0;
+
+    printf("=== Untether: %s | %u sessions | %u completed ===\n",
+           st.running ? "RUNNING" : st.sessions ? upload_result_str(st.result) : "idle",
+           (unsigned)st.sessions, (unsigned)st.completed);
+    printf("Cursor: segment %u + %u bytes on the server\n",
+           (unsigned)st.cursor.seg_id, (unsigned)st.cursor.offset);
+    printf("Files: %u (%u bad) | %u KB uploaded | %u KB sent | Wi-Fi up in %u ms (%s)\n",
+           (unsigned)x->files, (unsigned)x->bad, (unsigned)(x->bytes >> 10),
+           (unsigned)(x->sent >> 10), (unsigned)st.wifi_ms, wifi_path_str(st.wifi_path));
+    printf("Requests: %u (%u.%02u per MB) | %u failed (%u stalled) | %u rewinds | "
+           "%u ms backing off\n", (unsigned)x->requests, (unsigned)(per_mb / 100),
+           (unsigned)(per_mb % 100), (unsigned)x->failures, (unsigned)x->stalls,
+           (unsigned)x->rewinds, (unsigned)x->backoff_ms);
+    if (!st.running && x->elapsed_ms) {
+        printf("Time: %u ms (%u KB/s)\n", (unsigned)x->elapsed_ms,
+               (unsigned)(x->bytes * 1000 / x->elapsed_ms >> 10));
+    }
+    return 0;
+}
+
+// ====================================================
+// Command: wifi
+// Station state, the cached AP and connect time per path. scan and
+// connect go through the same cache the upload uses.
+// ====================================================
+static int cmd_wifi(int argc, char **argv)
+{
+    bool reset = argc > 1 && strcmp(argv[1], "reset") == 0;
+
+    if (argc > 1 && strcmp(argv[1], "scan") == 0) {
+        wifi_sta_seen_t seen[WIFI_STA_SEEN_MAX];
+        uint8_t n;
+        esp_err_t err = wifi_sta_scan(seen, WIFI_STA_SEEN_MAX, &n);
+        if (err != ESP_OK && err != ESP_ERR_NOT_FOUND) {
+            printf("Scan failed: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+        for (uint8_t i = 0; i < n; i++) {
+            const wifi_ap_t *ap = &seen[i].ap;
+            printf("  %02x:%02x:%02x:%02x:%02x:%02x  ch %2u  %4d dBm  %s\n", ap->bssid[0],
+                   ap->bssid[1], ap->bssid[2], ap->bssid[3], ap->bssid[4], ap->bssid[5],
+                   (unsigned)ap->channel, ap->rssi, seen[i].ssid);
+        }
+        printf("%u APs%s\n", (unsigned)n, err == ESP_OK ? "; strongest of ours cached" : "; ours not seen");
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "connect") == 0) {
+        esp_err_t err = wifi_sta_connect(15000);
+        if (err != ESP_OK) {
+            printf("Connect failed: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+    } else if (argc > 1 && strcmp(argv[1], "disconnect") == 0) {
+        wifi_sta_disconnect();
+    } else if (argc > 1 && strcmp(argv[1], "forget") == 0) {
+        if (wifi_sta_forget() != ESP_OK) {
+            printf("Wi-Fi not initialised\n");
+            return 1;
+        }
+    } else if (argc > 1 && !reset) {
+        printf("Usage: wifi [scan|connect|disconnect|forget|reset]\n");
+        return 1;
+    }
+
+    wifi_sta_stats_t st;
+    wifi_sta_get_stats(&st, reset);
+    const wifi_connect_stats_t *c = &st.connect;
+    const uint8_t *b = st.cache.bssid;
+
+    printf("=== Wi-Fi: %s | %u connects | %u failed | %u scans ===\n",
+           st.connected ? "CONNECTED" : "off", (unsigned)c->connects, (unsigned)c->failures,
+           (unsigned)c->scans);
+    if (st.cached) {
+        printf("Cached AP: %02x:%02x:%02x:%02x:%02x:%02x on channel %u (%u misses) | %u dropped\n",
+               b[0], b[1], b[2], b[3], b[4], b[5], (unsigned)st.cache.channel,
+               (unsigned)st.cache.fails, (unsigned)c->dropped);
+    } else {
+        printf("Cached AP: none (next connect scans) | %u dropped\n", (unsigned)c->dropped);
+    }
+    printf("Last connect: %s in %u ms\n", wifi_path_str(c->last_path), (unsigned)c->last_ms);
+    printf("%-10s %6s %6s %8s %8s %8s\n", "Path", "Tries", "OK", "Avg ms", "Min ms", "Max ms");
+    for (int p = 0; p < WIFI_PATH_COUNT; p++) {
+        const wifi_path_stats_t *x = &c->path[p];
+        printf("%-10s %6u %6u %8u %8u %8u\n", wifi_path_str((wifi_path_t)p), (unsigned)x->tries,
+               (unsigned)x->ok, x->ok ? (unsigned)(x->total_ms / x->ok) : 0,
+               (unsigned)x->min_ms, (unsigned)x->max_ms);
+    }
+    return 0;
+}
+
+static int cmd_help(int argc, char **argv);
+
+// ====================================================
+// Command table — MUST stay sorted by name (strcmp order):
+// lookup is a binary search. cli_register_commands() checks it.
+// ====================================================
+static const cli_cmd_t commands[] = {
+    { "boot",       cmd_boot,       NULL,        "Boot phase timings (this boot vs previous)" },
+    { "cli_stats",  cmd_cli_stats,  NULL,        "CLI dispatch counters and timing (resets)" },
+    { "event",      cmd_event,      "<NAME>",    "Post a state machine event" },
+    { "fsm_stats",  cmd_fsm_stats,  NULL,        "Print state transition latency statistics, then reset them" },
+    { "help",       cmd_help,       NULL,        "List commands" },
+    { "led",        cmd_led,        "<ch> <PATTERN|off|blink hz duty|pulse hz|fade ms>", "Drive an LED channel" },
+    { "led_status", cmd_led_status, NULL,        "LED handler status (DEV mode only)" },
+    { "led_trace",  cmd_led_trace,  "[on|off]",  "Dump LED edge trace and callback timing; 'on'/'off' toggles live echo" },
+    { "log_query",  cmd_log_query,  "[-b boot] [-f ms] [-t ms] [-l E|W|I|D|V] [-n max] [-s]",
+                                                 "Search the SD log by boot, time window and level" },
+    { "rtv",        cmd_rtv,        "[reset | preview [scale]]",
+                                                 "RTV capture, frame pool and viewer statistics (start with: event RTV_ON)" },
+    { "sd_log",     cmd_sd_log,     NULL,        "SD card log writer statistics" },
+    { "state",      cmd_state,      NULL,        "Show the current system state" },
+    { "tether",     cmd_tether,     NULL,        "USB log transfer statistics (start with: event TETHER_REQUEST)" },
+    { "untether",   cmd_untether,   "[rewind]",  "Wi-Fi log upload statistics (start with: event UNTETHER_REQUEST)" },
+    { "wifi",       cmd_wifi,       "[scan|connect|disconnect|forget|reset]",
+                                                 "Station, cached AP and connect time per path" },
 };
-*/
 
+#define CLI_CMD_COUNT   (sizeof(commands) / sizeof(commands[0]))
+
+static int cmd_help(int argc, char **argv)
+{
+    for (size_t i = 0; i < CLI_CMD_COUNT; i++) {
+        printf("  %-11s %-12s %s\n", commands[i].name,
+               commands[i].hint ? commands[i].hint : "", commands[i].help);
+    }
+    return 0;
+}
+
+// ====================================================
+// Lookup and tokenization
+// ====================================================
+
+static const cli_cmd_t *cli_find(const char *name)
+{
+    size_t lo = 0, hi = CLI_CMD_COUNT;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = strcmp(name, commands[mid].name);
+        if (c == 0) {
+            return &commands[mid];
+        }
+        if (c < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Split a line into argv[] in place (spaces separate, "double quotes" group).
+ *
+ * @return argc, or -1 if there are more than `max` arguments.
+ */
+static int cli_tokenize(char *line, char **argv, int max)
+{
+    int argc = 0;
+    char *s = line;
+
+    for (;;) {
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        if (*s == '\0') {
+            return argc;
+        }
+        if (argc == max) {
+            return -1;
+        }
+        if (*s == '"') {
+            argv[argc++] = ++s;
+            while (*s && *s != '"') {
+                s++;
+            }
+        } else {
+            argv[argc++] = s;
+            while (*s && *s != ' ' && *s != '\t') {
+                s++;
+            }
+        }
+        if (*s == '\0') {
+            return argc;
+        }
+        *s++ = '\0';
+    }
+}
+
+static void cli_note_dispatch(int64_t t0)
+{
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    cli_stats.total_us += us;
+    if (us > cli_stats.max_us) {
+        cli_stats.max_us = us;
+    }
+}
+
+int cli_execute_line(char *line)
+{
+    char *argv[CLI_MAX_ARGS];
+    int64_t t0 = esp_timer_get_time();
+    int argc = cli_tokenize(line, argv, CLI_MAX_ARGS);
+
+    if (argc == 0) {
+        return 0;
+    }
+    if (argc < 0) {
+        printf("Too many arguments (max %d)\n", CLI_MAX_ARGS);
+        return 1;
+    }
+
+    const cli_cmd_t *cmd = cli_find(argv[0]);
+    if (!cmd) {
+        cli_stats.unknown++;
+        printf("Unknown command '%s' (try 'help')\n", argv[0]);
+        return -1;
+    }
+
+    int rc = cmd->func(argc, argv);
+    cli_stats.text_cmds++;
+    cli_note_dispatch(t0);
+    return rc;
+}
+
+// ====================================================
+// Binary frames
+// ====================================================
+
+static void cli_send_response(uint8_t op, uint8_t status, const uint8_t *data, size_t len)
+{
+    uint8_t payload[CLI_FRAME_MAX_PAYLOAD];
+    uint8_t out[CLI_FRAME_MAX_PAYLOAD + CLI_FRAME_OVERHEAD];
+
+    if (len > CLI_FRAME_MAX_PAYLOAD - 1) {
+        len = CLI_FRAME_MAX_PAYLOAD - 1;
+    }
+    payload[0] = status;
+    if (len) {
+        memcpy(&payload[1], data, len);
+    }
+    size_t n = cli_frame_encode(op | CLI_FRAME_RESPONSE, payload, len + 1, out);
+    uart_write_bytes(CLI_UART, out, n);
+}
+
+/**
+ * @brief Run one decoded frame. Opcodes map straight to a switch (O(1)).
+ */
+static void cli_handle_frame(cli_frame_t *f)
+{
+    int64_t t0 = esp_timer_get_time();
+    const uint8_t *p = f->payload;
+    uint8_t status = CLI_STATUS_OK;
+    uint8_t reply[1];
+    size_t reply_len = 0;
+
+    switch (f->op) {
+        case CLI_OP_PING:
+            cli_send_response(f->op, CLI_STATUS_OK, p, f->len);
+            cli_stats.bin_frames++;
+            cli_note_dispatch(t0);
+            return;
+
+        case CLI_OP_GET_STATE:
+            reply[0] = (uint8_t)get_current_state();
+            reply_len = 1;
+            break;
+
+        case CLI_OP_POST_EVENT:
+            if (f->len != 1 || p[0] >= EVENT_COUNT) {
+                status = CLI_STATUS_BAD_ARG;
+            } else if (!state_machine_post_event((event_t)p[0])) {
+                status = CLI_STATUS_FAILED;
+            }
+            break;
+
+        case CLI_OP_LED_PATTERN:
+            if (f->len != 2 || p[0] >= LED_CHANNEL_COUNT || p[1] >= LED_PATTERN_COUNT) {
+                status = CLI_STATUS_BAD_ARG;
+            } else {
+                led_apply_pattern((led_channel_t)p[0], (led_pattern_t)p[1]);
+            }
+            break;
+
+        case CLI_OP_LED_BLINK:
+            if (f->len != 4 || p[0] >= LED_CHANNEL_COUNT) {
+                status = CLI_STATUS_BAD_ARG;
+            } else {
+                uint16_t centihz = (uint16_t)(p[1] | (p[2] << 8));
+                led_blink((led_channel_t)p[0], centihz / 100.0f, p[3]);
+            }
+            break;
+
+        case CLI_OP_LED_OFF:
+            if (f->len != 1 || p[0] >= LED_CHANNEL_COUNT) {
+                status = CLI_STATUS_BAD_ARG;
+            } else {
+                led_stop((led_channel_t)p[0]);
+            }
+            break;
+
+        case CLI_OP_TEXT: {
+            // Payload is NUL-terminated by the decoder; run it through the text table
+            int rc = cli_execute_line((char *)f->payload);
+            status = (rc == 0) ? CLI_STATUS_OK : (rc < 0 ? CLI_STATUS_BAD_OPCODE : CLI_STATUS_FAILED);
+            cli_send_response(f->op, status, NULL, 0);
+            return;     // Counted (and timed) as a text command
+        }
+
+        default:
+            cli_stats.unknown++;
+            status = CLI_STATUS_BAD_OPCODE;
+            break;
+    }
+
+    cli_send_response(f->op, status, reply, reply_len);
+    cli_stats.bin_frames++;
+    cli_note_dispatch(t0);
+}
+
+// ====================================================
+// CLI task: sleeps until uart_input publishes a line or frame
+// ====================================================
+static void cli_task_fn(void *arg)
+{
+    uart_input_msg_t msg;
+
+    for (;;) {
+        if (!uart_input_get(&msg, portMAX_DELAY)) {
+            continue;
+        }
+
+        uint32_t lat = (uint32_t)esp_timer_get_time() - msg.rx_us;
+        cli_stats.rx_count++;
+        cli_stats.rx_total_us += lat;
+        if (lat > cli_stats.rx_max_us) {
+            cli_stats.rx_max_us = lat;
+        }
+
+        if (msg.type == UART_INPUT_FRAME) {
+            cli_handle_frame(&msg.frame);
+        } else {
+            cli_execute_line(msg.line);
+        }
+    }
+}
+
+void cli_start(void)
+{
+    if (cli_task) {
+        return;
+    }
+    if (uart_input_init() != ESP_OK) {
+        ESP_LOGE(TAG, "UART input unavailable, CLI not started");
+        return;
+    }
+    if (xTaskCreate(cli_task_fn, "cli", CLI_TASK_STACK, NULL, CLI_TASK_PRIO, &cli_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create CLI task");
+        cli_task = NULL;
+    }
+}
+
+// ====================================================
+// Register all CLI commands on startup
+// This gets called once from app_main()
+// ====================================================
+void cli_register_commands(void)
+{
+    ESP_LOGI(TAG, "Registering CLI commands (%u)...", (unsigned)CLI_CMD_COUNT);
+
+    for (size_t i = 1; i < CLI_CMD_COUNT; i++) {
+        if (strcmp(commands[i - 1].name, commands[i].name) >= 0) {
+            ESP_LOGE(TAG, "Command table not sorted at '%s' — lookups will fail", commands[i].name);
+        }
+    }
+
+    memset(&cli_stats, 0, sizeof(cli_stats));
+}
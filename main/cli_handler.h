@@ -1,18 +1,37 @@
 #ifndef CLI_HANDLER_H
 #define CLI_HANDLER_H
 
+#include <stdint.h>
+#include <stddef.h>
+
 // ==============================
 // Purpose:
 // This header defines the CLI system for interacting with your ESP32.
-// You’ll be able to type commands like "set_state OPERATIONAL" or "rtv_on"
-// via UART (USB CLI console).
+// You type commands like "event CLI_SET_OP" or "led state RTV" over UART0;
+// host scripts can instead send binary frames (see cli_frame.h) on the same port.
+// Commands live in one const table sorted by name (binary-search lookup),
+// lines are tokenized in place and nothing is allocated per command.
 // ==============================
 
 /**
  * @brief Initialize the CLI command system.
- * This will register all CLI commands (e.g., set_state, get_state, help).
+ * Checks that the command table is sorted and clears the CLI statistics.
  * Must be called from app_main() or equivalent at startup.
  */
 void cli_register_commands(void);
 
+/**
+ * @brief Start the CLI task. It sleeps until uart_input publishes a text line
+ *        or binary frame (see uart_input.h), then dispatches it.
+ */
+void cli_start(void);
+
+/**
+ * @brief Tokenize a text command line in place and run it.
+ *
+ * @param line Writable, NUL-terminated line (modified).
+ * @return Command result (0 = success), or -1 if the command is unknown.
+ */
+int cli_execute_line(char *line);
+
 #endif // CLI_HANDLER_H
@@ -0,0 +1,651 @@
+// File: main/config_parser.c
+// ==========================================================================================
+// Line-oriented streaming parser for the config YAML subset.
+// Bytes are collected into one fixed line buffer; each complete line is classified
+// (section / key: value / - item) and its value converted in place into app_config_t
+// through the const field table generated from CONFIG_SCHEMA. No recursion, no heap.
+// ==========================================================================================
+
+#include <string.h>
+#include "config_parser.h"
+
+#define CONFIG_LIST_NONE    (-1)
+
+// === Field Table ===
+
+typedef enum {
+    CONFIG_T_STR,
+    CONFIG_T_U8,
+    CONFIG_T_U16,
+    CONFIG_T_U32,
+    CONFIG_T_BOOL,
+    CONFIG_T_U8_LIST,
+} config_type_t;
+
+/**
+ * @brief One schema row, resolved to offsets into app_config_t.
+ */
+typedef struct {
+    const char *section;
+    const char *key;
+    uint8_t     type;           ///< config_type_t
+    uint16_t    offset;         ///< Member offset
+    uint16_t    size;           ///< Buffer length (STR) or max elements (lists)
+    uint16_t    count_offset;   ///< Element counter offset (lists only)
+    uint32_t    min;
+    uint32_t    max;
+} config_field_t;
+
+#define CONFIG_COUNT_OFF_STR(name)      0
+#define CONFIG_COUNT_OFF_U8(name)       0
+#define CONFIG_COUNT_OFF_U16(name)      0
+#define CONFIG_COUNT_OFF_U32(name)      0
+#define CONFIG_COUNT_OFF_BOOL(name)     0
+#define CONFIG_COUNT_OFF_U8_LIST(name)  offsetof(app_config_t, name##_count)
+
+static const config_field_t fields[] = {
+#define X(sec, key, type, size, min, max, def) \
+    { #sec, #key, CONFIG_T_##type, offsetof(app_config_t, sec##_##key), size, \
+      CONFIG_COUNT_OFF_##type(sec##_##key), min, max },
+    CONFIG_SCHEMA(X)
+#undef X
+};
+
+#define FIELD_COUNT ((int)(sizeof(fields) / sizeof(fields[0])))
+
+_Static_assert(sizeof(fields) / sizeof(fields[0]) <= 64, "seen bitmap holds 64 rows");
+
+// === Defaults ===
+
+static void copy_str(char *dst, size_t size, const char *src) {
+    size_t n = strlen(src);
+    if (n >= size) {
+        n = size - 1;
+    }
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+#define CONFIG_DEFAULT_STR(m, def)      copy_str(cfg->m, sizeof(cfg->m), def);
+#define CONFIG_DEFAULT_U8(m, def)       cfg->m = (def);
+#define CONFIG_DEFAULT_U16(m, def)      cfg->m = (def);
+#define CONFIG_DEFAULT_U32(m, def)      cfg->m = (def);
+#define CONFIG_DEFAULT_BOOL(m, def)     cfg->m = (def);
+#define CONFIG_DEFAULT_U8_LIST(m, def)  cfg->m##_count = 0;
+
+void config_set_defaults(app_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+#define X(sec, key, type, size, min, max, def) CONFIG_DEFAULT_##type(sec##_##key, def)
+    CONFIG_SCHEMA(X)
+#undef X
+}
+
+// === Hashing ===
+
+uint32_t config_hash(const void *data, size_t len, uint32_t seed) {
+    const uint8_t *b = data;
+    uint32_t h = seed;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ b[i]) * 16777619u;
+    }
+    return h;
+}
+
+uint32_t config_schema_hash(void) {
+    app_config_t defaults;
+    uint32_t h = CONFIG_HASH_SEED;
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        const config_field_t *f = &fields[i];
+        h = config_hash(f->section, strlen(f->section) + 1, h);
+        h = config_hash(f->key, strlen(f->key) + 1, h);
+        h = config_hash(&f->type, sizeof(f->type), h);
+        h = config_hash(&f->offset, sizeof(f->offset), h);
+        h = config_hash(&f->size, sizeof(f->size), h);
+        h = config_hash(&f->min, sizeof(f->min), h);
+        h = config_hash(&f->max, sizeof(f->max), h);
+    }
+
+    // Keys absent from the source take their defaults, so those are part of the result too
+    config_set_defaults(&defaults);
+    return config_hash(&defaults, sizeof(defaults), h);
+}
+
+// === Error Helpers ===
+
+const char *config_status_str(config_status_t code) {
+    switch (code) {
+        case CONFIG_OK:                   return "ok";
+        case CONFIG_ERR_SYNTAX:           return "syntax error";
+        case CONFIG_ERR_TAB:              return "tab in indentation";
+        case CONFIG_ERR_INDENT:           return "bad indentation";
+        case CONFIG_ERR_LINE_TOO_LONG:    return "line too long";
+        case CONFIG_ERR_UNKNOWN_SECTION:  return "unknown section";
+        case CONFIG_ERR_UNKNOWN_KEY:      return "unknown key";
+        case CONFIG_ERR_DUPLICATE:        return "duplicate key";
+        case CONFIG_ERR_MISSING_VALUE:    return "missing value";
+        case CONFIG_ERR_TYPE:             return "wrong value type";
+        case CONFIG_ERR_RANGE:            return "value out of range";
+        case CONFIG_ERR_TOO_LONG:         return "string too long";
+        case CONFIG_ERR_LIST_FULL:        return "too many list items";
+        case CONFIG_ERR_UNTERMINATED:     return "unterminated quote or list";
+    }
+    return "?";
+}
+
+/**
+ * @brief Record the first error; later ones are ignored.
+ *
+ * @param at Pointer into p->line where the problem is (NULL = start of line).
+ */
+static config_status_t fail(config_parser_t *p, config_status_t code, const char *at) {
+    if (p->err.code == CONFIG_OK) {
+        p->err.code = code;
+        p->err.line = p->line_no;
+        p->err.column = (uint16_t)((at ? at - p->line : 0) + 1);
+    }
+    return code;
+}
+
+// === Lexing Helpers ===
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static const char *skip_spaces(const char *s, const char *end) {
+    while (s < end && is_space(*s)) {
+        s++;
+    }
+    return s;
+}
+
+/**
+ * @brief Quotes only open a string at the start of a scalar (after space, '[' or ',').
+ */
+static inline bool opens_quote(const char *s, const char *c) {
+    return (*c == '"' || *c == '\'') &&
+           (c == s || is_space(c[-1]) || c[-1] == '[' || c[-1] == ',');
+}
+
+static const char *trim_end(const char *s, const char *end) {
+    while (end > s && is_space(end[-1])) {
+        end--;
+    }
+    return end;
+}
+
+/**
+ * @brief End of the meaningful text: a '#' outside quotes that starts the line
+ *        or follows whitespace opens a comment.
+ */
+static const char *strip_comment(const char *s, const char *end) {
+    char quote = 0;
+    for (const char *c = s; c < end; c++) {
+        if (quote) {
+            if (*c == '\\' && quote == '"' && c + 1 < end) {
+                c++;
+            } else if (*c == quote) {
+                quote = 0;
+            }
+        } else if (opens_quote(s, c)) {
+            quote = *c;
+        } else if (*c == '#' && (c == s || is_space(c[-1]))) {
+            return c;
+        }
+    }
+    return end;
+}
+
+/**
+ * @brief First ':' outside quotes that ends the line or is followed by a space.
+ */
+static const char *find_colon(const char *s, const char *end) {
+    char quote = 0;
+    for (const char *c = s; c < end; c++) {
+        if (quote) {
+            if (*c == '\\' && quote == '"' && c + 1 < end) {
+                c++;
+            } else if (*c == quote) {
+                quote = 0;
+            }
+        } else if (opens_quote(s, c)) {
+            quote = *c;
+        } else if (*c == ':' && (c + 1 == end || is_space(c[1]))) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Scalar token: either a quoted string or plain text up to `stop` / the end.
+ *
+ * Quoted strings are unescaped in place ("\\n", "\\t", "\\\"", "\\\\"; '' in single quotes).
+ *
+ * @param[in,out] s    Start of the token; on return, first char after it.
+ * @param stop         Extra terminator for plain scalars (',' or ']' in flow lists), or 0.
+ * @param[out] out     Start of the value text.
+ * @param[out] out_len Length of the value.
+ */
+static config_status_t scan_scalar(config_parser_t *p, const char **s, const char *end,
+                                   char stop, const char **out, size_t *out_len) {
+    const char *c = *s;
+
+    if (c < end && (*c == '"' || *c == '\'')) {
+        char quote = *c++;
+        char *w = (char *)c;        // Unescape in place inside p->line
+        *out = w;
+        for (;;) {
+            if (c >= end) {
+                return fail(p, CONFIG_ERR_UNTERMINATED, *s);
+            }
+            if (*c == quote) {
+                if (quote == '\'' && c + 1 < end && c[1] == '\'') {
+                    *w++ = '\'';
+                    c += 2;
+                    continue;
+                }
+                c++;
+                break;
+            }
+            if (quote == '"' && *c == '\\' && c + 1 < end) {
+                c++;
+                switch (*c) {
+                    case 'n': *w++ = '\n'; break;
+                    case 't': *w++ = '\t'; break;
+                    default:  *w++ = *c;   break;
+                }
+                c++;
+                continue;
+            }
+            *w++ = *c++;
+        }
+        *out_len = (size_t)(w - *out);
+        *s = c;
+        return CONFIG_OK;
+    }
+
+    const char *start = c;
+    while (c < end && !(stop && (*c == stop || *c == ']'))) {
+        c++;
+    }
+    *out = start;
+    *out_len = (size_t)(trim_end(start, c) - start);
+    *s = c;
+    return CONFIG_OK;
+}
+
+/**
+ * @brief Parse an unsigned decimal or 0x-prefixed hex number (no sign, no overflow).
+ */
+static bool parse_u32(const char *s, size_t len, uint32_t *out) {
+    uint32_t base = 10;
+    uint64_t v = 0;
+
+    if (len > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+        len -= 2;
+    }
+    if (len == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        uint32_t d;
+        if (c >= '0' && c <= '9')                    d = (uint32_t)(c - '0');
+        else if (base == 16 && c >= 'a' && c <= 'f') d = (uint32_t)(c - 'a' + 10);
+        else if (base == 16 && c >= 'A' && c <= 'F') d = (uint32_t)(c - 'A' + 10);
+        else return false;
+        v = v * base + d;
+        if (v > UINT32_MAX) {
+            return false;
+        }
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+static bool token_is(const char *s, size_t len, const char *word) {
+    size_t n = strlen(word);
+    if (n != len) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        char c = s[i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != word[i]) return false;
+    }
+    return true;
+}
+
+// === Value Assignment ===
+
+/**
+ * @brief Convert one scalar and store it into the field (appends for lists).
+ */
+static config_status_t assign(config_parser_t *p, const config_field_t *f,
+                              const char *val, size_t len) {
+    uint8_t *base = (uint8_t *)p->cfg;
+    uint32_t num;
+
+    switch (f->type) {
+        case CONFIG_T_STR:
+            if (len >= f->size) {
+                return fail(p, CONFIG_ERR_TOO_LONG, val + f->size - 1);
+            }
+            memcpy(base + f->offset, val, len);
+            base[f->offset + len] = '\0';
+            return CONFIG_OK;
+
+        case CONFIG_T_BOOL:
+            if (token_is(val, len, "true") || token_is(val, len, "yes") ||
+                token_is(val, len, "on") || token_is(val, len, "1")) {
+                *(bool *)(base + f->offset) = true;
+            } else if (token_is(val, len, "false") || token_is(val, len, "no") ||
+                       token_is(val, len, "off") || token_is(val, len, "0")) {
+                *(bool *)(base + f->offset) = false;
+            } else {
+                return fail(p, CONFIG_ERR_TYPE, val);
+            }
+            return CONFIG_OK;
+
+        default:
+            break;
+    }
+
+    // Numeric types
+    if (!parse_u32(val, len, &num)) {
+        return fail(p, CONFIG_ERR_TYPE, val);
+    }
+    if (num < f->min || num > f->max) {
+        return fail(p, CONFIG_ERR_RANGE, val);
+    }
+
+    switch (f->type) {
+        case CONFIG_T_U8:  *(uint8_t *)(base + f->offset) = (uint8_t)num; break;
+        case CONFIG_T_U16: *(uint16_t *)(base + f->offset) = (uint16_t)num; break;
+        case CONFIG_T_U32: *(uint32_t *)(base + f->offset) = num; break;
+        case CONFIG_T_U8_LIST: {
+            uint8_t *count = base + f->count_offset;
+            if (*count >= f->size) {
+                return fail(p, CONFIG_ERR_LIST_FULL, val);
+            }
+            base[f->offset + (*count)++] = (uint8_t)num;
+            break;
+        }
+        default:
+            return fail(p, CONFIG_ERR_TYPE, val);
+    }
+    return CONFIG_OK;
+}
+
+/**
+ * @brief Parse "[a, b, c]" into a list field.
+ */
+static config_status_t assign_flow_list(config_parser_t *p, const config_field_t *f,
+                                        const char *s, const char *end) {
+    const char *open = s++;
+
+    for (;;) {
+        s = skip_spaces(s, end);
+        if (s >= end) {
+            return fail(p, CONFIG_ERR_UNTERMINATED, open);
+        }
+        if (*s == ']') {
+            break;      // Empty list or trailing comma
+        }
+
+        const char *val;
+        size_t len;
+        if (scan_scalar(p, &s, end, ',', &val, &len) != CONFIG_OK) {
+            return p->err.code;
+        }
+        if (len == 0) {
+            return fail(p, CONFIG_ERR_SYNTAX, s);
+        }
+        if (assign(p, f, val, len) != CONFIG_OK) {
+            return p->err.code;
+        }
+
+        s = skip_spaces(s, end);
+        if (s < end && *s == ',') {
+            s++;
+        } else if (s >= end || *s != ']') {
+            return fail(p, s < end ? CONFIG_ERR_SYNTAX : CONFIG_ERR_UNTERMINATED, s < end ? s : open);
+        }
+    }
+
+    s = skip_spaces(s + 1, end);
+    return (s < end) ? fail(p, CONFIG_ERR_SYNTAX, s) : CONFIG_OK;
+}
+
+// === Schema Lookup ===
+
+static bool name_is(const char *s, size_t len, const char *name) {
+    return strlen(name) == len && memcmp(s, name, len) == 0;
+}
+
+static int find_section(const char *s, size_t len) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (name_is(s, len, fields[i].section)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Row of `key` in the section whose first row is `section`, -1 if none.
+ *
+ * Sections are matched by name: identical string literals need not share an address.
+ * Rows of one section are not required to be adjacent in the schema.
+ */
+static int find_field(int section, const char *s, size_t len) {
+    const char *sec = fields[section].section;
+    for (int i = section; i < FIELD_COUNT; i++) {
+        if (strcmp(fields[i].section, sec) == 0 && name_is(s, len, fields[i].key)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Mark a row as assigned; a second assignment is an error.
+ */
+static config_status_t claim_field(config_parser_t *p, int idx, const char *at) {
+    uint64_t bit = 1ULL << idx;
+    if (p->seen & bit) {
+        return fail(p, CONFIG_ERR_DUPLICATE, at);
+    }
+    p->seen |= bit;
+    if (fields[idx].type == CONFIG_T_U8_LIST) {
+        *((uint8_t *)p->cfg + fields[idx].count_offset) = 0;
+    }
+    return CONFIG_OK;
+}
+
+// === Line Processing ===
+
+/**
+ * @brief Classify and apply one complete line (p->line, p->len bytes).
+ */
+static config_status_t process_line(config_parser_t *p) {
+    const char *s = p->line;
+    const char *end = p->line + p->len;
+
+    // Indentation: spaces only
+    const char *c = s;
+    while (c < end && *c == ' ') {
+        c++;
+    }
+    int indent = (int)(c - s);
+    end = trim_end(c, strip_comment(c, end));
+    if (c == end) {
+        return CONFIG_OK;           // Blank or comment-only line
+    }
+    if (*c == '\t') {
+        return fail(p, CONFIG_ERR_TAB, c);
+    }
+
+    // "- item" continues a block list
+    if (*c == '-' && (c + 1 == end || c[1] == ' ')) {
+        if (p->list_field == CONFIG_LIST_NONE || indent < p->key_indent) {
+            return fail(p, CONFIG_ERR_SYNTAX, c);
+        }
+        const char *v = skip_spaces(c + 1, end);
+        const char *val;
+        size_t len;
+        if (scan_scalar(p, &v, end, 0, &val, &len) != CONFIG_OK) {
+            return p->err.code;
+        }
+        v = skip_spaces(v, end);
+        if (v != end) {
+            return fail(p, CONFIG_ERR_SYNTAX, v);       // Points at the stray text
+        }
+        if (len == 0) {
+            return fail(p, CONFIG_ERR_MISSING_VALUE, c);
+        }
+        return assign(p, &fields[p->list_field], val, len);
+    }
+    p->list_field = CONFIG_LIST_NONE;
+
+    const char *colon = find_colon(c, end);
+    if (!colon) {
+        return fail(p, CONFIG_ERR_SYNTAX, c);
+    }
+    const char *key_end = trim_end(c, colon);
+    const char *rest = skip_spaces(colon + 1, end);
+
+    // Section header
+    if (indent == 0) {
+        if (rest != end) {
+            return fail(p, CONFIG_ERR_UNKNOWN_KEY, c);   // Top-level scalars are not in the schema
+        }
+        p->section = (int8_t)find_section(c, (size_t)(key_end - c));
+        p->key_indent = -1;
+        if (p->section < 0) {
+            return fail(p, CONFIG_ERR_UNKNOWN_SECTION, c);
+        }
+        return CONFIG_OK;
+    }
+
+    // key: value inside the open section
+    if (p->section < 0) {
+        return fail(p, CONFIG_ERR_INDENT, c);
+    }
+    if (p->key_indent < 0) {
+        p->key_indent = (int8_t)(indent > 127 ? 127 : indent);
+    } else if (indent != p->key_indent) {
+        return fail(p, CONFIG_ERR_INDENT, c);
+    }
+
+    int idx = find_field(p->section, c, (size_t)(key_end - c));
+    if (idx < 0) {
+        return fail(p, CONFIG_ERR_UNKNOWN_KEY, c);
+    }
+    if (claim_field(p, idx, c) != CONFIG_OK) {
+        return p->err.code;
+    }
+    const config_field_t *f = &fields[idx];
+
+    if (rest == end) {
+        if (f->type != CONFIG_T_U8_LIST) {
+            return fail(p, CONFIG_ERR_MISSING_VALUE, colon);
+        }
+        p->list_field = (int8_t)idx;     // Items follow as "- x" lines
+        return CONFIG_OK;
+    }
+
+    if (*rest == '[') {
+        if (f->type != CONFIG_T_U8_LIST) {
+            return fail(p, CONFIG_ERR_TYPE, rest);
+        }
+        return assign_flow_list(p, f, rest, end);
+    }
+    if (f->type == CONFIG_T_U8_LIST) {
+        return fail(p, CONFIG_ERR_TYPE, rest);
+    }
+
+    const char *val;
+    size_t len;
+    const char *v = rest;
+    if (scan_scalar(p, &v, end, 0, &val, &len) != CONFIG_OK) {
+        return p->err.code;
+    }
+    v = skip_spaces(v, end);
+    if (v != end) {
+        return fail(p, CONFIG_ERR_SYNTAX, v);
+    }
+    return assign(p, f, val, len);
+}
+
+// === Streaming API ===
+
+void config_parser_init(config_parser_t *p, app_config_t *cfg) {
+    memset(p, 0, sizeof(*p));
+    p->cfg = cfg;
+    p->line_no = 1;
+    p->section = -1;
+    p->key_indent = -1;
+    p->list_field = CONFIG_LIST_NONE;
+    config_set_defaults(cfg);
+}
+
+/**
+ * @brief Process the assembled line and start the next one.
+ */
+static config_status_t end_line(config_parser_t *p) {
+    config_status_t rc = CONFIG_OK;
+
+    if (p->overflow) {
+        rc = fail(p, CONFIG_ERR_LINE_TOO_LONG, p->line + CONFIG_LINE_MAX);
+    } else {
+        p->line[p->len] = '\0';
+        rc = process_line(p);
+    }
+    p->len = 0;
+    p->overflow = false;
+    if (p->line_no < UINT16_MAX) {
+        p->line_no++;
+    }
+    return rc;
+}
+
+config_status_t config_parser_feed(config_parser_t *p, const char *data, size_t len) {
+    for (size_t i = 0; i < len && p->err.code == CONFIG_OK; i++) {
+        char ch = data[i];
+        if (ch == '\n') {
+            end_line(p);
+        } else if (ch == '\r') {
+            continue;
+        } else if (p->len < CONFIG_LINE_MAX) {
+            p->line[p->len++] = ch;
+        } else {
+            p->overflow = true;
+        }
+    }
+    return p->err.code;
+}
+
+config_status_t config_parser_finish(config_parser_t *p) {
+    if (p->err.code == CONFIG_OK && (p->len > 0 || p->overflow)) {
+        end_line(p);
+    }
+    return p->err.code;
+}
+
+config_status_t config_parse_buffer(const char *text, size_t len,
+                                    app_config_t *cfg, config_error_t *err) {
+    config_parser_t p;
+
+    config_parser_init(&p, cfg);
+    config_parser_feed(&p, text, len);
+    config_parser_finish(&p);
+    if (err) {
+        *err = p.err;
+    }
+    return p.err.code;
+}
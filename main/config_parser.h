@@ -0,0 +1,192 @@
+// File: main/config_parser.h
+// ==========================================================================================
+// Streaming parser for the YAML subset used by the device configuration.
+// Supported: two-level maps (section -> key: value), scalars (plain, "double" or 'single'
+// quoted), flow lists [a, b] and block lists (- item), # comments.
+// Values are written straight into app_config_t as described by CONFIG_SCHEMA:
+// no malloc, no DOM, one fixed line buffer. Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef CONFIG_PARSER_H
+#define CONFIG_PARSER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONFIG_LINE_MAX     128     // Longest accepted line, including indentation
+
+// === Schema ===
+// One row per setting: X(section, key, type, size, min, max, default)
+//   STR:     size = buffer length (incl. NUL), min/max unused
+//   U8/U16/U32: numeric range [min, max] (decimal or 0x hex)
+//   BOOL:    true/false, yes/no, on/off, 1/0
+//   U8_LIST: size = max elements, each in [min, max]; default is always empty
+// The struct member is named <section>_<key>.
+
+#define CONFIG_SCHEMA(X) \
+    X(device,   name,                 STR,     24, 0,    0,      "optipulse")         \
+    X(device,   security_level,       U8,       1, 0,    3,      0)                   \
+    X(boot,     hold_ms,              U16,      1, 0,    60000,  0)                   \
+    X(boot,     budget_ms,            U16,      1, 0,    10000,  500)                 \
+    X(boot,     led_demo,             BOOL,     1, 0,    1,      false)               \
+    X(wifi,     ssid,                 STR,     33, 0,    0,      "")                  \
+    X(wifi,     password,             STR,     65, 0,    0,      "")                  \
+    X(wifi,     max_retries,          U8,       1, 0,    20,     5)                   \
+    X(wifi,     channels,             U8_LIST,  4, 1,    14,     0)                   \
+    X(led,      operational_blink_ms, U16,      1, 50,   5000,   500)                 \
+    X(led,      hw_offload,           BOOL,     1, 0,    1,      true)                \
+    X(rtv,      session_s,            U16,      1, 1,    3600,   60)                  \
+    X(rtv,      fps,                  U8,       1, 1,    30,     10)                  \
+    X(rtv,      jpeg_quality,         U8,       1, 4,    63,     12)                  \
+    X(rtv,      width,                U16,      1, 16,   1600,   160)                 \
+    X(rtv,      height,               U16,      1, 16,   1200,   120)                 \
+    X(rtv,      format,               STR,      8, 0,    0,      "yuv422")            \
+    X(rtv,      buffers,              U8,       1, 3,    6,      4)                   \
+    X(rtv,      synth_motion,         U8,       1, 0,    64,     2)                   \
+    X(rtv,      port,                 U16,      1, 1,    65534,  80)                  \
+    X(rtv,      max_viewers,          U8,       1, 1,    4,      2)                   \
+    X(rtv,      adaptive,             BOOL,     1, 0,    1,      true)                \
+    X(rtv,      fps_min,              U8,       1, 1,    30,     2)                   \
+    X(rtv,      jpeg_quality_min,     U8,       1, 4,    63,     40)                  \
+    X(rtv,      motion_threshold,     U8,       1, 0,    127,    4)                   \
+    X(rtv,      motion_blocks,        U8,       1, 1,    64,     1)                   \
+    X(rtv,      motion_keepalive_s,   U8,       1, 0,    60,     2)                   \
+    X(rtv,      scale,                U8,       1, 1,    8,      1)                   \
+    X(rtv,      snapshot_s,           U16,      1, 0,    3600,   300)                 \
+    X(rtv,      snapshot_scale,       U8,       1, 1,    16,     2)                   \
+    X(log,      level,                U8,       1, 0,    5,      3)                   \
+    X(log,      to_sd,                BOOL,     1, 0,    1,      true)                \
+    X(log,      segment_kb,           U16,      1, 8,    1024,   1024)                \
+    X(log,      compress,             BOOL,     1, 0,    1,      true)                \
+    X(transfer, upload_url,           STR,     96, 0,    0,      "")                  \
+    X(transfer, chunk_bytes,          U32,      1, 1024, 65536,  8192)                \
+    X(transfer, tether_fallback,      BOOL,     1, 0,    1,      true)                \
+    X(transfer, window,               U8,       1, 1,    32,     16)                  \
+    X(transfer, resume_s,             U16,      1, 1,    3600,   60)                  \
+    X(transfer, batch_kb,             U16,      1, 16,   4096,   256)                 \
+    X(transfer, retries,              U8,       1, 0,    20,     5)                   \
+    X(keys,     magic,                STR,     33, 0,    0,      "unlocked_dev_123")
+
+// Member declarations per type
+#define CONFIG_MEMBER_STR(name, size)       char     name[size];
+#define CONFIG_MEMBER_U8(name, size)        uint8_t  name;
+#define CONFIG_MEMBER_U16(name, size)       uint16_t name;
+#define CONFIG_MEMBER_U32(name, size)       uint32_t name;
+#define CONFIG_MEMBER_BOOL(name, size)      bool     name;
+#define CONFIG_MEMBER_U8_LIST(name, size)   uint8_t  name[size]; uint8_t name##_count;
+
+/**
+ * @brief Parsed device configuration. Layout follows CONFIG_SCHEMA order.
+ */
+typedef struct {
+#define X(sec, key, type, size, min, max, def) CONFIG_MEMBER_##type(sec##_##key, size)
+    CONFIG_SCHEMA(X)
+#undef X
+} app_config_t;
+
+// === Errors ===
+
+/**
+ * @brief Parse result codes.
+ */
+typedef enum {
+    CONFIG_OK = 0,
+    CONFIG_ERR_SYNTAX,          /**< Missing ':' or malformed token */
+    CONFIG_ERR_TAB,             /**< Tab character in indentation */
+    CONFIG_ERR_INDENT,          /**< Indentation does not match the section */
+    CONFIG_ERR_LINE_TOO_LONG,   /**< Line exceeds CONFIG_LINE_MAX */
+    CONFIG_ERR_UNKNOWN_SECTION, /**< Section not in the schema */
+    CONFIG_ERR_UNKNOWN_KEY,     /**< Key not in the schema for this section */
+    CONFIG_ERR_DUPLICATE,       /**< Key set twice */
+    CONFIG_ERR_MISSING_VALUE,   /**< Scalar key without a value */
+    CONFIG_ERR_TYPE,            /**< Value cannot be converted (not a number / bool / list) */
+    CONFIG_ERR_RANGE,           /**< Number outside [min, max] */
+    CONFIG_ERR_TOO_LONG,        /**< String longer than its buffer */
+    CONFIG_ERR_LIST_FULL,       /**< More list items than the schema allows */
+    CONFIG_ERR_UNTERMINATED,    /**< Quote or '[' not closed on the same line */
+} config_status_t;
+
+/**
+ * @brief First error found, with its position (1-based; 0 = not tied to a position).
+ */
+typedef struct {
+    config_status_t code;
+    uint16_t line;
+    uint16_t column;
+} config_error_t;
+
+/**
+ * @brief Streaming parser state. Lives wherever the caller puts it (stack or static).
+ */
+typedef struct {
+    app_config_t  *cfg;                     ///< Destination, written as values arrive
+    config_error_t err;                     ///< Sticky: first error stops the parse
+    uint64_t seen;                          ///< Bit per schema row already assigned
+    uint16_t line_no;                       ///< Line currently being assembled
+    uint16_t len;                           ///< Bytes in `line`
+    bool     overflow;                      ///< Current line exceeded CONFIG_LINE_MAX
+    int8_t   section;                       ///< Schema row of the first key of the open section, -1 = none
+    int8_t   key_indent;                    ///< Indentation of keys in the open section, -1 = not known yet
+    int8_t   list_field;                    ///< Schema row awaiting "- item" lines, -1 = none
+    char     line[CONFIG_LINE_MAX + 1];
+} config_parser_t;
+
+/**
+ * @brief Fill a config with the schema defaults.
+ */
+void config_set_defaults(app_config_t *cfg);
+
+/**
+ * @brief Start a streaming parse into `cfg` (defaults are applied first).
+ */
+void config_parser_init(config_parser_t *p, app_config_t *cfg);
+
+/**
+ * @brief Feed the next chunk of text. Chunks may split lines anywhere.
+ *
+ * @return CONFIG_OK, or the first error (also kept in p->err).
+ */
+config_status_t config_parser_feed(config_parser_t *p, const char *data, size_t len);
+
+/**
+ * @brief Flush the last (unterminated) line and end the parse.
+ */
+config_status_t config_parser_finish(config_parser_t *p);
+
+/**
+ * @brief Parse a complete in-memory document.
+ */
+config_status_t config_parse_buffer(const char *text, size_t len,
+                                    app_config_t *cfg, config_error_t *err);
+
+/**
+ * @brief FNV-1a hash of a byte range (chainable through `seed`).
+ *
+ * Use CONFIG_HASH_SEED for the first call.
+ */
+#define CONFIG_HASH_SEED    2166136261u
+uint32_t config_hash(const void *data, size_t len, uint32_t seed);
+
+/**
+ * @brief Fingerprint of the schema: field names, types, offsets, ranges and defaults.
+ *
+ * Changes whenever CONFIG_SCHEMA or the app_config_t layout changes, so a
+ * cached binary config from older firmware is never reused.
+ */
+uint32_t config_schema_hash(void);
+
+/**
+ * @brief Short description of a status code.
+ */
+const char *config_status_str(config_status_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONFIG_PARSER_H
@@ -0,0 +1,75 @@
+// File: main/fsm_queue.c
+// ==========================================================================================
+// Bounded multi-producer / single-consumer queue.
+// Each cell carries a sequence number: a producer may fill cell i when seq == pos,
+// and publishes it with seq = pos + 1; the consumer frees it with seq = pos + CAPACITY.
+// Producers only contend on one CAS of enqueue_pos, so posting from an ISR is safe.
+// ==========================================================================================
+
+#include "fsm_queue.h"
+
+_Static_assert((FSM_QUEUE_CAPACITY & (FSM_QUEUE_CAPACITY - 1)) == 0,
+               "FSM_QUEUE_CAPACITY must be a power of two");
+
+#define CELL(q, pos)    (&(q)->cells[(pos) & (FSM_QUEUE_CAPACITY - 1)])
+
+void fsm_queue_init(fsm_queue_t *q) {
+    for (unsigned i = 0; i < FSM_QUEUE_CAPACITY; i++) {
+        atomic_init(&q->cells[i].seq, i);
+    }
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    atomic_init(&q->dropped, 0);
+}
+
+// === Producers ===
+
+bool fsm_queue_push(fsm_queue_t *q, const fsm_msg_t *msg) {
+    unsigned pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+
+    for (;;) {
+        fsm_queue_cell_t *cell = CELL(q, pos);
+        unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+
+        if (diff == 0) {
+            // Cell is free for this position: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->msg = *msg;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return true;
+            }
+            // CAS failure reloaded pos; retry
+        } else if (diff < 0) {
+            // Consumer has not freed this cell yet: queue is full
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            // Another producer took this position; catch up
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// === Consumer ===
+
+size_t fsm_queue_pop_batch(fsm_queue_t *q, fsm_msg_t *out, size_t max) {
+    unsigned pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    size_t n = 0;
+
+    while (n < max) {
+        fsm_queue_cell_t *cell = CELL(q, pos);
+        unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        if ((int)(seq - (pos + 1)) < 0) {
+            break;  // Empty, or the producer of this cell has not published yet
+        }
+        out[n++] = cell->msg;
+        atomic_store_explicit(&cell->seq, pos + FSM_QUEUE_CAPACITY, memory_order_release);
+        pos++;
+    }
+
+    atomic_store_explicit(&q->dequeue_pos, pos, memory_order_relaxed);
+    return n;
+}
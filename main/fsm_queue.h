@@ -0,0 +1,71 @@
+// File: main/fsm_queue.h
+// ==========================================================================================
+// Bounded lock-free multi-producer event queue for the state machine.
+// Producers (CLI, timers, ISRs) never take a mutex; the single FSM task consumes.
+// Pure C11 (stdatomic), no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef FSM_QUEUE_H
+#define FSM_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FSM_QUEUE_CAPACITY  32      // Must be a power of two
+
+/**
+ * @brief One queued event.
+ */
+typedef struct {
+    uint8_t  event;         ///< event_t
+    uint32_t posted_us;     ///< esp_timer time when the event was posted (low 32 bits)
+} fsm_msg_t;
+
+/**
+ * @brief Queue cell: the sequence number tells producers/consumer whose turn it is.
+ */
+typedef struct {
+    atomic_uint seq;
+    fsm_msg_t   msg;
+} fsm_queue_cell_t;
+
+/**
+ * @brief Bounded MPSC ring (Vyukov-style sequence cells).
+ */
+typedef struct {
+    fsm_queue_cell_t cells[FSM_QUEUE_CAPACITY];
+    atomic_uint enqueue_pos;
+    atomic_uint dequeue_pos;
+    atomic_uint dropped;    ///< Posts rejected because the queue was full
+} fsm_queue_t;
+
+/**
+ * @brief Reset the queue to empty. Not thread-safe; call before any producer runs.
+ */
+void fsm_queue_init(fsm_queue_t *q);
+
+/**
+ * @brief Enqueue a message. Lock-free, safe from tasks and ISRs.
+ *
+ * @return false if the queue is full (the message is dropped and counted).
+ */
+bool fsm_queue_push(fsm_queue_t *q, const fsm_msg_t *msg);
+
+/**
+ * @brief Dequeue up to `max` messages (single consumer only).
+ *
+ * @return Number of messages written to `out`.
+ */
+size_t fsm_queue_pop_batch(fsm_queue_t *q, fsm_msg_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FSM_QUEUE_H
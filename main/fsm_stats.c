@@ -0,0 +1,106 @@
+// File: main/fsm_stats.c
+// ==========================================================================================
+// Transition latency bookkeeping: a static [from][to] table of counters and histograms.
+// Written from the FSM task only; readers accept slightly torn snapshots. A reset asked
+// for by another task (the CLI) is only a request counter: the FSM task clears the table
+// before it records next, so it never races with a memset.
+// ==========================================================================================
+
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "fsm_stats.h"
+
+// Bucket upper bounds in microseconds, wide enough for a queue wait of a few us and an
+// LED change of several ms: <10, <50, <100, <250, <500, <1ms, <5ms, <10ms, >=10ms
+static const uint32_t bucket_limit_us[FSM_STATS_BUCKETS - 1] = {
+    10, 50, 100, 250, 500, 1000, 5000, 10000
+};
+
+static fsm_pair_stats_t stats[FSM_STATS_MAX_STATES][FSM_STATS_MAX_STATES];
+static const fsm_pair_stats_t empty;        ///< What readers see while a reset is pending
+
+static atomic_uint reset_req;               ///< Resets asked for (any task)
+static atomic_uint reset_done;              ///< Resets applied (FSM task)
+
+static inline fsm_pair_stats_t *pair(uint8_t from, uint8_t to) {
+    if (from >= FSM_STATS_MAX_STATES || to >= FSM_STATS_MAX_STATES) {
+        return NULL;
+    }
+    return &stats[from][to];
+}
+
+static inline bool reset_pending(void) {
+    return atomic_load_explicit(&reset_req, memory_order_acquire) !=
+           atomic_load_explicit(&reset_done, memory_order_acquire);
+}
+
+/** FSM task: apply a pending reset, then return the pair to record into. */
+static fsm_pair_stats_t *pair_rec(uint8_t from, uint8_t to) {
+    unsigned req = atomic_load_explicit(&reset_req, memory_order_acquire);
+    if (req != atomic_load_explicit(&reset_done, memory_order_relaxed)) {
+        memset(stats, 0, sizeof(stats));
+        atomic_store_explicit(&reset_done, req, memory_order_release);
+    }
+    return pair(from, to);
+}
+
+static inline void lat_add(fsm_lat_t *l, uint32_t us) {
+    if (us > l->max_us) l->max_us = us;
+    l->sum_us += us;
+
+    int b = 0;
+    while (b < FSM_STATS_BUCKETS - 1 && us >= bucket_limit_us[b]) {
+        b++;
+    }
+    l->hist[b]++;
+}
+
+// === Recording ===
+
+void fsm_stats_add_transition(uint8_t from, uint8_t to,
+                              uint32_t queue_us, uint32_t exit_us, uint32_t entry_us) {
+    fsm_pair_stats_t *s = pair_rec(from, to);
+    if (!s) {
+        return;
+    }
+    s->count++;
+    lat_add(&s->queue, queue_us);
+    lat_add(&s->exit, exit_us);
+    lat_add(&s->entry, entry_us);
+}
+
+void fsm_stats_add_led(uint8_t from, uint8_t to, uint32_t led_us) {
+    fsm_pair_stats_t *s = pair_rec(from, to);
+    if (!s) {
+        return;
+    }
+    s->led_count++;
+    lat_add(&s->led, led_us);
+}
+
+void fsm_stats_note_led_missed(uint8_t from, uint8_t to) {
+    fsm_pair_stats_t *s = pair_rec(from, to);
+    if (s) {
+        s->led_missed++;
+    }
+}
+
+// === Access ===
+
+const fsm_pair_stats_t *fsm_stats_get(uint8_t from, uint8_t to) {
+    const fsm_pair_stats_t *s = pair(from, to);
+    return (s && reset_pending()) ? &empty : s;
+}
+
+uint32_t fsm_stats_bucket_limit_us(int bucket) {
+    if (bucket < 0 || bucket >= FSM_STATS_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return bucket_limit_us[bucket];
+}
+
+void fsm_stats_reset(void) {
+    atomic_fetch_add_explicit(&reset_req, 1, memory_order_release);
+}
@@ -0,0 +1,88 @@
+// File: main/fsm_stats.h
+// ==========================================================================================
+// Per-transition latency statistics of the state machine.
+// One fixed cell per (from, to) state pair; no allocation, no locks. Recorded by the FSM
+// task only; any task may read or reset.
+// Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef FSM_STATS_H
+#define FSM_STATS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FSM_STATS_MAX_STATES  8     // Table dimension (>= STATE_COUNT)
+#define FSM_STATS_BUCKETS     9     // Histogram buckets, see fsm_stats_bucket_limit_us()
+
+/**
+ * @brief Max, sum and histogram of one latency phase (in microseconds).
+ */
+typedef struct {
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t hist[FSM_STATS_BUCKETS];
+} fsm_lat_t;
+
+/**
+ * @brief Statistics of one (from, to) transition.
+ *
+ * Phases of a transition triggered by an event:
+ *   queue: event posted -> FSM task dispatches it
+ *   exit:  exit hook of the old state
+ *   entry: LED pattern request + entry hook of the new state
+ *   led:   event posted -> first edge of the new pattern on the STATE LED (end to end)
+ * Each phase has its own histogram, on the same buckets.
+ */
+typedef struct {
+    uint32_t  count;                        ///< Transitions taken
+    fsm_lat_t queue;
+    fsm_lat_t exit;
+    fsm_lat_t entry;
+    uint32_t  led_count;                    ///< Transitions whose LED change was observed
+    uint32_t  led_missed;                   ///< LED change superseded or not seen in time
+    fsm_lat_t led;
+} fsm_pair_stats_t;
+
+/**
+ * @brief Record the synchronous phases of one transition.
+ */
+void fsm_stats_add_transition(uint8_t from, uint8_t to,
+                              uint32_t queue_us, uint32_t exit_us, uint32_t entry_us);
+
+/**
+ * @brief Record the end-to-end latency once the LED change has been observed.
+ */
+void fsm_stats_add_led(uint8_t from, uint8_t to, uint32_t led_us);
+
+/**
+ * @brief Count a transition whose LED change could not be timed.
+ */
+void fsm_stats_note_led_missed(uint8_t from, uint8_t to);
+
+/**
+ * @brief Read-only access to one pair (NULL if out of range).
+ */
+const fsm_pair_stats_t *fsm_stats_get(uint8_t from, uint8_t to);
+
+/**
+ * @brief Upper bound (exclusive) of a histogram bucket; the last bucket is open-ended.
+ */
+uint32_t fsm_stats_bucket_limit_us(int bucket);
+
+/**
+ * @brief Clear all statistics. Callable from any task.
+ *
+ * Only posts the request: the FSM task clears the table before it records next. Until
+ * then fsm_stats_get() returns an empty cell for every pair.
+ */
+void fsm_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FSM_STATS_H
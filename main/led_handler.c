@@ -5,183 +5,277 @@
 // Scheduling is done using the ESP-IDF timer API and GPIO control.
 // ==========================================================================================
 
+#include <stdio.h>
+#include <stdatomic.h>
 #include "led_handler.h"
 #include "driver/gpio.h"
 #include "esp_timer.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "tlog.h"
+#include "led_trace.h"
+#include "led_jitter.h"
+#include "led_sched.h"
+#include "led_hw.h"
+#include "led_mailbox.h"
 
 // === GPIO Configuration ===
-#define GPIO_LED                GPIO_NUM_2       // LED connected to GPIO2
-
-// === Pattern Timings (in microseconds) ===
-
-// --- OPERATIONAL pattern ---
-#define BURST_ON_US            10000             // 10ms ON
-#define BURST_OFF_US           10000             // 10ms OFF
-#define BURST_PAUSE_US         50000             // 50ms pause after burst
-#define BURST_MAX_CYCLES       5                 // Number of ON/OFF cycles
-
-// --- HALTED_ENTRY pattern ---
-#define HALTED_BLINK_ON_US     100000            // 100ms ON (5Hz)
-#define HALTED_BLINK_OFF_US    100000            // 100ms OFF
-#define HALTED_MAX_CYCLES      10                // Total 2s duration
-
-// --- TRANSFER_COMPLETE pattern ---
-#define TRANSFER_BLINK_ON_US   500000            // 500ms ON (1Hz)
-#define TRANSFER_BLINK_OFF_US  500000            // 500ms OFF
-
-// --- TETHERED pattern ---
-#define TETHERED_BLINK_ON_US   1000000           // 1s ON (0.5Hz)
-#define TETHERED_BLINK_OFF_US  1000000           // 1s OFF
-
-// --- UNTETHERED pattern ---
-#define UNTETHERED_BURST_ON_US   250000            // 250ms ON (2Hz)
-#define UNTETHERED_BURST_OFF_US  250000            // 250ms OFF
-#define UNTETHERED_BURST_CYCLES  10              // Total 40ms burst
-#define UNTETHERED_PAUSE_US      500000          // 500ms pause between bursts
-
-// --- RTV pattern ---
-#define RTV_BLINK_ON_US          50000           // 50ms ON (20Hz)
-#define RTV_BLINK_OFF_US         50000           // 50ms OFF
-#define RTV_BURST_CYCLES         5               // 5 bursts
-#define RTV_PAUSE_US             500000          // 500ms pause after burst
+// One GPIO per LED channel. GPIO18/19/21 are taken by the security-level inputs.
+static const gpio_num_t channel_gpio[LED_CHANNEL_COUNT] = {
+    [LED_CHANNEL_STATE]    = GPIO_NUM_2,        // Onboard LED: system state
+    [LED_CHANNEL_NETWORK]  = GPIO_NUM_4,        // Network activity
+    [LED_CHANNEL_STORAGE]  = GPIO_NUM_5,        // SD card / storage activity
+    [LED_CHANNEL_SECURITY] = GPIO_NUM_6,        // Security level indication
+};
+
+_Static_assert(LED_CHANNEL_COUNT <= LED_SCHED_MAX_CHANNELS, "too many LED channels");
+
+// Pattern timings and the pattern table live in led_pattern.c/h
+
+// === Hot Path Logging ===
+// 0: the timer callback only stores binary trace records (see led_trace.c).
+// 1: legacy behaviour, one log record per edge from the esp_timer task.
+//    Kept to compare callback durations with `led_trace` (mean/max per call).
+#define LED_LOG_EDGES           0
+
+// === Hardware Offload ===
+// 1: blinking patterns that fit in RMT memory are looped by the RMT peripheral
+//    (no CPU wakeups); the others fall back to the shared esp_timer path.
+// 0: every pattern is driven by the esp_timer path.
+#define LED_HW_OFFLOAD          1
 
 // === Logging Tag ===
 static const char *TAG = "LED_HANDLER";
 
 // === Static Internal State ===
 
-static led_timing_t current_timing;              ///< Current pattern's timing
-static esp_timer_handle_t led_timer = NULL;      ///< Timer for scheduling LED toggles
-static bool led_state = false;                   ///< Current LED level (true = ON)
+/**
+ * @brief Which peripheral currently drives a channel's pin.
+ */
+typedef enum {
+    LED_BACKEND_TIMER,      ///< GPIO toggled from the shared esp_timer
+    LED_BACKEND_RMT,        ///< Waveform looped by the RMT peripheral
+    LED_BACKEND_LEDC,       ///< Brightness ramps (pulse/fade) on LEDC
+} led_backend_t;
+
+static const char *const backend_name[] = { "TIMER", "RMT", "LEDC" };
 
-static burst_state_t burst = { .active = false, .count = 0 }; ///< Burst tracking
-static led_pattern_t current_pattern = LED_PATTERN_DEV_MODE;  ///< Default state
+/**
+ * @brief Per-channel pattern state. Channels share one timer and one deadline heap.
+ */
+typedef struct {
+    led_pattern_state_t player;                  ///< Pattern interpreter state (level, cycle)
+    led_pattern_desc_t  custom_desc;             ///< RAM row used by led_blink() / led_burst()
+    led_pattern_t       pattern;                 ///< Last predefined pattern applied
+    uint8_t             backend;                 ///< led_backend_t owning the pin
+} led_channel_ctx_t;
+
+static esp_timer_handle_t led_timer = NULL;      ///< Single timer serving every channel
+static esp_timer_handle_t kick_timer = NULL;     ///< Fires "now" so new commands are picked up
+static led_sched_t sched;                        ///< Next absolute edge deadline per channel
+static led_channel_ctx_t channels[LED_CHANNEL_COUNT];
+
+// Last command applied per channel, readable from any task (see led_cmd_applied)
+static atomic_uint applied_seq[LED_CHANNEL_COUNT];  ///< Mailbox sequence number (24-bit)
+static atomic_uint applied_us[LED_CHANNEL_COUNT];   ///< esp_timer time of its first edge
+
+/**
+ * @brief Copy of the channel and scheduler state for led_debug_status(), taken by the
+ *        timer callback (the only owner of that state) when another task asks for it.
+ */
+typedef struct {
+    led_channel_ctx_t channels[LED_CHANNEL_COUNT];
+    uint8_t           queued;                    ///< Channels with a pending deadline
+} led_status_snap_t;
 
-// --- Special Mode Flags ---
-static bool halted_mode_active = false;          ///< Indicates if HALTED_ENTRY pattern is running
-static int halted_blink_count = 0;               ///< Counter for HALTED blinks
+#define LED_STATUS_WAIT_MS      100              // Snapshot request timeout
 
-static bool untethered_mode_active = false;      ///< Indicates if UNTETHERED burst is active
-static int untethered_blink_count = 0;           ///< Counter for UNTETHERED bursts
+static led_status_snap_t status_snap;            ///< Written by the callback on request
+static atomic_bool status_req;                   ///< Set by the reader, consumed by the callback
+static SemaphoreHandle_t status_done;            ///< Given once status_snap is filled
 
 // === GPIO LED Control ===
 
 /**
- * @brief Turn ON the LED.
+ * @brief Turn ON the LED of a channel.
  */
-void led_on(void) {
-    gpio_set_level(GPIO_LED, 1);
-    ESP_LOGI(TAG, "LED turned ON");
+void led_on(led_channel_t ch) {
+    gpio_set_level(channel_gpio[ch], 1);
+    TLOGI(TAG, "LED %d turned ON", ch);
 }
 
 /**
- * @brief Turn OFF the LED.
+ * @brief Turn OFF the LED of a channel.
  */
-void led_off(void) {
-    gpio_set_level(GPIO_LED, 0);
-    ESP_LOGI(TAG, "LED turned OFF");
+void led_off(led_channel_t ch) {
+    gpio_set_level(channel_gpio[ch], 0);
+    TLOGI(TAG, "LED %d turned OFF", ch);
 }
 
 /**
- * @brief Set the LED to a static state (ON or OFF).
+ * @brief Set the LED of a channel to a static state (ON or OFF).
  * 
+ * @param ch Channel to drive.
  * @param on True to turn ON, false to turn OFF.
  */
-void led_set_static(bool on) {
-    on ? led_on() : led_off();
-    ESP_LOGI(TAG, "LED set to static state: %s", on ? "ON" : "OFF");
+void led_set_static(led_channel_t ch, bool on) {
+    on ? led_on(ch) : led_off(ch);
+    TLOGI(TAG, "LED %d set to static state: %s", ch, on ? "ON" : "OFF");
 }
 
 // === Timer Callback ===
 
+static void led_exec_cmd(led_channel_t ch, const led_cmd_t *cmd, int64_t now_us);
+
+/**
+ * @brief Fill status_snap for led_debug_status() (esp_timer task only).
+ *
+ * A channel playing its own RAM row gets its player pointed at the copy of that row, so
+ * the reader never follows a pointer into live state.
+ */
+static void led_take_status_snap(void) {
+    for (int ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+        led_channel_ctx_t *s = &status_snap.channels[ch];
+        *s = channels[ch];
+        if (s->player.desc == &channels[ch].custom_desc) {
+            s->player.desc = &s->custom_desc;
+        }
+    }
+    status_snap.queued = (uint8_t)sched.size;
+    xSemaphoreGive(status_done);
+}
+
+/**
+ * @brief Drive a channel's pin without logging (timer hot path).
+ */
+static inline void led_write(led_channel_t ch, bool on) {
+    gpio_set_level(channel_gpio[ch], on);
+}
+
+/**
+ * @brief Arm the shared timer for the earliest queued deadline.
+ *
+ * Only called from the esp_timer task, which owns the scheduler state.
+ *
+ * @param now_us Current esp_timer time.
+ */
+static void led_arm_timer(int64_t now_us) {
+    int64_t deadline_us;
+    if (!led_timer || !led_sched_peek(&sched, &deadline_us)) {
+        return;
+    }
+    int64_t delay_us = deadline_us - now_us;
+    esp_timer_stop(led_timer);              // May still be armed after a kick wakeup
+    esp_timer_start_once(led_timer, delay_us > 0 ? (uint64_t)delay_us : 0);
+}
+
+/**
+ * @brief Play one edge of a due channel and queue its next deadline.
+ *
+ * The next deadline is derived from the one that just expired (not from "now"),
+ * so callback latency does not accumulate. If the channel is more than a whole
+ * phase behind, its grid restarts from now instead of firing catch-up edges.
+ */
+static void led_channel_step(led_channel_t ch, int64_t deadline_us, int64_t now_us) {
+    led_channel_ctx_t *c = &channels[ch];
+    bool custom = (c->player.desc == &c->custom_desc);
+
+    uint32_t next_us = led_pattern_step(&c->player);
+    if (c->backend == LED_BACKEND_LEDC) {
+        // Pulse: each phase is a hardware ramp lasting as long as the phase
+        led_hw_fade(ch, channel_gpio[ch], !c->player.level, c->player.level, next_us / 1000);
+    } else {
+#if LED_LOG_EDGES
+        led_set_static(ch, c->player.level);
+#else
+        led_write(ch, c->player.level);
+#endif
+    }
+    if (next_us) {
+        int64_t next_deadline_us = deadline_us + next_us;
+        if (next_deadline_us <= now_us) {
+            next_deadline_us = now_us + next_us;
+            led_jitter_note_resync(c->pattern);
+        }
+        led_sched_set(&sched, ch, next_deadline_us);
+    }
+
+    if (!custom) {
+        led_jitter_add(c->pattern, (int32_t)(now_us - deadline_us));
+    }
+    led_trace_record((uint32_t)now_us, (uint8_t)ch, (uint8_t)c->pattern,
+                     c->player.level, (uint8_t)c->player.cycle);
+}
+
 /**
  * @brief Callback function for the LED timer
  * 
- * This function is called automatically by the ESP-IDF timer system
- * after a specified ON or OFF interval expires.
- * It toggles the LED state and schedules the next toggle.
- * 
- * Special behavior is handled here for burst, halted, and untethered patterns.
- * Each special mode has its own condition, counter, and stop logic.
+ * This function is called automatically by the ESP-IDF timer system when the
+ * earliest channel deadline expires, or right away when a caller publishes a
+ * command (kick timer). It first applies pending mailbox commands, then
+ * serves every channel that is due at this instant, and finally re-arms the
+ * single timer for the next earliest deadline.
+ * Nothing is formatted here: edges are stored as binary trace records and
+ * printed later by the low-priority trace task. All per-pattern behavior
+ * (bursts, pauses, stop conditions) comes from the pattern table.
  * 
  * @param arg Unused, but required by esp_timer callback signature
  */
 static void led_timer_callback(void* arg) {
-    // === Toggle LED State ===
-    led_state = !led_state;
-    led_set_static(led_state);  // Turn LED ON or OFF
-
-    // === Decide next timer interval based on LED state ===
-    uint64_t next_interval = led_state ? current_timing.on_us : current_timing.off_us;
-
-    // === BURST MODE: OPERATIONAL or RTV_ACTIVE ===
-    if (burst.active && !led_state) {
-        burst.count++;  // Only count OFF phases
-
-    int max_cycles = (current_pattern == LED_PATTERN_RTV_ACTIVE)
-                    ? RTV_BURST_CYCLES : BURST_MAX_CYCLES;
-    uint32_t pause_us = (current_pattern == LED_PATTERN_RTV_ACTIVE)
-                        ? RTV_PAUSE_US : BURST_PAUSE_US;
-
-//
-
-//
-//
-        if (burst.count >= max_cycles) {
-            ESP_LOGI(TAG, "[%s] Burst complete → Pausing %d us",
-                     current_pattern == LED_PATTERN_RTV_ACTIVE ? "RTV" : "OPERATIONAL",
-                     pause_us);
-
-            burst.active = false;
-            burst.count = 0;
-            esp_timer_start_once(led_timer, pause_us);
-            return;
+    int64_t t0 = esp_timer_get_time();
+    int64_t deadline_us;
+    int ch;
+    uint32_t edges = 0;
+
+    // Pick up pattern changes published by other tasks since the last wakeup
+    led_cmd_t cmd;
+    for (ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+        if (led_mailbox_take((uint8_t)ch, &cmd)) {
+            led_exec_cmd((led_channel_t)ch, &cmd, t0);
+            // The new pattern's first edge is on the pin now (patterns start with their
+            // first phase, see led_pattern_start()): that is what led_cmd_applied() reports
+            uint32_t edge_us = (uint32_t)esp_timer_get_time();
+            led_trace_record(edge_us, (uint8_t)ch, (uint8_t)channels[ch].pattern,
+                             channels[ch].player.level, 0);
+            atomic_store_explicit(&applied_us[ch], edge_us, memory_order_relaxed);
+            atomic_store_explicit(&applied_seq[ch], cmd.seq, memory_order_release);
         }
     }
 
-    // === HALTED_ENTRY: 10 total toggles (5s at 2Hz) ===
-    if (halted_mode_active && !led_state) {
-        halted_blink_count++;
-        if (halted_blink_count >= HALTED_MAX_CYCLES) {
-            halted_mode_active = false;
-            led_set_static(false);  // Final OFF
-            ESP_LOGI(TAG, "[HALTED] Done → Holding LED OFF.");
-            return;
-        }
+    while ((ch = led_sched_pop_due(&sched, t0, &deadline_us)) >= 0) {
+        led_channel_step((led_channel_t)ch, deadline_us, t0);
+        edges++;
     }
+    led_arm_timer(t0);
 
-    // === UNTETHERED: 10x 250ms toggles → pause ===
-    if (untethered_mode_active && !led_state) {
-        untethered_blink_count++;
-        if (untethered_blink_count >= UNTETHERED_BURST_CYCLES) {
-            untethered_blink_count = 0;
-            ESP_LOGI(TAG, "[UNTETHERED] Burst complete → Pausing %d us", UNTETHERED_PAUSE_US);
-            esp_timer_start_once(led_timer, UNTETHERED_PAUSE_US);
-            return;
-        }
+    if (atomic_exchange_explicit(&status_req, false, memory_order_acquire)) {
+        led_take_status_snap();
     }
 
-    // === Default: Continue blinking ===
-    esp_timer_start_once(led_timer, next_interval);
+    led_trace_note_callback((uint32_t)(esp_timer_get_time() - t0), edges);
 }
 
 
 // === Initialization ===
 
 /**
- * @brief Initializes the LED GPIO and timer system
+ * @brief Initializes the LED GPIOs and timer system
  * 
- * - Configures the LED pin as output
- * - Creates the timer that will toggle the LED at the configured rate
+ * - Configures every channel's LED pin as output
+ * - Creates the single timer shared by all channels
  * - Does NOT start any blinking until a pattern is applied
  */
 void led_handler_init(void) {
-    ESP_LOGI(TAG, "Initializing LED handler...");
+    TLOGI(TAG, "Initializing LED handler (%d channels)...", LED_CHANNEL_COUNT);
 
     // === GPIO Configuration ===
+    uint64_t pin_mask = 0;
+    for (int ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+        pin_mask |= 1ULL << channel_gpio[ch];
+    }
     gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << GPIO_LED),         // Configure GPIO_LED pin
+        .pin_bit_mask = pin_mask,                   // Configure every channel pin
         .mode = GPIO_MODE_OUTPUT,                   // Set as OUTPUT
         .pull_up_en = GPIO_PULLUP_DISABLE,          // No pull-up
         .pull_down_en = GPIO_PULLDOWN_DISABLE,      // No pull-down
@@ -189,120 +283,276 @@ void led_handler_init(void) {
     };
     gpio_config(&io_conf);  // Apply configuration
 
+    // === Scheduler State ===
+    led_sched_init(&sched);
+    for (int ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+        channels[ch] = (led_channel_ctx_t){ .pattern = LED_PATTERN_DEV_MODE };
+    }
+
     // === Timer Configuration ===
-    // Set up a software timer to call `led_timer_callback` at ON/OFF intervals
+    // Set up a software timer to call `led_timer_callback` at the earliest deadline
     esp_timer_create_args_t timer_args = {
         .callback = &led_timer_callback,            // Timer ISR function
         .name = "led_blink_timer"                   // Name for debugging
     };
     esp_timer_create(&timer_args, &led_timer);      // Create the timer object
+
+    // Same callback, fired with zero delay by callers after publishing a command.
+    // Both timers run in the esp_timer task, so the callback never runs twice at once.
+    esp_timer_create_args_t kick_args = {
+        .callback = &led_timer_callback,
+        .name = "led_kick_timer"
+    };
+    esp_timer_create(&kick_args, &kick_timer);
+
+    if (!status_done) {
+        status_done = xSemaphoreCreateBinary();     // led_debug_status() snapshots
+    }
+
+    // === Edge Trace ===
+    led_trace_init();                               // Deferred formatting of LED edges
 }
 
 /**
  * @brief Deinitializes the LED handler
  * 
  * - Stops and deletes the timer
- * - Turns off the LED to leave the system in a clean state
+ * - Turns off every LED to leave the system in a clean state
  */
 void led_handler_deinit(void) {
-    ESP_LOGI(TAG, "Deinitializing LED handler...");
+    TLOGI(TAG, "Deinitializing LED handler...");
+    if (kick_timer) {
+        esp_timer_stop(kick_timer);
+        esp_timer_delete(kick_timer);
+        kick_timer = NULL;
+    }
     if (led_timer) {
         esp_timer_stop(led_timer);     // Stop timer if active
         esp_timer_delete(led_timer);   // Delete the timer object
         led_timer = NULL;              // Avoid dangling pointer
     }
-    led_off();                         // Turn LED off physically
+    led_sched_init(&sched);            // Drop all pending deadlines
+    for (int ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+        if (channels[ch].backend != LED_BACKEND_TIMER) {
+            led_hw_release((led_channel_t)ch, channel_gpio[ch]);   // Stop RMT/LEDC
+            channels[ch].backend = LED_BACKEND_TIMER;
+        }
+        led_off((led_channel_t)ch);    // Turn LED off physically
+    }
 }
 
-// === Apply Pattern ===
+// === Command Execution (esp_timer task only) ===
 
 /**
- * @brief Applies a predefined LED blinking pattern
- *
- * Based on the selected pattern, this function:
- * - Resets all internal state and counters
- * - Updates the `current_timing` struct with ON/OFF durations
- * - Starts the LED timer to begin toggling
+ * @brief Stop a channel's pending edge and give its pin back to plain GPIO.
+ */
+static void led_channel_stop(led_channel_t ch) {
+    led_channel_ctx_t *c = &channels[ch];
+
+    led_sched_remove(&sched, ch);
+    if (c->backend != LED_BACKEND_TIMER) {
+        led_hw_release(ch, channel_gpio[ch]);
+        c->backend = LED_BACKEND_TIMER;
+    }
+}
+
+/**
+ * @brief Starts playing a pattern descriptor on a channel from its first phase
  *
- * The function handles different logic branches depending on whether the pattern:
- * - Is continuous (DEV_MODE, TRANSFER_COMPLETE, TETHERED)
- * - Has a stopping condition (HALTED_ENTRY, UNTETHERED)
- * - Uses burst logic (OPERATIONAL, RTV_ACTIVE)
+ * Drops the channel's pending edge and resets its interpreter. Blinking patterns
+ * are offloaded to RMT when they fit; otherwise (or for LEDC pulses) the channel's
+ * first deadline is queued on the shared timer. Static patterns just set the level.
  *
- * @param pattern The LED pattern to apply (defined in `led_pattern_t` enum)
+ * @param ch      Channel to (re)start
+ * @param desc    Pattern row to play (table entry or the channel's custom RAM row)
+ * @param backend LED_BACKEND_TIMER (RMT offload allowed) or LED_BACKEND_LEDC (pulse)
+ * @param now_us  Current esp_timer time
  */
-void led_apply_pattern(led_pattern_t pattern) {
-    ESP_LOGI(TAG, "Applying LED pattern: %d", pattern);
-
-    // Stop any existing timer activity
-    if (led_timer) esp_timer_stop(led_timer);
-
-    // Reset all LED handler state
-    led_state = false;
-    burst = (burst_state_t){0};
-    halted_mode_active = false;
-    halted_blink_count = 0;
-    untethered_mode_active = false;
-    untethered_blink_count = 0;
-    current_pattern = pattern;  // Track current pattern globally
-
-    // === Pattern selection ===
-    switch (pattern) {
-
-        case LED_PATTERN_DEV_MODE:
-            ESP_LOGI(TAG, "[Pattern] DEV_MODE → static LED - constant ON");
-            led_set_static(true);  // No timer used
-            break;
+static void led_start_desc(led_channel_t ch, const led_pattern_desc_t *desc,
+                           led_backend_t backend, int64_t now_us) {
+    led_channel_ctx_t *c = &channels[ch];
+
+    led_channel_stop(ch);
+    uint32_t first_us = led_pattern_start(&c->player, desc);
+
+    if (backend == LED_BACKEND_LEDC) {
+        // The first (ON) phase ramps up right away; every later phase is one ramp
+        c->backend = LED_BACKEND_LEDC;
+        led_hw_fade(ch, channel_gpio[ch], false, true, first_us / 1000);
+        led_sched_set(&sched, ch, now_us + first_us);
+        return;
+    }
 
-        case LED_PATTERN_OPERATIONAL:
-            ESP_LOGI(TAG, "[Pattern] OPERATIONAL → 1Hz blinking (500ms ON/OFF)");
-            current_timing = (led_timing_t){ 500000, 500000 };
-            esp_timer_start_once(led_timer, current_timing.off_us);
-            break;
+#if LED_HW_OFFLOAD
+    if (first_us && led_hw_play(ch, channel_gpio[ch], desc)) {
+        c->backend = LED_BACKEND_RMT;
+        led_jitter_note_offload(c->pattern);   // No callbacks: no lateness, no trace
+        return;
+    }
+#endif
 
-        case LED_PATTERN_RTV_ACTIVE:
-            ESP_LOGI(TAG, "[Pattern] RTV_ACTIVE → 5x blinks @ 100Hz, then 500ms pause");
-            current_timing = (led_timing_t){ RTV_BLINK_ON_US, RTV_BLINK_OFF_US };
-            burst.active = true;
-            burst.count = 0;
-            esp_timer_start_once(led_timer, current_timing.off_us);
-            break;
+    led_write(ch, c->player.level);
+    if (first_us) {
+        led_sched_set(&sched, ch, now_us + first_us);
+    }
+}
 
-        case LED_PATTERN_HALTED_ENTRY:
-            ESP_LOGI(TAG, "[Pattern] HALTED_ENTRY → 2Hz (250ms ON/OFF) for 5s, then OFF");
-            current_timing = (led_timing_t){ HALTED_BLINK_ON_US, HALTED_BLINK_OFF_US };
-            halted_mode_active = true;
-            halted_blink_count = 0;
-            esp_timer_start_once(led_timer, current_timing.off_us);
+/**
+ * @brief Apply one mailbox command to a channel.
+ *
+ * Runs in the esp_timer task, the only task that touches channel and scheduler
+ * state, so callers never race with an edge in progress.
+ */
+static void led_exec_cmd(led_channel_t ch, const led_cmd_t *cmd, int64_t now_us) {
+    led_channel_ctx_t *c = &channels[ch];
+
+    switch (cmd->op) {
+        case LED_CMD_PATTERN:
+            c->pattern = (led_pattern_t)cmd->pattern;
+            led_start_desc(ch, led_pattern_get(c->pattern), LED_BACKEND_TIMER, now_us);
             break;
 
-        case LED_PATTERN_TRANSFER_COMPLETE:
-            ESP_LOGI(TAG, "[Pattern] TRANSFER_COMPLETE → 1Hz (500ms ON, 1s OFF)");
-            current_timing = (led_timing_t){ TRANSFER_BLINK_ON_US, TRANSFER_BLINK_OFF_US };
-            esp_timer_start_once(led_timer, current_timing.off_us);
+        case LED_CMD_BLINK:
+        case LED_CMD_PULSE: {
+            bool pulse = (cmd->op == LED_CMD_PULSE);
+            c->custom_desc = (led_pattern_desc_t){
+                .name = pulse ? "PULSE" : "CUSTOM",
+                .timing = { cmd->a, pulse ? cmd->a : cmd->b },
+                .end = LED_END_LOOP,
+            };
+            led_start_desc(ch, &c->custom_desc,
+                           pulse ? LED_BACKEND_LEDC : LED_BACKEND_TIMER, now_us);
             break;
+        }
 
-        case LED_PATTERN_TETHERED:
-            ESP_LOGI(TAG, "[Pattern] TETHERED → 0.5Hz (1s ON, 1s OFF)");
-            current_timing = (led_timing_t){ TETHERED_BLINK_ON_US, TETHERED_BLINK_OFF_US };
-            esp_timer_start_once(led_timer, current_timing.off_us);
+        case LED_CMD_BURST:
+            c->custom_desc = (led_pattern_desc_t){
+                .name = "BURST",
+                .timing = { cmd->a, cmd->a },
+                .pause_us = cmd->b,
+                .cycles = cmd->count,
+                .end = LED_END_LOOP,
+            };
+            led_start_desc(ch, &c->custom_desc, LED_BACKEND_TIMER, now_us);
             break;
 
-        case LED_PATTERN_UNTETHERED:
-            ESP_LOGI(TAG, "[Pattern] UNTETHERED → 10x 250ms blinks, then 500ms pause");
-            current_timing = (led_timing_t){ UNTETHERED_BURST_ON_US, UNTETHERED_BURST_OFF_US };
-            untethered_mode_active = true;
-            untethered_blink_count = 0;
-            esp_timer_start_once(led_timer, current_timing.off_us);
+        case LED_CMD_FADE: {
+            bool from_on = c->player.level;
+            if (c->backend != LED_BACKEND_LEDC) {
+                led_channel_stop(ch);
+                c->backend = LED_BACKEND_LEDC;
+            } else {
+                led_sched_remove(&sched, ch);   // Stop a running pulse
+            }
+            c->player = (led_pattern_state_t){ .level = !from_on };
+            led_hw_fade(ch, channel_gpio[ch], from_on, !from_on, cmd->a);
             break;
+        }
 
+        case LED_CMD_OFF:
         default:
-            ESP_LOGW(TAG, "[Pattern] Unknown pattern! Turning LED OFF.");
-            led_off();
+            led_channel_stop(ch);
+            c->player = (led_pattern_state_t){0};
+            led_write(ch, false);
             break;
     }
 }
 
+// === Apply Pattern ===
+
+/**
+ * @brief Publish a command for a channel and wake the timer task to apply it.
+ *
+ * Never blocks and never touches channel state: the command is handed over
+ * through the lock-free mailbox (latest command wins) and applied at the next
+ * callback, which the zero-delay kick timer makes happen right away.
+ */
+static uint32_t led_post(led_channel_t ch, const led_cmd_t *cmd) {
+    uint32_t seq = led_mailbox_post((uint8_t)ch, cmd);
+    if (!seq) {
+        TLOGW(TAG, "[Post] Command for channel %d dropped: mailbox pool exhausted", ch);
+        return 0;
+    }
+    if (kick_timer) {
+        // ESP_ERR_INVALID_STATE means a kick is already pending: it will see our command
+        esp_timer_start_once(kick_timer, 0);
+    }
+    return seq;
+}
+
+/**
+ * @brief Check whether a posted command (or a newer one) has reached the pin.
+ *
+ * Sequence numbers are 24-bit and compared modulo 2^24.
+ *
+ * @param ch         Channel the command was posted to.
+ * @param seq        Value returned by led_apply_pattern().
+ * @param applied_us_out Time (esp_timer, low 32 bits) its first edge was driven, if it was.
+ */
+bool led_cmd_applied(led_channel_t ch, uint32_t seq, uint32_t *applied_us_out) {
+    if ((unsigned)ch >= LED_CHANNEL_COUNT || seq == 0) {
+        return false;
+    }
+    uint32_t done = atomic_load_explicit(&applied_seq[ch], memory_order_acquire);
+    if (((done - seq) & 0xFFFFFFu) >= 0x800000u) {
+        return false;   // Still waiting in the mailbox
+    }
+    if (applied_us_out) {
+        *applied_us_out = atomic_load_explicit(&applied_us[ch], memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * @brief Stop a channel's pattern (any backend) and drive its LED OFF.
+ *
+ * @param ch The LED channel to stop
+ */
+void led_stop(led_channel_t ch) {
+    if ((unsigned)ch >= LED_CHANNEL_COUNT) {
+        TLOGW(TAG, "[Stop] Unknown channel %d", ch);
+        return;
+    }
+    led_post(ch, &(led_cmd_t){ .op = LED_CMD_OFF });
+}
+
+/**
+ * @brief Applies a predefined LED blinking pattern to one channel
+ *
+ * Looks the pattern up in the const pattern table and hands it to the
+ * generic interpreter. Patterns differ only in their table row:
+ * - Continuous blinking (OPERATIONAL, TRANSFER_COMPLETE, TETHERED)
+ * - Bursts with a pause (RTV_ACTIVE, UNTETHERED)
+ * - A stopping condition (HALTED_ENTRY)
+ * - Static ON (DEV_MODE)
+ *
+ * The change is published to the timer task and takes effect at its next
+ * wakeup (immediately), so this is safe to call from any task.
+ *
+ * @param ch      The LED channel to drive
+ * @param pattern The LED pattern to apply (defined in `led_pattern_t` enum)
+ * @return Command sequence number for led_cmd_applied(), 0 if nothing was posted
+ */
+uint32_t led_apply_pattern(led_channel_t ch, led_pattern_t pattern) {
+    TLOGI(TAG, "Applying LED pattern %d on channel %d", pattern, ch);
+
+    if ((unsigned)ch >= LED_CHANNEL_COUNT) {
+        TLOGW(TAG, "[Pattern] Unknown channel %d", ch);
+        return 0;
+    }
+
+    const led_pattern_desc_t *desc = led_pattern_get(pattern);
+    if (!desc) {
+        TLOGW(TAG, "[Pattern] Unknown pattern! Turning LED OFF.");
+        return led_post(ch, &(led_cmd_t){ .op = LED_CMD_OFF });
+    }
+
+    TLOGI(TAG, "[Pattern] %s → ON %u us / OFF %u us, %u cycles, pause %u us",
+             desc->name, (unsigned)desc->timing.on_us, (unsigned)desc->timing.off_us,
+             (unsigned)desc->cycles, (unsigned)desc->pause_us);
+    return led_post(ch, &(led_cmd_t){ .op = LED_CMD_PATTERN, .pattern = (uint8_t)pattern });
+}
+
 
 // === Utility API: Custom Blink Pattern ===
 
@@ -310,16 +560,22 @@ void led_apply_pattern(led_pattern_t pattern) {
  * @brief Configure a custom LED blinking pattern at runtime
  *
  * This function lets you define any blink frequency and duty cycle without relying on
- * predefined `led_pattern_t` enums. It updates the internal `current_timing` struct
- * and restarts the LED timer with your chosen parameters.
+ * predefined `led_pattern_t` enums. The timer task fills the channel's RAM pattern
+ * row with the computed timing and restarts the interpreter on it.
  *
+ * @param ch                  The LED channel to drive
  * @param frequency_hz        Frequency in Hertz (e.g., 2.0 → 2 toggles per second)
  * @param duty_cycle_percent  Duty cycle in % (e.g., 50.0 = 50% ON, 50% OFF)
  *
  * Example:
- *     led_blink(2.0f, 25.0f);  // 2Hz blinking with 25% ON time (125ms ON, 375ms OFF)
+ *     led_blink(LED_CHANNEL_STATE, 2.0f, 25.0f);  // 2Hz, 25% ON (125ms ON, 375ms OFF)
  */
-void led_blink(float frequency_hz, float duty_cycle_percent) {
+void led_blink(led_channel_t ch, float frequency_hz, float duty_cycle_percent) {
+    if ((unsigned)ch >= LED_CHANNEL_COUNT || frequency_hz <= 0.0f) {
+        TLOGW(TAG, "[Blink] Invalid channel %d or frequency", ch);
+        return;
+    }
+
     // Convert Hz → period in microseconds (us)
     uint32_t period_us = (uint32_t)(1000000.0f / frequency_hz);  
 
@@ -329,43 +585,69 @@ void led_blink(float frequency_hz, float duty_cycle_percent) {
     // Remaining time becomes OFF period
     uint32_t off_us = period_us - on_us;
 
-    // Save timing to internal struct
-    current_timing.on_us = on_us;
-    current_timing.off_us = off_us;
+    // Restart from an ON phase (every pattern starts ON, on RMT and on the timer)
+    led_post(ch, &(led_cmd_t){ .op = LED_CMD_BLINK, .a = on_us, .b = off_us });
+}
+
 
-    // Reset LED timer with new OFF delay (OFF comes first in this framework)
-    if (led_timer) esp_timer_stop(led_timer);
-    esp_timer_start_once(led_timer, current_timing.off_us);
+/**
+ * @brief Play `blinks` ON/OFF pairs of `blink_us` each, then pause, and repeat
+ *
+ * The runtime counterpart of the burst rows of the pattern table (RTV_ACTIVE,
+ * UNTETHERED), for patterns whose rhythm carries a value.
+ *
+ * @param ch       The LED channel to drive
+ * @param blinks   ON/OFF pairs per burst (1..255)
+ * @param blink_us Duration of each ON and each OFF phase
+ * @param pause_us Gap between bursts
+ */
+void led_burst(led_channel_t ch, uint8_t blinks, uint32_t blink_us, uint32_t pause_us) {
+    if ((unsigned)ch >= LED_CHANNEL_COUNT || blinks == 0 || blink_us == 0) {
+        TLOGW(TAG, "[Burst] Invalid channel %d or timing", ch);
+        return;
+    }
+    led_post(ch, &(led_cmd_t){ .op = LED_CMD_BURST, .a = blink_us, .b = pause_us, .count = blinks });
 }
 
 
-// === Pulse and Fade (Unimplemented Placeholders) ===
+// === Pulse and Fade (LEDC) ===
 
 /**
- * @brief Create a LED pulsing effect (TO BE IMPLEMENTED)
+ * @brief Create a LED pulsing ("breathing") effect
  *
- * This function is a placeholder for future enhancement.
- * You would use the LEDC (LED Controller) module or a PWM driver
- * to gradually increase and decrease LED brightness.
+ * Each period is two LEDC hardware ramps: up to full brightness over half a
+ * period, then back down to OFF. The ramps themselves run in hardware; the
+ * shared timer only starts the next ramp, i.e. two wakeups per period.
  *
+ * @param ch           The LED channel to drive
  * @param frequency_hz Frequency of pulse cycles (e.g., breathing rate)
  */
-void led_pulse(float frequency_hz) {
-    // [TODO] Implement pulse using LEDC fade or sine wave modulation
-    ESP_LOGW(TAG, "Pulse pattern not implemented.");
+void led_pulse(led_channel_t ch, float frequency_hz) {
+    if ((unsigned)ch >= LED_CHANNEL_COUNT || frequency_hz <= 0.0f) {
+        TLOGW(TAG, "[Pulse] Invalid channel %d or frequency", ch);
+        return;
+    }
+
+    uint32_t half_us = (uint32_t)(500000.0f / frequency_hz);
+    led_post(ch, &(led_cmd_t){ .op = LED_CMD_PULSE, .a = half_us });
 }
 
 /**
- * @brief Fade the LED brightness over a specific time (TO BE IMPLEMENTED)
+ * @brief Fade the LED brightness over a specific time
  *
- * This function is another placeholder for future fade effects.
- * It will likely use `ledc_set_fade_with_time()` and `ledc_fade_start()` from ESP-IDF.
+ * Ramps from the channel's current level to the opposite one (ON → OFF or
+ * OFF → ON) with a single LEDC hardware fade. Any running pattern on the
+ * channel is stopped first.
  *
+ * @param ch          The LED channel to drive
  * @param duration_ms Time in milliseconds to complete the fade
  */
-void led_fade(uint32_t duration_ms) {
-    // [TODO] Implement gradual brightness fade over time
-    ESP_LOGW(TAG, "Fade pattern not implemented.");
+void led_fade(led_channel_t ch, uint32_t duration_ms) {
+    if ((unsigned)ch >= LED_CHANNEL_COUNT) {
+        TLOGW(TAG, "[Fade] Unknown channel %d", ch);
+        return;
+    }
+    led_post(ch, &(led_cmd_t){ .op = LED_CMD_FADE, .a = duration_ms });
 }
 
 // === Periodic Tick (for future use) ===
@@ -385,44 +667,80 @@ void led_handler_tick(void) {
 void led_debug_status(void) {
     ESP_LOGI(TAG, "=== LED DEBUG STATUS ===");
 
-    if (current_pattern != LED_PATTERN_DEV_MODE) {
-        ESP_LOGW(TAG, "Debug status is only available in DEV_MODE.");
-        return;
+    // Scheduler lateness per pattern
+    ESP_LOGI(TAG, "--- Edge lateness (us): pattern | n | min | mean | max | resyncs | RMT runs ---");
+    for (int p = 0; p < LED_PATTERN_COUNT; p++) {
+        const led_jitter_stats_t *js = led_jitter_get((led_pattern_t)p);
+        if (js->count == 0) {
+            if (js->offloaded) {
+                ESP_LOGI(TAG, "%-17s | %6u | (played by RMT, not measured) | %u",
+                         led_pattern_get((led_pattern_t)p)->name, 0u, (unsigned)js->offloaded);
+            }
+            continue;
+        }
+        ESP_LOGI(TAG, "%-17s | %6u | %6d | %6d | %6d | %u | %u",
+                 led_pattern_get((led_pattern_t)p)->name, (unsigned)js->count,
+                 (int)js->min_us, (int)(js->sum_us / js->count), (int)js->max_us,
+                 (unsigned)js->resyncs, (unsigned)js->offloaded);
+
+        char line[96];
+        int len = 0;
+        for (int b = 0; b < LED_JITTER_BUCKETS; b++) {
+            len += snprintf(line + len, sizeof(line) - len, " %u", (unsigned)js->hist[b]);
+        }
+        ESP_LOGI(TAG, "    hist [<10 <50 <100 <500 <1k <5k <10k >=10k]:%s", line);
     }
 
-    // Basic LED state info
-    ESP_LOGI(TAG, "LED physical state: %s", gpio_get_level(GPIO_LED) ? "ON" : "OFF");
-    ESP_LOGI(TAG, "Current timing → ON: %u us | OFF: %u us", current_timing.on_us, current_timing.off_us);
+    // Command mailbox
+    led_mailbox_stats_t ms;
+    led_mailbox_get_stats(&ms);
+    ESP_LOGI(TAG, "Commands: %u posted | %u applied | %u superseded | %u dropped",
+             (unsigned)ms.posted, (unsigned)ms.taken, (unsigned)ms.superseded,
+             (unsigned)ms.dropped);
 
-    // Burst Mode
-    if (burst.active) {
-        const char* label = (current_pattern == LED_PATTERN_RTV_ACTIVE) ? "RTV" : "OPERATIONAL";
-        int max_cycles = (current_pattern == LED_PATTERN_RTV_ACTIVE) ? RTV_BURST_CYCLES : BURST_MAX_CYCLES;
-        ESP_LOGI(TAG, "[Burst - %s] ACTIVE → Cycles: %d / %d", label, burst.count, max_cycles);
-    } else {
-        ESP_LOGI(TAG, "[Burst] INACTIVE");
+    // Channel and scheduler state belong to the timer callback: ask it for a copy
+    if (!led_timer || !status_done) {
+        ESP_LOGW(TAG, "Timer: NULL (not initialized?)");
+        ESP_LOGI(TAG, "=======================================");
+        return;
     }
-
-    // HALTED Mode
-    if (halted_mode_active) {
-        ESP_LOGI(TAG, "[HALTED Entry] ACTIVE → Blinks: %d / %d", halted_blink_count, HALTED_MAX_CYCLES);
-    } else {
-        ESP_LOGI(TAG, "[HALTED Entry] INACTIVE");
+    xSemaphoreTake(status_done, 0);                 // A late answer to an earlier request
+    atomic_store_explicit(&status_req, true, memory_order_release);
+    esp_timer_start_once(kick_timer, 0);
+    if (xSemaphoreTake(status_done, pdMS_TO_TICKS(LED_STATUS_WAIT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Channel state: no answer from the LED timer within %d ms",
+                 LED_STATUS_WAIT_MS);
+        ESP_LOGI(TAG, "=======================================");
+        return;
     }
+    const led_status_snap_t *snap = &status_snap;
 
-    // UNTETHERED Mode
-    if (untethered_mode_active) {
-        ESP_LOGI(TAG, "[UNTETHERED] ACTIVE → Bursts: %d / %d", untethered_blink_count, UNTETHERED_BURST_CYCLES);
-    } else {
-        ESP_LOGI(TAG, "[UNTETHERED] INACTIVE");
+    if (snap->channels[LED_CHANNEL_STATE].pattern != LED_PATTERN_DEV_MODE) {
+        ESP_LOGW(TAG, "Per-channel state is only available in DEV_MODE.");
+        ESP_LOGI(TAG, "=======================================");
+        return;
     }
 
-    // Timer validity
-    if (led_timer) {
-        ESP_LOGI(TAG, "Timer: VALID (callback state not tracked here)");
-    } else {
-        ESP_LOGW(TAG, "Timer: NULL (not initialized?)");
+    // Per-channel LED state info
+    for (int ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+        const led_channel_ctx_t *c = &snap->channels[ch];
+        const led_pattern_desc_t *d = c->player.desc;
+
+        ESP_LOGI(TAG, "[CH%d GPIO%d] physical state: %s | backend: %s", ch, channel_gpio[ch],
+                 gpio_get_level(channel_gpio[ch]) ? "ON" : "OFF", backend_name[c->backend]);
+        if (!d) {
+            ESP_LOGI(TAG, "    Pattern: NONE");
+            continue;
+        }
+        ESP_LOGI(TAG, "    Pattern: %s | ON: %u us | OFF: %u us", d->name,
+                 (unsigned)d->timing.on_us, (unsigned)d->timing.off_us);
+        if (d->cycles) {
+            ESP_LOGI(TAG, "    [Burst] Cycles: %u / %u | Pause: %u us",
+                     (unsigned)c->player.cycle, (unsigned)d->cycles, (unsigned)d->pause_us);
+        }
     }
 
+    ESP_LOGI(TAG, "Timer: VALID (%u channels queued)", (unsigned)snap->queued);
+
     ESP_LOGI(TAG, "=======================================");
 }
@@ -5,35 +5,23 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "led_pattern.h"   // led_pattern_t and the pattern table
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef struct {
-    uint32_t on_us;
-    uint32_t off_us;
-} led_timing_t;
-
-typedef struct {
-    bool active;
-    uint16_t count;
-} burst_state_t;
-
-
 /**
- * @enum led_pattern_t
- * @brief LED blinking patterns for system state indication.
+ * @enum led_channel_t
+ * @brief Status LEDs on the board. All channels share one timer and one deadline heap.
  */
 typedef enum {
-    LED_PATTERN_DEV_MODE,           /**< Development mode: 1Hz continuous blinking */
-    LED_PATTERN_OPERATIONAL,        /**< Operational state: 2Hz bursts with pauses */
-    LED_PATTERN_RTV_ACTIVE,         /**< Real-Time Video active: burst mode pattern */
-    LED_PATTERN_TETHERED,           /**< Tethered transfer: 0.5Hz blinking */
-    LED_PATTERN_UNTETHERED,         /**< Untethered transfer: 10x short bursts + pause */
-    LED_PATTERN_HALTED_ENTRY,       /**< HALTED state: 5Hz blink for 2 seconds */
-    LED_PATTERN_TRANSFER_COMPLETE   /**< Transfer done: 1Hz blinking until change */
-} led_pattern_t;
+    LED_CHANNEL_STATE,              /**< System state (onboard GPIO2 LED) */
+    LED_CHANNEL_NETWORK,            /**< Network activity */
+    LED_CHANNEL_STORAGE,            /**< SD card / storage activity */
+    LED_CHANNEL_SECURITY,           /**< Security level indication */
+    LED_CHANNEL_COUNT               /**< Number of channels (not a channel) */
+} led_channel_t;
 
 /**
  * @brief Initialize the LED handler and configure the GPIO and timer.
@@ -52,56 +40,88 @@ void led_handler_deinit(void);
 void led_handler_tick(void);
 
 /**
- * @brief Apply a predefined LED blinking pattern based on system state.
+ * @brief Apply a predefined LED blinking pattern to one channel.
  *
+ * @param ch      The LED channel to drive.
  * @param pattern The desired pattern to apply from led_pattern_t.
+ * @return Command sequence number (see led_cmd_applied()), 0 if rejected.
+ */
+uint32_t led_apply_pattern(led_channel_t ch, led_pattern_t pattern);
+
+/**
+ * @brief Check whether the command `seq` (or a newer one) is already driving the LED.
+ *
+ * @param[out] applied_us When its first edge was driven (esp_timer time, low 32 bits). May be NULL.
  */
-void led_apply_pattern(led_pattern_t pattern);
+bool led_cmd_applied(led_channel_t ch, uint32_t seq, uint32_t *applied_us);
 
 /**
- * @brief Immediately turn ON the LED (no timer logic).
+ * @brief Immediately turn ON a channel's LED (no timer logic).
  */
-void led_on(void);
+void led_on(led_channel_t ch);
 
 /**
- * @brief Turn the LED OFF (static).
+ * @brief Turn a channel's LED OFF (static).
  */
-void led_off(void);
+void led_off(led_channel_t ch);
 
 /**
- * @brief Set the LED to a static state (ON or OFF), bypassing pattern logic.
+ * @brief Stop whatever pattern a channel is playing and leave its LED OFF.
+ */
+void led_stop(led_channel_t ch);
+
+/**
+ * @brief Set a channel's LED to a static state (ON or OFF), bypassing pattern logic.
  *
+ * @param ch Channel to drive.
  * @param on Pass true to turn ON, false to turn OFF.
  */
-void led_set_static(bool on);
+void led_set_static(led_channel_t ch, bool on);
 
 /**
- * @brief Blink LED with custom frequency and duty cycle.
+ * @brief Blink a channel's LED with custom frequency and duty cycle.
  *
+ * @param ch Channel to drive
  * @param frequency_hz Blink frequency in Hz
  * @param duty_cycle_percent Percentage of ON time (0–100)
  */
-void led_blink(float frequency_hz, float duty_cycle_percent);
+void led_blink(led_channel_t ch, float frequency_hz, float duty_cycle_percent);
+
+/**
+ * @brief Repeat bursts of `blinks` even ON/OFF pairs separated by `pause_us`.
+ *
+ * @param ch Channel to drive.
+ * @param blinks ON/OFF pairs per burst.
+ * @param blink_us Duration of each ON and each OFF phase.
+ * @param pause_us Gap between bursts.
+ */
+void led_burst(led_channel_t ch, uint8_t blinks, uint32_t blink_us, uint32_t pause_us);
 
 /**
- * @brief Placeholder for pulse mode (uses PWM fading or toggling).
+ * @brief Pulse ("breathe") a channel's LED using LEDC hardware ramps.
  *
+ * @param ch Channel to drive.
  * @param frequency_hz Pulse frequency in Hz.
  */
-void led_pulse(float frequency_hz);
+void led_pulse(led_channel_t ch, float frequency_hz);
 
 /**
- * @brief Placeholder for fading effect (e.g., fade in/out using LEDC).
+ * @brief Fade a channel's LED to the opposite level (ON ↔ OFF) using LEDC.
  *
+ * @param ch Channel to drive.
  * @param duration_ms Duration of fade in milliseconds.
  */
-void led_fade(uint32_t duration_ms);
+void led_fade(led_channel_t ch, uint32_t duration_ms);
 
 /**
  * @brief Print debug status of the LED handler.
  * This function provides detailed information about the current LED state,
- * including active patterns, burst states, and timer validity.
- * It is only available in DEV_MODE.
+ * including active patterns, burst states, timer validity and per-pattern
+ * edge lateness (min/mean/max and histogram) of the deadline scheduler.
+ * The lateness and mailbox statistics are always printed; the per-channel
+ * state and the timer are only shown in DEV_MODE. That state belongs to the LED
+ * timer callback: it is printed from a copy the callback takes on request, so call
+ * this from a task that may block (up to 100 ms), never from the esp_timer task.
  */
 void led_debug_status(void);
 
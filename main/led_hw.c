@@ -0,0 +1,182 @@
+// File: main/led_hw.c
+// ==========================================================================================
+// RMT and LEDC backends for the LED handler.
+// - RMT: a pattern is encoded once (led_wave.c) and replayed with loop_count = -1,
+//   so steady-state blinking costs no CPU wakeups at all.
+// - LEDC: hardware brightness ramps used by led_pulse() and led_fade().
+// ==========================================================================================
+
+#include "led_hw.h"
+#include "led_wave.h"
+#include "driver/rmt_tx.h"
+#include "driver/ledc.h"
+#include "esp_log.h"
+#include "tlog.h"
+
+// === RMT Configuration ===
+#define LED_RMT_RESOLUTION_HZ   1000000         // 1us ticks
+#define LED_RMT_MEM_SYMBOLS     48              // One RMT memory block; looped data must fit
+#define LED_RMT_DATA_SYMBOLS    (LED_RMT_MEM_SYMBOLS - 1)   // The last one holds the end marker
+#define LED_FADE_MIN_MS         1               // A 0 ms LEDC fade is rejected by the driver
+
+// === LEDC Configuration ===
+#define LED_LEDC_MODE           LEDC_LOW_SPEED_MODE
+#define LED_LEDC_TIMER          LEDC_TIMER_0
+#define LED_LEDC_FREQ_HZ        5000            // PWM carrier, well above flicker
+#define LED_LEDC_DUTY_RES       LEDC_TIMER_13_BIT
+#define LED_LEDC_DUTY_MAX       ((1u << 13) - 1)
+
+_Static_assert(sizeof(led_wave_symbol_t) == sizeof(rmt_symbol_word_t),
+               "led_wave_symbol_t must match rmt_symbol_word_t");
+
+static const char *TAG = "LED_HW";
+
+// === Static Internal State ===
+
+static rmt_channel_handle_t rmt_chan[LED_CHANNEL_COUNT];            ///< NULL = not on RMT
+static rmt_encoder_handle_t copy_encoder = NULL;                    ///< Shared, stateless
+static led_wave_symbol_t symbols[LED_CHANNEL_COUNT][LED_RMT_MEM_SYMBOLS]; ///< Must outlive TX
+
+static bool ledc_ready = false;                                     ///< Timer + fade ISR installed
+static bool ledc_attached[LED_CHANNEL_COUNT];                       ///< Pin routed to LEDC
+
+// === RMT Backend ===
+
+bool led_hw_play(led_channel_t ch, gpio_num_t gpio, const led_pattern_desc_t *desc) {
+    led_wave_t wave;
+    if (led_wave_encode(desc, LED_RMT_RESOLUTION_HZ, symbols[ch],
+                        LED_RMT_DATA_SYMBOLS, &wave) != 0) {
+        return false;
+    }
+
+    if (!copy_encoder) {
+        rmt_copy_encoder_config_t enc_cfg = {};
+        if (rmt_new_copy_encoder(&enc_cfg, &copy_encoder) != ESP_OK) {
+            TLOGW(TAG, "No RMT copy encoder, using timer path");
+            return false;
+        }
+    }
+
+    if (!rmt_chan[ch]) {
+        rmt_tx_channel_config_t tx_cfg = {
+            .gpio_num = gpio,
+            .clk_src = RMT_CLK_SRC_DEFAULT,
+            .resolution_hz = LED_RMT_RESOLUTION_HZ,
+            .mem_block_symbols = LED_RMT_MEM_SYMBOLS,
+            .trans_queue_depth = 1,
+        };
+        if (rmt_new_tx_channel(&tx_cfg, &rmt_chan[ch]) != ESP_OK) {
+            TLOGW(TAG, "[CH%d] No free RMT channel, using timer path", ch);
+            rmt_chan[ch] = NULL;
+            return false;
+        }
+        rmt_enable(rmt_chan[ch]);
+    }
+
+    rmt_transmit_config_t tx = {
+        .loop_count = wave.loop ? -1 : 0,   // -1 = replay forever
+        .flags.eot_level = 0,               // Hold OFF when a one-shot pattern ends
+    };
+    esp_err_t err = rmt_transmit(rmt_chan[ch], copy_encoder, symbols[ch],
+                                 wave.count * sizeof(led_wave_symbol_t), &tx);
+    if (err != ESP_OK) {
+        TLOGW(TAG, "[CH%d] rmt_transmit failed: %s", ch, esp_err_to_name(err));
+        led_hw_release(ch, gpio);
+        return false;
+    }
+
+    TLOGI(TAG, "[CH%d] %s offloaded to RMT (%u symbols, %s)", ch, desc->name,
+             (unsigned)wave.count, wave.loop ? "looped" : "one-shot");
+    return true;
+}
+
+// === LEDC Backend ===
+
+/**
+ * @brief Route a channel's pin to LEDC, installing the shared timer and fade service once.
+ */
+static esp_err_t led_hw_ledc_attach(led_channel_t ch, gpio_num_t gpio, bool on) {
+    if (!ledc_ready) {
+        ledc_timer_config_t timer_cfg = {
+            .speed_mode = LED_LEDC_MODE,
+            .duty_resolution = LED_LEDC_DUTY_RES,
+            .timer_num = LED_LEDC_TIMER,
+            .freq_hz = LED_LEDC_FREQ_HZ,
+            .clk_cfg = LEDC_AUTO_CLK,
+        };
+        esp_err_t err = ledc_timer_config(&timer_cfg);
+        if (err == ESP_OK) {
+            err = ledc_fade_func_install(0);
+        }
+        if (err != ESP_OK) {
+            TLOGE(TAG, "LEDC init failed: %s", esp_err_to_name(err));
+            return err;
+        }
+        ledc_ready = true;
+    }
+
+    ledc_channel_config_t chan_cfg = {
+        .gpio_num = gpio,
+        .speed_mode = LED_LEDC_MODE,
+        .channel = (ledc_channel_t)ch,
+        .timer_sel = LED_LEDC_TIMER,
+        .duty = on ? LED_LEDC_DUTY_MAX : 0,
+        .hpoint = 0,
+    };
+    esp_err_t err = ledc_channel_config(&chan_cfg);
+    if (err == ESP_OK) {
+        ledc_attached[ch] = true;
+    }
+    return err;
+}
+
+esp_err_t led_hw_fade(led_channel_t ch, gpio_num_t gpio, bool from_on, bool to_on,
+                      uint32_t duration_ms) {
+    if (!ledc_attached[ch]) {
+        esp_err_t err = led_hw_ledc_attach(ch, gpio, from_on);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (duration_ms < LED_FADE_MIN_MS) {
+        duration_ms = LED_FADE_MIN_MS;          // Sub-ms pulse phases, led_fade(ch, 0)
+    }
+
+    esp_err_t err = ledc_set_fade_with_time(LED_LEDC_MODE, (ledc_channel_t)ch,
+                                            to_on ? LED_LEDC_DUTY_MAX : 0, duration_ms);
+    if (err == ESP_OK) {
+        err = ledc_fade_start(LED_LEDC_MODE, (ledc_channel_t)ch, LEDC_FADE_NO_WAIT);
+    }
+    return err;
+}
+
+// === Release ===
+
+void led_hw_release(led_channel_t ch, gpio_num_t gpio) {
+    bool was_hw = false;
+
+    if (rmt_chan[ch]) {
+        rmt_disable(rmt_chan[ch]);          // Aborts a looping transmission
+        rmt_del_channel(rmt_chan[ch]);
+        rmt_chan[ch] = NULL;
+        was_hw = true;
+    }
+    if (ledc_attached[ch]) {
+        ledc_stop(LED_LEDC_MODE, (ledc_channel_t)ch, 0);
+        ledc_attached[ch] = false;
+        was_hw = true;
+    }
+
+    if (was_hw) {
+        // Route the pin back to the plain GPIO output signal
+        gpio_config_t io_conf = {
+            .pin_bit_mask = 1ULL << gpio,
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE
+        };
+        gpio_config(&io_conf);
+        gpio_set_level(gpio, 0);
+    }
+}
@@ -0,0 +1,50 @@
+// File: main/led_hw.h
+// ==========================================================================================
+// Hardware LED backends: RMT (looped blink waveforms) and LEDC (pulse/fade).
+// A channel's pin belongs to exactly one of GPIO, RMT or LEDC at a time;
+// led_hw_release() always hands it back to plain GPIO output.
+// ==========================================================================================
+
+#ifndef LED_HW_H
+#define LED_HW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "led_handler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Play a pattern on the channel's RMT TX channel, looped in hardware.
+ *
+ * @return true if the pattern now runs without CPU involvement; false if it
+ *         cannot be offloaded (static, too long for RMT memory, or no RMT
+ *         channel available) and the caller should use the timer path.
+ */
+bool led_hw_play(led_channel_t ch, gpio_num_t gpio, const led_pattern_desc_t *desc);
+
+/**
+ * @brief Start one LEDC brightness ramp on a channel.
+ *
+ * Attaches the pin to LEDC on first use, starting at `from_on` brightness.
+ *
+ * @param to_on       Target: full brightness (true) or OFF (false).
+ * @param duration_ms Ramp length (0 is taken as 1 ms).
+ */
+esp_err_t led_hw_fade(led_channel_t ch, gpio_num_t gpio, bool from_on, bool to_on,
+                      uint32_t duration_ms);
+
+/**
+ * @brief Stop any RMT/LEDC activity on the channel and return its pin to GPIO (OFF).
+ */
+void led_hw_release(led_channel_t ch, gpio_num_t gpio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_HW_H
@@ -0,0 +1,70 @@
+// File: main/led_jitter.c
+// ==========================================================================================
+// Lateness bookkeeping for the LED scheduler: min/max/mean and a log-ish histogram.
+// Written from the LED timer callback only; readers accept slightly torn snapshots.
+// ==========================================================================================
+
+#include <stddef.h>
+#include <string.h>
+#include "led_jitter.h"
+
+// Bucket upper bounds in microseconds: <10, <50, <100, <500, <1ms, <5ms, <10ms, >=10ms
+static const uint32_t bucket_limit_us[LED_JITTER_BUCKETS - 1] = {
+    10, 50, 100, 500, 1000, 5000, 10000
+};
+
+static led_jitter_stats_t stats[LED_PATTERN_COUNT];
+
+// === Recording ===
+
+void led_jitter_add(led_pattern_t pattern, int32_t lateness_us) {
+    if ((unsigned)pattern >= LED_PATTERN_COUNT) {
+        return;
+    }
+    led_jitter_stats_t *s = &stats[pattern];
+
+    if (s->count == 0 || lateness_us < s->min_us) s->min_us = lateness_us;
+    if (s->count == 0 || lateness_us > s->max_us) s->max_us = lateness_us;
+    s->count++;
+    s->sum_us += lateness_us;
+
+    // Early edges (negative lateness) land in the first bucket
+    uint32_t mag = lateness_us > 0 ? (uint32_t)lateness_us : 0;
+    int b = 0;
+    while (b < LED_JITTER_BUCKETS - 1 && mag >= bucket_limit_us[b]) {
+        b++;
+    }
+    s->hist[b]++;
+}
+
+void led_jitter_note_resync(led_pattern_t pattern) {
+    if ((unsigned)pattern < LED_PATTERN_COUNT) {
+        stats[pattern].resyncs++;
+    }
+}
+
+void led_jitter_note_offload(led_pattern_t pattern) {
+    if ((unsigned)pattern < LED_PATTERN_COUNT) {
+        stats[pattern].offloaded++;
+    }
+}
+
+// === Access ===
+
+const led_jitter_stats_t *led_jitter_get(led_pattern_t pattern) {
+    if ((unsigned)pattern >= LED_PATTERN_COUNT) {
+        return NULL;
+    }
+    return &stats[pattern];
+}
+
+uint32_t led_jitter_bucket_limit_us(int bucket) {
+    if (bucket < 0 || bucket >= LED_JITTER_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return bucket_limit_us[bucket];
+}
+
+void led_jitter_reset(void) {
+    memset(stats, 0, sizeof(stats));
+}
@@ -0,0 +1,69 @@
+// File: main/led_jitter.h
+// ==========================================================================================
+// Per-pattern lateness statistics of the LED scheduler.
+// Lateness = (time the edge actually ran) - (absolute deadline it was scheduled for).
+// Patterns offloaded to RMT toggle the pin without the timer callback, so they add no
+// samples (and no led_trace records); each such run is counted in `offloaded` instead.
+// Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef LED_JITTER_H
+#define LED_JITTER_H
+
+#include <stdint.h>
+#include "led_pattern.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LED_JITTER_BUCKETS  8   // Histogram buckets, see led_jitter_bucket_limit_us()
+
+/**
+ * @brief Lateness statistics of one pattern (in microseconds).
+ */
+typedef struct {
+    uint32_t count;                         ///< Edges measured
+    int32_t  min_us;                        ///< Earliest edge (can be negative)
+    int32_t  max_us;                        ///< Latest edge
+    int64_t  sum_us;                        ///< Sum of lateness, for the mean
+    uint32_t hist[LED_JITTER_BUCKETS];      ///< Lateness histogram
+    uint32_t resyncs;                       ///< Deadlines dropped because we fell a full phase behind
+    uint32_t offloaded;                     ///< Runs played by RMT (edges not measured)
+} led_jitter_stats_t;
+
+/**
+ * @brief Add one lateness sample to a pattern's statistics.
+ */
+void led_jitter_add(led_pattern_t pattern, int32_t lateness_us);
+
+/**
+ * @brief Count one resync (scheduler skipped ahead instead of catching up).
+ */
+void led_jitter_note_resync(led_pattern_t pattern);
+
+/**
+ * @brief Count one run handed to the RMT backend (its edges are never sampled).
+ */
+void led_jitter_note_offload(led_pattern_t pattern);
+
+/**
+ * @brief Read-only access to a pattern's statistics (NULL if out of range).
+ */
+const led_jitter_stats_t *led_jitter_get(led_pattern_t pattern);
+
+/**
+ * @brief Upper bound (exclusive) of a histogram bucket; the last bucket is open-ended.
+ */
+uint32_t led_jitter_bucket_limit_us(int bucket);
+
+/**
+ * @brief Clear all statistics.
+ */
+void led_jitter_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_JITTER_H
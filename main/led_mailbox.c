@@ -0,0 +1,154 @@
+// File: main/led_mailbox.c
+// ==========================================================================================
+// Slot pool + per-channel atomic mailbox word.
+//
+// A mailbox word packs (slot index + 1, per-channel version) into 32 bits so it stays
+// lock-free on the 32-bit Xtensa cores; 0 in the low byte means "empty". Every publish bumps the version in the same
+// CAS that installs the slot, so versions follow publish order exactly.
+// Ownership of a slot moves only through atomic operations, so no slot is ever
+// read while being written:
+//   producer: claim a FREE slot (CAS) -> fill -> CAS it into mailbox[ch]
+//             -> a slot it displaced was never seen by the consumer: free it
+//   consumer: CAS mailbox[ch] to EMPTY -> copy -> free the slot
+// Producers never wait on the consumer; the consumer never waits at all. A producer that
+// finds no free slot in LED_MAILBOX_CLAIM_PASSES scans (yielding between them) drops its
+// command instead of spinning.
+// ==========================================================================================
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "led_mailbox.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#define CLAIM_YIELD()       taskYIELD()
+#else
+#include <sched.h>
+#define CLAIM_YIELD()       sched_yield()
+#endif
+
+// At most one slot per mailbox, one per producer in flight and one for the consumer
+_Static_assert(LED_MAILBOX_SLOTS > LED_SCHED_MAX_CHANNELS, "mailbox pool too small");
+_Static_assert(LED_MAILBOX_SLOTS < 0xFF, "slot index + 1 must fit in 8 bits");
+
+#define BOX_PACK(slot, ver) (((uint32_t)(ver) << 8) | (slot))  // slot = index + 1, 0 = empty
+#define BOX_SLOT(word)      ((word) & 0xFFu)
+#define BOX_VER(word)       ((word) >> 8)
+#define BOX_VER_MAX         0xFFFFFFu
+
+/**
+ * @brief Version after `ver`, skipping 0 (the "nothing posted yet" sequence number).
+ */
+static inline uint32_t ver_next(uint32_t ver) {
+    return ver >= BOX_VER_MAX ? 1 : ver + 1;
+}
+
+typedef struct {
+    atomic_bool busy;   ///< Claimed by a producer, a mailbox or the consumer
+    led_cmd_t   cmd;
+} led_mailbox_slot_t;
+
+static led_mailbox_slot_t slots[LED_MAILBOX_SLOTS];
+static atomic_uint mailbox[LED_SCHED_MAX_CHANNELS];     ///< BOX_PACK(slot, version)
+
+static atomic_uint claim_hint;
+static atomic_uint stat_posted;
+static atomic_uint stat_taken;
+static atomic_uint stat_superseded;
+static atomic_uint stat_dropped;
+
+// === Slot Pool ===
+
+/**
+ * @brief Claim a free slot, scanning the pool at most LED_MAILBOX_CLAIM_PASSES times and
+ *        yielding between scans so the holders of the slots can run.
+ *
+ * @return Slot index, -1 if none came free.
+ */
+static int slot_claim(void) {
+    unsigned start = atomic_fetch_add_explicit(&claim_hint, 1, memory_order_relaxed);
+
+    for (unsigned pass = 0; pass < LED_MAILBOX_CLAIM_PASSES; pass++) {
+        if (pass) {
+            CLAIM_YIELD();
+        }
+        for (unsigned i = 0; i < LED_MAILBOX_SLOTS; i++) {
+            unsigned idx = (start + i) % LED_MAILBOX_SLOTS;
+            bool expected = false;
+            if (!atomic_load_explicit(&slots[idx].busy, memory_order_relaxed) &&
+                atomic_compare_exchange_strong_explicit(&slots[idx].busy, &expected, true,
+                                                        memory_order_acquire,
+                                                        memory_order_relaxed)) {
+                return (int)idx;
+            }
+        }
+    }
+    return -1;
+}
+
+static inline void slot_release(unsigned idx) {
+    atomic_store_explicit(&slots[idx].busy, false, memory_order_release);
+}
+
+// === Producer Side ===
+
+uint32_t led_mailbox_post(uint8_t ch, const led_cmd_t *cmd) {
+    if (ch >= LED_SCHED_MAX_CHANNELS) {
+        return 0;
+    }
+
+    int idx = slot_claim();
+    if (idx < 0) {
+        atomic_fetch_add_explicit(&stat_dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+    slots[idx].cmd = *cmd;
+
+    uint32_t cur = atomic_load_explicit(&mailbox[ch], memory_order_acquire);
+    uint32_t next;
+    do {
+        next = BOX_PACK(idx + 1, ver_next(BOX_VER(cur)));
+    } while (!atomic_compare_exchange_weak_explicit(&mailbox[ch], &cur, next,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire));
+
+    atomic_fetch_add_explicit(&stat_posted, 1, memory_order_relaxed);
+    if (BOX_SLOT(cur)) {
+        atomic_fetch_add_explicit(&stat_superseded, 1, memory_order_relaxed);
+        slot_release(BOX_SLOT(cur) - 1);
+    }
+    return BOX_VER(next);
+}
+
+// === Consumer Side ===
+
+bool led_mailbox_take(uint8_t ch, led_cmd_t *out) {
+    if (ch >= LED_SCHED_MAX_CHANNELS) {
+        return false;
+    }
+
+    uint32_t cur = atomic_load_explicit(&mailbox[ch], memory_order_acquire);
+    do {
+        if (!BOX_SLOT(cur)) {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&mailbox[ch], &cur,
+                                                    BOX_PACK(0, BOX_VER(cur)),
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire));
+
+    unsigned idx = BOX_SLOT(cur) - 1;
+    *out = slots[idx].cmd;
+    out->seq = BOX_VER(cur);
+    slot_release(idx);
+    atomic_fetch_add_explicit(&stat_taken, 1, memory_order_relaxed);
+    return true;
+}
+
+void led_mailbox_get_stats(led_mailbox_stats_t *out) {
+    out->posted = atomic_load(&stat_posted);
+    out->taken = atomic_load(&stat_taken);
+    out->superseded = atomic_load(&stat_superseded);
+    out->dropped = atomic_load(&stat_dropped);
+}
@@ -0,0 +1,88 @@
+// File: main/led_mailbox.h
+// ==========================================================================================
+// Lock-free handoff of LED commands from any task to the LED timer callback.
+// Each channel has a one-entry "latest wins" mailbox; callers claim a slot from a
+// pool, fill it and publish it with a compare-and-swap, the timer callback takes it
+// the same way. A retried CAS always means another caller got through: lock-free,
+// but not wait-free (a caller can in theory retry for as long as others keep winning).
+// Claiming a slot is bounded: with the pool exhausted the command is dropped and counted.
+// Pure C11 (stdatomic), no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef LED_MAILBOX_H
+#define LED_MAILBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_sched.h"      // LED_SCHED_MAX_CHANNELS
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LED_MAILBOX_SLOTS   24  // Command slots: channels in flight + concurrent callers + consumer
+#define LED_MAILBOX_CLAIM_PASSES 3  // Pool scans before a post gives up
+
+/**
+ * @brief What a command asks the timer callback to do with a channel.
+ */
+typedef enum {
+    LED_CMD_PATTERN,    ///< Play predefined pattern `pattern`
+    LED_CMD_BLINK,      ///< Custom blink: a = on_us, b = off_us
+    LED_CMD_BURST,      ///< Custom burst: a = on_us = off_us, b = pause_us, count blinks
+    LED_CMD_PULSE,      ///< LEDC breathing: a = half period in us
+    LED_CMD_FADE,       ///< One LEDC ramp to the opposite level: a = duration in ms
+    LED_CMD_OFF,        ///< Stop the channel and turn it OFF
+} led_cmd_op_t;
+
+/**
+ * @brief A pattern change request (copied by value into a mailbox slot).
+ */
+typedef struct {
+    uint8_t  op;        ///< led_cmd_op_t
+    uint8_t  pattern;   ///< led_pattern_t for LED_CMD_PATTERN
+    uint8_t  count;     ///< Blinks per burst for LED_CMD_BURST
+    uint32_t a;         ///< Op-specific argument
+    uint32_t b;         ///< Op-specific argument
+    uint32_t seq;       ///< Per-channel publish order (24-bit, never 0), set when published
+} led_cmd_t;
+
+/**
+ * @brief Mailbox counters (monotonic).
+ */
+typedef struct {
+    uint32_t posted;        ///< Commands published
+    uint32_t taken;         ///< Commands picked up by the consumer
+    uint32_t superseded;    ///< Commands replaced by a newer one before pickup
+    uint32_t dropped;       ///< Commands not posted: no free slot (not in posted)
+} led_mailbox_stats_t;
+
+/**
+ * @brief Publish a command for a channel. Never blocks (at most a few yields while the
+ *        slot pool is exhausted); callable from any task.
+ *
+ * A command still pending on the same channel is superseded (latest wins).
+ * Sequence numbers wrap from 0xFFFFFF to 1: 0 stays free to mean "nothing posted".
+ *
+ * @return Per-channel sequence number assigned to the command, 0 if `ch` is out of range
+ *         or no slot came free (counted in dropped).
+ */
+uint32_t led_mailbox_post(uint8_t ch, const led_cmd_t *cmd);
+
+/**
+ * @brief Take the pending command of a channel (single consumer only).
+ *
+ * @return true and *out filled if a command was pending.
+ */
+bool led_mailbox_take(uint8_t ch, led_cmd_t *out);
+
+/**
+ * @brief Snapshot of the mailbox counters.
+ */
+void led_mailbox_get_stats(led_mailbox_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_MAILBOX_H
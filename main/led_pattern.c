@@ -0,0 +1,93 @@
+// File: main/led_pattern.c
+// ==========================================================================================
+// Const pattern table and the generic interpreter that walks it.
+// Every predefined LED pattern is one row; adding a pattern means adding a row.
+// ==========================================================================================
+
+#include <stddef.h>
+#include "led_pattern.h"
+
+// === Pattern Table ===
+
+static const led_pattern_desc_t pattern_table[LED_PATTERN_COUNT] = {
+    [LED_PATTERN_DEV_MODE] = {
+        .name = "DEV_MODE",
+        .end = LED_END_STATIC_ON,
+    },
+    [LED_PATTERN_OPERATIONAL] = {
+        .name = "OPERATIONAL",
+        .timing = { OPERATIONAL_BLINK_ON_US, OPERATIONAL_BLINK_OFF_US },
+        .end = LED_END_LOOP,
+    },
+    [LED_PATTERN_RTV_ACTIVE] = {
+        .name = "RTV",
+        .timing = { RTV_BLINK_ON_US, RTV_BLINK_OFF_US },
+        .pause_us = RTV_PAUSE_US,
+        .cycles = RTV_BURST_CYCLES,
+        .end = LED_END_LOOP,
+    },
+    [LED_PATTERN_TETHERED] = {
+        .name = "TETHERED",
+        .timing = { TETHERED_BLINK_ON_US, TETHERED_BLINK_OFF_US },
+        .end = LED_END_LOOP,
+    },
+    [LED_PATTERN_UNTETHERED] = {
+        .name = "UNTETHERED",
+        .timing = { UNTETHERED_BURST_ON_US, UNTETHERED_BURST_OFF_US },
+        .pause_us = UNTETHERED_PAUSE_US,
+        .cycles = UNTETHERED_BURST_CYCLES,
+        .end = LED_END_LOOP,
+    },
+    [LED_PATTERN_HALTED_ENTRY] = {
+        .name = "HALTED",
+        .timing = { HALTED_BLINK_ON_US, HALTED_BLINK_OFF_US },
+        .cycles = HALTED_MAX_CYCLES,
+        .end = LED_END_HOLD_OFF,
+    },
+    [LED_PATTERN_TRANSFER_COMPLETE] = {
+        .name = "TRANSFER_COMPLETE",
+        .timing = { TRANSFER_BLINK_ON_US, TRANSFER_BLINK_OFF_US },
+        .end = LED_END_LOOP,
+    },
+};
+
+// === Lookup ===
+
+const led_pattern_desc_t *led_pattern_get(led_pattern_t pattern) {
+    if ((unsigned)pattern >= LED_PATTERN_COUNT) {
+        return NULL;
+    }
+    return &pattern_table[pattern];
+}
+
+// === Interpreter ===
+
+uint32_t led_pattern_start(led_pattern_state_t *st, const led_pattern_desc_t *desc) {
+    st->desc = desc;
+    st->cycle = 0;
+    st->level = (desc->end == LED_END_STATIC_ON) || desc->timing.on_us > 0;
+
+    // Static patterns need no timer; blinking ones hold their first ON phase, the point
+    // an RMT replay of the same row starts at (led_wave.c)
+    if (desc->end == LED_END_STATIC_ON) {
+        return 0;
+    }
+    return st->level ? desc->timing.on_us : desc->timing.off_us;
+}
+
+uint32_t led_pattern_step(led_pattern_state_t *st) {
+    const led_pattern_desc_t *d = st->desc;
+
+    st->level = !st->level;
+    if (st->level) {
+        return d->timing.on_us;
+    }
+
+    // Only OFF edges close an ON/OFF pair
+    if (d->cycles == 0 || ++st->cycle < d->cycles) {
+        return d->timing.off_us;
+    }
+
+    st->cycle = 0;
+    return (d->end == LED_END_LOOP) ? d->pause_us : 0;
+}
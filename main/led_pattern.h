@@ -0,0 +1,134 @@
+// File: main/led_pattern.h
+// ==========================================================================================
+// Table-driven LED pattern descriptions and the generic step interpreter.
+// This module is pure C (no ESP-IDF includes) so it can be compiled on the host.
+// ==========================================================================================
+
+#ifndef LED_PATTERN_H
+#define LED_PATTERN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// === Pattern Timings (in microseconds) ===
+
+// --- OPERATIONAL pattern ---
+#define OPERATIONAL_BLINK_ON_US  500000          // 500ms ON (1Hz)
+#define OPERATIONAL_BLINK_OFF_US 500000          // 500ms OFF
+
+// --- HALTED_ENTRY pattern ---
+#define HALTED_BLINK_ON_US     100000            // 100ms ON (5Hz)
+#define HALTED_BLINK_OFF_US    100000            // 100ms OFF
+#define HALTED_MAX_CYCLES      10                // Total 2s duration
+
+// --- TRANSFER_COMPLETE pattern ---
+#define TRANSFER_BLINK_ON_US   500000            // 500ms ON (1Hz)
+#define TRANSFER_BLINK_OFF_US  500000            // 500ms OFF
+
+// --- TETHERED pattern ---
+#define TETHERED_BLINK_ON_US   1000000           // 1s ON (0.5Hz)
+#define TETHERED_BLINK_OFF_US  1000000           // 1s OFF
+
+// --- UNTETHERED pattern ---
+#define UNTETHERED_BURST_ON_US   250000          // 250ms ON (2Hz)
+#define UNTETHERED_BURST_OFF_US  250000          // 250ms OFF
+#define UNTETHERED_BURST_CYCLES  10              // 10 blinks per burst
+#define UNTETHERED_PAUSE_US      500000          // 500ms pause between bursts
+
+// --- RTV pattern ---
+#define RTV_BLINK_ON_US          50000           // 50ms ON (10Hz)
+#define RTV_BLINK_OFF_US         50000           // 50ms OFF
+#define RTV_BURST_CYCLES         5               // 5 blinks per burst
+#define RTV_PAUSE_US             500000          // 500ms pause after burst
+
+/**
+ * @brief ON/OFF phase durations of a blinking pattern.
+ */
+typedef struct {
+    uint32_t on_us;
+    uint32_t off_us;
+} led_timing_t;
+
+/**
+ * @enum led_pattern_t
+ * @brief LED blinking patterns for system state indication.
+ */
+typedef enum {
+    LED_PATTERN_DEV_MODE,           /**< Development mode: static ON */
+    LED_PATTERN_OPERATIONAL,        /**< Operational state: 1Hz continuous blinking */
+    LED_PATTERN_RTV_ACTIVE,         /**< Real-Time Video active: 5 fast blinks + pause */
+    LED_PATTERN_TETHERED,           /**< Tethered transfer: 0.5Hz blinking */
+    LED_PATTERN_UNTETHERED,         /**< Untethered transfer: 10x 2Hz blinks + pause */
+    LED_PATTERN_HALTED_ENTRY,       /**< HALTED state: 5Hz blink for 2 seconds, then OFF */
+    LED_PATTERN_TRANSFER_COMPLETE,  /**< Transfer done: 1Hz blinking until change */
+    LED_PATTERN_COUNT               /**< Number of predefined patterns (not a pattern) */
+} led_pattern_t;
+
+/**
+ * @enum led_end_t
+ * @brief Terminal action taken when a pattern completes `cycles` ON/OFF pairs.
+ */
+typedef enum {
+    LED_END_LOOP,       /**< Wait `pause_us` (instead of the last OFF) and start over */
+    LED_END_HOLD_OFF,   /**< Stop scheduling and leave the LED OFF */
+    LED_END_STATIC_ON,  /**< No blinking at all: the LED is held ON from the start */
+} led_end_t;
+
+/**
+ * @brief One row of the pattern table.
+ *
+ * A pattern is a run of `cycles` ON/OFF pairs followed by a terminal action.
+ * `cycles == 0` means the pattern never reaches its terminal action (plain blinking).
+ */
+typedef struct {
+    const char  *name;      ///< Short label used in logs
+    led_timing_t timing;    ///< ON/OFF durations
+    uint32_t     pause_us;  ///< Gap after the last OFF of a burst (LED_END_LOOP only)
+    uint16_t     cycles;    ///< ON/OFF pairs per burst (0 = unbounded)
+    uint8_t      end;       ///< Terminal action (led_end_t)
+} led_pattern_desc_t;
+
+/**
+ * @brief Interpreter state: everything needed to produce the next edge.
+ */
+typedef struct {
+    const led_pattern_desc_t *desc; ///< Pattern being played (NULL = idle)
+    uint16_t cycle;                 ///< Completed ON/OFF pairs in the current burst
+    bool level;                     ///< Current LED level (true = ON)
+} led_pattern_state_t;
+
+/**
+ * @brief Look up the descriptor of a predefined pattern.
+ *
+ * @return Pointer into the const pattern table, or NULL if `pattern` is out of range.
+ */
+const led_pattern_desc_t *led_pattern_get(led_pattern_t pattern);
+
+/**
+ * @brief Reset the interpreter to the start of a pattern.
+ *
+ * Every pattern starts with the LED ON: blinking ones with their first ON phase (as the
+ * RMT waveform does), LED_END_STATIC_ON for good. A 0 us ON phase starts OFF instead.
+ *
+ * @return Delay in microseconds until the first edge, or 0 if no timer is needed.
+ */
+uint32_t led_pattern_start(led_pattern_state_t *st, const led_pattern_desc_t *desc);
+
+/**
+ * @brief Advance the interpreter by one edge.
+ *
+ * Toggles `st->level` and returns how long the new level must be held.
+ *
+ * @return Delay in microseconds until the next edge, or 0 when the pattern has ended.
+ */
+uint32_t led_pattern_step(led_pattern_state_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_PATTERN_H
@@ -0,0 +1,124 @@
+// File: main/led_sched.c
+// ==========================================================================================
+// Indexed binary min-heap of LED channel deadlines.
+// All operations are O(log n) with n <= LED_SCHED_MAX_CHANNELS; no allocation.
+// ==========================================================================================
+
+#include "led_sched.h"
+
+// === Heap Helpers ===
+
+static inline bool earlier(const led_sched_t *s, int i, int j) {
+    return s->deadline_us[s->heap[i]] < s->deadline_us[s->heap[j]];
+}
+
+static inline void swap_slots(led_sched_t *s, int i, int j) {
+    uint8_t a = s->heap[i];
+    uint8_t b = s->heap[j];
+    s->heap[i] = b;
+    s->heap[j] = a;
+    s->pos[b] = (int8_t)i;
+    s->pos[a] = (int8_t)j;
+}
+
+static void sift_up(led_sched_t *s, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!earlier(s, i, parent)) {
+            break;
+        }
+        swap_slots(s, i, parent);
+        i = parent;
+    }
+}
+
+static void sift_down(led_sched_t *s, int i) {
+    for (;;) {
+        int l = 2 * i + 1;
+        int r = l + 1;
+        int min = i;
+        if (l < s->size && earlier(s, l, min)) min = l;
+        if (r < s->size && earlier(s, r, min)) min = r;
+        if (min == i) {
+            break;
+        }
+        swap_slots(s, i, min);
+        i = min;
+    }
+}
+
+// === Public API ===
+
+void led_sched_init(led_sched_t *s) {
+    s->size = 0;
+    for (int i = 0; i < LED_SCHED_MAX_CHANNELS; i++) {
+        s->pos[i] = -1;
+    }
+}
+
+void led_sched_set(led_sched_t *s, uint8_t ch, int64_t deadline_us) {
+    if (ch >= LED_SCHED_MAX_CHANNELS) {
+        return;
+    }
+
+    int i = s->pos[ch];
+    if (i < 0) {
+        i = s->size++;
+        s->heap[i] = ch;
+        s->pos[ch] = (int8_t)i;
+        s->deadline_us[ch] = deadline_us;
+        sift_up(s, i);
+        return;
+    }
+
+    int64_t old = s->deadline_us[ch];
+    s->deadline_us[ch] = deadline_us;
+    if (deadline_us < old) {
+        sift_up(s, i);
+    } else {
+        sift_down(s, i);
+    }
+}
+
+void led_sched_remove(led_sched_t *s, uint8_t ch) {
+    if (ch >= LED_SCHED_MAX_CHANNELS || s->pos[ch] < 0) {
+        return;
+    }
+
+    int i = s->pos[ch];
+    int last = --s->size;
+    if (i != last) {
+        swap_slots(s, i, last);
+    }
+    s->pos[ch] = -1;
+
+    // The moved element may need to go either way
+    if (i < s->size) {
+        uint8_t moved = s->heap[i];
+        sift_up(s, i);
+        if (s->pos[moved] == i) {
+            sift_down(s, i);
+        }
+    }
+}
+
+bool led_sched_peek(const led_sched_t *s, int64_t *deadline_us) {
+    if (s->size == 0) {
+        return false;
+    }
+    *deadline_us = s->deadline_us[s->heap[0]];
+    return true;
+}
+
+int led_sched_pop_due(led_sched_t *s, int64_t now_us, int64_t *deadline_us) {
+    if (s->size == 0 || s->deadline_us[s->heap[0]] > now_us) {
+        return -1;
+    }
+
+    uint8_t ch = s->heap[0];
+    if (deadline_us) {
+        *deadline_us = s->deadline_us[ch];
+    }
+    led_sched_remove(s, ch);
+    return ch;
+}
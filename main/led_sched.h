@@ -0,0 +1,64 @@
+// File: main/led_sched.h
+// ==========================================================================================
+// Deadline min-heap shared by all LED channels.
+// One esp_timer is armed for the earliest deadline; each wakeup pops every channel
+// that is due. Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef LED_SCHED_H
+#define LED_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LED_SCHED_MAX_CHANNELS  16      // Upper bound on channels in one scheduler
+
+/**
+ * @brief Binary min-heap of (deadline, channel) with O(1) lookup of a channel's slot.
+ */
+typedef struct {
+    int64_t deadline_us[LED_SCHED_MAX_CHANNELS];    ///< Deadline per channel (valid if queued)
+    uint8_t heap[LED_SCHED_MAX_CHANNELS];           ///< Channel ids, heap-ordered by deadline
+    int8_t  pos[LED_SCHED_MAX_CHANNELS];            ///< Heap index per channel, -1 = not queued
+    uint8_t size;                                   ///< Channels currently queued
+} led_sched_t;
+
+/**
+ * @brief Empty the scheduler.
+ */
+void led_sched_init(led_sched_t *s);
+
+/**
+ * @brief Queue a channel at an absolute deadline, or move it if already queued.
+ */
+void led_sched_set(led_sched_t *s, uint8_t ch, int64_t deadline_us);
+
+/**
+ * @brief Remove a channel from the queue (no-op if not queued).
+ */
+void led_sched_remove(led_sched_t *s, uint8_t ch);
+
+/**
+ * @brief Earliest deadline in the queue.
+ *
+ * @return true and *deadline_us set, or false if no channel is queued.
+ */
+bool led_sched_peek(const led_sched_t *s, int64_t *deadline_us);
+
+/**
+ * @brief Pop the earliest channel if its deadline is <= now.
+ *
+ * @param deadline_us Optional: receives the popped channel's deadline.
+ * @return Channel id, or -1 if nothing is due.
+ */
+int led_sched_pop_due(led_sched_t *s, int64_t now_us, int64_t *deadline_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_SCHED_H
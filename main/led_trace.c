@@ -0,0 +1,190 @@
+// File: main/led_trace.c
+// ==========================================================================================
+// Single-producer / single-consumer ring of LED edge records.
+// Producer: the esp_timer task (led_timer_callback). Consumer: led_trace_task.
+// Only the consumer formats text, so the timer task never touches the UART.
+// When the ring is full the producer takes the oldest record away from the consumer by
+// advancing the tail itself (CAS); the consumer copies a record and then claims it with
+// the same CAS, discarding the copy if the producer got there first. The callback
+// statistics are published to the consumer through a sequence counter (seqlock).
+// ==========================================================================================
+
+#include <stdatomic.h>
+#include "led_trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "tlog.h"
+#include "esp_timer.h"
+
+#define LED_TRACE_TASK_STACK      3072
+#define LED_TRACE_TASK_PRIO       (tskIDLE_PRIORITY + 1)
+#define LED_TRACE_DRAIN_PERIOD_MS 200
+
+_Static_assert((LED_TRACE_RING_SIZE & (LED_TRACE_RING_SIZE - 1)) == 0,
+               "LED_TRACE_RING_SIZE must be a power of two");
+
+static const char *TAG = "LED_TRACE";
+
+// === Ring State ===
+
+static led_trace_rec_t ring[LED_TRACE_RING_SIZE];
+static atomic_uint head;                        ///< Next slot to write (producer only)
+static atomic_uint tail;                        ///< Oldest record (consumer; producer when full)
+static atomic_uint dropped;                     ///< Oldest records overwritten (ring full)
+
+// === Callback Statistics (written by the producer only) ===
+
+static led_trace_cb_stats_t cb_stats;
+static atomic_uint cb_seq;                      ///< Odd while the producer updates cb_stats
+static atomic_bool cb_stats_reset;              ///< Consumer asks producer to restart stats
+static int64_t cb_window_start_us;              ///< Start of the current stats window (consumer)
+
+static atomic_bool echo_enabled;
+static TaskHandle_t trace_task = NULL;
+
+// === Producer Side ===
+
+void led_trace_record(uint32_t t_us, uint8_t channel, uint8_t pattern,
+                      uint8_t level, uint8_t cycle) {
+    unsigned h = atomic_load_explicit(&head, memory_order_relaxed);
+    unsigned t = atomic_load_explicit(&tail, memory_order_acquire);
+
+    // Full: drop the oldest. A failed CAS means the consumer took it, which makes room too.
+    while (h - t >= LED_TRACE_RING_SIZE) {
+        if (atomic_compare_exchange_weak_explicit(&tail, &t, t + 1, memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            break;
+        }
+    }
+
+    ring[h & (LED_TRACE_RING_SIZE - 1)] = (led_trace_rec_t){ t_us, channel, pattern, level, cycle };
+    atomic_store_explicit(&head, h + 1, memory_order_release);
+}
+
+void led_trace_note_callback(uint32_t duration_us, uint32_t edges) {
+    unsigned seq = atomic_load_explicit(&cb_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&cb_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);  // Odd before any field changes
+    if (atomic_exchange_explicit(&cb_stats_reset, false, memory_order_acquire)) {
+        cb_stats = (led_trace_cb_stats_t){0};
+    }
+    cb_stats.count++;
+    cb_stats.edges += edges;
+    cb_stats.total_us += duration_us;
+    if (duration_us > cb_stats.max_us) {
+        cb_stats.max_us = duration_us;
+    }
+    atomic_store_explicit(&cb_seq, seq + 2, memory_order_release);
+}
+
+// === Consumer Side ===
+
+/**
+ * @brief Take the oldest record.
+ *
+ * @return false if the ring is empty.
+ */
+static bool led_trace_pop(led_trace_rec_t *out) {
+    unsigned t = atomic_load_explicit(&tail, memory_order_acquire);
+
+    while (t != atomic_load_explicit(&head, memory_order_acquire)) {
+        *out = ring[t & (LED_TRACE_RING_SIZE - 1)];
+        if (atomic_compare_exchange_strong_explicit(&tail, &t, t + 1, memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            return true;
+        }
+        // The producer dropped it (maybe mid-copy); t is the new oldest
+    }
+    return false;
+}
+
+/**
+ * @brief Pop and print the pending records, at most one ring's worth.
+ *
+ * @return Number of records consumed.
+ */
+static unsigned led_trace_drain(void) {
+    led_trace_rec_t r;
+    unsigned n = 0;
+
+    while (n < LED_TRACE_RING_SIZE && led_trace_pop(&r)) {
+        TLOGI(TAG, "[%10u us] ch=%u pattern=%u LED %s cycle=%u",
+                 (unsigned)r.t_us, r.channel, r.pattern, r.level ? "ON " : "OFF", r.cycle);
+        n++;
+    }
+    return n;
+}
+
+void led_trace_take_cb_stats(led_trace_cb_stats_t *out) {
+    int64_t now_us = esp_timer_get_time();
+    unsigned seq;
+
+    do {
+        seq = atomic_load_explicit(&cb_seq, memory_order_acquire);
+        *out = cb_stats;
+        atomic_thread_fence(memory_order_acquire);  // Copy before the re-check
+    } while ((seq & 1) || seq != atomic_load_explicit(&cb_seq, memory_order_relaxed));
+    out->window_us = (uint64_t)(now_us - cb_window_start_us);
+    cb_window_start_us = now_us;
+    atomic_store_explicit(&cb_stats_reset, true, memory_order_release);
+}
+
+/**
+ * @brief Low-priority task that drains the ring.
+ *
+ * Wakes periodically (live echo) or immediately when led_trace_dump() notifies it.
+ */
+static void led_trace_task(void *arg) {
+    for (;;) {
+        bool dump = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LED_TRACE_DRAIN_PERIOD_MS)) > 0;
+        bool echo = atomic_load(&echo_enabled);
+
+        if (!dump && !echo) {
+            continue;   // Keep the latest records for the next dump
+        }
+
+        unsigned n = led_trace_drain();
+        if (!dump) {
+            continue;
+        }
+
+        led_trace_cb_stats_t s;
+        led_trace_take_cb_stats(&s);
+        ESP_LOGI(TAG, "=== LED TRACE: %u records, %u overwritten ===",
+                 n, atomic_exchange(&dropped, 0));
+        ESP_LOGI(TAG, "Callback: %u wakeups (%u/s) | %u edges | max %u us | mean %u us | CPU %u us/s",
+                 (unsigned)s.count,
+                 s.window_us ? (unsigned)(s.count * 1000000ULL / s.window_us) : 0,
+                 (unsigned)s.edges, (unsigned)s.max_us,
+                 s.count ? (unsigned)(s.total_us / s.count) : 0,
+                 s.window_us ? (unsigned)(s.total_us * 1000000ULL / s.window_us) : 0);
+    }
+}
+
+// === Public Control ===
+
+void led_trace_init(void) {
+    if (trace_task) {
+        return;
+    }
+    if (xTaskCreate(led_trace_task, "led_trace", LED_TRACE_TASK_STACK, NULL,
+                    LED_TRACE_TASK_PRIO, &trace_task) != pdPASS) {
+        TLOGE(TAG, "Failed to create trace drain task");
+        trace_task = NULL;
+    }
+}
+
+void led_trace_set_echo(bool enable) {
+    atomic_store(&echo_enabled, enable);
+}
+
+void led_trace_dump(void) {
+    if (!trace_task) {
+        TLOGW(TAG, "Trace task not running (led_trace_init not called?)");
+        return;
+    }
+    xTaskNotifyGive(trace_task);
+}
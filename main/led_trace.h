@@ -0,0 +1,87 @@
+// File: main/led_trace.h
+// ==========================================================================================
+// Deferred binary trace of LED edges.
+// The timer callback only stores fixed-size records in a single-producer ring;
+// a low-priority task drains and formats them away from the esp_timer task.
+// Patterns looped by RMT have no callback, so they leave no records (see led_jitter.h).
+// ==========================================================================================
+
+#ifndef LED_TRACE_H
+#define LED_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LED_TRACE_RING_SIZE   64    // Records kept in RAM (must be a power of two)
+
+/**
+ * @brief One LED edge, as recorded from the timer callback (8 bytes).
+ */
+typedef struct {
+    uint32_t t_us;      ///< esp_timer time of the edge (low 32 bits)
+    uint8_t  channel;   ///< led_channel_t that toggled
+    uint8_t  pattern;   ///< led_pattern_t being played
+    uint8_t  level;     ///< New LED level (1 = ON)
+    uint8_t  cycle;     ///< Completed ON/OFF pairs in the current burst
+} led_trace_rec_t;
+
+/**
+ * @brief Callback duration statistics (in microseconds).
+ */
+typedef struct {
+    uint32_t count;     ///< Callbacks measured (= timer wakeups)
+    uint32_t edges;     ///< LED edges served by those callbacks
+    uint32_t max_us;    ///< Longest callback
+    uint64_t total_us;  ///< Sum of all callback durations
+    uint64_t window_us; ///< Wall time covered by these statistics
+} led_trace_cb_stats_t;
+
+/**
+ * @brief Create the low-priority drain task. Safe to call more than once.
+ */
+void led_trace_init(void);
+
+/**
+ * @brief Store one edge record. Lock-free; called only from the LED timer callback.
+ *
+ * If the ring is full the oldest record is overwritten and counted, so the ring always
+ * holds the latest LED_TRACE_RING_SIZE edges.
+ */
+void led_trace_record(uint32_t t_us, uint8_t channel, uint8_t pattern,
+                      uint8_t level, uint8_t cycle);
+
+/**
+ * @brief Account one timer callback (producer side, same task as records).
+ *
+ * @param duration_us Time spent in the callback.
+ * @param edges       Channel edges served by this wakeup.
+ */
+void led_trace_note_callback(uint32_t duration_us, uint32_t edges);
+
+/**
+ * @brief Enable/disable live printing of every record by the drain task.
+ *
+ * When disabled (default), the latest records stay in the ring until led_trace_dump().
+ */
+void led_trace_set_echo(bool enable);
+
+/**
+ * @brief Ask the drain task to print all pending records and the callback statistics.
+ */
+void led_trace_dump(void);
+
+/**
+ * @brief Snapshot and reset the callback duration statistics. Consumer side only; the
+ *        snapshot is consistent (seqlock), the reset happens at the next callback.
+ */
+void led_trace_take_cb_stats(led_trace_cb_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_TRACE_H
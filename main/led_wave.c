@@ -0,0 +1,91 @@
+// File: main/led_wave.c
+// ==========================================================================================
+// Pattern-to-RMT-symbol encoder. Pure function of (pattern row, tick rate).
+// ==========================================================================================
+
+#include "led_wave.h"
+
+// === Emitter ===
+
+/**
+ * @brief Packs halves into symbols while tracking the capacity limit.
+ */
+typedef struct {
+    led_wave_symbol_t *out;
+    size_t max;
+    size_t halves;          ///< Halves emitted so far
+    bool overflow;
+} emitter_t;
+
+static void emit_half(emitter_t *e, bool level, uint32_t ticks) {
+    size_t sym = e->halves / 2;
+    if (sym >= e->max) {
+        e->overflow = true;
+        return;
+    }
+    if ((e->halves & 1) == 0) {
+        e->out[sym].val = 0;
+        e->out[sym].level0 = level;
+        e->out[sym].duration0 = ticks;
+    } else {
+        e->out[sym].level1 = level;
+        e->out[sym].duration1 = ticks;
+    }
+    e->halves++;
+}
+
+static void emit_phase(emitter_t *e, bool level, uint32_t us, uint32_t resolution_hz) {
+    uint64_t ticks = ((uint64_t)us * resolution_hz) / 1000000ULL;
+    while (ticks > 0 && !e->overflow) {
+        uint32_t piece = ticks > LED_WAVE_MAX_HALF_TICKS ? LED_WAVE_MAX_HALF_TICKS : (uint32_t)ticks;
+        emit_half(e, level, piece);
+        ticks -= piece;
+    }
+}
+
+// === Encoder ===
+
+int led_wave_encode(const led_pattern_desc_t *desc, uint32_t resolution_hz,
+                    led_wave_symbol_t *out, size_t max_symbols, led_wave_t *wave) {
+    if (desc->end == LED_END_STATIC_ON) {
+        return -1;
+    }
+
+    emitter_t e = { .out = out, .max = max_symbols };
+    const uint32_t on_us = desc->timing.on_us;
+    const uint32_t off_us = desc->timing.off_us;
+    bool loop = (desc->end == LED_END_LOOP) || desc->cycles == 0;
+
+    if (desc->cycles == 0) {
+        // Plain blinking: one ON/OFF period
+        emit_phase(&e, true, on_us, resolution_hz);
+        emit_phase(&e, false, off_us, resolution_hz);
+    } else {
+        for (uint16_t i = 0; i < desc->cycles; i++) {
+            bool last = (i + 1 == desc->cycles);
+            emit_phase(&e, true, on_us, resolution_hz);
+            emit_phase(&e, false, (last && loop) ? desc->pause_us : off_us, resolution_hz);
+        }
+    }
+
+    // A symbol needs two non-zero halves: split the final half if the count is odd
+    if (!e.overflow && (e.halves & 1)) {
+        led_wave_symbol_t *s = &out[e.halves / 2];
+        uint32_t ticks = s->duration0;
+        if (ticks < 2) {
+            return -2;
+        }
+        s->duration0 = ticks - ticks / 2;
+        s->level1 = s->level0;
+        s->duration1 = ticks / 2;
+        e.halves++;
+    }
+
+    if (e.overflow || e.halves == 0) {
+        return -2;
+    }
+
+    wave->count = e.halves / 2;
+    wave->loop = loop;
+    return 0;
+}
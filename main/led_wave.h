@@ -0,0 +1,69 @@
+// File: main/led_wave.h
+// ==========================================================================================
+// Pure pattern-to-waveform encoder for the hardware LED backend.
+// Turns a pattern table row into RMT symbols (pairs of level/duration halves)
+// that the RMT peripheral can replay, looped, without any CPU involvement.
+// No ESP-IDF includes, so the encoder can be built and checked on the host.
+// ==========================================================================================
+
+#ifndef LED_WAVE_H
+#define LED_WAVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "led_pattern.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LED_WAVE_MAX_HALF_TICKS  0x7FFF     // 15-bit duration field of one RMT half-symbol
+
+/**
+ * @brief One RMT symbol, same bit layout as ESP-IDF's rmt_symbol_word_t.
+ */
+typedef union {
+    struct {
+        uint32_t duration0 : 15;    ///< Ticks of the first half
+        uint32_t level0 : 1;        ///< Level of the first half
+        uint32_t duration1 : 15;    ///< Ticks of the second half
+        uint32_t level1 : 1;        ///< Level of the second half
+    };
+    uint32_t val;
+} led_wave_symbol_t;
+
+/**
+ * @brief Result of encoding one pattern.
+ */
+typedef struct {
+    size_t count;   ///< Symbols written
+    bool   loop;    ///< true: replay forever; false: play once, then hold OFF
+} led_wave_t;
+
+/**
+ * @brief Encode a pattern into RMT symbols.
+ *
+ * The stream starts with the first ON phase, like led_pattern_start(), so a pattern
+ * looks the same on RMT and on the timer. Looping patterns encode exactly one
+ * period (bursts end with their pause instead of the last OFF), so replaying
+ * the buffer forever reproduces the timer-driven waveform. Phases longer than
+ * LED_WAVE_MAX_HALF_TICKS are split across several halves of the same level.
+ * No half is ever zero ticks (a zero duration ends an RMT transmission).
+ *
+ * @param desc          Pattern to encode.
+ * @param resolution_hz RMT tick rate.
+ * @param out           Output symbol buffer.
+ * @param max_symbols   Capacity of `out`.
+ * @param wave          Receives symbol count and loop flag.
+ * @return 0 on success, -1 if the pattern is static (nothing to play),
+ *         -2 if it does not fit in `max_symbols`.
+ */
+int led_wave_encode(const led_pattern_desc_t *desc, uint32_t resolution_hz,
+                    led_wave_symbol_t *out, size_t max_symbols, led_wave_t *wave);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_WAVE_H
@@ -0,0 +1,185 @@
+// File: main/log_lz.c
+// ==========================================================================================
+// LZ4 block format: sequences of
+//   token (literal length:4 | match length - 4:4), [length bytes], literals,
+//   match offset u16 LE, [length bytes]
+// where a 4-bit length of 15 continues in bytes of 255 + a final byte < 255. The last
+// sequence is literals only; matches stop 5 bytes before the end and start at least
+// 12 bytes before it (the reference decoder relies on this).
+// Greedy single-probe matching with backward extension; misses speed up the scan over
+// incompressible stretches.
+// ==========================================================================================
+
+#include <string.h>
+#include "log_lz.h"
+
+#define MIN_MATCH       4
+#define LAST_LITERALS   5
+#define MF_LIMIT        12
+#define MAX_OFFSET      65535
+#define SKIP_SHIFT      5       // Step grows by one every 32 consecutive misses
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LOG_LZ_HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/**
+ * @brief Emit literals [lit, lit + lit_len) and, if mlen, a match. NULL if out of room.
+ */
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *end, const uint8_t *lit, size_t lit_len,
+                             size_t offset, size_t mlen) {
+    size_t need = 1 + lit_len / 255 + 1 + lit_len + (mlen ? 2 + mlen / 255 + 1 : 0);
+    if ((size_t)(end - op) < need) {
+        return NULL;
+    }
+
+    uint8_t *token = op++;
+    *token = (uint8_t)((lit_len < 15 ? lit_len : 15) << 4);
+    if (lit_len >= 15) {
+        op = put_length(op, lit_len - 15);
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (mlen) {
+        size_t ml = mlen - MIN_MATCH;
+        *op++ = (uint8_t)offset;
+        *op++ = (uint8_t)(offset >> 8);
+        *token |= (uint8_t)(ml < 15 ? ml : 15);
+        if (ml >= 15) {
+            op = put_length(op, ml - 15);
+        }
+    }
+    return op;
+}
+
+size_t log_lz_compress(log_lz_t *lz, const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    uint8_t *op = dst;
+    const uint8_t *end = dst + cap;
+    size_t anchor = 0;
+
+    if (len > LOG_LZ_MAX_INPUT) {
+        return 0;
+    }
+    if (len > MF_LIMIT) {
+        size_t limit = len - MF_LIMIT;
+        size_t match_end = len - LAST_LITERALS;
+        size_t ip = 0;
+        unsigned misses = 0;
+
+        memset(lz->table, 0, sizeof(lz->table));
+        while (ip < limit) {
+            uint32_t seq = read32(&src[ip]);
+            uint32_t h = hash4(seq);
+            size_t cand = lz->table[h];
+            lz->table[h] = (uint16_t)ip;
+
+            if (cand >= ip || ip - cand > MAX_OFFSET || read32(&src[cand]) != seq) {
+                ip += 1 + (misses++ >> SKIP_SHIFT);
+                continue;
+            }
+            misses = 0;
+
+            while (ip > anchor && cand > 0 && src[ip - 1] == src[cand - 1]) {
+                ip--;
+                cand--;
+            }
+            size_t mlen = MIN_MATCH;
+            while (ip + mlen < match_end && src[ip + mlen] == src[cand + mlen]) {
+                mlen++;
+            }
+
+            op = put_sequence(op, end, &src[anchor], ip - anchor, ip - cand, mlen);
+            if (!op) {
+                return 0;
+            }
+            ip += mlen;
+            anchor = ip;
+            if (ip - 2 < limit) {
+                lz->table[hash4(read32(&src[ip - 2]))] = (uint16_t)(ip - 2);
+            }
+        }
+    }
+
+    op = put_sequence(op, end, &src[anchor], len - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+int log_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + len;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + cap;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+
+        if (lit == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if ((size_t)(iend - ip) < lit || (size_t)(oend - op) < lit) {
+            return -1;
+        }
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) {
+            break;      // Last sequence: literals only
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return -1;
+        }
+
+        size_t mlen = token & 15;
+        if (mlen == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                mlen += b;
+            } while (b == 255);
+        }
+        mlen += MIN_MATCH;
+        if ((size_t)(oend - op) < mlen) {
+            return -1;
+        }
+        // Byte copy: the match may overlap its own output (runs)
+        const uint8_t *m = op - offset;
+        for (size_t i = 0; i < mlen; i++) {
+            op[i] = m[i];
+        }
+        op += mlen;
+    }
+    return (int)(op - dst);
+}
@@ -0,0 +1,53 @@
+// File: main/log_lz.h
+// ==========================================================================================
+// Small LZ77 block compressor for log blocks (LZ4 block format).
+// Each call compresses one self-contained block: the window is the block itself, so a
+// block decodes on its own and the only state is a match hash table, reset per block.
+// RAM: sizeof(log_lz_t) = 2 << LOG_LZ_HASH_BITS bytes, plus the caller's output buffer
+// (LOG_LZ_BOUND(len) bytes). No heap, no tables in flash.
+// Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef LOG_LZ_H
+#define LOG_LZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LOG_LZ_HASH_BITS
+#define LOG_LZ_HASH_BITS    11      // 2048 entries = 4 KB; 12 gains <1% on 4 KB log blocks
+#endif
+
+#define LOG_LZ_MAX_INPUT    65535   // Positions are kept as uint16_t
+#define LOG_LZ_BOUND(len)   ((len) + (len) / 255 + 16)  // Worst case (incompressible input)
+
+/**
+ * @brief Compressor state (match table). Reused across blocks; not shared between tasks.
+ */
+typedef struct {
+    uint16_t table[1u << LOG_LZ_HASH_BITS];
+} log_lz_t;
+
+/**
+ * @brief Compress `len` bytes (at most LOG_LZ_MAX_INPUT).
+ *
+ * @return Compressed size, or 0 if it would exceed `cap` (store the block raw instead).
+ */
+size_t log_lz_compress(log_lz_t *lz, const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+/**
+ * @brief Decompress one block.
+ *
+ * @return Decompressed size, or -1 if the input is corrupt or does not fit in `cap`.
+ */
+int log_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_LZ_H
@@ -0,0 +1,246 @@
+// File: main/log_query.c
+// ==========================================================================================
+// Query engine: catalog -> segment summary -> block index -> lines.
+// Segments are visited in id order (oldest first), so results come out in log order.
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log_query.h"
+
+typedef struct {
+    union {
+        log_seg_header_t h;
+        uint8_t raw[LOG_SEG_HEADER_SIZE];
+    } hdr;
+    char block[LOG_SEG_BLOCK_SIZE];
+    uint8_t frame[LOG_SEG_FRAME_MAX];
+} query_work_t;
+
+typedef struct {
+    const log_query_t *q;
+    log_query_cb_t cb;
+    void *ctx;
+    log_query_stats_t *st;
+    bool done;
+} query_ctx_t;
+
+void log_query_init(log_query_t *q) {
+    memset(q, 0, sizeof(*q));
+    q->to_ms = UINT32_MAX;
+    q->use_index = true;
+}
+
+// === Matching ===
+
+static bool level_wanted(const log_query_t *q, uint8_t level) {
+    return q->level == 0 || (level >= 1 && level <= q->level);
+}
+
+static bool summary_matches(const log_query_t *q, const log_seg_summary_t *s) {
+    if (q->boot && s->boot != q->boot) {
+        return false;
+    }
+    if (!log_seg_overlaps(s->ts_first, s->ts_last, q->from_ms, q->to_ms)) {
+        return false;
+    }
+    if (q->level == 0) {
+        return s->lines > 0;
+    }
+    for (uint8_t l = 1; l <= q->level && l < LOG_SEG_LEVELS; l++) {
+        if (s->level_lines[l]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool block_matches(const log_query_t *q, const log_seg_index_t *e) {
+    if (!log_seg_overlaps(e->ts_first, e->ts_last, q->from_ms, q->to_ms)) {
+        return false;
+    }
+    return q->level == 0 ? e->lines > 0 : (e->level_mask & ((2u << q->level) - 2)) != 0;
+}
+
+/**
+ * @brief Length of the line at `p` including its newline.
+ */
+static size_t line_len(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    return nl ? (size_t)(nl - p) + 1 : (size_t)(end - p);
+}
+
+static void scan_block(query_ctx_t *c, const char *data, size_t len, uint32_t boot) {
+    const log_query_t *q = c->q;
+    const char *end = data + len;
+    bool unbounded = q->from_ms == 0 && q->to_ms == UINT32_MAX;
+    bool have_ts = false;
+    uint32_t ts = 0;
+
+    // Unprefixed lines at the head of the block take the first timestamp in it
+    for (const char *p = data; p < end; p += line_len(p, end)) {
+        log_line_meta_t m = log_line_meta(p, line_len(p, end));
+        if (m.has_ts) {
+            ts = m.ts;
+            have_ts = true;
+            break;
+        }
+    }
+
+    for (const char *p = data; p < end && !c->done; ) {
+        size_t n = line_len(p, end);
+        const char *line = p;
+        p += n;
+        if (n == 1 && *line == '\n') {
+            continue;   // Block padding
+        }
+
+        log_line_meta_t m = log_line_meta(line, n);
+        c->st->lines++;
+        if (m.has_ts) {
+            ts = m.ts;
+        }
+        bool in_window = have_ts ? (ts >= q->from_ms && ts <= q->to_ms) : unbounded;
+        if (!in_window || !level_wanted(q, m.level)) {
+            continue;
+        }
+
+        c->st->matched++;
+        size_t text = line[n - 1] == '\n' ? n - 1 : n;
+        if (!c->cb(line, text, &m, boot, c->ctx) || (q->max && c->st->matched >= q->max)) {
+            c->done = true;
+        }
+    }
+}
+
+static size_t read_header(query_ctx_t *c, FILE *f, void *buf) {
+    size_t n = fread(buf, 1, LOG_SEG_HEADER_SIZE, f);
+    if (n) {
+        c->st->blocks_read++;
+        c->st->bytes_read += n;
+    }
+    return n;
+}
+
+/**
+ * @brief Read and decode the block at *pos into w->block; advance *pos.
+ */
+static size_t read_block(query_ctx_t *c, query_work_t *w, FILE *f, uint8_t codec, long *pos) {
+    long start = *pos;
+    size_t n = log_seg_read_block(f, codec, pos, w->frame, w->block);
+    if (n) {
+        c->st->blocks_read++;
+        c->st->bytes_read += (uint64_t)(*pos - start);
+    }
+    return n;
+}
+
+// === Segment visits ===
+
+/**
+ * @brief Read every data block of a segment (scan mode, or no usable index).
+ */
+static void scan_segment(query_ctx_t *c, query_work_t *w, FILE *f) {
+    const log_seg_summary_t *s = &w->hdr.h.summary;
+    uint8_t codec = s->codec;
+    uint32_t boot = s->boot;
+    long pos = LOG_SEG_HEADER_SIZE;
+
+    while (!c->done) {
+        size_t n = read_block(c, w, f, codec, &pos);
+        if (n == 0) {
+            break;
+        }
+        scan_block(c, w->block, n, boot);
+    }
+}
+
+static void visit_segment(query_ctx_t *c, query_work_t *w, const char *root, uint32_t id) {
+    const log_seg_summary_t *s = &w->hdr.h.summary;
+    char path[LOG_PATH_MAX];
+
+    log_seg_path(path, sizeof(path), root, id);
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return;     // Deleted by rotation meanwhile
+    }
+    c->st->segments++;
+
+    if (read_header(c, f, w->hdr.raw) != LOG_SEG_HEADER_SIZE ||
+        !log_seg_summary_valid(s) || s->seg_id != id) {
+        fclose(f);
+        return;
+    }
+    if (c->q->boot && s->boot != c->q->boot) {
+        fclose(f);
+        return;
+    }
+
+    if (!c->q->use_index || !s->closed || !log_seg_header_valid(&w->hdr.h)) {
+        scan_segment(c, w, f);
+        fclose(f);
+        return;
+    }
+
+    // Block b starts after the stored sizes of blocks 0..b-1
+    long off = LOG_SEG_HEADER_SIZE;
+    for (uint16_t b = 0; b < s->block_count && !c->done; b++) {
+        const log_seg_index_t *e = &w->hdr.h.index[b];
+        if (block_matches(c->q, e)) {
+            long pos = off;
+            size_t n = read_block(c, w, f, s->codec, &pos);
+            scan_block(c, w->block, n, s->boot);
+        }
+        off += e->size;
+    }
+    fclose(f);
+}
+
+// === Public API ===
+
+int log_query_run(const char *root, const log_query_t *q, log_query_cb_t cb, void *ctx,
+                  log_query_stats_t *stats) {
+    char path[LOG_PATH_MAX];
+    log_catalog_header_t cat;
+
+    memset(stats, 0, sizeof(*stats));
+    snprintf(path, sizeof(path), "%s/%s", root, LOG_CATALOG_FILE);
+    FILE *catalog = fopen(path, "rb");
+    if (!catalog) {
+        return -1;
+    }
+    if (fread(&cat, 1, sizeof(cat), catalog) != sizeof(cat) || !log_catalog_header_valid(&cat)) {
+        fclose(catalog);
+        return -1;
+    }
+    query_work_t *w = malloc(sizeof(*w));
+    if (!w) {
+        fclose(catalog);
+        return -1;
+    }
+
+    query_ctx_t c = { .q = q, .cb = cb, .ctx = ctx, .st = stats };
+    uint32_t first = cat.next_seg > LOG_CATALOG_SLOTS ? cat.next_seg - LOG_CATALOG_SLOTS : 0;
+
+    for (uint32_t id = first; id < cat.next_seg && !c.done; id++) {
+        if (q->use_index) {
+            log_seg_summary_t s;
+            if (fseek(catalog, log_catalog_slot_offset(id), SEEK_SET) != 0 ||
+                fread(&s, 1, sizeof(s), catalog) != sizeof(s) ||
+                !log_seg_summary_valid(&s) || s.seg_id != id) {
+                continue;   // Never written, or overwritten by a newer segment
+            }
+            // An open segment's summary is not final: only the boot can rule it out
+            if (s.closed ? !summary_matches(q, &s) : (q->boot && s.boot != q->boot)) {
+                stats->skipped++;
+                continue;
+            }
+        }
+        visit_segment(&c, w, root, id);
+    }
+
+    free(w);
+    fclose(catalog);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// File: main/log_query.h
+// ==========================================================================================
+// Time-range / level queries over the segment store (log_segment.h).
+// Index mode reads the catalog, skips segments whose summary cannot match, and reads only
+// the data blocks whose index entry overlaps the query. Segments without a sealed index
+// (the one being written, or one that could not be recovered) are scanned. Scan mode
+// reads every data block and is the reference the index must agree with.
+// Pure C (stdio), no ESP-IDF includes; also builds on the host for benchmarks.
+// ==========================================================================================
+
+#ifndef LOG_QUERY_H
+#define LOG_QUERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "log_segment.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Query parameters.
+ *
+ * A line's time is its own timestamp or, for unprefixed lines, that of the previous
+ * timestamped line in its block (the first one for lines at the head of the block).
+ * Lines in blocks without any timestamp only match the unbounded window.
+ */
+typedef struct {
+    uint32_t boot;          ///< Boot sequence number, 0 = any
+    uint32_t from_ms;       ///< Window start, ms since boot (inclusive)
+    uint32_t to_ms;         ///< Window end (inclusive), UINT32_MAX = open
+    uint8_t  level;         ///< Most verbose level wanted, 1 = E ... 5 = V; 0 = every line
+    bool     use_index;     ///< false: read every data block
+    uint32_t max;           ///< Stop after this many matches, 0 = no limit
+} log_query_t;
+
+/**
+ * @brief Work done by one query.
+ */
+typedef struct {
+    uint32_t segments;      ///< Segment files opened
+    uint32_t skipped;       ///< Segments ruled out by their catalog summary
+    uint32_t blocks_read;   ///< 4 KB blocks read (headers included)
+    uint64_t bytes_read;
+    uint32_t lines;         ///< Lines examined
+    uint32_t matched;
+} log_query_stats_t;
+
+/**
+ * @brief Called per matching line (without its newline). Return false to stop.
+ */
+typedef bool (*log_query_cb_t)(const char *line, size_t len, const log_line_meta_t *meta,
+                               uint32_t boot, void *ctx);
+
+/**
+ * @brief Defaults: any boot, whole time range, every level, index on, no limit.
+ */
+void log_query_init(log_query_t *q);
+
+/**
+ * @brief Run a query over the store under `root`, oldest segment first.
+ *
+ * @return 0 on success, -1 if there is no catalog or no memory for the 12 KB work buffer.
+ */
+int log_query_run(const char *root, const log_query_t *q, log_query_cb_t cb, void *ctx,
+                  log_query_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_QUERY_H
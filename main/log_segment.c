@@ -0,0 +1,281 @@
+// File: main/log_segment.c
+// ==========================================================================================
+// Segment header/index bookkeeping, block frames and line metadata parsing, shared by
+// the writer (log_store.c), the query engine (log_query.c) and the host tools.
+// ==========================================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include "log_segment.h"
+
+_Static_assert(sizeof(log_seg_header_t) <= LOG_SEG_HEADER_SIZE, "segment header too large");
+_Static_assert(sizeof(log_catalog_header_t) <= LOG_CATALOG_HEADER_SIZE, "catalog header too large");
+_Static_assert(sizeof(log_seg_index_t) == 16, "index entry layout");
+
+#define NO_TS   UINT32_MAX
+
+// CRC-32 (reflected 0xEDB88320) nibble table, same trade-off as cli_crc16
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t log_crc32(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = data;
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc32_nibble[(crc ^ p[i]) & 0x0F] ^ (crc >> 4);
+        crc = crc32_nibble[(crc ^ (p[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+// === Line metadata ===
+
+static int b64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+/**
+ * @brief tlog record: level byte, hash (4), timestamp varint. 16 chars = 12 bytes is enough.
+ */
+static log_line_meta_t tlog_meta(const char *s, size_t len) {
+    log_line_meta_t m = { 0 };
+    uint8_t b[12];
+    size_t n = 0;
+
+    for (size_t i = 0; i + 4 <= len && i < 16; i += 4) {
+        int v0 = b64_value(s[i]), v1 = b64_value(s[i + 1]);
+        int v2 = b64_value(s[i + 2]), v3 = b64_value(s[i + 3]);
+        if (v0 < 0 || v1 < 0) {
+            break;
+        }
+        uint32_t v = (uint32_t)v0 << 18 | (uint32_t)v1 << 12 |
+                     (uint32_t)(v2 < 0 ? 0 : v2) << 6 | (uint32_t)(v3 < 0 ? 0 : v3);
+        b[n++] = (uint8_t)(v >> 16);
+        if (v2 >= 0) b[n++] = (uint8_t)(v >> 8);
+        if (v3 >= 0) b[n++] = (uint8_t)v;
+        if (v2 < 0 || v3 < 0) {
+            break;
+        }
+    }
+    if (n < 6) {
+        return m;
+    }
+
+    uint32_t ts = 0;
+    unsigned shift = 0;
+    for (size_t i = 5; i < n && shift < 32; i++, shift += 7) {
+        ts |= (uint32_t)(b[i] & 0x7F) << shift;
+        if (!(b[i] & 0x80)) {
+            m.has_ts = true;
+            break;
+        }
+    }
+    m.level = (b[0] & 7) <= 5 ? (b[0] & 7) : 0;
+    m.ts = ts;
+    return m;
+}
+
+log_line_meta_t log_line_meta(const char *line, size_t len) {
+    log_line_meta_t m = { 0 };
+    size_t i = 0;
+
+    if (len > 1 && line[0] == '$') {
+        return tlog_meta(line + 1, len - 1);
+    }
+    // Skip an ANSI color prefix ("\033[0;32m")
+    if (len > 2 && line[0] == '\033' && line[1] == '[') {
+        for (i = 2; i < len && line[i] != 'm'; i++) {
+        }
+        i++;
+    }
+    if (i + 4 > len || line[i + 1] != ' ' || line[i + 2] != '(') {
+        return m;
+    }
+
+    static const char levels[] = "EWIDV";
+    const char *lv = memchr(levels, line[i], 5);
+    if (!lv) {
+        return m;
+    }
+
+    uint32_t ts = 0;
+    size_t j = i + 3;
+    for (; j < len && line[j] >= '0' && line[j] <= '9'; j++) {
+        ts = ts * 10 + (uint32_t)(line[j] - '0');
+    }
+    if (j == i + 3 || j >= len || line[j] != ')') {
+        return m;
+    }
+    m.level = (uint8_t)(lv - levels + 1);
+    m.has_ts = true;
+    m.ts = ts;
+    return m;
+}
+
+void log_block_meta_reset(log_block_meta_t *m) {
+    memset(m, 0, sizeof(*m));
+    m->idx.ts_first = NO_TS;
+}
+
+void log_block_meta_add(log_block_meta_t *m, const char *line, size_t len) {
+    log_line_meta_t lm = log_line_meta(line, len);
+
+    m->idx.lines++;
+    m->level_lines[lm.level]++;
+    m->idx.level_mask |= (uint8_t)(1u << lm.level);
+    // Min/max rather than first/last: tasks can publish lines slightly out of order
+    if (lm.has_ts) {
+        if (lm.ts < m->idx.ts_first) {
+            m->idx.ts_first = lm.ts;
+        }
+        if (lm.ts > m->idx.ts_last) {
+            m->idx.ts_last = lm.ts;
+        }
+        m->has_ts = true;
+    }
+}
+
+void log_block_meta_scan(log_block_meta_t *m, const char *data, size_t len) {
+    const char *end = data + len;
+
+    while (data < end) {
+        const char *nl = memchr(data, '\n', (size_t)(end - data));
+        size_t n = nl ? (size_t)(nl - data) + 1 : (size_t)(end - data);
+        if (n > 1 || *data != '\n') {
+            log_block_meta_add(m, data, n);
+        }
+        data += n;
+    }
+}
+
+// === Segment header ===
+
+void log_seg_header_init(log_seg_header_t *h, uint32_t seg_id, uint32_t boot) {
+    memset(h, 0, sizeof(*h));
+    h->summary.magic = LOG_SEG_MAGIC;
+    h->summary.version = LOG_SEG_VERSION;
+    h->summary.seg_id = seg_id;
+    h->summary.boot = boot;
+    h->summary.ts_first = NO_TS;
+}
+
+void log_seg_header_add_block(log_seg_header_t *h, uint16_t block, const log_block_meta_t *m) {
+    log_seg_summary_t *s = &h->summary;
+    log_seg_index_t e = m->idx;
+
+    if (block >= LOG_SEG_MAX_BLOCKS) {
+        return;
+    }
+    if (m->has_ts) {
+        if (e.ts_first < s->ts_first) {
+            s->ts_first = e.ts_first;
+        }
+        if (e.ts_last > s->ts_last) {
+            s->ts_last = e.ts_last;
+        }
+    }
+    h->index[block] = e;
+    s->block_count = block + 1;
+    s->lines += e.lines;
+    for (int i = 0; i < LOG_SEG_LEVELS; i++) {
+        s->level_lines[i] += m->level_lines[i];
+    }
+}
+
+static uint32_t header_crc(const log_seg_header_t *h) {
+    uint32_t crc = log_crc32(0, &h->summary, offsetof(log_seg_summary_t, crc));
+    return log_crc32(crc, h->index, h->summary.block_count * sizeof(log_seg_index_t));
+}
+
+void log_seg_header_seal(log_seg_header_t *h) {
+    h->summary.crc = header_crc(h);
+}
+
+bool log_seg_summary_valid(const log_seg_summary_t *s) {
+    return s->magic == LOG_SEG_MAGIC && s->version == LOG_SEG_VERSION &&
+           s->block_count <= LOG_SEG_MAX_BLOCKS;
+}
+
+bool log_seg_header_valid(const log_seg_header_t *h) {
+    return log_seg_summary_valid(&h->summary) && h->summary.crc == header_crc(h);
+}
+
+// === Block frames ===
+
+size_t log_seg_frame_encode(log_lz_t *lz, uint8_t *frame, const void *text, size_t len) {
+    log_seg_frame_t hdr = { .raw = (uint16_t)len };
+    uint8_t *payload = frame + sizeof(hdr);
+
+    // Cap at len - 1: a payload as long as the text is stored as text
+    size_t n = len > 1 ? log_lz_compress(lz, text, len, payload, len - 1) : 0;
+    if (n == 0) {
+        memcpy(payload, text, len);
+        n = len;
+    }
+    hdr.stored = (uint16_t)n;
+    hdr.crc = log_crc32(0, payload, n);
+    memcpy(frame, &hdr, sizeof(hdr));
+    return sizeof(hdr) + n;
+}
+
+size_t log_seg_read_block(FILE *f, uint8_t codec, long *pos, uint8_t *frame, char *out) {
+    log_seg_frame_t hdr;
+
+    if (fseek(f, *pos, SEEK_SET) != 0) {
+        return 0;
+    }
+    if (codec == LOG_SEG_CODEC_RAW) {
+        size_t n = fread(out, 1, LOG_SEG_BLOCK_SIZE, f);
+        *pos += (long)n;
+        return n;
+    }
+
+    uint8_t *payload = frame + sizeof(hdr);
+    if (fread(frame, 1, sizeof(hdr), f) != sizeof(hdr)) {
+        return 0;
+    }
+    memcpy(&hdr, frame, sizeof(hdr));
+    if (hdr.raw == 0 || hdr.raw > LOG_SEG_BLOCK_SIZE || hdr.stored == 0 || hdr.stored > hdr.raw ||
+        fread(payload, 1, hdr.stored, f) != hdr.stored ||
+        log_crc32(0, payload, hdr.stored) != hdr.crc) {
+        return 0;
+    }
+    if (hdr.stored == hdr.raw) {
+        memcpy(out, payload, hdr.raw);
+    } else if (log_lz_decompress(payload, hdr.stored, (uint8_t *)out, LOG_SEG_BLOCK_SIZE) != hdr.raw) {
+        return 0;
+    }
+    *pos += (long)(sizeof(hdr) + hdr.stored);
+    return hdr.raw;
+}
+
+// === Catalog ===
+
+void log_catalog_header_seal(log_catalog_header_t *c) {
+    c->crc = log_crc32(0, c, offsetof(log_catalog_header_t, crc));
+}
+
+bool log_catalog_header_valid(const log_catalog_header_t *c) {
+    return c->magic == LOG_CATALOG_MAGIC && c->version == LOG_CATALOG_VERSION &&
+           c->slots == LOG_CATALOG_SLOTS &&
+           c->crc == log_crc32(0, c, offsetof(log_catalog_header_t, crc));
+}
+
+// === Paths ===
+
+void log_seg_dir(char *out, size_t cap, const char *root, uint32_t seg_id) {
+    snprintf(out, cap, "%s/G%04u", root, (unsigned)(seg_id / LOG_SEGS_PER_DIR));
+}
+
+void log_seg_path(char *out, size_t cap, const char *root, uint32_t seg_id) {
+    snprintf(out, cap, "%s/G%04u/%08u.LOG", root,
+             (unsigned)(seg_id / LOG_SEGS_PER_DIR), (unsigned)seg_id);
+}
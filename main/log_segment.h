@@ -0,0 +1,237 @@
+// File: main/log_segment.h
+// ==========================================================================================
+// On-card log layout.
+//   <root>/CATALOG.BIN         catalog header + one summary slot per segment (ring)
+//   <root>/Gnnnn/nnnnnnnn.LOG  segment: 4 KB header block (summary + block index), then
+//                              data blocks of whole text lines (4 KB of text each)
+// A segment belongs to one boot; timestamps are esp_log milliseconds since that boot.
+// The summary gives the time range and per-level line counts of a segment, the block
+// index the same per data block, so a query can skip straight to the blocks it needs.
+// Data blocks are stored as plain text (LOG_SEG_CODEC_RAW, 4 KB apart) or as frames of
+// independently LZ-compressed blocks (LOG_SEG_CODEC_LZ, packed back to back), so every
+// block and every segment still decodes on its own.
+// Pure C (stdio), no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef LOG_SEGMENT_H
+#define LOG_SEGMENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "log_lz.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_SEG_BLOCK_SIZE      4096
+#define LOG_SEG_HEADER_SIZE     LOG_SEG_BLOCK_SIZE      // Summary + index, first block of a segment
+#define LOG_SEG_MAGIC           0x4745534Cu             // "LSEG"
+#define LOG_SEG_VERSION         2
+#define LOG_SEG_LEVELS          6                       // esp_log levels N E W I D V
+#define LOG_SEG_MAX_BLOCKS      ((LOG_SEG_HEADER_SIZE - sizeof(log_seg_summary_t)) / sizeof(log_seg_index_t))
+
+#define LOG_SEG_CODEC_RAW       0                       // Text blocks at 4 KB strides
+#define LOG_SEG_CODEC_LZ        1                       // log_seg_frame_t + payload per block
+#define LOG_SEG_FRAME_MAX       (sizeof(log_seg_frame_t) + LOG_SEG_BLOCK_SIZE)  // Stored raw if LZ does not help
+
+#define LOG_CATALOG_FILE        "CATALOG.BIN"
+#define LOG_CATALOG_MAGIC       0x5441434Cu             // "LCAT"
+#define LOG_CATALOG_VERSION     1
+#define LOG_CATALOG_SLOTS       4096                    // Segments kept before the oldest is deleted
+#define LOG_CATALOG_HEADER_SIZE 512
+#define LOG_SEGS_PER_DIR        256                     // Keeps FAT directory scans short
+
+#define LOG_PATH_MAX            64
+
+/**
+ * @brief Segment summary: first bytes of the segment and its catalog slot.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t block_count;                   ///< Data blocks (in the index)
+    uint32_t seg_id;
+    uint32_t boot;                          ///< Boot sequence number
+    uint32_t ts_first;                      ///< Earliest line timestamp, ms since boot
+    uint32_t ts_last;                       ///< Latest (ts_first > ts_last: no timestamps)
+    uint32_t data_bytes;                    ///< Bytes after the header block
+    uint32_t lines;
+    uint32_t level_lines[LOG_SEG_LEVELS];   ///< Lines per level (0 = no level prefix)
+    uint32_t data_crc;                      ///< CRC-32 of the data bytes as stored
+    uint8_t  closed;                        ///< 0: still open, or lost power before closing
+    uint8_t  codec;                         ///< LOG_SEG_CODEC_*
+    uint8_t  reserved[2];
+    uint32_t crc;                           ///< CRC-32 of this struct up to here, plus the index
+} log_seg_summary_t;
+
+/**
+ * @brief Block index entry.
+ */
+typedef struct {
+    uint32_t ts_first;                      ///< Same convention as the summary
+    uint32_t ts_last;
+    uint16_t lines;
+    uint16_t size;                          ///< Bytes on the card (whole frame for LZ)
+    uint8_t  level_mask;                    ///< Bit per level present in the block (bit 0: no level)
+    uint8_t  reserved[3];
+} log_seg_index_t;
+
+/**
+ * @brief Header of a stored block in an LZ segment; the payload follows.
+ */
+typedef struct {
+    uint16_t stored;                        ///< Payload bytes
+    uint16_t raw;                           ///< Text bytes; stored == raw: payload is the text
+    uint32_t crc;                           ///< CRC-32 of the payload
+} log_seg_frame_t;
+
+/**
+ * @brief Header block of a segment.
+ */
+typedef struct {
+    log_seg_summary_t summary;
+    log_seg_index_t   index[LOG_SEG_MAX_BLOCKS];
+} log_seg_header_t;
+
+/**
+ * @brief Catalog header (first sector of CATALOG.BIN).
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t slots;
+    uint32_t next_seg;                      ///< Id the next segment will get
+    uint32_t boot;                          ///< Last boot sequence number
+    uint32_t crc;
+} log_catalog_header_t;
+
+/**
+ * @brief Level and timestamp parsed from one stored line.
+ */
+typedef struct {
+    uint8_t  level;                         ///< 1..5 = E W I D V, 0 = unknown
+    bool     has_ts;
+    uint32_t ts;
+} log_line_meta_t;
+
+/**
+ * @brief Running per-block statistics (what becomes one index entry).
+ */
+typedef struct {
+    log_seg_index_t idx;
+    uint16_t level_lines[LOG_SEG_LEVELS];
+    bool     has_ts;
+} log_block_meta_t;
+
+/**
+ * @brief Parse "I (1234) TAG: ..." (optionally colored) or a "$<base64>" tlog record.
+ */
+log_line_meta_t log_line_meta(const char *line, size_t len);
+
+/**
+ * @brief Clear block statistics.
+ */
+void log_block_meta_reset(log_block_meta_t *m);
+
+/**
+ * @brief Account one line in block statistics.
+ */
+void log_block_meta_add(log_block_meta_t *m, const char *line, size_t len);
+
+/**
+ * @brief Account every non-empty line of a block of text.
+ */
+void log_block_meta_scan(log_block_meta_t *m, const char *data, size_t len);
+
+/**
+ * @brief Start an empty segment header.
+ */
+void log_seg_header_init(log_seg_header_t *h, uint32_t seg_id, uint32_t boot);
+
+/**
+ * @brief Store block statistics as index entry `block` and fold them into the summary.
+ *
+ * Must be called once per block, in order.
+ */
+void log_seg_header_add_block(log_seg_header_t *h, uint16_t block, const log_block_meta_t *m);
+
+/**
+ * @brief Compute the summary CRC (over summary fields + used index entries).
+ */
+void log_seg_header_seal(log_seg_header_t *h);
+
+/**
+ * @brief Check magic, version and CRC of a header.
+ */
+bool log_seg_header_valid(const log_seg_header_t *h);
+
+/**
+ * @brief Check a catalog slot (summary only, no index).
+ */
+bool log_seg_summary_valid(const log_seg_summary_t *s);
+
+/**
+ * @brief Encode one block of text as a frame (header + LZ or raw payload).
+ *
+ * @param frame  LOG_SEG_FRAME_MAX bytes
+ * @return Frame size
+ */
+size_t log_seg_frame_encode(log_lz_t *lz, uint8_t *frame, const void *text, size_t len);
+
+/**
+ * @brief Read and decode the data block at file offset *pos, then advance *pos past it.
+ *
+ * @param frame  Scratch of LOG_SEG_FRAME_MAX bytes; holds the stored frame (LZ codec)
+ * @param out    LOG_SEG_BLOCK_SIZE bytes of text
+ * @return Text bytes, 0 at the end of the data or at a damaged frame.
+ */
+size_t log_seg_read_block(FILE *f, uint8_t codec, long *pos, uint8_t *frame, char *out);
+
+/**
+ * @brief Catalog header: set the CRC / check magic, version, slot count and CRC.
+ */
+void log_catalog_header_seal(log_catalog_header_t *c);
+bool log_catalog_header_valid(const log_catalog_header_t *c);
+
+/**
+ * @brief File offset of a segment's catalog slot.
+ */
+static inline long log_catalog_slot_offset(uint32_t seg_id) {
+    return LOG_CATALOG_HEADER_SIZE + (long)(seg_id % LOG_CATALOG_SLOTS) * (long)sizeof(log_seg_summary_t);
+}
+
+/**
+ * @brief Does the [from, to] window overlap [first, last]?
+ *
+ * A range without timestamps (first > last) only overlaps the unbounded window.
+ */
+static inline bool log_seg_overlaps(uint32_t first, uint32_t last, uint32_t from, uint32_t to) {
+    if (first > last) {
+        return from == 0 && to == UINT32_MAX;
+    }
+    return first <= to && last >= from;
+}
+
+/**
+ * @brief Path of a segment file: <root>/Gnnnn/nnnnnnnn.LOG (8.3 names).
+ */
+void log_seg_path(char *out, size_t cap, const char *root, uint32_t seg_id);
+
+/**
+ * @brief Path of a segment's directory: <root>/Gnnnn.
+ */
+void log_seg_dir(char *out, size_t cap, const char *root, uint32_t seg_id);
+
+/**
+ * @brief CRC-32 (IEEE, reflected), chainable: start with 0.
+ */
+uint32_t log_crc32(uint32_t crc, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_SEGMENT_H
@@ -0,0 +1,175 @@
+// File: main/log_sink.c
+// ==========================================================================================
+// Line ring (Vyukov sequence cells, as in fsm_queue.c) feeding a two-block packer.
+// A line that does not fit closes the current block (tail padded with newlines, so a
+// block can be read on its own) and starts the other one. It is only taken from the ring
+// when the other block is free, so a slow writer backs up into the ring and then into
+// drops, never into the producers. Drops are announced in-band once space is available.
+// ==========================================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include "log_sink.h"
+
+_Static_assert((LOG_SINK_RING_CELLS & (LOG_SINK_RING_CELLS - 1)) == 0,
+               "LOG_SINK_RING_CELLS must be a power of two");
+_Static_assert(LOG_SINK_LINE_MAX < LOG_SINK_BLOCK_SIZE, "a line must fit in one block");
+
+#define CELL(s, pos)    (&(s)->cells[(pos) & (LOG_SINK_RING_CELLS - 1)])
+
+void log_sink_init(log_sink_t *s, uint32_t base_offset) {
+    for (unsigned i = 0; i < LOG_SINK_RING_CELLS; i++) {
+        atomic_init(&s->cells[i].seq, i);
+    }
+    atomic_init(&s->enqueue_pos, 0);
+    atomic_init(&s->dequeue_pos, 0);
+    atomic_init(&s->dropped, 0);
+    atomic_init(&s->truncated, 0);
+    atomic_init(&s->busy, 0);
+
+    s->fill = 0;
+    s->fill_len = 0;
+    s->flushed_len = 0;
+    s->fill_offset = base_offset;
+    s->dropped_reported = 0;
+    log_block_meta_reset(&s->fill_meta);
+    memset(&s->stats, 0, sizeof(s->stats));
+}
+
+// === Producers ===
+
+bool log_sink_write(log_sink_t *s, const char *text, size_t len) {
+    bool cut = false;
+    if (len > LOG_SINK_LINE_MAX) {
+        len = LOG_SINK_LINE_MAX;
+        cut = true;
+    }
+
+    unsigned pos = atomic_load_explicit(&s->enqueue_pos, memory_order_relaxed);
+
+    for (;;) {
+        log_sink_cell_t *cell = CELL(s, pos);
+        unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                memcpy(cell->text, text, len);
+                if (cut) {
+                    cell->text[len - 1] = '\n';
+                    atomic_fetch_add_explicit(&s->truncated, 1, memory_order_relaxed);
+                }
+                cell->len = (uint16_t)len;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&s->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&s->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// === Packer ===
+
+bool log_sink_pack(log_sink_t *s, log_sink_req_t *req) {
+    unsigned pos = atomic_load_explicit(&s->dequeue_pos, memory_order_relaxed);
+    bool handed_off = false;
+
+    while (!handed_off) {
+        char marker[48];
+        const char *src;
+        size_t len;
+        log_sink_cell_t *cell = NULL;
+        uint32_t dropped = atomic_load_explicit(&s->dropped, memory_order_relaxed);
+
+        if (dropped != s->dropped_reported) {
+            len = (size_t)snprintf(marker, sizeof(marker), "[log] %u lines dropped\n",
+                                   (unsigned)(dropped - s->dropped_reported));
+            src = marker;
+        } else {
+            cell = CELL(s, pos);
+            unsigned seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+            if ((int)(seq - (pos + 1)) < 0) {
+                break;  // Empty, or the producer of this cell has not published yet
+            }
+            src = cell->text;
+            len = cell->len;
+        }
+
+        uint8_t other = s->fill ^ 1;
+        bool full = s->fill_len + len > LOG_SINK_BLOCK_SIZE;
+        if (full && (atomic_load_explicit(&s->busy, memory_order_acquire) & (1u << other))) {
+            s->stats.stalls++;
+            break;  // Writer still owns the other block; leave the line in the ring
+        }
+
+        if (full) {
+            memset(&s->block[s->fill][s->fill_len], '\n', LOG_SINK_BLOCK_SIZE - (size_t)s->fill_len);
+            req->data = s->block[s->fill];
+            req->offset = s->fill_offset;
+            req->len = LOG_SINK_BLOCK_SIZE;
+            req->buf = s->fill;
+            req->partial = false;
+            req->meta = s->fill_meta;
+            atomic_fetch_or_explicit(&s->busy, 1u << s->fill, memory_order_relaxed);
+            s->stats.blocks++;
+
+            s->fill = other;
+            s->fill_offset += LOG_SINK_BLOCK_SIZE;
+            s->fill_len = 0;
+            s->flushed_len = 0;
+            log_block_meta_reset(&s->fill_meta);
+            handed_off = true;
+        }
+
+        memcpy(&s->block[s->fill][s->fill_len], src, len);
+        s->fill_len += (uint16_t)len;
+        log_block_meta_add(&s->fill_meta, src, len);
+
+        s->stats.bytes += (uint32_t)len;
+        if (cell) {
+            atomic_store_explicit(&cell->seq, pos + LOG_SINK_RING_CELLS, memory_order_release);
+            pos++;
+            s->stats.lines++;
+        } else {
+            s->dropped_reported = dropped;
+        }
+    }
+
+    atomic_store_explicit(&s->dequeue_pos, pos, memory_order_relaxed);
+    return handed_off;
+}
+
+size_t log_sink_pending(const log_sink_t *s) {
+    return (size_t)(s->fill_len - s->flushed_len);
+}
+
+bool log_sink_flush_partial(log_sink_t *s, log_sink_req_t *req) {
+    if (s->fill_len == s->flushed_len) {
+        return false;
+    }
+    req->data = s->block[s->fill];
+    req->offset = s->fill_offset;
+    req->len = s->fill_len;
+    req->buf = s->fill;
+    req->partial = true;
+    req->meta = s->fill_meta;
+    s->flushed_len = s->fill_len;
+    s->stats.partials++;
+    return true;
+}
+
+// === Writer ===
+
+void log_sink_block_done(log_sink_t *s, uint8_t buf) {
+    atomic_fetch_and_explicit(&s->busy, ~(1u << buf), memory_order_release);
+}
+
+uint32_t log_sink_dropped(const log_sink_t *s) {
+    return atomic_load_explicit(&((log_sink_t *)s)->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,137 @@
+// File: main/log_sink.h
+// ==========================================================================================
+// Log sink core: lock-free line ring + double-buffered block packer.
+// Producers copy finished text lines into a bounded MPSC ring and never block; when the
+// ring is full the line is dropped and counted. One packer drains the ring into the fill
+// block; full blocks are handed to the writer as LOG_SINK_BLOCK_SIZE-aligned requests
+// while packing continues in the other block. Every block starts on a line boundary and
+// carries its index entry (log_segment.h). Storage I/O is left to the caller.
+// Pure C11 (stdatomic), no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "log_segment.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_SINK_BLOCK_SIZE     LOG_SEG_BLOCK_SIZE  // Write unit: 8 SD sectors, one FAT cluster on typical cards
+#define LOG_SINK_RING_CELLS     64      // Lines buffered between producers and packer (power of two)
+#define LOG_SINK_LINE_MAX       122     // Longest stored line; longer lines are truncated
+
+/**
+ * @brief Ring cell, same sequence scheme as fsm_queue.
+ */
+typedef struct {
+    atomic_uint seq;
+    uint16_t    len;
+    char        text[LOG_SINK_LINE_MAX];
+} log_sink_cell_t;
+
+/**
+ * @brief One write for the storage side.
+ *
+ * Always starts at a block boundary. A partial request (flush-on-idle) writes the
+ * filled head of the current block; the block is rewritten in place once it is full.
+ */
+typedef struct {
+    const uint8_t *data;
+    uint32_t offset;        ///< Byte offset in the log, multiple of LOG_SINK_BLOCK_SIZE
+    uint16_t len;           ///< Bytes to write (LOG_SINK_BLOCK_SIZE unless partial)
+    uint8_t  buf;           ///< Block buffer index, for log_sink_block_done()
+    bool     partial;       ///< Buffer stays with the packer; no block_done needed
+    log_block_meta_t meta;  ///< Time range and level counts of the lines in `data`
+} log_sink_req_t;
+
+/**
+ * @brief Packer-side counters.
+ */
+typedef struct {
+    uint32_t lines;         ///< Lines packed
+    uint32_t bytes;         ///< Bytes packed (incl. loss markers)
+    uint32_t blocks;        ///< Full blocks handed off
+    uint32_t partials;      ///< Partial (idle) flushes
+    uint32_t stalls;        ///< Pack stopped because both blocks were in flight
+} log_sink_stats_t;
+
+/**
+ * @brief Complete sink state. Large (~16 KB): keep it static.
+ */
+typedef struct {
+    // Producers -> packer
+    log_sink_cell_t cells[LOG_SINK_RING_CELLS];
+    atomic_uint enqueue_pos;
+    atomic_uint dequeue_pos;
+    atomic_uint dropped;            ///< Lines lost because the ring was full
+    atomic_uint truncated;          ///< Lines cut to LOG_SINK_LINE_MAX
+
+    // Packer <-> writer
+    atomic_uint busy;               ///< Bit per block buffer owned by the writer
+    uint8_t  block[2][LOG_SINK_BLOCK_SIZE] __attribute__((aligned(4)));
+    uint8_t  fill;                  ///< Buffer being filled
+    uint16_t fill_len;              ///< Bytes in the fill buffer
+    uint16_t flushed_len;           ///< Bytes of the fill buffer already written (partial)
+    uint32_t fill_offset;           ///< Log offset of the fill buffer
+    log_block_meta_t fill_meta;     ///< Index entry of the fill buffer so far
+    uint32_t dropped_reported;      ///< `dropped` value already announced in the log
+    log_sink_stats_t stats;
+} log_sink_t;
+
+/**
+ * @brief Reset to empty, starting at `base_offset` (multiple of LOG_SINK_BLOCK_SIZE).
+ *        Not thread-safe; call before any producer runs.
+ */
+void log_sink_init(log_sink_t *s, uint32_t base_offset);
+
+/**
+ * @brief Queue one line (producers; lock-free, never blocks).
+ *
+ * @return false if the ring is full: the line is dropped and counted.
+ */
+bool log_sink_write(log_sink_t *s, const char *text, size_t len);
+
+/**
+ * @brief Drain the ring into the fill block (single packer only).
+ *
+ * Stops when the ring is empty, when both blocks are in flight, or when a block
+ * fills up. A line that does not fit is not split: the rest of the block is padded
+ * with '\n' and the line starts the next block. Call again after handling the request.
+ *
+ * @return true if `req` holds a full block to write.
+ */
+bool log_sink_pack(log_sink_t *s, log_sink_req_t *req);
+
+/**
+ * @brief Bytes packed but not yet handed to the writer.
+ */
+size_t log_sink_pending(const log_sink_t *s);
+
+/**
+ * @brief Build a partial request for the unwritten head of the fill block (packer only).
+ *
+ * @return false if nothing is pending.
+ */
+bool log_sink_flush_partial(log_sink_t *s, log_sink_req_t *req);
+
+/**
+ * @brief Return a full block's buffer to the packer (writer side).
+ */
+void log_sink_block_done(log_sink_t *s, uint8_t buf);
+
+/**
+ * @brief Lines lost so far because the ring was full.
+ */
+uint32_t log_sink_dropped(const log_sink_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_SINK_H
@@ -0,0 +1,293 @@
+// File: main/log_store.c
+// ==========================================================================================
+// Segment writer. Sink offset -> (segment, block): segment first_seg + block / seg_blocks,
+// data block block % seg_blocks. Blocks are appended after the header block (raw text
+// blocks are 4 KB each, so this is LOG_SEG_HEADER_SIZE + 4 KB * block). A partial flush
+// writes the block being filled at the end of the data; the full block overwrites it.
+// The header block is written twice per segment: at open (identity only, closed = 0) and
+// at close (summary + index, sealed). Full blocks are indexed from the meta the sink
+// attached to them; the partial tail block is indexed at close.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "log_store.h"
+
+// === File helpers ===
+
+static bool write_at(FILE *f, long off, const void *data, size_t len) {
+    return fseek(f, off, SEEK_SET) == 0 && fwrite(data, 1, len, f) == len;
+}
+
+static bool read_at(FILE *f, long off, void *data, size_t len) {
+    return fseek(f, off, SEEK_SET) == 0 && fread(data, 1, len, f) == len;
+}
+
+static void store_path(const log_store_t *st, char *out, size_t cap, const char *name) {
+    snprintf(out, cap, "%s/%s", st->root, name);
+}
+
+// === Catalog ===
+
+static bool catalog_write_header(log_store_t *st) {
+    log_catalog_header_seal(&st->cat);
+    return write_at(st->catalog, 0, &st->cat, sizeof(st->cat)) &&
+           fsync(fileno(st->catalog)) == 0;
+}
+
+static bool catalog_write_slot(log_store_t *st, const log_seg_summary_t *s) {
+    return write_at(st->catalog, log_catalog_slot_offset(s->seg_id), s, sizeof(*s)) &&
+           fsync(fileno(st->catalog)) == 0;
+}
+
+static bool catalog_create(log_store_t *st, const char *path) {
+    uint8_t sector[LOG_CATALOG_HEADER_SIZE] = { 0 };
+
+    st->catalog = fopen(path, "w+b");
+    if (!st->catalog) {
+        return false;
+    }
+    setvbuf(st->catalog, NULL, _IONBF, 0);
+    memset(&st->cat, 0, sizeof(st->cat));
+    st->cat.magic = LOG_CATALOG_MAGIC;
+    st->cat.version = LOG_CATALOG_VERSION;
+    st->cat.slots = LOG_CATALOG_SLOTS;
+    log_catalog_header_seal(&st->cat);
+    memcpy(sector, &st->cat, sizeof(st->cat));
+    return write_at(st->catalog, 0, sector, sizeof(sector));
+}
+
+// === Segments ===
+
+static void segment_delete(log_store_t *st, uint32_t id) {
+    char path[LOG_PATH_MAX];
+
+    log_seg_path(path, sizeof(path), st->root, id);
+    if (remove(path) == 0) {
+        st->stats.deleted++;
+    }
+    if (id % LOG_SEGS_PER_DIR == LOG_SEGS_PER_DIR - 1) {
+        log_seg_dir(path, sizeof(path), st->root, id);
+        rmdir(path);
+    }
+}
+
+/**
+ * @brief Re-index a segment that was never closed (reset or power loss while logging).
+ */
+static void segment_recover(log_store_t *st, uint32_t id) {
+    log_seg_header_t *h = &st->hdr.h;
+    char path[LOG_PATH_MAX];
+
+    log_seg_path(path, sizeof(path), st->root, id);
+    FILE *f = fopen(path, "r+b");
+    if (!f) {
+        return;
+    }
+    setvbuf(f, NULL, _IONBF, 0);
+
+    char *buf = malloc(LOG_SEG_BLOCK_SIZE);
+    if (!buf || !read_at(f, 0, st->hdr.raw, LOG_SEG_HEADER_SIZE) ||
+        !log_seg_summary_valid(&h->summary) || h->summary.seg_id != id || h->summary.closed) {
+        free(buf);
+        fclose(f);
+        return;
+    }
+
+    // Walk the data until EOF or the first damaged frame (a stale partial tail)
+    uint8_t codec = h->summary.codec;
+    long pos = LOG_SEG_HEADER_SIZE;
+    uint32_t crc = 0;
+
+    log_seg_header_init(h, id, h->summary.boot);
+    h->summary.codec = codec;
+    for (uint16_t b = 0; b < LOG_SEG_MAX_BLOCKS; b++) {
+        long start = pos;
+        size_t n = log_seg_read_block(f, codec, &pos, st->frame, buf);
+        if (n == 0) {
+            break;
+        }
+        uint16_t stored = (uint16_t)(pos - start);
+        log_block_meta_t meta;
+
+        crc = log_crc32(crc, codec == LOG_SEG_CODEC_RAW ? (const void *)buf : st->frame, stored);
+        log_block_meta_reset(&meta);
+        log_block_meta_scan(&meta, buf, n);
+        meta.idx.size = stored;
+        log_seg_header_add_block(h, b, &meta);
+        h->summary.data_bytes += stored;
+    }
+    h->summary.data_crc = crc;
+    h->summary.closed = 1;
+    log_seg_header_seal(h);
+
+    if (write_at(f, 0, st->hdr.raw, LOG_SEG_HEADER_SIZE) && fsync(fileno(f)) == 0 &&
+        catalog_write_slot(st, &h->summary)) {
+        st->stats.recovered++;
+    } else {
+        st->stats.errors++;
+    }
+    free(buf);
+    fclose(f);
+}
+
+static bool segment_open(log_store_t *st, uint32_t id) {
+    char path[LOG_PATH_MAX];
+
+    if (id >= LOG_CATALOG_SLOTS) {
+        segment_delete(st, id - LOG_CATALOG_SLOTS);
+    }
+    log_seg_dir(path, sizeof(path), st->root, id);
+    mkdir(path, 0777);      // Usually exists already
+
+    log_seg_path(path, sizeof(path), st->root, id);
+    st->seg = fopen(path, "w+b");
+    if (!st->seg) {
+        return false;
+    }
+    setvbuf(st->seg, NULL, _IONBF, 0);
+
+    memset(st->hdr.raw, 0, sizeof(st->hdr.raw));
+    log_seg_header_init(&st->hdr.h, id, st->cat.boot);
+    st->hdr.h.summary.codec = st->codec;
+    log_seg_header_seal(&st->hdr.h);
+    st->seg_id = id;
+    st->blocks_done = 0;
+    st->data_end = 0;
+    st->data_crc = 0;
+    st->tail_size = 0;
+    st->cat.next_seg = id + 1;
+    st->stats.segments++;
+
+    return write_at(st->seg, 0, st->hdr.raw, LOG_SEG_HEADER_SIZE) &&
+           catalog_write_slot(st, &st->hdr.h.summary) &&
+           catalog_write_header(st);
+}
+
+static bool segment_close(log_store_t *st) {
+    log_seg_summary_t *s = &st->hdr.h.summary;
+
+    if (!st->seg) {
+        return true;
+    }
+    s->data_bytes = st->data_end;
+    s->data_crc = st->data_crc;
+    if (st->tail_size) {
+        log_seg_header_add_block(&st->hdr.h, st->blocks_done, &st->tail_meta);
+        s->data_bytes += st->tail_size;
+        s->data_crc = st->tail_crc;
+    }
+    s->closed = 1;
+    log_seg_header_seal(&st->hdr.h);
+
+    bool ok = write_at(st->seg, 0, st->hdr.raw, LOG_SEG_HEADER_SIZE) &&
+              fsync(fileno(st->seg)) == 0;
+    ok = (fclose(st->seg) == 0) && ok;
+    st->seg = NULL;
+    return catalog_write_slot(st, s) && ok;
+}
+
+// === Public API ===
+
+bool log_store_open(log_store_t *st, const char *root, uint16_t segment_kb, bool compress) {
+    char path[LOG_PATH_MAX];
+    unsigned blocks = segment_kb / (LOG_SEG_BLOCK_SIZE / 1024);
+
+    memset(st, 0, sizeof(*st));
+    snprintf(st->root, sizeof(st->root), "%s", root);
+    if (blocks < 2) {
+        blocks = 2;
+    }
+    if (blocks - 1 > LOG_SEG_MAX_BLOCKS) {
+        blocks = LOG_SEG_MAX_BLOCKS + 1;
+    }
+    st->seg_blocks = (uint16_t)(blocks - 1);
+    st->codec = compress ? LOG_SEG_CODEC_LZ : LOG_SEG_CODEC_RAW;
+
+    mkdir(root, 0777);
+    store_path(st, path, sizeof(path), LOG_CATALOG_FILE);
+    st->catalog = fopen(path, "r+b");
+    if (st->catalog) {
+        setvbuf(st->catalog, NULL, _IONBF, 0);
+        if (read_at(st->catalog, 0, &st->cat, sizeof(st->cat)) &&
+            log_catalog_header_valid(&st->cat)) {
+            if (st->cat.next_seg > 0) {
+                segment_recover(st, st->cat.next_seg - 1);
+            }
+        } else {
+            fclose(st->catalog);
+            st->catalog = NULL;
+        }
+    }
+    if (!st->catalog && !catalog_create(st, path)) {
+        return false;
+    }
+
+    st->cat.boot++;
+    st->first_seg = st->cat.next_seg;
+    return segment_open(st, st->first_seg);
+}
+
+bool log_store_write(log_store_t *st, const log_sink_req_t *req) {
+    uint32_t block = req->offset / LOG_SEG_BLOCK_SIZE;
+    uint32_t id = st->first_seg + block / st->seg_blocks;
+    uint16_t idx = (uint16_t)(block % st->seg_blocks);
+
+    if (!st->catalog) {
+        return false;
+    }
+    if (!st->seg || id != st->seg_id) {
+        if (!segment_close(st)) {
+            st->stats.errors++;
+        }
+        if (!segment_open(st, id)) {
+            st->stats.errors++;
+            return false;
+        }
+    }
+
+    // Bytes [0, len) of the fill block are final (the packer only appends), so a
+    // partial block can be read and compressed while packing continues
+    const uint8_t *data = req->data;
+    size_t size = req->len;
+    if (st->codec == LOG_SEG_CODEC_LZ) {
+        size = log_seg_frame_encode(&st->lz, st->frame, req->data, req->len);
+        data = st->frame;
+    }
+
+    bool ok = write_at(st->seg, LOG_SEG_HEADER_SIZE + (long)st->data_end, data, size);
+    if (req->partial) {
+        ok = ok && fsync(fileno(st->seg)) == 0;
+        st->tail_size = (uint16_t)size;
+        st->tail_crc = log_crc32(st->data_crc, data, size);
+        st->tail_meta = req->meta;
+        st->tail_meta.idx.size = (uint16_t)size;
+    } else {
+        log_block_meta_t meta = req->meta;
+        meta.idx.size = (uint16_t)size;
+        st->data_crc = log_crc32(st->data_crc, data, size);
+        log_seg_header_add_block(&st->hdr.h, idx, &meta);
+        st->blocks_done = idx + 1;
+        st->data_end += (uint32_t)size;
+        st->tail_size = 0;
+        st->stats.raw_bytes += req->len;
+        st->stats.stored_bytes += size;
+    }
+    if (!ok) {
+        st->stats.errors++;
+    }
+    return ok;
+}
+
+void log_store_close(log_store_t *st) {
+    if (!st->catalog) {
+        return;
+    }
+    if (!segment_close(st) || !catalog_write_header(st)) {
+        st->stats.errors++;
+    }
+    fclose(st->catalog);
+    st->catalog = NULL;
+}
@@ -0,0 +1,98 @@
+// File: main/log_store.h
+// ==========================================================================================
+// Segment store: writes log_sink requests into rotating indexed segments (log_segment.h).
+// Each boot opens a new segment; sink offsets map onto segments of a fixed number of
+// data blocks. With compression on, each block is LZ-compressed on its own as it is
+// written (the sink's double buffering keeps the packer running meanwhile). A segment's
+// header and catalog slot are finalised when it is closed; a segment left open by a
+// reset or power loss is re-indexed from its data on the next open. Once the catalog
+// ring is full the oldest segment is deleted for every new one.
+// Pure C (stdio + POSIX), no ESP-IDF includes. Single writer; not thread-safe.
+// ==========================================================================================
+
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "log_segment.h"
+#include "log_sink.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Store counters.
+ */
+typedef struct {
+    uint32_t segments;      ///< Segments opened this boot
+    uint32_t deleted;       ///< Old segments removed to make room
+    uint32_t recovered;     ///< Unclosed segments re-indexed at open
+    uint32_t errors;        ///< Failed writes (data, header or catalog)
+    uint64_t raw_bytes;     ///< Text bytes of the full blocks written
+    uint64_t stored_bytes;  ///< The same blocks as stored (frames when compressing)
+} log_store_stats_t;
+
+/**
+ * @brief Store state, ~12.5 KB (segment header, frame buffer, LZ table): keep it static.
+ */
+typedef struct {
+    char     root[LOG_PATH_MAX - 24];
+    FILE    *catalog;
+    FILE    *seg;                   ///< Open segment, NULL between segments
+    log_catalog_header_t cat;
+    union {
+        log_seg_header_t h;
+        uint8_t raw[LOG_SEG_HEADER_SIZE];
+    } hdr;                          ///< Header of the open segment
+    uint32_t seg_id;
+    uint32_t first_seg;             ///< Segment holding sink offset 0 (first of this boot)
+    uint16_t seg_blocks;            ///< Data blocks per segment
+    uint8_t  codec;                 ///< LOG_SEG_CODEC_* for new segments
+    uint16_t blocks_done;           ///< Full blocks written to the open segment
+    uint32_t data_end;              ///< Stored bytes of those blocks (next block's offset)
+    uint32_t data_crc;              ///< CRC of the full blocks
+    uint16_t tail_size;             ///< Stored bytes of the last partial write (0: none)
+    uint32_t tail_crc;              ///< data_crc extended over the partial block
+    log_block_meta_t tail_meta;
+    log_store_stats_t stats;
+    log_lz_t lz;
+    uint8_t  frame[LOG_SEG_FRAME_MAX];
+} log_store_t;
+
+/**
+ * @brief Open (or create) the store under `root` and start this boot's first segment.
+ *
+ * @param segment_kb  Text per segment including the 4 KB header, clamped to what the
+ *                    index can describe (compressed segments are smaller on the card).
+ * @param compress    LZ-compress data blocks
+ * @return false if the catalog or the first segment cannot be created.
+ */
+bool log_store_open(log_store_t *st, const char *root, uint16_t segment_kb, bool compress);
+
+/**
+ * @brief Write one sink request (full block or partial flush), rotating as needed.
+ *
+ * Partial writes are fsync'ed; full blocks are not.
+ */
+bool log_store_write(log_store_t *st, const log_sink_req_t *req);
+
+/**
+ * @brief Close the open segment (header + catalog slot) and the catalog.
+ */
+void log_store_close(log_store_t *st);
+
+/**
+ * @brief Boot sequence number of this run.
+ */
+static inline uint32_t log_store_boot(const log_store_t *st) {
+    return st->cat.boot;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_STORE_H
@@ -1,16 +1,29 @@
 // File: main/main.c
 // ==========================================================================================
 // Main application for OptiPulse™ Developer Training Project
-// This program tests all LED patterns implemented in led_handler.c
+// Boots in timed phases (see boot_profile.h); with boot.led_demo set it also cycles
+// through all LED patterns implemented in led_handler.c
 // ==========================================================================================
 
 #include <stdio.h>                      // Standard I/O
 #include "freertos/FreeRTOS.h"         // FreeRTOS core
 #include "freertos/task.h"             // Delay / task APIs
 #include "led_handler.h"               // LED control interface
-#include "state_machine.h"             // Placeholder
+#include "state_machine.h"             // System FSM
 #include "esp_system.h"                // ESP-IDF system info
-#include "driver/uart.h"               // For serial input
+#include "esp_timer.h"                 // Boot step timing
+#include "config_parser.h"             // YAML config -> app_config_t
+#include "nvs_helper.h"                // NVS init + cached config blob
+#include "config_yaml_hash.h"          // CONFIG_YAML_HASH (generated by tools/config_hash.py)
+#include "cli_handler.h"               // UART command interface
+#include "boot_profile.h"              // Boot phase timing
+#include "sd_log.h"                    // Async SD card log writer
+#include "tether.h"                    // USB log transfer (TETHERED)
+#include "untether.h"                  // Wi-Fi log upload (UNTETHERED)
+#include "wifi_sta.h"                  // Station for the upload
+#include "rtv_handler.h"               // RTV capture pipeline
+#include "rtv_snap.h"                  // OPERATIONAL snapshots to SD
+#include "uart_input.h"                // Event-driven serial input
 
 void show_banner(void) {
     printf("\n");
@@ -23,43 +36,74 @@ void show_banner(void) {
     printf("###################################################################################\n\n");
 }
 
-// Wait for user to press 'c' before starting logic
-void wait_for_user_to_continue(void) {
-    char c = 0;
-
-    // UART0 config
-    uart_config_t uart_config = {
-        .baud_rate = 115200,
-        .data_bits = UART_DATA_8_BITS,
-        .parity    = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE
-    };
-    uart_param_config(UART_NUM_0, &uart_config);
-    uart_driver_install(UART_NUM_0, 256, 0, 0, NULL, 0);
+// Default config.yaml, embedded by EMBED_TXTFILES (NUL-terminated)
+extern const char config_yaml_start[] asm("_binary_config_yaml_start");
+extern const char config_yaml_end[]   asm("_binary_config_yaml_end");
 
-    while (1) {
-        int len = uart_read_bytes(UART_NUM_0, (uint8_t*)&c, 1, pdMS_TO_TICKS(100));
-        if (len > 0 && (c == 'c' || c == 'C')) {
-            printf("[CONTINUE] Starting main functionality...\n\n");
-            break;
-        }
-        vTaskDelay(pdMS_TO_TICKS(100));
+static app_config_t app_config;
+
+// Load the config: cached blob from NVS if config.yaml and the schema are unchanged
+// (warm path, one blob read), otherwise parse the YAML and refresh the cache (cold path).
+// The YAML is hashed at build time (CONFIG_YAML_HASH), so the warm path never reads it.
+void load_config(void) {
+    size_t len = (size_t)(config_yaml_end - config_yaml_start) - 1;
+    config_error_t err;
+
+    int64_t t0 = esp_timer_get_time();
+    uint32_t source_hash = CONFIG_YAML_HASH;
+    uint32_t schema_hash = config_schema_hash();
+
+    if (nvs_config_load(source_hash, schema_hash, &app_config) == ESP_OK) {
+        printf("[CONFIG] Warm boot: cached config loaded in %lld us (device '%s')\n",
+               (long long)(esp_timer_get_time() - t0), app_config.device_name);
+        return;
     }
+
+    config_status_t rc = config_parse_buffer(config_yaml_start, len, &app_config, &err);
+    int64_t t1 = esp_timer_get_time();
+
+    if (rc != CONFIG_OK) {
+        printf("[CONFIG] config.yaml:%u:%u: %s -> using defaults\n",
+               err.line, err.column, config_status_str(rc));
+        config_set_defaults(&app_config);
+        return;
+    }
+
+    nvs_config_store(source_hash, schema_hash, &app_config);
+    printf("[CONFIG] Cold boot: parsed %u bytes in %lld us, cached in %lld us (device '%s', Wi-Fi '%s')\n",
+           (unsigned)len, (long long)(t1 - t0), (long long)(esp_timer_get_time() - t1),
+           app_config.device_name, app_config.wifi_ssid);
 }
 
-void app_main(void) {
-    show_banner();
-    printf("\n[FIRMWARE HALT] Type 'c' and press ENTER to continue...\n");
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    wait_for_user_to_continue();
+// Optional boot hold (boot.hold_ms > 0): wait up to hold_ms for 'c' + ENTER, then continue
+// either way. Blocks on the UART input ring, so it costs no wakeups while nobody types.
+void wait_for_user_to_continue(uint32_t hold_ms) {
+    uart_input_msg_t msg;
+    int64_t deadline = esp_timer_get_time() + (int64_t)hold_ms * 1000;
 
-    // === Initialize LED control ===
-    led_handler_init();
+    printf("\n[BOOT HOLD] Type 'c' and press ENTER to continue (auto-continue in %u ms)...\n",
+           (unsigned)hold_ms);
 
+    for (;;) {
+        int64_t left_us = deadline - esp_timer_get_time();
+        if (left_us <= 0) {
+            printf("[CONTINUE] Hold timed out, starting main functionality...\n\n");
+            return;
+        }
+        TickType_t ticks = pdMS_TO_TICKS((left_us + 999) / 1000);
+        if (uart_input_get(&msg, ticks ? ticks : 1) && msg.type == UART_INPUT_LINE &&
+            (msg.line[0] == 'c' || msg.line[0] == 'C')) {
+            printf("[CONTINUE] Starting main functionality...\n\n");
+            return;
+        }
+    }
+}
+
+// Cycle the STATE LED through every pattern (boot.led_demo)
+void run_led_demo(void) {
     // === Pattern 1: DEV_MODE ===
     printf("[MAIN] Applying DEV_MODE pattern (constant ON)\n");
-    led_apply_pattern(LED_PATTERN_DEV_MODE);
+    led_apply_pattern(LED_CHANNEL_STATE, LED_PATTERN_DEV_MODE);
     vTaskDelay(pdMS_TO_TICKS(5000));
 
     printf("[MAIN] LED debug status (should show info only in DEV_MODE)\n");
@@ -68,32 +112,32 @@ void app_main(void) {
 
     // === Pattern 2: OPERATIONAL ===
     printf("[MAIN] Applying OPERATIONAL pattern (1Hz blinking)\n");
-    led_apply_pattern(LED_PATTERN_OPERATIONAL);
+    led_apply_pattern(LED_CHANNEL_STATE, LED_PATTERN_OPERATIONAL);
     vTaskDelay(pdMS_TO_TICKS(5000));
 
     // === Pattern 3: RTV_ACTIVE ===
     printf("[MAIN] Applying RTV_ACTIVE pattern (5x 10Hz blinks → pause)\n");
-    led_apply_pattern(LED_PATTERN_RTV_ACTIVE);
+    led_apply_pattern(LED_CHANNEL_STATE, LED_PATTERN_RTV_ACTIVE);
     vTaskDelay(pdMS_TO_TICKS(5000));
 
     // === Pattern 4: HALTED_ENTRY ===
     printf("[MAIN] Applying HALTED_ENTRY pattern (2Hz for 5s, then OFF)\n");
-    led_apply_pattern(LED_PATTERN_HALTED_ENTRY);
+    led_apply_pattern(LED_CHANNEL_STATE, LED_PATTERN_HALTED_ENTRY);
     vTaskDelay(pdMS_TO_TICKS(3000));  // Enough to confirm it stops
 
     // === Pattern 5: TRANSFER_COMPLETE ===
     printf("[MAIN] Applying TRANSFER_COMPLETE pattern (500ms ON / 1s OFF)\n");
-    led_apply_pattern(LED_PATTERN_TRANSFER_COMPLETE);
+    led_apply_pattern(LED_CHANNEL_STATE, LED_PATTERN_TRANSFER_COMPLETE);
     vTaskDelay(pdMS_TO_TICKS(5000));
 
     // === Pattern 6: TETHERED ===
     printf("[MAIN] Applying TETHERED pattern (0.5Hz slow blink)\n");
-    led_apply_pattern(LED_PATTERN_TETHERED);
+    led_apply_pattern(LED_CHANNEL_STATE, LED_PATTERN_TETHERED);
     vTaskDelay(pdMS_TO_TICKS(5000));
 
     // === Pattern 7: UNTETHERED ===
     printf("[MAIN] Applying UNTETHERED pattern (10x 2Hz blinks → 500ms pause)\n");
-    led_apply_pattern(LED_PATTERN_UNTETHERED);
+    led_apply_pattern(LED_CHANNEL_STATE, LED_PATTERN_UNTETHERED);
     vTaskDelay(pdMS_TO_TICKS(5000));
 
     // === Debug status in non-DEV_MODE ===
@@ -101,10 +145,93 @@ void app_main(void) {
     led_debug_status();
     vTaskDelay(pdMS_TO_TICKS(2000));
 
-    // === Deinitialize and exit ===
-    printf("[MAIN] Deinitializing LED handler\n");
-    led_handler_deinit();
+}
+
+void app_main(void) {
+    boot_profile_begin();
+    show_banner();
+    boot_profile_end(BOOT_PHASE_BANNER);
+
+    // === Load configuration ===
+    nvs_helper_init();
+    boot_profile_end(BOOT_PHASE_NVS);
+    load_config();
+    boot_profile_end(BOOT_PHASE_CONFIG);
+
+    // === Wi-Fi station (nothing starts until a user joins: RTV stream, upload, wifi CLI) ===
+    wifi_sta_init(app_config.wifi_ssid, app_config.wifi_password, app_config.wifi_max_retries,
+                  app_config.wifi_channels, app_config.wifi_channels_count);
+
+    // === SD card log (mounts in the background) and its USB / Wi-Fi transfers ===
+    if (app_config.log_to_sd) {
+        sd_log_init(app_config.log_segment_kb, app_config.log_compress);
+        tether_init(app_config.transfer_chunk_bytes, app_config.transfer_window,
+                    app_config.transfer_resume_s);
+        untether_config_t up = {
+            .url = app_config.transfer_upload_url,
+            .device = app_config.device_name,
+            .chunk_bytes = app_config.transfer_chunk_bytes,
+            .batch_kb = app_config.transfer_batch_kb,
+            .retries = app_config.transfer_retries,
+            .tether_fallback = app_config.transfer_tether_fallback,
+        };
+        untether_init(&up);
+        boot_profile_end(BOOT_PHASE_STORAGE);
+    }
+
+    // === UART0 input (boot hold and CLI) ===
+    bool uart_ok = uart_input_init() == ESP_OK;
+    boot_profile_end(BOOT_PHASE_UART);
+    if (uart_ok && app_config.boot_hold_ms > 0) {
+        wait_for_user_to_continue(app_config.boot_hold_ms);
+        boot_profile_end(BOOT_PHASE_HOLD);
+    }
+
+    // === Initialize LED control ===
+    led_handler_init();
+    boot_profile_end(BOOT_PHASE_LED);
+    if (app_config.boot_led_demo) {
+        run_led_demo();
+        boot_profile_end(BOOT_PHASE_LED_DEMO);
+    }
+
+    // === RTV capture task (idle until STATE_RTV) ===
+    rtv_config_t rtv = {
+        .fps = app_config.rtv_fps,
+        .width = app_config.rtv_width,
+        .height = app_config.rtv_height,
+        .format = rtv_format_from_str(app_config.rtv_format),
+        .buffers = app_config.rtv_buffers,
+        .motion = app_config.rtv_synth_motion,
+        .jpeg_quality = app_config.rtv_jpeg_quality,
+        .session_s = app_config.rtv_session_s,
+        .port = app_config.rtv_port,
+        .max_viewers = app_config.rtv_max_viewers,
+        .adaptive = app_config.rtv_adaptive,
+        .fps_min = app_config.rtv_fps_min,
+        .jpeg_quality_min = app_config.rtv_jpeg_quality_min,
+        .motion_threshold = app_config.rtv_motion_threshold,
+        .motion_blocks = app_config.rtv_motion_blocks,
+        .motion_keepalive_s = app_config.rtv_motion_keepalive_s,
+        .scale = app_config.rtv_scale,
+    };
+    rtv_handler_init(&rtv);
+    if (app_config.log_to_sd) {
+        rtv_snap_init(app_config.rtv_snapshot_s, app_config.rtv_snapshot_scale);
+    }
+
+    // === Hand the STATE LED over to the state machine ===
+    printf("[MAIN] Starting state machine\n");
+    state_machine_init();
+    state_machine_start();
+    boot_profile_end(BOOT_PHASE_FSM);
+
+    // === CLI on UART0 (text commands and binary frames) ===
+    cli_register_commands();
+    cli_start();
+    boot_profile_end(BOOT_PHASE_CLI);
+
+    boot_profile_finish(app_config.boot_budget_ms);
 
     // Reserved for CLI/RTV/Storage logic
-    // state_machine_start();
 }
@@ -0,0 +1,171 @@
+// File: main/nvs_helper.c
+// ==========================================================================================
+// NVS helpers. The config cache is a single blob:
+//   [ nvs_config_hdr_t | app_config_t ]
+// The header carries a magic, the blob format version and both hashes; any mismatch
+// is treated as a miss, so the caller falls back to parsing the YAML source.
+// State blobs (upload cursor, ...) are plain fixed-size blobs under their own keys.
+// ==========================================================================================
+
+#include <string.h>
+#include "nvs_helper.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_log.h"
+
+#define NVS_CONFIG_KEY      "cfg_blob"
+#define NVS_CONFIG_MAGIC    0x4643504Fu     // "OPCF"
+#define NVS_CONFIG_FORMAT   1               // Bump when the header layout changes
+
+static const char *TAG = "NVS_HELPER";
+
+/**
+ * @brief Header in front of the cached app_config_t.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t size;          ///< sizeof(app_config_t) when written
+    uint32_t schema_hash;
+    uint32_t source_hash;
+} nvs_config_hdr_t;
+
+typedef struct {
+    nvs_config_hdr_t hdr;
+    app_config_t     cfg;
+} nvs_config_blob_t;
+
+static nvs_config_blob_t blob;      // Static: keeps ~300 bytes off the boot task stack
+
+// === Initialization ===
+
+esp_err_t nvs_helper_init(void) {
+    esp_err_t err = nvs_flash_init();
+
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition needs erase (%s), erasing...", esp_err_to_name(err));
+        err = nvs_flash_erase();
+        if (err == ESP_OK) {
+            err = nvs_flash_init();
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+// === Config Cache ===
+
+esp_err_t nvs_config_load(uint32_t source_hash, uint32_t schema_hash, app_config_t *out) {
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(NVS_HELPER_NAMESPACE, NVS_READONLY, &h);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;       // Namespace not created yet: first boot
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(h, NVS_CONFIG_KEY, &blob, &len);
+    nvs_close(h);
+
+    if (err == ESP_ERR_NVS_NOT_FOUND || err == ESP_ERR_NVS_INVALID_LENGTH) {
+        return ESP_ERR_NOT_FOUND;       // No blob, or one from a bigger layout
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (len != sizeof(blob) ||
+        blob.hdr.magic != NVS_CONFIG_MAGIC ||
+        blob.hdr.format != NVS_CONFIG_FORMAT ||
+        blob.hdr.size != sizeof(app_config_t) ||
+        blob.hdr.schema_hash != schema_hash ||
+        blob.hdr.source_hash != source_hash) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memcpy(out, &blob.cfg, sizeof(*out));
+    return ESP_OK;
+}
+
+esp_err_t nvs_config_store(uint32_t source_hash, uint32_t schema_hash, const app_config_t *cfg) {
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(NVS_HELPER_NAMESPACE, NVS_READWRITE, &h);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    blob.hdr = (nvs_config_hdr_t){
+        .magic = NVS_CONFIG_MAGIC,
+        .format = NVS_CONFIG_FORMAT,
+        .size = sizeof(app_config_t),
+        .schema_hash = schema_hash,
+        .source_hash = source_hash,
+    };
+    memcpy(&blob.cfg, cfg, sizeof(*cfg));
+
+    err = nvs_set_blob(h, NVS_CONFIG_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(h);
+    }
+    nvs_close(h);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store config blob: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t nvs_config_erase(void) {
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(NVS_HELPER_NAMESPACE, NVS_READWRITE, &h);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_erase_key(h, NVS_CONFIG_KEY);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        err = nvs_commit(h);
+    }
+    nvs_close(h);
+    return err;
+}
+
+// === State Blobs ===
+
+esp_err_t nvs_state_load(const char *key, void *out, size_t len) {
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(NVS_HELPER_NAMESPACE, NVS_READONLY, &h);
+    if (err != ESP_OK) {
+        return err == ESP_ERR_NVS_NOT_FOUND ? ESP_ERR_NOT_FOUND : err;
+    }
+
+    size_t got = len;
+    err = nvs_get_blob(h, key, out, &got);
+    nvs_close(h);
+    if (err == ESP_ERR_NVS_NOT_FOUND || err == ESP_ERR_NVS_INVALID_LENGTH ||
+        (err == ESP_OK && got != len)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return err;
+}
+
+esp_err_t nvs_state_store(const char *key, const void *data, size_t len) {
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(NVS_HELPER_NAMESPACE, NVS_READWRITE, &h);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(h, key, data, len);
+    if (err == ESP_OK) {
+        err = nvs_commit(h);
+    }
+    nvs_close(h);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store '%s': %s", key, esp_err_to_name(err));
+    }
+    return err;
+}
@@ -1,11 +1,64 @@
+// File: main/nvs_helper.h
+// ==========================================================================================
+// NVS access helpers: flash init, the cached binary configuration and small state blobs.
+// The parsed app_config_t is stored as one versioned blob, keyed by the hash of the
+// YAML source and the schema fingerprint, so boot only parses when either changes.
+// ==========================================================================================
+
 #ifndef NVS_HELPER_H
 #define NVS_HELPER_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "config_parser.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// your function declarations and structs/enums here
+#define NVS_HELPER_NAMESPACE    "optipulse"     // Namespace for all keys of this firmware
+
+/**
+ * @brief Initialize the default NVS partition.
+ *
+ * Erases and retries once if the partition is full or was written by a newer NVS format.
+ */
+esp_err_t nvs_helper_init(void);
+
+/**
+ * @brief Load the cached config if it was compiled from the same source and schema.
+ *
+ * One blob read; header and size are checked before anything is copied to `out`.
+ *
+ * @param source_hash config_hash() of the YAML text (CONFIG_YAML_HASH, computed at build time).
+ * @param schema_hash config_schema_hash() of the running firmware.
+ * @return ESP_OK on a hit, ESP_ERR_NOT_FOUND on a miss or stale blob, other errors from NVS.
+ */
+esp_err_t nvs_config_load(uint32_t source_hash, uint32_t schema_hash, app_config_t *out);
+
+/**
+ * @brief Store a freshly parsed config as the new cache entry.
+ */
+esp_err_t nvs_config_store(uint32_t source_hash, uint32_t schema_hash, const app_config_t *cfg);
+
+/**
+ * @brief Drop the cached config (next boot parses again).
+ */
+esp_err_t nvs_config_erase(void);
+
+/**
+ * @brief Read a fixed-size state blob (e.g. the upload cursor).
+ *
+ * @return ESP_ERR_NOT_FOUND if the key is absent or holds a blob of another size.
+ */
+esp_err_t nvs_state_load(const char *key, void *out, size_t len);
+
+/**
+ * @brief Write (and commit) a fixed-size state blob. Keys are at most 15 characters.
+ */
+esp_err_t nvs_state_store(const char *key, const void *data, size_t len);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,557 @@
+// File: main/rtv_handler.c
+// ==========================================================================================
+// RTV capture task: rtv_pipe steps at rtv.fps into a pool allocated for the session.
+// Pacing follows an absolute schedule, so the tick (10 ms) only adds jitter, not drift,
+// and a late frame is not made up with a burst. Waiting senders are woken through two
+// event group bits that alternate with the frame number: a sender that found frame N
+// waits for the bit of N+1, which stays set until N+2 is published, so a frame that
+// lands between its check and its wait is not missed.
+// The stream is opened before the pool and closed after it, so viewers always find the
+// pool closed (and give their frames back) before the server goes away. Frames the motion
+// gate skips are not losses: the rate controller is not told about them.
+// ==========================================================================================
+
+#include <string.h>
+#include <strings.h>
+#include <stdatomic.h>
+#include "rtv_handler.h"
+#include "rtv_jpeg.h"
+#include "rtv_scale.h"
+#include "rtv_stream.h"
+#include "state_machine.h"
+#include "led_handler.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+
+#define RTV_TASK_STACK      4096    // JPEG blocks on the stack
+#define RTV_TASK_PRIO       (tskIDLE_PRIORITY + 2)
+#define RTV_EVEN            BIT0    // Frame with an even number published
+#define RTV_ODD             BIT1    // ... odd
+#define RTV_STOPPED         BIT2    // No session: senders give up
+#define RTV_DRAIN_WARN_MS   1000    // Senders slow to release at the end of a session
+#define RTV_LED_BLINK_MIN_US 25000  // Fastest rate LED blink (30 fps would not be visible)
+
+static const char *TAG = "RTV";
+
+static TaskHandle_t task = NULL;
+static EventGroupHandle_t events;
+static atomic_bool cancel;
+static atomic_bool reset_req;
+static rtv_config_t config;
+static esp_timer_handle_t session_timer;
+static SemaphoreHandle_t led_lock;      ///< Rate LED updates vs. rtv_stop()
+
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+static rtv_pool_t pool;
+static bool active;                     ///< Pool usable (under pool_lock)
+static uint8_t *bufs[RTV_POOL_MAX];
+static uint8_t *thumbs[2];              ///< Motion gate thumbnails (reference, current)
+static uint16_t *scale_work;            ///< rtv.scale column sums
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static rtv_stats_t stats;
+
+// === Pool ops ===
+
+static void ops_lock(void *ctx) {
+    taskENTER_CRITICAL(&pool_lock);
+}
+
+static void ops_unlock(void *ctx) {
+    taskEXIT_CRITICAL(&pool_lock);
+}
+
+static uint64_t ops_now_us(void *ctx) {
+    return (uint64_t)esp_timer_get_time();
+}
+
+static void ops_published(void *ctx, const rtv_frame_t *f) {
+    EventBits_t bit = (f->seq & 1) ? RTV_ODD : RTV_EVEN;
+    xEventGroupSetBits(events, bit);
+    xEventGroupClearBits(events, bit ^ (RTV_EVEN | RTV_ODD));
+}
+
+static const rtv_pool_ops_t pool_ops = {
+    .lock = ops_lock,
+    .unlock = ops_unlock,
+    .now_us = ops_now_us,
+    .published = ops_published,
+};
+
+// === Session ===
+
+static void session_expired(void *arg) {
+    ESP_LOGI(TAG, "Session time (%u s) is up", (unsigned)config.session_s);
+    state_machine_post_event(EVENT_RTV_OFF);
+}
+
+static void pool_free(void) {
+    for (uint8_t i = 0; i < RTV_POOL_MAX; i++) {
+        heap_caps_free(bufs[i]);
+        bufs[i] = NULL;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        heap_caps_free(thumbs[i]);
+        thumbs[i] = NULL;
+    }
+    heap_caps_free(scale_work);
+    scale_work = NULL;
+}
+
+/**
+ * @brief Allocate the rtv.scale column sums. false leaves frames at full size.
+ */
+static bool scale_begin(rtv_scale_t *sc, uint16_t width) {
+    size_t bytes = rtv_scale_work_bytes(config.format, width);
+
+    scale_work = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!scale_work) {
+        ESP_LOGW(TAG, "No memory to scale frames (%u bytes), sending them at full size",
+                 (unsigned)bytes);
+        return false;
+    }
+    rtv_scale_init(sc, config.scale, false, scale_work, bytes, &rtv_scale_vector);
+    return true;
+}
+
+/**
+ * @brief Allocate the motion gate's thumbnails (16-byte aligned for the vector kernel).
+ *        false leaves the gate off for the session.
+ */
+static bool motion_begin(rtv_motion_t *m, size_t thumb_bytes) {
+    for (uint8_t i = 0; i < 2; i++) {
+        thumbs[i] = heap_caps_aligned_alloc(16, thumb_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!thumbs[i]) {
+            ESP_LOGW(TAG, "No memory for the motion gate (2 x %u bytes), sending every frame",
+                     (unsigned)thumb_bytes);
+            return false;
+        }
+    }
+    rtv_motion_config_t cfg = {
+        .threshold = config.motion_threshold,
+        .blocks = config.motion_blocks,
+        .keepalive_ms = config.motion_keepalive_s * 1000u,
+    };
+    rtv_motion_init(m, &cfg, thumbs[0], thumbs[1], thumb_bytes, rtv_motion_sad_vector,
+                    ops_now_us, NULL);
+    return true;
+}
+
+/**
+ * @brief Allocate the buffers (PSRAM first) and open the pool to senders.
+ */
+static bool session_begin(size_t frame_bytes, bool *psram) {
+    *psram = true;
+    for (uint8_t i = 0; i < config.buffers; i++) {
+        bufs[i] = heap_caps_malloc(frame_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!bufs[i]) {
+            bufs[i] = heap_caps_malloc(frame_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            *psram = false;
+        }
+        if (!bufs[i]) {
+            ESP_LOGE(TAG, "No memory for %u x %u byte frames (largest block %u)",
+                     (unsigned)config.buffers, (unsigned)frame_bytes,
+                     (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+            pool_free();
+            return false;
+        }
+    }
+    rtv_pool_init(&pool, &pool_ops, bufs, config.buffers, frame_bytes);
+    xEventGroupClearBits(events, RTV_EVEN | RTV_ODD | RTV_STOPPED);
+    taskENTER_CRITICAL(&pool_lock);
+    active = true;
+    taskEXIT_CRITICAL(&pool_lock);
+    return true;
+}
+
+/**
+ * @brief Close the pool to senders, wait until they let go, free it.
+ */
+static void session_end(void) {
+    uint32_t waited = 0;
+
+    taskENTER_CRITICAL(&pool_lock);
+    active = false;
+    taskEXIT_CRITICAL(&pool_lock);
+    xEventGroupSetBits(events, RTV_STOPPED);
+
+    while (rtv_pool_held(&pool)) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited += 10;
+        if (waited == RTV_DRAIN_WARN_MS) {
+            ESP_LOGW(TAG, "Senders still hold %u frames", (unsigned)rtv_pool_held(&pool));
+        }
+    }
+    pool_free();
+}
+
+// === Rate control ===
+
+/**
+ * @brief Show the rate on the STATE LED: blink speed follows the frame rate, blinks per
+ *        burst the quality, so 10 fps at q82 looks like the plain RTV_ACTIVE pattern.
+ *        Never after rtv_stop(): the next state's pattern must not be overwritten.
+ */
+static void show_rate(uint8_t fps, uint8_t quality) {
+    uint32_t blink_us = 500000u / fps;
+
+    xSemaphoreTake(led_lock, portMAX_DELAY);
+    if (!atomic_load(&cancel)) {
+        led_burst(LED_CHANNEL_STATE, (uint8_t)((quality + 19) / 20),
+                  blink_us < RTV_LED_BLINK_MIN_US ? RTV_LED_BLINK_MIN_US : blink_us, RTV_PAUSE_US);
+    }
+    xSemaphoreGive(led_lock);
+}
+
+/**
+ * @brief Close a controller window: sample the pipeline and the viewers, apply the result.
+ *        `gated`: frames the motion gate skipped in the window (counted in pipe dropped).
+ */
+static void rate_window(rtv_rate_t *rate, const rtv_pipe_t *pipe, rtv_pipe_stats_t *mark,
+                        rtv_jpeg_t *jpeg, uint32_t gated, int64_t window_us) {
+    rtv_rate_sample_t s = {
+        .window_us = (uint32_t)window_us,
+        .published = pipe->stats.published - mark->published,
+        .dropped = (pipe->stats.no_frame + pipe->stats.dropped) - (mark->no_frame + mark->dropped) -
+                   gated,
+    };
+    uint8_t fps = rate->fps, quality = rate->quality;
+
+    *mark = pipe->stats;
+    rtv_stream_take_load(&s);
+    rtv_rate_action_t a = rtv_rate_update(rate, &s);
+    if (rate->quality != quality) {
+        rtv_jpeg_set_quality(jpeg, rate->quality);
+    }
+    if (rate->fps != fps || rate->quality != quality) {
+        ESP_LOGI(TAG, "Rate %s: %u fps, q%u (%u viewers, send %u%%, missed %u%%, %u lost)",
+                 rtv_rate_action_str(a), (unsigned)rate->fps, (unsigned)rate->quality,
+                 (unsigned)s.viewers, (unsigned)(rate->load_pm / 10), (unsigned)rate->skip_pct,
+                 (unsigned)s.dropped);
+        show_rate(rate->fps, rate->quality);
+    }
+}
+
+// === Task ===
+
+static void rtv_task(void *arg) {
+    static rtv_synth_t synth;
+    static rtv_source_t source;
+    static rtv_pipe_t pipe;
+    static rtv_jpeg_t jpeg;
+    static rtv_stage_t jpeg_stage;
+    static rtv_motion_t motion;
+    static rtv_stage_t motion_stage;
+    static rtv_scale_t scale;
+    static rtv_stage_t scale_stage;
+    static rtv_rate_t rate;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (rtv_stream_open(config.port, config.max_viewers) != ESP_OK) {
+            state_machine_post_event(EVENT_RTV_OFF);
+            continue;
+        }
+        size_t frame_bytes = rtv_frame_size(config.format, config.width & ~1u, config.height);
+        bool psram;
+        if (!session_begin(frame_bytes, &psram)) {
+            rtv_stream_close();
+            state_machine_post_event(EVENT_RTV_OFF);
+            continue;
+        }
+        rtv_synth_init(&synth, &source, config.width, config.height, config.format, config.motion);
+        rtv_pipe_init(&pipe, &pool, &source);
+        uint16_t width = synth.width, height = config.height;
+        memset(&scale, 0, sizeof(scale));
+        if (config.scale > 1 && scale_begin(&scale, synth.width)) {
+            rtv_scale_stage(&scale, &scale_stage);
+            rtv_pipe_add_stage(&pipe, &scale_stage);       // First: the rest works on less
+            rtv_scale_size(config.format, synth.width, config.height, config.scale, &width, &height);
+        }
+        memset(&motion, 0, sizeof(motion));
+        bool gate = config.motion_threshold &&
+                    motion_begin(&motion, rtv_motion_thumb_bytes(width, height));
+        if (gate) {
+            rtv_motion_stage(&motion, &motion_stage);
+            rtv_pipe_add_stage(&pipe, &motion_stage);     // Before the encoder: skips cost no JPEG
+        }
+        rtv_jpeg_init(&jpeg, rtv_jpeg_quality_from_camera(config.jpeg_quality));
+        rtv_jpeg_stage(&jpeg, &jpeg_stage);
+        rtv_pipe_add_stage(&pipe, &jpeg_stage);       // JPEG out of a second buffer
+        esp_timer_start_once(session_timer, (uint64_t)config.session_s * 1000000);
+
+        rtv_rate_limits_t lim = {
+            .fps_min = config.fps_min,
+            .fps_max = config.fps,
+            .q_min = rtv_jpeg_quality_from_camera(config.jpeg_quality_min),
+            .q_max = jpeg.quality,
+        };
+        rtv_rate_init(&rate, &lim);
+        rtv_pipe_stats_t mark = { 0 };
+        uint32_t gated_mark = 0;
+
+        int64_t t0 = esp_timer_get_time();
+        taskENTER_CRITICAL(&stats_lock);
+        stats.running = true;
+        stats.sessions++;
+        stats.psram = psram;
+        stats.buffers = config.buffers;
+        stats.frame_bytes = frame_bytes;
+        stats.source = source.name;
+        stats.jpeg_overflows = 0;
+        stats.adaptive = config.adaptive;
+        stats.rate = rate;
+        stats.motion_gate = gate;
+        stats.width = width;
+        stats.height = height;
+        stats.scale = scale.stats;
+        stats.motion = motion.stats;
+        for (uint8_t i = 0; i < RTV_STAGES_MAX; i++) {
+            stats.stage_names[i] = i < pipe.n_stages ? pipe.stages[i]->name : NULL;
+        }
+        stats.elapsed_ms = 0;
+        memset(&stats.pipe, 0, sizeof(stats.pipe));
+        taskEXIT_CRITICAL(&stats_lock);
+        ESP_LOGI(TAG, "Session started: %ux%u %s at %u fps, JPEG q%u%s, %u x %u KB buffers in %s",
+                 (unsigned)width, (unsigned)height, rtv_format_str(config.format),
+                 (unsigned)config.fps, (unsigned)jpeg.quality, config.adaptive ? " (adaptive)" : "",
+                 (unsigned)config.buffers, (unsigned)(frame_bytes >> 10),
+                 psram ? "PSRAM" : "internal RAM");
+        show_rate(rate.fps, rate.quality);
+
+        const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+        int64_t next = esp_timer_get_time();
+        int64_t window = next;
+        while (!atomic_load(&cancel)) {
+            if (atomic_exchange(&reset_req, false)) {
+                memset(&pipe.stats, 0, sizeof(pipe.stats));
+                memset(&mark, 0, sizeof(mark));
+                memset(&motion.stats, 0, sizeof(motion.stats));
+                gated_mark = 0;
+                t0 = esp_timer_get_time();
+            }
+            rtv_pipe_step(&pipe);
+
+            int64_t now = esp_timer_get_time();
+            if (config.adaptive && now - window >= RTV_RATE_WINDOW_MS * 1000) {
+                rate_window(&rate, &pipe, &mark, &jpeg, motion.stats.skipped - gated_mark,
+                            now - window);
+                gated_mark = motion.stats.skipped;
+                window = now;
+            }
+            taskENTER_CRITICAL(&stats_lock);
+            stats.pipe = pipe.stats;
+            stats.jpeg_overflows = jpeg.overflows;
+            stats.rate = rate;
+            stats.motion = motion.stats;
+            stats.scale = scale.stats;
+            stats.elapsed_ms = (uint32_t)((now - t0) / 1000);
+            taskEXIT_CRITICAL(&stats_lock);
+
+            next += 1000000 / rate.fps;
+            if (next <= now) {
+                next = now;             // Behind: drop the lost time, no catch-up burst
+                taskYIELD();
+            } else {
+                vTaskDelay((TickType_t)((next - now + tick_us - 1) / tick_us));
+            }
+        }
+
+        esp_timer_stop(session_timer);
+        session_end();
+        rtv_stream_close();
+        rtv_pool_stats_t ps = pool.stats;
+        taskENTER_CRITICAL(&stats_lock);
+        stats.running = false;
+        stats.pool = ps;
+        taskEXIT_CRITICAL(&stats_lock);
+        ESP_LOGI(TAG, "Session ended: %u frames in %u ms, %u stale, %u starved, age avg %u us",
+                 (unsigned)pipe.stats.published, (unsigned)stats.elapsed_ms, (unsigned)ps.stale,
+                 (unsigned)ps.starved,
+                 ps.age_count ? (unsigned)(ps.age_total_us / ps.age_count) : 0);
+    }
+}
+
+// === Public API ===
+
+rtv_format_t rtv_format_from_str(const char *s) {
+    for (int f = 0; f < RTV_FMT_JPEG; f++) {
+        if (strcasecmp(s, rtv_format_str((rtv_format_t)f)) == 0) {
+            return (rtv_format_t)f;
+        }
+    }
+    return RTV_FMT_COUNT;
+}
+
+esp_err_t rtv_handler_init(const rtv_config_t *cfg) {
+    if (task) {
+        return ESP_OK;
+    }
+    config = *cfg;
+    if (config.format >= RTV_FMT_JPEG) {
+        ESP_LOGW(TAG, "Unsupported rtv.format, using yuv422");
+        config.format = RTV_FMT_YUV422;
+    }
+    if (config.fps == 0) {
+        config.fps = 1;
+    }
+    if (config.buffers < 3 || config.buffers > RTV_POOL_MAX) {
+        config.buffers = 4;
+    }
+    if (config.fps_min == 0 || config.fps_min > config.fps) {
+        config.fps_min = config.fps;
+    }
+    if (config.jpeg_quality_min < config.jpeg_quality) {
+        config.jpeg_quality_min = config.jpeg_quality;      // Camera scale: larger is worse
+    }
+    if (config.scale == 0 || config.scale > RTV_SCALE_MAX) {
+        config.scale = 1;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = session_expired,
+        .name = "rtv_session",
+    };
+    events = xEventGroupCreate();
+    led_lock = xSemaphoreCreateMutex();
+    if (!events || !led_lock || esp_timer_create(&timer_args, &session_timer) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    xEventGroupSetBits(events, RTV_STOPPED);
+    if (xTaskCreate(rtv_task, "rtv", RTV_TASK_STACK, NULL, RTV_TASK_PRIO, &task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create RTV task");
+        task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void rtv_start(void) {
+    if (!task) {
+        ESP_LOGW(TAG, "Not initialised: no RTV");
+        state_machine_post_event(EVENT_RTV_OFF);
+        return;
+    }
+    atomic_store(&cancel, false);
+    xTaskNotifyGive(task);
+}
+
+void rtv_stop(void) {
+    if (led_lock) {
+        xSemaphoreTake(led_lock, portMAX_DELAY);    // A rate LED update in flight lands first
+    }
+    atomic_store(&cancel, true);
+    if (led_lock) {
+        xSemaphoreGive(led_lock);
+    }
+    if (events) {
+        xEventGroupSetBits(events, RTV_STOPPED);
+    }
+}
+
+esp_err_t rtv_snapshot(uint8_t scale, uint8_t **out, uint16_t *width, uint16_t *height) {
+    rtv_synth_t synth;
+    rtv_source_t source;
+    uint8_t *buf;
+
+    if (!task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (scale == 0) {
+        scale = (uint8_t)((config.width + RTV_PREVIEW_W - 1) / RTV_PREVIEW_W);
+    }
+    size_t frame_bytes = rtv_frame_size(config.format, config.width & ~1u, config.height);
+    size_t work_bytes = rtv_scale_work_bytes(config.format, config.width);
+    uint16_t *work = heap_caps_malloc(work_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    buf = heap_caps_malloc(frame_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf) {
+        buf = heap_caps_malloc(frame_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!work || !buf) {
+        heap_caps_free(work);
+        heap_caps_free(buf);
+        return ESP_ERR_NO_MEM;
+    }
+
+    rtv_synth_init(&synth, &source, config.width, config.height, config.format, config.motion);
+    synth.frames = (uint32_t)(esp_timer_get_time() / (1000000 / config.fps));   // Bar where it is now
+    rtv_frame_t f = { .data = buf, .cap = frame_bytes };
+    bool ok = source.capture(source.ctx, &f);
+
+    rtv_scale_t sc;
+    rtv_scale_init(&sc, scale, true, work, work_bytes, &rtv_scale_vector);
+    ok = ok && rtv_scale_frame(&sc, &f);
+    heap_caps_free(work);
+    if (!ok) {
+        heap_caps_free(buf);
+        return ESP_FAIL;
+    }
+    uint8_t *small = heap_caps_realloc(buf, f.len, MALLOC_CAP_8BIT);    // Give back the rest
+    *out = small ? small : buf;
+    *width = f.width;
+    *height = f.height;
+    return ESP_OK;
+}
+
+bool rtv_session_open(void) {
+    taskENTER_CRITICAL(&pool_lock);
+    bool open = active && !atomic_load(&cancel);
+    taskEXIT_CRITICAL(&pool_lock);
+    return open;
+}
+
+rtv_frame_t *rtv_acquire(uint32_t after_seq, uint32_t timeout_ms) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS(timeout_ms);
+
+    if (!events) {
+        return NULL;
+    }
+    for (;;) {
+        rtv_frame_t *f = NULL;
+        taskENTER_CRITICAL(&pool_lock);         // Nests with the pool's own lock
+        bool open = active && !atomic_load(&cancel);
+        if (open) {
+            f = rtv_pool_acquire(&pool, after_seq);
+        }
+        taskEXIT_CRITICAL(&pool_lock);
+        if (f || !open) {
+            return f;
+        }
+
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= limit) {
+            return NULL;
+        }
+        EventBits_t next = ((after_seq + 1) & 1) ? RTV_ODD : RTV_EVEN;
+        xEventGroupWaitBits(events, next | RTV_STOPPED, pdFALSE, pdFALSE, limit - waited);
+    }
+}
+
+void rtv_release(rtv_frame_t *f) {
+    if (f) {
+        rtv_pool_release(&pool, f);
+    }
+}
+
+void rtv_get_stats(rtv_stats_t *out, bool reset) {
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    taskENTER_CRITICAL(&pool_lock);
+    bool open = active;
+    taskEXIT_CRITICAL(&pool_lock);
+    if (open) {
+        rtv_pool_get_stats(&pool, &out->pool, reset);   // Live
+        if (reset) {
+            atomic_store(&reset_req, true);
+        }
+    }
+}
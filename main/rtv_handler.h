@@ -0,0 +1,141 @@
+// File: main/rtv_handler.h
+// ==========================================================================================
+// Real-Time View session. On entry to STATE_RTV the capture task allocates the frame
+// pool (rtv.buffers buffers, PSRAM when there is some) and runs the pipeline at rtv.fps;
+// senders take the latest frame by reference with rtv_acquire() and give it back with
+// rtv_release(). On exit the task stops capturing, waits for the senders to let go and
+// frees the pool, so the memory is only in use during a session.
+// There is no camera driver in the build yet: the source is the synthetic test pattern
+// (rtv_pipe.h), rtv.width x rtv.height in rtv.format, JPEG-encoded by a pipeline stage
+// (rtv_jpeg.h) and served over HTTP (rtv_stream.h). A session lasts rtv.session_s from
+// the moment the stream is up, then posts EVENT_RTV_OFF. With rtv.adaptive the frame rate
+// and JPEG quality follow the viewers' backpressure (rtv_rate.h) within rtv.fps_min..
+// rtv.fps and rtv.jpeg_quality_min..rtv.jpeg_quality; the STATE LED shows them (blink
+// speed: frame rate, blinks per burst: quality / 20). With rtv.motion_threshold set, a
+// motion gate (rtv_motion.h) ahead of the encoder skips frames that show no change;
+// with rtv.scale > 1 frames are box-downscaled (rtv_scale.h) before anything else.
+// ==========================================================================================
+
+#ifndef RTV_HANDLER_H
+#define RTV_HANDLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "rtv_pool.h"
+#include "rtv_pipe.h"
+#include "rtv_rate.h"
+#include "rtv_motion.h"
+#include "rtv_scale.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_PREVIEW_W       64      // rtv_snapshot() scale 0: fits a terminal line
+
+/**
+ * @brief Session settings (the rtv config section).
+ */
+typedef struct {
+    uint8_t      fps;           ///< rtv.fps
+    uint16_t     width;         ///< rtv.width
+    uint16_t     height;        ///< rtv.height
+    rtv_format_t format;        ///< rtv.format
+    uint8_t      buffers;       ///< rtv.buffers
+    uint8_t      motion;        ///< rtv.synth_motion (test pattern)
+    uint8_t      jpeg_quality;  ///< rtv.jpeg_quality (camera scale, 4 best .. 63)
+    uint16_t     session_s;     ///< rtv.session_s
+    uint16_t     port;          ///< rtv.port
+    uint8_t      max_viewers;   ///< rtv.max_viewers
+    bool         adaptive;      ///< rtv.adaptive
+    uint8_t      fps_min;       ///< rtv.fps_min
+    uint8_t      jpeg_quality_min; ///< rtv.jpeg_quality_min (camera scale, the worst allowed)
+    uint8_t      motion_threshold;   ///< rtv.motion_threshold (0: every frame is sent)
+    uint8_t      motion_blocks;      ///< rtv.motion_blocks
+    uint8_t      motion_keepalive_s; ///< rtv.motion_keepalive_s
+    uint8_t      scale;         ///< rtv.scale (1: full size)
+} rtv_config_t;
+
+/**
+ * @brief Session counters (printed by the rtv CLI command).
+ */
+typedef struct {
+    bool             running;
+    uint32_t         sessions;
+    bool             psram;         ///< Pool is in PSRAM
+    uint8_t          buffers;
+    size_t           frame_bytes;   ///< Per buffer
+    uint32_t         elapsed_ms;    ///< Current session, or the last one
+    const char      *source;
+    uint16_t         width;         ///< Frames as encoded (after rtv.scale)
+    uint16_t         height;
+    rtv_scale_stats_t scale;
+    uint32_t         jpeg_overflows; ///< Frames larger than a buffer (dropped)
+    bool             adaptive;
+    rtv_rate_t       rate;          ///< Current fps / quality and the last window
+    bool             motion_gate;   ///< Unchanged frames are skipped
+    rtv_motion_stats_t motion;
+    const char      *stage_names[RTV_STAGES_MAX]; ///< For pipe.stage_us
+    rtv_pipe_stats_t pipe;
+    rtv_pool_stats_t pool;
+} rtv_stats_t;
+
+/**
+ * @brief Parse rtv.format ("gray", "rgb565", "yuv422"). RTV_FMT_COUNT if unknown.
+ */
+rtv_format_t rtv_format_from_str(const char *s);
+
+/**
+ * @brief Start the (idle) capture task. Sessions run on rtv_start().
+ */
+esp_err_t rtv_handler_init(const rtv_config_t *cfg);
+
+/**
+ * @brief Begin a session (RTV entry). Never blocks. Posts EVENT_RTV_OFF if the stream
+ *        cannot be served or the pool cannot be allocated, and when rtv.session_s is up.
+ */
+void rtv_start(void);
+
+/**
+ * @brief End the session (RTV exit). Does not wait for the session to wind down;
+ *        waiting senders are woken up.
+ */
+void rtv_stop(void);
+
+/**
+ * @brief Capture one frame from the RTV source and reduce it to gray luma `scale` times
+ *        smaller (box average). Works with or without a session: the CLI preview and
+ *        the SD snapshots (rtv_snap.h). scale 0: the smallest factor that makes it at
+ *        most RTV_PREVIEW_W pixels wide.
+ *
+ * @param out  Receives width x height bytes; free with heap_caps_free()
+ * @return ESP_ERR_NO_MEM without room for one full-size frame, ESP_FAIL if the capture
+ *         failed or the frame is smaller than one box
+ */
+esp_err_t rtv_snapshot(uint8_t scale, uint8_t **out, uint16_t *width, uint16_t *height);
+
+/**
+ * @brief True while a session delivers frames (senders stop when it turns false).
+ */
+bool rtv_session_open(void);
+
+/**
+ * @brief Wait up to timeout_ms for a frame newer than after_seq (0: any).
+ *
+ * @return A referenced frame (rtv_release() it), or NULL on timeout or outside a session.
+ */
+rtv_frame_t *rtv_acquire(uint32_t after_seq, uint32_t timeout_ms);
+
+void rtv_release(rtv_frame_t *f);
+
+/**
+ * @brief Snapshot of the counters; `reset` clears the pool and pipeline counters.
+ */
+void rtv_get_stats(rtv_stats_t *out, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_HANDLER_H
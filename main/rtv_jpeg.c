@@ -0,0 +1,445 @@
+// File: main/rtv_jpeg.c
+// ==========================================================================================
+// Baseline JPEG encoder (see rtv_jpeg.h). One pass over the frame in MCUs (8x8 gray,
+// 16x8 for 4:2:2), edges padded by repeating the last row/column. The bit writer stops
+// at the end of the output buffer and the frame is reported as not fitting; it never
+// writes past cap.
+// ==========================================================================================
+
+#include <string.h>
+#include "rtv_jpeg.h"
+
+// === Tables (ITU T.81 Annex K) ===
+
+static const uint8_t zigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+static const uint8_t base_qt[2][64] = {
+    {   16, 11, 10, 16, 24, 40, 51, 61,    12, 12, 14, 19, 26, 58, 60, 55,
+        14, 13, 16, 24, 40, 57, 69, 56,    14, 17, 22, 29, 51, 87, 80, 62,
+        18, 22, 37, 56, 68,109,103, 77,    24, 35, 55, 64, 81,104,113, 92,
+        49, 64, 78, 87,103,121,120,101,    72, 92, 95, 98,112,100,103, 99 },
+    {   17, 18, 24, 47, 99, 99, 99, 99,    18, 21, 26, 66, 99, 99, 99, 99,
+        24, 26, 56, 99, 99, 99, 99, 99,    47, 66, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,    99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,    99, 99, 99, 99, 99, 99, 99, 99 },
+};
+
+static const uint8_t dc_bits[2][16] = {
+    { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 },
+    { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 },
+};
+
+static const uint8_t dc_vals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t ac_bits[2][16] = {
+    { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d },
+    { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 },
+};
+
+static const uint8_t ac_vals[2][162] = {
+    {   0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+        0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+        0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+        0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+        0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+        0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+        0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa },
+    {   0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+        0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+        0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+        0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+        0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+        0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+        0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+        0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+        0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+        0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa },
+};
+
+static const float aan_scale[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f,
+};
+
+// === Bit writer ===
+
+typedef struct {
+    uint8_t *p;
+    uint8_t *end;
+    uint32_t acc;
+    int      n;
+    bool     full;
+} bits_t;
+
+static void put_byte(bits_t *b, uint8_t v) {
+    if (b->p < b->end) {
+        *b->p++ = v;
+    } else {
+        b->full = true;
+    }
+}
+
+static void put_bits(bits_t *b, uint32_t v, int len) {
+    b->acc = (b->acc << len) | (v & ((1u << len) - 1));
+    b->n += len;
+    while (b->n >= 8) {
+        uint8_t c = (uint8_t)(b->acc >> (b->n - 8));
+        put_byte(b, c);
+        if (c == 0xFF) {
+            put_byte(b, 0);             // Byte stuffing
+        }
+        b->n -= 8;
+    }
+    b->acc &= (1u << b->n) - 1;
+}
+
+static void put_u16(bits_t *b, uint16_t v) {
+    put_byte(b, (uint8_t)(v >> 8));
+    put_byte(b, (uint8_t)v);
+}
+
+// === Tables ===
+
+static void build_codes(rtv_jpeg_code_t *t, const uint8_t bits[16], const uint8_t *vals) {
+    uint16_t code = 0;
+    int k = 0;
+
+    for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < bits[len - 1]; i++, k++) {
+            t[vals[k]].code = code++;
+            t[vals[k]].len = (uint8_t)len;
+        }
+        code <<= 1;
+    }
+}
+
+uint8_t rtv_jpeg_quality_from_camera(uint8_t camera_quality) {
+    int q = 100 - camera_quality * 3 / 2;
+    return (uint8_t)(q < 5 ? 5 : q > 100 ? 100 : q);
+}
+
+void rtv_jpeg_set_quality(rtv_jpeg_t *j, uint8_t quality) {
+    int scale;
+
+    quality = quality < 1 ? 1 : quality > 100 ? 100 : quality;
+    scale = quality < 50 ? 5000 / quality : 200 - quality * 2;      // libjpeg scaling
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < 64; i++) {
+            int q = (base_qt[t][i] * scale + 50) / 100;
+            j->qt[t][i] = (uint8_t)(q < 1 ? 1 : q > 255 ? 255 : q);
+            j->fdiv[t][i] = 1.0f / (j->qt[t][i] * aan_scale[i >> 3] * aan_scale[i & 7] * 8.0f);
+        }
+    }
+    j->quality = quality;
+}
+
+void rtv_jpeg_init(rtv_jpeg_t *j, uint8_t quality) {
+    memset(j, 0, sizeof(*j));
+    for (int t = 0; t < 2; t++) {
+        build_codes(j->dc[t], dc_bits[t], dc_vals);
+        build_codes(j->ac[t], ac_bits[t], ac_vals[t]);
+    }
+    rtv_jpeg_set_quality(j, quality);
+}
+
+// === Block coding ===
+
+/**
+ * @brief Float AAN forward DCT in place (output scaled by aan_scale, undone by fdiv).
+ */
+static void fdct(float *d) {
+    for (int pass = 0; pass < 2; pass++) {
+        int step = pass ? 8 : 1, next = pass ? 1 : 8;
+        for (int i = 0; i < 8; i++) {
+            float *p = d + i * next;
+            float t0 = p[0] + p[7 * step], t7 = p[0] - p[7 * step];
+            float t1 = p[step] + p[6 * step], t6 = p[step] - p[6 * step];
+            float t2 = p[2 * step] + p[5 * step], t5 = p[2 * step] - p[5 * step];
+            float t3 = p[3 * step] + p[4 * step], t4 = p[3 * step] - p[4 * step];
+
+            float t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2;
+            p[0] = t10 + t11;
+            p[4 * step] = t10 - t11;
+            float z1 = (t12 + t13) * 0.707106781f;
+            p[2 * step] = t13 + z1;
+            p[6 * step] = t13 - z1;
+
+            t10 = t4 + t5;
+            t11 = t5 + t6;
+            t12 = t6 + t7;
+            float z5 = (t10 - t12) * 0.382683433f;
+            float z2 = 0.541196100f * t10 + z5;
+            float z4 = 1.306562965f * t12 + z5;
+            float z3 = t11 * 0.707106781f;
+            float z11 = t7 + z3, z13 = t7 - z3;
+            p[5 * step] = z13 + z2;
+            p[3 * step] = z13 - z2;
+            p[step] = z11 + z4;
+            p[7 * step] = z11 - z4;
+        }
+    }
+}
+
+static int bit_size(int v) {
+    int n = 0;
+    for (unsigned a = (unsigned)(v < 0 ? -v : v); a; a >>= 1) {
+        n++;
+    }
+    return n;
+}
+
+static void put_value(bits_t *b, int v, int size) {
+    put_bits(b, (uint32_t)(v < 0 ? v - 1 : v), size);
+}
+
+static void encode_block(bits_t *b, const rtv_jpeg_t *j, int t, float *blk, int *pred) {
+    int q[64], run = 0;
+
+    fdct(blk);
+    for (int k = 0; k < 64; k++) {
+        float v = blk[zigzag[k]] * j->fdiv[t][zigzag[k]];
+        q[k] = (int)(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+
+    int diff = q[0] - *pred, size = bit_size(diff);
+    *pred = q[0];
+    put_bits(b, j->dc[t][size].code, j->dc[t][size].len);
+    if (size) {
+        put_value(b, diff, size);
+    }
+
+    for (int k = 1; k < 64; k++) {
+        if (q[k] == 0) {
+            run++;
+            continue;
+        }
+        for (; run > 15; run -= 16) {
+            put_bits(b, j->ac[t][0xF0].code, j->ac[t][0xF0].len);     // ZRL
+        }
+        size = bit_size(q[k]);
+        uint8_t sym = (uint8_t)(run << 4 | size);
+        put_bits(b, j->ac[t][sym].code, j->ac[t][sym].len);
+        put_value(b, q[k], size);
+        run = 0;
+    }
+    if (run) {
+        put_bits(b, j->ac[t][0x00].code, j->ac[t][0x00].len);         // EOB
+    }
+}
+
+// === Pixels ===
+
+static inline int clampi(int v, int hi) {
+    return v < 0 ? 0 : v > hi ? hi : v;
+}
+
+static void rgb565_ycc(const uint8_t *s, int *y, int *cb, int *cr) {
+    uint16_t px = (uint16_t)(s[0] | s[1] << 8);
+    int r = (px >> 11) << 3, g = ((px >> 5) & 0x3F) << 2, bl = (px & 0x1F) << 3;
+    *y = (77 * r + 150 * g + 29 * bl) >> 8;
+    *cb = ((-43 * r - 85 * g + 128 * bl) >> 8) + 128;
+    *cr = ((128 * r - 107 * g - 21 * bl) >> 8) + 128;
+}
+
+/**
+ * @brief Load the 16x8 MCU at (x0, y0) as two Y blocks and one Cb and one Cr block.
+ */
+static void load_422(const rtv_frame_t *in, int x0, int y0, float y[2][64], float cb[64],
+                     float cr[64]) {
+    int w = in->width, h = in->height, stride = w * 2;
+
+    for (int r = 0; r < 8; r++) {
+        const uint8_t *row = in->data + (size_t)clampi(y0 + r, h - 1) * stride;
+        for (int c = 0; c < 8; c++) {
+            int x = clampi(x0 + 2 * c, w - 2) & ~1;         // Pair start
+            int ya, yb, ua, va;
+            if (in->format == RTV_FMT_YUV422) {
+                const uint8_t *p = row + x * 2;
+                ya = p[0];
+                yb = p[2];
+                ua = p[1];
+                va = p[3];
+            } else {
+                int u2, v2;
+                rgb565_ycc(row + x * 2, &ya, &ua, &va);
+                rgb565_ycc(row + x * 2 + 2, &yb, &u2, &v2);
+                ua = (ua + u2) >> 1;
+                va = (va + v2) >> 1;
+            }
+            float *yd = y[c >> 2] + r * 8 + (c & 3) * 2;
+            yd[0] = (float)(ya - 128);
+            yd[1] = (float)(yb - 128);
+            cb[r * 8 + c] = (float)(ua - 128);
+            cr[r * 8 + c] = (float)(va - 128);
+        }
+    }
+}
+
+static void load_gray(const rtv_frame_t *in, int x0, int y0, float y[64]) {
+    int w = in->width, h = in->height;
+
+    for (int r = 0; r < 8; r++) {
+        const uint8_t *row = in->data + (size_t)clampi(y0 + r, h - 1) * w;
+        for (int c = 0; c < 8; c++) {
+            y[r * 8 + c] = (float)(row[clampi(x0 + c, w - 1)] - 128);
+        }
+    }
+}
+
+// === Headers ===
+
+static void put_headers(bits_t *b, const rtv_jpeg_t *j, int w, int h, bool color) {
+    static const uint8_t jfif[] = { 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 };
+    int nt = color ? 2 : 1;
+
+    put_u16(b, 0xFFD8);                                 // SOI
+    put_u16(b, 0xFFE0);                                 // APP0
+    put_u16(b, 2 + sizeof(jfif));
+    for (size_t i = 0; i < sizeof(jfif); i++) {
+        put_byte(b, jfif[i]);
+    }
+
+    put_u16(b, 0xFFDB);                                 // DQT
+    put_u16(b, (uint16_t)(2 + 65 * nt));
+    for (int t = 0; t < nt; t++) {
+        put_byte(b, (uint8_t)t);
+        for (int k = 0; k < 64; k++) {
+            put_byte(b, j->qt[t][zigzag[k]]);
+        }
+    }
+
+    put_u16(b, 0xFFC0);                                 // SOF0
+    put_u16(b, (uint16_t)(8 + 3 * (color ? 3 : 1)));
+    put_byte(b, 8);
+    put_u16(b, (uint16_t)h);
+    put_u16(b, (uint16_t)w);
+    put_byte(b, color ? 3 : 1);
+    put_byte(b, 1);
+    put_byte(b, color ? 0x21 : 0x11);                   // Y: 2x1 for 4:2:2
+    put_byte(b, 0);
+    if (color) {
+        for (uint8_t id = 2; id <= 3; id++) {
+            put_byte(b, id);
+            put_byte(b, 0x11);
+            put_byte(b, 1);
+        }
+    }
+
+    put_u16(b, 0xFFC4);                                 // DHT
+    put_u16(b, (uint16_t)(2 + nt * (17 + 12 + 17 + 162)));
+    for (int t = 0; t < nt; t++) {
+        put_byte(b, (uint8_t)t);                        // DC
+        for (int i = 0; i < 16; i++) {
+            put_byte(b, dc_bits[t][i]);
+        }
+        for (int i = 0; i < 12; i++) {
+            put_byte(b, dc_vals[i]);
+        }
+        put_byte(b, (uint8_t)(0x10 | t));               // AC
+        for (int i = 0; i < 16; i++) {
+            put_byte(b, ac_bits[t][i]);
+        }
+        for (int i = 0; i < 162; i++) {
+            put_byte(b, ac_vals[t][i]);
+        }
+    }
+
+    put_u16(b, 0xFFDA);                                 // SOS
+    put_u16(b, (uint16_t)(6 + 2 * (color ? 3 : 1)));
+    put_byte(b, color ? 3 : 1);
+    put_byte(b, 1);
+    put_byte(b, 0x00);
+    if (color) {
+        put_byte(b, 2);
+        put_byte(b, 0x11);
+        put_byte(b, 3);
+        put_byte(b, 0x11);
+    }
+    put_byte(b, 0);
+    put_byte(b, 63);
+    put_byte(b, 0);
+}
+
+// === Encoder ===
+
+size_t rtv_jpeg_encode(rtv_jpeg_t *j, const rtv_frame_t *in, uint8_t *out, size_t cap) {
+    bits_t b = { .p = out, .end = out + cap };
+    bool color = in->format == RTV_FMT_YUV422 || in->format == RTV_FMT_RGB565;
+    int w = in->width, h = in->height;
+    int pred[3] = { 0 };
+
+    if ((!color && in->format != RTV_FMT_GRAY8) || w < 2 || h < 1 ||
+        in->len < rtv_frame_size(in->format, in->width, in->height)) {
+        return 0;
+    }
+    put_headers(&b, j, w, h, color);
+
+    for (int y0 = 0; y0 < h && !b.full; y0 += 8) {
+        if (color) {
+            for (int x0 = 0; x0 < w; x0 += 16) {
+                float y[2][64], cb[64], cr[64];
+                load_422(in, x0, y0, y, cb, cr);
+                encode_block(&b, j, 0, y[0], &pred[0]);
+                encode_block(&b, j, 0, y[1], &pred[0]);
+                encode_block(&b, j, 1, cb, &pred[1]);
+                encode_block(&b, j, 1, cr, &pred[2]);
+            }
+        } else {
+            for (int x0 = 0; x0 < w; x0 += 8) {
+                float y[64];
+                load_gray(in, x0, y0, y);
+                encode_block(&b, j, 0, y, &pred[0]);
+            }
+        }
+    }
+    if (b.n) {
+        put_bits(&b, 0x7F, 8 - b.n);                    // Pad with 1s
+    }
+    put_u16(&b, 0xFFD9);                                // EOI
+
+    if (b.full) {
+        j->overflows++;
+        return 0;
+    }
+    j->frames++;
+    j->bytes += (size_t)(b.p - out);
+    return (size_t)(b.p - out);
+}
+
+// === Stage ===
+
+static rtv_stage_result_t jpeg_run(void *ctx, rtv_frame_t *in, rtv_frame_t *out) {
+    rtv_jpeg_t *j = ctx;
+
+    if (in->format == RTV_FMT_JPEG) {
+        return RTV_STAGE_KEEP;          // The source encodes already
+    }
+    if (!out) {
+        return RTV_STAGE_DROP;          // Viewers only take JPEG
+    }
+    size_t n = rtv_jpeg_encode(j, in, out->data, out->cap);
+    if (!n) {
+        return RTV_STAGE_DROP;
+    }
+    out->len = n;
+    out->width = in->width;
+    out->height = in->height;
+    out->format = RTV_FMT_JPEG;
+    return RTV_STAGE_NEW;
+}
+
+void rtv_jpeg_stage(rtv_jpeg_t *j, rtv_stage_t *stage) {
+    stage->name = "jpeg";
+    stage->ctx = j;
+    stage->needs_out = true;
+    stage->run = jpeg_run;
+}
@@ -0,0 +1,78 @@
+// File: main/rtv_jpeg.h
+// ==========================================================================================
+// Baseline JPEG encoder for RTV frames, as a pipeline stage: it reads a raw frame and
+// writes the JPEG into a second pool buffer, so every viewer sends the same encoded
+// frame and nothing is encoded twice. GRAY8 becomes a one-component JPEG; YUV422 and
+// RGB565 become YCbCr 4:2:2 (YUV422 maps onto it without resampling). Standard tables
+// (ITU T.81 Annex K) scaled by quality, float AAN DCT (the S3 has an FPU).
+// A camera that delivers JPEG itself would simply skip the stage.
+// Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef RTV_JPEG_H
+#define RTV_JPEG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rtv_pool.h"
+#include "rtv_pipe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_JPEG_HEADER_MAX     640     // Markers and tables before the scan
+
+/**
+ * @brief Huffman code of one symbol.
+ */
+typedef struct {
+    uint16_t code;
+    uint8_t  len;
+} rtv_jpeg_code_t;
+
+/**
+ * @brief Encoder tables (build once, re-scale on a quality change).
+ */
+typedef struct {
+    uint8_t         quality;        ///< 1 (smallest) .. 100 (best)
+    uint8_t         qt[2][64];      ///< Luma, chroma; natural order
+    float           fdiv[2][64];    ///< 1 / (qt * AAN scale * 8)
+    rtv_jpeg_code_t dc[2][12];
+    rtv_jpeg_code_t ac[2][256];
+    uint32_t        frames;         ///< Frames encoded
+    uint32_t        overflows;      ///< Frames that did not fit the output buffer
+    uint64_t        bytes;          ///< JPEG bytes written
+} rtv_jpeg_t;
+
+/**
+ * @brief Map rtv.jpeg_quality (camera scale: 4 best .. 63 smallest) to 1..100.
+ */
+uint8_t rtv_jpeg_quality_from_camera(uint8_t camera_quality);
+
+void rtv_jpeg_init(rtv_jpeg_t *j, uint8_t quality);
+
+/**
+ * @brief Re-scale the quantization tables (takes effect with the next frame).
+ */
+void rtv_jpeg_set_quality(rtv_jpeg_t *j, uint8_t quality);
+
+/**
+ * @brief Encode a raw frame into out (cap bytes).
+ *
+ * @return JPEG size, 0 if the format is not raw or it did not fit.
+ */
+size_t rtv_jpeg_encode(rtv_jpeg_t *j, const rtv_frame_t *in, uint8_t *out, size_t cap);
+
+/**
+ * @brief Describe the encoder as a pipeline stage (`stage` keeps a pointer to `j`).
+ *        Without a spare output buffer the frame is dropped.
+ */
+void rtv_jpeg_stage(rtv_jpeg_t *j, rtv_stage_t *stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_JPEG_H
@@ -0,0 +1,305 @@
+// File: main/rtv_motion.c
+// ==========================================================================================
+// Motion gate (see rtv_motion.h). The thumbnail is built one thumbnail row at a time:
+// `scale` source rows are summed into 16-bit column sums, then each sum is divided by its
+// box size. Rows are padded with zeros to the 16-byte stride in both thumbnails, so the
+// padding never counts as a difference and the kernels always see whole vectors.
+// ==========================================================================================
+
+#include <string.h>
+#include "rtv_motion.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// === Kernels ===
+
+uint32_t rtv_motion_sad_scalar(const uint8_t *a, const uint8_t *b, size_t stride, unsigned rows) {
+    uint32_t sum = 0;
+
+    for (unsigned r = 0; r < rows; r++, a += stride, b += stride) {
+        for (unsigned i = 0; i < RTV_MOTION_BLOCK_W; i++) {
+            unsigned d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+            sum += d > RTV_MOTION_DIFF_MAX ? RTV_MOTION_DIFF_MAX : d;
+        }
+    }
+    return sum;
+}
+
+#if CONFIG_RTV_MOTION_PIE
+
+/*
+ * PIE (128-bit) version, opt-in through menuconfig until it has been checked on hardware.
+ * The lanes are signed, so both rows are biased by 0x80 first; max - min with a saturating
+ * subtract is then |a - b| capped at 127. The 16 lanes are summed by a multiply-accumulate
+ * with a vector of ones into the 40-bit ACCX register.
+ *
+ * One asm statement for the whole block: q0-q3, q6, q7 and ACCX only hold values inside
+ * it. GCC never allocates the PIE registers (it has no names for them in a clobber list);
+ * FreeRTOS saves them per task, so a preemption mid-block is harmless.
+ */
+static const uint8_t pie_bias[16] __attribute__((aligned(16))) = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+static const uint8_t pie_ones[16] __attribute__((aligned(16))) = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+uint32_t rtv_motion_sad_vector(const uint8_t *a, const uint8_t *b, size_t stride, unsigned rows) {
+    const uint8_t *bias = pie_bias, *ones = pie_ones;
+    uint32_t sum;
+
+    __asm__ volatile(
+        "ee.zero.accx\n"
+        "ee.vld.128.ip q6, %[bias], 0\n"
+        "ee.vld.128.ip q7, %[ones], 0\n"
+        "beqz %[rows], 2f\n"
+        "1:\n"
+        "ee.vld.128.xp q0, %[a], %[stride]\n"
+        "ee.vld.128.xp q1, %[b], %[stride]\n"
+        "ee.xorq q0, q0, q6\n"
+        "ee.xorq q1, q1, q6\n"
+        "ee.vmax.s8 q2, q0, q1\n"
+        "ee.vmin.s8 q3, q0, q1\n"
+        "ee.vsubs.s8 q2, q2, q3\n"
+        "ee.vmulas.u8.accx q2, q7\n"
+        "addi %[rows], %[rows], -1\n"
+        "bnez %[rows], 1b\n"
+        "2:\n"
+        "rur.accx_0 %[sum]\n"
+        : [sum] "=r"(sum), [a] "+r"(a), [b] "+r"(b), [rows] "+r"(rows), [bias] "+r"(bias),
+          [ones] "+r"(ones)
+        : [stride] "r"(stride)
+        : "memory");
+    return sum;
+}
+
+#else
+
+/*
+ * GCC vector extensions (SSE2 / NEON on a host): |a - b| from a lane compare and two
+ * wrapping subtracts, capped at 127 like the PIE kernel, so both match the scalar one bit
+ * for bit. Lanes are widened to 16 bits before the sum.
+ */
+typedef uint8_t  v16u8 __attribute__((vector_size(16)));
+typedef uint16_t v16u16 __attribute__((vector_size(32)));
+
+uint32_t rtv_motion_sad_vector(const uint8_t *a, const uint8_t *b, size_t stride, unsigned rows) {
+    const v16u8 cap = { 127, 127, 127, 127, 127, 127, 127, 127,
+                        127, 127, 127, 127, 127, 127, 127, 127 };
+    v16u16 acc = { 0 };
+    uint32_t sum = 0;
+
+    for (unsigned r = 0; r < rows; r++) {
+        v16u8 x, y;
+        memcpy(&x, a + r * stride, sizeof(x));
+        memcpy(&y, b + r * stride, sizeof(y));
+        v16u8 gt = (v16u8)(x > y);
+        v16u8 d = (gt & (x - y)) | (~gt & (y - x));                 // |a - b|, 0..255
+        v16u8 big = (v16u8)(d > cap);
+        d = (big & cap) | (~big & d);
+        acc += __builtin_convertvector(d, v16u16);
+        if ((r & 255) == 255) {                 // 256 x 127 still fits 16 bits
+            for (int i = 0; i < 16; i++) {
+                sum += acc[i];
+            }
+            acc = (v16u16){ 0 };
+        }
+    }
+    for (int i = 0; i < 16; i++) {
+        sum += acc[i];
+    }
+    return sum;
+}
+
+#endif
+
+// === Thumbnail ===
+
+#define THUMB_SCALE_MAX     16      // 16 x 16 x 255 still fits the 16-bit column sums
+
+static uint8_t thumb_scale(uint16_t width) {
+    uint8_t scale = 1;
+    while ((width + scale - 1) / scale > RTV_MOTION_THUMB_W) {
+        scale *= 2;
+    }
+    return scale;
+}
+
+size_t rtv_motion_thumb_bytes(uint16_t width, uint16_t height) {
+    uint8_t scale = thumb_scale(width);
+    size_t tw = (width + scale - 1) / scale, th = (height + scale - 1) / scale;
+    return ((tw + 15) & ~(size_t)15) * th;
+}
+
+/**
+ * @brief Sum the luma of source row y into the column sums (thumbnail column x / scale).
+ */
+static void add_row(const rtv_frame_t *f, uint16_t y, uint8_t scale, uint16_t *sums) {
+    uint16_t w = f->width;
+
+    switch (f->format) {
+        case RTV_FMT_GRAY8: {
+            const uint8_t *p = f->data + (size_t)y * w;
+            for (uint16_t x0 = 0, tx = 0; x0 < w; x0 += scale, tx++) {
+                uint16_t end = w - x0 < scale ? w : x0 + scale, s = 0;
+                for (uint16_t x = x0; x < end; x++) {
+                    s += p[x];
+                }
+                sums[tx] += s;
+            }
+            break;
+        }
+        case RTV_FMT_YUV422: {
+            const uint8_t *p = f->data + (size_t)y * w * 2;
+            for (uint16_t x0 = 0, tx = 0; x0 < w; x0 += scale, tx++) {
+                uint16_t end = w - x0 < scale ? w : x0 + scale, s = 0;
+                for (uint16_t x = x0; x < end; x++) {
+                    s += p[x * 2];
+                }
+                sums[tx] += s;
+            }
+            break;
+        }
+        default: {                              // RGB565, little endian
+            const uint8_t *p = f->data + (size_t)y * w * 2;
+            for (uint16_t x0 = 0, tx = 0; x0 < w; x0 += scale, tx++) {
+                uint16_t end = w - x0 < scale ? w : x0 + scale, s = 0;
+                for (uint16_t x = x0; x < end; x++) {
+                    uint16_t px = (uint16_t)(p[x * 2] | p[x * 2 + 1] << 8);
+                    unsigned r = (px >> 11) << 3, g = ((px >> 5) & 0x3F) << 2, bl = (px & 0x1F) << 3;
+                    s += (uint16_t)((77 * r + 150 * g + 29 * bl) >> 8);
+                }
+                sums[tx] += s;
+            }
+            break;
+        }
+    }
+}
+
+static bool build_thumb(rtv_motion_t *m, const rtv_frame_t *f) {
+    uint16_t sums[RTV_MOTION_THUMB_W];
+    uint8_t scale = thumb_scale(f->width);
+    uint16_t tw = (uint16_t)((f->width + scale - 1) / scale);
+    uint16_t th = (uint16_t)((f->height + scale - 1) / scale);
+    uint16_t stride = (uint16_t)((tw + 15) & ~15u);
+
+    m->have_cur = false;
+    if (f->format >= RTV_FMT_JPEG || f->width == 0 || f->height == 0 || scale > THUMB_SCALE_MAX ||
+        f->len < rtv_frame_size(f->format, f->width, f->height) || (size_t)stride * th > m->cap) {
+        return false;
+    }
+    if (tw != m->tw || th != m->th || scale != m->scale) {
+        m->have_ref = false;                    // New geometry: nothing to compare with
+        m->tw = tw;
+        m->th = th;
+        m->scale = scale;
+        m->stride = stride;
+    }
+
+    for (uint16_t ty = 0; ty < th; ty++) {
+        uint16_t y0 = (uint16_t)(ty * scale);
+        uint16_t rows = f->height - y0 < scale ? f->height - y0 : scale;
+        uint8_t *out = m->cur + (size_t)ty * stride;
+
+        memset(sums, 0, tw * sizeof(sums[0]));
+        for (uint16_t y = y0; y < y0 + rows; y++) {
+            add_row(f, y, scale, sums);
+        }
+        for (uint16_t tx = 0; tx < tw; tx++) {
+            unsigned cols = f->width - tx * scale < scale ? f->width - tx * scale : scale;
+            out[tx] = (uint8_t)(sums[tx] / (cols * rows));
+        }
+        memset(out + tw, 0, stride - tw);       // Padding: equal in both thumbnails
+    }
+    m->have_cur = true;
+    return true;
+}
+
+// === Gate ===
+
+void rtv_motion_init(rtv_motion_t *m, const rtv_motion_config_t *cfg, uint8_t *buf_a,
+                     uint8_t *buf_b, size_t cap, rtv_motion_sad_fn sad,
+                     uint64_t (*now_us)(void *ctx), void *now_ctx) {
+    memset(m, 0, sizeof(*m));
+    m->cfg = *cfg;
+    if (m->cfg.blocks == 0) {
+        m->cfg.blocks = 1;
+    }
+    m->sad = sad;
+    m->now_us = now_us;
+    m->now_ctx = now_ctx;
+    m->ref = buf_a;
+    m->cur = buf_b;
+    m->cap = cap;
+}
+
+int rtv_motion_changed(rtv_motion_t *m, const rtv_frame_t *f) {
+    int changed = 0;
+
+    if (!build_thumb(m, f) || !m->have_ref) {
+        return -1;
+    }
+    for (uint16_t by = 0; by < m->th; by += RTV_MOTION_BLOCK_H) {
+        unsigned rows = m->th - by < RTV_MOTION_BLOCK_H ? m->th - by : RTV_MOTION_BLOCK_H;
+        for (uint16_t bx = 0; bx < m->tw; bx += RTV_MOTION_BLOCK_W) {
+            unsigned cols = m->tw - bx < RTV_MOTION_BLOCK_W ? m->tw - bx : RTV_MOTION_BLOCK_W;
+            size_t off = (size_t)by * m->stride + bx;
+            uint32_t sad = m->sad(m->cur + off, m->ref + off, m->stride, rows);
+            changed += sad > (uint32_t)m->cfg.threshold * cols * rows;
+        }
+    }
+    return changed;
+}
+
+bool rtv_motion_check(rtv_motion_t *m, const rtv_frame_t *f) {
+    uint64_t now = m->now_us(m->now_ctx);
+    bool pass = true;
+
+    m->stats.frames++;
+    if (m->cfg.threshold) {
+        int changed = rtv_motion_changed(m, f);
+        if (changed >= 0) {
+            m->stats.blocks = ((m->tw + RTV_MOTION_BLOCK_W - 1) / RTV_MOTION_BLOCK_W) *
+                              ((m->th + RTV_MOTION_BLOCK_H - 1) / RTV_MOTION_BLOCK_H);
+            if ((uint32_t)changed > m->stats.changed_max) {
+                m->stats.changed_max = (uint32_t)changed;
+            }
+            pass = changed >= m->cfg.blocks;
+            if (!pass && m->cfg.keepalive_ms && now - m->last_pass_us >= m->cfg.keepalive_ms * 1000ull) {
+                pass = true;
+                m->stats.keepalive++;
+            }
+        }
+    }
+    if (!pass) {
+        m->stats.skipped++;
+        return false;
+    }
+
+    if (m->have_cur) {
+        uint8_t *t = m->ref;                    // This frame is the new reference
+        m->ref = m->cur;
+        m->cur = t;
+        m->have_ref = true;
+        m->have_cur = false;
+    }
+    m->last_pass_us = now;
+    m->stats.passed++;
+    return true;
+}
+
+// === Stage ===
+
+static rtv_stage_result_t motion_run(void *ctx, rtv_frame_t *in, rtv_frame_t *out) {
+    (void)out;
+    return rtv_motion_check(ctx, in) ? RTV_STAGE_KEEP : RTV_STAGE_DROP;
+}
+
+void rtv_motion_stage(rtv_motion_t *m, rtv_stage_t *stage) {
+    stage->name = "motion";
+    stage->ctx = m;
+    stage->needs_out = false;
+    stage->run = motion_run;
+}
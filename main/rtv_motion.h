@@ -0,0 +1,120 @@
+// File: main/rtv_motion.h
+// ==========================================================================================
+// Motion gate: a pipeline stage that drops frames showing no change, so a still scene is
+// neither encoded nor sent. Each raw frame is reduced to a luma thumbnail (box average,
+// at most RTV_MOTION_THUMB_W wide) and compared with the thumbnail of the last frame that
+// went through, in blocks of 16x8 thumbnail pixels. A block has changed when its mean
+// absolute difference exceeds rtv.motion_threshold; a frame goes through when
+// rtv.motion_blocks blocks have, or when nothing has gone through for
+// rtv.motion_keepalive_s (a refresh for viewers that just connected). Comparing with the
+// last frame passed, not the previous one, lets a slow drift add up until it shows.
+//
+// The block difference (sum of per-pixel |a - b|, each capped at 127) has a scalar
+// kernel and a vector one: GCC vector extensions, or ESP32-S3 PIE instructions when
+// CONFIG_RTV_MOTION_PIE is set in menuconfig (off by default). All give the same sums, so the decisions do not depend on the
+// kernel.
+// Pure C; under ESP-IDF sdkconfig.h only selects the kernel.
+// ==========================================================================================
+
+#ifndef RTV_MOTION_H
+#define RTV_MOTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rtv_pool.h"
+#include "rtv_pipe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_MOTION_THUMB_W      128     // Widest thumbnail (the scale doubles until it fits)
+#define RTV_MOTION_BLOCK_W      16      // Block size in thumbnail pixels; one vector per row
+#define RTV_MOTION_BLOCK_H      8
+#define RTV_MOTION_DIFF_MAX     127     // Per-pixel difference cap (signed lanes on the S3)
+
+/**
+ * @brief SAD of a 16-pixel-wide column: rows x 16 bytes, rows `stride` apart.
+ *        The vector kernel needs a, b and stride 16-byte aligned.
+ */
+typedef uint32_t (*rtv_motion_sad_fn)(const uint8_t *a, const uint8_t *b, size_t stride,
+                                      unsigned rows);
+
+uint32_t rtv_motion_sad_scalar(const uint8_t *a, const uint8_t *b, size_t stride, unsigned rows);
+uint32_t rtv_motion_sad_vector(const uint8_t *a, const uint8_t *b, size_t stride, unsigned rows);
+
+/**
+ * @brief Gate settings (the rtv.motion_* keys).
+ */
+typedef struct {
+    uint8_t  threshold;         ///< Mean |diff| per pixel of a changed block; 0 = gate off
+    uint8_t  blocks;            ///< Changed blocks that let a frame through
+    uint32_t keepalive_ms;      ///< Let one through at least this often; 0 = never
+} rtv_motion_config_t;
+
+typedef struct {
+    uint32_t frames;            ///< Frames looked at
+    uint32_t passed;
+    uint32_t skipped;           ///< Dropped: no change
+    uint32_t keepalive;         ///< Passed without a change
+    uint32_t blocks;            ///< Blocks per frame
+    uint32_t changed_max;       ///< Most changed blocks in one frame
+} rtv_motion_stats_t;
+
+typedef struct {
+    rtv_motion_config_t cfg;
+    rtv_motion_sad_fn   sad;
+    uint64_t (*now_us)(void *ctx);
+    void               *now_ctx;
+    uint8_t            *ref;            ///< Thumbnail of the last frame passed
+    uint8_t            *cur;
+    size_t              cap;            ///< Bytes per thumbnail buffer
+    bool                have_ref;
+    bool                have_cur;       ///< cur holds the thumbnail of the frame checked
+    uint8_t             scale;          ///< Source pixels per thumbnail pixel (each axis)
+    uint16_t            tw, th;         ///< Thumbnail size
+    uint16_t            stride;         ///< Thumbnail row bytes (multiple of 16)
+    uint64_t            last_pass_us;
+    rtv_motion_stats_t  stats;
+} rtv_motion_t;
+
+/**
+ * @brief Bytes for one thumbnail buffer of a width x height frame (two are needed).
+ */
+size_t rtv_motion_thumb_bytes(uint16_t width, uint16_t height);
+
+/**
+ * @brief Set up the gate on two 16-byte aligned buffers of `cap` bytes each.
+ *
+ * @param sad    Kernel (rtv_motion_sad_vector normally; the scalar one for comparison)
+ * @param now_us Clock for the keepalive
+ */
+void rtv_motion_init(rtv_motion_t *m, const rtv_motion_config_t *cfg, uint8_t *buf_a,
+                     uint8_t *buf_b, size_t cap, rtv_motion_sad_fn sad,
+                     uint64_t (*now_us)(void *ctx), void *now_ctx);
+
+/**
+ * @brief Count the changed blocks of a raw frame against the reference. Builds the
+ *        thumbnail into the current buffer; the reference is left alone.
+ *
+ * @return Changed blocks; -1 if the frame cannot be compared (JPEG, thumbnail too
+ *         large, or no reference yet: the thumbnail is built, though).
+ */
+int rtv_motion_changed(rtv_motion_t *m, const rtv_frame_t *f);
+
+/**
+ * @brief Decide on a raw frame: true to pass it (its thumbnail becomes the reference).
+ */
+bool rtv_motion_check(rtv_motion_t *m, const rtv_frame_t *f);
+
+/**
+ * @brief Describe the gate as an in-place pipeline stage (KEEP or DROP).
+ */
+void rtv_motion_stage(rtv_motion_t *m, rtv_stage_t *stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_MOTION_H
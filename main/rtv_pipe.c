@@ -0,0 +1,146 @@
+// File: main/rtv_pipe.c
+// ==========================================================================================
+// Capture pipeline and the synthetic source (see rtv_pipe.h). Every buffer a step takes
+// from the pool is either published or given back before it returns, so a step can
+// never leak a buffer, whatever the stages decide.
+// ==========================================================================================
+
+#include <string.h>
+#include "rtv_pipe.h"
+
+// === Pipeline ===
+
+static uint64_t now_us(const rtv_pipe_t *pp) {
+    return pp->pool->ops->now_us(pp->pool->ops->ctx);
+}
+
+void rtv_pipe_init(rtv_pipe_t *pp, rtv_pool_t *pool, const rtv_source_t *src) {
+    memset(pp, 0, sizeof(*pp));
+    pp->pool = pool;
+    pp->src = src;
+}
+
+bool rtv_pipe_add_stage(rtv_pipe_t *pp, const rtv_stage_t *stage) {
+    if (pp->n_stages >= RTV_STAGES_MAX) {
+        return false;
+    }
+    pp->stages[pp->n_stages++] = stage;
+    return true;
+}
+
+bool rtv_pipe_step(rtv_pipe_t *pp) {
+    rtv_frame_t *f = rtv_pool_get_free(pp->pool);
+    if (!f) {
+        pp->stats.no_frame++;           // Every buffer busy: skip, never wait
+        return false;
+    }
+
+    uint64_t t0 = now_us(pp);
+    if (!pp->src->capture(pp->src->ctx, f)) {
+        rtv_pool_discard(pp->pool, f);
+        pp->stats.no_frame++;
+        return false;
+    }
+    uint64_t t_capture = now_us(pp);
+    pp->stats.capture_us += t_capture - t0;
+    pp->stats.captured++;
+
+    for (uint8_t i = 0; i < pp->n_stages; i++) {
+        const rtv_stage_t *st = pp->stages[i];
+        rtv_frame_t *out = st->needs_out ? rtv_pool_get_free(pp->pool) : NULL;
+        uint64_t ts = now_us(pp);
+        rtv_stage_result_t r = st->run(st->ctx, f, out);
+        pp->stats.stage_us[i] += now_us(pp) - ts;
+
+        if (r == RTV_STAGE_NEW && out) {
+            rtv_pool_discard(pp->pool, f);
+            f = out;
+        } else if (out) {
+            rtv_pool_discard(pp->pool, out);
+        }
+        if (r == RTV_STAGE_DROP) {
+            rtv_pool_discard(pp->pool, f);
+            pp->stats.dropped++;
+            return false;
+        }
+    }
+
+    rtv_pool_publish(pp->pool, f, t_capture);
+    pp->stats.published++;
+    return true;
+}
+
+// === Synthetic source ===
+
+#define SYNTH_LO        16      // Video-range black
+#define SYNTH_HI        235     // Video-range white
+#define SYNTH_STRIP     8       // Rows of the frame counter strip
+#define SYNTH_BITS      16      // Counter bits shown
+
+static uint16_t to_rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static bool synth_capture(void *ctx, rtv_frame_t *f) {
+    rtv_synth_t *s = ctx;
+    size_t size = rtv_frame_size(s->format, s->width, s->height);
+    uint16_t w = s->width, h = s->height;
+    uint16_t bar_w = w / 16 ? w / 16 : 1;
+    uint16_t bar_x = (uint16_t)((s->frames * s->motion) % w);
+    uint16_t bit_w = w / SYNTH_BITS ? w / SYNTH_BITS : 1;
+    uint8_t *d = f->data;
+
+    if (size == 0 || size > f->cap) {
+        return false;
+    }
+    for (uint16_t y = 0; y < h; y++) {
+        for (uint16_t x = 0; x < w; x++) {
+            bool bar = (uint16_t)(x - bar_x) < bar_w;       // Wraps at the right edge
+            uint8_t l;
+            if (y < SYNTH_STRIP) {
+                unsigned bit = x / bit_w;
+                l = bit < SYNTH_BITS && ((s->frames >> (SYNTH_BITS - 1 - bit)) & 1) ? SYNTH_HI : SYNTH_LO;
+            } else if (bar) {
+                l = SYNTH_HI;
+            } else {
+                l = (uint8_t)(SYNTH_LO + (uint32_t)(x + y) * (SYNTH_HI - SYNTH_LO) / (w + h));
+            }
+
+            switch (s->format) {
+                case RTV_FMT_GRAY8:
+                    *d++ = l;
+                    break;
+                case RTV_FMT_RGB565: {
+                    uint16_t px = bar && y >= SYNTH_STRIP ? to_rgb565(SYNTH_HI, SYNTH_LO, SYNTH_LO)
+                                                          : to_rgb565(l, l, l);
+                    *d++ = (uint8_t)px;
+                    *d++ = (uint8_t)(px >> 8);
+                    break;
+                }
+                default:                                    // YUV422: Y0 U Y1 V
+                    *d++ = l;
+                    *d++ = (x & 1) ? (bar && y >= SYNTH_STRIP ? 240 : 128)    // V
+                                   : (bar && y >= SYNTH_STRIP ? 90 : 128);    // U
+                    break;
+            }
+        }
+    }
+    f->len = size;
+    f->width = w;
+    f->height = h;
+    f->format = s->format;
+    s->frames++;
+    return true;
+}
+
+void rtv_synth_init(rtv_synth_t *s, rtv_source_t *src, uint16_t width, uint16_t height,
+                    rtv_format_t format, uint8_t motion) {
+    memset(s, 0, sizeof(*s));
+    s->width = width & ~1u;         // Even: YUV422 pairs
+    s->height = height;
+    s->format = format;
+    s->motion = motion;
+    src->name = "synthetic";
+    src->ctx = s;
+    src->capture = synth_capture;
+}
@@ -0,0 +1,120 @@
+// File: main/rtv_pipe.h
+// ==========================================================================================
+// RTV capture pipeline: one step takes a free buffer from the pool, lets the source fill
+// it, runs the processing stages on it and publishes the result as the latest frame:
+//
+//   source --capture--> [stage]* --publish--> pool --acquire--> senders
+//
+// A stage works in place (KEEP), writes into a second buffer from the pool (NEW, e.g. an
+// encoder or a downscaler; the input goes back at once) or rejects the frame (DROP, e.g.
+// nothing changed). Nothing is allocated or copied per frame beyond what a stage writes.
+// The source is pluggable; rtv_synth_* is a test pattern that stands in for the camera on
+// the device and feeds the host tests and benchmarks.
+// Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef RTV_PIPE_H
+#define RTV_PIPE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rtv_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_STAGES_MAX      4
+
+/**
+ * @brief Where frames come from.
+ */
+typedef struct {
+    const char  *name;
+    void        *ctx;
+    /** Fill f->data (up to f->cap) and set len, width, height, format. false: no frame. */
+    bool (*capture)(void *ctx, rtv_frame_t *f);
+} rtv_source_t;
+
+/**
+ * @brief What a stage did with the frame.
+ */
+typedef enum {
+    RTV_STAGE_KEEP = 0,         /**< Continue with `in` (changed in place or not at all) */
+    RTV_STAGE_NEW,              /**< Continue with `out`; `in` goes back to the pool */
+    RTV_STAGE_DROP,             /**< Do not publish this frame */
+} rtv_stage_result_t;
+
+/**
+ * @brief One processing step between capture and publish.
+ */
+typedef struct {
+    const char *name;
+    void       *ctx;
+    /** Ask the pool for an `out` buffer before run (NULL is passed if none is free). */
+    bool        needs_out;
+    rtv_stage_result_t (*run)(void *ctx, rtv_frame_t *in, rtv_frame_t *out);
+} rtv_stage_t;
+
+/**
+ * @brief Pipeline counters.
+ */
+typedef struct {
+    uint32_t captured;          ///< Frames the source delivered
+    uint32_t no_frame;          ///< Steps without a frame (source failed, or no buffer)
+    uint32_t dropped;           ///< Frames a stage rejected
+    uint32_t published;
+    uint64_t capture_us;        ///< Time in the source, summed
+    uint64_t stage_us[RTV_STAGES_MAX];  ///< Time per stage, summed
+} rtv_pipe_stats_t;
+
+/**
+ * @brief Pipeline state (caller-allocated).
+ */
+typedef struct {
+    rtv_pool_t         *pool;
+    const rtv_source_t *src;
+    const rtv_stage_t  *stages[RTV_STAGES_MAX];
+    uint8_t             n_stages;
+    rtv_pipe_stats_t    stats;
+} rtv_pipe_t;
+
+void rtv_pipe_init(rtv_pipe_t *pp, rtv_pool_t *pool, const rtv_source_t *src);
+
+/**
+ * @brief Append a stage (run in the order added). false when RTV_STAGES_MAX are set.
+ */
+bool rtv_pipe_add_stage(rtv_pipe_t *pp, const rtv_stage_t *stage);
+
+/**
+ * @brief Capture, process and publish one frame.
+ *
+ * @return true if a frame was published.
+ */
+bool rtv_pipe_step(rtv_pipe_t *pp);
+
+// === Synthetic source ===
+
+/**
+ * @brief Test pattern: a diagonal gradient with a bright vertical bar that moves
+ *        `motion` pixels per frame (0: a still scene) and a frame counter strip.
+ */
+typedef struct {
+    uint16_t     width;
+    uint16_t     height;
+    rtv_format_t format;        ///< GRAY8, RGB565 or YUV422
+    uint8_t      motion;
+    uint32_t     frames;
+} rtv_synth_t;
+
+/**
+ * @brief Set up the pattern and describe it as a source (`src` keeps a pointer to `s`).
+ */
+void rtv_synth_init(rtv_synth_t *s, rtv_source_t *src, uint16_t width, uint16_t height,
+                    rtv_format_t format, uint8_t motion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_PIPE_H
@@ -0,0 +1,164 @@
+// File: main/rtv_pool.c
+// ==========================================================================================
+// Frame pool (see rtv_pool.h). A buffer is free when it is not being filled, not the
+// latest frame and not referenced; that is checked under ops.lock, which only ever
+// covers a few counters, never a copy or a wait.
+// ==========================================================================================
+
+#include <string.h>
+#include "rtv_pool.h"
+
+// === Helpers ===
+
+static void lock(rtv_pool_t *p) {
+    p->ops->lock(p->ops->ctx);
+}
+
+static void unlock(rtv_pool_t *p) {
+    p->ops->unlock(p->ops->ctx);
+}
+
+static bool is_free(const rtv_pool_t *p, uint8_t i) {
+    return !p->filling[i] && p->latest != (int8_t)i && p->refs[i] == 0;
+}
+
+static uint8_t busy(const rtv_pool_t *p) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < p->count; i++) {
+        n += !is_free(p, i);
+    }
+    return n;
+}
+
+// === Formats ===
+
+const char *rtv_format_str(rtv_format_t f) {
+    static const char *const names[] = { "gray", "rgb565", "yuv422", "jpeg" };
+    return (unsigned)f < sizeof(names) / sizeof(names[0]) ? names[f] : "?";
+}
+
+size_t rtv_frame_size(rtv_format_t f, uint16_t width, uint16_t height) {
+    size_t px = (size_t)width * height;
+    switch (f) {
+        case RTV_FMT_GRAY8:  return px;
+        case RTV_FMT_RGB565:
+        case RTV_FMT_YUV422: return px * 2;
+        default:             return 0;
+    }
+}
+
+// === Pool ===
+
+bool rtv_pool_init(rtv_pool_t *p, const rtv_pool_ops_t *ops, uint8_t *const *bufs,
+                   uint8_t count, size_t cap) {
+    if (count == 0 || count > RTV_POOL_MAX) {
+        return false;
+    }
+    memset(p, 0, sizeof(*p));
+    p->ops = ops;
+    p->count = count;
+    p->latest = -1;
+    for (uint8_t i = 0; i < count; i++) {
+        p->frames[i].data = bufs[i];
+        p->frames[i].cap = cap;
+        p->frames[i].index = i;
+    }
+    return true;
+}
+
+rtv_frame_t *rtv_pool_get_free(rtv_pool_t *p) {
+    rtv_frame_t *f = NULL;
+
+    lock(p);
+    for (uint8_t i = 0; i < p->count && !f; i++) {
+        if (is_free(p, i)) {
+            p->filling[i] = true;
+            f = &p->frames[i];
+            f->len = 0;
+        }
+    }
+    if (!f) {
+        p->stats.starved++;
+    } else {
+        uint8_t n = busy(p);
+        if (n > p->stats.busy_max) {
+            p->stats.busy_max = n;
+        }
+    }
+    unlock(p);
+    return f;
+}
+
+void rtv_pool_publish(rtv_pool_t *p, rtv_frame_t *f, uint64_t t_capture_us) {
+    lock(p);
+    if (p->latest >= 0 && p->reads[p->latest] == 0) {
+        p->stats.stale++;           // Nobody wanted it before the next one was ready
+    }
+    f->seq = ++p->seq;
+    f->t_capture_us = t_capture_us;
+    p->filling[f->index] = false;
+    p->reads[f->index] = 0;
+    p->latest = (int8_t)f->index;   // The previous one is free now unless referenced
+    p->stats.published++;
+    unlock(p);
+    if (p->ops->published) {
+        p->ops->published(p->ops->ctx, f);
+    }
+}
+
+void rtv_pool_discard(rtv_pool_t *p, rtv_frame_t *f) {
+    lock(p);
+    p->filling[f->index] = false;
+    p->stats.discarded++;
+    unlock(p);
+}
+
+rtv_frame_t *rtv_pool_acquire(rtv_pool_t *p, uint32_t after_seq) {
+    rtv_frame_t *f = NULL;
+
+    lock(p);
+    if (p->latest >= 0 && (int32_t)(p->frames[p->latest].seq - after_seq) > 0) {
+        f = &p->frames[p->latest];
+        p->refs[f->index]++;
+        p->reads[f->index]++;
+        p->stats.delivered++;
+    }
+    unlock(p);
+    return f;
+}
+
+void rtv_pool_release(rtv_pool_t *p, rtv_frame_t *f) {
+    uint64_t now = p->ops->now_us(p->ops->ctx);
+    uint32_t age = now > f->t_capture_us ? (uint32_t)(now - f->t_capture_us) : 0;
+
+    lock(p);
+    if (p->refs[f->index]) {
+        p->refs[f->index]--;
+    }
+    p->stats.age_count++;
+    p->stats.age_total_us += age;
+    if (age > p->stats.age_max_us) {
+        p->stats.age_max_us = age;
+    }
+    unlock(p);
+}
+
+uint8_t rtv_pool_held(rtv_pool_t *p) {
+    uint8_t n = 0;
+
+    lock(p);
+    for (uint8_t i = 0; i < p->count; i++) {
+        n += p->refs[i] != 0;
+    }
+    unlock(p);
+    return n;
+}
+
+void rtv_pool_get_stats(rtv_pool_t *p, rtv_pool_stats_t *out, bool reset) {
+    lock(p);
+    *out = p->stats;
+    if (reset) {
+        memset(&p->stats, 0, sizeof(p->stats));
+    }
+    unlock(p);
+}
@@ -0,0 +1,157 @@
+// File: main/rtv_pool.h
+// ==========================================================================================
+// Frame buffer pool for the Real-Time View. A fixed set of buffers is allocated once per
+// session; frames move by pointer from capture through the processing stages to the
+// senders and are never copied or queued. The pool holds at most one READY frame, the
+// latest: publishing a new one retires the previous one, so a slow viewer always gets
+// the newest picture and never makes latency or memory grow (latest-frame-wins).
+//
+//   producer   get_free() -> fill -> publish()       (or discard())
+//   consumers  acquire(after_seq) -> send -> release()
+//
+// Consumers share a frame by reference count; a buffer goes back to the free list when
+// it is neither the latest frame nor held by anyone. With three buffers (one filling, one
+// latest, one being sent) the producer never waits for the consumers, however many read
+// the same frame (triple buffering). Viewers that hold different frames at the same
+// time need one more buffer each; without it the capture is skipped, not blocked.
+// Pure C, no ESP-IDF includes; locking and time come through rtv_pool_ops_t, so the pool
+// also builds on the host for tests.
+// ==========================================================================================
+
+#ifndef RTV_POOL_H
+#define RTV_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_POOL_MAX        6       // Buffers at most (rtv.buffers)
+
+/**
+ * @brief Pixel formats along the pipeline.
+ */
+typedef enum {
+    RTV_FMT_GRAY8 = 0,          /**< 1 byte per pixel */
+    RTV_FMT_RGB565,             /**< 2 bytes per pixel, little-endian */
+    RTV_FMT_YUV422,             /**< 2 bytes per pixel, Y0 U Y1 V */
+    RTV_FMT_JPEG,               /**< Compressed; len bytes */
+    RTV_FMT_COUNT,
+} rtv_format_t;
+
+/**
+ * @brief One buffer of the pool and the picture in it.
+ */
+typedef struct {
+    uint8_t     *data;
+    size_t       cap;           ///< Buffer size (fixed)
+    size_t       len;           ///< Bytes of picture
+    uint16_t     width;
+    uint16_t     height;
+    rtv_format_t format;
+    uint32_t     seq;           ///< Publish number, from 1
+    uint64_t     t_capture_us;  ///< When the source delivered it (ops.now_us)
+    uint8_t      index;         ///< Slot in the pool
+} rtv_frame_t;
+
+/**
+ * @brief Locking, time and wake-up, supplied by the platform.
+ */
+typedef struct {
+    void *ctx;
+    /** Short critical section around the pool's bookkeeping. */
+    void (*lock)(void *ctx);
+    void (*unlock)(void *ctx);
+    uint64_t (*now_us)(void *ctx);
+    /** A new latest frame is there (wake the consumers); may be NULL. Called unlocked. */
+    void (*published)(void *ctx, const rtv_frame_t *f);
+} rtv_pool_ops_t;
+
+/**
+ * @brief Pool counters.
+ */
+typedef struct {
+    uint32_t published;         ///< Frames made the latest
+    uint32_t delivered;         ///< Frames handed to a consumer (one frame, N viewers: N)
+    uint32_t stale;             ///< Retired before any consumer took them
+    uint32_t starved;           ///< get_free() found every buffer busy (capture skipped)
+    uint32_t discarded;         ///< Buffers the producer gave back unpublished
+    uint32_t age_count;         ///< Releases measured below
+    uint64_t age_total_us;      ///< Capture to release, summed
+    uint32_t age_max_us;
+    uint8_t  busy_max;          ///< Most buffers out of the free list at once
+} rtv_pool_stats_t;
+
+/**
+ * @brief Pool state (caller-allocated; buffers are passed to rtv_pool_init).
+ */
+typedef struct {
+    const rtv_pool_ops_t *ops;
+    rtv_frame_t frames[RTV_POOL_MAX];
+    uint8_t  refs[RTV_POOL_MAX];    ///< Consumers holding the frame
+    uint8_t  reads[RTV_POOL_MAX];   ///< Consumers that took it since it was published
+    bool     filling[RTV_POOL_MAX]; ///< With the producer
+    int8_t   latest;                ///< READY frame, -1 if none
+    uint8_t  count;
+    uint32_t seq;
+    rtv_pool_stats_t stats;
+} rtv_pool_t;
+
+const char *rtv_format_str(rtv_format_t f);
+
+/**
+ * @brief Bytes of a raw picture (0 for JPEG: variable).
+ */
+size_t rtv_frame_size(rtv_format_t f, uint16_t width, uint16_t height);
+
+/**
+ * @brief Set the pool up over `count` caller-allocated buffers of `cap` bytes each.
+ *
+ * @return false if count is not 1..RTV_POOL_MAX.
+ */
+bool rtv_pool_init(rtv_pool_t *p, const rtv_pool_ops_t *ops, uint8_t *const *bufs,
+                   uint8_t count, size_t cap);
+
+/**
+ * @brief Producer: a buffer to fill, or NULL if every one is busy (count it, skip the
+ *        capture). seq and t_capture_us are stamped on publish.
+ */
+rtv_frame_t *rtv_pool_get_free(rtv_pool_t *p);
+
+/**
+ * @brief Producer: make `f` the latest frame. The previous latest returns to the free
+ *        list unless a consumer still holds it.
+ */
+void rtv_pool_publish(rtv_pool_t *p, rtv_frame_t *f, uint64_t t_capture_us);
+
+/**
+ * @brief Producer: give a buffer back without publishing it (frame skipped or failed).
+ */
+void rtv_pool_discard(rtv_pool_t *p, rtv_frame_t *f);
+
+/**
+ * @brief Consumer: take a reference to the latest frame if it is newer than after_seq
+ *        (0: any), else NULL. Must be released.
+ */
+rtv_frame_t *rtv_pool_acquire(rtv_pool_t *p, uint32_t after_seq);
+
+/**
+ * @brief Consumer: drop the reference; records the frame's age (capture to now).
+ */
+void rtv_pool_release(rtv_pool_t *p, rtv_frame_t *f);
+
+/**
+ * @brief Frames consumers hold right now (the buffers must outlive them).
+ */
+uint8_t rtv_pool_held(rtv_pool_t *p);
+
+void rtv_pool_get_stats(rtv_pool_t *p, rtv_pool_stats_t *out, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_POOL_H
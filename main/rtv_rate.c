@@ -0,0 +1,121 @@
+// File: main/rtv_rate.c
+// ==========================================================================================
+// Frame rate / quality controller (see rtv_rate.h). Steps down are immediate and the rate
+// is cut by a quarter (or to what the slowest viewer actually took, when it is far
+// behind); steps up wait for RTV_RATE_CALM quiet windows and are smaller, so the
+// controller settles just below what the link carries instead of oscillating around it.
+// ==========================================================================================
+
+#include "rtv_rate.h"
+
+static const char *const action_names[RTV_RATE_COUNT] = { "HOLD", "DOWN", "UP", "IDLE" };
+
+const char *rtv_rate_action_str(rtv_rate_action_t a) {
+    return (unsigned)a < RTV_RATE_COUNT ? action_names[a] : "?";
+}
+
+void rtv_rate_init(rtv_rate_t *r, const rtv_rate_limits_t *lim) {
+    *r = (rtv_rate_t){ .lim = *lim };
+    if (r->lim.fps_min == 0) {
+        r->lim.fps_min = 1;
+    }
+    if (r->lim.fps_max < r->lim.fps_min) {
+        r->lim.fps_max = r->lim.fps_min;
+    }
+    if (r->lim.q_min == 0) {
+        r->lim.q_min = 1;
+    }
+    if (r->lim.q_max < r->lim.q_min) {
+        r->lim.q_max = r->lim.q_min;
+    }
+    r->fps = r->resume_fps = r->lim.fps_max;
+    r->quality = r->lim.q_max;
+    r->last = RTV_RATE_HOLD;
+}
+
+static rtv_rate_action_t step_down(rtv_rate_t *r, const rtv_rate_sample_t *s, bool severe) {
+    bool changed = false;
+
+    if (r->quality > r->lim.q_min) {
+        int q = r->quality - RTV_RATE_Q_STEP;
+        r->quality = (uint8_t)(q < r->lim.q_min ? r->lim.q_min : q);
+        changed = true;
+    }
+    if ((severe || !changed) && r->fps > r->lim.fps_min) {
+        uint32_t fps = r->fps * 3u / 4;
+        uint32_t took = (uint32_t)((uint64_t)s->sent * 1000000 / s->window_us) + 1;
+        if (severe && took < fps) {
+            fps = took;                         // Far behind: go to what it managed
+        }
+        if (fps >= r->fps) {
+            fps = r->fps - 1u;
+        }
+        r->fps = (uint8_t)(fps < r->lim.fps_min ? r->lim.fps_min : fps);
+        changed = true;
+    }
+    if (changed) {
+        r->downs++;
+    }
+    return changed ? RTV_RATE_DOWN : RTV_RATE_HOLD;
+}
+
+static rtv_rate_action_t step_up(rtv_rate_t *r) {
+    if (r->fps < r->lim.fps_max) {
+        uint32_t fps = r->fps + (r->fps / 4u ? r->fps / 4u : 1u);
+        r->fps = (uint8_t)(fps > r->lim.fps_max ? r->lim.fps_max : fps);
+    } else if (r->quality < r->lim.q_max) {
+        int q = r->quality + RTV_RATE_Q_STEP / 2;
+        r->quality = (uint8_t)(q > r->lim.q_max ? r->lim.q_max : q);
+    } else {
+        return RTV_RATE_HOLD;                   // Already at the best setting
+    }
+    r->ups++;
+    return RTV_RATE_UP;
+}
+
+rtv_rate_action_t rtv_rate_update(rtv_rate_t *r, const rtv_rate_sample_t *s) {
+    rtv_rate_action_t a = RTV_RATE_HOLD;
+    uint32_t seen = s->sent + s->skipped;
+
+    r->windows++;
+    r->dropped = s->dropped;
+    r->load_pm = 0;
+    r->skip_pct = 0;
+
+    if (s->viewers == 0) {
+        if (r->last != RTV_RATE_IDLE) {
+            r->resume_fps = r->fps;
+        }
+        r->fps = r->lim.fps_min;
+        r->calm = 0;
+        r->last = RTV_RATE_IDLE;
+        return RTV_RATE_IDLE;
+    }
+    if (r->last == RTV_RATE_IDLE) {
+        r->fps = r->resume_fps;                 // Window was measured at the idle rate
+        r->last = RTV_RATE_UP;
+        return RTV_RATE_UP;
+    }
+    if (s->window_us == 0) {
+        return RTV_RATE_HOLD;
+    }
+
+    uint64_t load = s->send_us * 1000 / s->window_us;
+    r->load_pm = (uint16_t)(load > 1000 ? 1000 : load);
+    r->skip_pct = (uint8_t)(seen ? s->skipped * 100 / seen : 0);
+
+    if (r->load_pm >= RTV_RATE_LOAD_HIGH || r->skip_pct >= RTV_RATE_SKIP_HIGH || s->dropped) {
+        bool severe = r->load_pm >= RTV_RATE_LOAD_SEVERE && r->skip_pct >= RTV_RATE_SKIP_SEVERE;
+        r->calm = 0;
+        a = step_down(r, s, severe);
+    } else if (r->load_pm < RTV_RATE_LOAD_LOW && s->skipped == 0) {
+        if (++r->calm >= RTV_RATE_CALM) {
+            r->calm = 0;
+            a = step_up(r);
+        }
+    } else {
+        r->calm = 0;                            // In the band: stay
+    }
+    r->last = (uint8_t)a;
+    return a;
+}
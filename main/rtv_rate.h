@@ -0,0 +1,97 @@
+// File: main/rtv_rate.h
+// ==========================================================================================
+// Adaptive RTV frame rate and JPEG quality. Once per window the capture task feeds in what
+// the stream saw: how long the slowest viewer spent sending (send latency against the
+// window), how many frames it missed because the next one was already published (the
+// "queue" of a latest-frame-wins pool), and frames lost before publishing (pool starved,
+// JPEG larger than a buffer). Backpressure lowers quality first, then the frame rate;
+// headroom raises the frame rate first, then quality, one step per calm period. With no
+// viewer the capture drops to the minimum rate and resumes where it was when one connects.
+// Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef RTV_RATE_H
+#define RTV_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_RATE_WINDOW_MS      1000    // Control period
+#define RTV_RATE_LOAD_HIGH      850     // Sending this share of the window (per mille): back off
+#define RTV_RATE_LOAD_LOW       500     // Below this, with nothing missed: headroom
+#define RTV_RATE_LOAD_SEVERE    950     // ... and the frame rate is cut as well
+#define RTV_RATE_SKIP_HIGH      20      // Frames missed by the slowest viewer (%): back off
+#define RTV_RATE_SKIP_SEVERE    50
+#define RTV_RATE_CALM           2       // Windows of headroom per step up
+#define RTV_RATE_Q_STEP         8       // Quality step down (up: half of it)
+
+/**
+ * @brief Bounds (rtv.fps_min..rtv.fps, rtv.jpeg_quality_min..rtv.jpeg_quality).
+ */
+typedef struct {
+    uint8_t fps_min;
+    uint8_t fps_max;
+    uint8_t q_min;              ///< JPEG quality 1..100
+    uint8_t q_max;
+} rtv_rate_limits_t;
+
+/**
+ * @brief What one window looked like.
+ */
+typedef struct {
+    uint32_t window_us;
+    uint32_t published;         ///< Frames published
+    uint32_t dropped;           ///< Frames lost before publishing
+    uint8_t  viewers;
+    uint32_t sent;              ///< Slowest viewer: frames sent
+    uint32_t skipped;           ///< Slowest viewer: frames replaced before it took them
+    uint64_t send_us;           ///< Slowest viewer: time spent sending
+} rtv_rate_sample_t;
+
+typedef enum {
+    RTV_RATE_HOLD,
+    RTV_RATE_DOWN,
+    RTV_RATE_UP,
+    RTV_RATE_IDLE,              ///< No viewer: minimum rate
+    RTV_RATE_COUNT
+} rtv_rate_action_t;
+
+/**
+ * @brief Controller state, also the report (CLI).
+ */
+typedef struct {
+    rtv_rate_limits_t lim;
+    uint8_t  fps;               ///< Current capture rate
+    uint8_t  quality;           ///< Current JPEG quality
+    uint8_t  resume_fps;        ///< Rate to resume at when a viewer connects
+    uint8_t  calm;              ///< Consecutive windows of headroom
+    uint8_t  last;              ///< rtv_rate_action_t of the last window
+    uint16_t load_pm;           ///< Last window: slowest viewer's send time, per mille
+    uint8_t  skip_pct;          ///< Last window: frames it missed, %
+    uint32_t dropped;           ///< Last window
+    uint32_t windows;
+    uint32_t downs;
+    uint32_t ups;
+} rtv_rate_t;
+
+const char *rtv_rate_action_str(rtv_rate_action_t a);
+
+/**
+ * @brief Start at the best setting (fps_max, q_max); bounds are put in order.
+ */
+void rtv_rate_init(rtv_rate_t *r, const rtv_rate_limits_t *lim);
+
+/**
+ * @brief Feed one window; r->fps and r->quality hold the settings for the next one.
+ */
+rtv_rate_action_t rtv_rate_update(rtv_rate_t *r, const rtv_rate_sample_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_RATE_H
@@ -0,0 +1,99 @@
+// File: main/rtv_scale.h
+// ==========================================================================================
+// Downscaler for raw RTV frames: a box average over `factor` x `factor` pixels (integer
+// arithmetic, rounded), either in the frame's own format (gray, RGB565, YUV422 with its
+// chroma averaged over the same boxes) or to gray luma. It works in place: output row r
+// is only written once source rows r * factor .. are summed, and it never reaches past
+// them, so a pipeline stage needs no second buffer. Pixels past the last whole box are
+// cropped (and the width is kept even for YUV422).
+//
+// Uses: the rtv.scale pipeline stage (a smaller stream), rtv_snapshot() for the CLI
+// preview and the SD snapshots taken during OPERATIONAL.
+//
+// Source rows are summed into 16-bit column sums by a kernel; the scalar kernels and
+// the vector ones (GCC vector extensions, 16 bytes at a time; lane by lane on Xtensa, which
+// has no PIE kernel yet) give the same sums, the horizontal step and the rounding are
+// shared.
+// Pure C, no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef RTV_SCALE_H
+#define RTV_SCALE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rtv_pool.h"
+#include "rtv_pipe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_SCALE_MAX       16      // Largest factor: 16 x 16 x 255 fits the 16-bit sums
+
+/**
+ * @brief Column-sum kernels.
+ */
+typedef struct {
+    const char *name;
+    /** acc[i] += row[i] for n bytes (gray and YUV422: every byte is a sample). */
+    void (*add_u8)(uint16_t *acc, const uint8_t *row, size_t n);
+    /** Unpack n RGB565 pixels and add their 5 / 6 / 5 bit channels to r, g, b. */
+    void (*add_565)(uint16_t *r, uint16_t *g, uint16_t *b, const uint8_t *row, size_t n);
+} rtv_scale_kernels_t;
+
+extern const rtv_scale_kernels_t rtv_scale_scalar;
+extern const rtv_scale_kernels_t rtv_scale_vector;
+
+typedef struct {
+    uint32_t frames;            ///< Frames scaled
+    uint32_t unscaled;          ///< Passed on as they were (JPEG, too wide, too small)
+} rtv_scale_stats_t;
+
+typedef struct {
+    const rtv_scale_kernels_t *k;
+    uint16_t          *work;            ///< Column sums
+    size_t             work_len;        ///< Entries in work
+    uint8_t            factor;
+    bool               to_gray;
+    rtv_scale_stats_t  stats;
+} rtv_scale_t;
+
+/**
+ * @brief Bytes of column sums needed for frames up to `width` pixels wide.
+ */
+size_t rtv_scale_work_bytes(rtv_format_t format, uint16_t width);
+
+/**
+ * @brief Output size of a width x height frame (0 x 0 if smaller than one box).
+ */
+void rtv_scale_size(rtv_format_t format, uint16_t width, uint16_t height, uint8_t factor,
+                    uint16_t *out_w, uint16_t *out_h);
+
+/**
+ * @brief Set up a scaler on `work_bytes` bytes of column sums (rtv_scale_work_bytes()).
+ *
+ * @param factor  1 .. RTV_SCALE_MAX (1 with to_gray: a luma copy)
+ * @param k       &rtv_scale_vector normally; &rtv_scale_scalar for comparison
+ */
+void rtv_scale_init(rtv_scale_t *sc, uint8_t factor, bool to_gray, uint16_t *work,
+                    size_t work_bytes, const rtv_scale_kernels_t *k);
+
+/**
+ * @brief Scale a raw frame in place (data, len, width, height and format are updated).
+ *
+ * @return false if the frame was left as it was.
+ */
+bool rtv_scale_frame(rtv_scale_t *sc, rtv_frame_t *f);
+
+/**
+ * @brief Describe the scaler as an in-place pipeline stage (always KEEP).
+ */
+void rtv_scale_stage(rtv_scale_t *sc, rtv_stage_t *stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_SCALE_H
@@ -0,0 +1,217 @@
+// File: main/rtv_snap.c
+// ==========================================================================================
+// Snapshot task (see rtv_snap.h). It sleeps on its notification: with no timeout while
+// stopped, rtv.snapshot_s while running. A notification (start or stop) only restarts
+// the wait, so a snapshot is taken when a whole period passes without one.
+//
+// The card is shared: sd_log's writer task owns the log store (SD_LOG_ROOT) and this task
+// only ever opens its own files under SNAP, one at a time. FATFS serializes calls on the
+// volume, so the two never interleave inside a write; a snapshot only delays the next
+// log block by its own write (tens of KB). The mount's max_files counts this file.
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "rtv_snap.h"
+#include "rtv_handler.h"
+#include "sd_log.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define RTV_SNAP_TASK_STACK     3072    // stdio + FATFS
+#define RTV_SNAP_TASK_PRIO      (tskIDLE_PRIORITY + 1)
+
+static const char *TAG = "SNAP";
+
+static TaskHandle_t task = NULL;
+static atomic_bool running;
+static uint32_t number;                 ///< Next file number this boot
+static bool pruned;                     ///< Old boot directories removed this boot
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static rtv_snap_stats_t stats;
+
+static void count_deleted(void) {
+    taskENTER_CRITICAL(&stats_lock);
+    stats.deleted++;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief Remove the boot directories older than the last RTV_SNAP_BOOTS (this one included).
+ */
+static void prune_boots(uint32_t boot) {
+    char path[64];
+    DIR *snap = opendir(SD_LOG_MOUNT_POINT "/" RTV_SNAP_DIR);
+    struct dirent *de;
+
+    if (!snap) {
+        return;
+    }
+    while ((de = readdir(snap)) != NULL) {
+        char *end;
+        if (de->d_name[0] != 'B') {
+            continue;
+        }
+        unsigned long b = strtoul(de->d_name + 1, &end, 10);
+        if (*end != '\0' || b >= 100000) {
+            continue;                   // Not ours
+        }
+        if ((boot % 100000 - b + 100000) % 100000 < RTV_SNAP_BOOTS) {
+            continue;                   // Recent (the names wrap at 100000 boots)
+        }
+        snprintf(path, sizeof(path), SD_LOG_MOUNT_POINT "/" RTV_SNAP_DIR "/%s", de->d_name);
+        DIR *d = opendir(path);
+        struct dirent *f;
+        while (d && (f = readdir(d)) != NULL) {
+            char file[64];
+            snprintf(file, sizeof(file), "%s/%.12s", path, f->d_name);
+            remove(file);
+        }
+        if (d) {
+            closedir(d);
+        }
+        if (rmdir(path) == 0) {
+            count_deleted();
+        }
+    }
+    closedir(snap);
+}
+
+/**
+ * @brief Write one PGM, making room first. The directories usually exist already.
+ */
+static bool write_pgm(uint32_t boot, const uint8_t *px, uint16_t w, uint16_t h) {
+    char path[48];
+
+    snprintf(path, sizeof(path), SD_LOG_MOUNT_POINT "/" RTV_SNAP_DIR);
+    mkdir(path, 0777);
+    if (!pruned) {
+        prune_boots(boot);
+        pruned = true;
+    }
+    snprintf(path, sizeof(path), SD_LOG_MOUNT_POINT "/" RTV_SNAP_DIR "/B%05u", (unsigned)(boot % 100000));
+    mkdir(path, 0777);
+    if (number >= RTV_SNAP_KEEP) {
+        snprintf(path, sizeof(path), SD_LOG_MOUNT_POINT "/" RTV_SNAP_DIR "/B%05u/%08u.PGM",
+                 (unsigned)(boot % 100000), (unsigned)(number - RTV_SNAP_KEEP));
+        if (remove(path) == 0) {
+            count_deleted();
+        }
+    }
+    snprintf(path, sizeof(path), SD_LOG_MOUNT_POINT "/" RTV_SNAP_DIR "/B%05u/%08u.PGM",
+             (unsigned)(boot % 100000), (unsigned)number);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot create %s", path);
+        return false;
+    }
+    size_t n = (size_t)w * h;
+    bool ok = fprintf(f, "P5\n%u %u\n255\n", (unsigned)w, (unsigned)h) > 0 &&
+              fwrite(px, 1, n, f) == n;
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        ESP_LOGW(TAG, "Write failed: %s", path);
+        remove(path);
+    }
+    return ok;
+}
+
+static void take_one(uint8_t scale) {
+    sd_log_stats_t sd;
+    uint8_t *px;
+    uint16_t w, h;
+
+    sd_log_get_stats(&sd);
+    if (!sd.mounted) {
+        taskENTER_CRITICAL(&stats_lock);
+        stats.no_card++;
+        taskEXIT_CRITICAL(&stats_lock);
+        return;
+    }
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = rtv_snapshot(scale, &px, &w, &h);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Capture failed: %s", esp_err_to_name(err));
+    }
+    bool ok = err == ESP_OK && write_pgm(sd.boot, px, w, h);
+    if (err == ESP_OK) {
+        heap_caps_free(px);
+    }
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+
+    taskENTER_CRITICAL(&stats_lock);
+    if (ok) {
+        stats.taken++;
+        stats.width = w;
+        stats.height = h;
+        stats.last_us = us;
+        stats.bytes += (uint64_t)w * h;
+    } else {
+        stats.failed++;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    if (ok) {
+        number++;
+    }
+}
+
+static void rtv_snap_task(void *arg) {
+    const TickType_t period = pdMS_TO_TICKS(stats.period_s * 1000u);
+
+    for (;;) {
+        bool on = atomic_load(&running);
+        if (ulTaskNotifyTake(pdTRUE, on ? period : portMAX_DELAY) == 0 && on &&
+            atomic_load(&running)) {
+            take_one(stats.scale);
+        }
+    }
+}
+
+// === Public API ===
+
+esp_err_t rtv_snap_init(uint16_t period_s, uint8_t scale) {
+    if (task || period_s == 0) {
+        return ESP_OK;
+    }
+    stats.period_s = period_s;
+    stats.scale = scale ? scale : 1;
+    if (xTaskCreate(rtv_snap_task, "rtv_snap", RTV_SNAP_TASK_STACK, NULL, RTV_SNAP_TASK_PRIO,
+                    &task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create snapshot task");
+        task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Snapshots every %u s in OPERATIONAL, 1/%u size", (unsigned)period_s,
+             (unsigned)stats.scale);
+    return ESP_OK;
+}
+
+void rtv_snap_start(void) {
+    if (task) {
+        atomic_store(&running, true);
+        xTaskNotifyGive(task);
+    }
+}
+
+void rtv_snap_stop(void) {
+    if (task) {
+        atomic_store(&running, false);
+        xTaskNotifyGive(task);
+    }
+}
+
+void rtv_snap_get_stats(rtv_snap_stats_t *out) {
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+    out->running = task && atomic_load(&running);
+}
@@ -0,0 +1,66 @@
+// File: main/rtv_snap.h
+// ==========================================================================================
+// Periodic snapshots to SD while OPERATIONAL. Full frames are too large to keep
+// continuously, so every rtv.snapshot_s a frame is taken from the RTV source, reduced to
+// gray rtv.snapshot_scale times smaller (rtv_snapshot(), a box average) and written as
+// a binary PGM: SD_LOG_MOUNT_POINT/SNAP/B<boot>/<number>.PGM, one directory per boot of
+// the log store. The first one is taken one period after entering OPERATIONAL; nothing
+// is taken in other states (RTV has the camera, transfers have the card).
+// The card space is bounded: a boot keeps its last RTV_SNAP_KEEP files (the oldest is
+// deleted for each new one), and only the last RTV_SNAP_BOOTS boot directories are kept.
+// ==========================================================================================
+
+#ifndef RTV_SNAP_H
+#define RTV_SNAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_SNAP_DIR        "SNAP"      // Under SD_LOG_MOUNT_POINT (8.3 names)
+#define RTV_SNAP_KEEP       288         // Files per boot: a day at the default 300 s
+#define RTV_SNAP_BOOTS      8           // Boot directories kept
+
+/**
+ * @brief Snapshot counters (printed by the rtv CLI command).
+ */
+typedef struct {
+    bool     running;           ///< In OPERATIONAL: taking snapshots
+    uint16_t period_s;          ///< rtv.snapshot_s (0: off)
+    uint8_t  scale;             ///< rtv.snapshot_scale
+    uint32_t taken;             ///< Files written
+    uint32_t failed;            ///< Capture or write failed
+    uint32_t no_card;           ///< Skipped: card not mounted
+    uint32_t deleted;           ///< Old files and boot directories removed
+    uint16_t width;             ///< Last snapshot size
+    uint16_t height;
+    uint32_t last_us;           ///< Capture + scale + write of the last one
+    uint64_t bytes;             ///< Written in total
+} rtv_snap_stats_t;
+
+/**
+ * @brief Start the (idle) snapshot task. period_s 0: no task, snapshots off.
+ */
+esp_err_t rtv_snap_init(uint16_t period_s, uint8_t scale);
+
+/**
+ * @brief OPERATIONAL entry: take one every period_s from now on. Never blocks.
+ */
+void rtv_snap_start(void);
+
+/**
+ * @brief OPERATIONAL exit. A snapshot in progress is finished.
+ */
+void rtv_snap_stop(void);
+
+void rtv_snap_get_stats(rtv_snap_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_SNAP_H
@@ -0,0 +1,271 @@
+// File: main/rtv_stream.c
+// ==========================================================================================
+// MJPEG server (see rtv_stream.h). The /stream handler hands its request to a viewer task
+// (httpd async request) so the server task stays free for the next viewer. The task runs
+// the send loop of rtv_viewer.c over httpd_resp_send_chunk() and keeps each viewer's load
+// for the rate controller under stats_lock.
+// ==========================================================================================
+
+#include <stdatomic.h>
+#include "rtv_stream.h"
+#include "rtv_handler.h"
+#include "rtv_viewer.h"
+#include "wifi_sta.h"
+#include "esp_http_server.h"
+#include "esp_netif.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define RTV_STREAM_WIFI_MS      15000
+#define RTV_VIEWER_STACK        3072
+#define RTV_VIEWER_PRIO         (tskIDLE_PRIORITY + 1)  // Below capture
+#define RTV_SEND_TIMEOUT_S      2       // A stalled viewer is dropped after this
+#define RTV_CLOSE_WARN_MS       3000
+
+static const char *TAG = "RTV_HTTP";
+
+static const char page[] =
+    "<!DOCTYPE html><html><head><title>RTV</title></head>"
+    "<body style=\"margin:0;background:#000\">"
+    "<img src=\"/stream\" style=\"width:100%;image-rendering:pixelated\">"
+    "</body></html>";
+
+static httpd_handle_t server = NULL;
+static uint8_t max_viewers;
+static atomic_int viewers;
+static atomic_bool closing;             ///< No new viewers once rtv_stream_close() waits
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static rtv_stream_stats_t stats;
+static rtv_viewer_load_t load[RTV_STREAM_VIEWERS_MAX];  // Under stats_lock
+
+// === Viewer ===
+
+/**
+ * @brief The viewer task's side of rtv_viewer_io_t.
+ */
+typedef struct {
+    httpd_req_t *req;
+    int slot;                   ///< In load[], -1 if none
+    esp_err_t err;              ///< Last send
+} viewer_t;
+
+static int viewer_slot(void) {
+    int slot = -1;
+
+    taskENTER_CRITICAL(&stats_lock);
+    for (int i = 0; i < RTV_STREAM_VIEWERS_MAX && slot < 0; i++) {
+        if (!load[i].used) {
+            load[i] = (rtv_viewer_load_t){ .used = true };
+            slot = i;
+        }
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    return slot;
+}
+
+static void viewer_done(int slot, bool error) {
+    taskENTER_CRITICAL(&stats_lock);
+    stats.errors += error;
+    stats.viewers--;
+    if (slot >= 0) {
+        load[slot].used = false;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    atomic_fetch_sub(&viewers, 1);
+}
+
+static bool viewer_session_open(void *ctx) {
+    (void)ctx;
+    return rtv_session_open();
+}
+
+static rtv_frame_t *viewer_acquire(void *ctx, uint32_t after_seq, uint32_t wait_ms) {
+    (void)ctx;
+    return rtv_acquire(after_seq, wait_ms);
+}
+
+static void viewer_release(void *ctx, rtv_frame_t *f) {
+    (void)ctx;
+    rtv_release(f);
+}
+
+static bool viewer_send(void *ctx, const void *data, size_t len) {
+    viewer_t *v = ctx;
+
+    v->err = httpd_resp_send_chunk(v->req, data, (ssize_t)len);
+    return v->err == ESP_OK;
+}
+
+static uint64_t viewer_now(void *ctx) {
+    (void)ctx;
+    return (uint64_t)esp_timer_get_time();
+}
+
+static void viewer_sent(void *ctx, bool ok, size_t bytes, uint32_t skipped, uint64_t send_us) {
+    viewer_t *v = ctx;
+
+    taskENTER_CRITICAL(&stats_lock);
+    if (ok) {
+        stats.frames++;
+        stats.bytes += bytes;
+    }
+    if (v->slot >= 0) {
+        rtv_viewer_load_add(&load[v->slot], skipped, send_us);
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+static void viewer_task(void *arg) {
+    viewer_t v = { .req = arg, .slot = viewer_slot() };     // viewers <= RTV_STREAM_VIEWERS_MAX
+    const rtv_viewer_io_t io = {
+        .ctx = &v, .session_open = viewer_session_open, .acquire = viewer_acquire,
+        .release = viewer_release, .send = viewer_send, .now_us = viewer_now, .sent = viewer_sent,
+    };
+
+    v.err = httpd_resp_set_type(v.req, RTV_VIEWER_CONTENT_TYPE);
+    httpd_resp_set_hdr(v.req, "Cache-Control", "no-store");
+    bool ok = v.err == ESP_OK && rtv_viewer_run(&io);
+    if (!ok) {
+        ESP_LOGI(TAG, "Viewer %d gone (%s)", httpd_req_to_sockfd(v.req), esp_err_to_name(v.err));
+    }
+    httpd_req_async_handler_complete(v.req);
+    viewer_done(v.slot, !ok);
+    vTaskDelete(NULL);
+}
+
+// === Handlers ===
+
+static esp_err_t page_get(httpd_req_t *req) {
+    httpd_resp_set_type(req, "text/html");
+    return httpd_resp_send(req, page, HTTPD_RESP_USE_STRLEN);
+}
+
+static esp_err_t stream_get(httpd_req_t *req) {
+    httpd_req_t *copy = NULL;
+
+    if (atomic_fetch_add(&viewers, 1) >= max_viewers || atomic_load(&closing)) {
+        atomic_fetch_sub(&viewers, 1);
+        taskENTER_CRITICAL(&stats_lock);
+        stats.rejected++;
+        taskEXIT_CRITICAL(&stats_lock);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Viewer limit reached", HTTPD_RESP_USE_STRLEN);
+    }
+    if (httpd_req_async_handler_begin(req, &copy) != ESP_OK) {
+        atomic_fetch_sub(&viewers, 1);
+        return httpd_resp_send_500(req);
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.viewers++;
+    stats.viewers_total++;
+    if (stats.viewers > stats.viewers_max) {
+        stats.viewers_max = stats.viewers;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (xTaskCreate(viewer_task, "rtv_view", RTV_VIEWER_STACK, copy, RTV_VIEWER_PRIO, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "No memory for a viewer task");
+        httpd_resp_send_500(copy);
+        httpd_req_async_handler_complete(copy);
+        viewer_done(-1, true);
+        return ESP_OK;
+    }
+    ESP_LOGI(TAG, "Viewer %d connected (%d)", httpd_req_to_sockfd(req), atomic_load(&viewers));
+    return ESP_OK;
+}
+
+// === Public API ===
+
+esp_err_t rtv_stream_open(uint16_t port, uint8_t limit) {
+    httpd_config_t hc = HTTPD_DEFAULT_CONFIG();
+    esp_netif_ip_info_t ip = { 0 };
+
+    if (server) {
+        return ESP_OK;
+    }
+    esp_err_t err = wifi_sta_connect(RTV_STREAM_WIFI_MS);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Wi-Fi: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    max_viewers = limit < 1 ? 1 : limit > RTV_STREAM_VIEWERS_MAX ? RTV_STREAM_VIEWERS_MAX : limit;
+    atomic_store(&closing, false);
+    hc.server_port = port;
+    hc.ctrl_port = port + 1;
+    hc.max_open_sockets = max_viewers + 2;      // Room for the page and a turned-away viewer
+    hc.lru_purge_enable = true;
+    hc.send_wait_timeout = RTV_SEND_TIMEOUT_S;
+    err = httpd_start(&server, &hc);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP server: %s", esp_err_to_name(err));
+        server = NULL;
+        wifi_sta_disconnect();
+        return err;
+    }
+
+    static const httpd_uri_t uris[] = {
+        { .uri = "/", .method = HTTP_GET, .handler = page_get },
+        { .uri = "/stream", .method = HTTP_GET, .handler = stream_get },
+    };
+    for (size_t i = 0; i < sizeof(uris) / sizeof(uris[0]); i++) {
+        httpd_register_uri_handler(server, &uris[i]);
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.serving = true;
+    taskEXIT_CRITICAL(&stats_lock);
+    esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"), &ip);
+    ESP_LOGI(TAG, "Serving http://" IPSTR ":%u/ (up to %u viewers)", IP2STR(&ip.ip),
+             (unsigned)port, (unsigned)max_viewers);
+    return ESP_OK;
+}
+
+void rtv_stream_close(void) {
+    uint32_t waited = 0;
+
+    if (!server) {
+        return;
+    }
+    atomic_store(&closing, true);
+    while (atomic_load(&viewers) > 0) {         // Woken by the pool closing; sends time out
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited += 10;
+        if (waited == RTV_CLOSE_WARN_MS) {
+            ESP_LOGW(TAG, "%d viewers still sending", atomic_load(&viewers));
+        }
+    }
+    httpd_stop(server);
+    server = NULL;
+    wifi_sta_disconnect();
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.serving = false;
+    taskEXIT_CRITICAL(&stats_lock);
+    ESP_LOGI(TAG, "Stopped: %u frames, %u KB to %u viewers", (unsigned)stats.frames,
+             (unsigned)(stats.bytes >> 10), (unsigned)stats.viewers_total);
+}
+
+void rtv_stream_get_stats(rtv_stream_stats_t *out, bool reset) {
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    if (reset) {
+        stats.viewers_max = stats.viewers;
+        stats.viewers_total = stats.viewers;
+        stats.rejected = 0;
+        stats.frames = 0;
+        stats.bytes = 0;
+        stats.errors = 0;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+void rtv_stream_take_load(rtv_rate_sample_t *s) {
+    taskENTER_CRITICAL(&stats_lock);
+    rtv_viewer_take_load(load, RTV_STREAM_VIEWERS_MAX, s);
+    taskEXIT_CRITICAL(&stats_lock);
+}
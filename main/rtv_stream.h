@@ -0,0 +1,63 @@
+// File: main/rtv_stream.h
+// ==========================================================================================
+// Real-Time View over HTTP: a multipart MJPEG stream (GET /stream) and a page that shows
+// it (GET /). Each viewer gets its own task that takes the latest encoded frame from the
+// RTV pool and sends it straight from the pool buffer, so viewers share one encoded
+// frame and nothing is copied. A slow viewer just skips frames; it never slows the
+// capture or the other viewers, but what it misses and how long its sends take are
+// reported to the rate controller (rtv_rate.h). Opened and closed by the RTV task around
+// each session.
+// ==========================================================================================
+
+#ifndef RTV_STREAM_H
+#define RTV_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "rtv_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_STREAM_VIEWERS_MAX  4       // rtv.max_viewers upper bound
+
+/**
+ * @brief Stream counters (printed by the rtv CLI command).
+ */
+typedef struct {
+    bool     serving;
+    uint8_t  viewers;           ///< Connected now
+    uint8_t  viewers_max;       ///< Most at once
+    uint32_t viewers_total;
+    uint32_t rejected;          ///< Turned away at rtv.max_viewers
+    uint32_t frames;            ///< Frames sent, all viewers
+    uint64_t bytes;             ///< Multipart bytes sent, all viewers
+    uint32_t errors;            ///< Viewers lost on a send error
+} rtv_stream_stats_t;
+
+/**
+ * @brief Join Wi-Fi and start the HTTP server on `port`.
+ */
+esp_err_t rtv_stream_open(uint16_t port, uint8_t max_viewers);
+
+/**
+ * @brief Stop serving. Call once the pool is closed: viewers see the session end, finish
+ *        their response and go; then the server stops and Wi-Fi is released.
+ */
+void rtv_stream_close(void);
+
+void rtv_stream_get_stats(rtv_stream_stats_t *out, bool reset);
+
+/**
+ * @brief Fill the viewer side of a controller sample (viewers, and sent / skipped /
+ *        send_us of the viewer that spent the longest sending) and start a new window.
+ */
+void rtv_stream_take_load(rtv_rate_sample_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_STREAM_H
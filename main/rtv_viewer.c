@@ -0,0 +1,72 @@
+// File: main/rtv_viewer.c
+// ==========================================================================================
+// MJPEG viewer loop (see rtv_viewer.h). The part header is formatted on the caller's
+// stack; the JPEG goes out of the pool buffer the viewer holds a reference to, released
+// as soon as it has been sent.
+// ==========================================================================================
+
+#include <stdio.h>
+#include "rtv_viewer.h"
+
+static const char trailer[] = "\r\n--" RTV_VIEWER_BOUNDARY "--\r\n";
+
+bool rtv_viewer_run(const rtv_viewer_io_t *io) {
+    uint32_t seq = 0;
+    char part[96];
+    bool ok = true;
+
+    while (ok && io->session_open(io->ctx)) {
+        rtv_frame_t *f = io->acquire(io->ctx, seq, RTV_VIEWER_WAIT_MS);
+        if (!f) {
+            continue;
+        }
+        uint32_t skipped = seq ? f->seq - seq - 1 : 0;
+        seq = f->seq;
+        size_t len = f->len;
+        if (f->format != RTV_FMT_JPEG) {
+            io->release(io->ctx, f);
+            continue;
+        }
+        uint64_t t0 = io->now_us(io->ctx);
+        int n = snprintf(part, sizeof(part),
+                         "\r\n--" RTV_VIEWER_BOUNDARY "\r\nContent-Type: image/jpeg\r\n"
+                         "Content-Length: %u\r\n\r\n", (unsigned)len);
+        ok = io->send(io->ctx, part, (size_t)n) && io->send(io->ctx, f->data, len);  // From the pool
+        io->release(io->ctx, f);
+        io->sent(io->ctx, ok, (size_t)n + len, skipped, io->now_us(io->ctx) - t0);
+    }
+
+    if (ok) {
+        ok = io->send(io->ctx, trailer, sizeof(trailer) - 1) && io->send(io->ctx, NULL, 0);
+    }
+    return ok;
+}
+
+void rtv_viewer_load_add(rtv_viewer_load_t *l, uint32_t skipped, uint64_t send_us) {
+    l->sent++;
+    l->skipped += skipped;
+    l->send_us += send_us;
+}
+
+int rtv_viewer_take_load(rtv_viewer_load_t *loads, size_t n, rtv_rate_sample_t *s) {
+    int worst = -1;
+
+    s->viewers = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!loads[i].used) {
+            continue;
+        }
+        s->viewers++;
+        if (worst < 0 || loads[i].send_us > loads[worst].send_us) {
+            worst = (int)i;
+        }
+    }
+    s->sent = worst >= 0 ? loads[worst].sent : 0;
+    s->skipped = worst >= 0 ? loads[worst].skipped : 0;
+    s->send_us = worst >= 0 ? loads[worst].send_us : 0;
+    for (size_t i = 0; i < n; i++) {
+        loads[i].sent = loads[i].skipped = 0;
+        loads[i].send_us = 0;
+    }
+    return worst;
+}
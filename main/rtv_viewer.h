@@ -0,0 +1,82 @@
+// File: main/rtv_viewer.h
+// ==========================================================================================
+// One MJPEG viewer: the send loop behind GET /stream and the per-viewer load it reports
+// to the rate controller. The loop takes the latest frame newer than the last one it
+// sent, writes a multipart part header and the JPEG straight out of the pool buffer,
+// releases the frame and accounts the send time and the frames it missed (replaced
+// before it got to them). Backpressure is the send itself: a slow viewer spends longer
+// per frame, skips more, and never holds up the capture or the other viewers. Pure C,
+// no ESP-IDF includes; the transport, the frame source and the clock come through
+// rtv_viewer_io_t (the HTTP server in rtv_stream.c, local sockets in host_test).
+// ==========================================================================================
+
+#ifndef RTV_VIEWER_H
+#define RTV_VIEWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rtv_pool.h"
+#include "rtv_rate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTV_VIEWER_BOUNDARY     "rtvframe"
+#define RTV_VIEWER_CONTENT_TYPE "multipart/x-mixed-replace;boundary=" RTV_VIEWER_BOUNDARY
+#define RTV_VIEWER_WAIT_MS      500     // Re-check the session this often
+
+/**
+ * @brief One viewer's counters for the current controller window.
+ */
+typedef struct {
+    bool     used;
+    uint32_t sent;
+    uint32_t skipped;
+    uint64_t send_us;
+} rtv_viewer_load_t;
+
+/**
+ * @brief Session, frames, transport and clock of one viewer.
+ */
+typedef struct {
+    void *ctx;
+    /** False ends the stream (session over or server closing). */
+    bool (*session_open)(void *ctx);
+    /** Latest frame newer than after_seq, waiting up to wait_ms; NULL if none. */
+    rtv_frame_t *(*acquire)(void *ctx, uint32_t after_seq, uint32_t wait_ms);
+    void (*release)(void *ctx, rtv_frame_t *f);
+    /** One chunk of the response (NULL, 0: end of response). False: the viewer is gone. */
+    bool (*send)(void *ctx, const void *data, size_t len);
+    uint64_t (*now_us)(void *ctx);
+    /** After each frame: whether it went out, its bytes, frames missed before it, send time. */
+    void (*sent)(void *ctx, bool ok, size_t bytes, uint32_t skipped, uint64_t send_us);
+} rtv_viewer_io_t;
+
+/**
+ * @brief Stream frames until the session closes, then end the multipart response.
+ *
+ * @return false if a send failed (the viewer is gone; the response is left unfinished).
+ */
+bool rtv_viewer_run(const rtv_viewer_io_t *io);
+
+/**
+ * @brief Add one frame to a viewer's window.
+ */
+void rtv_viewer_load_add(rtv_viewer_load_t *l, uint32_t skipped, uint64_t send_us);
+
+/**
+ * @brief Fill the viewer side of a controller sample from `n` slots (viewers, and sent /
+ *        skipped / send_us of the used slot that spent the longest sending) and start a
+ *        new window. The caller holds whatever lock guards the slots.
+ *
+ * @return Index of that slot, -1 if no slot is used.
+ */
+int rtv_viewer_take_load(rtv_viewer_load_t *loads, size_t n, rtv_rate_sample_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTV_VIEWER_H
@@ -0,0 +1,233 @@
+// File: main/sd_log.c
+// ==========================================================================================
+// SD card log writer: ESP_LOGx hook -> log_sink ring -> packer task -> writer task ->
+// log_store segments on FAT. The writer owns the store exclusively; other tasks only open
+// their own files on the volume (log_query, a transfer, rtv_snap), which FATFS serializes
+// per call. Files are unbuffered, so each 4 KB block goes to FATFS as one aligned
+// multi-sector write (no sector-buffer copy). Partial flushes rewrite the current block from its start and are
+// followed by fsync, which also commits the directory entry; full blocks are not synced
+// individually.
+// ==========================================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include "sd_log.h"
+#include "log_sink.h"
+#include "log_store.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"
+#include "sdmmc_cmd.h"
+#include "driver/sdmmc_host.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+// === SDMMC wiring (1-bit mode, routed through the GPIO matrix) ===
+// Clear of the LED GPIOs (2/4/5/6) and the security-level straps (18/19/21).
+#define SD_LOG_PIN_CLK      GPIO_NUM_39
+#define SD_LOG_PIN_CMD      GPIO_NUM_38
+#define SD_LOG_PIN_D0       GPIO_NUM_40
+
+#define SD_LOG_IO_QUEUE     4       // Two full blocks + partial flushes in flight
+#define SD_LOG_PACK_STACK   3072
+#define SD_LOG_PACK_PRIO    (tskIDLE_PRIORITY + 1)
+#define SD_LOG_WRITE_STACK  4096
+#define SD_LOG_WRITE_PRIO   (tskIDLE_PRIORITY + 1)
+
+static const char *TAG = "SD_LOG";
+
+static log_sink_t sink;
+static QueueHandle_t io_queue = NULL;
+static TaskHandle_t pack_task = NULL;
+static TaskHandle_t write_task = NULL;
+static vprintf_like_t prev_vprintf = NULL;
+
+// Writer task only
+static log_store_t store;
+static uint16_t segment_kb;
+static bool compress;
+static sdmmc_card_t *card = NULL;
+
+static struct {
+    uint32_t write_errors;
+    uint32_t write_max_us;
+    uint64_t write_total_us;
+    bool     mounted;
+} io_stats;
+
+// === Producers ===
+
+bool sd_log_line(const char *text, size_t len) {
+    bool ok = log_sink_write(&sink, text, len);
+    TaskHandle_t t = pack_task;
+    if (ok && t) {
+        xTaskNotifyGive(t);
+    }
+    return ok;
+}
+
+/**
+ * @brief esp_log hook: tee every formatted log line into the sink.
+ */
+static int sd_log_vprintf(const char *fmt, va_list args) {
+    char line[LOG_SINK_LINE_MAX + 1];
+    va_list copy;
+
+    va_copy(copy, args);
+    int n = vsnprintf(line, sizeof(line), fmt, copy);
+    va_end(copy);
+    if (n > 0) {
+        sd_log_line(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line));
+    }
+    return prev_vprintf(fmt, args);
+}
+
+// === Packer task ===
+
+static void sd_log_pack_task(void *arg) {
+    log_sink_req_t req;
+    bool dirty = false;
+    TickType_t dirty_since = 0;
+    const TickType_t flush_ticks = pdMS_TO_TICKS(SD_LOG_FLUSH_MS);
+
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (dirty) {
+            TickType_t age = xTaskGetTickCount() - dirty_since;
+            wait = age < flush_ticks ? flush_ticks - age : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        while (log_sink_pack(&sink, &req)) {
+            xQueueSend(io_queue, &req, portMAX_DELAY);
+        }
+
+        // Flush-on-idle: nothing packed may wait longer than SD_LOG_FLUSH_MS
+        if (log_sink_pending(&sink) == 0) {
+            dirty = false;
+        } else if (!dirty) {
+            dirty = true;
+            dirty_since = xTaskGetTickCount();
+        } else if (xTaskGetTickCount() - dirty_since >= flush_ticks) {
+            if (log_sink_flush_partial(&sink, &req)) {
+                xQueueSend(io_queue, &req, portMAX_DELAY);
+            }
+            dirty = false;
+        }
+    }
+}
+
+// === Writer task ===
+
+static esp_err_t sd_log_mount(void) {
+    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
+        .format_if_mount_failed = false,
+        .max_files = 7,     // Catalog + segment each for the store, log_query and a transfer;
+                            // one snapshot
+        .allocation_unit_size = 16 * 1024,
+    };
+    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
+    sdmmc_slot_config_t slot = SDMMC_SLOT_CONFIG_DEFAULT();
+
+    slot.width = 1;
+    slot.clk = SD_LOG_PIN_CLK;
+    slot.cmd = SD_LOG_PIN_CMD;
+    slot.d0 = SD_LOG_PIN_D0;
+    slot.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+
+    return esp_vfs_fat_sdmmc_mount(SD_LOG_MOUNT_POINT, &host, &slot, &mount_config, &card);
+}
+
+static void sd_log_write_task(void *arg) {
+    log_sink_req_t req;
+
+    esp_err_t err = sd_log_mount();
+    if (err == ESP_OK && !log_store_open(&store, SD_LOG_ROOT, segment_kb, compress)) {
+        err = ESP_FAIL;
+    }
+    io_stats.mounted = (err == ESP_OK);
+    if (io_stats.mounted) {
+        ESP_LOGI(TAG, "Logging to %s (%s, %u MB): boot %u, segment %u, %u KB segments%s, %u recovered",
+                 SD_LOG_ROOT, card->cid.name,
+                 (unsigned)((uint64_t)card->csd.capacity * card->csd.sector_size >> 20),
+                 (unsigned)log_store_boot(&store), (unsigned)store.first_seg,
+                 (unsigned)(store.seg_blocks + 1) * 4, compress ? " (LZ)" : "",
+                 (unsigned)store.stats.recovered);
+    } else {
+        ESP_LOGE(TAG, "SD card unavailable (%s): log blocks will be discarded", esp_err_to_name(err));
+    }
+
+    for (;;) {
+        xQueueReceive(io_queue, &req, portMAX_DELAY);
+
+        if (io_stats.mounted) {
+            int64_t t0 = esp_timer_get_time();
+            bool ok = log_store_write(&store, &req);
+            uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+
+            io_stats.write_total_us += us;
+            if (us > io_stats.write_max_us) {
+                io_stats.write_max_us = us;
+            }
+            if (!ok) {
+                io_stats.write_errors++;
+            }
+        } else {
+            io_stats.write_errors++;
+        }
+
+        if (!req.partial) {
+            log_sink_block_done(&sink, req.buf);
+            xTaskNotifyGive(pack_task);     // Packer may be waiting for this buffer
+        }
+    }
+}
+
+// === Public API ===
+
+esp_err_t sd_log_init(uint16_t seg_kb, bool lz) {
+    if (pack_task) {
+        return ESP_OK;
+    }
+    segment_kb = seg_kb;
+    compress = lz;
+
+    log_sink_init(&sink, 0);
+    io_queue = xQueueCreate(SD_LOG_IO_QUEUE, sizeof(log_sink_req_t));
+    if (!io_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(sd_log_pack_task, "log_pack", SD_LOG_PACK_STACK, NULL,
+                    SD_LOG_PACK_PRIO, &pack_task) != pdPASS ||
+        xTaskCreate(sd_log_write_task, "log_write", SD_LOG_WRITE_STACK, NULL,
+                    SD_LOG_WRITE_PRIO, &write_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create SD log tasks");
+        return ESP_ERR_NO_MEM;
+    }
+
+    prev_vprintf = esp_log_set_vprintf(sd_log_vprintf);
+    return ESP_OK;
+}
+
+void sd_log_get_stats(sd_log_stats_t *out) {
+    out->lines = sink.stats.lines;
+    out->bytes = sink.stats.bytes;
+    out->dropped = log_sink_dropped(&sink);
+    out->truncated = atomic_load_explicit(&sink.truncated, memory_order_relaxed);
+    out->blocks = sink.stats.blocks;
+    out->partials = sink.stats.partials;
+    out->stalls = sink.stats.stalls;
+    out->write_errors = io_stats.write_errors;
+    out->write_max_us = io_stats.write_max_us;
+    out->write_total_us = io_stats.write_total_us;
+    out->mounted = io_stats.mounted;
+    out->boot = log_store_boot(&store);
+    out->segment = store.seg_id;
+    out->segments = store.stats.segments;
+    out->deleted = store.stats.deleted;
+    out->recovered = store.stats.recovered;
+    out->raw_bytes = store.stats.raw_bytes;
+    out->stored_bytes = store.stats.stored_bytes;
+}
@@ -0,0 +1,79 @@
+// File: main/sd_log.h
+// ==========================================================================================
+// SD card log writer.
+// ESP_LOGx output (and sd_log_line() callers) is copied into the lock-free log_sink ring;
+// a packer task assembles 4 KB blocks and a writer task puts them on the card, so no
+// caller ever waits for FAT or the card. The card is mounted by the writer task itself,
+// so boot does not wait for it either; lines logged meanwhile are buffered in the ring.
+// Lines are stored as rotating indexed segments under SD_LOG_ROOT (log_store.h), which
+// the log_query CLI command searches by boot, time window and level. Blocks can be
+// LZ-compressed on the way (log_lz.h); every block and segment still decodes alone.
+// ==========================================================================================
+
+#ifndef SD_LOG_H
+#define SD_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SD_LOG_MOUNT_POINT  "/sdcard"
+#define SD_LOG_ROOT         SD_LOG_MOUNT_POINT "/LOGS"          // 8.3 names only (FATFS LFN is off)
+#define SD_LOG_FLUSH_MS     1000    // Longest time a packed line waits before a partial flush
+
+/**
+ * @brief Writer statistics (printed by the sd_log CLI command).
+ */
+typedef struct {
+    uint32_t lines;             ///< Lines packed
+    uint32_t bytes;             ///< Bytes packed
+    uint32_t dropped;           ///< Lines lost (ring full: card too slow or not ready)
+    uint32_t truncated;         ///< Lines cut to LOG_SINK_LINE_MAX
+    uint32_t blocks;            ///< Full 4 KB blocks written
+    uint32_t partials;          ///< Flush-on-idle partial writes
+    uint32_t stalls;            ///< Packer waits for the card (both blocks in flight)
+    uint32_t write_errors;
+    uint32_t write_max_us;      ///< Slowest block write
+    uint64_t write_total_us;
+    bool     mounted;
+    uint32_t boot;              ///< Boot sequence number in the store
+    uint32_t segment;           ///< Segment being written
+    uint32_t segments;          ///< Segments opened this boot
+    uint32_t deleted;           ///< Old segments removed by rotation
+    uint32_t recovered;         ///< Unclosed segments re-indexed at mount
+    uint64_t raw_bytes;         ///< Text in full blocks written
+    uint64_t stored_bytes;      ///< The same blocks on the card (< raw_bytes when compressing)
+} sd_log_stats_t;
+
+/**
+ * @brief Start the packer and writer tasks and hook ESP_LOGx output.
+ *
+ * Returns immediately; mounting and opening the store happen in the writer task.
+ *
+ * @param segment_kb  Segment size (log.segment_kb)
+ * @param compress    LZ-compress blocks (log.compress)
+ */
+esp_err_t sd_log_init(uint16_t segment_kb, bool compress);
+
+/**
+ * @brief Queue one text line (any task, never blocks).
+ *
+ * @return false if the line was dropped.
+ */
+bool sd_log_line(const char *text, size_t len);
+
+/**
+ * @brief Snapshot of the writer statistics.
+ */
+void sd_log_get_stats(sd_log_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SD_LOG_H
@@ -0,0 +1,74 @@
+// File: main/seg_source.c
+// ==========================================================================================
+// Catalog walk and segment reads behind xfer_source_t (see seg_source.h).
+// ==========================================================================================
+
+#include "seg_source.h"
+#include "log_segment.h"
+
+static bool src_next(void *ctx, xfer_file_t *out) {
+    seg_source_t *s = ctx;
+    log_catalog_header_t cat;
+    log_seg_summary_t sum;
+
+    // Re-read the header: segments may have been closed (or rotated out) meanwhile
+    if (fseek(s->catalog, 0, SEEK_SET) != 0 ||
+        fread(&cat, 1, sizeof(cat), s->catalog) != sizeof(cat) || !log_catalog_header_valid(&cat)) {
+        return false;
+    }
+    if (cat.next_seg > LOG_CATALOG_SLOTS && s->next_id < cat.next_seg - LOG_CATALOG_SLOTS) {
+        s->next_id = cat.next_seg - LOG_CATALOG_SLOTS;
+    }
+    for (; s->next_id < cat.next_seg; s->next_id++) {
+        uint32_t id = s->next_id;
+        if (fseek(s->catalog, log_catalog_slot_offset(id), SEEK_SET) == 0 &&
+            fread(&sum, 1, sizeof(sum), s->catalog) == sizeof(sum) &&
+            log_seg_summary_valid(&sum) && sum.seg_id == id && sum.closed) {
+            out->id = id;
+            out->size = LOG_SEG_HEADER_SIZE + sum.data_bytes;
+            out->tag = sum.crc;
+            s->next_id++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool src_read(void *ctx, const xfer_file_t *f, uint32_t off, uint8_t *buf, size_t len) {
+    seg_source_t *s = ctx;
+
+    if (!s->seg || s->seg_id != f->id) {
+        char path[LOG_PATH_MAX];
+        if (s->seg) {
+            fclose(s->seg);
+        }
+        log_seg_path(path, sizeof(path), s->root, f->id);
+        s->seg = fopen(path, "rb");
+        s->seg_id = f->id;
+        if (!s->seg) {
+            return false;
+        }
+        setvbuf(s->seg, NULL, _IONBF, 0);   // Chunks are read whole: no stdio copy
+    }
+    return fseek(s->seg, (long)off, SEEK_SET) == 0 && fread(buf, 1, len, s->seg) == len;
+}
+
+bool seg_source_open(seg_source_t *s, xfer_source_t *src, const char *root, uint32_t first_id) {
+    char path[LOG_PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s/%s", root, LOG_CATALOG_FILE);
+    *s = (seg_source_t){ .root = root, .catalog = fopen(path, "rb"), .next_id = first_id };
+    *src = (xfer_source_t){ .ctx = s, .next = src_next, .read = src_read };
+    return s->catalog != NULL;
+}
+
+void seg_source_close(seg_source_t *s) {
+    if (s->seg) {
+        fclose(s->seg);
+        s->seg = NULL;
+    }
+    if (s->catalog) {
+        fclose(s->catalog);
+        s->catalog = NULL;
+    }
+}
@@ -0,0 +1,51 @@
+// File: main/seg_source.h
+// ==========================================================================================
+// Closed log segments as a file source for the transfer paths (xfer_source_t): the USB
+// session (tether.c) and the Wi-Fi upload (uploader.c). Walks the catalog oldest first
+// from a given segment id, re-reading its header on every step because segments keep
+// closing (and old ones rotating out) while a transfer runs. The segment being written is
+// not closed yet and is left for the next transfer. A file's tag is its summary CRC.
+// Pure C (stdio), no ESP-IDF includes.
+// ==========================================================================================
+
+#ifndef SEG_SOURCE_H
+#define SEG_SOURCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "xfer_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Source state: the open catalog and the segment being read.
+ */
+typedef struct {
+    const char *root;       ///< Store directory (SD_LOG_ROOT on the device)
+    FILE    *catalog;
+    uint32_t next_id;       ///< Next catalog slot to look at
+    FILE    *seg;           ///< Segment being read (NULL: none yet)
+    uint32_t seg_id;
+} seg_source_t;
+
+/**
+ * @brief Open the catalog under `root` and bind `src` to it.
+ *
+ * @param first_id  Segments below this id are not offered
+ * @return false if there is no catalog.
+ */
+bool seg_source_open(seg_source_t *s, xfer_source_t *src, const char *root, uint32_t first_id);
+
+/**
+ * @brief Close the catalog and the current segment.
+ */
+void seg_source_close(seg_source_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEG_SOURCE_H
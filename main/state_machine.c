@@ -1,44 +1,283 @@
+// File: main/state_machine.c
+// ==========================================================================================
+// Event-driven system state machine.
+// Producers (CLI, timers, ISRs) post events into a lock-free queue; a single FSM task
+// drains it in batches and resolves each event with one lookup in the transition table.
+// ==========================================================================================
 
 #include "state_machine.h"
+#include "fsm_queue.h"
+#include "fsm_stats.h"
+#include "led_handler.h"
+#include "tether.h"      // TETHERED sessions
+#include "untether.h"    // UNTETHERED sessions
+#include "rtv_handler.h" // RTV sessions
+#include "rtv_snap.h"    // OPERATIONAL snapshots
+#include "freertos/task.h"
 #include "esp_log.h"     // For logging
-#include "nvs_flash.h"   // Future: to persist state
-#include "driver/gpio.h" // Optional: for LED indication
+#include "tlog.h"        // Tokenized log records
+#include "esp_timer.h"   // Post timestamps
 
-// =================================
-// Static variable to track the state
-// =================================
-static SystemState current_state;  // Global only to this .c file
+#define FSM_TASK_STACK      3072
+#define FSM_TASK_PRIO       (tskIDLE_PRIORITY + 3)
+#define FSM_BATCH_MAX       8       // Events handled per queue read
+#define FSM_LED_POLL_TICKS  1       // Re-check a pending LED change every tick...
+#define FSM_LED_POLL_MAX    50      // ...for at most this many ticks
+
+_Static_assert(STATE_COUNT <= FSM_STATS_MAX_STATES, "fsm_stats table too small");
 
 // =================================
 // Logging tag for ESP_LOG macros
 // =================================
 static const char *TAG = "STATE_MACHINE";
 
+// =================================
+// Per-state behaviour
+// =================================
+
+/**
+ * @brief Entry/exit hook. `other` is the state being left (entry) or entered (exit).
+ */
+typedef void (*fsm_hook_t)(SystemState other);
+
+/**
+ * @brief One row of the state table.
+ */
+typedef struct {
+    const char   *name;         ///< Label used in logs
+    led_pattern_t led_pattern;  ///< Pattern shown on the STATE LED while in this state
+    fsm_hook_t    on_entry;     ///< Extra work after the LED pattern is applied (may be NULL)
+    fsm_hook_t    on_exit;      ///< Work before leaving the state (may be NULL)
+} fsm_state_desc_t;
+
+static void halted_on_entry(SystemState from) {
+    TLOGW(TAG, "System HALTED (from %s); magic key required to resume",
+             state_machine_state_name(from));
+}
+
+static void operational_on_entry(SystemState from) {
+    rtv_snap_start();
+}
+
+static void operational_on_exit(SystemState to) {
+    rtv_snap_stop();
+}
+
+static void transfer_on_exit(SystemState to) {
+    if (to == STATE_OPERATIONAL) {
+        TLOGI(TAG, "Transfer session closed");
+    }
+}
+
+static void tethered_on_entry(SystemState from) {
+    // After a failed upload, continue over USB where the server's copy ends
+    tether_start(from == STATE_UNTETHERED ? untether_cursor().seg_id : 0);
+}
+
+static void tethered_on_exit(SystemState to) {
+    tether_stop();
+    transfer_on_exit(to);
+}
+
+static void untethered_on_entry(SystemState from) {
+    untether_start();
+}
+
+static void untethered_on_exit(SystemState to) {
+    untether_stop();
+    transfer_on_exit(to);
+}
+
+static void rtv_on_entry(SystemState from) {
+    rtv_start();
+}
+
+static void rtv_on_exit(SystemState to) {
+    rtv_stop();
+}
+
+static const fsm_state_desc_t state_table[STATE_COUNT] = {
+    [STATE_DEV]         = { "DEV",         LED_PATTERN_DEV_MODE,     NULL,                 NULL },
+    [STATE_OPERATIONAL] = { "OPERATIONAL", LED_PATTERN_OPERATIONAL,  operational_on_entry, operational_on_exit },
+    [STATE_TETHERED]    = { "TETHERED",    LED_PATTERN_TETHERED,     tethered_on_entry,    tethered_on_exit },
+    [STATE_UNTETHERED]  = { "UNTETHERED",  LED_PATTERN_UNTETHERED,   untethered_on_entry,  untethered_on_exit },
+    [STATE_RTV]         = { "RTV",         LED_PATTERN_RTV_ACTIVE,   rtv_on_entry,         rtv_on_exit },
+    [STATE_HALTED]      = { "HALTED",      LED_PATTERN_HALTED_ENTRY, halted_on_entry,      NULL },
+};
+
+static const char *const event_names[EVENT_COUNT] = {
+    [EVENT_NONE]              = "NONE",
+    [EVENT_CLI_MAGIC_KEY]     = "CLI_MAGIC_KEY",
+    [EVENT_CLI_SET_OP]        = "CLI_SET_OP",
+    [EVENT_TIMEOUT]           = "TIMEOUT",
+    [EVENT_RTV_ON]            = "RTV_ON",
+    [EVENT_RTV_OFF]           = "RTV_OFF",
+    [EVENT_TRANSFER_COMPLETE] = "TRANSFER_COMPLETE",
+    [EVENT_TRANSFER_FAILED]   = "TRANSFER_FAILED",
+    [EVENT_ERROR]             = "ERROR",
+    [EVENT_TETHER_REQUEST]    = "TETHER_REQUEST",
+    [EVENT_UNTETHER_REQUEST]  = "UNTETHER_REQUEST",
+};
+
+// =================================
+// Transition table
+// =================================
+// Entries hold (target state + 1) so that an omitted (zero) entry means "ignore event".
+
+#define GO(s)   ((uint8_t)((s) + 1))
+
+static const uint8_t transition_table[STATE_COUNT][EVENT_COUNT] = {
+    [STATE_DEV] = {
+        [EVENT_CLI_SET_OP]        = GO(STATE_OPERATIONAL),
+        [EVENT_ERROR]             = GO(STATE_HALTED),
+    },
+    [STATE_OPERATIONAL] = {
+        [EVENT_CLI_MAGIC_KEY]     = GO(STATE_DEV),
+        [EVENT_RTV_ON]            = GO(STATE_RTV),
+        [EVENT_TETHER_REQUEST]    = GO(STATE_TETHERED),
+        [EVENT_UNTETHER_REQUEST]  = GO(STATE_UNTETHERED),
+        [EVENT_ERROR]             = GO(STATE_HALTED),
+    },
+    [STATE_TETHERED] = {
+        [EVENT_TRANSFER_COMPLETE] = GO(STATE_OPERATIONAL),
+        [EVENT_TRANSFER_FAILED]   = GO(STATE_OPERATIONAL),
+        [EVENT_ERROR]             = GO(STATE_HALTED),
+    },
+    [STATE_UNTETHERED] = {
+        [EVENT_TRANSFER_COMPLETE] = GO(STATE_OPERATIONAL),
+        [EVENT_TRANSFER_FAILED]   = GO(STATE_TETHERED),     // Wi-Fi failed: fall back to USB
+        [EVENT_TIMEOUT]           = GO(STATE_OPERATIONAL),  // Gave up, fallback disabled
+        [EVENT_ERROR]             = GO(STATE_HALTED),
+    },
+    [STATE_RTV] = {
+        [EVENT_RTV_OFF]           = GO(STATE_OPERATIONAL),
+        [EVENT_TIMEOUT]           = GO(STATE_OPERATIONAL),
+        [EVENT_ERROR]             = GO(STATE_HALTED),
+    },
+    [STATE_HALTED] = {
+        [EVENT_CLI_MAGIC_KEY]     = GO(STATE_DEV),
+    },
+};
+
+// ==========================================
+// Internal State Variables (invisible to .h)
+// ==========================================
+static volatile SystemState current_state = STATE_DEV;  // Written by the FSM task only
+static fsm_queue_t event_queue;
+static TaskHandle_t fsm_task = NULL;
+
+/**
+ * @brief Last transition whose STATE LED change has not been observed yet.
+ *        Owned by the FSM task.
+ */
+static struct {
+    bool     active;
+    uint8_t  from;
+    uint8_t  to;
+    uint16_t polls;
+    uint32_t posted_us;     ///< When the triggering event was posted
+    uint32_t led_seq;       ///< led_apply_pattern() sequence number
+} led_probe;
+
+// ==============================
+// Names
+// ==============================
+
+const char *state_machine_state_name(SystemState state) {
+    return ((unsigned)state < STATE_COUNT) ? state_table[state].name : "?";
+}
+
+const char *state_machine_event_name(event_t event) {
+    return ((unsigned)event < EVENT_COUNT) ? event_names[event] : "?";
+}
+
 // =====================================
 // Initialize the state machine on boot
 // =====================================
 void state_machine_init(void)
 {
+    fsm_queue_init(&event_queue);
+
     // TODO: Load from NVS in future
-    // Placeholder logic:
     current_state = STATE_DEV;
 
-    // Optional: Log this event
-    ESP_LOGI(TAG, "State machine initialized in DEV mode");
+    TLOGI(TAG, "State machine initialized in DEV mode");
+}
+
+// ============================================
+// Transition latency probe
+// ============================================
+
+/**
+ * @brief Close the pending LED measurement if the LED task has applied the pattern.
+ *
+ * Gives up after FSM_LED_POLL_MAX checks and counts the transition as missed.
+ */
+static void fsm_led_probe_check(void)
+{
+    uint32_t applied_us;
+
+    if (!led_probe.active) {
+        return;
+    }
+    if (led_cmd_applied(LED_CHANNEL_STATE, led_probe.led_seq, &applied_us)) {
+        fsm_stats_add_led(led_probe.from, led_probe.to, applied_us - led_probe.posted_us);
+        led_probe.active = false;
+    } else if (++led_probe.polls >= FSM_LED_POLL_MAX) {
+        fsm_stats_note_led_missed(led_probe.from, led_probe.to);
+        led_probe.active = false;
+    }
 }
 
 // ============================================
 // Transition to a new state with side effects
 // ============================================
-void transition_to_state(SystemState new_state)
+
+/**
+ * @brief Run exit hook, state switch and entry hook, timing each phase.
+ *
+ * @param posted_us When the triggering event was posted (esp_timer, low 32 bits).
+ */
+static void fsm_run_transition(SystemState new_state, uint32_t posted_us)
 {
-    // TODO: Add validation if needed
-    // TODO: Call per-state entry behavior (LED pattern, etc.)
+    SystemState old_state = current_state;
+
+    if ((unsigned)new_state >= STATE_COUNT || new_state == old_state) {
+        return;
+    }
 
-    // Log state transition
-    ESP_LOGI(TAG, "State change: %d -> %d", current_state, new_state);
+    uint32_t t_start = (uint32_t)esp_timer_get_time();
+    if (state_table[old_state].on_exit) {
+        state_table[old_state].on_exit(new_state);
+    }
+    uint32_t t_exit = (uint32_t)esp_timer_get_time();
 
     current_state = new_state;
+
+    uint32_t led_seq = led_apply_pattern(LED_CHANNEL_STATE, state_table[new_state].led_pattern);
+    if (state_table[new_state].on_entry) {
+        state_table[new_state].on_entry(old_state);
+    }
+    uint32_t t_entry = (uint32_t)esp_timer_get_time();
+
+    fsm_stats_add_transition(old_state, new_state,
+                             t_start - posted_us, t_exit - t_start, t_entry - t_exit);
+
+    // An older LED change still pending is either done by now or superseded
+    fsm_led_probe_check();
+    if (led_probe.active) {
+        fsm_stats_note_led_missed(led_probe.from, led_probe.to);
+    }
+    led_probe.active = (led_seq != 0);
+    led_probe.from = (uint8_t)old_state;
+    led_probe.to = (uint8_t)new_state;
+    led_probe.polls = 0;
+    led_probe.posted_us = posted_us;
+    led_probe.led_seq = led_seq;
+
+    TLOGI(TAG, "State change: %s -> %s (%u us)",
+             state_table[old_state].name, state_table[new_state].name,
+             (unsigned)(t_entry - posted_us));
 }
 
 // ==============================
@@ -49,22 +288,98 @@ SystemState get_current_state(void)
     return current_state;
 }
 
-// state_machine.c
+// ==============================
+// Event posting (any context)
+// ==============================
 
-static const char *TAG = "STATE_MACHINE"; // Log tag for this module
+bool state_machine_post_event(event_t event)
+{
+    fsm_msg_t msg = { .event = (uint8_t)event, .posted_us = (uint32_t)esp_timer_get_time() };
 
-// ==========================================
-// Internal State Variables (invisible to .h)
-// ==========================================
-static SystemState current_state = STATE_DEV; // Default state at startup
-static uint8_t security_level = 0; // Default security level
+    if ((unsigned)event >= EVENT_COUNT || !fsm_queue_push(&event_queue, &msg)) {
+        return false;
+    }
+    if (fsm_task) {
+        xTaskNotifyGive(fsm_task);
+    }
+    return true;
+}
+
+bool state_machine_post_event_from_isr(event_t event, BaseType_t *woken)
+{
+    fsm_msg_t msg = { .event = (uint8_t)event, .posted_us = (uint32_t)esp_timer_get_time() };
 
-// ===============================
-// Function Implementations
-// ===============================
+    if ((unsigned)event >= EVENT_COUNT || !fsm_queue_push(&event_queue, &msg)) {
+        return false;
+    }
+    if (fsm_task) {
+        vTaskNotifyGiveFromISR(fsm_task, woken);
+    }
+    return true;
+}
 
-// Return the current state
-SystemState get_current_state(void) {
-    return current_state;
+// ==============================
+// FSM task
+// ==============================
+
+/**
+ * @brief Resolve one event against the transition table.
+ */
+static void fsm_dispatch(const fsm_msg_t *msg)
+{
+    SystemState state = current_state;
+    uint8_t next = transition_table[state][msg->event];
+
+    TLOGD(TAG, "Event %s in %s (queued %u us)",
+             event_names[msg->event], state_table[state].name,
+             (unsigned)((uint32_t)esp_timer_get_time() - msg->posted_us));
+
+    if (next == 0) {
+        TLOGD(TAG, "Event %s ignored in %s", event_names[msg->event], state_table[state].name);
+        return;
+    }
+    fsm_run_transition((SystemState)(next - 1), msg->posted_us);
+}
+
+/**
+ * @brief Sleeps until notified, then drains the queue FSM_BATCH_MAX events at a time.
+ *
+ * While an LED change is pending the wait is bounded so the probe gets polled.
+ */
+static void state_machine_task(void *arg)
+{
+    fsm_msg_t batch[FSM_BATCH_MAX];
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, led_probe.active ? FSM_LED_POLL_TICKS : portMAX_DELAY);
+        fsm_led_probe_check();
+
+        size_t n;
+        while ((n = fsm_queue_pop_batch(&event_queue, batch, FSM_BATCH_MAX)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                fsm_dispatch(&batch[i]);
+            }
+        }
+        fsm_led_probe_check();
+    }
 }
 
+void state_machine_start(void)
+{
+    if (fsm_task) {
+        return;
+    }
+
+    // Show the initial state before any event can move us away from it
+    led_apply_pattern(LED_CHANNEL_STATE, state_table[current_state].led_pattern);
+
+    if (xTaskCreate(state_machine_task, "fsm", FSM_TASK_STACK, NULL,
+                    FSM_TASK_PRIO, &fsm_task) != pdPASS) {
+        TLOGE(TAG, "Failed to create FSM task");
+        fsm_task = NULL;
+        return;
+    }
+
+    // Pick up anything posted between init and start
+    xTaskNotifyGive(fsm_task);
+}
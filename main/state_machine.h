@@ -1,10 +1,10 @@
-
 // File: main/state_machine.h
 
 #ifndef STATE_MACHINE_H
 #define STATE_MACHINE_H
 #include <stdbool.h>  // Enables use of `bool`, `true`, `false`
 #include <stdint.h> // Enables use of `uint8_t`, `uint32_t`, etc.
+#include "freertos/FreeRTOS.h" // BaseType_t for the ISR API
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,7 +19,8 @@ typedef enum {
     STATE_TETHERED,    // Connected via USB OTG for transfer
     STATE_UNTETHERED,  // Transfer via Wi-Fi
     STATE_RTV,         // Real-Time View session (live camera)
-    STATE_HALTED       // Fatal error or intentional halt
+    STATE_HALTED,      // Fatal error or intentional halt
+    STATE_COUNT        // Number of states (not a state)
 } SystemState;
 
 // ===============================
@@ -34,7 +35,10 @@ typedef enum {
     EVENT_RTV_OFF,          // RTV timed out or stopped
     EVENT_TRANSFER_COMPLETE,// File/data transfer completed
     EVENT_TRANSFER_FAILED,  // Transfer failed (Wi-Fi/USB)
-    EVENT_ERROR             // Generic error
+    EVENT_ERROR,            // Generic error
+    EVENT_TETHER_REQUEST,   // Start a log transfer over USB
+    EVENT_UNTETHER_REQUEST, // Start a log upload over Wi-Fi
+    EVENT_COUNT             // Number of events (not an event)
 } event_t;
 
 
@@ -43,7 +47,7 @@ typedef enum {
 // =====================================
 
 /**
- * @brief Initialize the state machine. 
+ * @brief Initialize the state machine.
  *        Should be called at system startup.
  *        Will read from NVS (non-volatile storage) if implemented,
  *        or start in a default safe state like DEV or HALTED.
@@ -51,18 +55,44 @@ typedef enum {
 void state_machine_init(void);
 
 /**
- * @brief Perform a transition to a new system state.
- *        Will include logging, LED signaling, and future behavior hooks.
+ * @brief Start the FSM task and run the entry hook of the initial state.
+ *        Events posted before this call are queued and handled once it runs.
+ */
+void state_machine_start(void);
+
+/**
+ * @brief Queue an event for the FSM task. Lock-free; never blocks.
+ *        Events are the only way to change state: transitions run in the FSM task,
+ *        which owns the hooks' sessions and the LED latency probe.
+ *
+ * @return false if the event queue is full (the event is dropped).
+ */
+bool state_machine_post_event(event_t event);
+
+/**
+ * @brief ISR variant of state_machine_post_event().
+ *
+ * @param[out] woken Set to pdTRUE if a context switch should be requested on ISR exit.
  */
-void transition_to_state(SystemState new_state);
+bool state_machine_post_event_from_isr(event_t event, BaseType_t *woken);
 
 /**
  * @brief Returns the current system state.
  */
+SystemState get_current_state(void);
 
+/**
+ * @brief Short printable name of a state (e.g. "OPERATIONAL").
+ */
+const char *state_machine_state_name(SystemState state);
+
+/**
+ * @brief Short printable name of an event (e.g. "RTV_ON").
+ */
+const char *state_machine_event_name(event_t event);
 
- #ifdef __cplusplus
+#ifdef __cplusplus
 }
 #endif
 
-#endif // STATE_MACHINE_H  <-- ENSURE THIS LINE IS PRESENT AND ONLY ONE EXISTS
\ No newline at end of file
+#endif // STATE_MACHINE_H
@@ -0,0 +1,210 @@
+// File: main/tether.c
+// ==========================================================================================
+// Tethered transfer task: xfer_proto sender <- segment files via the catalog (seg_source),
+//                                           -> USB Serial/JTAG driver (link).
+// The task idles on a notification between sessions. Segments are read straight from the
+// card, so the session holds one chunk plus its encoded frame (xfer_tx_t, malloc'ed per
+// session) and does not touch the log writer: the segment being written is not closed
+// in the catalog yet and is left for the next session.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "tether.h"
+#include "seg_source.h"
+#include "sd_log.h"
+#include "state_machine.h"
+#include "driver/usb_serial_jtag.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define TETHER_TASK_STACK   3072
+#define TETHER_TASK_PRIO    (tskIDLE_PRIORITY + 1)
+#define TETHER_USB_TX_BUF   4096    // Driver ring buffers
+#define TETHER_USB_RX_BUF   512
+#define TETHER_WRITE_SLICE  1024    // Bytes handed to the driver per call
+#define TETHER_WRITE_MS     50      // A slice not queued by then: host not reading
+
+static const char *TAG = "TETHER";
+
+static TaskHandle_t task = NULL;
+static atomic_bool cancel;
+static xfer_params_t params;
+static uint32_t first_id;           ///< Segments below were uploaded (set by tether_start)
+static bool usb_ready;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static tether_stats_t stats;
+static const xfer_tx_t *live;       ///< Session in progress (under stats_lock)
+
+// === Link: USB Serial/JTAG ===
+
+static TickType_t ms_to_ticks(uint32_t ms) {
+    return ms ? pdMS_TO_TICKS(ms) + 1 : 0;     // Round up: never 0 for a real wait
+}
+
+static int link_read(void *ctx, uint8_t *buf, size_t cap, uint32_t timeout_ms) {
+    if (!usb_serial_jtag_is_connected()) {
+        vTaskDelay(ms_to_ticks(timeout_ms ? timeout_ms : 1));
+        return -1;
+    }
+    return usb_serial_jtag_read_bytes(buf, (uint32_t)cap, ms_to_ticks(timeout_ms));
+}
+
+static bool link_write(void *ctx, const uint8_t *data, size_t len) {
+    if (!usb_serial_jtag_is_connected()) {
+        return false;
+    }
+    while (len > 0) {
+        size_t n = len < TETHER_WRITE_SLICE ? len : TETHER_WRITE_SLICE;
+        if (usb_serial_jtag_write_bytes(data, n, pdMS_TO_TICKS(TETHER_WRITE_MS)) != (int)n) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+static uint32_t link_now_ms(void *ctx) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static bool link_cancelled(void *ctx) {
+    return atomic_load(&cancel);
+}
+
+static const xfer_link_t usb_link = {
+    .read = link_read,
+    .write = link_write,
+    .now_ms = link_now_ms,
+    .cancelled = link_cancelled,
+};
+
+// === Session ===
+
+static xfer_result_t tether_session(xfer_tx_t *tx) {
+    sd_log_stats_t sd;
+    seg_source_t src_ctx = { 0 };
+    xfer_source_t src;
+
+    sd_log_get_stats(&sd);
+    if (!sd.mounted || !seg_source_open(&src_ctx, &src, SD_LOG_ROOT, first_id)) {
+        seg_source_close(&src_ctx);
+        ESP_LOGE(TAG, "No log store on the card");
+        return XFER_ERR_SOURCE;
+    }
+
+    xfer_params_t p = params;
+    p.boot = sd.boot;
+    p.session = esp_random();
+    xfer_result_t r = xfer_send(tx, &p, &usb_link, &src);
+
+    seg_source_close(&src_ctx);
+    return r;
+}
+
+static void tether_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xfer_tx_t *tx = calloc(1, sizeof(*tx));
+        if (!tx) {
+            ESP_LOGE(TAG, "No memory for a session (%u bytes)", (unsigned)sizeof(*tx));
+            state_machine_post_event(EVENT_TRANSFER_FAILED);
+            continue;
+        }
+        taskENTER_CRITICAL(&stats_lock);
+        stats.running = true;
+        stats.sessions++;
+        live = tx;
+        taskEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGI(TAG, "Session started at segment %u: %u B chunks, window %u, waiting %u s "
+                 "for the host", (unsigned)first_id, (unsigned)params.chunk,
+                 (unsigned)params.window, (unsigned)(params.resume_ms / 1000));
+        xfer_result_t r = tether_session(tx);
+        const xfer_stats_t *x = &tx->stats;
+
+        taskENTER_CRITICAL(&stats_lock);
+        stats.running = false;
+        stats.result = r;
+        stats.completed += (r == XFER_OK);
+        stats.xfer = *x;
+        live = NULL;
+        taskEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGI(TAG, "Session %s: %u files (%u already on host, %u bad), %u KB in %u ms "
+                 "(%u KB/s), %u retransmits, %u reconnects",
+                 xfer_result_str(r), (unsigned)x->files, (unsigned)x->skipped, (unsigned)x->bad,
+                 (unsigned)(x->bytes >> 10), (unsigned)x->elapsed_ms,
+                 x->elapsed_ms ? (unsigned)(x->bytes / x->elapsed_ms * 1000 >> 10) : 0,
+                 (unsigned)x->retransmits, (unsigned)x->reconnects);
+        free(tx);
+
+        if (r == XFER_OK) {
+            state_machine_post_event(EVENT_TRANSFER_COMPLETE);
+        } else if (r != XFER_ERR_CANCELLED) {
+            state_machine_post_event(EVENT_TRANSFER_FAILED);
+        }
+    }
+}
+
+// === Public API ===
+
+esp_err_t tether_init(uint32_t chunk_bytes, uint8_t window, uint16_t resume_s) {
+    if (task) {
+        return ESP_OK;
+    }
+    params.chunk = (uint16_t)(chunk_bytes < XFER_CHUNK_MAX ? chunk_bytes : XFER_CHUNK_MAX);
+    params.window = window;
+    params.resume_ms = (uint32_t)resume_s * 1000;
+
+    if (xTaskCreate(tether_task, "tether", TETHER_TASK_STACK, NULL,
+                    TETHER_TASK_PRIO, &task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create tether task");
+        task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void tether_start(uint32_t from_seg) {
+    if (!task) {
+        ESP_LOGW(TAG, "Not initialised: no transfer");
+        state_machine_post_event(EVENT_TRANSFER_FAILED);
+        return;
+    }
+    if (!usb_ready) {
+        usb_serial_jtag_driver_config_t cfg = {
+            .tx_buffer_size = TETHER_USB_TX_BUF,
+            .rx_buffer_size = TETHER_USB_RX_BUF,
+        };
+        esp_err_t err = usb_serial_jtag_driver_install(&cfg);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "USB Serial/JTAG driver: %s", esp_err_to_name(err));
+            state_machine_post_event(EVENT_TRANSFER_FAILED);
+            return;
+        }
+        usb_ready = true;
+    }
+    first_id = from_seg;
+    atomic_store(&cancel, false);   // A stop before the task wakes still cancels
+    xTaskNotifyGive(task);
+}
+
+void tether_stop(void) {
+    atomic_store(&cancel, true);
+}
+
+void tether_get_stats(tether_stats_t *out) {
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    if (live) {
+        out->xfer = live->stats;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
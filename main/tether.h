@@ -0,0 +1,65 @@
+// File: main/tether.h
+// ==========================================================================================
+// Tethered log transfer. On entry to TETHERED, a session sends every closed log segment
+// the host does not have yet over the ESP32-S3's USB Serial/JTAG port (a CDC-ACM device
+// on the PC), using xfer_proto.h. It then posts EVENT_TRANSFER_COMPLETE, or
+// EVENT_TRANSFER_FAILED if there is no card, no host, or the host stays away longer
+// than transfer.resume_s after a cable pull. The receiver is tools/tether_recv.py; it
+// rebuilds the card's LOGS directory and resumes partial files across sessions.
+// ==========================================================================================
+
+#ifndef TETHER_H
+#define TETHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "xfer_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Session counters (printed by the tether CLI command).
+ */
+typedef struct {
+    bool          running;      ///< A session is in progress (xfer counts are live)
+    uint32_t      sessions;     ///< Sessions started since boot
+    uint32_t      completed;    ///< Of those, ended with XFER_OK
+    xfer_result_t result;       ///< Outcome of the last finished session
+    xfer_stats_t  xfer;         ///< Current session, or the last one
+} tether_stats_t;
+
+/**
+ * @brief Start the (idle) transfer task. Sessions run on tether_start().
+ *
+ * @param chunk_bytes  DATA payload (transfer.chunk_bytes, capped at XFER_CHUNK_MAX)
+ * @param window       Chunks in flight (transfer.window)
+ * @param resume_s     How long to wait for the host, at start and after a link loss
+ */
+esp_err_t tether_init(uint32_t chunk_bytes, uint8_t window, uint16_t resume_s);
+
+/**
+ * @brief Begin a session (TETHERED entry). Never blocks.
+ *
+ * @param from_seg  First segment to offer: 0 for all, or the upload cursor when taking
+ *                  over from a failed upload (the server already has what lies before)
+ */
+void tether_start(uint32_t from_seg);
+
+/**
+ * @brief Cancel the running session (TETHERED exit). No event is posted for it.
+ */
+void tether_stop(void);
+
+/**
+ * @brief Snapshot of the counters.
+ */
+void tether_get_stats(tether_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TETHER_H
@@ -0,0 +1,135 @@
+// File: main/tlog.c
+// ==========================================================================================
+// Tokenized log records.
+// Record: [level | 0x80 if truncated] [hash u32 LE] [timestamp ms, varint] [tag] [args...]
+//   tag      length byte + bytes (at most TLOG_TAG_MAX)
+//   int      zigzag varint (unsigned values go out as their int32 bit pattern)
+//   int64    zigzag varint
+//   double   IEEE float32 LE
+//   string   length byte + bytes (at most TLOG_STRING_MAX)
+//   pointer  zigzag varint of the address as a signed integer
+// The record is base64-encoded behind a '$' so it survives any text channel.
+// ==========================================================================================
+
+#include <string.h>
+#include "tlog.h"
+
+#define TLOG_FLAG_TRUNCATED 0x80
+
+static const char b64_chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// === Encoding ===
+
+static size_t put_varint(uint8_t *out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static size_t put_string(uint8_t *out, const char *s, size_t max) {
+    size_t len = s ? strnlen(s, max) : 0;
+    out[0] = (uint8_t)len;
+    if (len) {
+        memcpy(&out[1], s, len);
+    }
+    return 1 + len;
+}
+
+size_t tlog_vencode(uint8_t *out, size_t cap, uint8_t level, const char *tag, uint32_t hash,
+                    uint32_t timestamp_ms, uint32_t types, va_list args) {
+    uint8_t tmp[10 + TLOG_STRING_MAX + 1];
+    size_t n = 0;
+    unsigned count = types & 0xF;
+
+    if (cap < 5 + 5 + 1 + TLOG_TAG_MAX) {
+        return 0;
+    }
+    out[n++] = level;
+    out[n++] = (uint8_t)hash;
+    out[n++] = (uint8_t)(hash >> 8);
+    out[n++] = (uint8_t)(hash >> 16);
+    out[n++] = (uint8_t)(hash >> 24);
+    n += put_varint(&out[n], timestamp_ms);
+    n += put_string(&out[n], tag, TLOG_TAG_MAX);
+
+    for (unsigned i = 0; i < count && i < TLOG_MAX_ARGS; i++) {
+        size_t len = 0;
+
+        switch ((types >> (4 + TLOG_ARG_BITS * i)) & ((1u << TLOG_ARG_BITS) - 1)) {
+            case TLOG_ARG_INT:
+                len = put_varint(tmp, zigzag(va_arg(args, int)));
+                break;
+            case TLOG_ARG_INT64:
+                len = put_varint(tmp, zigzag(va_arg(args, long long)));
+                break;
+            case TLOG_ARG_DOUBLE: {
+                float f = (float)va_arg(args, double);
+                uint32_t bits;
+                memcpy(&bits, &f, sizeof(bits));
+                tmp[0] = (uint8_t)bits;
+                tmp[1] = (uint8_t)(bits >> 8);
+                tmp[2] = (uint8_t)(bits >> 16);
+                tmp[3] = (uint8_t)(bits >> 24);
+                len = 4;
+                break;
+            }
+            case TLOG_ARG_STRING:
+                len = put_string(tmp, va_arg(args, const char *), TLOG_STRING_MAX);
+                break;
+            case TLOG_ARG_PTR:
+                len = put_varint(tmp, zigzag((intptr_t)va_arg(args, void *)));
+                break;
+        }
+
+        if (n + len > cap) {
+            out[0] |= TLOG_FLAG_TRUNCATED;
+            break;
+        }
+        memcpy(&out[n], tmp, len);
+        n += len;
+    }
+    return n;
+}
+
+static size_t base64_encode(char *out, const uint8_t *in, size_t len) {
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+
+        out[n++] = b64_chars[(v >> 18) & 63];
+        out[n++] = b64_chars[(v >> 12) & 63];
+        out[n++] = (i + 1 < len) ? b64_chars[(v >> 6) & 63] : '=';
+        out[n++] = (i + 2 < len) ? b64_chars[v & 63] : '=';
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// === Output ===
+
+void tlog_emit(esp_log_level_t level, const char *tag, uint32_t hash, uint32_t types, ...) {
+    uint8_t rec[TLOG_RECORD_MAX];
+    char text[(TLOG_RECORD_MAX + 2) / 3 * 4 + 1];
+    va_list args;
+
+    va_start(args, types);
+    size_t n = tlog_vencode(rec, sizeof(rec), (uint8_t)level, tag, hash, esp_log_timestamp(),
+                            types, args);
+    va_end(args);
+
+    base64_encode(text, rec, n);
+    // esp_log_write applies the per-tag level filter and feeds every hooked sink
+    esp_log_write(level, tag, "$%s\n", text);
+}
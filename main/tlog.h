@@ -0,0 +1,210 @@
+// File: main/tlog.h
+// ==========================================================================================
+// Tokenized logging.
+// TLOGx(TAG, "fmt", args...) works like ESP_LOGx, but the format string never reaches the
+// firmware image: the call site emits a compact record (format hash, tag + raw arguments),
+// sent as one "$<base64>" line through esp_log (UART, and the SD log when enabled).
+// tools/tlog_dict.py collects the format strings into build/tlog_dict.json at build time;
+// tools/tlog_decode.py turns captured UART output or SD log files back into text.
+//
+// Define TLOG_ENABLED 0 to turn every TLOGx back into the equivalent ESP_LOGx.
+// ==========================================================================================
+
+#ifndef TLOG_H
+#define TLOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TLOG_ENABLED
+#define TLOG_ENABLED        1
+#endif
+
+#define TLOG_RECORD_MAX     64      // Encoded record bytes (arguments past this are cut)
+#define TLOG_STRING_MAX     24      // Bytes kept of each %s argument
+#define TLOG_TAG_MAX        16      // Bytes kept of the tag
+#define TLOG_MAX_ARGS       8
+
+// === Argument types (3 bits each, packed after a 4-bit count) ===
+
+#define TLOG_ARG_INT        0u      // Up to 32 bits, zigzag varint
+#define TLOG_ARG_INT64      1u      // long long, zigzag varint
+#define TLOG_ARG_DOUBLE     2u      // float/double, sent as 32-bit float
+#define TLOG_ARG_STRING     3u      // Length byte + bytes
+#define TLOG_ARG_PTR        4u      // Pointer, zigzag varint of its address (all its bits)
+#define TLOG_ARG_BITS       3
+
+// Other pointer types fall to the default: as wide as an int they go out as one (same
+// bits on a 32-bit target), wider ones (64-bit host) as a pointer.
+#define TLOG_ARG_TYPE(a) _Generic((a),                                  \
+    char *: TLOG_ARG_STRING, const char *: TLOG_ARG_STRING,             \
+    float: TLOG_ARG_DOUBLE, double: TLOG_ARG_DOUBLE,                    \
+    long long: TLOG_ARG_INT64, unsigned long long: TLOG_ARG_INT64,      \
+    long: (sizeof(long) > 4 ? TLOG_ARG_INT64 : TLOG_ARG_INT),           \
+    unsigned long: (sizeof(long) > 4 ? TLOG_ARG_INT64 : TLOG_ARG_INT),  \
+    void *: TLOG_ARG_PTR, const void *: TLOG_ARG_PTR,                   \
+    default: (sizeof(a) > sizeof(int) ? TLOG_ARG_PTR : TLOG_ARG_INT))
+
+#define TLOG_CAT_(a, b)     a##b
+#define TLOG_CAT(a, b)      TLOG_CAT_(a, b)
+#define TLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define TLOG_NARGS(...)     TLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TLOG_T_(a, i)       (TLOG_ARG_TYPE(a) << (4 + TLOG_ARG_BITS * (i)))
+
+#define TLOG_TYPES_0()                          0u
+#define TLOG_TYPES_1(a)                         (1u | TLOG_T_(a, 0))
+#define TLOG_TYPES_2(a, b)                      (2u | TLOG_T_(a, 0) | TLOG_T_(b, 1))
+#define TLOG_TYPES_3(a, b, c)                   (3u | TLOG_T_(a, 0) | TLOG_T_(b, 1) | TLOG_T_(c, 2))
+#define TLOG_TYPES_4(a, b, c, d)                (4u | TLOG_T_(a, 0) | TLOG_T_(b, 1) | TLOG_T_(c, 2) | \
+                                                 TLOG_T_(d, 3))
+#define TLOG_TYPES_5(a, b, c, d, e)             ((TLOG_TYPES_4(a, b, c, d) + 1u) | TLOG_T_(e, 4))
+#define TLOG_TYPES_6(a, b, c, d, e, f)          ((TLOG_TYPES_5(a, b, c, d, e) + 1u) | TLOG_T_(f, 5))
+#define TLOG_TYPES_7(a, b, c, d, e, f, g)       ((TLOG_TYPES_6(a, b, c, d, e, f) + 1u) | TLOG_T_(g, 6))
+#define TLOG_TYPES_8(a, b, c, d, e, f, g, h)    ((TLOG_TYPES_7(a, b, c, d, e, f, g) + 1u) | TLOG_T_(h, 7))
+
+/** @brief Argument count and types of a call, as one compile-time constant. */
+#define TLOG_TYPES(...)     TLOG_CAT(TLOG_TYPES_, TLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+// === Format string hash ===
+// 65599 hash over the length and the first TLOG_HASH_LEN bytes, written so the compiler
+// folds it to a constant and drops the literal. tools/tlog_dict.py computes the same value.
+
+#define TLOG_HASH_LEN       80
+#define TLOG_HASH_CHAR_(s, i, k) \
+    ((i) < sizeof(s) - 1 ? (uint32_t)(uint8_t)(s)[(i) < sizeof(s) ? (i) : 0] * (k) : 0u)
+
+#define TLOG_HASH(s) ((uint32_t)(sizeof(s) - 1) + \
+    TLOG_HASH_CHAR_(s,  0, 0x0001003Fu) + \
+    TLOG_HASH_CHAR_(s,  1, 0x007E0F81u) + \
+    TLOG_HASH_CHAR_(s,  2, 0x2E86D0BFu) + \
+    TLOG_HASH_CHAR_(s,  3, 0x43EC5F01u) + \
+    TLOG_HASH_CHAR_(s,  4, 0x162C613Fu) + \
+    TLOG_HASH_CHAR_(s,  5, 0xD62AEE81u) + \
+    TLOG_HASH_CHAR_(s,  6, 0xA311B1BFu) + \
+    TLOG_HASH_CHAR_(s,  7, 0xD319BE01u) + \
+    TLOG_HASH_CHAR_(s,  8, 0xB156C23Fu) + \
+    TLOG_HASH_CHAR_(s,  9, 0x6698CD81u) + \
+    TLOG_HASH_CHAR_(s, 10, 0x0D1B92BFu) + \
+    TLOG_HASH_CHAR_(s, 11, 0xCC881D01u) + \
+    TLOG_HASH_CHAR_(s, 12, 0x7280233Fu) + \
+    TLOG_HASH_CHAR_(s, 13, 0x50C7AC81u) + \
+    TLOG_HASH_CHAR_(s, 14, 0x8DA473BFu) + \
+    TLOG_HASH_CHAR_(s, 15, 0x4F377C01u) + \
+    TLOG_HASH_CHAR_(s, 16, 0xFAA8843Fu) + \
+    TLOG_HASH_CHAR_(s, 17, 0x33B78B81u) + \
+    TLOG_HASH_CHAR_(s, 18, 0x45AC54BFu) + \
+    TLOG_HASH_CHAR_(s, 19, 0x7A27DB01u) + \
+    TLOG_HASH_CHAR_(s, 20, 0xEACFE53Fu) + \
+    TLOG_HASH_CHAR_(s, 21, 0xAE686A81u) + \
+    TLOG_HASH_CHAR_(s, 22, 0x563335BFu) + \
+    TLOG_HASH_CHAR_(s, 23, 0x6C593A01u) + \
+    TLOG_HASH_CHAR_(s, 24, 0xE3F6463Fu) + \
+    TLOG_HASH_CHAR_(s, 25, 0x5FDA4981u) + \
+    TLOG_HASH_CHAR_(s, 26, 0xE03916BFu) + \
+    TLOG_HASH_CHAR_(s, 27, 0x44CB9901u) + \
+    TLOG_HASH_CHAR_(s, 28, 0x871BA73Fu) + \
+    TLOG_HASH_CHAR_(s, 29, 0xE70D2881u) + \
+    TLOG_HASH_CHAR_(s, 30, 0x04BDF7BFu) + \
+    TLOG_HASH_CHAR_(s, 31, 0x227EF801u) + \
+    TLOG_HASH_CHAR_(s, 32, 0x7540083Fu) + \
+    TLOG_HASH_CHAR_(s, 33, 0xE3010781u) + \
+    TLOG_HASH_CHAR_(s, 34, 0xE4C1D8BFu) + \
+    TLOG_HASH_CHAR_(s, 35, 0x24735701u) + \
+    TLOG_HASH_CHAR_(s, 36, 0x4F63693Fu) + \
+    TLOG_HASH_CHAR_(s, 37, 0xF2B5E681u) + \
+    TLOG_HASH_CHAR_(s, 38, 0xA144B9BFu) + \
+    TLOG_HASH_CHAR_(s, 39, 0x69A8B601u) + \
+    TLOG_HASH_CHAR_(s, 40, 0xB685CA3Fu) + \
+    TLOG_HASH_CHAR_(s, 41, 0xB52BC581u) + \
+    TLOG_HASH_CHAR_(s, 42, 0x5B469ABFu) + \
+    TLOG_HASH_CHAR_(s, 43, 0x111F1501u) + \
+    TLOG_HASH_CHAR_(s, 44, 0x4BA72B3Fu) + \
+    TLOG_HASH_CHAR_(s, 45, 0xC962A481u) + \
+    TLOG_HASH_CHAR_(s, 46, 0x33C77BBFu) + \
+    TLOG_HASH_CHAR_(s, 47, 0x39D67401u) + \
+    TLOG_HASH_CHAR_(s, 48, 0xAFC78C3Fu) + \
+    TLOG_HASH_CHAR_(s, 49, 0xCE5A8381u) + \
+    TLOG_HASH_CHAR_(s, 50, 0x4BC75CBFu) + \
+    TLOG_HASH_CHAR_(s, 51, 0x02CED301u) + \
+    TLOG_HASH_CHAR_(s, 52, 0x83E6ED3Fu) + \
+    TLOG_HASH_CHAR_(s, 53, 0x63136281u) + \
+    TLOG_HASH_CHAR_(s, 54, 0xC4463DBFu) + \
+    TLOG_HASH_CHAR_(s, 55, 0x8B083201u) + \
+    TLOG_HASH_CHAR_(s, 56, 0x69054E3Fu) + \
+    TLOG_HASH_CHAR_(s, 57, 0x268D4181u) + \
+    TLOG_HASH_CHAR_(s, 58, 0xBE441EBFu) + \
+    TLOG_HASH_CHAR_(s, 59, 0xF1829101u) + \
+    TLOG_HASH_CHAR_(s, 60, 0x0022AF3Fu) + \
+    TLOG_HASH_CHAR_(s, 61, 0xB7C82081u) + \
+    TLOG_HASH_CHAR_(s, 62, 0x5AC0FFBFu) + \
+    TLOG_HASH_CHAR_(s, 63, 0x553DF001u) + \
+    TLOG_HASH_CHAR_(s, 64, 0xEA3F103Fu) + \
+    TLOG_HASH_CHAR_(s, 65, 0xB5C3FF81u) + \
+    TLOG_HASH_CHAR_(s, 66, 0xBABCE0BFu) + \
+    TLOG_HASH_CHAR_(s, 67, 0xD53A4F01u) + \
+    TLOG_HASH_CHAR_(s, 68, 0xC85A713Fu) + \
+    TLOG_HASH_CHAR_(s, 69, 0xBF80DE81u) + \
+    TLOG_HASH_CHAR_(s, 70, 0xFF37C1BFu) + \
+    TLOG_HASH_CHAR_(s, 71, 0x9077AE01u) + \
+    TLOG_HASH_CHAR_(s, 72, 0x3B74D23Fu) + \
+    TLOG_HASH_CHAR_(s, 73, 0x73FEBD81u) + \
+    TLOG_HASH_CHAR_(s, 74, 0x4931A2BFu) + \
+    TLOG_HASH_CHAR_(s, 75, 0xA5F60D01u) + \
+    TLOG_HASH_CHAR_(s, 76, 0xE48E333Fu) + \
+    TLOG_HASH_CHAR_(s, 77, 0x723D9C81u) + \
+    TLOG_HASH_CHAR_(s, 78, 0xB9AA83BFu) + \
+    TLOG_HASH_CHAR_(s, 79, 0x34B56C01u))
+
+// === Call sites ===
+
+#if TLOG_ENABLED
+
+#define TLOG_AT(level, tag, fmt, ...) do {                                                  \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                                   \
+            tlog_emit((level), (tag), TLOG_HASH(fmt), TLOG_TYPES(__VA_ARGS__), ##__VA_ARGS__); \
+        }                                                                                   \
+    } while (0)
+
+#define TLOGE(tag, fmt, ...)    TLOG_AT(ESP_LOG_ERROR,   tag, fmt, ##__VA_ARGS__)
+#define TLOGW(tag, fmt, ...)    TLOG_AT(ESP_LOG_WARN,    tag, fmt, ##__VA_ARGS__)
+#define TLOGI(tag, fmt, ...)    TLOG_AT(ESP_LOG_INFO,    tag, fmt, ##__VA_ARGS__)
+#define TLOGD(tag, fmt, ...)    TLOG_AT(ESP_LOG_DEBUG,   tag, fmt, ##__VA_ARGS__)
+#define TLOGV(tag, fmt, ...)    TLOG_AT(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+#else
+
+#define TLOGE(tag, fmt, ...)    ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#define TLOGW(tag, fmt, ...)    ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define TLOGI(tag, fmt, ...)    ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define TLOGD(tag, fmt, ...)    ESP_LOGD(tag, fmt, ##__VA_ARGS__)
+#define TLOGV(tag, fmt, ...)    ESP_LOGV(tag, fmt, ##__VA_ARGS__)
+
+#endif
+
+/**
+ * @brief Encode one record: level, format hash, timestamp (ms), tag, arguments.
+ *
+ * Pure encoding, usable on the host. Arguments that do not fit are dropped and the
+ * record is flagged as truncated.
+ *
+ * @return Encoded length (0 if cap cannot hold the header and the tag).
+ */
+size_t tlog_vencode(uint8_t *out, size_t cap, uint8_t level, const char *tag, uint32_t hash,
+                    uint32_t timestamp_ms, uint32_t types, va_list args);
+
+/**
+ * @brief Emit a record through esp_log (called by the TLOGx macros).
+ */
+void tlog_emit(esp_log_level_t level, const char *tag, uint32_t hash, uint32_t types, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TLOG_H
@@ -0,0 +1,275 @@
+// File: main/uart_input.c
+// ==========================================================================================
+// UART0 receive path: driver event queue -> byte demultiplexer -> SPSC message ring.
+// Producer: uart_input_task (the only reader of the UART). Consumer: whichever task calls
+// uart_input_get() (the CLI task, or the boot gate before the CLI starts).
+// The RX task sleeps on the event queue, so an idle console costs no wakeups.
+// ==========================================================================================
+
+#include <stdatomic.h>
+#include <string.h>
+#include "uart_input.h"
+#include "driver/uart.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define UART_INPUT_PORT         UART_NUM_0
+#define UART_INPUT_BAUD         115200
+#define UART_INPUT_RX_BUF       1024    // Driver ring buffer
+#define UART_INPUT_EVT_QUEUE    16      // Driver event queue depth
+#define UART_INPUT_PATTERN_Q    16      // Newline positions tracked by the driver
+#define UART_INPUT_CHUNK        64      // Bytes copied out of the driver per read
+#define UART_INPUT_TASK_STACK   3072
+#define UART_INPUT_TASK_PRIO    (tskIDLE_PRIORITY + 5)
+
+_Static_assert((UART_INPUT_RING_SIZE & (UART_INPUT_RING_SIZE - 1)) == 0,
+               "UART_INPUT_RING_SIZE must be a power of two");
+
+static const char *TAG = "UART_INPUT";
+
+// === Message Ring (SPSC) ===
+
+static uart_input_msg_t ring[UART_INPUT_RING_SIZE];
+static atomic_uint head;                        ///< Next slot to publish (producer)
+static atomic_uint tail;                        ///< Next slot to consume (consumer)
+static TaskHandle_t volatile consumer = NULL;   ///< Task to notify on publish
+
+// === Producer State (RX task only) ===
+
+static QueueHandle_t uart_queue = NULL;
+static TaskHandle_t rx_task = NULL;
+static cli_frame_decoder_t frame_dec;
+static size_t line_len;
+static bool line_overflow;
+static bool line_dropped;                       ///< Ring was full while this line arrived
+
+static struct {
+    atomic_uint events;
+    atomic_uint lines;
+    atomic_uint frames;
+    atomic_uint dropped;
+    atomic_uint overflows;
+    atomic_uint frame_errors;
+} stats;
+
+// === Producer Side ===
+
+/**
+ * @brief Slot being filled, or NULL if the ring is full.
+ */
+static uart_input_msg_t *ring_slot(void) {
+    unsigned h = atomic_load_explicit(&head, memory_order_relaxed);
+    unsigned t = atomic_load_explicit(&tail, memory_order_acquire);
+    return (h - t < UART_INPUT_RING_SIZE) ? &ring[h & (UART_INPUT_RING_SIZE - 1)] : NULL;
+}
+
+/**
+ * @brief Publish the current slot and wake the consumer.
+ */
+static void ring_publish(void) {
+    atomic_fetch_add_explicit(&head, 1, memory_order_release);
+    TaskHandle_t c = consumer;
+    if (c) {
+        xTaskNotifyGive(c);
+    }
+}
+
+/**
+ * @brief Split raw bytes into text lines and binary frames.
+ *
+ * Text is assembled directly in the next free ring slot, so a line is copied once.
+ * A SYNC byte between lines starts a binary frame (never valid in text). Inside a line it
+ * is just a bad text byte: starting a frame there would let the frame complete into the
+ * slot the line is being built in.
+ */
+static void uart_input_feed(const uint8_t *data, size_t len, uint32_t rx_us) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+
+        if (cli_frame_decoder_busy(&frame_dec) || (b == CLI_FRAME_SYNC && line_len == 0)) {
+            switch (cli_frame_decode_byte(&frame_dec, b)) {
+                case CLI_FRAME_COMPLETE: {
+                    uart_input_msg_t *m = ring_slot();
+                    if (!m) {
+                        atomic_fetch_add_explicit(&stats.dropped, 1, memory_order_relaxed);
+                        break;
+                    }
+                    m->type = UART_INPUT_FRAME;
+                    m->rx_us = rx_us;
+                    m->frame = frame_dec.frame;
+                    ring_publish();
+                    atomic_fetch_add_explicit(&stats.frames, 1, memory_order_relaxed);
+                    break;
+                }
+                case CLI_FRAME_CRC_ERROR:
+                case CLI_FRAME_TOO_LONG:
+                    atomic_fetch_add_explicit(&stats.frame_errors, 1, memory_order_relaxed);
+                    break;
+                default:
+                    break;
+            }
+            continue;
+        }
+
+        uart_input_msg_t *m = ring_slot();
+
+        if (b == '\r' || b == '\n') {
+            if (line_overflow) {
+                atomic_fetch_add_explicit(&stats.overflows, 1, memory_order_relaxed);
+            } else if (line_len > 0) {
+                if (m && !line_dropped) {
+                    m->type = UART_INPUT_LINE;
+                    m->rx_us = rx_us;
+                    m->line[line_len] = '\0';
+                    ring_publish();
+                    atomic_fetch_add_explicit(&stats.lines, 1, memory_order_relaxed);
+                } else {
+                    atomic_fetch_add_explicit(&stats.dropped, 1, memory_order_relaxed);
+                }
+            }
+            line_len = 0;
+            line_overflow = false;
+            line_dropped = false;
+        } else if (line_len < UART_INPUT_LINE_MAX) {
+            if (m) {
+                m->line[line_len] = (char)b;
+            } else {
+                line_dropped = true;
+            }
+            line_len++;
+        } else {
+            line_overflow = true;
+        }
+    }
+}
+
+/**
+ * @brief Copy everything the driver has buffered into the demultiplexer.
+ */
+static void uart_input_drain(uint32_t rx_us) {
+    uint8_t chunk[UART_INPUT_CHUNK];
+    size_t avail = 0;
+
+    uart_get_buffered_data_len(UART_INPUT_PORT, &avail);
+    while (avail > 0) {
+        int n = uart_read_bytes(UART_INPUT_PORT, chunk,
+                                avail < sizeof(chunk) ? avail : sizeof(chunk), 0);
+        if (n <= 0) {
+            break;
+        }
+        uart_input_feed(chunk, (size_t)n, rx_us);
+        avail -= (size_t)n;
+    }
+
+    // Positions were consumed along with the data; keep the driver's pattern queue empty
+    while (uart_pattern_pop_pos(UART_INPUT_PORT) != -1) {
+    }
+}
+
+/**
+ * @brief RX task: blocks on the driver event queue, never on a timeout.
+ */
+static void uart_input_task(void *arg) {
+    uart_event_t ev;
+
+    for (;;) {
+        if (xQueueReceive(uart_queue, &ev, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        uint32_t rx_us = (uint32_t)esp_timer_get_time();
+        atomic_fetch_add_explicit(&stats.events, 1, memory_order_relaxed);
+
+        switch (ev.type) {
+            case UART_DATA:
+            case UART_PATTERN_DET:
+                uart_input_drain(rx_us);
+                break;
+
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                // Input was lost: resynchronize on the next line/frame
+                uart_flush_input(UART_INPUT_PORT);
+                xQueueReset(uart_queue);
+                cli_frame_decoder_reset(&frame_dec);
+                line_len = 0;
+                line_overflow = true;
+                atomic_fetch_add_explicit(&stats.overflows, 1, memory_order_relaxed);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+// === Public API ===
+
+esp_err_t uart_input_init(void) {
+    if (rx_task) {
+        return ESP_OK;
+    }
+
+    uart_config_t uart_config = {
+        .baud_rate = UART_INPUT_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    esp_err_t err = uart_driver_install(UART_INPUT_PORT, UART_INPUT_RX_BUF, 0,
+                                        UART_INPUT_EVT_QUEUE, &uart_queue, 0);
+    if (err == ESP_OK) {
+        err = uart_param_config(UART_INPUT_PORT, &uart_config);
+    }
+    if (err == ESP_OK) {
+        // One '\n' raises UART_PATTERN_DET right away instead of waiting for the RX timeout
+        err = uart_enable_pattern_det_baud_intr(UART_INPUT_PORT, '\n', 1, 9, 0, 0);
+    }
+    if (err == ESP_OK) {
+        err = uart_pattern_queue_reset(UART_INPUT_PORT, UART_INPUT_PATTERN_Q);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "UART setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    cli_frame_decoder_reset(&frame_dec);
+    if (xTaskCreate(uart_input_task, "uart_rx", UART_INPUT_TASK_STACK, NULL,
+                    UART_INPUT_TASK_PRIO, &rx_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create UART RX task");
+        rx_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool uart_input_get(uart_input_msg_t *out, TickType_t timeout) {
+    consumer = xTaskGetCurrentTaskHandle();
+
+    for (;;) {
+        unsigned t = atomic_load_explicit(&tail, memory_order_relaxed);
+        unsigned h = atomic_load_explicit(&head, memory_order_acquire);
+
+        if (t != h) {
+            *out = ring[t & (UART_INPUT_RING_SIZE - 1)];
+            atomic_store_explicit(&tail, t + 1, memory_order_release);
+            return true;
+        }
+        // Notifications are counted, so a publish between the check and here is not lost
+        if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            return false;
+        }
+    }
+}
+
+void uart_input_take_stats(uart_input_stats_t *out) {
+    out->events = atomic_exchange(&stats.events, 0);
+    out->lines = atomic_exchange(&stats.lines, 0);
+    out->frames = atomic_exchange(&stats.frames, 0);
+    out->dropped = atomic_exchange(&stats.dropped, 0);
+    out->overflows = atomic_exchange(&stats.overflows, 0);
+    out->frame_errors = atomic_exchange(&stats.frame_errors, 0);
+}
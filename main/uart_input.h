@@ -0,0 +1,82 @@
+// File: main/uart_input.h
+// ==========================================================================================
+// Event-driven UART0 input.
+// A high-priority task blocks on the UART driver's event queue (no polling). Newline
+// pattern detection raises an event as soon as a line ends instead of after the RX
+// timeout. Bytes are split into text lines and binary CLI frames, and each complete
+// message is published into a preallocated ring. The consumer gets a task notification.
+// ==========================================================================================
+
+#ifndef UART_INPUT_H
+#define UART_INPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "cli_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UART_INPUT_LINE_MAX     128     // Longest text line (longer lines are dropped)
+#define UART_INPUT_RING_SIZE    8       // Messages buffered for the consumer (power of two)
+
+/**
+ * @brief Kind of message in the ring.
+ */
+typedef enum {
+    UART_INPUT_LINE,        /**< Text line, NUL-terminated, without CR/LF */
+    UART_INPUT_FRAME,       /**< CRC-checked binary frame */
+} uart_input_type_t;
+
+/**
+ * @brief One complete input message.
+ */
+typedef struct {
+    uint8_t  type;                          ///< uart_input_type_t
+    uint32_t rx_us;                         ///< esp_timer time of the UART event that completed it
+    union {
+        char        line[UART_INPUT_LINE_MAX + 1];
+        cli_frame_t frame;
+    };
+} uart_input_msg_t;
+
+/**
+ * @brief Receive-side counters.
+ */
+typedef struct {
+    uint32_t events;        ///< UART driver events handled (= RX task wakeups)
+    uint32_t lines;         ///< Text lines published
+    uint32_t frames;        ///< Binary frames published
+    uint32_t dropped;       ///< Messages lost because the ring was full
+    uint32_t overflows;     ///< Lines too long, or driver FIFO/buffer overflows
+    uint32_t frame_errors;  ///< Frames with bad CRC or length
+} uart_input_stats_t;
+
+/**
+ * @brief Configure UART0, install the driver with an event queue and newline
+ *        pattern detection, and start the RX task. Safe to call more than once.
+ */
+esp_err_t uart_input_init(void);
+
+/**
+ * @brief Wait for the next complete message (single consumer task at a time).
+ *
+ * The calling task becomes the one notified when messages arrive.
+ *
+ * @return true if `out` was filled, false on timeout.
+ */
+bool uart_input_get(uart_input_msg_t *out, TickType_t timeout);
+
+/**
+ * @brief Snapshot and reset the counters.
+ */
+void uart_input_take_stats(uart_input_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UART_INPUT_H
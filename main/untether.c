@@ -0,0 +1,281 @@
+// File: main/untether.c
+// ==========================================================================================
+// Untethered upload task: upload_proto batch uploader <- segment files via the catalog
+// (seg_source), -> esp_http_client on one kept-alive connection over Wi-Fi (wifi_sta).
+// The task idles on a notification between sessions; the radio is on only during one.
+// The cursor is saved to NVS after every answered POST (one small write per batch), so
+// a reset or a power loss costs at most the batch in flight.
+// ==========================================================================================
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "untether.h"
+#include "seg_source.h"
+#include "sd_log.h"
+#include "wifi_sta.h"
+#include "nvs_helper.h"
+#include "state_machine.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define UNTETHER_TASK_STACK     4096    // esp_http_client + lwIP calls
+#define UNTETHER_TASK_PRIO      (tskIDLE_PRIORITY + 1)
+#define UNTETHER_WIFI_MS        15000   // Join + DHCP
+#define UNTETHER_HTTP_MS        10000   // Per socket operation
+#define UNTETHER_CURSOR_KEY     "up_cursor"
+
+static const char *TAG = "UNTETHER";
+
+static TaskHandle_t task = NULL;
+static atomic_bool cancel;
+static untether_config_t config;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static untether_stats_t stats;          ///< stats.cursor is the cursor (under stats_lock)
+static const upload_t *live;            ///< Session in progress (under stats_lock)
+
+// === Link: esp_http_client ===
+
+static esp_http_client_handle_t client;
+
+static bool http_begin(void *ctx) {
+    if (!client) {
+        esp_http_client_config_t cfg = {
+            .url = config.url,
+            .method = HTTP_METHOD_POST,
+            .timeout_ms = UNTETHER_HTTP_MS,
+            .keep_alive_enable = true,
+        };
+        client = esp_http_client_init(&cfg);
+        if (!client) {
+            return false;
+        }
+        esp_http_client_set_header(client, "Content-Type", "application/octet-stream");
+        esp_http_client_set_header(client, "X-Device", config.device);
+    }
+    return esp_http_client_open(client, -1) == ESP_OK;     // -1: Transfer-Encoding chunked
+}
+
+static bool http_write(void *ctx, const uint8_t *data, size_t len) {
+    return esp_http_client_write(client, (const char *)data, (int)len) == (int)len;
+}
+
+static int http_finish(void *ctx, char *body, size_t cap) {
+    if (esp_http_client_fetch_headers(client) < 0) {
+        return -1;
+    }
+    int n = esp_http_client_read_response(client, body, (int)cap - 1);
+    if (n < 0) {
+        return -1;
+    }
+    body[n] = '\0';
+    esp_http_client_flush_response(client, NULL);      // Anything past cap
+    return esp_http_client_get_status_code(client);
+}
+
+static void http_reset(void *ctx) {
+    if (client) {
+        esp_http_client_close(client);
+    }
+}
+
+static uint32_t link_now_ms(void *ctx) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void link_sleep_ms(void *ctx, uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms) + 1);
+}
+
+static bool link_cancelled(void *ctx) {
+    return atomic_load(&cancel);
+}
+
+static void link_checkpoint(void *ctx, const upload_cursor_t *cursor) {
+    taskENTER_CRITICAL(&stats_lock);
+    stats.cursor = *cursor;
+    taskEXIT_CRITICAL(&stats_lock);
+    nvs_state_store(UNTETHER_CURSOR_KEY, cursor, sizeof(*cursor));
+}
+
+static const upload_link_t http_link = {
+    .begin = http_begin,
+    .write = http_write,
+    .finish = http_finish,
+    .reset = http_reset,
+    .now_ms = link_now_ms,
+    .sleep_ms = link_sleep_ms,
+    .cancelled = link_cancelled,
+    .checkpoint = link_checkpoint,
+};
+
+// === Session ===
+
+static upload_result_t untether_session(upload_t *u, uint8_t *buf) {
+    sd_log_stats_t sd;
+    seg_source_t src_ctx = { 0 };
+    xfer_source_t src;
+    upload_cursor_t cursor = untether_cursor();
+
+    if (!config.url[0]) {
+        ESP_LOGE(TAG, "No transfer.upload_url configured");
+        return UPLOAD_ERR_SERVER;
+    }
+    sd_log_get_stats(&sd);
+    if (!sd.mounted || !seg_source_open(&src_ctx, &src, SD_LOG_ROOT, cursor.seg_id)) {
+        seg_source_close(&src_ctx);
+        ESP_LOGE(TAG, "No log store on the card");
+        return UPLOAD_ERR_SOURCE;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = wifi_sta_connect(UNTETHER_WIFI_MS);
+    wifi_sta_stats_t wifi;
+    wifi_sta_get_stats(&wifi, false);
+    taskENTER_CRITICAL(&stats_lock);
+    stats.wifi_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+    stats.wifi_path = err == ESP_OK ? wifi.connect.last_path : WIFI_PATH_NONE;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    upload_result_t r = UPLOAD_ERR_LINK;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Wi-Fi: %s", esp_err_to_name(err));
+    } else {
+        upload_params_t p = {
+            .chunk = config.chunk_bytes,
+            .batch = (uint32_t)config.batch_kb * 1024,
+            .retries = config.retries,
+        };
+        r = upload_run(u, &p, &http_link, &src, &cursor, buf);
+    }
+
+    if (client) {
+        esp_http_client_cleanup(client);
+        client = NULL;
+    }
+    wifi_sta_disconnect();
+    seg_source_close(&src_ctx);
+    return r;
+}
+
+static void untether_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        upload_t *u = calloc(1, sizeof(*u));
+        uint8_t *buf = malloc(UPLOAD_BUF_SIZE(config.chunk_bytes));
+        if (!u || !buf) {
+            ESP_LOGE(TAG, "No memory for a session (%u bytes)",
+                     (unsigned)(sizeof(*u) + UPLOAD_BUF_SIZE(config.chunk_bytes)));
+            free(u);
+            free(buf);
+            state_machine_post_event(config.tether_fallback ? EVENT_TRANSFER_FAILED : EVENT_TIMEOUT);
+            continue;
+        }
+        taskENTER_CRITICAL(&stats_lock);
+        stats.running = true;
+        stats.sessions++;
+        live = u;
+        upload_cursor_t from = stats.cursor;
+        taskEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGI(TAG, "Session started at segment %u + %u: %u KB per POST, %u B chunks",
+                 (unsigned)from.seg_id, (unsigned)from.offset, (unsigned)config.batch_kb,
+                 (unsigned)config.chunk_bytes);
+        upload_result_t r = untether_session(u, buf);
+        const upload_stats_t *x = &u->stats;
+
+        taskENTER_CRITICAL(&stats_lock);
+        stats.running = false;
+        stats.result = r;
+        stats.completed += (r == UPLOAD_OK);
+        stats.upload = *x;
+        live = NULL;
+        taskEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGI(TAG, "Session %s: %u files (%u bad), %u KB in %u ms (%u KB/s), %u requests, "
+                 "%u failed, Wi-Fi up in %u ms (%s)",
+                 upload_result_str(r), (unsigned)x->files, (unsigned)x->bad,
+                 (unsigned)(x->bytes >> 10), (unsigned)x->elapsed_ms,
+                 x->elapsed_ms ? (unsigned)(x->bytes / x->elapsed_ms * 1000 >> 10) : 0,
+                 (unsigned)x->requests, (unsigned)x->failures, (unsigned)stats.wifi_ms,
+                 wifi_path_str(stats.wifi_path));
+        free(buf);
+        free(u);
+
+        if (r == UPLOAD_OK) {
+            state_machine_post_event(EVENT_TRANSFER_COMPLETE);
+        } else if (r != UPLOAD_ERR_CANCELLED) {
+            state_machine_post_event(config.tether_fallback ? EVENT_TRANSFER_FAILED : EVENT_TIMEOUT);
+        }
+    }
+}
+
+// === Public API ===
+
+esp_err_t untether_init(const untether_config_t *cfg) {
+    if (task) {
+        return ESP_OK;
+    }
+    config = *cfg;
+    if (config.chunk_bytes == 0) {
+        config.chunk_bytes = 1024;
+    }
+    stats.wifi_path = WIFI_PATH_NONE;
+    if (nvs_state_load(UNTETHER_CURSOR_KEY, &stats.cursor, sizeof(stats.cursor)) != ESP_OK) {
+        stats.cursor = (upload_cursor_t){ 0 };
+    }
+
+    if (xTaskCreate(untether_task, "untether", UNTETHER_TASK_STACK, NULL,
+                    UNTETHER_TASK_PRIO, &task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create untether task");
+        task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void untether_start(void) {
+    if (!task) {
+        ESP_LOGW(TAG, "Not initialised: no upload");
+        state_machine_post_event(EVENT_TRANSFER_FAILED);
+        return;
+    }
+    atomic_store(&cancel, false);   // A stop before the task wakes still cancels
+    xTaskNotifyGive(task);
+}
+
+void untether_stop(void) {
+    atomic_store(&cancel, true);
+}
+
+upload_cursor_t untether_cursor(void) {
+    taskENTER_CRITICAL(&stats_lock);
+    upload_cursor_t c = stats.cursor;
+    taskEXIT_CRITICAL(&stats_lock);
+    return c;
+}
+
+esp_err_t untether_rewind(void) {
+    upload_cursor_t zero = { 0 };
+
+    taskENTER_CRITICAL(&stats_lock);
+    bool running = stats.running;
+    if (!running) {
+        stats.cursor = zero;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    return running ? ESP_ERR_INVALID_STATE : nvs_state_store(UNTETHER_CURSOR_KEY, &zero, sizeof(zero));
+}
+
+void untether_get_stats(untether_stats_t *out) {
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    if (live) {
+        out->upload = live->stats;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
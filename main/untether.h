@@ -0,0 +1,87 @@
+// File: main/untether.h
+// ==========================================================================================
+// Untethered log upload. On entry to UNTETHERED, a session joins Wi-Fi and uploads every
+// closed log segment after the saved cursor to transfer.upload_url in batched POSTs
+// (upload_proto.h). It then posts EVENT_TRANSFER_COMPLETE. If the upload cannot finish
+// (no network, server gone for good) it posts EVENT_TRANSFER_FAILED, which falls back to
+// TETHERED, or EVENT_TIMEOUT (back to OPERATIONAL) if transfer.tether_fallback is off.
+// The cursor is kept in NVS, so the next upload (or the USB session taking over) starts
+// where the server's copy ends. The stand-in server is tools/upload_server.py.
+// ==========================================================================================
+
+#ifndef UNTETHER_H
+#define UNTETHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "upload_proto.h"
+#include "wifi_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Session counters (printed by the untether CLI command).
+ */
+typedef struct {
+    bool            running;    ///< A session is in progress (upload counts are live)
+    uint32_t        sessions;   ///< Sessions started since boot
+    uint32_t        completed;  ///< Of those, ended with UPLOAD_OK
+    upload_result_t result;     ///< Outcome of the last finished session
+    uint32_t        wifi_ms;    ///< Time to join Wi-Fi in the last session
+    wifi_path_t     wifi_path;  ///< How it was joined (cached AP or a scan)
+    upload_cursor_t cursor;     ///< Where the server's copy ends
+    upload_stats_t  upload;     ///< Current session, or the last one
+} untether_stats_t;
+
+/**
+ * @brief Upload settings (the transfer config section).
+ */
+typedef struct {
+    const char *url;            ///< transfer.upload_url (kept by reference)
+    const char *device;         ///< device.name, sent as X-Device (kept by reference)
+    uint32_t    chunk_bytes;    ///< transfer.chunk_bytes
+    uint16_t    batch_kb;       ///< transfer.batch_kb
+    uint8_t     retries;        ///< transfer.retries
+    bool        tether_fallback;
+} untether_config_t;
+
+/**
+ * @brief Load the cursor and start the (idle) upload task. Sessions run on untether_start().
+ */
+esp_err_t untether_init(const untether_config_t *cfg);
+
+/**
+ * @brief Begin a session (UNTETHERED entry). Never blocks.
+ */
+void untether_start(void);
+
+/**
+ * @brief Cancel the running session (UNTETHERED exit). No event is posted for it.
+ */
+void untether_stop(void);
+
+/**
+ * @brief Where the server's copy ends (the USB session starts there after a fallback).
+ */
+upload_cursor_t untether_cursor(void);
+
+/**
+ * @brief Forget the cursor: the next upload starts from the oldest segment on the card.
+ *
+ * @return ESP_ERR_INVALID_STATE while a session runs.
+ */
+esp_err_t untether_rewind(void);
+
+/**
+ * @brief Snapshot of the counters.
+ */
+void untether_get_stats(untether_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UNTETHER_H
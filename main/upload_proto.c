@@ -0,0 +1,304 @@
+// File: main/upload_proto.c
+// ==========================================================================================
+// Batch uploader (see upload_proto.h). The queue holds the files of the next POST and how
+// much of each the server has; a POST sends a prefix of it, up to p.batch file bytes, and
+// the server's answer moves each file's offset (forward, or back if the server lost
+// data). A failed POST changes nothing, so the retry simply sends the same batch again.
+// An answered POST that moves no offset (the server kept nothing and lost nothing, or left
+// every record out) counts as a failed one too, so a server stuck that way cannot hold the
+// session in a loop: it backs off and ends after p.retries like a dead link.
+// File bytes are read into the chunk buffer behind room for the chunk-size line, so each
+// HTTP chunk goes out in a single write.
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "upload_proto.h"
+
+// === Helpers ===
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t now(const upload_t *u) {
+    return u->link->now_ms(u->link->ctx);
+}
+
+static bool cancelled(const upload_t *u) {
+    return u->link->cancelled && u->link->cancelled(u->link->ctx);
+}
+
+// === Body ===
+
+/**
+ * @brief Frame the `len` bytes at buf + UPLOAD_CHUNK_PREFIX as one HTTP chunk and send it.
+ */
+static bool send_chunk(upload_t *u, size_t len) {
+    char line[UPLOAD_CHUNK_PREFIX + 1];
+    int n = snprintf(line, sizeof(line), "%x\r\n", (unsigned)len);
+    uint8_t *start = u->buf + UPLOAD_CHUNK_PREFIX - n;
+
+    memcpy(start, line, (size_t)n);
+    memcpy(u->buf + UPLOAD_CHUNK_PREFIX + len, "\r\n", 2);
+    u->stats.sent += (size_t)n + len + 2;
+    return u->link->write(u->link->ctx, start, (size_t)n + len + 2);
+}
+
+/**
+ * @brief One record: header in the first chunk, then the file slice chunk by chunk.
+ */
+static upload_result_t send_record(upload_t *u, const upload_entry_t *e) {
+    uint8_t *p = u->buf + UPLOAD_CHUNK_PREFIX;
+    size_t hdr = UPLOAD_REC_HDR;
+    uint32_t off = e->have, left = e->len;
+
+    put32(p, UPLOAD_MAGIC);
+    put32(p + 4, e->f.id);
+    put32(p + 8, e->f.size);
+    put32(p + 12, e->f.tag);
+    put32(p + 16, e->have);
+    put32(p + 20, e->len);
+    do {
+        uint32_t n = left < u->p.chunk ? left : u->p.chunk;
+        if (cancelled(u)) {
+            return UPLOAD_ERR_CANCELLED;
+        }
+        if (n && !u->src->read(u->src->ctx, &e->f, off, p + hdr, n)) {
+            return UPLOAD_ERR_SOURCE;
+        }
+        if (!send_chunk(u, hdr + n)) {
+            return UPLOAD_ERR_LINK;
+        }
+        hdr = 0;
+        off += n;
+        left -= n;
+    } while (left > 0);
+    return UPLOAD_OK;
+}
+
+// === Batch ===
+
+/**
+ * @brief Queue files from the source until the queue covers a whole batch.
+ */
+static void refill(upload_t *u) {
+    uint64_t queued = 0;
+
+    for (uint8_t i = 0; i < u->count; i++) {
+        queued += u->queue[i].f.size - u->queue[i].have;
+    }
+    while (!u->source_done && u->count < UPLOAD_QUEUE_MAX && queued < u->p.batch) {
+        upload_entry_t *e = &u->queue[u->count];
+        if (!u->src->next(u->src->ctx, &e->f)) {
+            u->source_done = true;      // Segments closed from now on wait for the next session
+            break;
+        }
+        const upload_cursor_t *c = &u->cursor;
+        e->have = e->f.id == c->seg_id && e->f.tag == c->tag && c->offset <= e->f.size ? c->offset : 0;
+        e->len = 0;
+        queued += e->f.size - e->have;
+        u->count++;
+    }
+}
+
+/**
+ * @brief Apply the server's answer: new offsets, finished files out of the queue.
+ *
+ * @param moved Set when at least one posted file's offset changed (forward or back).
+ */
+static upload_result_t apply(upload_t *u, bool *moved) {
+    bool seen[UPLOAD_QUEUE_MAX] = { false };
+    const char *line = u->resp;
+
+    while (*line) {
+        char *end;
+        unsigned long id = strtoul(line, &end, 10);
+        unsigned long have = strtoul(end, &end, 10);
+        while (*end == ' ') {
+            end++;
+        }
+        bool bad = strncmp(end, "bad", 3) == 0;
+
+        for (uint8_t i = 0; i < u->posted; i++) {
+            upload_entry_t *e = &u->queue[i];
+            if (e->f.id != id || seen[i]) {
+                continue;
+            }
+            if (have > e->f.size) {
+                return UPLOAD_ERR_SERVER;
+            }
+            if (have != e->have + e->len) {
+                u->stats.rewinds++;
+            }
+            if (have > e->have) {
+                u->stats.bytes += have - e->have;
+            }
+            *moved |= have != e->have;
+            e->have = (uint32_t)have;
+            seen[i] = true;
+            if (have == e->f.size) {
+                u->stats.files++;
+                u->stats.bad += bad;
+            }
+            break;
+        }
+        line = strchr(end, '\n');
+        if (!line) {
+            break;
+        }
+        line++;
+    }
+
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < u->count; i++) {
+        upload_entry_t *e = &u->queue[i];
+        if (i < u->posted && !seen[i]) {
+            u->stats.rewinds++;         // Not answered: send it again from the same offset
+        }
+        if (e->have < e->f.size) {
+            u->queue[kept++] = *e;
+        } else {
+            u->cursor = (upload_cursor_t){ .seg_id = e->f.id + 1 };
+        }
+    }
+    u->count = kept;
+    if (kept) {
+        u->cursor = (upload_cursor_t){ u->queue[0].f.id, u->queue[0].have, u->queue[0].f.tag };
+    }
+    return UPLOAD_OK;
+}
+
+/**
+ * @brief One POST: records for up to p.batch file bytes, then the server's answer.
+ *
+ * @param moved See apply(); false unless the POST was answered.
+ * @return UPLOAD_ERR_LINK for anything worth retrying (no connection, 5xx, 408, 429).
+ */
+static upload_result_t post_batch(upload_t *u, bool *moved) {
+    static const uint8_t last[] = "0\r\n\r\n";
+    uint32_t budget = u->p.batch;
+
+    *moved = false;
+    if (!u->link->begin(u->link->ctx)) {
+        return UPLOAD_ERR_LINK;
+    }
+    u->posted = 0;
+    for (uint8_t i = 0; i < u->count && budget > 0; i++) {
+        upload_entry_t *e = &u->queue[i];
+        uint32_t left = e->f.size - e->have;
+        e->len = left < budget ? left : budget;
+        budget -= e->len;
+        u->posted++;
+        upload_result_t r = send_record(u, e);
+        if (r != UPLOAD_OK) {
+            return r;
+        }
+    }
+    u->stats.sent += sizeof(last) - 1;
+    if (!u->link->write(u->link->ctx, last, sizeof(last) - 1)) {
+        return UPLOAD_ERR_LINK;
+    }
+
+    int status = u->link->finish(u->link->ctx, u->resp, sizeof(u->resp));
+    if (status < 0 || status >= 500 || status == 408 || status == 429) {
+        return UPLOAD_ERR_LINK;
+    }
+    if (status != 200) {
+        return UPLOAD_ERR_SERVER;
+    }
+    u->stats.requests++;
+    return apply(u, moved);
+}
+
+/**
+ * @brief Exponential backoff with jitter, so devices that lost the same access point do
+ *        not all retry in step. Returns false if cancelled meanwhile.
+ */
+static bool backoff(upload_t *u, uint8_t fails) {
+    uint32_t ms = UPLOAD_BACKOFF_MIN_MS << (fails < 5 ? fails - 1 : 4);
+
+    if (ms > UPLOAD_BACKOFF_MAX_MS) {
+        ms = UPLOAD_BACKOFF_MAX_MS;
+    }
+    ms = ms / 2 + (now(u) * 2654435761u >> 16) % (ms / 2 + 1);
+    u->stats.backoff_ms += ms;
+    for (uint32_t waited = 0; waited < ms; waited += 100) {
+        if (cancelled(u)) {
+            return false;
+        }
+        u->link->sleep_ms(u->link->ctx, ms - waited < 100 ? ms - waited : 100);
+    }
+    return true;
+}
+
+// === Public API ===
+
+const char *upload_result_str(upload_result_t r) {
+    static const char *const names[] = { "OK", "LINK", "SERVER", "SOURCE", "CANCELLED" };
+    return (unsigned)r < sizeof(names) / sizeof(names[0]) ? names[r] : "?";
+}
+
+upload_result_t upload_run(upload_t *u, const upload_params_t *p, const upload_link_t *link,
+                           const xfer_source_t *src, upload_cursor_t *cursor, uint8_t *buf) {
+    upload_result_t r = UPLOAD_OK;
+    uint8_t fails = 0;
+
+    memset(u, 0, sizeof(*u));
+    u->p = *p;
+    if (u->p.chunk == 0) {
+        u->p.chunk = 1;
+    }
+    if (u->p.batch == 0) {
+        u->p.batch = u->p.chunk;
+    }
+    u->link = link;
+    u->src = src;
+    u->cursor = *cursor;
+    u->buf = buf;
+    uint32_t start = now(u);
+
+    for (;;) {
+        if (cancelled(u)) {
+            r = UPLOAD_ERR_CANCELLED;
+            break;
+        }
+        refill(u);
+        if (u->count == 0) {
+            break;
+        }
+        bool moved;
+        r = post_batch(u, &moved);
+        if (r == UPLOAD_OK) {
+            if (link->checkpoint) {
+                link->checkpoint(link->ctx, &u->cursor);
+            }
+            if (moved) {
+                fails = 0;
+                continue;
+            }
+            u->stats.stalls++;          // Answered, but nothing moved: retried like a failure
+            r = UPLOAD_ERR_SERVER;
+        } else {
+            link->reset(link->ctx);     // Mid-request or unanswered: the connection is unusable
+            if (r != UPLOAD_ERR_LINK) {
+                break;
+            }
+        }
+        u->stats.failures++;
+        if (++fails > u->p.retries) {
+            break;
+        }
+        if (!backoff(u, fails)) {
+            r = UPLOAD_ERR_CANCELLED;
+            break;
+        }
+    }
+    *cursor = u->cursor;
+    u->stats.elapsed_ms = now(u) - start;
+    return r;
+}
@@ -0,0 +1,154 @@
+// File: main/upload_proto.h
+// ==========================================================================================
+// Batched log upload over HTTP (Wi-Fi on the device, a local socket in host tests).
+// Per-record requests would be dominated by TLS and HTTP overhead, so whole segments go
+// out back to back in large POSTs on one kept-alive connection:
+//
+//   POST <upload_url>   Transfer-Encoding: chunked
+//     body:  record*    record = header (6 x u32 LE: magic, file, size, tag, offset, len)
+//                                + len bytes of the file from offset
+//   200 OK             one text line per record: "<file> <have> <part|ok|bad>"
+//
+// A record is a slice of one file; a file longer than the batch continues in the next
+// POST. The server appends a record only at the offset it already has (anything else is
+// answered with its offset and skipped), so the device never needs to ask first: it
+// starts from its saved cursor and follows whatever the server reports. A failed POST is
+// retried from the same place after an exponential backoff, and so is an answer that
+// moves no file's offset; when the retries run out the cursor is left where the server's
+// last answer put it, for the caller to save and the USB path to continue from. Segments are already LZ-compressed per block on the card
+// (log.compress), so records carry the file bytes as stored.
+// Pure C, no ESP-IDF includes; the uploader also builds on the host for tests.
+// ==========================================================================================
+
+#ifndef UPLOAD_PROTO_H
+#define UPLOAD_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "xfer_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPLOAD_MAGIC            0x31505554u     // "TUP1"
+#define UPLOAD_REC_HDR          24              // Record header bytes
+#define UPLOAD_QUEUE_MAX        32              // Files in one batch at most
+#define UPLOAD_RESP_MAX         (UPLOAD_QUEUE_MAX * 28 + 1)     // 32 answer lines
+#define UPLOAD_CHUNK_PREFIX     8               // "xxxxx\r\n" in front of an HTTP chunk
+#define UPLOAD_BUF_SIZE(chunk)  (UPLOAD_CHUNK_PREFIX + UPLOAD_REC_HDR + (chunk) + 2)
+
+#define UPLOAD_BACKOFF_MIN_MS   500
+#define UPLOAD_BACKOFF_MAX_MS   8000
+
+/**
+ * @brief Session outcome.
+ */
+typedef enum {
+    UPLOAD_OK = 0,
+    UPLOAD_ERR_LINK,            /**< No connection or no answer, retries used up */
+    UPLOAD_ERR_SERVER,          /**< Server refused the upload (4xx, a bad answer, or answers
+                                     that took nothing until the retries ran out) */
+    UPLOAD_ERR_SOURCE,          /**< File could not be read */
+    UPLOAD_ERR_CANCELLED,
+} upload_result_t;
+
+/**
+ * @brief Where the server's copy ends: every file before seg_id, plus `offset` bytes of
+ *        seg_id if its content still has `tag`.
+ */
+typedef struct {
+    uint32_t seg_id;
+    uint32_t offset;
+    uint32_t tag;
+} upload_cursor_t;
+
+/**
+ * @brief HTTP client for one kept-alive connection, plus time and persistence hooks.
+ */
+typedef struct {
+    void *ctx;
+    /** Send the headers of a chunked POST, connecting first if needed. */
+    bool (*begin)(void *ctx);
+    /** Body bytes (already chunk-framed). */
+    bool (*write)(void *ctx, const uint8_t *data, size_t len);
+    /** Read the answer into body (NUL-terminated). Returns the HTTP status, < 0 if none. */
+    int  (*finish)(void *ctx, char *body, size_t cap);
+    /** Drop the connection after an error; the next begin() reconnects. */
+    void (*reset)(void *ctx);
+    uint32_t (*now_ms)(void *ctx);
+    void (*sleep_ms)(void *ctx, uint32_t ms);
+    /** Polled between chunks; may be NULL. */
+    bool (*cancelled)(void *ctx);
+    /** Called with the new cursor after every answered POST; may be NULL. */
+    void (*checkpoint)(void *ctx, const upload_cursor_t *cursor);
+} upload_link_t;
+
+/**
+ * @brief Session parameters.
+ */
+typedef struct {
+    uint32_t chunk;             ///< File bytes per HTTP chunk (transfer.chunk_bytes)
+    uint32_t batch;             ///< File bytes per POST (transfer.batch_kb)
+    uint8_t  retries;           ///< Failed POSTs in a row before giving up
+} upload_params_t;
+
+/**
+ * @brief Session counters.
+ */
+typedef struct {
+    uint32_t files;             ///< Files the server completed this session
+    uint32_t bad;               ///< Of those, failed the server's check (kept aside there)
+    uint64_t bytes;             ///< File bytes the server took
+    uint64_t sent;              ///< Body bytes put on the link, framing and retries included
+    uint32_t requests;          ///< POSTs answered
+    uint32_t failures;          ///< POSTs that failed (each followed by a backoff)
+    uint32_t stalls;            ///< Of those, answered but moved no offset
+    uint32_t rewinds;           ///< Records the server did not take at the offset sent
+    uint32_t backoff_ms;        ///< Time spent waiting between retries
+    uint32_t elapsed_ms;
+} upload_stats_t;
+
+/**
+ * @brief A file of the batch and how much of it the server has.
+ */
+typedef struct {
+    xfer_file_t f;
+    uint32_t    have;
+    uint32_t    len;            ///< Bytes in the POST being sent
+} upload_entry_t;
+
+/**
+ * @brief Session state (caller-allocated; the chunk buffer is passed separately).
+ */
+typedef struct {
+    upload_params_t p;
+    const upload_link_t *link;
+    const xfer_source_t *src;
+    upload_stats_t stats;
+    upload_cursor_t cursor;
+    upload_entry_t queue[UPLOAD_QUEUE_MAX];
+    uint8_t  count;
+    uint8_t  posted;            ///< Entries in the POST being sent (a prefix of queue)
+    bool     source_done;
+    uint8_t *buf;               ///< UPLOAD_BUF_SIZE(p.chunk) bytes
+    char     resp[UPLOAD_RESP_MAX];
+} upload_t;
+
+const char *upload_result_str(upload_result_t r);
+
+/**
+ * @brief Upload every file `src` offers, starting at `cursor` (updated on return).
+ *
+ * `src` must start at cursor->seg_id. Returns once the source is exhausted and the server
+ * has everything, or on the first error that retrying cannot fix.
+ */
+upload_result_t upload_run(upload_t *u, const upload_params_t *p, const upload_link_t *link,
+                           const xfer_source_t *src, upload_cursor_t *cursor, uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UPLOAD_PROTO_H
@@ -0,0 +1,147 @@
+// File: main/wifi_cache.c
+// ==========================================================================================
+// Reconnect policy (see wifi_cache.h). Each step only runs while the connect's time budget
+// lasts; a directed join gets at most WIFI_CACHE_DIRECTED_MS of it, so a stale entry
+// costs a few seconds once rather than the whole budget.
+// ==========================================================================================
+
+#include <string.h>
+#include "wifi_cache.h"
+
+// === Helpers ===
+
+static uint32_t elapsed(const wifi_backend_t *b, uint32_t t0) {
+    return b->now_ms(b->ctx) - t0;
+}
+
+static uint32_t left(const wifi_backend_t *b, uint32_t t0, uint32_t timeout_ms) {
+    uint32_t used = elapsed(b, t0);
+    return used < timeout_ms ? timeout_ms - used : 0;
+}
+
+static bool scan(wifi_connect_stats_t *st, const wifi_backend_t *b, const uint8_t *channels,
+                 uint8_t n, wifi_ap_t *best) {
+    st->scans++;
+    return b->scan(b->ctx, channels, n, best);
+}
+
+static void record(wifi_path_stats_t *s, uint32_t ms) {
+    s->ok++;
+    s->total_ms += ms;
+    if (s->ok == 1 || ms < s->min_ms) {
+        s->min_ms = ms;
+    }
+    if (ms > s->max_ms) {
+        s->max_ms = ms;
+    }
+}
+
+// === Entry ===
+
+const char *wifi_path_str(wifi_path_t p) {
+    static const char *const names[] = { "DIRECTED", "CHANNELS", "FULL", "NONE" };
+    return (unsigned)p < sizeof(names) / sizeof(names[0]) ? names[p] : "?";
+}
+
+uint32_t wifi_cache_ssid_hash(const char *ssid) {
+    uint32_t h = 2166136261u;
+    while (*ssid) {
+        h = (h ^ (uint8_t)*ssid++) * 16777619u;
+    }
+    return h ? h : 1;
+}
+
+bool wifi_cache_valid(const wifi_cache_t *c, uint32_t ssid_hash) {
+    return c->magic == WIFI_CACHE_MAGIC && c->ssid_hash == ssid_hash && c->channel != 0 &&
+           c->fails < WIFI_CACHE_MAX_FAILS;
+}
+
+void wifi_cache_store(wifi_cache_t *c, uint32_t ssid_hash, const wifi_ap_t *ap) {
+    c->magic = WIFI_CACHE_MAGIC;
+    c->ssid_hash = ssid_hash;
+    memcpy(c->bssid, ap->bssid, sizeof(c->bssid));
+    c->channel = ap->channel;
+    c->fails = 0;
+}
+
+void wifi_cache_forget(wifi_cache_t *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+void wifi_connect_stats_reset(wifi_connect_stats_t *st) {
+    memset(st, 0, sizeof(*st));
+    st->last_path = WIFI_PATH_NONE;
+}
+
+// === Connect ===
+
+wifi_path_t wifi_cache_connect(wifi_cache_t *c, wifi_connect_stats_t *st, const wifi_backend_t *b,
+                               uint32_t ssid_hash, const uint8_t *channels, uint8_t n_channels,
+                               uint32_t timeout_ms, wifi_ap_t *ap) {
+    uint32_t t0 = b->now_ms(b->ctx);
+    wifi_path_t path = WIFI_PATH_NONE;
+    bool found = false;
+    wifi_ap_t cand = { 0 };
+
+    st->connects++;
+
+    // 1. Directed: the cached AP, no scan
+    if (wifi_cache_valid(c, ssid_hash)) {
+        uint32_t budget = timeout_ms < WIFI_CACHE_DIRECTED_MS ? timeout_ms : WIFI_CACHE_DIRECTED_MS;
+        memcpy(cand.bssid, c->bssid, sizeof(cand.bssid));
+        cand.channel = c->channel;
+        st->path[WIFI_PATH_DIRECTED].tries++;
+        if (b->join(b->ctx, &cand, budget)) {
+            path = WIFI_PATH_DIRECTED;
+        } else if (++c->fails >= WIFI_CACHE_MAX_FAILS) {
+            st->dropped++;
+            wifi_cache_forget(c);
+        }
+    }
+
+    // 2. The configured channels
+    if (path == WIFI_PATH_NONE && n_channels && left(b, t0, timeout_ms)) {
+        st->path[WIFI_PATH_CHANNELS].tries++;
+        found = scan(st, b, channels, n_channels, &cand);
+        if (found && b->join(b->ctx, &cand, left(b, t0, timeout_ms))) {
+            path = WIFI_PATH_CHANNELS;
+        }
+    }
+
+    // 3. Everything (a join that failed on an AP just seen would fail again)
+    if (path == WIFI_PATH_NONE && !found && left(b, t0, timeout_ms)) {
+        st->path[WIFI_PATH_FULL].tries++;
+        if (scan(st, b, NULL, 0, &cand) && b->join(b->ctx, &cand, left(b, t0, timeout_ms))) {
+            path = WIFI_PATH_FULL;
+        }
+    }
+
+    uint32_t ms = elapsed(b, t0);
+    if (path != WIFI_PATH_NONE) {
+        wifi_cache_store(c, ssid_hash, &cand);      // Same bytes unless the AP moved
+        record(&st->path[path], ms);
+        if (ap) {
+            *ap = cand;
+        }
+    } else {
+        st->failures++;
+    }
+    st->last_path = path;
+    st->last_ms = ms;
+    return path;
+}
+
+bool wifi_cache_scan(wifi_cache_t *c, wifi_connect_stats_t *st, const wifi_backend_t *b,
+                     uint32_t ssid_hash, const uint8_t *channels, uint8_t n_channels,
+                     wifi_ap_t *best) {
+    wifi_ap_t ap;
+
+    if (!scan(st, b, channels, n_channels, &ap)) {
+        return false;
+    }
+    wifi_cache_store(c, ssid_hash, &ap);
+    if (best) {
+        *best = ap;
+    }
+    return true;
+}
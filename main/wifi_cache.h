@@ -0,0 +1,145 @@
+// File: main/wifi_cache.h
+// ==========================================================================================
+// Fast reconnect for the station. A cold connect scans every channel before it can
+// associate, which costs seconds of radio-on time per upload session. The AP that last
+// worked (BSSID + channel) is cached, so a connect tries the cheapest way first:
+//
+//   1. DIRECTED   join the cached BSSID on its channel (no scan)
+//   2. CHANNELS   scan wifi.channels only, join the strongest AP with our SSID
+//   3. FULL       scan every channel (only if step 2 found nothing)
+//
+// Any successful join refreshes the cache; a scan done for its own sake (CLI) feeds it
+// too. An entry that failed WIFI_CACHE_MAX_FAILS directed joins in a row, or belongs to
+// another SSID, is not used. The entry is a fixed-size blob the caller persists (NVS)
+// whenever it changes, which is only when the AP, its channel or the fail count change.
+// Pure C, no ESP-IDF includes; the radio is behind wifi_backend_t, so the policy also
+// builds on the host for tests.
+// ==========================================================================================
+
+#ifndef WIFI_CACHE_H
+#define WIFI_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WIFI_CACHE_MAGIC        0x31434657u     // "WFC1"
+#define WIFI_CACHE_MAX_FAILS    3               // Directed misses in a row before it is dropped
+#define WIFI_CACHE_DIRECTED_MS  3000            // Directed join budget before scanning
+
+/**
+ * @brief How a connect got its AP.
+ */
+typedef enum {
+    WIFI_PATH_DIRECTED = 0,
+    WIFI_PATH_CHANNELS,
+    WIFI_PATH_FULL,
+    WIFI_PATH_COUNT,
+    WIFI_PATH_NONE = WIFI_PATH_COUNT,   ///< Not connected
+} wifi_path_t;
+
+/**
+ * @brief One access point of the configured network.
+ */
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t  rssi;               ///< dBm when seen (not cached)
+} wifi_ap_t;
+
+/**
+ * @brief The cached AP (persisted as is).
+ */
+typedef struct {
+    uint32_t magic;             ///< WIFI_CACHE_MAGIC when the entry is set
+    uint32_t ssid_hash;         ///< Network it belongs to (wifi_cache_ssid_hash)
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint8_t  fails;             ///< Directed joins that failed in a row
+} wifi_cache_t;
+
+/**
+ * @brief Connect time per path. Times run from the start of the connect, so a FULL
+ *        connect includes the failed directed join and channel scan before it.
+ */
+typedef struct {
+    uint32_t tries;             ///< Connects that attempted this step
+    uint32_t ok;                ///< Connects that ended on this path
+    uint32_t total_ms;          ///< Sum over `ok`
+    uint32_t min_ms;
+    uint32_t max_ms;
+} wifi_path_stats_t;
+
+/**
+ * @brief Connect counters (printed by the wifi CLI command).
+ */
+typedef struct {
+    wifi_path_stats_t path[WIFI_PATH_COUNT];
+    uint32_t    connects;       ///< wifi_cache_connect() calls
+    uint32_t    failures;       ///< Of those, not connected
+    uint32_t    scans;          ///< Scans issued (CLI scans included)
+    uint32_t    dropped;        ///< Entries dropped after WIFI_CACHE_MAX_FAILS misses
+    wifi_path_t last_path;
+    uint32_t    last_ms;        ///< Duration of the last connect, failed or not
+} wifi_connect_stats_t;
+
+/**
+ * @brief The radio, as the policy needs it.
+ */
+typedef struct {
+    void *ctx;
+    /** Scan `channels` (every channel if n == 0) for our SSID; strongest AP in *best. */
+    bool (*scan)(void *ctx, const uint8_t *channels, uint8_t n, wifi_ap_t *best);
+    /** Associate with this BSSID, starting on its channel, and wait for an address.
+     *  On success *ap holds the channel and RSSI actually joined. */
+    bool (*join)(void *ctx, wifi_ap_t *ap, uint32_t timeout_ms);
+    uint32_t (*now_ms)(void *ctx);
+} wifi_backend_t;
+
+const char *wifi_path_str(wifi_path_t p);
+
+/**
+ * @brief Tag for the SSID (FNV-1a, never 0), so a config change invalidates the entry.
+ */
+uint32_t wifi_cache_ssid_hash(const char *ssid);
+
+/**
+ * @brief The entry can be used for a directed join on this network.
+ */
+bool wifi_cache_valid(const wifi_cache_t *c, uint32_t ssid_hash);
+
+/**
+ * @brief Remember an AP that was joined or seen (resets the fail count).
+ */
+void wifi_cache_store(wifi_cache_t *c, uint32_t ssid_hash, const wifi_ap_t *ap);
+
+void wifi_cache_forget(wifi_cache_t *c);
+
+void wifi_connect_stats_reset(wifi_connect_stats_t *st);
+
+/**
+ * @brief Connect the cheapest way that works (see the file header), within timeout_ms.
+ *
+ * @param channels  wifi.channels (may be empty: step 2 is skipped)
+ * @param ap        Out: the AP joined (may be NULL)
+ * @return The path that connected, or WIFI_PATH_NONE.
+ */
+wifi_path_t wifi_cache_connect(wifi_cache_t *c, wifi_connect_stats_t *st, const wifi_backend_t *b,
+                               uint32_t ssid_hash, const uint8_t *channels, uint8_t n_channels,
+                               uint32_t timeout_ms, wifi_ap_t *ap);
+
+/**
+ * @brief Scan for the network (every channel if n == 0) and cache the strongest AP found.
+ */
+bool wifi_cache_scan(wifi_cache_t *c, wifi_connect_stats_t *st, const wifi_backend_t *b,
+                     uint32_t ssid_hash, const uint8_t *channels, uint8_t n_channels,
+                     wifi_ap_t *best);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIFI_CACHE_H
@@ -0,0 +1,387 @@
+// File: main/wifi_sta.c
+// ==========================================================================================
+// Station bring-up on demand. wifi_cache.c decides how to find the AP; this file is its
+// radio backend. A join targets one BSSID (fast scan from its channel) and events drive
+// the retries: a disconnect while a connection is wanted re-associates until
+// wifi.max_retries attempts have failed in a row, except that "no AP found" ends the join
+// at once, so a stale cache entry falls through to a scan quickly. A scan walks the given
+// channels one by one and keeps every AP it saw for the CLI.
+// Connects and scans are serialized (untether task and CLI); the cache and counters are
+// worked on as copies and published under stats_lock, so reading them never waits on
+// the radio.
+// ==========================================================================================
+
+#include <string.h>
+#include "wifi_sta.h"
+#include "nvs_helper.h"
+#include "esp_wifi.h"
+#include "esp_mac.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+
+#define WIFI_STA_GOT_IP     BIT0
+#define WIFI_STA_FAILED     BIT1
+#define WIFI_STA_CACHE_KEY  "wifi_cache"
+#define WIFI_STA_CHANNELS   4           // wifi.channels size
+
+static const char *TAG = "WIFI";
+
+static wifi_config_t sta_config;
+static uint32_t ssid_hash;
+static uint8_t channels[WIFI_STA_CHANNELS];
+static uint8_t channel_count;
+static uint8_t max_retries;
+static EventGroupHandle_t events;
+static SemaphoreHandle_t lock;      ///< One connect or scan at a time
+static bool stack_ready;
+static bool started;
+static volatile bool wanted;        ///< Reconnect on disconnect
+static uint8_t retries;             ///< Failed attempts in a row (event task only)
+
+static wifi_ap_record_t records[WIFI_STA_SEEN_MAX];     // Scan buffer (under lock)
+static wifi_sta_seen_t seen[WIFI_STA_SEEN_MAX];         // Last scan (under lock)
+static uint8_t seen_count;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_cache_t cache;          ///< Published copies (under stats_lock)
+static wifi_connect_stats_t stats;
+static wifi_ap_t joined;
+
+// === Events ===
+
+static void on_event(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+        const wifi_event_sta_disconnected_t *d = data;
+        xEventGroupClearBits(events, WIFI_STA_GOT_IP);
+        if (!wanted) {
+            return;
+        }
+        if (d->reason != WIFI_REASON_NO_AP_FOUND && retries < max_retries) {
+            retries++;
+            ESP_LOGW(TAG, "Disconnected (reason %d), retry %u/%u", d->reason,
+                     (unsigned)retries, (unsigned)max_retries);
+            esp_wifi_connect();
+        } else {
+            ESP_LOGW(TAG, "Cannot join " MACSTR " (reason %d)", MAC2STR(d->bssid), d->reason);
+            xEventGroupSetBits(events, WIFI_STA_FAILED);
+        }
+    } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        const ip_event_got_ip_t *ip = data;
+        retries = 0;
+        ESP_LOGI(TAG, "Connected, IP " IPSTR, IP2STR(&ip->ip_info.ip));
+        xEventGroupSetBits(events, WIFI_STA_GOT_IP);
+    }
+}
+
+// === Stack ===
+
+static esp_err_t stack_init(void) {
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    esp_err_t err = esp_netif_init();
+
+    if (err == ESP_OK) {
+        err = esp_event_loop_create_default();
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;       // Someone else created it first
+        }
+    }
+    if (err == ESP_OK) {
+        esp_netif_create_default_wifi_sta();
+        err = esp_wifi_init(&cfg);
+    }
+    if (err == ESP_OK) {
+        esp_wifi_set_storage(WIFI_STORAGE_RAM);
+        esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, on_event, NULL);
+        esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, on_event, NULL);
+        err = esp_wifi_set_mode(WIFI_MODE_STA);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Wi-Fi init failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+/**
+ * @brief Bring the stack up (first use) and start the radio without joining anything.
+ */
+static esp_err_t radio_start(void) {
+    if (!stack_ready) {
+        esp_err_t err = stack_init();
+        if (err != ESP_OK) {
+            return err;
+        }
+        stack_ready = true;
+    }
+    if (!started) {
+        esp_wifi_set_config(WIFI_IF_STA, &sta_config);
+        esp_err_t err = esp_wifi_start();
+        if (err != ESP_OK) {
+            return err;
+        }
+        started = true;
+    }
+    return ESP_OK;
+}
+
+// === Backend (wifi_cache.h) ===
+
+static void seen_insert(const wifi_ap_record_t *r) {
+    uint8_t i = seen_count;
+
+    if (i == WIFI_STA_SEEN_MAX) {
+        if (seen[i - 1].ap.rssi >= r->rssi) {
+            return;             // Weaker than everything kept
+        }
+        i--;                    // Replaces the weakest
+    } else {
+        seen_count++;
+    }
+    for (; i > 0 && seen[i - 1].ap.rssi < r->rssi; i--) {
+        seen[i] = seen[i - 1];
+    }
+    memcpy(seen[i].ssid, r->ssid, sizeof(seen[i].ssid) - 1);
+    seen[i].ssid[sizeof(seen[i].ssid) - 1] = '\0';
+    memcpy(seen[i].ap.bssid, r->bssid, sizeof(seen[i].ap.bssid));
+    seen[i].ap.channel = r->primary;
+    seen[i].ap.rssi = r->rssi;
+}
+
+static bool radio_scan(void *ctx, const uint8_t *list, uint8_t n, wifi_ap_t *best) {
+    static const uint8_t all = 0;
+    bool found = false;
+
+    if (n == 0) {
+        list = &all;            // Channel 0: every channel in one scan
+        n = 1;
+    }
+    seen_count = 0;
+    for (uint8_t c = 0; c < n; c++) {
+        wifi_scan_config_t sc = { .channel = list[c] };
+        uint16_t num = WIFI_STA_SEEN_MAX;
+
+        if (esp_wifi_scan_start(&sc, true) != ESP_OK ||
+            esp_wifi_scan_get_ap_records(&num, records) != ESP_OK) {
+            continue;
+        }
+        for (uint16_t i = 0; i < num; i++) {
+            seen_insert(&records[i]);
+        }
+    }
+    for (uint8_t i = 0; i < seen_count && !found; i++) {    // Strongest first
+        if (strncmp(seen[i].ssid, (const char *)sta_config.sta.ssid, sizeof(sta_config.sta.ssid)) == 0) {
+            *best = seen[i].ap;
+            found = true;
+        }
+    }
+    return found;
+}
+
+static bool radio_join(void *ctx, wifi_ap_t *ap, uint32_t timeout_ms) {
+    wifi_config_t cfg = sta_config;
+    wifi_ap_record_t info;
+
+    memcpy(cfg.sta.bssid, ap->bssid, sizeof(cfg.sta.bssid));
+    cfg.sta.bssid_set = true;
+    cfg.sta.channel = ap->channel;
+    cfg.sta.scan_method = WIFI_FAST_SCAN;
+
+    xEventGroupClearBits(events, WIFI_STA_GOT_IP | WIFI_STA_FAILED);
+    retries = 0;
+    wanted = true;
+    esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    if (esp_wifi_connect() != ESP_OK) {
+        wanted = false;
+        return false;
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(events, WIFI_STA_GOT_IP | WIFI_STA_FAILED, pdFALSE,
+                                           pdFALSE, pdMS_TO_TICKS(timeout_ms));
+    if (bits & WIFI_STA_GOT_IP) {
+        if (esp_wifi_sta_get_ap_info(&info) == ESP_OK) {
+            ap->channel = info.primary;         // Fast scan may have found it elsewhere
+            ap->rssi = info.rssi;
+        }
+        return true;
+    }
+    wanted = false;
+    esp_wifi_disconnect();
+    return false;
+}
+
+static uint32_t radio_now_ms(void *ctx) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static const wifi_backend_t radio = {
+    .scan = radio_scan,
+    .join = radio_join,
+    .now_ms = radio_now_ms,
+};
+
+// === Cache ===
+
+/**
+ * @brief Publish the working copies; the entry goes to NVS only if it changed.
+ */
+static void publish(const wifi_cache_t *c, const wifi_connect_stats_t *st, const wifi_ap_t *ap) {
+    taskENTER_CRITICAL(&stats_lock);
+    bool changed = memcmp(c, &cache, sizeof(cache)) != 0;
+    cache = *c;
+    stats = *st;
+    if (ap) {
+        joined = *ap;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    if (changed) {
+        nvs_state_store(WIFI_STA_CACHE_KEY, c, sizeof(*c));
+    }
+}
+
+static void snapshot(wifi_cache_t *c, wifi_connect_stats_t *st) {
+    taskENTER_CRITICAL(&stats_lock);
+    *c = cache;
+    *st = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+// === Public API ===
+
+esp_err_t wifi_sta_init(const char *ssid, const char *password, uint8_t retries_max,
+                        const uint8_t *channel_list, uint8_t count) {
+    if (!events) {
+        events = xEventGroupCreate();
+        lock = xSemaphoreCreateMutex();
+        if (!events || !lock) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    memset(&sta_config, 0, sizeof(sta_config));
+    strncpy((char *)sta_config.sta.ssid, ssid, sizeof(sta_config.sta.ssid));
+    strncpy((char *)sta_config.sta.password, password, sizeof(sta_config.sta.password));
+    sta_config.sta.threshold.authmode = password[0] ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+    ssid_hash = wifi_cache_ssid_hash(ssid);
+    channel_count = count < WIFI_STA_CHANNELS ? count : WIFI_STA_CHANNELS;
+    memcpy(channels, channel_list, channel_count);
+    max_retries = retries_max;
+
+    taskENTER_CRITICAL(&stats_lock);
+    wifi_connect_stats_reset(&stats);
+    taskEXIT_CRITICAL(&stats_lock);
+    if (nvs_state_load(WIFI_STA_CACHE_KEY, &cache, sizeof(cache)) != ESP_OK) {
+        wifi_cache_forget(&cache);
+    } else if (wifi_cache_valid(&cache, ssid_hash)) {
+        ESP_LOGI(TAG, "Cached AP " MACSTR " on channel %u", MAC2STR(cache.bssid),
+                 (unsigned)cache.channel);
+    }
+    return ESP_OK;
+}
+
+esp_err_t wifi_sta_connect(uint32_t timeout_ms) {
+    if (!events || !sta_config.sta.ssid[0]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (wifi_sta_connected()) {
+        xSemaphoreGive(lock);
+        return ESP_OK;
+    }
+    esp_err_t err = radio_start();
+    if (err != ESP_OK) {
+        xSemaphoreGive(lock);
+        return err;
+    }
+
+    wifi_cache_t c;
+    wifi_connect_stats_t st;
+    wifi_ap_t ap;
+    snapshot(&c, &st);
+    wifi_path_t path = wifi_cache_connect(&c, &st, &radio, ssid_hash, channels, channel_count,
+                                          timeout_ms, &ap);
+    publish(&c, &st, path != WIFI_PATH_NONE ? &ap : NULL);
+    xSemaphoreGive(lock);
+
+    if (path == WIFI_PATH_NONE) {
+        ESP_LOGE(TAG, "Cannot join '%s' (%u ms)", (const char *)sta_config.sta.ssid,
+                 (unsigned)st.last_ms);
+        wifi_sta_disconnect();
+        return st.last_ms >= timeout_ms ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Joined " MACSTR " on channel %u (%s) in %u ms", MAC2STR(ap.bssid),
+             (unsigned)ap.channel, wifi_path_str(path), (unsigned)st.last_ms);
+    return ESP_OK;
+}
+
+void wifi_sta_disconnect(void) {
+    wanted = false;
+    if (started) {
+        esp_wifi_disconnect();
+        esp_wifi_stop();
+        started = false;
+    }
+    if (events) {
+        xEventGroupClearBits(events, WIFI_STA_GOT_IP);
+    }
+}
+
+bool wifi_sta_connected(void) {
+    return events && (xEventGroupGetBits(events) & WIFI_STA_GOT_IP);
+}
+
+esp_err_t wifi_sta_scan(wifi_sta_seen_t *out, uint8_t max, uint8_t *count) {
+    *count = 0;
+    if (!events || !sta_config.sta.ssid[0]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    esp_err_t err = radio_start();
+    if (err != ESP_OK) {
+        xSemaphoreGive(lock);
+        return err;
+    }
+
+    wifi_cache_t c;
+    wifi_connect_stats_t st;
+    snapshot(&c, &st);
+    bool found = wifi_cache_scan(&c, &st, &radio, ssid_hash, NULL, 0, NULL);
+    publish(&c, &st, NULL);
+    *count = seen_count < max ? seen_count : max;
+    memcpy(out, seen, *count * sizeof(*out));
+    if (!wifi_sta_connected()) {
+        wifi_sta_disconnect();
+    }
+    xSemaphoreGive(lock);
+    return found ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t wifi_sta_forget(void) {
+    wifi_cache_t c;
+    wifi_connect_stats_t st;
+
+    if (!lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    snapshot(&c, &st);
+    wifi_cache_forget(&c);
+    publish(&c, &st, NULL);
+    xSemaphoreGive(lock);
+    return ESP_OK;
+}
+
+void wifi_sta_get_stats(wifi_sta_stats_t *out, bool reset) {
+    taskENTER_CRITICAL(&stats_lock);
+    out->cache = cache;
+    out->connect = stats;
+    out->ap = joined;
+    if (reset) {
+        wifi_connect_stats_reset(&stats);
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    out->cached = wifi_cache_valid(&out->cache, ssid_hash);
+    out->connected = wifi_sta_connected();
+}
@@ -0,0 +1,90 @@
+// File: main/wifi_sta.h
+// ==========================================================================================
+// Wi-Fi station for the untethered upload. The radio is only up while a transfer needs
+// it: wifi_sta_connect() brings the stack up on first use, joins wifi.ssid and waits for
+// an address; wifi_sta_disconnect() turns the radio off again. Credentials stay in RAM
+// (the config is the source of truth), so connecting never writes them to NVS. What is
+// written is the last good AP (wifi_cache.h), so the next connect can skip the scan.
+// ==========================================================================================
+
+#ifndef WIFI_STA_H
+#define WIFI_STA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "wifi_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WIFI_STA_SEEN_MAX   16      // APs kept from the last scan
+
+/**
+ * @brief An AP from the last scan, any network.
+ */
+typedef struct {
+    char      ssid[33];
+    wifi_ap_t ap;
+} wifi_sta_seen_t;
+
+/**
+ * @brief Station state and connect counters (printed by the wifi CLI command).
+ */
+typedef struct {
+    bool                 connected;
+    bool                 cached;    ///< The cache entry is usable for a directed join
+    wifi_cache_t         cache;
+    wifi_ap_t            ap;        ///< AP of the last successful connect
+    wifi_connect_stats_t connect;
+} wifi_sta_stats_t;
+
+/**
+ * @brief Remember the network to join (wifi.ssid, wifi.password, wifi.max_retries,
+ *        wifi.channels) and load the cached AP. Nothing is started yet.
+ */
+esp_err_t wifi_sta_init(const char *ssid, const char *password, uint8_t max_retries,
+                        const uint8_t *channels, uint8_t channel_count);
+
+/**
+ * @brief Join the network and wait for an IP address: the cached AP first, then a scan.
+ *
+ * @return ESP_OK when connected, ESP_ERR_INVALID_STATE without an SSID, ESP_ERR_TIMEOUT,
+ *         or ESP_FAIL when no AP could be joined.
+ */
+esp_err_t wifi_sta_connect(uint32_t timeout_ms);
+
+/**
+ * @brief Leave the network and stop the radio.
+ */
+void wifi_sta_disconnect(void);
+
+/**
+ * @brief Associated and addressed right now.
+ */
+bool wifi_sta_connected(void);
+
+/**
+ * @brief Scan every channel, cache the strongest AP of wifi.ssid and return what was seen
+ *        (strongest first). The radio is stopped again unless connected.
+ *
+ * @return ESP_ERR_NOT_FOUND if wifi.ssid was not among them (the list is still valid).
+ */
+esp_err_t wifi_sta_scan(wifi_sta_seen_t *out, uint8_t max, uint8_t *count);
+
+/**
+ * @brief Drop the cached AP: the next connect scans.
+ */
+esp_err_t wifi_sta_forget(void);
+
+/**
+ * @brief Snapshot of the state and counters; `reset` clears the counters afterwards.
+ */
+void wifi_sta_get_stats(wifi_sta_stats_t *out, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIFI_STA_H
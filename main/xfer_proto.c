@@ -0,0 +1,552 @@
+// File: main/xfer_proto.c
+// ==========================================================================================
+// COBS framing and the sending side of the tethered transfer protocol.
+// Chunks are read from the source each time they are (re)transmitted, so the sender's
+// memory does not grow with the window. Losses are repaired two ways: a chunk that is
+// still missing when a chunk sent after it shows up in the ACK's SACK bitmap is resent at
+// once (the link keeps order, so a hole is a loss), and anything unacknowledged for one
+// RTO is resent with backoff. Host silence while data is outstanding means the link is
+// gone: the sender then re-handshakes and offers the file again.
+// ==========================================================================================
+
+#include <string.h>
+#include "xfer_proto.h"
+#include "log_segment.h"    // log_crc32
+
+enum { XFER_AGAIN = -1 };   // Internal: link re-established, offer the file again
+
+// === Little-endian fields ===
+
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// === COBS ===
+
+size_t xfer_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t code_at = 0, out = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] != 0) {
+            dst[out++] = src[i];
+            code++;
+        }
+        if (src[i] == 0 || code == 0xFF) {
+            dst[code_at] = code;
+            code_at = out++;
+            code = 1;
+        }
+    }
+    dst[code_at] = code;
+    dst[out++] = 0;
+    return out;
+}
+
+static void cobs_reset(xfer_cobs_dec_t *d) {
+    d->len = 0;
+    d->code = 0;
+    d->left = 0;
+    d->zero = false;
+    d->bad = false;
+}
+
+void xfer_cobs_init(xfer_cobs_dec_t *d, uint8_t *buf, size_t cap) {
+    d->buf = buf;
+    d->cap = cap;
+    cobs_reset(d);
+}
+
+static void cobs_put(xfer_cobs_dec_t *d, uint8_t b) {
+    if (d->len < d->cap) {
+        d->buf[d->len++] = b;
+    } else {
+        d->bad = true;
+    }
+}
+
+int xfer_cobs_feed(xfer_cobs_dec_t *d, uint8_t byte) {
+    if (byte == 0) {
+        bool empty = d->code == 0 && !d->bad;
+        bool ok = !empty && !d->bad && d->left == 0;
+        int n = (int)d->len;
+        cobs_reset(d);
+        return empty ? 0 : ok ? n : -1;
+    }
+    if (d->left == 0) {
+        // Code byte: the previous block (if not a full 254-byte run) ended with a zero
+        if (d->zero) {
+            cobs_put(d, 0);
+        }
+        d->code = byte;
+        d->left = (uint8_t)(byte - 1);
+        d->zero = d->left == 0;
+        return 0;
+    }
+    cobs_put(d, byte);
+    if (--d->left == 0) {
+        d->zero = d->code != 0xFF;
+    }
+    return 0;
+}
+
+// === Link ===
+
+static uint32_t now(const xfer_tx_t *tx) {
+    return tx->link->now_ms(tx->link->ctx);
+}
+
+static bool cancelled(const xfer_tx_t *tx) {
+    return tx->link->cancelled && tx->link->cancelled(tx->link->ctx);
+}
+
+/**
+ * @brief Append the CRC to `msg` (len + 4 bytes of room) and write it as one frame.
+ *
+ * A failed write is not an error here: the missing replies will show the link is down.
+ */
+static void send_msg(xfer_tx_t *tx, uint8_t *msg, size_t len) {
+    put32(msg + len, log_crc32(0, msg, len));
+    size_t n = xfer_cobs_encode(msg, len + 4, tx->wire);
+    tx->link->write(tx->link->ctx, tx->wire, n);
+}
+
+/**
+ * @brief Next valid host message (type, payload in tx->rx), waiting up to timeout_ms.
+ *
+ * @return Message type, 0 on timeout, -1 if the link is down.
+ */
+static int recv_msg(xfer_tx_t *tx, uint32_t timeout_ms) {
+    uint32_t start = now(tx);
+
+    for (;;) {
+        while (tx->rx_pos < tx->rx_len) {
+            int n = xfer_cobs_feed(&tx->dec, tx->rx_raw[tx->rx_pos++]);
+            if (n == 0) {
+                continue;
+            }
+            if (n < 5 || log_crc32(0, tx->rx, (size_t)n - 4) != get32(tx->rx + n - 4)) {
+                tx->stats.bad_frames++;
+                continue;
+            }
+            tx->rx_n = (size_t)n - 4;
+            tx->last_rx_ms = now(tx);
+            return tx->rx[0];
+        }
+
+        uint32_t waited = now(tx) - start;
+        int r = tx->link->read(tx->link->ctx, tx->rx_raw, sizeof(tx->rx_raw),
+                               waited < timeout_ms ? timeout_ms - waited : 0);
+        if (r <= 0) {
+            return r < 0 ? -1 : 0;
+        }
+        tx->rx_pos = 0;
+        tx->rx_len = (uint8_t)r;
+    }
+}
+
+// === Session ===
+
+/**
+ * @brief HELLO every XFER_RETRY_MS until the host answers or p.resume_ms runs out.
+ */
+static int handshake(xfer_tx_t *tx) {
+    uint8_t m[17 + 4];
+    uint32_t start = now(tx), sent = 0;
+    bool first = true;
+
+    m[0] = XFER_HELLO;
+    put32(m + 1, XFER_MAGIC);
+    m[5] = XFER_VERSION;
+    m[6] = tx->p.window;
+    put16(m + 7, tx->p.chunk);
+    put32(m + 9, tx->p.boot);
+    put32(m + 13, tx->p.session);
+
+    xfer_cobs_init(&tx->dec, tx->rx, sizeof(tx->rx));
+    for (;;) {
+        uint32_t t = now(tx);
+        if (cancelled(tx)) {
+            return XFER_ERR_CANCELLED;
+        }
+        if (t - start >= tx->p.resume_ms) {
+            return XFER_ERR_LINK;
+        }
+        if (first || t - sent >= XFER_RETRY_MS) {
+            send_msg(tx, m, 17);
+            sent = t;
+            first = false;
+        }
+        int type = recv_msg(tx, XFER_RETRY_MS - (t - sent));
+        if (type == XFER_HELLO_ACK && tx->rx_n >= 6 && get32(tx->rx + 1) == tx->p.session) {
+            tx->window = tx->rx[5] && tx->rx[5] < tx->p.window ? tx->rx[5] : tx->p.window;
+            return XFER_OK;
+        }
+    }
+}
+
+/**
+ * @brief Re-establish a lost link; the caller then offers its file again.
+ */
+static int reconnect(xfer_tx_t *tx) {
+    uint32_t t0 = now(tx);
+    int r = handshake(tx);
+
+    if (r != XFER_OK) {
+        return r;
+    }
+    uint32_t ms = now(tx) - t0;
+    tx->stats.reconnects++;
+    if (ms > tx->stats.recover_max_ms) {
+        tx->stats.recover_max_ms = ms;
+    }
+    return XFER_AGAIN;
+}
+
+/**
+ * @brief Send `m` (len bytes + 4 of room) until the host replies `want` (at least
+ *        `need` bytes) for the current file.
+ *
+ * @return XFER_OK with the reply in tx->rx, XFER_AGAIN after a reconnect, or an error.
+ */
+static int exchange(xfer_tx_t *tx, uint8_t *m, size_t len, uint8_t want, size_t need) {
+    uint32_t start = now(tx), sent = start;
+
+    send_msg(tx, m, len);
+    for (;;) {
+        uint32_t t = now(tx);
+        uint32_t quiet = t - start < t - tx->last_rx_ms ? t - start : t - tx->last_rx_ms;
+        if (cancelled(tx)) {
+            return XFER_ERR_CANCELLED;
+        }
+        if (quiet >= XFER_LINK_TIMEOUT_MS) {
+            return reconnect(tx);
+        }
+        if (t - sent >= XFER_RETRY_MS) {
+            send_msg(tx, m, len);
+            sent = t;
+        }
+
+        int type = recv_msg(tx, XFER_RETRY_MS - (t - sent));
+        if (type < 0) {
+            return reconnect(tx);
+        }
+        if (type == want && tx->rx_n >= need &&
+            (want == XFER_BYE_ACK || get32(tx->rx + 1) == tx->file.id)) {
+            return XFER_OK;
+        }
+        if (type == XFER_RESYNC) {
+            sent = t - XFER_RETRY_MS;   // Host restarted: repeat at once
+        }
+    }
+}
+
+// === Window ===
+
+static uint32_t chunk_len(const xfer_tx_t *tx, uint32_t off) {
+    uint32_t left = tx->file.size - off;
+    return left < tx->p.chunk ? left : tx->p.chunk;
+}
+
+static xfer_slot_t *slot_of(xfer_tx_t *tx, uint32_t off) {
+    return &tx->slots[((off - tx->origin) / tx->p.chunk) % tx->window];
+}
+
+static bool send_chunk(xfer_tx_t *tx, uint32_t off) {
+    uint32_t n = chunk_len(tx, off);
+    uint8_t *m = tx->msg;
+    xfer_slot_t *s = slot_of(tx, off);
+
+    if (!tx->src->read(tx->src->ctx, &tx->file, off, m + XFER_DATA_HDR, n)) {
+        return false;
+    }
+    m[0] = XFER_DATA;
+    put32(m + 1, tx->file.id);
+    put32(m + 5, off);
+    s->seq = ++tx->seq;
+    s->sent_ms = now(tx);
+    if (s->tries++) {
+        tx->stats.retransmits++;
+    }
+    tx->stats.sent += n;
+    send_msg(tx, m, XFER_DATA_HDR + n);
+    return true;
+}
+
+/**
+ * @brief Round-trip estimate (RFC 6298 style); only first transmissions are sampled.
+ */
+static void rtt_sample(xfer_tx_t *tx, const xfer_slot_t *s, uint32_t t) {
+    if (s->tries != 1) {
+        return;
+    }
+    int32_t r = (int32_t)(t - s->sent_ms);
+    if (tx->srtt == 0) {
+        tx->srtt = (uint32_t)r + 1;
+        tx->rttvar = (uint32_t)r / 2 + 1;
+    } else {
+        int32_t err = r - (int32_t)tx->srtt;
+        tx->srtt = (uint32_t)((int32_t)tx->srtt + err / 8);
+        tx->rttvar = (uint32_t)((int32_t)tx->rttvar + ((err < 0 ? -err : err) - (int32_t)tx->rttvar) / 4);
+    }
+    uint32_t rto = tx->srtt + 4 * tx->rttvar;
+    tx->rto = rto < XFER_RTO_MIN_MS ? XFER_RTO_MIN_MS : rto > XFER_RTO_MAX_MS ? XFER_RTO_MAX_MS : rto;
+}
+
+static bool on_ack(xfer_tx_t *tx) {
+    uint32_t chunk = tx->p.chunk;
+
+    if (tx->rx_n < 13 || get32(tx->rx + 1) != tx->file.id) {
+        return true;
+    }
+    uint32_t cum = get32(tx->rx + 5), sack = get32(tx->rx + 9), t = now(tx);
+    if (cum < tx->base || cum > tx->next || (cum < tx->next && (cum - tx->origin) % chunk)) {
+        return true;    // Stale (from before a reconnect) or bogus
+    }
+
+    for (uint32_t off = tx->base; off < cum; off += chunk) {
+        xfer_slot_t *s = slot_of(tx, off);
+        if (!s->acked) {
+            rtt_sample(tx, s, t);
+        }
+        tx->stats.bytes += chunk_len(tx, off);
+        memset(s, 0, sizeof(*s));
+    }
+    tx->base = cum;
+
+    uint32_t top = 0;   // Latest transmission the host has confirmed above cum
+    for (uint32_t i = 0; i < XFER_WINDOW_MAX && (sack >> i); i++) {
+        uint32_t off = cum + (i + 1) * chunk;
+        if (off >= tx->next) {
+            break;
+        }
+        xfer_slot_t *s = slot_of(tx, off);
+        if ((sack >> i) & 1) {
+            if (!s->acked) {
+                rtt_sample(tx, s, t);
+                s->acked = true;
+            }
+            if (s->seq > top) {
+                top = s->seq;
+            }
+        }
+    }
+
+    // Holes: anything sent before a confirmed chunk and still missing was lost
+    for (uint32_t off = tx->base; off < tx->next && top; off += chunk) {
+        xfer_slot_t *s = slot_of(tx, off);
+        if (!s->acked && s->seq < top && !send_chunk(tx, off)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Resend whatever has waited one RTO; back the RTO off if anything was.
+ */
+static bool retransmit_expired(xfer_tx_t *tx, uint32_t t) {
+    bool expired = false;
+
+    for (uint32_t off = tx->base; off < tx->next; off += tx->p.chunk) {
+        xfer_slot_t *s = slot_of(tx, off);
+        if (!s->acked && t - s->sent_ms >= tx->rto) {
+            if (!send_chunk(tx, off)) {
+                return false;
+            }
+            tx->stats.timeouts++;
+            expired = true;
+        }
+    }
+    if (expired) {
+        tx->rto = tx->rto * 2 < XFER_RTO_MAX_MS ? tx->rto * 2 : XFER_RTO_MAX_MS;
+    }
+    return true;
+}
+
+/**
+ * @brief Time until the oldest unacknowledged chunk times out.
+ */
+static uint32_t rto_wait(xfer_tx_t *tx, uint32_t t) {
+    uint32_t wait = XFER_LINK_TIMEOUT_MS;
+
+    for (uint32_t off = tx->base; off < tx->next; off += tx->p.chunk) {
+        xfer_slot_t *s = slot_of(tx, off);
+        if (!s->acked) {
+            uint32_t age = t - s->sent_ms;
+            uint32_t left = age < tx->rto ? tx->rto - age : 0;
+            if (left < wait) {
+                wait = left;
+            }
+        }
+    }
+    return wait;
+}
+
+/**
+ * @brief Send the current file from tx->origin until the host has all of it.
+ */
+static int stream(xfer_tx_t *tx) {
+    uint32_t size = tx->file.size;
+    uint32_t span = (uint32_t)tx->window * tx->p.chunk;
+
+    for (;;) {
+        if (cancelled(tx)) {
+            return XFER_ERR_CANCELLED;
+        }
+        while (tx->next < size && tx->next - tx->base < span) {
+            if (!send_chunk(tx, tx->next)) {
+                return XFER_ERR_SOURCE;
+            }
+            tx->next += chunk_len(tx, tx->next);
+        }
+        if (tx->base >= size) {
+            return XFER_OK;
+        }
+
+        int type = recv_msg(tx, rto_wait(tx, now(tx)));
+        if (type < 0) {
+            return reconnect(tx);
+        }
+        if (type == XFER_RESYNC) {
+            return XFER_AGAIN;
+        }
+        if (type == XFER_ACK && !on_ack(tx)) {
+            return XFER_ERR_SOURCE;
+        }
+
+        uint32_t t = now(tx);
+        if (!retransmit_expired(tx, t)) {
+            return XFER_ERR_SOURCE;
+        }
+        if (t - tx->last_rx_ms >= XFER_LINK_TIMEOUT_MS) {
+            return reconnect(tx);
+        }
+    }
+}
+
+static int send_file(xfer_tx_t *tx) {
+    const xfer_file_t *f = &tx->file;
+    uint8_t m[13 + 4];
+    bool first = true;
+
+    for (;;) {
+        m[0] = XFER_OFFER;
+        put32(m + 1, f->id);
+        put32(m + 5, f->size);
+        put32(m + 9, f->tag);
+        int r = exchange(tx, m, 13, XFER_RESUME, 9);
+        if (r == XFER_AGAIN) {
+            continue;
+        }
+        if (r != XFER_OK) {
+            return r;
+        }
+
+        uint32_t have = get32(tx->rx + 5);
+        if (first) {
+            tx->stats.resumed += have < f->size ? have : f->size;
+            tx->stats.skipped += have >= f->size;
+            first = false;
+        }
+        if (have >= f->size) {
+            return XFER_OK;     // Host has it (or finished it before the link dropped)
+        }
+
+        tx->origin = tx->base = tx->next = have;
+        memset(tx->slots, 0, sizeof(tx->slots));
+        r = stream(tx);
+        if (r == XFER_AGAIN) {
+            continue;
+        }
+        if (r != XFER_OK) {
+            return r;
+        }
+
+        m[0] = XFER_END;
+        put32(m + 1, f->id);
+        put32(m + 5, f->size);
+        r = exchange(tx, m, 9, XFER_DONE, 6);
+        if (r == XFER_AGAIN) {
+            continue;
+        }
+        if (r == XFER_OK && tx->rx[5] == XFER_DONE_BAD) {
+            tx->stats.bad++;
+        }
+        return r;
+    }
+}
+
+/**
+ * @brief Best effort: every file is already confirmed by its DONE.
+ */
+static void bye(xfer_tx_t *tx) {
+    uint8_t m[9 + 4];
+
+    m[0] = XFER_BYE;
+    put32(m + 1, tx->stats.files);
+    put32(m + 5, (uint32_t)tx->stats.bytes);
+    for (int i = 0; i < 3; i++) {
+        send_msg(tx, m, 9);
+        uint32_t t0 = now(tx);
+        for (uint32_t t = t0; t - t0 < XFER_RETRY_MS; t = now(tx)) {
+            int type = recv_msg(tx, XFER_RETRY_MS - (t - t0));
+            if (type == XFER_BYE_ACK) {
+                return;
+            }
+            if (type < 0) {
+                break;
+            }
+        }
+    }
+}
+
+// === Public API ===
+
+const char *xfer_result_str(xfer_result_t r) {
+    static const char *const names[] = { "OK", "LINK", "SOURCE", "CANCELLED" };
+    return (unsigned)r < sizeof(names) / sizeof(names[0]) ? names[r] : "?";
+}
+
+xfer_result_t xfer_send(xfer_tx_t *tx, const xfer_params_t *p, const xfer_link_t *link,
+                        const xfer_source_t *src) {
+    memset(tx, 0, sizeof(*tx));
+    tx->p = *p;
+    if (tx->p.chunk == 0 || tx->p.chunk > XFER_CHUNK_MAX) {
+        tx->p.chunk = XFER_CHUNK_MAX;
+    }
+    if (tx->p.window == 0 || tx->p.window > XFER_WINDOW_MAX) {
+        tx->p.window = XFER_WINDOW_MAX;
+    }
+    tx->window = tx->p.window;
+    tx->link = link;
+    tx->src = src;
+    tx->rto = XFER_RTO_INIT_MS;
+    tx->start_ms = now(tx);
+
+    int r = handshake(tx);
+    while (r == XFER_OK && src->next(src->ctx, &tx->file)) {
+        r = send_file(tx);
+        if (r == XFER_OK) {
+            tx->stats.files++;
+        }
+    }
+    if (r == XFER_OK) {
+        bye(tx);
+    }
+    tx->stats.rtt_ms = tx->srtt;
+    tx->stats.elapsed_ms = now(tx) - tx->start_ms;
+    return (xfer_result_t)r;
+}
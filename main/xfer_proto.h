@@ -0,0 +1,238 @@
+// File: main/xfer_proto.h
+// ==========================================================================================
+// Resumable file transfer protocol for the tethered link (USB CDC on the device, any
+// byte stream in host tests, e.g. a pty pair). The device sends, tools/tether_recv.py
+// receives. Every message is one COBS-encoded frame ended by a 0x00 delimiter, so the
+// receiver resynchronises at the next delimiter after noise, a lost byte or a cable pull:
+//
+//   COBS( TYPE | PAYLOAD | CRC32 (LE, log_crc32) ) 0x00
+//
+//   Session    HELLO        ->  HELLO_ACK
+//   Per file   OFFER        ->  RESUME(offset)     host's in-order prefix, >= size: skip
+//              DATA(offset) ->  ACK(cum, sack)     sliding window, selective retransmit
+//              END          ->  DONE(status)       host checks the file as a whole
+//   Close      BYE          ->  BYE_ACK
+//
+// The host writes data strictly in order and acknowledges only what it has written, so
+// after a link loss (or a receiver restart) the sender re-handshakes, offers the file
+// again and continues from the host's offset. All integers are little-endian.
+// Pure C, no ESP-IDF includes; the sender also builds on the host for tests.
+// ==========================================================================================
+
+#ifndef XFER_PROTO_H
+#define XFER_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XFER_MAGIC              0x31465854u     // "TXF1"
+#define XFER_VERSION            1
+#define XFER_CHUNK_MAX          8192            // DATA payload limit
+#define XFER_WINDOW_MAX         32              // Chunks in flight (width of the SACK bitmap)
+#define XFER_DATA_HDR           9               // TYPE + file + offset
+#define XFER_MSG_MAX            (XFER_DATA_HDR + XFER_CHUNK_MAX + 4)
+#define XFER_CTRL_MAX           24              // Largest host -> device message
+#define XFER_COBS_MAX(n)        ((n) + (n) / 254 + 2)   // Encoded size incl. delimiter
+
+#define XFER_RETRY_MS           200     // HELLO / OFFER / END / BYE resend period
+#define XFER_LINK_TIMEOUT_MS    1500    // Host silence (data outstanding) that means link lost
+#define XFER_RTO_INIT_MS        250
+#define XFER_RTO_MIN_MS         20
+#define XFER_RTO_MAX_MS         2000
+
+/**
+ * @brief Message types. Host -> device replies have bit 7 set.
+ */
+typedef enum {
+    XFER_HELLO      = 0x01,     /**< magic u32, version u8, window u8, chunk u16, boot u32, session u32 */
+    XFER_OFFER      = 0x02,     /**< file u32, size u32, tag u32 */
+    XFER_DATA       = 0x03,     /**< file u32, offset u32, bytes */
+    XFER_END        = 0x04,     /**< file u32, size u32 */
+    XFER_BYE        = 0x05,     /**< files u32, bytes u32 */
+    XFER_HELLO_ACK  = 0x81,     /**< session u32, window u8 (host's limit) */
+    XFER_RESUME     = 0x82,     /**< file u32, offset u32 */
+    XFER_ACK        = 0x83,     /**< file u32, cum u32, sack u32 (bit i: chunk at cum + (i+1) * chunk) */
+    XFER_DONE       = 0x84,     /**< file u32, status u8 (xfer_done_t) */
+    XFER_BYE_ACK    = 0x85,     /**< (empty) */
+    XFER_RESYNC     = 0x86,     /**< (empty) host has no context for what it received */
+} xfer_msg_type_t;
+
+/**
+ * @brief DONE status.
+ */
+typedef enum {
+    XFER_DONE_OK = 0,           /**< Stored and verified */
+    XFER_DONE_BAD,              /**< Stored, but the file's own checks failed (kept aside) */
+} xfer_done_t;
+
+/**
+ * @brief Outcome of a session.
+ */
+typedef enum {
+    XFER_OK = 0,
+    XFER_ERR_LINK,              /**< No host, or it did not come back within resume_ms */
+    XFER_ERR_SOURCE,            /**< A file could not be read */
+    XFER_ERR_CANCELLED,
+} xfer_result_t;
+
+// === Byte link and file source (supplied by the caller) ===
+
+/**
+ * @brief Byte stream to the host.
+ */
+typedef struct {
+    void *ctx;
+    /** Bytes read (> 0), 0 on timeout, < 0 if the link is known to be down (after
+     *  waiting up to timeout_ms, so that retries do not spin). */
+    int (*read)(void *ctx, uint8_t *buf, size_t cap, uint32_t timeout_ms);
+    /** false if the bytes could not be queued (link down or stalled). */
+    bool (*write)(void *ctx, const uint8_t *data, size_t len);
+    uint32_t (*now_ms)(void *ctx);
+    /** Polled between messages; may be NULL. */
+    bool (*cancelled)(void *ctx);
+} xfer_link_t;
+
+/**
+ * @brief One file to send.
+ */
+typedef struct {
+    uint32_t id;                ///< Host derives the file name from it (segment id)
+    uint32_t size;
+    uint32_t tag;               ///< Content identity: a different tag restarts a partial copy
+} xfer_file_t;
+
+/**
+ * @brief Files to send, oldest first.
+ */
+typedef struct {
+    void *ctx;
+    /** Next file; false when there are no more. */
+    bool (*next)(void *ctx, xfer_file_t *out);
+    /** Read `len` bytes at `offset` of `f`. */
+    bool (*read)(void *ctx, const xfer_file_t *f, uint32_t offset, uint8_t *buf, size_t len);
+} xfer_source_t;
+
+// === COBS framing ===
+
+/**
+ * @brief Streaming COBS frame decoder (one byte at a time).
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   len;
+    uint8_t  code;              ///< Code byte of the current block
+    uint8_t  left;              ///< Data bytes left in the current block
+    bool     zero;              ///< A block ended: the next one starts with a 0x00
+    bool     bad;               ///< Overflow: drop the frame at its delimiter
+} xfer_cobs_dec_t;
+
+/**
+ * @brief Encode `len` bytes plus the 0x00 delimiter into `dst` (XFER_COBS_MAX(len) bytes).
+ *
+ * @return Encoded size including the delimiter.
+ */
+size_t xfer_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+void xfer_cobs_init(xfer_cobs_dec_t *d, uint8_t *buf, size_t cap);
+
+/**
+ * @brief Feed one byte.
+ *
+ * @return Decoded frame length at a delimiter (data in d->buf), 0 if the frame is not
+ *         complete yet, -1 for a malformed or oversized frame.
+ */
+int xfer_cobs_feed(xfer_cobs_dec_t *d, uint8_t byte);
+
+// === Sender ===
+
+/**
+ * @brief Session parameters.
+ */
+typedef struct {
+    uint16_t chunk;             ///< DATA payload size, <= XFER_CHUNK_MAX
+    uint8_t  window;            ///< Chunks in flight, <= XFER_WINDOW_MAX
+    uint32_t resume_ms;         ///< Wait this long for the host (at start and after a loss)
+    uint32_t boot;              ///< Reported in HELLO
+    uint32_t session;           ///< Random per session; reported in HELLO
+} xfer_params_t;
+
+/**
+ * @brief Session counters.
+ */
+typedef struct {
+    uint32_t files;             ///< Files the host has (sent now, or before)
+    uint32_t skipped;           ///< Of those, already complete on the host
+    uint32_t bad;               ///< Of those, kept aside by the host (XFER_DONE_BAD)
+    uint64_t bytes;             ///< File bytes the host acknowledged this session
+    uint64_t resumed;           ///< Bytes the host already had of the files offered
+    uint64_t sent;              ///< DATA bytes put on the link, retransmits included
+    uint32_t retransmits;       ///< Chunks sent again
+    uint32_t timeouts;          ///< Of those, after an RTO (the rest filled SACK holes)
+    uint32_t bad_frames;        ///< Host frames dropped (COBS, CRC, length)
+    uint32_t reconnects;        ///< Link losses survived
+    uint32_t recover_max_ms;    ///< Longest loss: detection -> HELLO_ACK
+    uint32_t rtt_ms;            ///< Smoothed round trip at the end
+    uint32_t elapsed_ms;
+} xfer_stats_t;
+
+/**
+ * @brief Window slot: one chunk in flight.
+ */
+typedef struct {
+    uint32_t seq;               ///< Transmission number of the latest send (0 = free)
+    uint32_t sent_ms;
+    uint8_t  tries;
+    bool     acked;             ///< Selectively acknowledged (above cum)
+} xfer_slot_t;
+
+/**
+ * @brief Sender state, ~17 KB with the largest chunk: allocate it per session.
+ */
+typedef struct {
+    xfer_params_t p;
+    uint8_t  window;            ///< p.window capped by the host
+    const xfer_link_t *link;
+    const xfer_source_t *src;
+    xfer_stats_t stats;
+    uint32_t start_ms;
+    uint32_t last_rx_ms;        ///< Last valid frame from the host
+    uint32_t srtt, rttvar, rto; ///< ms
+    uint32_t seq;               ///< Transmission counter
+    xfer_file_t file;           ///< File being sent
+    uint32_t origin;            ///< Offset the window is aligned to (the host's RESUME)
+    uint32_t base;              ///< Everything below is acknowledged
+    uint32_t next;              ///< Next new byte to send
+    xfer_slot_t slots[XFER_WINDOW_MAX];
+    xfer_cobs_dec_t dec;
+    uint8_t  rx[XFER_CTRL_MAX];         ///< Decoded host message (CRC included)
+    size_t   rx_n;                      ///< Its length without the CRC
+    uint8_t  rx_raw[64];                ///< Bytes read from the link...
+    uint8_t  rx_pos, rx_len;            ///< ...and how far they are decoded
+    uint8_t  msg[XFER_MSG_MAX];
+    uint8_t  wire[XFER_COBS_MAX(XFER_MSG_MAX)];
+} xfer_tx_t;
+
+/**
+ * @brief Printable name of a result (e.g. "LINK").
+ */
+const char *xfer_result_str(xfer_result_t r);
+
+/**
+ * @brief Run a whole session: handshake, every file from `src`, BYE.
+ *
+ * Blocks until done. Survives link losses shorter than p->resume_ms.
+ */
+xfer_result_t xfer_send(xfer_tx_t *tx, const xfer_params_t *p, const xfer_link_t *link,
+                        const xfer_source_t *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XFER_PROTO_H
@@ -0,0 +1,47 @@
+"""Hash the embedded config.yaml at build time.
+
+Writes a header defining CONFIG_YAML_HASH, the FNV-1a hash of the file as
+config_hash(text, len, CONFIG_HASH_SEED) in main/config_parser.c computes it over the
+bytes EMBED_TXTFILES embeds. Boot compares the cached config blob against this constant
+instead of hashing the YAML each time.
+
+Usage: python tools/config_hash.py -o build/config_yaml_hash.h main/config.yaml
+"""
+
+import argparse
+from pathlib import Path
+
+FNV_SEED = 2166136261   # CONFIG_HASH_SEED
+FNV_PRIME = 16777619
+
+
+def config_hash(data: bytes, seed: int = FNV_SEED) -> int:
+    h = seed
+    for c in data:
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("-o", "--output", required=True, help="header to write")
+    ap.add_argument("yaml", help="config.yaml embedded in the firmware")
+    args = ap.parse_args()
+
+    data = Path(args.yaml).read_bytes()
+    h = config_hash(data)
+    text = ("// Generated by tools/config_hash.py from config.yaml. Do not edit.\n"
+            "#ifndef CONFIG_YAML_HASH_H\n"
+            "#define CONFIG_YAML_HASH_H\n"
+            f"#define CONFIG_YAML_HASH    0x{h:08X}u\n"
+            f"#define CONFIG_YAML_BYTES   {len(data)}u\n"
+            "#endif\n")
+    path = Path(args.output)
+    # Keep the timestamp when nothing changed so dependents do not rebuild
+    if not path.exists() or path.read_text(encoding="utf-8") != text:
+        path.write_text(text, encoding="utf-8")
+    print(f"config_hash: {len(data)} bytes, 0x{h:08X} -> {path}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+"""Extract text from SD card log segments (main/log_segment.h).
+
+Reads a LOGS directory copied off the card (or single .LOG files), decodes raw and
+LZ-compressed segments, checks their CRCs and prints the lines in log order.
+
+Usage:
+  python tools/log_extract.py /media/sd/LOGS > device.log
+  python tools/log_extract.py --boot 7 /media/sd/LOGS | python tools/tlog_decode.py -d build/tlog_dict.json
+  python tools/log_extract.py --list /media/sd/LOGS
+"""
+
+import argparse
+import binascii
+import struct
+import sys
+from pathlib import Path
+
+HEADER_SIZE = 4096          # LOG_SEG_HEADER_SIZE
+BLOCK_SIZE = 4096           # LOG_SEG_BLOCK_SIZE
+SEG_MAGIC = 0x4745534C      # "LSEG"
+SEG_VERSION = 2
+CODEC_RAW, CODEC_LZ = 0, 1
+LEVELS = "NEWIDV"
+
+SUMMARY = struct.Struct("<IHHIIIIII6IIBB2xI")   # log_seg_summary_t
+INDEX = struct.Struct("<IIHHB3x")               # log_seg_index_t
+FRAME = struct.Struct("<HHI")                   # log_seg_frame_t
+SUMMARY_FIELDS = ("magic", "version", "block_count", "seg_id", "boot", "ts_first", "ts_last",
+                  "data_bytes", "lines")
+
+
+class SegmentError(Exception):
+    pass
+
+
+def lz_decompress(src: bytes, raw_len: int) -> bytes:
+    """LZ4 block format (main/log_lz.c)."""
+    out = bytearray()
+    i, n = 0, len(src)
+    while i < n:
+        token = src[i]
+        i += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = src[i]
+                i += 1
+                lit += b
+                if b != 255:
+                    break
+        out += src[i:i + lit]
+        i += lit
+        if i >= n:
+            break
+        offset = src[i] | src[i + 1] << 8
+        i += 2
+        mlen = token & 15
+        if mlen == 15:
+            while True:
+                b = src[i]
+                i += 1
+                mlen += b
+                if b != 255:
+                    break
+        mlen += 4
+        if offset == 0 or offset > len(out):
+            raise SegmentError("corrupt LZ block")
+        start = len(out) - offset
+        for k in range(mlen):       # May overlap its own output
+            out.append(out[start + k])
+    if len(out) != raw_len:
+        raise SegmentError("LZ block size mismatch")
+    return bytes(out)
+
+
+def parse_summary(data: bytes) -> dict:
+    v = SUMMARY.unpack_from(data, 0)
+    s = dict(zip(SUMMARY_FIELDS, v[:9]))
+    s["level_lines"] = list(v[9:15])
+    s["data_crc"], s["closed"], s["codec"], s["crc"] = v[15:19]
+    return s
+
+
+def read_segment(path):
+    """Return (summary, list of text blocks). Unclosed segments are read up to the first bad frame."""
+    data = Path(path).read_bytes()
+    if len(data) < HEADER_SIZE:
+        raise SegmentError("short header")
+    s = parse_summary(data)
+    if s["magic"] != SEG_MAGIC or s["version"] != SEG_VERSION:
+        raise SegmentError("not a v%d log segment" % SEG_VERSION)
+    if s["closed"]:
+        crc = binascii.crc32(data[:SUMMARY.size - 4])
+        crc = binascii.crc32(data[SUMMARY.size:SUMMARY.size + s["block_count"] * INDEX.size], crc)
+        if crc != s["crc"]:
+            raise SegmentError("header CRC mismatch")
+        stored = data[HEADER_SIZE:HEADER_SIZE + s["data_bytes"]]
+        if binascii.crc32(stored) != s["data_crc"]:
+            raise SegmentError("data CRC mismatch")
+    else:
+        stored = data[HEADER_SIZE:]
+
+    blocks = []
+    if s["codec"] == CODEC_RAW:
+        blocks = [stored[i:i + BLOCK_SIZE] for i in range(0, len(stored), BLOCK_SIZE)]
+    else:
+        pos = 0
+        while pos + FRAME.size <= len(stored):
+            n_stored, n_raw, crc = FRAME.unpack_from(stored, pos)
+            payload = stored[pos + FRAME.size:pos + FRAME.size + n_stored]
+            if not 0 < n_stored <= n_raw <= BLOCK_SIZE or len(payload) != n_stored or \
+                    binascii.crc32(payload) != crc:
+                if s["closed"]:
+                    raise SegmentError("bad frame at %d" % pos)
+                break       # Stale tail of an unclosed segment
+            blocks.append(payload if n_stored == n_raw else lz_decompress(payload, n_raw))
+            pos += FRAME.size + n_stored
+    return s, blocks
+
+
+def segment_files(inputs):
+    for name in inputs:
+        p = Path(name)
+        if p.is_dir():
+            yield from sorted(p.glob("G*/*.LOG"), key=lambda q: int(q.stem))
+        else:
+            yield p
+
+
+def extract(args):
+    errors = 0
+    out = sys.stdout.buffer
+    for path in segment_files(args.inputs):
+        try:
+            s, blocks = read_segment(path)
+        except (OSError, SegmentError, IndexError) as e:
+            print(f"log_extract: {path}: {e}", file=sys.stderr)
+            errors += 1
+            continue
+        if args.boot is not None and s["boot"] != args.boot:
+            continue
+        if args.list:
+            raw = sum(len(b) for b in blocks)
+            levels = " ".join(f"{LEVELS[i]}:{n}" for i, n in enumerate(s["level_lines"]) if n)
+            span = f"{s['ts_first']}-{s['ts_last']} ms" if s["ts_first"] <= s["ts_last"] else "-"
+            print(f"{path.name}  boot {s['boot']:<4} {span:<22} {len(blocks):4} blocks "
+                  f"{raw // 1024:5} KB text {s['data_bytes'] // 1024:5} KB stored "
+                  f"{'LZ ' if s['codec'] == CODEC_LZ else 'raw'} "
+                  f"{'' if s['closed'] else '(open) '}{levels}")
+            continue
+        for b in blocks:
+            out.write(b"".join(line for line in b.splitlines(keepends=True) if line != b"\n"))
+    return errors
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--boot", type=int, help="only this boot sequence number")
+    ap.add_argument("--list", action="store_true", help="print one summary line per segment")
+    ap.add_argument("inputs", nargs="+", help="LOGS directories or .LOG files")
+    args = ap.parse_args()
+
+    try:
+        errors = extract(args)
+    except (KeyboardInterrupt, BrokenPipeError):
+        errors = 0
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
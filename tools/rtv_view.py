@@ -0,0 +1,188 @@
+"""Watch the device's Real-Time View stream with N viewers and measure it (main/rtv_stream.h).
+
+Opens --viewers concurrent connections to http://<device>:<port>/stream (multipart MJPEG,
+chunked), checks that every part is a complete JPEG and reports per-viewer frames/s and
+KB/s. A list of viewer counts (--viewers 1,2,4) runs one step per count, to see how the
+stream holds up as viewers are added; the device turns viewers beyond rtv.max_viewers
+away with 503. --save keeps the frames of the first viewer. --kbps reads no faster than
+that (with a small receive buffer), a slow link for the device's rate controller to find:
+watch the rtv CLI command step the frame rate and quality down. Start a session first
+(CLI: event RTV_ON); it ends on its own after rtv.session_s.
+
+Usage:
+  python tools/rtv_view.py 192.168.1.42 --viewers 1,2 --seconds 10
+  python tools/rtv_view.py 192.168.1.42 --save frames
+  python tools/rtv_view.py 192.168.1.42 --kbps 64 --seconds 30
+"""
+
+import argparse
+import socket
+import sys
+import threading
+import time
+from pathlib import Path
+
+RECV = 65536
+THROTTLED_RCVBUF = 8192
+
+
+class StreamError(Exception):
+    pass
+
+
+class Viewer(threading.Thread):
+    """One /stream connection: de-chunks the body and splits it into JPEG parts."""
+
+    def __init__(self, host, port, seconds, save=None, kbps=0):
+        super().__init__(daemon=True)
+        self.host, self.port, self.seconds, self.save = host, port, seconds, save
+        self.kbps = kbps
+        self.frames = 0
+        self.bytes = 0              # Body bytes, part headers included
+        self.bad = 0                # Parts that are not a whole JPEG
+        self.status = None
+        self.error = None
+        self.elapsed = 0.0
+        self.sock = None
+        self.raw = bytearray()      # Received, not yet de-chunked
+        self.body = bytearray()     # De-chunked, not yet parsed
+        self.chunk_left = 0
+        self.received = 0
+        self.t_read = 0.0
+
+    def fill(self):
+        data = self.sock.recv(THROTTLED_RCVBUF // 4 if self.kbps else RECV)
+        if not data:
+            raise StreamError("connection closed")
+        self.raw += data
+        if self.kbps:
+            self.received += len(data)
+            ahead = self.received / (self.kbps * 1024) - (time.monotonic() - self.t_read)
+            if ahead > 0:
+                time.sleep(ahead)
+
+    def dechunk(self):
+        """Move whole or partial chunk payloads from raw to body. False at the last chunk."""
+        while self.raw:
+            if self.chunk_left == 0:
+                eol = self.raw.find(b"\r\n")
+                if eol < 0:
+                    return True
+                line = bytes(self.raw[:eol])
+                if not line:                # CRLF after the previous chunk
+                    del self.raw[:2]
+                    continue
+                size = int(line.split(b";")[0], 16)
+                del self.raw[:eol + 2]
+                if size == 0:
+                    return False
+                self.chunk_left = size
+            n = min(self.chunk_left, len(self.raw))
+            self.body += self.raw[:n]
+            del self.raw[:n]
+            self.chunk_left -= n
+        return True
+
+    def parse(self):
+        """Take whole parts off the body (the closing boundary has no blank line, stays)."""
+        while True:
+            end = self.body.find(b"\r\n\r\n")
+            if end < 0:
+                return
+            length = None
+            for line in bytes(self.body[:end]).split(b"\r\n"):
+                if line.lower().startswith(b"content-length:"):
+                    length = int(line.split(b":")[1])
+            if length is None:
+                raise StreamError("part without Content-Length")
+            if len(self.body) < end + 4 + length:
+                return
+            jpeg = bytes(self.body[end + 4:end + 4 + length])
+            del self.body[:end + 4 + length]
+            self.frames += 1
+            self.bytes += end + 4 + length
+            if not (jpeg.startswith(b"\xff\xd8") and jpeg.endswith(b"\xff\xd9")):
+                self.bad += 1
+            if self.save:
+                (self.save / f"{self.frames:05d}.jpg").write_bytes(jpeg)
+
+    def run(self):
+        t0 = time.monotonic()
+        try:
+            self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            if self.kbps:
+                self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, THROTTLED_RCVBUF)
+            self.sock.settimeout(5)
+            self.sock.connect((self.host, self.port))
+            self.sock.sendall(f"GET /stream HTTP/1.1\r\nHost: {self.host}\r\n\r\n".encode())
+            while b"\r\n\r\n" not in self.raw:
+                self.fill()
+            end = self.raw.find(b"\r\n\r\n")
+            head = bytes(self.raw[:end]).decode("latin-1").split("\r\n")
+            del self.raw[:end + 4]
+            self.status = int(head[0].split()[1])
+            if self.status != 200:
+                return
+            if not any(h.lower().startswith("transfer-encoding: chunked") for h in head):
+                raise StreamError("expected a chunked response")
+            t0 = self.t_read = time.monotonic()
+            while time.monotonic() - t0 < self.seconds:
+                if not self.dechunk():
+                    break                           # Session over
+                self.parse()
+                self.fill()
+        except (OSError, ValueError, StreamError) as e:
+            self.error = str(e)
+        finally:
+            self.elapsed = time.monotonic() - t0
+            if self.sock:
+                self.sock.close()
+
+
+def step(args, n):
+    save = None
+    if args.save:
+        save = Path(args.save)
+        save.mkdir(parents=True, exist_ok=True)
+    viewers = [Viewer(args.host, args.port, args.seconds, save if i == 0 else None, args.kbps)
+               for i in range(n)]
+    for v in viewers:
+        v.start()
+        time.sleep(0.05)            # Let the server hand each one to its own task
+    for v in viewers:
+        v.join()
+
+    served = [v for v in viewers if v.status == 200]
+    print(f"--- {n} viewer(s): {len(served)} served, {n - len(served)} turned away ---")
+    for i, v in enumerate(viewers):
+        if v.status != 200:
+            print(f"  viewer {i}: HTTP {v.status} {v.error or ''}")
+            continue
+        t = v.elapsed or 1
+        print(f"  viewer {i}: {v.frames} frames, {v.frames / t:6.1f} fps, "
+              f"{v.bytes / t / 1024:8.1f} KB/s, avg {v.bytes / v.frames if v.frames else 0:6.0f} B"
+              f"{', ' + str(v.bad) + ' bad' if v.bad else ''}{', ' + v.error if v.error else ''}")
+    t = max((v.elapsed for v in served), default=1) or 1
+    total = sum(v.bytes for v in served)
+    print(f"  total: {sum(v.frames for v in served) / t:.1f} fps, {total / t / 1024:.1f} KB/s")
+    return all(v.bad == 0 for v in served)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--viewers", default="1", help="viewer counts to step through, e.g. 1,2,4")
+    ap.add_argument("--seconds", type=float, default=10, help="per step")
+    ap.add_argument("--save", help="directory for the first viewer's frames")
+    ap.add_argument("--kbps", type=float, default=0, help="throttle each viewer to this many KB/s")
+    args = ap.parse_args()
+
+    ok = True
+    for n in (int(x) for x in args.viewers.split(",")):
+        ok &= step(args, n)
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
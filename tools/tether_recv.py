@@ -0,0 +1,318 @@
+"""Receive log segments from the device over USB (tethered transfer, main/xfer_proto.h).
+
+Put the device in TETHERED (CLI: event TETHER_REQUEST) with its native USB port connected.
+The receiver rebuilds the card's LOGS directory (Gnnnn/nnnnnnnn.LOG) under --out, so
+log_extract.py and tlog_decode.py read the result directly. Data is written strictly in
+order and acknowledged only once written; an unfinished file stays as a .part and the
+next session (or the same one, after a cable pull) continues where it stopped. Every
+finished segment is checked against its own header and data CRCs; one that fails is
+kept as .LOG.bad.
+
+Usage:
+  python tools/tether_recv.py COM7 --out logs_dev1          (Linux: /dev/ttyACM0)
+  python tools/log_extract.py logs_dev1 > device.log
+Needs pyserial (part of the ESP-IDF Python environment).
+"""
+
+import argparse
+import binascii
+import struct
+import sys
+import time
+from pathlib import Path
+
+import serial   # pyserial
+
+from log_extract import SegmentError, SUMMARY, parse_summary, read_segment
+
+MAGIC = 0x31465854          # XFER_MAGIC "TXF1"
+VERSION = 1
+WINDOW_MAX = 32             # XFER_WINDOW_MAX
+SEGS_PER_DIR = 256          # LOG_SEGS_PER_DIR
+
+HELLO, OFFER, DATA, END, BYE = 0x01, 0x02, 0x03, 0x04, 0x05
+HELLO_ACK, RESUME, ACK, DONE, BYE_ACK, RESYNC = 0x81, 0x82, 0x83, 0x84, 0x85, 0x86
+DONE_OK, DONE_BAD = 0, 1
+RESYNC_GAP = 0.1            # s between RESYNCs while stale frames drain
+
+
+# === Framing ===
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray()
+    for block in data.split(b"\0"):
+        while len(block) >= 254:
+            out.append(255)
+            out += block[:254]
+            block = block[254:]
+        out.append(len(block) + 1)
+        out += block
+    return bytes(out) + b"\0"
+
+
+def cobs_decode(frame: bytes):
+    out = bytearray()
+    i, n = 0, len(frame)
+    while i < n:
+        code = frame[i]
+        if code == 0 or i + code > n:
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code != 255 and i < n:
+            out.append(0)
+    return bytes(out)
+
+
+def message(mtype: int, payload: bytes = b"") -> bytes:
+    body = bytes([mtype]) + payload
+    return cobs_encode(body + struct.pack("<I", binascii.crc32(body)))
+
+
+# === Receiver ===
+
+class Receiver:
+    def __init__(self, out: Path, log):
+        self.out = out
+        self.log = log
+        self.chunk = 0
+        self.window = WINDOW_MAX
+        self.cur = None             # dict for the file being received
+        self.last_done = None       # (id, status): repeat DONE if END is resent
+        self.last_resync = 0.0
+        self.finished = False
+        self.stats = dict(files=0, skipped=0, bad=0, bytes=0, resumed=0, dups=0, early=0,
+                          bad_frames=0, hellos=0)
+
+    def seg_path(self, seg_id: int) -> Path:
+        return self.out / f"G{seg_id // SEGS_PER_DIR:04d}" / f"{seg_id:08d}.LOG"
+
+    def close_current(self):
+        if self.cur:
+            self.cur["fh"].close()
+            self.cur = None
+
+    # --- Messages ---
+
+    def on_hello(self, p: bytes):
+        magic, version, window, chunk, boot, session = struct.unpack_from("<IBBHII", p)
+        if magic != MAGIC or version != VERSION:
+            self.log(f"tether_recv: unsupported sender (magic {magic:#x}, version {version})")
+            return []
+        self.close_current()        # The sender offers its file again next
+        self.chunk = chunk
+        self.window = min(window, WINDOW_MAX)
+        self.stats["hellos"] += 1
+        if self.stats["hellos"] == 1:
+            self.log(f"device boot {boot}, session {session:08x}: {chunk} B chunks, window {window}")
+        else:
+            self.log("link back: resuming")
+        return [message(HELLO_ACK, struct.pack("<IB", session, self.window))]
+
+    def have_complete(self, path: Path, size: int, tag: int) -> bool:
+        for p in (path, path.with_name(path.name + ".bad")):
+            try:
+                with open(p, "rb") as f:
+                    head = f.read(SUMMARY.size)
+                    if f.seek(0, 2) == size and parse_summary(head)["crc"] == tag:
+                        return True
+            except (OSError, struct.error):
+                pass
+        return False
+
+    def on_offer(self, p: bytes):
+        seg_id, size, tag = struct.unpack_from("<III", p)
+        self.close_current()
+        final = self.seg_path(seg_id)
+        if self.have_complete(final, size, tag):
+            self.stats["skipped"] += 1
+            return [message(RESUME, struct.pack("<II", seg_id, size))]
+
+        final.parent.mkdir(parents=True, exist_ok=True)
+        part = final.with_name(f"{final.name}.{tag:08x}.part")
+        for old in final.parent.glob(final.name + ".*.part"):
+            if old != part:
+                old.unlink()        # Same id, other content: the card was rewritten
+        have = part.stat().st_size if part.exists() else 0
+        if have > size:
+            part.unlink()
+            have = 0
+        self.cur = dict(id=seg_id, size=size, tag=tag, part=part, final=final,
+                        fh=open(part, "ab"), cum=have, pending={}, t0=time.monotonic(), start=have)
+        if have:
+            self.stats["resumed"] += have
+        if have == size:
+            self.finish()           # The link dropped before END: RESUME(size) means done
+        return [message(RESUME, struct.pack("<II", seg_id, have))]
+
+    def resync(self):
+        now = time.monotonic()
+        if now - self.last_resync < RESYNC_GAP:
+            return []
+        self.last_resync = now
+        return [message(RESYNC)]
+
+    def on_data(self, p: bytes):
+        seg_id, off = struct.unpack_from("<II", p)
+        data = p[8:]
+        c = self.cur
+        if not c or c["id"] != seg_id:
+            late = self.last_done and self.last_done[0] == seg_id
+            return [] if late else self.resync()
+
+        if off < c["cum"]:
+            self.stats["dups"] += 1
+        elif off == c["cum"]:
+            c["fh"].write(data)
+            c["cum"] += len(data)
+            while c["cum"] in c["pending"]:
+                d = c["pending"].pop(c["cum"])
+                c["fh"].write(d)
+                c["cum"] += len(d)
+            c["fh"].flush()     # Acknowledge only what the OS has
+        elif off - c["cum"] <= self.window * self.chunk and off + len(data) <= c["size"]:
+            c["pending"][off] = data
+            self.stats["early"] += 1
+
+        sack = 0
+        for i in range(WINDOW_MAX):
+            if c["cum"] + (i + 1) * self.chunk in c["pending"]:
+                sack |= 1 << i
+        return [message(ACK, struct.pack("<III", seg_id, c["cum"], sack))]
+
+    def on_end(self, p: bytes):
+        seg_id, size = struct.unpack_from("<II", p)
+        c = self.cur
+        if not c or c["id"] != seg_id or c["cum"] != size:
+            if self.last_done and self.last_done[0] == seg_id:
+                return [message(DONE, struct.pack("<IB", seg_id, self.last_done[1]))]
+            return self.resync()
+
+        status = self.finish()
+        return [message(DONE, struct.pack("<IB", seg_id, status))]
+
+    def finish(self) -> int:
+        """Verify the complete current file and move it into place (or aside)."""
+        c = self.cur
+        self.close_current()
+        status, note = DONE_OK, "ok"
+        try:
+            read_segment(c["part"])
+            c["part"].replace(c["final"])
+        except (OSError, SegmentError, IndexError, struct.error) as e:
+            status, note = DONE_BAD, f"BAD ({e})"
+            c["part"].replace(c["final"].with_name(c["final"].name + ".bad"))
+        secs = time.monotonic() - c["t0"]
+        got = c["size"] - c["start"]
+        resumed = f" (resumed at {c['start'] // 1024} KB)" if c["start"] else ""
+        self.stats["files"] += 1
+        self.stats["bad"] += status == DONE_BAD
+        self.stats["bytes"] += got
+        self.log(f"{c['final'].relative_to(self.out)}  {c['size'] // 1024:5} KB  "
+                 f"{got / 1024 / max(secs, 1e-3):7.1f} KB/s  {note}{resumed}")
+        self.last_done = (c["id"], status)
+        return status
+
+    def on_bye(self, p: bytes):
+        self.finished = True
+        return [message(BYE_ACK)]
+
+    HANDLERS = {HELLO: (on_hello, 16), OFFER: (on_offer, 12), DATA: (on_data, 8),
+                END: (on_end, 8), BYE: (on_bye, 0)}
+
+    def handle(self, frame: bytes):
+        body = cobs_decode(frame)
+        if body is None or len(body) < 5 or \
+                binascii.crc32(body[:-4]) != struct.unpack_from("<I", body, len(body) - 4)[0]:
+            self.stats["bad_frames"] += 1
+            return []
+        handler = self.HANDLERS.get(body[0])
+        payload = body[1:-4]
+        if not handler or len(payload) < handler[1]:
+            self.stats["bad_frames"] += 1
+            return []
+        return handler[0](self, payload)
+
+
+# === Port handling ===
+
+def open_port(name: str, deadline: float, log):
+    announced = False
+    while time.monotonic() < deadline:
+        try:
+            return serial.Serial(name, 115200, timeout=0.05)
+        except serial.SerialException as e:
+            if not announced:
+                log(f"waiting for {name} ({e})")
+                announced = True
+            time.sleep(0.1)
+    return None
+
+
+def receive(args) -> int:
+    def log(msg):
+        print(msg, file=sys.stderr, flush=True)
+
+    rx = Receiver(Path(args.out), log)
+    t_start = time.monotonic()
+    last_frame = t_start
+    reopens = 0
+
+    while not rx.finished:
+        ser = open_port(args.port, last_frame + args.wait, log)
+        if not ser:
+            log(f"tether_recv: no device for {args.wait} s")
+            break
+        buf = b""
+        try:
+            while not rx.finished:
+                data = ser.read(max(1, ser.in_waiting))
+                if not data:
+                    if time.monotonic() - last_frame > args.wait:
+                        break
+                    continue
+                buf += data
+                *frames, buf = buf.split(b"\0")
+                replies = []
+                for f in frames:
+                    if f:
+                        replies += rx.handle(f)
+                        last_frame = time.monotonic()
+                if replies:
+                    ser.write(b"".join(replies))
+            if rx.finished:
+                break
+            if time.monotonic() - last_frame > args.wait:
+                log(f"tether_recv: device silent for {args.wait} s")
+                break
+        except (serial.SerialException, OSError) as e:     # Port vanished (cable pulled)
+            reopens += 1
+            log(f"link lost ({e}); reopening")
+        finally:
+            ser.close()
+
+    rx.close_current()
+    s = rx.stats
+    secs = time.monotonic() - t_start
+    log(f"{'complete' if rx.finished else 'INCOMPLETE'}: {s['files']} files received "
+        f"({s['bad']} bad), {s['skipped']} already here, {s['bytes'] // 1024} KB in {secs:.1f} s "
+        f"({s['bytes'] / 1024 / max(secs, 1e-3):.1f} KB/s), {s['resumed'] // 1024} KB resumed, "
+        f"{s['dups']} duplicate chunks, {s['bad_frames']} bad frames, {reopens} reopens")
+    return 0 if rx.finished and not s["bad"] else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("port", help="device's USB serial port (COMx, /dev/ttyACMx)")
+    ap.add_argument("--out", default="LOGS", help="directory to rebuild the LOGS tree in")
+    ap.add_argument("--wait", type=float, default=120,
+                    help="give up after this many seconds without the device (default 120)")
+    args = ap.parse_args()
+    try:
+        sys.exit(receive(args))
+    except KeyboardInterrupt:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,178 @@
+"""Decode tokenized log records ("$<base64>" lines) back into text.
+
+Works on captured UART output, SD card log segments (LOGS/Gnnnn/nnnnnnnn.LOG, read
+through log_extract.py) or a live serial port. Plain text lines pass through unchanged.
+
+Usage:
+  python tools/tlog_decode.py -d build/tlog_dict.json /media/sd/LOGS/G0000/*.LOG
+  python tools/tlog_decode.py -d build/tlog_dict.json --port COM4
+  idf.py monitor | python tools/tlog_decode.py -d build/tlog_dict.json
+"""
+
+import argparse
+import base64
+import binascii
+import json
+import re
+import struct
+import sys
+
+LEVELS = "NEWIDV"       # esp_log_level_t: NONE, ERROR, WARN, INFO, DEBUG, VERBOSE
+TRUNCATED = 0x80
+TOKEN_RE = re.compile(r"\$([A-Za-z0-9+/]+={0,2})")
+SPEC_RE = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsfFeEgGp%])")
+
+
+class Reader:
+    def __init__(self, data: bytes):
+        self.data, self.pos = data, 0
+
+    def byte(self):
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        v, shift = 0, 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def float32(self):
+        v = struct.unpack_from("<f", self.data, self.pos)[0]
+        self.pos += 4
+        return v
+
+    def string(self):
+        n = self.byte()
+        s = self.data[self.pos:self.pos + n].decode("utf-8", "replace")
+        self.pos += n
+        return s
+
+    def more(self):
+        return self.pos < len(self.data)
+
+
+def format_record(fmt: str, rd: Reader) -> str:
+    """Apply a C format string, reading each argument from the record as it is needed."""
+    out, last = [], 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if not rd.more():
+            out.append("<?>")
+            continue
+        spec = "%" + flags + (width or "") + ("." + prec if prec else "")
+        if conv == "s":
+            out.append((spec + "s") % rd.string())
+        elif conv in "fFeEgG":
+            out.append((spec + conv) % rd.float32())
+        else:
+            v = rd.zigzag()
+            if conv == "p":
+                # A 32-bit target's address is sign-extended from its int32 pattern
+                v &= 0xFFFFFFFF if -2**31 <= v < 0 else 0xFFFFFFFFFFFFFFFF
+            elif conv in "ouxX" or conv == "c":
+                v &= 0xFFFFFFFFFFFFFFFF if length == "ll" else 0xFFFFFFFF
+            elif conv in "di" and length != "ll":
+                v = (v + 2**31) % 2**32 - 2**31
+            if conv == "p":
+                out.append("0x%08x" % v)
+            elif conv == "c":
+                out.append((spec + "c") % chr(v & 0xFF))
+            else:
+                out.append((spec + ("d" if conv in "iu" else conv)) % v)
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def decode_token(token: str, entries: dict) -> str:
+    try:
+        rec = base64.b64decode(token, validate=True)
+    except (binascii.Error, ValueError):
+        return None
+    if len(rec) < 6:
+        return None
+    rd = Reader(rec)
+    level = rd.byte()
+    key = "0x%08x" % struct.unpack_from("<I", rec, 1)[0]
+    rd.pos = 5
+    try:
+        ts = rd.varint()
+        tag = rd.string()
+    except IndexError:
+        return None
+    e = entries.get(key)
+    lv = LEVELS[level & 7] if (level & 7) < len(LEVELS) else "?"
+    if not e:
+        return f"{lv} ({ts}) {tag or '?'}: <unknown token {key}, dictionary out of date?>"
+    try:
+        msg = format_record(e["fmt"], rd)
+    except (IndexError, struct.error):
+        msg = e["fmt"] + " <corrupt record>"
+    if level & TRUNCATED:
+        msg += " <truncated>"
+    return f"{lv} ({ts}) {tag or e['tag']}: {msg}"
+
+
+def decode_line(line: str, entries: dict) -> str:
+    def sub(m):
+        text = decode_token(m.group(1), entries)
+        return text if text is not None else m.group(0)
+    return TOKEN_RE.sub(sub, line)
+
+
+def lines_from(args):
+    if args.port:
+        import serial   # pyserial, only needed for live capture
+        with serial.Serial(args.port, args.baud, timeout=1) as ser:
+            while True:
+                raw = ser.readline()
+                if raw:
+                    yield raw.decode("utf-8", "replace")
+    elif not args.inputs or args.inputs == ["-"]:
+        yield from sys.stdin
+    else:
+        for name in args.inputs:
+            if name.upper().endswith(".LOG"):
+                from log_extract import read_segment
+                for block in read_segment(name)[1]:
+                    for line in block.decode("utf-8", "replace").splitlines(keepends=True):
+                        if line != "\n":   # Block padding
+                            yield line
+                continue
+            with open(name, encoding="utf-8", errors="replace") as f:
+                yield from f
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("-d", "--dict", required=True, help="tlog_dict.json from the build")
+    ap.add_argument("--port", help="serial port to read live (needs pyserial)")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("inputs", nargs="*", help="log files ('-' or none = stdin)")
+    args = ap.parse_args()
+
+    with open(args.dict, encoding="utf-8") as f:
+        entries = json.load(f)["entries"]
+
+    try:
+        for line in lines_from(args):
+            sys.stdout.write(decode_line(line, entries))
+    except (KeyboardInterrupt, BrokenPipeError):
+        pass
+
+
+if __name__ == "__main__":
+    main()
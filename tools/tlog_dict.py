@@ -0,0 +1,156 @@
+"""Build the tokenized-log dictionary.
+
+Scans C sources for TLOGx(TAG, "format", ...) calls and writes a JSON dictionary
+mapping each format hash to its format string, level and tag. The hash must match
+TLOG_HASH() in main/tlog.h.
+
+Usage: python tools/tlog_dict.py -o build/tlog_dict.json main
+"""
+
+import argparse
+import json
+import re
+import sys
+from pathlib import Path
+
+HASH_LEN = 80           # TLOG_HASH_LEN
+HASH_K = 65599
+
+CALL_RE = re.compile(r"\bTLOG([EWIDV])\s*\(")
+TAG_RE = re.compile(r'static\s+const\s+char\s*\*\s*(?:const\s+)?TAG\s*=\s*"([^"]*)"')
+ESCAPES = {"n": 10, "t": 9, "r": 13, "0": 0, "\\": 92, '"': 34, "'": 39, "a": 7, "b": 8,
+           "f": 12, "v": 11, "?": 63}
+
+
+def tlog_hash(data: bytes) -> int:
+    h = len(data)
+    k = HASH_K
+    for c in data[:HASH_LEN]:
+        h = (h + c * k) & 0xFFFFFFFF
+        k = (k * HASH_K) & 0xFFFFFFFF
+    return h
+
+
+def unescape(body: str) -> bytes:
+    """C string literal body -> bytes (source is UTF-8)."""
+    out = bytearray()
+    i = 0
+    while i < len(body):
+        ch = body[i]
+        if ch != "\\":
+            out += ch.encode("utf-8")
+            i += 1
+            continue
+        nxt = body[i + 1]
+        if nxt == "x":
+            m = re.match(r"[0-9a-fA-F]+", body[i + 2:])
+            out.append(int(m.group(0), 16) & 0xFF)
+            i += 2 + len(m.group(0))
+        elif nxt in "01234567":
+            m = re.match(r"[0-7]{1,3}", body[i + 1:])
+            out.append(int(m.group(0), 8) & 0xFF)
+            i += 1 + len(m.group(0))
+        else:
+            out.append(ESCAPES[nxt])
+            i += 2
+    return bytes(out)
+
+
+def split_args(text: str, start: int):
+    """Split a call's arguments at top-level commas, starting after '('."""
+    args, depth, cur, i = [], 0, [], start
+    while i < len(text):
+        ch = text[i]
+        if ch in "\"'":
+            j = i + 1
+            while text[j] != ch:
+                j += 2 if text[j] == "\\" else 1
+            cur.append(text[i:j + 1])
+            i = j + 1
+            continue
+        if ch in "([{":
+            depth += 1
+        elif ch in ")]}":
+            if depth == 0:
+                args.append("".join(cur).strip())
+                return args
+            depth -= 1
+        elif ch == "," and depth == 0:
+            args.append("".join(cur).strip())
+            cur = []
+            i += 1
+            continue
+        cur.append(ch)
+        i += 1
+    raise ValueError("unterminated call")
+
+
+def literal_bytes(expr: str):
+    """Concatenate adjacent string literals; None if the argument is not a literal."""
+    parts = re.findall(r'"((?:[^"\\]|\\.)*)"', expr)
+    rest = re.sub(r'"((?:[^"\\]|\\.)*)"', "", expr).strip()
+    if not parts or rest:
+        return None
+    return b"".join(unescape(p) for p in parts)
+
+
+def strip_comments(src: str) -> str:
+    src = re.sub(r"/\*.*?\*/", lambda m: re.sub(r"[^\n]", " ", m.group(0)), src, flags=re.S)
+    return re.sub(r"//[^\n]*", "", src)
+
+
+def scan(paths):
+    entries, errors = {}, []
+    files = []
+    for p in paths:
+        p = Path(p)
+        files += sorted(p.glob("*.c")) if p.is_dir() else [p]
+
+    for path in files:
+        src = strip_comments(path.read_text(encoding="utf-8"))
+        tag_m = TAG_RE.search(src)
+        tag = tag_m.group(1) if tag_m else ""
+        for m in CALL_RE.finditer(src):
+            line = src.count("\n", 0, m.start()) + 1
+            if src[:m.start()].rstrip().endswith("#define"):
+                continue
+            args = split_args(src, m.end())
+            fmt = literal_bytes(args[1]) if len(args) > 1 else None
+            if fmt is None:
+                continue    # Macro definitions / non-literal formats
+            key = f"0x{tlog_hash(fmt):08x}"
+            site = f"{path.name}:{line}"
+            text = fmt.decode("utf-8", "replace")
+            e = entries.get(key)
+            if e and e["fmt"] != text:
+                errors.append(f"{site}: hash {key} collides with {e['sites'][0]}")
+                continue
+            if not e:
+                e = entries[key] = {"fmt": text, "level": m.group(1), "tag": tag, "sites": []}
+            e["sites"].append(site)
+    return entries, errors
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("-o", "--output", required=True, help="dictionary JSON to write")
+    ap.add_argument("sources", nargs="+", help="C files or directories")
+    args = ap.parse_args()
+
+    entries, errors = scan(args.sources)
+    for e in errors:
+        print(f"tlog_dict: {e}", file=sys.stderr)
+    if errors:
+        sys.exit(1)
+
+    out = {"hash_len": HASH_LEN, "entries": dict(sorted(entries.items()))}
+    text = json.dumps(out, indent=1, ensure_ascii=False) + "\n"
+    path = Path(args.output)
+    # Keep the timestamp when nothing changed so dependents do not rebuild
+    if not path.exists() or path.read_text(encoding="utf-8") != text:
+        path.write_text(text, encoding="utf-8")
+    print(f"tlog_dict: {len(entries)} format strings -> {path}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,286 @@
+"""Receive log uploads from the device over HTTP (untethered upload, main/upload_proto.h).
+
+A small stand-in for the real upload server, for the lab and for tests. Point the device's
+transfer.upload_url at http://<this PC>:<port>/upload. Each device (X-Device header) gets
+its own LOGS tree under --out, in the card's layout (Gnnnn/nnnnnnnn.LOG), so
+log_extract.py and tlog_decode.py read it directly. Records are appended only at the
+offset already on disk; a finished segment is checked against its own CRCs and kept as
+.LOG.bad if it fails. --fail and --drop inject errors to exercise the device's retries.
+
+Usage:
+  python tools/upload_server.py --port 8080 --out uploads
+  python tools/log_extract.py uploads/optipulse-01 > device.log
+"""
+
+import argparse
+import random
+import re
+import struct
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+from log_extract import SegmentError, SUMMARY, parse_summary, read_segment
+
+MAGIC = 0x31505554          # UPLOAD_MAGIC "TUP1"
+RECORD = struct.Struct("<IIIIII")   # magic, file, size, tag, offset, len
+SEGS_PER_DIR = 256          # LOG_SEGS_PER_DIR
+COPY = 65536
+
+
+class BodyError(Exception):
+    pass
+
+
+class ChunkedBody:
+    """Reads a Transfer-Encoding: chunked request body."""
+
+    def __init__(self, rfile):
+        self.rfile = rfile
+        self.left = 0
+        self.eof = False
+
+    def read(self, n: int) -> bytes:
+        out = bytearray()
+        while n and not self.eof:
+            if self.left == 0:
+                try:
+                    size = int(self.rfile.readline(64).split(b";")[0], 16)
+                except ValueError:
+                    raise BodyError("bad chunk size")
+                if size == 0:
+                    while self.rfile.readline(256).strip():
+                        pass                # Trailer
+                    self.eof = True
+                    break
+                self.left = size
+            data = self.rfile.read(min(n, self.left))
+            if not data:
+                raise BodyError("connection closed mid-chunk")
+            out += data
+            n -= len(data)
+            self.left -= len(data)
+            if self.left == 0:
+                self.rfile.readline(4)      # CRLF after the chunk
+        return bytes(out)
+
+
+class CutBody:
+    """Injected fault: the connection drops after `left` body bytes."""
+
+    def __init__(self, body, left: int):
+        self.body = body
+        self.left = left
+
+    def read(self, n: int) -> bytes:
+        if self.left <= 0:
+            raise BodyError("injected drop")
+        data = self.body.read(min(n, self.left))
+        self.left -= len(data)
+        return data
+
+
+class LengthBody:
+    def __init__(self, rfile, length: int):
+        self.rfile = rfile
+        self.left = length
+
+    def read(self, n: int) -> bytes:
+        data = self.rfile.read(min(n, self.left))
+        self.left -= len(data)
+        return data
+
+
+# === Store ===
+
+class Store:
+    def __init__(self, out: Path, log):
+        self.out = out
+        self.log = log
+        self.lock = threading.Lock()
+        self.stats = dict(requests=0, failed=0, connections=0, files=0, bad=0, bytes=0, busy=0.0)
+
+    def paths(self, device: str, seg_id: int, tag: int):
+        final = self.out / device / f"G{seg_id // SEGS_PER_DIR:04d}" / f"{seg_id:08d}.LOG"
+        return final, final.with_name(f"{final.name}.{tag:08x}.part")
+
+    @staticmethod
+    def complete(path: Path, size: int, tag: int):
+        """'ok' or 'bad' if the finished file (or the one kept aside) is this content."""
+        for p, state in ((path, "ok"), (path.with_name(path.name + ".bad"), "bad")):
+            try:
+                with open(p, "rb") as f:
+                    head = f.read(SUMMARY.size)
+                    if f.seek(0, 2) == size and parse_summary(head)["crc"] == tag:
+                        return state
+            except (OSError, struct.error):
+                pass
+        return None
+
+    def finish(self, device: str, final: Path, part: Path, size: int) -> str:
+        state, note = "ok", "ok"
+        try:
+            read_segment(part)
+            part.replace(final)
+        except (OSError, SegmentError, IndexError, struct.error) as e:
+            state, note = "bad", f"BAD ({e})"
+            part.replace(final.with_name(final.name + ".bad"))
+        self.stats["files"] += 1
+        self.stats["bad"] += state == "bad"
+        self.log(f"{device}/{final.parent.name}/{final.name}  {size // 1024:5} KB  {note}")
+        return state
+
+    def record(self, device: str, hdr, body) -> str:
+        """Store one record (or skip it) and return its answer line."""
+        _, seg_id, size, tag, offset, length = hdr
+        final, part = self.paths(device, seg_id, tag)
+        with self.lock:
+            state = self.complete(final, size, tag)
+            if state:
+                have = size
+            else:
+                final.parent.mkdir(parents=True, exist_ok=True)
+                for old in final.parent.glob(final.name + ".*.part"):
+                    if old != part:
+                        old.unlink()        # Same id, other content: the card was rewritten
+                have = part.stat().st_size if part.exists() else 0
+                if have > size:
+                    part.unlink()
+                    have = 0
+            take = state is None and offset == have and offset + length <= size
+            fh = open(part, "ab") if take else None
+            try:
+                left = length
+                while left:
+                    data = body.read(min(left, COPY))
+                    if not data:
+                        raise BodyError("body ends inside a record")
+                    if fh:
+                        fh.write(data)
+                    left -= len(data)
+            finally:
+                if fh:
+                    fh.close()
+            if take:
+                have += length
+                self.stats["bytes"] += length
+                if have == size:
+                    state = self.finish(device, final, part, size)
+        return f"{seg_id} {have} {state or 'part'}\n"
+
+
+# === HTTP ===
+
+def make_handler(store: Store, args):
+    rng = random.Random(args.seed)
+
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"       # Keep-alive
+
+        def setup(self):
+            super().setup()
+            store.stats["connections"] += 1
+
+        def log_message(self, fmt, *a):
+            if args.verbose:
+                super().log_message(fmt, *a)
+
+        def reply(self, code: int, text: str):
+            data = text.encode()
+            self.send_response(code)
+            self.send_header("Content-Type", "text/plain")
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+        def do_POST(self):
+            t0 = time.monotonic()
+            device = re.sub(r"[^A-Za-z0-9_.-]", "_", self.headers.get("X-Device", "device"))[:32]
+            if self.headers.get("Transfer-Encoding", "").lower() == "chunked":
+                body = ChunkedBody(self.rfile)
+            else:
+                body = LengthBody(self.rfile, int(self.headers.get("Content-Length", 0)))
+            if rng.random() < args.drop:
+                body = CutBody(body, rng.randrange(1, 1 << 18))
+            fail = rng.random() < args.fail
+
+            lines = []
+            try:
+                while True:
+                    raw = body.read(RECORD.size)
+                    if not raw:
+                        break
+                    if len(raw) < RECORD.size or RECORD.unpack(raw)[0] != MAGIC:
+                        self.close_connection = True    # The rest of the body is unread
+                        self.reply(400, "bad record\n")
+                        return
+                    lines.append(store.record(device, RECORD.unpack(raw), body))
+            except BodyError as e:
+                self.log(f"{device}: {e}")
+                self.close_connection = True
+                store.stats["failed"] += 1
+                return
+            store.stats["requests"] += 1
+            store.stats["busy"] += time.monotonic() - t0
+            if fail:
+                store.stats["failed"] += 1
+                self.reply(503, "injected failure\n")    # The data is kept: a retry skips it
+                return
+            self.reply(200, "".join(lines))
+
+        def log(self, msg):
+            store.log(msg)
+
+    return Handler
+
+
+def summary(store: Store, secs: float) -> str:
+    s = store.stats
+    mb = s["bytes"] / 1048576
+    return (f"{s['files']} files ({s['bad']} bad), {mb:.2f} MB in {s['requests']} requests "
+            f"({s['requests'] / mb if mb else 0:.2f} per MB) over {s['connections']} connections, "
+            f"{s['failed']} failed; {mb / s['busy'] if s['busy'] else 0:.2f} MB/s while busy, "
+            f"{secs:.1f} s up")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", type=int, default=8080)
+    ap.add_argument("--bind", default="0.0.0.0")
+    ap.add_argument("--out", default="uploads", help="directory for the per-device LOGS trees")
+    ap.add_argument("--fail", type=float, default=0, help="answer this share of POSTs with 503")
+    ap.add_argument("--drop", type=float, default=0, help="cut this share of POSTs off mid-body")
+    ap.add_argument("--seed", type=int, default=None, help="seed for --fail / --drop")
+    ap.add_argument("--idle", type=float, default=0,
+                    help="exit after this many seconds without requests (after the first)")
+    ap.add_argument("--verbose", action="store_true", help="log every request")
+    args = ap.parse_args()
+
+    def log(msg):
+        print(msg, file=sys.stderr, flush=True)
+
+    store = Store(Path(args.out), log)
+    server = ThreadingHTTPServer((args.bind, args.port), make_handler(store, args))
+    server.daemon_threads = True
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    log(f"upload_server: listening on {args.bind}:{args.port}, writing to {args.out}")
+    t_start = time.monotonic()
+    try:
+        last, seen = 0, 0
+        while True:
+            time.sleep(0.25)
+            n = store.stats["requests"] + store.stats["failed"]
+            if n != seen:
+                seen, last = n, time.monotonic()
+            elif args.idle and seen and time.monotonic() - last > args.idle:
+                break
+    except KeyboardInterrupt:
+        pass
+    server.shutdown()
+    log("upload_server: " + summary(store, time.monotonic() - t_start))
+
+
+if __name__ == "__main__":
+    main()